@@ -21,6 +21,9 @@
 #include "ccBBox.h"
 #include "ccObject.h"
 
+// System
+#include <unordered_map>
+
 class QIcon;
 
 //! Hierarchical CloudCompare Object
@@ -70,6 +73,9 @@ class QCC_DB_LIB_API ccHObject : public ccObject
 		return getClassID() == static_cast<CC_CLASS_ENUM>(CC_TYPES::HIERARCHY_OBJECT);
 	}
 
+	//! Changes unique ID (overridden to keep the unique ID index up to date)
+	void setUniqueID(unsigned ID) override;
+
 	//! Returns parent object
 	/** \return parent object (nullptr if no parent)
 	 **/
@@ -114,6 +120,12 @@ class QCC_DB_LIB_API ccHObject : public ccObject
 	 **/
 	bool hasDependencyFlag(int flag) const;
 
+	//! Returns whether deleting this entity may delete other entities than its own descendants
+	/** I.e. whether this entity or one of its descendants has a DP_DELETE_OTHER
+	    dependency with an entity outside of this sub-tree (a sibling, a parent, etc.)
+	**/
+	bool deletionCascadesOutside() const;
+
 	//! Removes any dependency flags with a given object
 	/** \param otherObject other object
 	 **/
@@ -160,7 +172,9 @@ class QCC_DB_LIB_API ccHObject : public ccObject
 	}
 
 	//! Finds an entity in this object hierarchy
-	/** \param uniqueID child unique ID
+	/** The entities are looked up in a global (hash) index of the unique IDs first,
+	    so that the search doesn't need to traverse the whole hierarchy.
+	    \param uniqueID child unique ID
 	    \return child (or nullptr if not found)
 	**/
 	ccHObject* find(unsigned uniqueID) const;
@@ -215,6 +229,9 @@ class QCC_DB_LIB_API ccHObject : public ccObject
 	void removeAllChildren();
 
 	//! Returns child index
+	/** Constant time (the position of each child is indexed).
+	    \return the child index (or -1 if the object is not a child of this entity)
+	**/
 	int getChildIndex(const ccHObject* aChild) const;
 
 	//! Swaps two children
@@ -526,9 +543,15 @@ class QCC_DB_LIB_API ccHObject : public ccObject
 	//! Parent
 	ccHObject* m_parent;
 
+	//! Updates the index of the children positions (from a given position to the end)
+	void updateChildIndexes(size_t firstPos = 0);
+
 	//! Children
 	Container m_children;
 
+	//! Children positions (in m_children)
+	std::unordered_map<const ccHObject*, unsigned> m_childIndexes;
+
 	//! Selection behavior
 	SelectionBehavior m_selectionBehavior;
 
@@ -25,6 +25,9 @@
 #include <QSharedPointer>
 #include <QVariant>
 
+// System
+#include <atomic>
+
 //! Object state flag
 enum CC_OBJECT_FLAG
 { // CC_UNUSED			= 1, //DGM: not used anymore (former CC_FATHER_DEPENDENT)
@@ -150,6 +153,8 @@ namespace CC_TYPES
 }
 
 //! Unique ID generator (should be unique for the whole application instance - with plugins, etc.)
+/** Thread-safe (entities may be created concurrently by worker threads).
+**/
 class QCC_DB_LIB_API ccUniqueIDGenerator
 {
   public:
@@ -168,7 +173,7 @@ class QCC_DB_LIB_API ccUniqueIDGenerator
 	//! Resets the unique ID
 	void reset()
 	{
-		m_lastUniqueID = MinUniqueID;
+		m_lastUniqueID.store(MinUniqueID);
 	}
 	//! Returns a (new) unique ID
 	unsigned fetchOne()
@@ -178,17 +183,20 @@ class QCC_DB_LIB_API ccUniqueIDGenerator
 	//! Returns the value of the last generated unique ID
 	unsigned getLast() const
 	{
-		return m_lastUniqueID;
+		return m_lastUniqueID.load();
 	}
 	//! Updates the value of the last generated unique ID with the current one
 	void update(unsigned ID)
 	{
-		if (ID > m_lastUniqueID)
-			m_lastUniqueID = ID;
+		unsigned lastID = m_lastUniqueID.load();
+		while (ID > lastID && !m_lastUniqueID.compare_exchange_weak(lastID, ID))
+		{
+			//lastID has been updated by compare_exchange_weak
+		}
 	}
 
   protected:
-	unsigned m_lastUniqueID;
+	std::atomic<unsigned> m_lastUniqueID;
 };
 
 //! Generic "CloudCompare Object" template
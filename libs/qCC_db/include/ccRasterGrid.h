@@ -42,13 +42,15 @@ struct QCC_DB_LIB_API ccRasterCell
 	    , nbPoints(0)
 	    , nearestPointIndex(0)
 	    , color(0, 0, 0)
-	    , pointRefHead(nullptr)
-	    , pointRefTail(nullptr)
+	    , pointIndexesStart(0)
 	{
 	}
 
 	//! Returns the list of all point indexes projected into this cell
-	void getPointIndexes(std::vector<unsigned>& indexes, const std::vector<void*>& pointRefList) const;
+	/** \param indexes output point indexes
+	    \param gridPointIndexes the (sorted by cell) point indexes of the grid (see ccRasterGrid::pointIndexes)
+	**/
+	void getPointIndexes(std::vector<unsigned>& indexes, const std::vector<unsigned>& gridPointIndexes) const;
 
 	//! Height value
 	double h;
@@ -62,10 +64,8 @@ struct QCC_DB_LIB_API ccRasterCell
 	unsigned nearestPointIndex;
 	//! Color
 	CCVector3d color;
-	//! Pointer to first point reference for this cell (used to compute the median)
-	void** pointRefHead;
-	//! Pointer to last point reference for this cell (used to compute the median)
-	void** pointRefTail;
+	//! Position of the first point index of this cell in ccRasterGrid::pointIndexes
+	unsigned pointIndexesStart;
 };
 
 //! Raster grid type
@@ -269,11 +269,11 @@ struct QCC_DB_LIB_API ccRasterGrid
 	//! Associated scalar fields
 	std::vector<SF> scalarFields;
 
-	//! Array of pointers, each coresponding to a point in the cloud
-	/** 'cloud->getPoint(n)' coresponds to 'pointRefList[n]'
-	    The pointers are used to chain points belonging to the same cell together.
+	//! Indexes of the points projected in the grid, sorted by cell
+	/** The indexes of the points of a given cell are contiguous: they start
+	    at 'cell.pointIndexesStart' and there are 'cell.nbPoints' of them.
 	**/
-	std::vector<void*> pointRefList;
+	std::vector<unsigned> pointIndexes;
 
 	//! Number of columns
 	unsigned width;
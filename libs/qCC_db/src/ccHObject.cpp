@@ -48,6 +48,77 @@
 
 // Qt
 #include <QIcon>
+#include <QMutex>
+
+namespace
+{
+	//! Global index of the (living) entities by unique ID
+	/** Several entities may share the same ID (e.g. if the ID was set manually).
+	**/
+	struct UniqueIDIndex
+	{
+		QMutex                                        mutex;
+		std::unordered_multimap<unsigned, ccHObject*> entities;
+
+		void insert(unsigned ID, ccHObject* entity)
+		{
+			QMutexLocker locker(&mutex);
+			entities.emplace(ID, entity);
+		}
+
+		void remove(unsigned ID, ccHObject* entity)
+		{
+			QMutexLocker locker(&mutex);
+			auto         range = entities.equal_range(ID);
+			for (auto it = range.first; it != range.second; ++it)
+			{
+				if (it->second == entity)
+				{
+					entities.erase(it);
+					break;
+				}
+			}
+		}
+
+		void find(unsigned ID, ccHObject::Container& candidates)
+		{
+			QMutexLocker locker(&mutex);
+			auto         range = entities.equal_range(ID);
+			for (auto it = range.first; it != range.second; ++it)
+			{
+				candidates.push_back(it->second);
+			}
+		}
+	};
+
+	UniqueIDIndex& GetUniqueIDIndex()
+	{
+		// never released, as entities may still be destroyed after the static objects
+		static UniqueIDIndex* s_index = new UniqueIDIndex;
+		return *s_index;
+	}
+
+	//! Exhaustive (recursive) search of an entity among the children of another one
+	ccHObject* FindInChildren(const ccHObject* object, unsigned uniqueID)
+	{
+		for (unsigned i = 0; i < object->getChildrenNumber(); ++i)
+		{
+			ccHObject* child = object->getChild(i);
+			if (child->getUniqueID() == uniqueID)
+			{
+				return child;
+			}
+
+			ccHObject* match = FindInChildren(child, uniqueID);
+			if (match)
+			{
+				return match;
+			}
+		}
+
+		return nullptr;
+	}
+} // namespace
 
 ccHObject::ccHObject(const QString& name, unsigned uniqueID /*=ccUniqueIDGenerator::InvalidUniqueID*/)
     : ccObject(name, uniqueID)
@@ -60,6 +131,8 @@ ccHObject::ccHObject(const QString& name, unsigned uniqueID /*=ccUniqueIDGenerat
 	lockVisibility(true);
 
 	m_glTransHistory.toIdentity();
+
+	GetUniqueIDIndex().insert(getUniqueID(), this);
 }
 
 ccHObject::ccHObject(const ccHObject& object)
@@ -70,12 +143,15 @@ ccHObject::ccHObject(const ccHObject& object)
     , m_glTransHistory(object.m_glTransHistory)
     , m_isDeleting(false)
 {
+	GetUniqueIDIndex().insert(getUniqueID(), this);
 }
 
 ccHObject::~ccHObject()
 {
 	m_isDeleting = true;
 
+	GetUniqueIDIndex().remove(getUniqueID(), this);
+
 	// process dependencies
 	std::map<ccHObject*, int> dependencies;
 	m_dependencies.swap(dependencies); // the member might be modified during the following process!
@@ -325,6 +401,30 @@ bool ccHObject::hasDependencyFlag(int dependencyFlag) const
 	return false;
 }
 
+bool ccHObject::deletionCascadesOutside() const
+{
+	std::vector<const ccHObject*> toVisit{this};
+	while (!toVisit.empty())
+	{
+		const ccHObject* object = toVisit.back();
+		toVisit.pop_back();
+
+		for (const auto& dependency : object->m_dependencies)
+		{
+			if ((dependency.second & DP_DELETE_OTHER) == DP_DELETE_OTHER
+			    && dependency.first != this
+			    && !isAncestorOf(dependency.first))
+			{
+				return true;
+			}
+		}
+
+		toVisit.insert(toVisit.end(), object->m_children.begin(), object->m_children.end());
+	}
+
+	return false;
+}
+
 void ccHObject::removeDependencyWith(ccHObject* otherObject)
 {
 	m_dependencies.erase(const_cast<ccHObject*>(otherObject)); // DGM: not sure why erase won't accept a const pointer?! We try to modify the map here, not the pointer object!
@@ -348,6 +448,29 @@ void ccHObject::removeDependencyFlag(ccHObject* otherObject, DEPENDENCY_FLAGS fl
 	}
 }
 
+void ccHObject::setUniqueID(unsigned ID)
+{
+	unsigned previousID = getUniqueID();
+	if (previousID == ID)
+	{
+		ccObject::setUniqueID(ID); // still update the generator
+		return;
+	}
+
+	UniqueIDIndex& index = GetUniqueIDIndex();
+	index.remove(previousID, this);
+	ccObject::setUniqueID(ID);
+	index.insert(ID, this);
+}
+
+void ccHObject::updateChildIndexes(size_t firstPos /*=0*/)
+{
+	for (size_t i = firstPos; i < m_children.size(); ++i)
+	{
+		m_childIndexes[m_children[i]] = static_cast<unsigned>(i);
+	}
+}
+
 void ccHObject::onDeletionOf(const ccHObject* obj)
 {
 	// remove any dependency declared with this object
@@ -361,6 +484,8 @@ void ccHObject::onDeletionOf(const ccHObject* obj)
 	{
 		// we can't swap children as we want to keep the order!
 		m_children.erase(m_children.begin() + pos);
+		m_childIndexes.erase(obj);
+		updateChildIndexes(pos);
 	}
 }
 
@@ -371,7 +496,7 @@ bool ccHObject::addChild(ccHObject* child, int dependencyFlags /*=DP_PARENT_OF_O
 		assert(false);
 		return false;
 	}
-	if (std::find(m_children.begin(), m_children.end(), child) != m_children.end())
+	if (m_childIndexes.find(child) != m_childIndexes.end())
 	{
 		ccLog::ErrorDebug("[ccHObject::addChild] Object is already a child!");
 		return false;
@@ -387,13 +512,30 @@ bool ccHObject::addChild(ccHObject* child, int dependencyFlags /*=DP_PARENT_OF_O
 	try
 	{
 		if (insertIndex < 0 || static_cast<size_t>(insertIndex) >= m_children.size())
+		{
 			m_children.push_back(child);
+			m_childIndexes[child] = static_cast<unsigned>(m_children.size() - 1);
+		}
 		else
+		{
 			m_children.insert(m_children.begin() + insertIndex, child);
+			updateChildIndexes(insertIndex);
+		}
 	}
 	catch (const std::bad_alloc&)
 	{
 		// not enough memory!
+		if (m_childIndexes.size() != m_children.size())
+		{
+			// restore the consistency between the children and their index
+			auto it = std::find(m_children.begin(), m_children.end(), child);
+			if (it != m_children.end())
+			{
+				m_children.erase(it);
+			}
+			m_childIndexes.erase(child);
+			updateChildIndexes();
+		}
 		return false;
 	}
 
@@ -450,17 +592,33 @@ ccHObject* ccHObject::find(unsigned uniqueID) const
 		return const_cast<ccHObject*>(this);
 	}
 
-	// otherwise we are going to test all children recursively
-	for (unsigned i = 0; i < getChildrenNumber(); ++i)
+	// look for the entities with this ID in the global index first
+	try
 	{
-		ccHObject* match = getChild(i)->find(uniqueID);
-		if (match)
+		Container candidates;
+		GetUniqueIDIndex().find(uniqueID, candidates);
+		if (candidates.empty())
+		{
+			// no living entity has this ID
+			return nullptr;
+		}
+
+		for (ccHObject* candidate : candidates)
 		{
-			return match;
+			if (isAncestorOf(candidate))
+			{
+				return candidate;
+			}
 		}
 	}
+	catch (const std::bad_alloc&)
+	{
+		// not enough memory: we'll fall back to the exhaustive search
+	}
 
-	return nullptr;
+	// the entity may still be a child of an entity that is not its parent
+	// (i.e. with a simple dependency link): we are going to test all children recursively
+	return FindInChildren(this, uniqueID);
 }
 
 unsigned ccHObject::filterChildren(Container&          filteredChildren,
@@ -495,11 +653,14 @@ unsigned ccHObject::filterChildren(Container&          filteredChildren,
 
 int ccHObject::getChildIndex(const ccHObject* child) const
 {
-	for (size_t i = 0; i < m_children.size(); ++i)
-		if (m_children[i] == child)
-			return static_cast<int>(i);
+	auto it = m_childIndexes.find(child);
+	if (it == m_childIndexes.end())
+	{
+		return -1;
+	}
 
-	return -1;
+	assert(it->second < m_children.size() && m_children[it->second] == child);
+	return static_cast<int>(it->second);
 }
 
 void ccHObject::transferChild(ccHObject* child, ccHObject& newParent)
@@ -538,6 +699,7 @@ void ccHObject::transferChildren(ccHObject& newParent, bool forceFatherDependent
 		assert(child->getParent() == &newParent || child->getParent() == nullptr);
 	}
 	m_children.clear();
+	m_childIndexes.clear();
 }
 
 void ccHObject::swapChildren(unsigned firstChildIndex, unsigned secondChildIndex)
@@ -546,6 +708,8 @@ void ccHObject::swapChildren(unsigned firstChildIndex, unsigned secondChildIndex
 	assert(secondChildIndex < m_children.size());
 
 	std::swap(m_children[firstChildIndex], m_children[secondChildIndex]);
+	m_childIndexes[m_children[firstChildIndex]]  = firstChildIndex;
+	m_childIndexes[m_children[secondChildIndex]] = secondChildIndex;
 }
 
 int ccHObject::getIndex() const
@@ -930,6 +1094,8 @@ void ccHObject::detachChild(ccHObject* child)
 	{
 		// we can't swap children as we want to keep the order!
 		m_children.erase(m_children.begin() + pos);
+		m_childIndexes.erase(child);
+		updateChildIndexes(pos);
 	}
 }
 
@@ -947,6 +1113,7 @@ void ccHObject::detachAllChildren()
 		}
 	}
 	m_children.clear();
+	m_childIndexes.clear();
 }
 
 void ccHObject::removeChild(ccHObject* child)
@@ -972,6 +1139,8 @@ void ccHObject::removeChild(int pos)
 	//(DGM: do this BEFORE deleting the object (otherwise
 	// the dependency mechanism can 'backfire' ;)
 	m_children.erase(m_children.begin() + pos);
+	m_childIndexes.erase(child);
+	updateChildIndexes(pos);
 
 	// backup dependency flags
 	int flags = getDependencyFlagsWith(child);
@@ -1012,6 +1181,7 @@ void ccHObject::removeAllChildren()
 	{
 		ccHObject* child = m_children.back();
 		m_children.pop_back();
+		m_childIndexes.erase(child);
 
 		int flags = getDependencyFlagsWith(child);
 		if ((flags & DP_DELETE_OTHER) == DP_DELETE_OTHER)
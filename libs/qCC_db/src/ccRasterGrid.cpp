@@ -32,8 +32,15 @@
 #include <QMap>
 
 // System
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
 // default field names
 struct DefaultFieldNames : public QMap<ccRasterGrid::ExportableFields, QString>
 {
@@ -59,18 +66,11 @@ QString ccRasterGrid::GetDefaultFieldName(ExportableFields field)
 	return s_defaultFieldNames[field];
 }
 
-void ccRasterCell::getPointIndexes(std::vector<unsigned>& indexes, const std::vector<void*>& pointRefList) const
+void ccRasterCell::getPointIndexes(std::vector<unsigned>& indexes, const std::vector<unsigned>& gridPointIndexes) const
 {
-	indexes.clear();
-	// Assemble a list of all point indexes in this cell
-	// Start with first point in cell, and browse through every point using the linked ref list, and collect point indexes
-	void** pRef = pointRefHead;
-	for (unsigned n = 0; n < nbPoints; ++n)
-	{
-		unsigned pointIndex = static_cast<unsigned>(pRef - pointRefList.data());
-		indexes.push_back(pointIndex);
-		pRef = reinterpret_cast<void**>(*pRef);
-	}
+	// the point indexes of each cell are contiguous in the grid 'pointIndexes' array
+	assert(nbPoints == 0 || static_cast<size_t>(pointIndexesStart) + nbPoints <= gridPointIndexes.size());
+	indexes.assign(gridPointIndexes.begin() + pointIndexesStart, gridPointIndexes.begin() + pointIndexesStart + nbPoints);
 }
 
 ccRasterGrid::ccRasterGrid()
@@ -133,6 +133,7 @@ void ccRasterGrid::clear()
 	width = height = 0;
 	rows.resize(0);
 	scalarFields.resize(0);
+	pointIndexes.resize(0);
 
 	minHeight = maxHeight = meanHeight = 0;
 	nonEmptyCellCount = validCellCount = 0;
@@ -147,6 +148,7 @@ void ccRasterGrid::reset()
 	{
 		std::fill(row.begin(), row.end(), ccRasterCell());
 	}
+	pointIndexes.resize(0);
 
 	minHeight = maxHeight = meanHeight = 0;
 	nonEmptyCellCount = validCellCount = 0;
@@ -276,17 +278,23 @@ bool ccRasterGrid::fillWith(ccGenericPointCloud* cloud,
 	// we always handle the colors (if any)
 	hasColors = cloud->hasColors();
 
+	// linear index of the cell in which each point is projected ('gridTotalSize' = outside of the grid)
+	std::vector<unsigned> pointCellIndexes;
+	// CSR layout: the points of cell #k are pointIndexes[cellStart[k] ; cellStart[k + 1][
+	std::vector<unsigned> cellStart;
 	try
 	{
-		pointRefList.resize(pointCount, nullptr);
+		pointCellIndexes.resize(pointCount);
+		cellStart.resize(static_cast<size_t>(gridTotalSize) + 2, 0);
+		pointIndexes.resize(0);
 	}
-	catch (const std::bad_alloc)
+	catch (const std::bad_alloc&)
 	{
 		ccLog::Error("Not enough memory");
 		return false;
 	}
 
-	// first, project the points inside the grid
+	// first, project the points inside the grid (concurrently)
 	{
 		if (progressDialog)
 		{
@@ -298,82 +306,91 @@ bool ccRasterGrid::fillWith(ccGenericPointCloud* cloud,
 			QCoreApplication::processEvents();
 		}
 
-		CCCoreLib::NormalizedProgress nProgress(progressDialog, pointCount);
-		for (unsigned n = 0; n < pointCount; ++n)
-		{
-			// for each point
-			const CCVector3* P = cloud->getPoint(n);
+		// the points are processed by chunks (the progress is updated once per chunk)
+		const unsigned chunkSize  = (1 << 16);
+		const int      chunkCount = static_cast<int>((static_cast<size_t>(pointCount) + chunkSize - 1) / chunkSize);
 
-			// project it inside the grid
-			CCVector2i cellPos = computeCellPos(*P, X, Y);
+		CCCoreLib::NormalizedProgress nProgress(progressDialog, static_cast<unsigned>(chunkCount));
+		std::atomic<bool>             cancelled(false);
 
-			// we skip points that fall outside of the grid!
-			if (cellPos.x < 0 || cellPos.x >= static_cast<int>(width)
-			    || cellPos.y < 0 || cellPos.y >= static_cast<int>(height))
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(omp_get_max_threads())
+#endif
+		for (int c = 0; c < chunkCount; ++c)
+		{
+			if (cancelled)
 			{
-				if (!nProgress.oneStep())
-				{
-					// process cancelled by the user
-					return false;
-				}
 				continue;
 			}
 
-			// update the cell statistics
-			ccRasterCell& aCell = rows[cellPos.y][cellPos.x];
-
-			// update linked list of point references
-			if (aCell.nbPoints == 0)
-			{
-				// if first point in cell, set head and tail to this reference
-				aCell.pointRefHead = pointRefList.data() + n;
-				aCell.pointRefTail = pointRefList.data() + n;
-			}
-			else
+			unsigned firstIndex = static_cast<unsigned>(c) * chunkSize;
+			unsigned lastIndex  = (pointCount - firstIndex > chunkSize ? firstIndex + chunkSize : pointCount);
+			for (unsigned n = firstIndex; n < lastIndex; ++n)
 			{
-				// else point previous tail ref to this point, and reset tail
-				*(aCell.pointRefTail) = pointRefList.data() + n;
-				aCell.pointRefTail    = pointRefList.data() + n;
-			}
+				// project the point inside the grid
+				CCVector2i cellPos = computeCellPos(*cloud->getPoint(n), X, Y);
 
-			// update the number of points in the cell
-			++aCell.nbPoints;
+				// we skip points that fall outside of the grid!
+				if (cellPos.x < 0 || cellPos.x >= static_cast<int>(width)
+				    || cellPos.y < 0 || cellPos.y >= static_cast<int>(height))
+				{
+					pointCellIndexes[n] = gridTotalSize;
+				}
+				else
+				{
+					pointCellIndexes[n] = static_cast<unsigned>(cellPos.y) * width + static_cast<unsigned>(cellPos.x);
+				}
+			}
 
 			if (!nProgress.oneStep())
 			{
-				// process cancelled by user
-				return false;
+				// process cancelled by the user
+				cancelled = true;
 			}
 		}
+
+		if (cancelled)
+		{
+			return false;
+		}
 	}
 
-	std::vector<IndexAndValue> cellPointIndexedHeight;
-	std::vector<ScalarType>    cellInvVarianceValues;
-	try
+	// then sort the point indexes by cell (counting sort)
 	{
-		// find maximum needed size for storing per-cell data
-		unsigned maxCellPopuplation = 0;
-		for (unsigned j = 0; j < height; ++j)
+		for (unsigned n = 0; n < pointCount; ++n)
 		{
-			Row& row = rows[j];
-			for (unsigned i = 0; i < width; ++i)
+			if (pointCellIndexes[n] != gridTotalSize)
 			{
-				ccRasterCell& aCell = row[i];
-				maxCellPopuplation  = std::max(maxCellPopuplation, aCell.nbPoints);
+				++cellStart[pointCellIndexes[n] + 2];
 			}
 		}
+		for (size_t k = 2; k < cellStart.size(); ++k)
+		{
+			cellStart[k] += cellStart[k - 1];
+		}
 
-		cellPointIndexedHeight.resize(maxCellPopuplation);
-		if (projectionType == PROJ_INVERSE_VAR_VALUE)
+		try
 		{
-			cellInvVarianceValues.resize(maxCellPopuplation);
+			pointIndexes.resize(cellStart.back());
 		}
-	}
-	catch (const std::bad_alloc&)
-	{
-		// out of memory
-		ccLog::Warning("Not enough memory");
-		return false;
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Error("Not enough memory");
+			return false;
+		}
+
+		// cellStart[k + 1] is used as the insertion cursor of cell #k (and ends up being its end = the start of cell #k+1)
+		for (unsigned n = 0; n < pointCount; ++n)
+		{
+			if (pointCellIndexes[n] != gridTotalSize)
+			{
+				pointIndexes[cellStart[pointCellIndexes[n] + 1]++] = n;
+			}
+		}
+
+		// we don't need this anymore
+		pointCellIndexes.clear();
+		pointCellIndexes.shrink_to_fit();
 	}
 
 	// Find the right 'std. dev.' SF if inverse variance is being used
@@ -393,9 +410,7 @@ bool ccRasterGrid::fillWith(ccGenericPointCloud* cloud,
 		}
 	}
 
-	std::vector<ScalarType> sfValues; // common vector used to sort SF values in each cell
-
-	// now we can browse through all points belonging to each cell
+	// now we can browse through all points belonging to each cell (the rows are processed concurrently)
 	{
 		if (progressDialog)
 		{
@@ -404,320 +419,360 @@ bool ccRasterGrid::fillWith(ccGenericPointCloud* cloud,
 			progressDialog->setCancelButton(nullptr);
 			QCoreApplication::processEvents();
 		}
-		CCCoreLib::NormalizedProgress nProgress(progressDialog, height * width);
+		CCCoreLib::NormalizedProgress nProgress(progressDialog, height);
+		std::atomic<bool>             notEnoughMemory(false);
 
-		for (unsigned j = 0; j < height; ++j)
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(omp_get_max_threads())
+#endif
 		{
-			Row& row = rows[j];
-			for (unsigned i = 0; i < width; ++i)
+			// per-thread buffers
+			std::vector<IndexAndValue> cellPointIndexedHeight;
+			std::vector<ScalarType>    cellInvVarianceValues;
+			std::vector<ScalarType>    sfValues; // used to sort SF values in each cell
+
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic)
+#endif
+			for (int j = 0; j < static_cast<int>(height); ++j)
 			{
-				ccRasterCell& aCell                 = row[i];
-				double        cellAvgHeight         = 0.0;
-				double        cellStdDevHeight      = 0.0;
-				double        cellModelStdDevHeight = std::numeric_limits<double>::quiet_NaN(); // for inv. var. projection mode only
+				if (notEnoughMemory)
+				{
+					continue;
+				}
 
-				if (aCell.nbPoints)
+				Row& row = rows[j];
+				for (unsigned i = 0; i < width; ++i)
 				{
-					// Assemble a list of all points in this cell.
-					// Start with first point in cell, and browse through the other points using the linked ref list, and collect point indexes
-					void** pRef = aCell.pointRefHead;
-					for (unsigned n = 0; n < aCell.nbPoints; ++n)
+					ccRasterCell& aCell                 = row[i];
+					double        cellAvgHeight         = 0.0;
+					double        cellStdDevHeight      = 0.0;
+					double        cellModelStdDevHeight = std::numeric_limits<double>::quiet_NaN(); // for inv. var. projection mode only
+
+					size_t cellIndex        = static_cast<size_t>(j) * width + i;
+					aCell.pointIndexesStart = cellStart[cellIndex];
+					aCell.nbPoints          = cellStart[cellIndex + 1] - cellStart[cellIndex];
+
+					if (aCell.nbPoints)
 					{
-						unsigned         pointIndex     = static_cast<unsigned>(pRef - pointRefList.data());
-						const CCVector3* P              = cloud->getPoint(pointIndex);
-						cellPointIndexedHeight[n].index = pointIndex;
-						cellPointIndexedHeight[n].val   = P->u[Z];
-						pRef                            = reinterpret_cast<void**>(*pRef);
-					}
+						try
+						{
+							if (cellPointIndexedHeight.size() < aCell.nbPoints)
+							{
+								cellPointIndexedHeight.resize(aCell.nbPoints);
+								sfValues.reserve(aCell.nbPoints);
+								if (projectionType == PROJ_INVERSE_VAR_VALUE)
+								{
+									cellInvVarianceValues.resize(aCell.nbPoints);
+								}
+							}
+						}
+						catch (const std::bad_alloc&)
+						{
+							// out of memory
+							notEnoughMemory = true;
+							break;
+						}
 
-					auto cellPointIndexedHeightEnd = std::next(cellPointIndexedHeight.begin(), aCell.nbPoints);
-					// sorting indexed points in cell based on height in ascending order
-					ParallelSort(cellPointIndexedHeight.begin(), cellPointIndexedHeightEnd, [](const IndexAndValue& a, const IndexAndValue& b)
-					             { return a.val < b.val; });
+						// Assemble a list of all points in this cell (they are contiguous in 'pointIndexes')
+						for (unsigned n = 0; n < aCell.nbPoints; ++n)
+						{
+							unsigned         pointIndex     = pointIndexes[aCell.pointIndexesStart + n];
+							const CCVector3* P              = cloud->getPoint(pointIndex);
+							cellPointIndexedHeight[n].index = pointIndex;
+							cellPointIndexedHeight[n].val   = P->u[Z];
+						}
 
-					// compute standard statistics on height values
+						auto cellPointIndexedHeightEnd = std::next(cellPointIndexedHeight.begin(), aCell.nbPoints);
+						// sorting indexed points in cell based on height in ascending order
+						// (the cells are already processed in parallel)
+						std::sort(cellPointIndexedHeight.begin(), cellPointIndexedHeightEnd, [](const IndexAndValue& a, const IndexAndValue& b)
+						          { return a.val < b.val; });
 
-					// extract min/max value
-					aCell.minHeight = cellPointIndexedHeight.front().val;
-					aCell.maxHeight = cellPointIndexedHeight[aCell.nbPoints - 1].val;
+						// compute standard statistics on height values
 
-					if (projectionType != PROJ_INVERSE_VAR_VALUE)
-					{
-						// calculate average value and std dev
-						cellAvgHeight        = 0.0;
-						double cellSquareSum = 0.0;
-						for (unsigned n = 0; n < aCell.nbPoints; n++)
+						// extract min/max value
+						aCell.minHeight = cellPointIndexedHeight.front().val;
+						aCell.maxHeight = cellPointIndexedHeight[aCell.nbPoints - 1].val;
+
+						if (projectionType != PROJ_INVERSE_VAR_VALUE)
 						{
-							double h = cellPointIndexedHeight[n].val;
-							cellAvgHeight += h;
-							cellSquareSum += h * h;
+							// calculate average value and std dev
+							cellAvgHeight        = 0.0;
+							double cellSquareSum = 0.0;
+							for (unsigned n = 0; n < aCell.nbPoints; n++)
+							{
+								double h = cellPointIndexedHeight[n].val;
+								cellAvgHeight += h;
+								cellSquareSum += h * h;
+							}
+							cellAvgHeight /= aCell.nbPoints;
+							cellStdDevHeight = sqrt(std::max(0.0, cellSquareSum / aCell.nbPoints - cellAvgHeight * cellAvgHeight));
 						}
-						cellAvgHeight /= aCell.nbPoints;
-						cellStdDevHeight = sqrt(std::max(0.0, cellSquareSum / aCell.nbPoints - cellAvgHeight * cellAvgHeight));
-					}
-					else // inverse variance projection mode
-					{
-						assert(zStdDevSF);
-						// Calculate weighted average
-						double sumInverseVariance = 0.0;
-						double weightedSum        = 0.0;
-						double weightedSquareSum  = 0.0;
-						for (unsigned n = 0; n < aCell.nbPoints; ++n)
+						else // inverse variance projection mode
 						{
-							// Compute inverse variance for all points in the current cell
-							ScalarType stdDev = zStdDevSF->getValue(cellPointIndexedHeight[n].index);
-							if (ccScalarField::ValidValue(stdDev) && CCCoreLib::GreaterThanEpsilon(stdDev))
+							assert(zStdDevSF);
+							// Calculate weighted average
+							double sumInverseVariance = 0.0;
+							double weightedSum        = 0.0;
+							double weightedSquareSum  = 0.0;
+							for (unsigned n = 0; n < aCell.nbPoints; ++n)
 							{
-								double invVar = 1.0 / (static_cast<double>(stdDev) * stdDev);
-								weightedSum += invVar * cellPointIndexedHeight[n].val;
-								weightedSquareSum += invVar * cellPointIndexedHeight[n].val * cellPointIndexedHeight[n].val;
-								sumInverseVariance += invVar;
+								// Compute inverse variance for all points in the current cell
+								ScalarType stdDev = zStdDevSF->getValue(cellPointIndexedHeight[n].index);
+								if (ccScalarField::ValidValue(stdDev) && CCCoreLib::GreaterThanEpsilon(stdDev))
+								{
+									double invVar = 1.0 / (static_cast<double>(stdDev) * stdDev);
+									weightedSum += invVar * cellPointIndexedHeight[n].val;
+									weightedSquareSum += invVar * cellPointIndexedHeight[n].val * cellPointIndexedHeight[n].val;
+									sumInverseVariance += invVar;
+
+									cellInvVarianceValues[n] = static_cast<ScalarType>(invVar);
+								}
+								else
+								{
+									cellInvVarianceValues[n] = CCCoreLib::NAN_VALUE;
+								}
+							}
 
-								cellInvVarianceValues[n] = static_cast<ScalarType>(invVar);
+							if (CCCoreLib::GreaterThanEpsilon(sumInverseVariance))
+							{
+								cellAvgHeight         = weightedSum / sumInverseVariance;
+								cellStdDevHeight      = std::sqrt(std::abs(weightedSquareSum / sumInverseVariance - cellAvgHeight * cellAvgHeight));
+								cellModelStdDevHeight = std::sqrt(1.0 / sumInverseVariance);
 							}
 							else
 							{
-								cellInvVarianceValues[n] = CCCoreLib::NAN_VALUE;
+								// we can't compute these values if the weight is null (= no valid SF value)
+								cellAvgHeight = cellStdDevHeight = cellModelStdDevHeight = std::numeric_limits<double>::quiet_NaN();
 							}
 						}
 
-						if (CCCoreLib::GreaterThanEpsilon(sumInverseVariance))
-						{
-							cellAvgHeight         = weightedSum / sumInverseVariance;
-							cellStdDevHeight      = std::sqrt(std::abs(weightedSquareSum / sumInverseVariance - cellAvgHeight * cellAvgHeight));
-							cellModelStdDevHeight = std::sqrt(1.0 / sumInverseVariance);
-						}
-						else
-						{
-							// we can't compute these values if the weight is null (= no valid SF value)
-							cellAvgHeight = cellStdDevHeight = cellModelStdDevHeight = std::numeric_limits<double>::quiet_NaN();
-						}
-					}
-
-					// pick a point (index) that correspond to the selected 'height' value
-					switch (projectionType)
-					{
-					case PROJ_MINIMUM_VALUE:
-						aCell.h                 = aCell.minHeight;
-						aCell.nearestPointIndex = cellPointIndexedHeight.front().index;
-						break;
-					case PROJ_AVERAGE_VALUE:
-					case PROJ_INVERSE_VAR_VALUE:
-						aCell.h = cellAvgHeight;
-						if (std::isfinite(aCell.h))
+						// pick a point (index) that correspond to the selected 'height' value
+						switch (projectionType)
 						{
-							// we choose the point which is the closest to the cell center (in 2D)
-							CCVector2d C                    = computeCellCenter(i, j, X, Y);
-							double     minimumSquareDistToP = 0.0;
-							for (unsigned n = 0; n < aCell.nbPoints; n++)
+						case PROJ_MINIMUM_VALUE:
+							aCell.h                 = aCell.minHeight;
+							aCell.nearestPointIndex = cellPointIndexedHeight.front().index;
+							break;
+						case PROJ_AVERAGE_VALUE:
+						case PROJ_INVERSE_VAR_VALUE:
+							aCell.h = cellAvgHeight;
+							if (std::isfinite(aCell.h))
 							{
-								unsigned         pointIndex = cellPointIndexedHeight[n].index;
-								const CCVector3* P          = cloud->getPoint(pointIndex);
-								CCVector2d       P2D(P->u[X], P->u[Y]);
-								double           squareDistToP = (C - P2D).norm2();
-								if ((squareDistToP < minimumSquareDistToP) || (n == 0))
+								// we choose the point which is the closest to the cell center (in 2D)
+								CCVector2d C                    = computeCellCenter(i, j, X, Y);
+								double     minimumSquareDistToP = 0.0;
+								for (unsigned n = 0; n < aCell.nbPoints; n++)
 								{
-									minimumSquareDistToP    = squareDistToP;
-									aCell.nearestPointIndex = pointIndex;
+									unsigned         pointIndex = cellPointIndexedHeight[n].index;
+									const CCVector3* P          = cloud->getPoint(pointIndex);
+									CCVector2d       P2D(P->u[X], P->u[Y]);
+									double           squareDistToP = (C - P2D).norm2();
+									if ((squareDistToP < minimumSquareDistToP) || (n == 0))
+									{
+										minimumSquareDistToP    = squareDistToP;
+										aCell.nearestPointIndex = pointIndex;
+									}
 								}
 							}
-						}
-						break;
-					case PROJ_MEDIAN_VALUE:
-					{
-						// extract median value
-						unsigned indexMid = aCell.nbPoints / 2;
-						if (aCell.nbPoints % 2) // odd value
-						{
-							aCell.h = cellPointIndexedHeight[indexMid].val;
-						}
-						else
+							break;
+						case PROJ_MEDIAN_VALUE:
 						{
-							aCell.h = (cellPointIndexedHeight[indexMid - 1].val + cellPointIndexedHeight[indexMid].val) / 2;
+							// extract median value
+							unsigned indexMid = aCell.nbPoints / 2;
+							if (aCell.nbPoints % 2) // odd value
+							{
+								aCell.h = cellPointIndexedHeight[indexMid].val;
+							}
+							else
+							{
+								aCell.h = (cellPointIndexedHeight[indexMid - 1].val + cellPointIndexedHeight[indexMid].val) / 2;
+							}
+							aCell.nearestPointIndex = cellPointIndexedHeight[indexMid].index;
 						}
-						aCell.nearestPointIndex = cellPointIndexedHeight[indexMid].index;
-					}
-					break;
-					case PROJ_MAXIMUM_VALUE:
-						aCell.h                 = aCell.maxHeight;
-						aCell.nearestPointIndex = cellPointIndexedHeight[aCell.nbPoints - 1].index;
 						break;
-					default:
-						assert(false);
-						break;
-					}
+						case PROJ_MAXIMUM_VALUE:
+							aCell.h                 = aCell.maxHeight;
+							aCell.nearestPointIndex = cellPointIndexedHeight[aCell.nbPoints - 1].index;
+							break;
+						default:
+							assert(false);
+							break;
+						}
 
-					// if the cloud has RGB-colors
-					if (hasColors)
-					{
-						assert(cloud->hasColors());
-						if (projectionType == PROJ_AVERAGE_VALUE)
+						// if the cloud has RGB-colors
+						if (hasColors)
 						{
-							// compute the average color
-							aCell.color = CCVector3d(0, 0, 0);
-							for (unsigned n = 0; n < aCell.nbPoints; n++)
+							assert(cloud->hasColors());
+							if (projectionType == PROJ_AVERAGE_VALUE)
 							{
-								unsigned            pointIndex = cellPointIndexedHeight[n].index;
-								const ccColor::Rgb& col        = cloud->getPointColor(pointIndex);
-								aCell.color += CCVector3d(col.r, col.g, col.b);
+								// compute the average color
+								aCell.color = CCVector3d(0, 0, 0);
+								for (unsigned n = 0; n < aCell.nbPoints; n++)
+								{
+									unsigned            pointIndex = cellPointIndexedHeight[n].index;
+									const ccColor::Rgb& col        = cloud->getPointColor(pointIndex);
+									aCell.color += CCVector3d(col.r, col.g, col.b);
+								}
+								aCell.color /= aCell.nbPoints;
+							}
+							else
+							{
+								// pick color from selected index
+								const ccColor::Rgb& col = cloud->getPointColor(aCell.nearestPointIndex);
+								aCell.color             = CCVector3d(col.r, col.g, col.b);
 							}
-							aCell.color /= aCell.nbPoints;
-						}
-						else
-						{
-							// pick color from selected index
-							const ccColor::Rgb& col = cloud->getPointColor(aCell.nearestPointIndex);
-							aCell.color             = CCVector3d(col.r, col.g, col.b);
 						}
-					}
-
-					// if we should project the scalar fields
-					if (projectSFs)
-					{
-						assert(pc);
-						// absolute position of the cell (e.g. in the 2D SF grid(s))
-						int pos = j * static_cast<int>(width) + i;
-						assert(pos < static_cast<int>(gridTotalSize));
 
-						for (size_t k = 0; k < scalarFields.size(); ++k)
+						// if we should project the scalar fields
+						if (projectSFs)
 						{
-							assert(!scalarFields[k].empty());
-							CCCoreLib::ScalarField* sf = pc->getScalarField(static_cast<unsigned>(k));
+							assert(pc);
+							// absolute position of the cell (e.g. in the 2D SF grid(s))
+							int pos = j * static_cast<int>(width) + i;
+							assert(pos < static_cast<int>(gridTotalSize));
 
-							assert(sf && pos < scalarFields[k].size());
-
-							switch (sfProjectionType)
-							{
-							case PROJ_MINIMUM_VALUE:
+							for (size_t k = 0; k < scalarFields.size(); ++k)
 							{
-								ScalarType minValue = CCCoreLib::NAN_VALUE;
-								for (unsigned n = 0; n < aCell.nbPoints; n++)
+								assert(!scalarFields[k].empty());
+								CCCoreLib::ScalarField* sf = pc->getScalarField(static_cast<unsigned>(k));
+
+								assert(sf && pos < scalarFields[k].size());
+
+								switch (sfProjectionType)
+								{
+								case PROJ_MINIMUM_VALUE:
 								{
-									unsigned   pointIndex = cellPointIndexedHeight[n].index;
-									ScalarType value      = sf->getValue(pointIndex);
-									if (CCCoreLib::ScalarField::ValidValue(value))
+									ScalarType minValue = CCCoreLib::NAN_VALUE;
+									for (unsigned n = 0; n < aCell.nbPoints; n++)
 									{
-										if (std::isnan(minValue) || minValue > value)
+										unsigned   pointIndex = cellPointIndexedHeight[n].index;
+										ScalarType value      = sf->getValue(pointIndex);
+										if (CCCoreLib::ScalarField::ValidValue(value))
 										{
-											minValue = value;
+											if (std::isnan(minValue) || minValue > value)
+											{
+												minValue = value;
+											}
 										}
 									}
+									scalarFields[k][pos] = minValue;
 								}
-								scalarFields[k][pos] = minValue;
-							}
-							break;
+								break;
 
-							case PROJ_MEDIAN_VALUE:
-							{
-								sfValues.clear();
-								sfValues.reserve(aCell.nbPoints);
-								for (unsigned n = 0; n < aCell.nbPoints; n++)
+								case PROJ_MEDIAN_VALUE:
 								{
-									unsigned   pointIndex = cellPointIndexedHeight[n].index;
-									ScalarType value      = sf->getValue(pointIndex);
-									if (CCCoreLib::ScalarField::ValidValue(value))
+									sfValues.clear();
+									sfValues.reserve(aCell.nbPoints);
+									for (unsigned n = 0; n < aCell.nbPoints; n++)
+									{
+										unsigned   pointIndex = cellPointIndexedHeight[n].index;
+										ScalarType value      = sf->getValue(pointIndex);
+										if (CCCoreLib::ScalarField::ValidValue(value))
+										{
+											sfValues.push_back(value);
+										}
+									}
+									if (sfValues.size() > 1)
 									{
-										sfValues.push_back(value);
+										std::sort(sfValues.begin(), sfValues.end());
+										size_t midIndex = sfValues.size() / 2;
+										if (sfValues.size() % 2) // odd number
+										{
+											scalarFields[k][pos] = sfValues[midIndex];
+										}
+										else
+										{
+											scalarFields[k][pos] = static_cast<ScalarType>((static_cast<double>(sfValues[midIndex - 1]) + sfValues[midIndex]) / 2);
+										}
 									}
-								}
-								if (sfValues.size() > 1)
-								{
-									ParallelSort(sfValues.begin(), sfValues.end());
-									size_t midIndex = sfValues.size() / 2;
-									if (sfValues.size() % 2) // odd number
+									else if (sfValues.size() == 1)
 									{
-										scalarFields[k][pos] = sfValues[midIndex];
+										scalarFields[k][pos] = sfValues[0];
 									}
 									else
 									{
-										scalarFields[k][pos] = static_cast<ScalarType>((static_cast<double>(sfValues[midIndex - 1]) + sfValues[midIndex]) / 2);
+										scalarFields[k][pos] = CCCoreLib::NAN_VALUE;
 									}
 								}
-								else if (sfValues.size() == 1)
-								{
-									scalarFields[k][pos] = sfValues[0];
-								}
-								else
-								{
-									scalarFields[k][pos] = CCCoreLib::NAN_VALUE;
-								}
-							}
-							break;
+								break;
 
-							case PROJ_MAXIMUM_VALUE:
-							{
-								ScalarType maxValue = CCCoreLib::NAN_VALUE;
-								for (unsigned n = 0; n < aCell.nbPoints; n++)
+								case PROJ_MAXIMUM_VALUE:
 								{
-									unsigned   pointIndex = cellPointIndexedHeight[n].index;
-									ScalarType value      = sf->getValue(pointIndex);
-									if (CCCoreLib::ScalarField::ValidValue(value))
+									ScalarType maxValue = CCCoreLib::NAN_VALUE;
+									for (unsigned n = 0; n < aCell.nbPoints; n++)
 									{
-										if (std::isnan(maxValue) || maxValue < value)
+										unsigned   pointIndex = cellPointIndexedHeight[n].index;
+										ScalarType value      = sf->getValue(pointIndex);
+										if (CCCoreLib::ScalarField::ValidValue(value))
 										{
-											maxValue = value;
+											if (std::isnan(maxValue) || maxValue < value)
+											{
+												maxValue = value;
+											}
 										}
 									}
+									scalarFields[k][pos] = maxValue;
 								}
-								scalarFields[k][pos] = maxValue;
-							}
-							break;
+								break;
 
-							case PROJ_AVERAGE_VALUE:
-							{
-								// for average, we do a simple average of unsorted SF-values in cell
-								double   scalarFieldWeightedSum = 0.0;
-								unsigned validPointCount        = 0;
-								for (unsigned n = 0; n < aCell.nbPoints; n++)
+								case PROJ_AVERAGE_VALUE:
 								{
-									unsigned   pointIndex = cellPointIndexedHeight[n].index;
-									ScalarType value      = sf->getValue(pointIndex);
-									if (CCCoreLib::ScalarField::ValidValue(value))
+									// for average, we do a simple average of unsorted SF-values in cell
+									double   scalarFieldWeightedSum = 0.0;
+									unsigned validPointCount        = 0;
+									for (unsigned n = 0; n < aCell.nbPoints; n++)
 									{
-										scalarFieldWeightedSum += value;
-										++validPointCount;
+										unsigned   pointIndex = cellPointIndexedHeight[n].index;
+										ScalarType value      = sf->getValue(pointIndex);
+										if (CCCoreLib::ScalarField::ValidValue(value))
+										{
+											scalarFieldWeightedSum += value;
+											++validPointCount;
+										}
 									}
+									scalarFields[k][pos] = validPointCount != 0 ? scalarFieldWeightedSum / validPointCount : std::numeric_limits<double>::quiet_NaN();
 								}
-								scalarFields[k][pos] = validPointCount != 0 ? scalarFieldWeightedSum / validPointCount : std::numeric_limits<double>::quiet_NaN();
-							}
-							break;
+								break;
 
-							case PROJ_INVERSE_VAR_VALUE:
-								// inverse variance projection mode: weighted average with weights of 1/var
-								if (projectionType == PROJ_INVERSE_VAR_VALUE && k == zStdDevSfIndex)
-								{
-									// Special case for the 'std deviation' scalar field, output layer should
-									// just be filled with the updated model standard deviation.
-									scalarFields[k][pos] = cellModelStdDevHeight;
-								}
-								else
-								{
-									assert(zStdDevSF);
-									double scalarFieldWeightedSum = 0.0;
-									double scalarFieldWeightSum   = 0.0;
-									for (unsigned n = 0; n < aCell.nbPoints; n++)
+								case PROJ_INVERSE_VAR_VALUE:
+									// inverse variance projection mode: weighted average with weights of 1/var
+									if (projectionType == PROJ_INVERSE_VAR_VALUE && k == zStdDevSfIndex)
 									{
-										unsigned   pointIndex = cellPointIndexedHeight[n].index;
-										ScalarType stdDev     = zStdDevSF->getValue(pointIndex);
-										if (ccScalarField::ValidValue(stdDev) && CCCoreLib::GreaterThanEpsilon(stdDev))
+										// Special case for the 'std deviation' scalar field, output layer should
+										// just be filled with the updated model standard deviation.
+										scalarFields[k][pos] = cellModelStdDevHeight;
+									}
+									else
+									{
+										assert(zStdDevSF);
+										double scalarFieldWeightedSum = 0.0;
+										double scalarFieldWeightSum   = 0.0;
+										for (unsigned n = 0; n < aCell.nbPoints; n++)
 										{
-											ScalarType value = sf->getValue(pointIndex);
-											if (ccScalarField::ValidValue(value))
+											unsigned   pointIndex = cellPointIndexedHeight[n].index;
+											ScalarType stdDev     = zStdDevSF->getValue(pointIndex);
+											if (ccScalarField::ValidValue(stdDev) && CCCoreLib::GreaterThanEpsilon(stdDev))
 											{
-												ScalarType weight = 1.0 / (stdDev * stdDev);
-												scalarFieldWeightedSum += static_cast<double>(weight) * value;
-												scalarFieldWeightSum += weight;
+												ScalarType value = sf->getValue(pointIndex);
+												if (ccScalarField::ValidValue(value))
+												{
+													ScalarType weight = 1.0 / (stdDev * stdDev);
+													scalarFieldWeightedSum += static_cast<double>(weight) * value;
+													scalarFieldWeightSum += weight;
+												}
 											}
 										}
+
+										scalarFields[k][pos] = CCCoreLib::GreaterThanEpsilon(scalarFieldWeightSum) ? scalarFieldWeightedSum / scalarFieldWeightSum : std::numeric_limits<double>::quiet_NaN();
 									}
+									break;
 
-									scalarFields[k][pos] = CCCoreLib::GreaterThanEpsilon(scalarFieldWeightSum) ? scalarFieldWeightedSum / scalarFieldWeightSum : std::numeric_limits<double>::quiet_NaN();
+								default:
+									assert(false);
+									break;
 								}
-								break;
-
-							default:
-								assert(false);
-								break;
 							}
 						}
 					}
@@ -726,6 +781,12 @@ bool ccRasterGrid::fillWith(ccGenericPointCloud* cloud,
 				nProgress.oneStep();
 			}
 		}
+
+		if (notEnoughMemory)
+		{
+			ccLog::Error("Not enough memory");
+			return false;
+		}
 	}
 
 	// compute the number of non empty cells
@@ -850,71 +911,88 @@ static void InterpolateOnBorder(const std::vector<uint8_t>& pointsOnBorder,
 	}
 }
 
-bool ccRasterGrid::interpolateEmptyCells(double maxSquareEdgeLength)
+//! Interpolates the empty cells of a given tile of the grid (Delaunay-based)
+/** The (non-empty) cells of the tile extended by 'overlap' cells on each side are triangulated,
+    and only the empty cells of the tile 'core' [x0 ; x1[ x [y0 ; y1[ are updated.
+    \return false if the triangulation failed
+**/
+static bool InterpolateEmptyCellsInTile(ccRasterGrid& grid,
+                                        unsigned      x0,
+                                        unsigned      y0,
+                                        unsigned      x1,
+                                        unsigned      y1,
+                                        unsigned      overlap,
+                                        double        maxSquareEdgeLength)
 {
-	if (nonEmptyCellCount < 3)
+	const unsigned width  = grid.width;
+	const unsigned height = grid.height;
+
+	// extended tile
+	const unsigned ex0 = x0 - std::min(x0, overlap);
+	const unsigned ey0 = y0 - std::min(y0, overlap);
+	const unsigned ex1 = std::min(width, x1 + overlap);
+	const unsigned ey1 = std::min(height, y1 + overlap);
+
+	// is there any empty cell in the tile core?
+	bool hasEmptyCells = false;
+	for (unsigned j = y0; j < y1 && !hasEmptyCells; ++j)
 	{
-		ccLog::Warning("[Rasterize] Not enough non-empty cells for interpolation!");
-		return false;
+		const ccRasterGrid::Row& row = grid.rows[j];
+		for (unsigned i = x0; i < x1; ++i)
+		{
+			if (!row[i].nbPoints && !std::isfinite(row[i].h))
+			{
+				hasEmptyCells = true;
+				break;
+			}
+		}
 	}
-
-	if (nonEmptyCellCount >= width * height)
+	if (!hasEmptyCells)
 	{
 		// nothing to do
 		return true;
 	}
 
+	// fill 2D vector with non-empty cell indexes
 	std::vector<CCVector2> the2DPoints;
 	try
 	{
-		the2DPoints.resize(nonEmptyCellCount);
+		for (unsigned j = ey0; j < ey1; ++j)
+		{
+			const ccRasterGrid::Row& row = grid.rows[j];
+			for (unsigned i = ex0; i < ex1; ++i)
+			{
+				if (row[i].nbPoints)
+				{
+					// we only use the non-empty cells for interpolation
+					the2DPoints.emplace_back(static_cast<PointCoordinateType>(i), static_cast<PointCoordinateType>(j));
+				}
+			}
+		}
 	}
 	catch (const std::bad_alloc&)
 	{
 		// out of memory
-		ccLog::Warning("[Rasterize] Not enough memory to interpolate empty cells!");
 		return false;
 	}
 
-	// fill 2D vector with non-empty cell indexes
-	unsigned index = 0;
-	for (unsigned j = 0; j < height; ++j)
+	if (the2DPoints.size() < 3)
 	{
-		const Row& row = rows[j];
-		for (unsigned i = 0; i < width; ++i)
-		{
-			if (row[i].nbPoints)
-			{
-				// we only use the non-empty cells for interpolation
-				the2DPoints[index++] = CCVector2(static_cast<PointCoordinateType>(i), static_cast<PointCoordinateType>(j));
-			}
-		}
+		// not enough non-empty cells in the vicinity of this tile
+		return true;
 	}
-	assert(index == nonEmptyCellCount);
 
 	// mesh the '2D' points
 	CCCoreLib::Delaunay2dMesh delaunayMesh;
 	std::string               errorStr;
 	if (!delaunayMesh.buildMesh(the2DPoints, CCCoreLib::Delaunay2dMesh::USE_ALL_POINTS, errorStr))
 	{
-		ccLog::Warning(QStringLiteral("[Rasterize] Empty cells interpolation failed. Could not compute the 2.5D mesh ('%1')")
-		                   .arg(QString::fromStdString(errorStr)));
 		return false;
 	}
 
-	if (maxSquareEdgeLength > 0.0)
-	{
-		// we have to scale the maxSquareEdgeLength parameters as we will consider now 'cells' and not real units
-		maxSquareEdgeLength /= (gridStep * gridStep);
-	}
-
 	// now we are going to 'project' all triangles on the grid
 	delaunayMesh.placeIteratorAtBeginning();
 	unsigned triNum = delaunayMesh.size();
-#ifdef _DEBUG
-	size_t interpolatedCells = 0;
-	size_t toolLongEdgeCount = 0;
-#endif
 	for (unsigned k = 0; k < triNum; ++k)
 	{
 		const CCCoreLib::VerticesIndexes* tsi = delaunayMesh.getNextTriangleVertIndexes();
@@ -926,9 +1004,6 @@ bool ccRasterGrid::interpolateEmptyCells(double maxSquareEdgeLength)
 
 			if ((B2D - A2D).norm2() > maxSquareEdgeLength)
 			{
-#ifdef _DEBUG
-				++toolLongEdgeCount;
-#endif
 				continue;
 			}
 
@@ -936,9 +1011,6 @@ bool ccRasterGrid::interpolateEmptyCells(double maxSquareEdgeLength)
 			if ((C2D - A2D).norm2() > maxSquareEdgeLength
 			    || (C2D - B2D).norm2() > maxSquareEdgeLength)
 			{
-#ifdef _DEBUG
-				++toolLongEdgeCount;
-#endif
 				continue;
 			}
 		}
@@ -969,24 +1041,25 @@ bool ccRasterGrid::interpolateEmptyCells(double maxSquareEdgeLength)
 				if (static_cast<unsigned>(P[k].y + 1) == height)
 					onTopBorder.push_back(k);
 			}
-			xMin = std::min(std::min(P[0].x, P[1].x), P[2].x);
-			yMin = std::min(std::min(P[0].y, P[1].y), P[2].y);
-			xMax = std::max(std::max(P[0].x, P[1].x), P[2].x);
-			yMax = std::max(std::max(P[0].y, P[1].y), P[2].y);
+			// we only update the cells of the tile core
+			xMin = std::max(std::min(std::min(P[0].x, P[1].x), P[2].x), static_cast<int>(x0));
+			yMin = std::max(std::min(std::min(P[0].y, P[1].y), P[2].y), static_cast<int>(y0));
+			xMax = std::min(std::max(std::max(P[0].x, P[1].x), P[2].x), static_cast<int>(x1) - 1);
+			yMax = std::min(std::max(std::max(P[0].y, P[1].y), P[2].y), static_cast<int>(y1) - 1);
 		}
 
 		// now scan the cells
 		{
 			// pre-computation for barycentric coordinates
-			const double& valA = rows[P[0].y][P[0].x].h;
-			const double& valB = rows[P[1].y][P[1].x].h;
-			const double& valC = rows[P[2].y][P[2].x].h;
+			const double& valA = grid.rows[P[0].y][P[0].x].h;
+			const double& valB = grid.rows[P[1].y][P[1].x].h;
+			const double& valC = grid.rows[P[2].y][P[2].x].h;
 
 			int det = (P[1].y - P[2].y) * (P[0].x - P[2].x) - (P[1].x - P[2].x) * (P[0].y - P[2].y);
 
 			for (int j = yMin; j <= yMax; ++j)
 			{
-				Row& row = rows[static_cast<unsigned>(j)];
+				ccRasterGrid::Row& row = grid.rows[static_cast<unsigned>(j)];
 
 				for (int i = xMin; i <= xMax; ++i)
 				{
@@ -1022,21 +1095,18 @@ bool ccRasterGrid::interpolateEmptyCells(double maxSquareEdgeLength)
 
 							row[i].h = l1 * valA + l2 * valB + l3 * valC;
 							// assert(std::isfinite(row[i].h)); //it can happen with the inv. var. projection mode
-#ifdef _DEBUG
-							++interpolatedCells;
-#endif
 
 							// interpolate color as well!
-							if (hasColors)
+							if (grid.hasColors)
 							{
-								const CCVector3d& colA = rows[P[0].y][P[0].x].color;
-								const CCVector3d& colB = rows[P[1].y][P[1].x].color;
-								const CCVector3d& colC = rows[P[2].y][P[2].x].color;
+								const CCVector3d& colA = grid.rows[P[0].y][P[0].x].color;
+								const CCVector3d& colB = grid.rows[P[1].y][P[1].x].color;
+								const CCVector3d& colC = grid.rows[P[2].y][P[2].x].color;
 								row[i].color           = l1 * colA + l2 * colB + l3 * colC;
 							}
 
 							// interpolate the SFs as well!
-							for (auto& gridSF : scalarFields)
+							for (auto& gridSF : grid.scalarFields)
 							{
 								assert(!gridSF.empty());
 
@@ -1051,22 +1121,22 @@ bool ccRasterGrid::interpolateEmptyCells(double maxSquareEdgeLength)
 						{
 							/*if (i == 0 && onLeftBorder.size() > 1)
 							{
-							    InterpolateOnBorder(onLeftBorder, P, i, j, j, 1, row[i], *this);
+							    InterpolateOnBorder(onLeftBorder, P, i, j, j, 1, row[i], grid);
 							}
 							else */
 							if (static_cast<unsigned>(i + 1) == width && onRightBorder.size() > 1)
 							{
-								InterpolateOnBorder(onRightBorder, P, i, j, j, 1, row[i], *this);
+								InterpolateOnBorder(onRightBorder, P, i, j, j, 1, row[i], grid);
 							}
 
 							/*if (j == 0 && onBottomBorder.size() > 1)
 							{
-							    InterpolateOnBorder(onBottomBorder, P, i, j, i, 0, row[i], *this);
+							    InterpolateOnBorder(onBottomBorder, P, i, j, i, 0, row[i], grid);
 							}
 							else*/
 							if (static_cast<unsigned>(j + 1) == height && onTopBorder.size() > 1)
 							{
-								InterpolateOnBorder(onTopBorder, P, i, j, i, 0, row[i], *this);
+								InterpolateOnBorder(onTopBorder, P, i, j, i, 0, row[i], grid);
 							}
 						}
 					}
@@ -1078,6 +1148,80 @@ bool ccRasterGrid::interpolateEmptyCells(double maxSquareEdgeLength)
 	return true;
 }
 
+bool ccRasterGrid::interpolateEmptyCells(double maxSquareEdgeLength)
+{
+	if (nonEmptyCellCount < 3)
+	{
+		ccLog::Warning("[Rasterize] Not enough non-empty cells for interpolation!");
+		return false;
+	}
+
+	if (nonEmptyCellCount >= width * height)
+	{
+		// nothing to do
+		return true;
+	}
+
+	// by default, the whole grid is triangulated at once
+	unsigned tileSizeX = width;
+	unsigned tileSizeY = height;
+	unsigned overlap   = 0;
+
+	if (maxSquareEdgeLength > 0.0)
+	{
+		// we have to scale the maxSquareEdgeLength parameters as we will consider now 'cells' and not real units
+		maxSquareEdgeLength /= (gridStep * gridStep);
+
+		// as the triangles are bounded, the grid can be processed by tiles (concurrently). Each tile is
+		// triangulated independently, with an overlap (twice as large as the max edge length) so that the
+		// cells close to the tile borders are still covered by triangles. However, the triangulation of a
+		// tile may differ from a global one near its borders (e.g. for thin triangles whose circumcircle
+		// extends beyond the overlap), and the empty cells there may be interpolated with slightly
+		// different triangles.
+		static const unsigned s_minTileSize = 512;
+		double                maxEdgeLength = std::sqrt(maxSquareEdgeLength);
+		if (maxEdgeLength < width && maxEdgeLength < height)
+		{
+			overlap   = static_cast<unsigned>(std::ceil(2 * maxEdgeLength)) + 1;
+			tileSizeX = tileSizeY = std::max(s_minTileSize, 4 * overlap);
+		}
+	}
+
+	const unsigned tileCountX = (width + tileSizeX - 1) / tileSizeX;
+	const unsigned tileCountY = (height + tileSizeY - 1) / tileSizeY;
+	const int      tileCount  = static_cast<int>(tileCountX * tileCountY);
+
+	std::atomic<unsigned> failedTileCount(0);
+
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(omp_get_max_threads())
+#endif
+	for (int t = 0; t < tileCount; ++t)
+	{
+		unsigned x0 = (static_cast<unsigned>(t) % tileCountX) * tileSizeX;
+		unsigned y0 = (static_cast<unsigned>(t) / tileCountX) * tileSizeY;
+		unsigned x1 = std::min(width, x0 + tileSizeX);
+		unsigned y1 = std::min(height, y0 + tileSizeY);
+
+		if (!InterpolateEmptyCellsInTile(*this, x0, y0, x1, y1, overlap, maxSquareEdgeLength))
+		{
+			++failedTileCount;
+		}
+	}
+
+	if (failedTileCount != 0)
+	{
+		if (tileCount == 1)
+		{
+			ccLog::Warning("[Rasterize] Empty cells interpolation failed. Could not compute the 2.5D mesh");
+			return false;
+		}
+		ccLog::Warning(QString("[Rasterize] Empty cells interpolation failed on %1 tile(s) out of %2").arg(failedTileCount.load()).arg(tileCount));
+	}
+
+	return true;
+}
+
 bool ccRasterGrid::fillGridCellsWithKriging(unsigned char         Z,
                                             int                   knn,
                                             Kriging::KrigeParams& krigeParams,
@@ -1146,18 +1290,73 @@ bool ccRasterGrid::fillGridCellsWithKriging(unsigned char         Z,
 	if (hasColors)
 		stepCount += 3;
 
-	CCCoreLib::NormalizedProgress nProgress(progressDialog, static_cast<unsigned>(nonEmptyCellCount * stepCount));
+	CCCoreLib::NormalizedProgress nProgress(progressDialog, height * stepCount);
 
 	Kriging kriging(dataPoints, rasterParams);
 	knn = std::min(knn, static_cast<int>(nonEmptyCellCount - 1));
 
-	auto* context = kriging.createOrdinaryKrigeContext(knn);
-	if (!context)
+	// the cells are processed concurrently (by rows), with one Kriging context per thread
+	// (i.e. neighbors search structure + working matrices), reused for all the layers
+#if defined(_OPENMP)
+	const int threadCount = omp_get_max_threads();
+#else
+	const int threadCount = 1;
+#endif
+	std::vector<decltype(kriging.createOrdinaryKrigeContext(knn))> contexts(threadCount, nullptr);
+	for (auto& context : contexts)
 	{
-		ccLog::Error(QObject::tr("Failed to initialize the Kriging algorithm"));
-		return false;
+		context = kriging.createOrdinaryKrigeContext(knn);
+		if (!context)
+		{
+			ccLog::Error(QObject::tr("Failed to initialize the Kriging algorithm"));
+			for (auto& c : contexts)
+			{
+				if (c)
+				{
+					kriging.releaseOrdinaryKrigeContext(c);
+				}
+			}
+			return false;
+		}
 	}
 
+	std::atomic<bool> cancelled(false);
+
+	// evaluates the Kriging estimator on all the grid cells
+	auto krigeAllCells = [&](const Kriging::KrigeParams& params, auto&& setCellValue)
+	{
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+#endif
+		for (int j = 0; j < static_cast<int>(height); ++j)
+		{
+			if (cancelled)
+			{
+				continue;
+			}
+
+#if defined(_OPENMP)
+			auto context = contexts[omp_get_thread_num()];
+#else
+			auto context = contexts.front();
+#endif
+			for (unsigned i = 0; i < width; ++i)
+			{
+				setCellValue(i, static_cast<unsigned>(j), kriging.ordinaryKrigeSingleCell(params, i, static_cast<unsigned>(j), context));
+			}
+
+			if (!nProgress.oneStep())
+			{
+				// process cancelled by user
+				cancelled = true;
+			}
+		}
+
+		return !cancelled;
+	};
+
+	bool success = true;
+
 	// process the altitudes first
 	{
 		if (!useInputParams)
@@ -1172,27 +1371,12 @@ bool ccRasterGrid::fillGridCellsWithKriging(unsigned char         Z,
 			}
 		}
 
-		for (unsigned j = 0; j < height; ++j)
-		{
-			Row& row = rows[j];
-
-			for (unsigned i = 0; i < width; ++i)
-			{
-				ccRasterCell& cell = row[i];
-				cell.h             = kriging.ordinaryKrigeSingleCell(krigeParams, i, j, context);
-
-				if (!nProgress.oneStep())
-				{
-					// process cancelled by user
-					kriging.releaseOrdinaryKrigeContext(context);
-					return false;
-				}
-			}
-		}
+		success = krigeAllCells(krigeParams, [&](unsigned i, unsigned j, double value)
+		                        { rows[j][i].h = value; });
 	}
 
 	// then process the scalar values (if any)
-	for (size_t sfIndex = 0; sfIndex < scalarFields.size(); ++sfIndex)
+	for (size_t sfIndex = 0; sfIndex < scalarFields.size() && success; ++sfIndex)
 	{
 		SF& sf = scalarFields[sfIndex];
 
@@ -1222,26 +1406,13 @@ bool ccRasterGrid::fillGridCellsWithKriging(unsigned char         Z,
 			sfKrigeParams.model = krigeParams.model;
 		}
 
-		for (unsigned j = 0; j < height; ++j)
-		{
-			Row& row = rows[j];
-
-			for (unsigned i = 0; i < width; ++i)
-			{
-				sf[i + j * width] = kriging.ordinaryKrigeSingleCell(sfKrigeParams, i, j, context);
-
-				if (!nProgress.oneStep())
-				{
-					// process cancelled by user
-					return false;
-				}
-			}
-		}
+		success = krigeAllCells(sfKrigeParams, [&](unsigned i, unsigned j, double value)
+		                        { sf[i + j * width] = value; });
 	}
 
 	if (hasColors)
 	{
-		for (unsigned char c = 0; c < 3; ++c)
+		for (unsigned char c = 0; c < 3 && success; ++c)
 		{
 			// update the kriging value
 			{
@@ -1269,29 +1440,17 @@ bool ccRasterGrid::fillGridCellsWithKriging(unsigned char         Z,
 				colorKrigeParams.model = krigeParams.model;
 			}
 
-			for (unsigned j = 0; j < height; ++j)
-			{
-				Row& row = rows[j];
-
-				for (unsigned i = 0; i < width; ++i)
-				{
-					double        col  = kriging.ordinaryKrigeSingleCell(colorKrigeParams, i, j, context);
-					ccRasterCell& cell = row[i];
-					cell.color.u[c]    = std::max(0.0, std::min(255.0, col));
-
-					if (!nProgress.oneStep())
-					{
-						// process cancelled by user
-						return false;
-					}
-				}
-			}
+			success = krigeAllCells(colorKrigeParams, [&](unsigned i, unsigned j, double value)
+			                        { rows[j][i].color.u[c] = std::max(0.0, std::min(255.0, value)); });
 		}
 	}
 
-	kriging.releaseOrdinaryKrigeContext(context);
+	for (auto& context : contexts)
+	{
+		kriging.releaseOrdinaryKrigeContext(context);
+	}
 
-	return true;
+	return success;
 }
 
 unsigned ccRasterGrid::updateNonEmptyCellCount()
@@ -1740,7 +1899,7 @@ ccPointCloud* ccRasterGrid::convertToCloud(bool
 						{
 							if (!cellPointIndexesBuilt) // only required the first time
 							{
-								aCell->getPointIndexes(cellPointIndexes, pointRefList);
+								aCell->getPointIndexes(cellPointIndexes, pointIndexes);
 								cellPointIndexesBuilt = true;
 							}
 
@@ -22,8 +22,14 @@
 
 // local
 #include "ccGlobalShiftManager.h"
+#include "ccLoadingFilter.h"
+
+// System
+#include <functional>
+#include <vector>
 
 class QWidget;
+class ccFileLoadingTask;
 
 //! Typical I/O filter errors
 enum CC_FILE_ERROR
@@ -72,6 +78,7 @@ class FileIOFilter
 		    , autoComputeNormals(false)
 		    , parentWidget(nullptr)
 		    , sessionStart(true)
+		    , loadingTask(nullptr)
 		{
 		}
 
@@ -93,6 +100,17 @@ class FileIOFilter
 		QWidget* parentWidget;
 		//! Session start (whether the load action is the first of a session)
 		bool sessionStart;
+		//! Load-time point filter (optional)
+		/** The I/O filters that decode points progressively apply it on the fly.
+		    The other clouds are filtered once loaded (see FileIOFilter::LoadFromFile).
+		**/
+		ccLoadingFilter::Shared loadingFilter;
+		//! Asynchronous loading task (if any)
+		/** Set by FileIOFilter::LoadFromFileAsync. The I/O filters can use it to report their
+		    progress (when no parent widget is set), check whether the loading has been canceled,
+		    and deliver the entities as soon as they are loaded (see FileIOFilter::DeliverEntity).
+		**/
+		ccFileLoadingTask* loadingTask;
 	};
 
 	//! Generic saving parameters
@@ -121,6 +139,9 @@ class FileIOFilter
 	//! Returns whether this I/O filter can export files
 	QCC_IO_LIB_API bool exportSupported() const;
 
+	//! Returns whether this I/O filter can load files in background threads (see FileIOFilter::LoadFromFileAsync and FileIOFilter::LoadFromFiles)
+	QCC_IO_LIB_API bool concurrentLoadSupported() const;
+
 	//! Returns the file filter(s) for this I/O filter
 	/** E.g. 'ASCII file (*.asc)'
 	    \param onImport whether the requested filters are for import or export
@@ -150,6 +171,28 @@ class FileIOFilter
 		return CC_FERR_NOT_IMPLEMENTED;
 	}
 
+	//! Prepares the loading of a file in a background thread
+	/** Called by FileIOFilter::LoadFromFiles on the calling thread, before the file is loaded by
+	    a background thread (which can't display any dialog). This is the place to display the
+	    loading dialog (if any), and to store the chosen options for FileIOFilter::loadFile.
+	    Only called for the I/O filters that declare the FileIOFilter::ConcurrentLoad feature.
+	    \param filename file to load
+	    \param parameters generic loading parameters
+	    \param[out] result error code (if the file shouldn't be loaded)
+	    \return whether the file still has to be loaded (if not, the result tells whether the file has
+	            been processed by other means or if an error occurred, e.g. CC_FERR_CANCELED_BY_USER)
+	**/
+	virtual bool prepareConcurrentLoad(const QString&  filename,
+	                                   LoadParameters& parameters,
+	                                   CC_FILE_ERROR&  result)
+	{
+		Q_UNUSED(filename);
+		Q_UNUSED(parameters);
+
+		result = CC_FERR_NO_ERROR;
+		return true;
+	}
+
 	//! Saves an entity (or a group of) to a file
 	/** This method must be implemented by children classes.
 	    \param entity entity (or group of) to save
@@ -214,6 +257,71 @@ class FileIOFilter
 	                                              CC_FILE_ERROR&  result,
 	                                              const QString&  fileFilter = QString());
 
+	//! Loads one or more entities from a file asynchronously
+	/** The file is loaded in a background thread, with the same process as FileIOFilter::LoadFromFile.
+	    As no dialog can be displayed by this thread, the I/O filters use their default (or last) parameters,
+	    and the global shift is automatically handled if the requested mode would display a dialog (see
+	    ccGlobalShiftManager::NO_DIALOG_AUTO_SHIFT). The optional global shift parameters are copied (see
+	    ccFileLoadingTask::getCoordinatesShift to retrieve the applied global shift).
+	    Only the I/O filters that declare the FileIOFilter::ConcurrentLoad feature are supported (the other
+	    ones may display dialogs or rely on a static state): CC_FERR_NOT_IMPLEMENTED is returned otherwise.
+	    \param filename filename
+	    \param parameters generic loading parameters
+	    \param[out] result file error code (if the loading couldn't be started)
+	    \param fileFilter input filter 'file filter' (if empty, the best I/O filter will be guessed from the file extension)
+	    \return loading task (or a null pointer if the loading couldn't be started)
+	**/
+	QCC_IO_LIB_API static QSharedPointer<ccFileLoadingTask> LoadFromFileAsync(const QString&        filename,
+	                                                                          const LoadParameters& parameters,
+	                                                                          CC_FILE_ERROR&        result,
+	                                                                          const QString&        fileFilter = QString());
+
+	//! Callback called once a file has been loaded (see FileIOFilter::LoadFromFiles)
+	/** The callee takes the ownership of the loaded entities (if any).
+	**/
+	using FileLoadedCallback = std::function<void(const QString& filename, ccHObject* entities, CC_FILE_ERROR result)>;
+
+	//! Callback called when entities are delivered before the end of the loading of a file (see FileIOFilter::LoadFromFiles)
+	/** The callee takes the ownership of the delivered entities.
+	**/
+	using EntitiesDeliveredCallback = std::function<void(const QString& filename, const std::vector<ccHObject*>& entities)>;
+
+	//! Loads several files, concurrently when possible
+	/** The files handled by an I/O filter that supports it (see FileIOFilter::ConcurrentLoad) are loaded
+	    in background threads (see FileIOFilter::LoadFromFileAsync), by a limited number of threads and with
+	    a limited amount of data being loaded at the same time (their loading dialogs, if any, are displayed
+	    beforehand by the calling thread, see FileIOFilter::prepareConcurrentLoad). The other files are
+	    loaded by the calling thread, one after the other (with their dialogs, if any).
+	    The Global Shift of the files loaded in the background is handled by the calling thread (see
+	    ccGlobalShiftResolver): the dialog is displayed if necessary, the first accepted Global Shift
+	    is used for the whole batch, and if the user refuses it, the next files are not shifted.
+	    \param filenames filenames
+	    \param parameters generic loading parameters
+	    \param callback called by the calling thread for each file, in the input order
+	    \param fileFilter input filter 'file filter' (if empty, the best I/O filter will be guessed from each file extension)
+	    \param maxThreadCount maximum number of files loaded concurrently (or 0 to use as many threads as cores)
+	    \param deliveredCallback optional callback, called by the calling thread with the entities delivered while the next file
+	           to be handed over is loaded in the background (see FileIOFilter::DeliverEntity). The callback of this file then
+	           only receives the remaining entities. If not set, all the entities are passed to the FileLoadedCallback.
+	    \return CC_FERR_CANCELED_BY_USER if the process has been canceled, CC_FERR_NO_ERROR otherwise (see the result of each file)
+	**/
+	QCC_IO_LIB_API static CC_FILE_ERROR LoadFromFiles(const QStringList&               filenames,
+	                                                  LoadParameters&                  parameters,
+	                                                  const FileLoadedCallback&        callback,
+	                                                  const QString&                   fileFilter        = QString(),
+	                                                  int                              maxThreadCount    = 0,
+	                                                  const EntitiesDeliveredCallback& deliveredCallback = EntitiesDeliveredCallback());
+
+	//! Adds a loaded entity to the container, or delivers it right away in case of an asynchronous loading
+	/** To be called by the I/O filters once an entity is entirely loaded (the filter shouldn't access
+	    it anymore). The delivered entities are named the same way as by FileIOFilter::LoadFromFile,
+	    and the load-time filter (if any) is applied to them beforehand.
+	    \param entity loaded entity
+	    \param container container (the one passed to FileIOFilter::loadFile)
+	    \param parameters generic loading parameters
+	**/
+	QCC_IO_LIB_API static void DeliverEntity(ccHObject* entity, ccHObject& container, LoadParameters& parameters);
+
 	//! Saves an entity (or a group of) to a specific file thanks to a given filter
 	/** Shortcut to FileIOFilter::saveFile
 	    \param entities entity to save (can be a group of other entities)
@@ -316,6 +424,8 @@ class FileIOFilter
 		BuiltIn = 0x0004, //< Implemented in the core
 
 		DynamicInfo = 0x0008, //< FilterInfo cannot be set statically (this is used for internal consistency checking)
+
+		ConcurrentLoad = 0x0010, //< Several files can be loaded concurrently, in background threads (loadFile is reentrant and doesn't display anything without a parent widget)
 	};
 	Q_DECLARE_FLAGS(FilterFeatures, FilterFeature)
 
@@ -0,0 +1,271 @@
+#pragma once
+
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+// #                                                                        #
+// ##########################################################################
+
+// local
+#include "FileIOFilter.h"
+
+// CCCoreLib
+#include <GenericProgressCallback.h>
+
+// Qt
+#include <QAtomicInt>
+#include <QFuture>
+#include <QMutex>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QWaitCondition>
+
+// System
+#include <atomic>
+#include <deque>
+#include <vector>
+
+class ccGlobalShiftResolver;
+
+//! Asynchronous file loading task (see FileIOFilter::LoadFromFileAsync)
+/** The file is loaded in a background thread. The task reports the loading progress,
+    can be canceled, and delivers the loaded entities incrementally: the I/O filters
+    that support it deliver each entity as soon as it is entirely loaded (see
+    FileIOFilter::DeliverEntity), and the remaining ones are available at the end,
+    as a single group (the same as the one returned by FileIOFilter::LoadFromFile).
+
+    The signals are emitted by the loading thread (i.e. they are queued for the
+    receivers living in the main thread).
+
+    Implements the GenericProgressCallback interface so that the I/O filters can
+    report their progress and check whether the loading has been canceled.
+**/
+class QCC_IO_LIB_API ccFileLoadingTask : public QObject
+    , public CCCoreLib::GenericProgressCallback
+{
+	Q_OBJECT
+
+  public:
+	//! Shared type
+	using Shared = QSharedPointer<ccFileLoadingTask>;
+
+	//! Destructor
+	/** Cancels the loading (if it's still running) and waits for its end.
+	    The entities that have not been taken yet are deleted.
+	**/
+	~ccFileLoadingTask() override;
+
+	//! Returns the loaded file name
+	inline const QString& filename() const { return m_filename; }
+
+	//! Requests the cancellation of the loading
+	/** The already delivered entities remain valid.
+	**/
+	void cancel();
+
+	//! Returns whether the loading has been canceled
+	inline bool isCanceled() const { return m_cancelRequested; }
+
+	//! Returns the Global Shift resolver shared with other tasks (if any)
+	inline ccGlobalShiftResolver* globalShiftResolver() const { return m_globalShiftResolver; }
+
+	//! Returns whether the loading is finished
+	inline bool isFinished() const { return m_finished; }
+
+	//! Waits for the end of the loading
+	void waitForFinished();
+
+	//! Returns the current progress (percent)
+	inline int progress() const { return m_progress.loadAcquire(); }
+
+	//! Returns the loading result (once finished)
+	inline CC_FILE_ERROR result() const { return m_result; }
+
+	//! Returns the global shift applied to the loaded entities, if any (once finished)
+	/** \param[out] shift global shift
+	    \return whether a global shift has been applied (and should be applied to the next files, if any)
+	**/
+	bool getCoordinatesShift(CCVector3d& shift) const;
+
+	//! Takes the entities delivered so far (thread-safe)
+	/** The caller takes their ownership.
+	    \warning The remaining entities are not included (see takeContainer).
+	**/
+	std::vector<ccHObject*> takeEntities();
+
+	//! Takes the remaining entities, as a single group (once finished)
+	/** The caller takes its ownership.
+	    \return the group of the entities that have not been delivered during the loading (if any)
+	**/
+	ccHObject* takeContainer();
+
+	//! Delivers an entity (called by the loading thread, see FileIOFilter::DeliverEntity)
+	void deliver(ccHObject* entity);
+
+	// inherited from GenericProgressCallback
+	void update(float percent) override;
+	void setMethodTitle(const char* methodTitle) override;
+	void setInfo(const char* infoStr) override;
+	void start() override;
+	void stop() override;
+	bool isCancelRequested() override;
+	bool textCanBeEdited() const override
+	{
+		return false;
+	}
+
+  Q_SIGNALS:
+
+	//! Emitted when the progress value changes
+	void progressChanged(int percent);
+
+	//! Emitted when new entities have been delivered (see takeEntities)
+	void entitiesReady();
+
+	//! Emitted once the loading is finished
+	void finished();
+
+  protected:
+	friend class FileIOFilter;
+
+	//! Constructor (see FileIOFilter::LoadFromFileAsync)
+	explicit ccFileLoadingTask(const QString& filename);
+
+	//! Starts the loading
+	/** The dialogs are disabled (see FileIOFilter::LoadFromFileAsync).
+	    \param filter I/O filter
+	    \param parameters loading parameters
+	    \param globalShiftResolver optional Global Shift resolver (in which case the Global Shift is
+	           handled by its owner thread, with the input mode, see FileIOFilter::LoadFromFiles)
+	**/
+	void launch(FileIOFilter::Shared filter, const FileIOFilter::LoadParameters& parameters, ccGlobalShiftResolver* globalShiftResolver = nullptr);
+
+	//! Loads the file (loading thread)
+	void run(FileIOFilter::Shared filter);
+
+	//! Loaded file name
+	QString m_filename;
+	//! Loading parameters
+	FileIOFilter::LoadParameters m_parameters;
+	//! Global shift (loading parameters)
+	CCVector3d m_coordinatesShift;
+	//! Whether the global shift is enabled (loading parameters)
+	bool m_coordinatesShiftEnabled;
+	//! Whether the global shift is forced (loading parameters)
+	bool m_coordinatesShiftForced;
+	//! Global Shift resolver shared with other tasks (if any)
+	ccGlobalShiftResolver* m_globalShiftResolver;
+
+	//! Loading thread
+	QFuture<void> m_future;
+	//! Whether the cancellation has been requested
+	std::atomic<bool> m_cancelRequested;
+	//! Whether the loading is finished
+	std::atomic<bool> m_finished;
+	//! Current progress (percent)
+	QAtomicInt m_progress;
+	//! Loading result
+	CC_FILE_ERROR m_result;
+
+	//! Delivered entities (not taken yet)
+	std::vector<ccHObject*> m_entities;
+	//! Remaining entities (not taken yet)
+	ccHObject* m_container;
+	//! Mutex (to protect the delivered entities)
+	QMutex m_entitiesMutex;
+};
+
+//! Global Shift shared by several loading tasks (see FileIOFilter::LoadFromFiles)
+/** The loading threads can't display the Global Shift dialog. When a file needs a Global Shift
+    that can't be deduced from the previous answers, its loading thread waits for the thread owning
+    this object to handle it (see processRequests), with the dialog if necessary. The first accepted
+    Global Shift is then used for all the files, and if the user refuses to apply a Global Shift,
+    no Global Shift is applied to the next files.
+**/
+class QCC_IO_LIB_API ccGlobalShiftResolver
+{
+  public:
+	//! Default constructor
+	/** \param parameters loading parameters of the owner thread (they must stay valid as long as this object
+	           is used, and their Global Shift information is updated)
+	**/
+	explicit ccGlobalShiftResolver(FileIOFilter::LoadParameters& parameters);
+
+	//! Handles the Global Shift of an entity (loading thread)
+	/** Same as FileIOFilter::HandleGlobalShift, but waits for the owner thread if the Global Shift
+	    can't be deduced from the previous answers.
+	    \param P first point (or any representative point) of the entity
+	    \param[in,out] Pshift Global Shift (the input one may be used if useInputCoordinatesShiftIfPossible is true)
+	    \param[out] preserveCoordinateShift whether the Global Shift should be preserved when saving the entity
+	    \param loadParameters loading parameters of the loading thread
+	    \param useInputCoordinatesShiftIfPossible whether to use the input 'PShift' vector if possible
+	    \return whether a Global Shift should be applied
+	**/
+	bool handle(const CCVector3d&             P,
+	            CCVector3d&                   Pshift,
+	            bool&                         preserveCoordinateShift,
+	            FileIOFilter::LoadParameters& loadParameters,
+	            bool                          useInputCoordinatesShiftIfPossible);
+
+	//! Processes the pending requests, if any (owner thread)
+	/** The Global Shift dialog may be displayed.
+	**/
+	void processRequests();
+
+	//! Updates the shared Global Shift after a file has been loaded by the owner thread
+	/** \param entities loaded entities (if any)
+	**/
+	void update(ccHObject* entities);
+
+  protected:
+	//! Global Shift request (see handle)
+	struct Request
+	{
+		CCVector3d                 P;
+		CCVector3d                 shift;
+		bool                       useInputShift = false;
+		ccGlobalShiftManager::Mode mode          = ccGlobalShiftManager::DIALOG_IF_NECESSARY;
+		bool                       preserveShift = true;
+		bool                       result        = false;
+		bool                       processed     = false;
+	};
+
+	//! Tries to answer a request with the previous answers (the mutex must be locked)
+	bool answer(Request& request) const;
+
+	//! Updates the shared state from the owner loading parameters (the mutex must be locked)
+	void synchronize();
+
+	//! Loading parameters of the owner thread
+	FileIOFilter::LoadParameters& m_parameters;
+
+	//! Whether a Global Shift has been accepted (shared state)
+	bool m_shiftEnabled;
+	//! Accepted Global Shift (shared state)
+	CCVector3d m_shift;
+	//! Whether the accepted Global Shift must be applied to all the files (shared state)
+	bool m_shiftForced;
+	//! Whether the accepted Global Shift should be preserved when saving the entities (shared state)
+	bool m_preserveShift;
+	//! Whether the user has refused to apply a Global Shift (shared state)
+	bool m_shiftRefused;
+
+	//! Pending requests
+	std::deque<Request*> m_requests;
+	//! Mutex (to protect the shared state and the requests)
+	QMutex m_mutex;
+	//! Signaled once requests have been processed
+	QWaitCondition m_requestsProcessed;
+};
@@ -120,7 +120,9 @@ class QCC_IO_LIB_API ccGlobalShiftManager
 	};
 
 	//! Returns the default and last input shift/scale entries
-	const static std::vector<ShiftInfo>& GetLast();
+	/** Returns a copy, as the entries may be updated by another thread (see StoreShift).
+	**/
+	static std::vector<ShiftInfo> GetLast();
 
 	//! Tries to load ShiftInfo data from a (text) file
 	/** \param[in]  filename filename
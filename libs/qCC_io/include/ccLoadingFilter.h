@@ -0,0 +1,132 @@
+#pragma once
+
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+// #                                                                        #
+// ##########################################################################
+
+// local
+#include "qCC_io.h"
+
+// CCCoreLib
+#include <CCGeom.h>
+
+// Qt
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+
+// System
+#include <memory>
+#include <unordered_map>
+
+class ccHObject;
+class ccPointCloud;
+
+//! Load-time point filter (random or spatial subsampling, cropping, scalar field range)
+/** The points are filtered while they are decoded, so that huge files can be (partially)
+    loaded without ever holding all their points in memory.
+
+    The I/O filters that decode points progressively should call 'filter' regularly (e.g.
+    every 'BatchSize' points) on the newly decoded points. The clouds that have not been
+    filtered this way are filtered once loaded (see 'finalize', called by FileIOFilter::LoadFromFile).
+
+    The filter results don't depend on the batch size (i.e. the same points are kept whether
+    the cloud is filtered on the fly or after loading).
+**/
+class QCC_IO_LIB_API ccLoadingFilter
+{
+  public:
+	//! Filtering parameters
+	struct Parameters
+	{
+		//! Ratio of points to keep (random subsampling, between 0 and 1)
+		double randomRatio = 1.0;
+		//! Minimum distance between two kept points (spatial subsampling, or 0 to disable it)
+		/** Expressed in the file coordinate system (i.e. before any global shift/scale).
+		**/
+		double minSpacing = 0.0;
+		//! Whether to crop the points with a box
+		bool useBox = false;
+		//! Box min corner (in the file coordinate system)
+		CCVector3d boxMin;
+		//! Box max corner (in the file coordinate system)
+		CCVector3d boxMax;
+		//! Name of the scalar field used to filter the points by value (or empty to disable it)
+		QString sfName;
+		//! Min scalar field value
+		double sfMin = 0.0;
+		//! Max scalar field value
+		double sfMax = 0.0;
+		//! Random seed (random subsampling)
+		unsigned seed = 0;
+	};
+
+	//! Shared type
+	using Shared = QSharedPointer<ccLoadingFilter>;
+
+	//! Recommended number of points to decode between two calls to 'filter'
+	static constexpr unsigned BatchSize = (1 << 20);
+
+	//! Default constructor
+	explicit ccLoadingFilter(const Parameters& parameters);
+
+	//! Destructor
+	~ccLoadingFilter();
+
+	//! Returns the filtering parameters
+	inline const Parameters& parameters() const { return m_parameters; }
+
+	//! Returns whether the filter may reject points
+	bool isActive() const;
+
+	//! Filters the last points of a cloud (in place)
+	/** The points (and their colors, normals, scalar fields, waveforms) that pass the filter are
+	    moved at the beginning of the [firstIndex, size[ range, and the cloud is then shrunk.
+	    The scalar fields min and max values are not updated. The global shift/scale of the
+	    cloud must be set before this method is called the first time.
+
+	    Thread-safe as long as a given cloud is only filtered by a single thread at a time.
+
+	    \param cloud cloud
+	    \param firstIndex index of the first point to filter (i.e. the first point decoded since the previous call)
+	    \return the number of points kept
+	**/
+	unsigned filter(ccPointCloud* cloud, unsigned firstIndex);
+
+	//! Filters the clouds of an entity hierarchy that have not been filtered yet, and releases the filtering states
+	/** Mesh and polyline vertices, as well as clouds with labels, are never filtered.
+	    \param root entity hierarchy
+	    \param releaseAllStates whether to release the states of all the clouds, or only the ones of the hierarchy
+	        (e.g. when the other clouds are still being filtered on the fly)
+	**/
+	void finalize(ccHObject* root, bool releaseAllStates = true);
+
+  protected:
+	//! Per-cloud filtering state
+	struct CloudState;
+
+	//! Returns the filtering state of a given cloud (thread-safe)
+	CloudState& getState(ccPointCloud* cloud);
+
+	//! Filtering parameters
+	Parameters m_parameters;
+
+	//! Filtering states (per cloud unique ID)
+	std::unordered_map<unsigned, std::unique_ptr<CloudState>> m_states;
+
+	//! Mutex (to protect the states map)
+	QMutex m_statesMutex;
+};
@@ -10,6 +10,7 @@
  *
  * Modifications:
  *	- DGM (25/01/06) - get_plystorage_mode method added
+ *	- get_plydata_offset method added
  *
  * ---------------------------------------------------------------------- */
 
@@ -383,6 +384,16 @@ p_ply ply_create(const char* name,
 	 * ---------------------------------------------------------------------- */
 	int get_plystorage_mode(p_ply ply, e_ply_storage_mode* storage_mode);
 
+	/* ----------------------------------------------------------------------
+	 * Returns the offset of the data section (i.e. right after the header)
+	 * Must be called after ply_read_header and before ply_read
+	 *
+	 * ply: handle returned by ply_open
+	 *
+	 * Returns 1 if successful, 0 otherwise
+	 * ---------------------------------------------------------------------- */
+	int get_plydata_offset(p_ply ply, long* offset);
+
 #ifdef __cplusplus
 }
 #endif
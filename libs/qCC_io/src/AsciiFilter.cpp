@@ -819,9 +819,26 @@ CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream&
 	unsigned cloudChunkPos  = 0;
 	unsigned chunkRank      = 1;
 
+	// load-time filter (applied on the fly, unless labels refer to the points)
+	ccLoadingFilter* loadingFilter = nullptr;
+	if (parameters.loadingFilter && parameters.loadingFilter->isActive())
+	{
+		bool hasLabels = false;
+		for (const AsciiOpenDlg::SequenceItem& item : openSequence)
+		{
+			hasLabels |= (item.type == ASCII_OPEN_DLG_Label);
+		}
+		if (!hasLabels || s_doNotCreateLabels)
+		{
+			loadingFilter = parameters.loadingFilter.data();
+		}
+	}
+	// the points are filtered by batches (no need to reserve memory for all of them)
+	const unsigned cloudReservedSize = (loadingFilter ? ccLoadingFilter::BatchSize : maxCloudSize);
+
 	// we initialize the loading accelerator structure and point cloud
 	int                       maxPartIndex = -1;
-	cloudAttributesDescriptor cloudDesc    = prepareCloud(openSequence, cloudChunkSize, maxPartIndex, chunkRank);
+	cloudAttributesDescriptor cloudDesc    = prepareCloud(openSequence, std::min(cloudChunkSize, cloudReservedSize), maxPartIndex, chunkRank);
 
 	if (!cloudDesc.cloud)
 	{
@@ -868,6 +885,7 @@ CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream&
 	// other useful variables
 	unsigned linesRead  = 0;
 	unsigned pointsRead = 0;
+	unsigned filterPos  = 0; // index of the first point of the current cloud not filtered yet
 
 	CC_FILE_ERROR result = CC_FERR_NO_ERROR;
 
@@ -918,7 +936,7 @@ CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream&
 				ccLog::PrintDebug("[ASCII] We choose to enlarge existing clouds");
 
 				cloudChunkSize = std::min(maxCloudSize, approximateNumberOfLines - cloudChunkPos);
-				if (!cloudDesc.cloud->reserve(cloudChunkSize))
+				if (!loadingFilter && !cloudDesc.cloud->reserve(cloudChunkSize))
 				{
 					ccLog::Error("Not enough memory! Process stopped ...");
 					result = CC_FERR_NOT_ENOUGH_MEMORY;
@@ -930,7 +948,13 @@ CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream&
 				ccLog::PrintDebug("[ASCII] We choose to instantiate new clouds");
 
 				// we store (and resize) actual cloud
-				if (!cloudDesc.cloud->resize(cloudChunkSize))
+				if (loadingFilter)
+				{
+					loadingFilter->filter(cloudDesc.cloud, filterPos);
+					filterPos = 0;
+					cloudDesc.cloud->shrinkToFit();
+				}
+				else if (!cloudDesc.cloud->resize(cloudChunkSize))
 					ccLog::Warning("Memory reallocation failed ... some memory may have been wasted ...");
 				if (!cloudDesc.scalarFields.empty())
 				{
@@ -946,7 +970,7 @@ CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream&
 				// and create new one
 				cloudChunkPos  = pointsRead;
 				cloudChunkSize = std::min(maxCloudSize, approximateNumberOfLines - cloudChunkPos);
-				cloudDesc      = prepareCloud(openSequence, cloudChunkSize, maxPartIndex, ++chunkRank);
+				cloudDesc      = prepareCloud(openSequence, std::min(cloudChunkSize, cloudReservedSize), maxPartIndex, ++chunkRank);
 				if (!cloudDesc.cloud)
 				{
 					ccLog::Error("Not enough memory! Process stopped ...");
@@ -1138,6 +1162,12 @@ CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream&
 			}
 
 			++pointsRead;
+
+			if (loadingFilter && cloudDesc.cloud->size() - filterPos >= ccLoadingFilter::BatchSize)
+			{
+				loadingFilter->filter(cloudDesc.cloud, filterPos);
+				filterPos = cloudDesc.cloud->size();
+			}
 		}
 		else
 		{
@@ -1154,6 +1184,11 @@ CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream&
 
 	if (cloudDesc.cloud)
 	{
+		if (loadingFilter)
+		{
+			loadingFilter->filter(cloudDesc.cloud, filterPos);
+		}
+
 		if (cloudDesc.cloud->size() < cloudDesc.cloud->capacity())
 		{
 			cloudDesc.cloud->resize(cloudDesc.cloud->size());
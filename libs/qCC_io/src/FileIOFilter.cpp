@@ -17,6 +17,8 @@
 
 #include "FileIOFilter.h"
 
+#include "ccFileLoadingTask.h"
+
 // CLOUDS
 #include "AsciiFilter.h"
 #include "BinFilter.h"
@@ -31,8 +33,14 @@
 #include "RasterGridFilter.h"
 #include "ShpFilter.h"
 
+// qCC_db
+#include <ccProgressDialog.h>
+
 // Qt
+#include <QApplication>
 #include <QFileInfo>
+#include <QScopedPointer>
+#include <QThread>
 
 #ifdef USE_VLD
 // VLD
@@ -40,6 +48,8 @@
 #endif
 
 // system
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <vector>
 
@@ -49,7 +59,27 @@
 **/
 static FileIOFilter::FilterContainer s_ioFilters;
 
-static unsigned s_sessionCounter = 0; //!< Session counter
+static std::atomic<unsigned> s_sessionCounter(0); //!< Session counter (files may be loaded concurrently)
+
+static constexpr qint64 s_maxConcurrentLoadingSize = (qint64(1) << 32); //!< Max amount of data (estimated decoded size) loaded concurrently (4 GB)
+
+//! Returns the estimated amount of memory required to load a file
+/** The data of compressed formats is much bigger once decoded than on disk.
+**/
+static qint64 EstimatedLoadingSize(const QString& filename, qint64 fileSize)
+{
+	const QString extension = QFileInfo(filename).suffix().toUpper();
+	if (extension == "LAZ" || extension == "DRC")
+	{
+		return 10 * fileSize;
+	}
+	else if (extension == "E57")
+	{
+		return 4 * fileSize;
+	}
+
+	return fileSize;
+}
 
 // This extra definition is required in C++11.
 // In C++17, class-level "static constexpr" is implicitly inline, so these are not required.
@@ -87,6 +117,11 @@ bool FileIOFilter::exportSupported() const
 	return m_filterInfo.features & Export;
 }
 
+bool FileIOFilter::concurrentLoadSupported() const
+{
+	return m_filterInfo.features & ConcurrentLoad;
+}
+
 const QStringList& FileIOFilter::getFileFilters(bool onImport) const
 {
 	if (onImport)
@@ -293,6 +328,65 @@ QStringList FileIOFilter::ImportFilterList()
 	return list;
 }
 
+//! Updates the name of a loaded entity
+static void UpdateLoadedEntityName(ccHObject* entity, const QFileInfo& fi)
+{
+	QString newName = entity->getName();
+	if (newName.startsWith("unnamed"))
+	{
+		// we automatically replace occurrences of 'unnamed' in entities names by the base filename (no path, no extension)
+		newName.replace(QString("unnamed"), fi.completeBaseName());
+		entity->setName(newName);
+	}
+	else if (newName.isEmpty())
+	{
+		// just in case
+		entity->setName(fi.baseName());
+	}
+}
+
+//! Returns the I/O filter to load a given file
+static FileIOFilter::Shared GetFilterForFile(const QString& filename, const QString& fileFilter, CC_FILE_ERROR& result)
+{
+	FileIOFilter::Shared filter;
+
+	// if the right filter is specified by the caller
+	if (!fileFilter.isEmpty())
+	{
+		filter = FileIOFilter::GetFilter(fileFilter, true);
+		if (!filter)
+		{
+			ccLog::Error(QString("[Load] Internal error: no I/O filter corresponds to filter '%1'").arg(fileFilter));
+			result = CC_FERR_CONSOLE_ERROR;
+			return {};
+		}
+	}
+	else // we need to guess the I/O filter based on the file format
+	{
+		// look for file extension (we trust Qt on this task)
+		QString extension = QFileInfo(filename).suffix();
+		if (extension.isEmpty())
+		{
+			ccLog::Error("[Load] Can't guess file format: no file extension");
+			result = CC_FERR_CONSOLE_ERROR;
+			return {};
+		}
+
+		// convert extension to file format
+		filter = FileIOFilter::FindBestFilterForExtension(extension);
+
+		// unknown extension?
+		if (!filter)
+		{
+			ccLog::Error(QString("[Load] Can't guess file format: unhandled file extension '%1'").arg(extension));
+			result = CC_FERR_CONSOLE_ERROR;
+			return {};
+		}
+	}
+
+	return filter;
+}
+
 ccHObject* FileIOFilter::LoadFromFile(const QString&  filename,
                                       LoadParameters& loadParameters,
                                       Shared          filter,
@@ -349,6 +443,13 @@ ccHObject* FileIOFilter::LoadFromFile(const QString&  filename,
 		result = CC_FERR_CONSOLE_ERROR;
 	}
 
+	if (loadParameters.loadingFilter && loadParameters.loadingFilter->isActive())
+	{
+		// filter the clouds that haven't been filtered on the fly
+		// (in case of an asynchronous loading, other files may still be filtered with the same filter)
+		loadParameters.loadingFilter->finalize(container, loadParameters.loadingTask == nullptr);
+	}
+
 	if (result == CC_FERR_NO_ERROR)
 	{
 		ccLog::Print(QString("[I/O] File '%1' loaded successfully").arg(filename));
@@ -365,19 +466,7 @@ ccHObject* FileIOFilter::LoadFromFile(const QString&  filename,
 		container->setName(QString("%1 (%2)").arg(fi.fileName(), fi.absolutePath()));
 		for (unsigned i = 0; i < childCount; ++i)
 		{
-			ccHObject* child   = container->getChild(i);
-			QString    newName = child->getName();
-			if (newName.startsWith("unnamed"))
-			{
-				// we automatically replace occurrences of 'unnamed' in entities names by the base filename (no path, no extension)
-				newName.replace(QString("unnamed"), fi.completeBaseName());
-				child->setName(newName);
-			}
-			else if (newName.isEmpty())
-			{
-				// just in case
-				child->setName(fi.baseName());
-			}
+			UpdateLoadedEntityName(container->getChild(i), fi);
 		}
 	}
 	else
@@ -394,46 +483,340 @@ ccHObject* FileIOFilter::LoadFromFile(const QString&  inputFilename,
                                       CC_FILE_ERROR&  result,
                                       const QString&  fileFilter)
 {
-	Shared filter;
+	// special case for symbolic link, shortcut or alias files
+	QString filename = GetRealFilename(inputFilename);
+
+	Shared filter = GetFilterForFile(filename, fileFilter, result);
+	if (!filter)
+	{
+		return nullptr;
+	}
+
+	return LoadFromFile(filename, loadParameters, filter, result);
+}
 
+QSharedPointer<ccFileLoadingTask> FileIOFilter::LoadFromFileAsync(const QString&        inputFilename,
+                                                                  const LoadParameters& parameters,
+                                                                  CC_FILE_ERROR&        result,
+                                                                  const QString&        fileFilter)
+{
 	// special case for symbolic link, shortcut or alias files
 	QString filename = GetRealFilename(inputFilename);
 
-	// if the right filter is specified by the caller
-	if (!fileFilter.isEmpty())
+	result        = CC_FERR_NO_ERROR;
+	Shared filter = GetFilterForFile(filename, fileFilter, result);
+	if (!filter)
 	{
-		filter = GetFilter(fileFilter, true);
-		if (!filter)
+		return {};
+	}
+
+	if (!filter->concurrentLoadSupported())
+	{
+		// the filter may display dialogs or rely on a static state
+		ccLog::Warning(QString("[I/O] Filter '%1' can't load files in a background thread").arg(filter->m_filterInfo.id));
+		result = CC_FERR_NOT_IMPLEMENTED;
+		return {};
+	}
+
+	ccFileLoadingTask::Shared task(new ccFileLoadingTask(filename));
+	task->launch(filter, parameters);
+
+	return task;
+}
+
+CC_FILE_ERROR FileIOFilter::LoadFromFiles(const QStringList&               filenames,
+                                          LoadParameters&                  parameters,
+                                          const FileLoadedCallback&        callback,
+                                          const QString&                   fileFilter /*=QString()*/,
+                                          int                              maxThreadCount /*=0*/,
+                                          const EntitiesDeliveredCallback& deliveredCallback /*=EntitiesDeliveredCallback()*/)
+{
+	if (filenames.empty())
+	{
+		return CC_FERR_NO_ERROR;
+	}
+
+	//! File to load
+	struct FileToLoad
+	{
+		QString                   filename;
+		Shared                    filter;
+		qint64                    size     = 0;     //!< estimated loading size
+		bool                      budgeted = false; //!< whether the size counts in the concurrent loading budget
+		ccFileLoadingTask::Shared task;
+		std::vector<ccHObject*>   delivered;
+		ccHObject*                entities = nullptr;
+		CC_FILE_ERROR             result   = CC_FERR_NO_ERROR;
+		bool                      loaded   = false;
+	};
+
+	std::vector<FileToLoad> files;
+	try
+	{
+		files.resize(static_cast<size_t>(filenames.size()));
+	}
+	catch (const std::bad_alloc&)
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		FileToLoad& file = files[i];
+		// special case for symbolic link, shortcut or alias files
+		file.filename = GetRealFilename(filenames[static_cast<int>(i)]);
+		file.filter   = GetFilterForFile(file.filename, fileFilter, file.result);
+		file.size     = EstimatedLoadingSize(file.filename, QFileInfo(file.filename).size());
+	}
+
+	// the global shift is shared by all the files (even if the caller doesn't retrieve it)
+	CCVector3d     coordinatesShift(0, 0, 0);
+	bool           coordinatesShiftEnabled = false;
+	bool           coordinatesShiftForced  = false;
+	LoadParameters batchParameters         = parameters;
+	if (!batchParameters._coordinatesShift)
+	{
+		batchParameters._coordinatesShift = &coordinatesShift;
+	}
+	if (!batchParameters._coordinatesShiftEnabled)
+	{
+		batchParameters._coordinatesShiftEnabled = &coordinatesShiftEnabled;
+	}
+	if (!batchParameters._coordinatesShiftForced)
+	{
+		batchParameters._coordinatesShiftForced = &coordinatesShiftForced;
+	}
+
+	// the Global Shift of the files loaded in the background is handled by the calling thread
+	// (so that the dialog is displayed once, and the user's answer is used for the whole batch)
+	ccGlobalShiftResolver globalShiftResolver(batchParameters);
+
+	// loads a file in the calling thread
+	auto loadFile = [&](FileToLoad& file)
+	{
+		if (file.filter)
 		{
-			ccLog::Error(QString("[Load] Internal error: no I/O filter corresponds to filter '%1'").arg(fileFilter));
-			result = CC_FERR_CONSOLE_ERROR;
-			return nullptr;
+			file.entities = LoadFromFile(file.filename, batchParameters, file.filter, file.result);
 		}
+		file.loaded = true;
+
+		globalShiftResolver.update(file.entities);
+	};
+
+	// retrieves the entities loaded by a background thread
+	auto collectFile = [](FileToLoad& file)
+	{
+		file.delivered = file.task->takeEntities();
+		file.entities  = file.task->takeContainer();
+		file.result    = file.task->result();
+		file.task.clear();
+		file.loaded = true;
+	};
+
+	if (maxThreadCount <= 0)
+	{
+		maxThreadCount = std::max(1, QThread::idealThreadCount());
 	}
-	else // we need to guess the I/O filter based on the file format
+
+	// global progress bar (also for a single file loaded in the background, as it can't display its own)
+	QScopedPointer<ccProgressDialog> progressDlg(nullptr);
+	if (parameters.parentWidget && (files.size() > 1 || (files.front().filter && files.front().filter->concurrentLoadSupported())))
 	{
-		// look for file extension (we trust Qt on this task)
-		QString extension = QFileInfo(filename).suffix();
-		if (extension.isEmpty())
+		progressDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
+		progressDlg->setAutoClose(false);
+		progressDlg->setMethodTitle(QObject::tr("Load files"));
+		progressDlg->setInfo(QObject::tr("Files: %1/%2").arg(0).arg(files.size()));
+		progressDlg->start();
+		QApplication::processEvents();
+	}
+
+	bool   canceled      = false;
+	size_t nextToLaunch  = 0;
+	size_t nextToDeliver = 0;
+	size_t loadedCount   = 0;
+	int    runningCount  = 0;
+	qint64 runningSize   = 0;
+
+	while (nextToDeliver < files.size())
+	{
+		// launch the next files (in the input order)
+		while (!canceled && nextToLaunch < files.size())
 		{
-			ccLog::Error("[Load] Can't guess file format: no file extension");
-			result = CC_FERR_CONSOLE_ERROR;
-			return nullptr;
+			FileToLoad& file = files[nextToLaunch];
+			if (file.filter && file.filter->concurrentLoadSupported())
+			{
+				// limit the number of threads and the amount of data held at the same time (until the files are
+				// delivered, as the callback takes ownership of the entities). A file bigger than the budget is loaded alone.
+				if (runningCount >= maxThreadCount || (runningSize != 0 && runningSize + file.size > s_maxConcurrentLoadingSize))
+				{
+					break;
+				}
+
+				// the loading dialog (if any) is displayed by the calling thread
+				batchParameters.sessionStart = (nextToLaunch == 0 && s_sessionCounter == 0);
+				if (file.filter->prepareConcurrentLoad(file.filename, batchParameters, file.result))
+				{
+					file.task.reset(new ccFileLoadingTask(file.filename));
+					file.task->launch(file.filter, batchParameters, &globalShiftResolver);
+					++runningCount;
+					runningSize += file.size;
+					file.budgeted = true;
+				}
+				else
+				{
+					// the file has been processed by the filter (or the user canceled it)
+					DisplayErrorMessage(file.result, "loading", QFileInfo(file.filename).baseName());
+					file.loaded = true;
+					canceled |= (file.result == CC_FERR_CANCELED_BY_USER);
+					++loadedCount;
+				}
+			}
+			else
+			{
+				// this file can't be loaded in a background thread
+				loadFile(file);
+				canceled |= (file.result == CC_FERR_CANCELED_BY_USER);
+				++loadedCount;
+			}
+			++nextToLaunch;
 		}
 
-		// convert extension to file format
-		filter = FindBestFilterForExtension(extension);
+		// the loading threads may be waiting for the Global Shift
+		globalShiftResolver.processRequests();
 
-		// unknown extension?
-		if (!filter)
+		// retrieve the files loaded in the background
+		for (size_t i = nextToDeliver; i < nextToLaunch; ++i)
 		{
-			ccLog::Error(QString("[Load] Can't guess file format: unhandled file extension '%1'").arg(extension));
-			result = CC_FERR_CONSOLE_ERROR;
-			return nullptr;
+			FileToLoad& file = files[i];
+			if (file.task && file.task->isFinished())
+			{
+				collectFile(file);
+				--runningCount;
+				++loadedCount;
+			}
+		}
+
+		// hand over the entities delivered so far by the next file (if it's still being loaded in the background)
+		if (deliveredCallback && nextToDeliver < nextToLaunch && files[nextToDeliver].task)
+		{
+			std::vector<ccHObject*> entities = files[nextToDeliver].task->takeEntities();
+			if (!entities.empty())
+			{
+				deliveredCallback(filenames[static_cast<int>(nextToDeliver)], entities);
+			}
+		}
+
+		// deliver the loaded files (in the input order)
+		while (nextToDeliver < nextToLaunch && files[nextToDeliver].loaded)
+		{
+			FileToLoad& file = files[nextToDeliver];
+			if (!file.delivered.empty())
+			{
+				// some entities have been delivered before the end of the loading
+				if (deliveredCallback)
+				{
+					deliveredCallback(filenames[static_cast<int>(nextToDeliver)], file.delivered);
+				}
+				else
+				{
+					// they are gathered with the remaining ones (first, in the delivery order)
+					if (!file.entities)
+					{
+						QFileInfo fi(file.filename);
+						file.entities = new ccHObject(QString("%1 (%2)").arg(fi.fileName(), fi.absolutePath()));
+					}
+					for (size_t j = 0; j < file.delivered.size(); ++j)
+					{
+						file.entities->addChild(file.delivered[j], ccHObject::DP_PARENT_OF_OTHER, static_cast<int>(j));
+					}
+				}
+				file.delivered.clear();
+			}
+			callback(filenames[static_cast<int>(nextToDeliver)], file.entities, file.result);
+			file.entities = nullptr;
+			if (file.budgeted)
+			{
+				// the loaded data is now held by the caller
+				runningSize -= file.size;
+				file.budgeted = false;
+			}
+			++nextToDeliver;
+		}
+
+		if (canceled && nextToDeliver == nextToLaunch)
+		{
+			// the files that have been started are all delivered
+			break;
+		}
+
+		if (runningCount != 0)
+		{
+			QThread::msleep(50);
+		}
+
+		if (progressDlg)
+		{
+			if (!canceled && progressDlg->isCancelRequested())
+			{
+				canceled = true;
+				for (size_t i = nextToDeliver; i < nextToLaunch; ++i)
+				{
+					if (files[i].task)
+					{
+						files[i].task->cancel();
+					}
+				}
+			}
+
+			// the files being loaded in the background count for their current progress
+			float progress = 100.0f * loadedCount;
+			for (size_t i = nextToDeliver; i < nextToLaunch; ++i)
+			{
+				if (files[i].task)
+				{
+					progress += files[i].task->progress();
+				}
+			}
+			progressDlg->update(progress / files.size());
+			progressDlg->setInfo(QObject::tr("Files: %1/%2").arg(loadedCount).arg(files.size()));
+			QApplication::processEvents();
 		}
 	}
 
-	return LoadFromFile(filename, loadParameters, filter, result);
+	if (progressDlg)
+	{
+		progressDlg->stop();
+		QApplication::processEvents();
+	}
+
+	parameters.preserveShiftOnSave = batchParameters.preserveShiftOnSave;
+
+	return canceled ? CC_FERR_CANCELED_BY_USER : CC_FERR_NO_ERROR;
+}
+
+void FileIOFilter::DeliverEntity(ccHObject* entity, ccHObject& container, LoadParameters& parameters)
+{
+	if (!entity)
+	{
+		assert(false);
+		return;
+	}
+
+	if (!parameters.loadingTask)
+	{
+		container.addChild(entity);
+		return;
+	}
+
+	if (parameters.loadingFilter && parameters.loadingFilter->isActive())
+	{
+		// the other clouds may still be filtered on the fly
+		parameters.loadingFilter->finalize(entity, false);
+	}
+
+	UpdateLoadedEntityName(entity, QFileInfo(parameters.loadingTask->filename()));
+
+	parameters.loadingTask->deliver(entity);
 }
 
 CC_FILE_ERROR FileIOFilter::SaveToFile(ccHObject*            entities,
@@ -589,6 +972,12 @@ bool FileIOFilter::HandleGlobalShift(const CCVector3d& P,
                                      LoadParameters&   loadParameters,
                                      bool              useInputCoordinatesShiftIfPossible /*=false*/)
 {
+	if (loadParameters.loadingTask && loadParameters.loadingTask->globalShiftResolver())
+	{
+		// the Global Shift is shared by several files loaded concurrently (see LoadFromFiles)
+		return loadParameters.loadingTask->globalShiftResolver()->handle(P, Pshift, preserveCoordinateShift, loadParameters, useInputCoordinatesShiftIfPossible);
+	}
+
 	bool shiftAlreadyEnabled = ((nullptr != loadParameters._coordinatesShiftEnabled)
 	                            && (*loadParameters._coordinatesShiftEnabled)
 	                            && (nullptr != loadParameters._coordinatesShift));
@@ -23,10 +23,12 @@
 #include "PlyOpenDlg.h"
 
 // Qt
+#include <QFile>
 #include <QFileInfo>
 #include <QImage>
 #include <QMessageBox>
 #include <QPushButton>
+#include <QSysInfo>
 
 // qCC_db
 #include <ccHObjectCaster.h>
@@ -34,13 +36,16 @@
 #include <ccMaterial.h>
 #include <ccMaterialSet.h>
 #include <ccMesh.h>
+#include <ccNormalVectors.h>
 #include <ccPointCloud.h>
 #include <ccProgressDialog.h>
 #include <ccScalarField.h>
 
 // System
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <cstring>
 #if defined(CC_WINDOWS)
 #include <windows.h>
@@ -49,6 +54,11 @@
 #include <unistd.h>
 #endif
 
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
 using namespace CCCoreLib;
 
 static bool IsFloat(e_ply_type type)
@@ -930,6 +940,826 @@ static int texIndexes_cb(p_ply_argument argument)
 	return 1;
 }
 
+/******************************/
+/***  Binary 'bulk' decoding  ***/
+/******************************/
+
+//! Properties to be loaded by the binary 'bulk' decoder
+struct PlyBulkProperties
+{
+	//! Coordinates (X, Y, Z)
+	const plyProperty* coords[3]{nullptr, nullptr, nullptr};
+	//! Normals (Nx, Ny, Nz)
+	const plyProperty* normals[3]{nullptr, nullptr, nullptr};
+	//! Colors (R, G, B)
+	const plyProperty* colors[3]{nullptr, nullptr, nullptr};
+	//! Grey level (intensity)
+	const plyProperty* grey = nullptr;
+	//! Scalar fields
+	std::vector<std::pair<const plyProperty*, CCCoreLib::ScalarField*>> scalarFields;
+	//! Point-based elements
+	const std::vector<plyElement>* pointElements = nullptr;
+
+	//! Vertex indexes (faces)
+	const plyProperty* faces = nullptr;
+	//! Mesh-based elements
+	const std::vector<plyElement>* meshElements = nullptr;
+};
+
+//! Result of the binary 'bulk' decoding
+enum class PlyBulkResult
+{
+	NotApplicable, //!< the file can't be decoded this way (nothing was loaded)
+	Success,
+	NotEnoughMemory,
+	Malformed,
+	Canceled //!< the process has been canceled by the user
+};
+
+//! Returns the size (in bytes) of a binary PLY scalar type (0 for lists)
+static size_t PlyTypeSize(e_ply_type type)
+{
+	switch (type)
+	{
+	case PLY_INT8:
+	case PLY_UINT8:
+	case PLY_CHAR:
+	case PLY_UCHAR:
+		return 1;
+	case PLY_INT16:
+	case PLY_UINT16:
+	case PLY_SHORT:
+	case PLY_USHORT:
+		return 2;
+	case PLY_INT32:
+	case PLY_UIN32:
+	case PLY_INT:
+	case PLY_UINT:
+	case PLY_FLOAT32:
+	case PLY_FLOAT:
+		return 4;
+	case PLY_FLOAT64:
+	case PLY_DOUBLE:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+//! Decodes a binary PLY scalar value
+static inline double ReadPlyValue(const uchar* data, e_ply_type type, bool swapBytes)
+{
+	uchar  bytes[8];
+	size_t size = PlyTypeSize(type);
+	if (swapBytes)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			bytes[i] = data[size - 1 - i];
+		}
+	}
+	else
+	{
+		memcpy(bytes, data, size);
+	}
+
+	switch (type)
+	{
+	case PLY_INT8:
+	case PLY_CHAR:
+		return static_cast<int8_t>(bytes[0]);
+	case PLY_UINT8:
+	case PLY_UCHAR:
+		return bytes[0];
+	case PLY_INT16:
+	case PLY_SHORT:
+	{
+		int16_t value = 0;
+		memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+	case PLY_UINT16:
+	case PLY_USHORT:
+	{
+		uint16_t value = 0;
+		memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+	case PLY_INT32:
+	case PLY_INT:
+	{
+		int32_t value = 0;
+		memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+	case PLY_UIN32:
+	case PLY_UINT:
+	{
+		uint32_t value = 0;
+		memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+	case PLY_FLOAT32:
+	case PLY_FLOAT:
+	{
+		float value = 0;
+		memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+	case PLY_FLOAT64:
+	case PLY_DOUBLE:
+	{
+		double value = 0;
+		memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+	default:
+		assert(false);
+		return 0.0;
+	}
+}
+
+//! Converts a PLY color component
+static inline ColorCompType ToColorComponent(double value, bool isFloat)
+{
+	return isFloat ? static_cast<ColorCompType>(std::min(std::max(0.0, value), 1.0) * ccColor::MAX) : static_cast<ColorCompType>(value);
+}
+
+//! Binary PLY element (as stored in the file)
+struct PlyBinaryElement
+{
+	p_ply_element            elem      = nullptr;
+	long                     instances = 0;
+	std::vector<plyProperty> properties;
+
+	//! Returns the (fixed) record size, or 0 if the element has list properties
+	size_t fixedRecordSize() const
+	{
+		size_t recordSize = 0;
+		for (const plyProperty& prop : properties)
+		{
+			if (prop.type == PLY_LIST)
+			{
+				return 0;
+			}
+			recordSize += PlyTypeSize(prop.type);
+		}
+		return recordSize;
+	}
+
+	//! Returns the index of a given property (or -1 if not found)
+	int propertyIndex(const plyProperty* prop) const
+	{
+		for (size_t i = 0; i < properties.size(); ++i)
+		{
+			if (properties[i].prop == prop->prop)
+			{
+				return static_cast<int>(i);
+			}
+		}
+		return -1;
+	}
+};
+
+//! Skips one record of a binary PLY element (with list properties)
+/** \return the beginning of the next record (or nullptr if the data is truncated)
+**/
+static const uchar* SkipPlyRecord(const uchar* record, const uchar* end, const PlyBinaryElement& element, bool swapBytes)
+{
+	const uchar* p = record;
+	for (const plyProperty& prop : element.properties)
+	{
+		size_t size = 0;
+		if (prop.type == PLY_LIST)
+		{
+			size_t lengthSize = PlyTypeSize(prop.length_type);
+			if (lengthSize == 0 || static_cast<size_t>(end - p) < lengthSize)
+			{
+				return nullptr;
+			}
+			double length = ReadPlyValue(p, prop.length_type, swapBytes);
+			if (length < 0)
+			{
+				return nullptr;
+			}
+			p += lengthSize;
+			size = static_cast<size_t>(length) * PlyTypeSize(prop.value_type);
+		}
+		else
+		{
+			size = PlyTypeSize(prop.type);
+		}
+
+		if (static_cast<size_t>(end - p) < size)
+		{
+			return nullptr;
+		}
+		p += size;
+	}
+	return p;
+}
+
+//! Loads the vertices (and the triangles) of a binary PLY file by blocks
+/** The 'rply' callbacks are invoked for each single value, which makes the loading of
+    large binary files CPU-bound. Instead, if all the point properties belong to a single
+    element with fixed-size records, the records are decoded directly from the memory-mapped
+    file (in parallel). Faces are decoded in parallel as well if they all are triangles
+    (otherwise sequentially, but still without the callbacks).
+    The records are processed by blocks, and the progress callback is updated
+    (and the cancel state checked) after each block. If a loading filter is active
+    (and if there's no mesh), each block of points is filtered right after being decoded.
+    \warning The cloud points table (and the mesh triangles table) should be reserved but empty
+**/
+static PlyBulkResult LoadBinaryBlocks(const QString&                      filename,
+                                      p_ply                               ply,
+                                      e_ply_storage_mode                  storageMode,
+                                      const PlyBulkProperties&            bulk,
+                                      ccPointCloud*                       cloud,
+                                      ccMesh*                             mesh,
+                                      CCCoreLib::GenericProgressCallback* progressCb = nullptr)
+{
+	if ((storageMode != PLY_BIG_ENDIAN && storageMode != PLY_LITTLE_ENDIAN) || !cloud || !bulk.pointElements)
+	{
+		return PlyBulkResult::NotApplicable;
+	}
+	const bool swapBytes = ((storageMode == PLY_LITTLE_ENDIAN) != (QSysInfo::ByteOrder == QSysInfo::LittleEndian));
+
+	// all the point properties must belong to the same element
+	std::vector<const plyProperty*> pointProperties;
+	for (unsigned d = 0; d < 3; ++d)
+	{
+		pointProperties.push_back(bulk.coords[d]);
+		pointProperties.push_back(bulk.normals[d]);
+		pointProperties.push_back(bulk.colors[d]);
+	}
+	pointProperties.push_back(bulk.grey);
+	for (const auto& sfProp : bulk.scalarFields)
+	{
+		pointProperties.push_back(sfProp.first);
+	}
+
+	int vertexElemIndex = -1;
+	for (const plyProperty* pp : pointProperties)
+	{
+		if (!pp)
+		{
+			continue;
+		}
+		if (vertexElemIndex < 0)
+		{
+			vertexElemIndex = pp->elemIndex;
+		}
+		else if (vertexElemIndex != pp->elemIndex)
+		{
+			return PlyBulkResult::NotApplicable;
+		}
+	}
+	if (vertexElemIndex < 0)
+	{
+		return PlyBulkResult::NotApplicable;
+	}
+	p_ply_element vertexElem = bulk.pointElements->at(vertexElemIndex).elem;
+	p_ply_element faceElem   = (mesh && bulk.faces && bulk.meshElements ? bulk.meshElements->at(bulk.faces->elemIndex).elem : nullptr);
+
+	long dataOffset = 0;
+	if (!get_plydata_offset(ply, &dataOffset))
+	{
+		return PlyBulkResult::NotApplicable;
+	}
+
+	// elements layout (in the file order)
+	std::vector<PlyBinaryElement> elements;
+	int                           vertexIndex = -1;
+	int                           faceIndex   = -1;
+	try
+	{
+		p_ply_element elem = nullptr;
+		while ((elem = ply_get_next_element(ply, elem)))
+		{
+			PlyBinaryElement element;
+			element.elem = elem;
+			ply_get_element_info(elem, nullptr, &element.instances);
+
+			plyProperty prop;
+			prop.prop      = nullptr;
+			prop.elemIndex = static_cast<int>(elements.size());
+			while ((prop.prop = ply_get_next_property(elem, prop.prop)))
+			{
+				ply_get_property_info(prop.prop, &prop.propName, &prop.type, &prop.length_type, &prop.value_type);
+				element.properties.push_back(prop);
+			}
+
+			if (elem == vertexElem)
+			{
+				vertexIndex = static_cast<int>(elements.size());
+			}
+			if (elem == faceElem)
+			{
+				faceIndex = static_cast<int>(elements.size());
+			}
+			elements.push_back(element);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		return PlyBulkResult::NotApplicable;
+	}
+
+	if (vertexIndex < 0)
+	{
+		assert(false);
+		return PlyBulkResult::NotApplicable;
+	}
+	const PlyBinaryElement& vertexElement    = elements[vertexIndex];
+	const size_t            vertexRecordSize = vertexElement.fixedRecordSize();
+	if (vertexRecordSize == 0)
+	{
+		// variable size records
+		return PlyBulkResult::NotApplicable;
+	}
+
+	// map the file in memory
+	QFile file(filename);
+	if (!file.open(QFile::ReadOnly))
+	{
+		return PlyBulkResult::NotApplicable;
+	}
+	const qint64 fileSize = file.size();
+	const uchar* fileData = (dataOffset < fileSize ? file.map(0, fileSize) : nullptr);
+	if (!fileData)
+	{
+		ccLog::PrintDebug("[PLY] Failed to map the file in memory (standard loading)");
+		return PlyBulkResult::NotApplicable;
+	}
+	const uchar* fileEnd = fileData + fileSize;
+
+	// look for the beginning of the elements to load
+	const uchar* vertexData = nullptr;
+	const uchar* faceData   = nullptr;
+	{
+		const uchar* p         = fileData + dataOffset;
+		const int    lastIndex = std::max(vertexIndex, faceIndex);
+		for (int i = 0; i <= lastIndex; ++i)
+		{
+			if (i == vertexIndex)
+				vertexData = p;
+			if (i == faceIndex)
+				faceData = p;
+			if (i == lastIndex)
+				break;
+
+			// skip the element
+			const PlyBinaryElement& element    = elements[i];
+			const size_t            recordSize = element.fixedRecordSize();
+			if (recordSize != 0 || element.properties.empty())
+			{
+				if (recordSize != 0 && static_cast<size_t>(fileEnd - p) / recordSize < static_cast<size_t>(element.instances))
+				{
+					return PlyBulkResult::NotApplicable; // truncated file (let rply handle it)
+				}
+				p += recordSize * element.instances;
+			}
+			else
+			{
+				for (long j = 0; j < element.instances && p; ++j)
+				{
+					p = SkipPlyRecord(p, fileEnd, element, swapBytes);
+				}
+				if (!p)
+				{
+					return PlyBulkResult::NotApplicable; // truncated file (let rply handle it)
+				}
+			}
+		}
+	}
+
+	const unsigned pointCount = static_cast<unsigned>(vertexElement.instances);
+	if (static_cast<size_t>(fileEnd - vertexData) / vertexRecordSize < pointCount)
+	{
+		return PlyBulkResult::NotApplicable; // truncated file (let rply handle it)
+	}
+
+	// properties offsets
+	struct BlockProperty
+	{
+		bool       valid  = false;
+		size_t     offset = 0;
+		e_ply_type type   = PLY_LIST;
+	};
+	auto locate = [&](const plyProperty* pp)
+	{
+		BlockProperty bp;
+		if (pp)
+		{
+			int propIndex = vertexElement.propertyIndex(pp);
+			if (propIndex >= 0)
+			{
+				bp.valid = true;
+				bp.type  = vertexElement.properties[propIndex].type;
+				for (int k = 0; k < propIndex; ++k)
+				{
+					bp.offset += PlyTypeSize(vertexElement.properties[k].type);
+				}
+			}
+		}
+		return bp;
+	};
+
+	BlockProperty coords[3], normals[3], colors[3];
+	for (unsigned d = 0; d < 3; ++d)
+	{
+		coords[d]  = locate(bulk.coords[d]);
+		normals[d] = locate(bulk.normals[d]);
+		colors[d]  = locate(bulk.colors[d]);
+	}
+	BlockProperty grey = locate(bulk.grey);
+
+	std::vector<std::pair<BlockProperty, CCCoreLib::ScalarField*>> scalarFields;
+	for (const auto& sfProp : bulk.scalarFields)
+	{
+		scalarFields.emplace_back(locate(sfProp.first), sfProp.second);
+	}
+
+	const bool hasNormals = (normals[0].valid || normals[1].valid || normals[2].valid);
+	const bool hasColors  = (colors[0].valid || colors[1].valid || colors[2].valid || grey.valid);
+
+	auto readPoint = [&](const uchar* record)
+	{
+		CCVector3d P(0, 0, 0);
+		for (unsigned d = 0; d < 3; ++d)
+		{
+			if (coords[d].valid)
+			{
+				double val = ReadPlyValue(record + coords[d].offset, coords[d].type, swapBytes);
+				// This looks like it should always be true,
+				// but it's false if val is NaN.
+				if (val == val)
+				{
+					P.u[d] = val;
+				}
+			}
+		}
+		return P;
+	};
+
+	// first point: check for 'big' coordinates
+	if (pointCount != 0)
+	{
+		CCVector3d P                       = readPoint(vertexData);
+		bool       preserveCoordinateShift = true;
+		if (FileIOFilter::HandleGlobalShift(P, s_Pshift, preserveCoordinateShift, s_loadParameters))
+		{
+			if (preserveCoordinateShift)
+			{
+				cloud->setGlobalShift(s_Pshift);
+			}
+			ccLog::Warning("[PLYFilter::loadFile] Cloud (vertices) has been recentered! Translation: (%.2f ; %.2f ; %.2f)", s_Pshift.x, s_Pshift.y, s_Pshift.z);
+		}
+	}
+
+	// number of records decoded between two progress updates
+	static const int BlockSize = (1 << 16);
+
+	// load-time filtering (the mesh vertices are never filtered)
+	ccLoadingFilter* loadingFilter = (!mesh && s_loadParameters.loadingFilter && s_loadParameters.loadingFilter->isActive() ? s_loadParameters.loadingFilter.data() : nullptr);
+
+	// if the points are filtered, the cloud only grows one block at a time
+	const unsigned initialCount = (loadingFilter ? std::min<unsigned>(pointCount, BlockSize) : pointCount);
+	if (!cloud->resize(initialCount)
+	    || (hasColors && !cloud->resizeTheRGBTable(false))
+	    || (hasNormals && !cloud->resizeTheNormsTable()))
+	{
+		return PlyBulkResult::NotEnoughMemory;
+	}
+	for (const auto& sf : scalarFields)
+	{
+		if (sf.second->size() < initialCount && !sf.second->resizeSafe(initialCount))
+		{
+			return PlyBulkResult::NotEnoughMemory;
+		}
+	}
+
+	const CCVector3d       Pshift      = s_Pshift;
+	RGBAColorsTableType*   rgbaColors  = cloud->rgbaColors();
+	NormsIndexesTableType* normsTable  = cloud->normals();
+	const int              pointCountI = static_cast<int>(pointCount);
+
+	// the progress covers the points and the faces records
+	const unsigned                faceRecordCount = (faceData ? static_cast<unsigned>(std::max(elements[faceIndex].instances, 0L)) : 0);
+	CCCoreLib::NormalizedProgress nprogress(progressCb, pointCount + faceRecordCount);
+
+	for (int blockStart = 0; blockStart < pointCountI; blockStart += BlockSize)
+	{
+		const int blockEnd = std::min(blockStart + BlockSize, pointCountI);
+
+		// index of the first point of the block in the cloud
+		unsigned outputStart = static_cast<unsigned>(blockStart);
+		if (loadingFilter)
+		{
+			// the block points are decoded after the points kept so far
+			outputStart = cloud->size();
+			if (!cloud->resize(outputStart + static_cast<unsigned>(blockEnd - blockStart)))
+			{
+				return PlyBulkResult::NotEnoughMemory;
+			}
+		}
+
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+		for (int i = blockStart; i < blockEnd; ++i)
+		{
+			const uchar*   record     = vertexData + static_cast<size_t>(i) * vertexRecordSize;
+			const unsigned pointIndex = outputStart + static_cast<unsigned>(i - blockStart);
+
+			*const_cast<CCVector3*>(cloud->getPoint(pointIndex)) = (readPoint(record) + Pshift).toPC();
+
+			if (hasNormals)
+			{
+				CCVector3 N(0, 0, 0);
+				for (unsigned d = 0; d < 3; ++d)
+				{
+					if (normals[d].valid)
+					{
+						N.u[d] = static_cast<PointCoordinateType>(ReadPlyValue(record + normals[d].offset, normals[d].type, swapBytes));
+					}
+				}
+				normsTable->at(pointIndex) = ccNormalVectors::GetNormIndex(N);
+			}
+
+			if (hasColors)
+			{
+				ccColor::Rgba col(0, 0, 0, ccColor::MAX);
+				if (grey.valid)
+				{
+					ColorCompType G = ToColorComponent(ReadPlyValue(record + grey.offset, grey.type, swapBytes), IsFloat(grey.type));
+					col             = ccColor::Rgba(G, G, G, ccColor::MAX);
+				}
+				else
+				{
+					for (unsigned d = 0; d < 3; ++d)
+					{
+						if (colors[d].valid)
+						{
+							col.rgba[d] = ToColorComponent(ReadPlyValue(record + colors[d].offset, colors[d].type, swapBytes), IsFloat(colors[d].type));
+						}
+					}
+				}
+				rgbaColors->at(pointIndex) = col;
+			}
+
+			for (const auto& sf : scalarFields)
+			{
+				if (sf.first.valid)
+				{
+					sf.second->setValue(pointIndex, static_cast<ScalarType>(ReadPlyValue(record + sf.first.offset, sf.first.type, swapBytes)));
+				}
+			}
+		}
+
+		if (loadingFilter)
+		{
+			loadingFilter->filter(cloud, outputStart);
+		}
+
+		if (!nprogress.steps(static_cast<unsigned>(blockEnd - blockStart)))
+		{
+			return PlyBulkResult::Canceled;
+		}
+	}
+
+	if (loadingFilter)
+	{
+		cloud->shrinkToFit();
+	}
+
+	cloud->invalidateBoundingBox();
+	if (hasColors)
+	{
+		cloud->colorsHaveChanged();
+	}
+	if (hasNormals)
+	{
+		cloud->normalsHaveChanged();
+	}
+	s_PointCount = static_cast<int>(cloud->size());
+
+	/* MESH FACETS (TRI) */
+
+	if (!faceData)
+	{
+		return PlyBulkResult::Success;
+	}
+
+	const PlyBinaryElement& faceElement = elements[faceIndex];
+	const int               facesProp   = faceElement.propertyIndex(bulk.faces);
+	if (facesProp < 0 || faceElement.instances <= 0)
+	{
+		return PlyBulkResult::Success;
+	}
+	const plyProperty& faces         = faceElement.properties[facesProp];
+	const size_t       lengthSize    = PlyTypeSize(faces.length_type);
+	const size_t       indexSize     = PlyTypeSize(faces.value_type);
+	const unsigned     numberOfFaces = static_cast<unsigned>(faceElement.instances);
+
+	// layout of the first record
+	struct ListLayout
+	{
+		size_t     offset;
+		e_ply_type lengthType;
+		double     length;
+	};
+	std::vector<ListLayout> lists;
+	size_t                  facesOffset = 0;
+	size_t                  stride      = 0;
+	{
+		const uchar* p = faceData;
+		for (size_t k = 0; k < faceElement.properties.size(); ++k)
+		{
+			const plyProperty& prop = faceElement.properties[k];
+			size_t             size = 0;
+			if (prop.type == PLY_LIST)
+			{
+				size_t propLengthSize = PlyTypeSize(prop.length_type);
+				if (propLengthSize == 0 || static_cast<size_t>(fileEnd - p) < propLengthSize)
+				{
+					return PlyBulkResult::Malformed;
+				}
+				double length = ReadPlyValue(p, prop.length_type, swapBytes);
+				if (length < 0)
+				{
+					return PlyBulkResult::Malformed;
+				}
+				if (static_cast<int>(k) == facesProp)
+				{
+					facesOffset = static_cast<size_t>(p - faceData);
+				}
+				lists.push_back({static_cast<size_t>(p - faceData), prop.length_type, length});
+				size = propLengthSize + static_cast<size_t>(length) * PlyTypeSize(prop.value_type);
+			}
+			else
+			{
+				size = PlyTypeSize(prop.type);
+			}
+			if (static_cast<size_t>(fileEnd - p) < size)
+			{
+				return PlyBulkResult::Malformed;
+			}
+			p += size;
+		}
+		stride = static_cast<size_t>(p - faceData);
+	}
+
+	// if all the faces are triangles (with the same layout), the records have a fixed size
+	bool constantTriangles = (stride != 0
+	                          && indexSize != 0
+	                          && static_cast<size_t>(fileEnd - faceData) / stride >= numberOfFaces
+	                          && ReadPlyValue(faceData + facesOffset, faces.length_type, swapBytes) == 3.0);
+	if (constantTriangles)
+	{
+		if (!mesh->resize(numberOfFaces))
+		{
+			return PlyBulkResult::NotEnoughMemory;
+		}
+
+		std::atomic<bool> layoutMismatch(false);
+		const int         numberOfFacesI = static_cast<int>(numberOfFaces);
+
+		for (int blockStart = 0; blockStart < numberOfFacesI && !layoutMismatch; blockStart += BlockSize)
+		{
+			const int blockEnd = std::min(blockStart + BlockSize, numberOfFacesI);
+
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+			for (int i = blockStart; i < blockEnd; ++i)
+			{
+				if (layoutMismatch)
+				{
+					continue;
+				}
+
+				const uchar* record = faceData + static_cast<size_t>(i) * stride;
+				for (const ListLayout& list : lists)
+				{
+					if (ReadPlyValue(record + list.offset, list.lengthType, swapBytes) != list.length)
+					{
+						layoutMismatch = true;
+						break;
+					}
+				}
+				if (layoutMismatch)
+				{
+					continue;
+				}
+
+				const uchar*                indexes = record + facesOffset + lengthSize;
+				CCCoreLib::VerticesIndexes* tri     = mesh->getTriangleVertIndexes(i);
+
+				tri->i1 = static_cast<unsigned>(ReadPlyValue(indexes, faces.value_type, swapBytes));
+				tri->i2 = static_cast<unsigned>(ReadPlyValue(indexes + indexSize, faces.value_type, swapBytes));
+				tri->i3 = static_cast<unsigned>(ReadPlyValue(indexes + 2 * indexSize, faces.value_type, swapBytes));
+			}
+
+			if (!nprogress.steps(static_cast<unsigned>(blockEnd - blockStart)))
+			{
+				return PlyBulkResult::Canceled;
+			}
+		}
+
+		if (!layoutMismatch)
+		{
+			s_triCount = numberOfFaces;
+			return PlyBulkResult::Success;
+		}
+
+		// some faces are not triangles (or the records don't have the same size)
+		mesh->resize(0);
+	}
+
+	// sequential decoding (same behavior as 'face_cb')
+	const uchar* p = faceData;
+	for (unsigned i = 0; i < numberOfFaces; ++i)
+	{
+		if ((i % BlockSize) == 0 && i != 0 && !nprogress.steps(BlockSize))
+		{
+			return PlyBulkResult::Canceled;
+		}
+
+		for (size_t k = 0; k < faceElement.properties.size(); ++k)
+		{
+			const plyProperty& prop = faceElement.properties[k];
+			size_t             size = 0;
+			if (prop.type == PLY_LIST)
+			{
+				size_t propLengthSize = PlyTypeSize(prop.length_type);
+				if (propLengthSize == 0 || static_cast<size_t>(fileEnd - p) < propLengthSize)
+				{
+					return PlyBulkResult::Malformed;
+				}
+				double length = ReadPlyValue(p, prop.length_type, swapBytes);
+				if (length < 0)
+				{
+					return PlyBulkResult::Malformed;
+				}
+				p += propLengthSize;
+
+				size_t valueSize = PlyTypeSize(prop.value_type);
+				size             = static_cast<size_t>(length) * valueSize;
+				if (static_cast<size_t>(fileEnd - p) < size)
+				{
+					return PlyBulkResult::Malformed;
+				}
+
+				if (static_cast<int>(k) == facesProp)
+				{
+					if (length != 3.0 && length != 4.0)
+					{
+						s_unsupportedPolygonType = true;
+					}
+					else
+					{
+						unsigned tri[4]{0, 0, 0, 0};
+						for (unsigned v = 0; v < static_cast<unsigned>(length); ++v)
+						{
+							tri[v] = static_cast<unsigned>(ReadPlyValue(p + v * valueSize, prop.value_type, swapBytes));
+						}
+
+						const unsigned triCount = (length == 4.0 ? 2 : 1);
+						if (mesh->size() + triCount > mesh->capacity())
+						{
+							// we may have more triangles than expected
+							if (!mesh->reserve(std::max<size_t>(mesh->size() + 1024, (mesh->capacity() * 3) / 2)))
+							{
+								return PlyBulkResult::NotEnoughMemory;
+							}
+						}
+
+						mesh->addTriangle(tri[0], tri[1], tri[2]);
+						if (triCount == 2)
+						{
+							s_hasQuads = true;
+							mesh->addTriangle(tri[0], tri[2], tri[3]);
+						}
+						s_triCount += triCount;
+					}
+				}
+			}
+			else
+			{
+				size = PlyTypeSize(prop.type);
+				if (static_cast<size_t>(fileEnd - p) < size)
+				{
+					return PlyBulkResult::Malformed;
+				}
+			}
+			p += size;
+		}
+	}
+
+	return PlyBulkResult::Success;
+}
+
 CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, ccHObject& container, LoadParameters& parameters)
 {
 	return loadFile(filename, QString(), container, parameters);
@@ -1417,6 +2247,11 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 		cloud->setMetaData("ply.comments", comments);
 	}
 
+	// properties that can be decoded by blocks (binary files)
+	PlyBulkProperties bulk;
+	bulk.pointElements = &pointElements;
+	bulk.meshElements  = &meshElements;
+
 	/* POINTS (X,Y,Z) */
 
 	unsigned numberOfPoints = 0;
@@ -1432,6 +2267,7 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 
 		plyProperty& pp = stdProperties[xIndex - 1];
 		ply_set_read_cb(ply, pointElements[pp.elemIndex].elementName, pp.propName, vertex_cb, cloud, flags);
+		bulk.coords[0] = &pp;
 
 		numberOfPoints = pointElements[pp.elemIndex].elementInstances;
 	}
@@ -1445,6 +2281,7 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 
 		plyProperty& pp = stdProperties[yIndex - 1];
 		ply_set_read_cb(ply, pointElements[pp.elemIndex].elementName, pp.propName, vertex_cb, cloud, flags);
+		bulk.coords[1] = &pp;
 
 		if (numberOfPoints > 0)
 		{
@@ -1469,6 +2306,7 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 
 		plyProperty& pp = stdProperties[zIndex - 1];
 		ply_set_read_cb(ply, pointElements[pp.elemIndex].elementName, pp.propName, vertex_cb, cloud, flags);
+		bulk.coords[2] = &pp;
 
 		if (numberOfPoints > 0)
 		{
@@ -1508,6 +2346,7 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 
 		plyProperty& pp = stdProperties[nxIndex - 1];
 		ply_set_read_cb(ply, pointElements[pp.elemIndex].elementName, pp.propName, normal_cb, cloud, flags);
+		bulk.normals[0] = &pp;
 
 		numberOfNormals = pointElements[pp.elemIndex].elementInstances;
 	}
@@ -1521,6 +2360,7 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 
 		plyProperty& pp = stdProperties[nyIndex - 1];
 		ply_set_read_cb(ply, pointElements[pp.elemIndex].elementName, pp.propName, normal_cb, cloud, flags);
+		bulk.normals[1] = &pp;
 
 		numberOfNormals = std::max(numberOfNormals, (unsigned)pointElements[pp.elemIndex].elementInstances);
 	}
@@ -1534,6 +2374,7 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 
 		plyProperty& pp = stdProperties[nzIndex - 1];
 		ply_set_read_cb(ply, pointElements[pp.elemIndex].elementName, pp.propName, normal_cb, cloud, flags);
+		bulk.normals[2] = &pp;
 
 		numberOfNormals = std::max(numberOfNormals, (unsigned)pointElements[pp.elemIndex].elementInstances);
 	}
@@ -1573,6 +2414,7 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 
 		plyProperty& pp = stdProperties[rIndex - 1];
 		ply_set_read_cb(ply, pointElements[pp.elemIndex].elementName, pp.propName, rgb_cb, cloud, flags);
+		bulk.colors[0] = &pp;
 
 		numberOfColors = pointElements[pp.elemIndex].elementInstances;
 	}
@@ -1585,6 +2427,7 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 
 		plyProperty& pp = stdProperties[gIndex - 1];
 		ply_set_read_cb(ply, pointElements[pp.elemIndex].elementName, pp.propName, rgb_cb, cloud, flags);
+		bulk.colors[1] = &pp;
 
 		numberOfColors = std::max(numberOfColors, (unsigned)pointElements[pp.elemIndex].elementInstances);
 	}
@@ -1597,6 +2440,7 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 
 		plyProperty& pp = stdProperties[bIndex - 1];
 		ply_set_read_cb(ply, pointElements[pp.elemIndex].elementName, pp.propName, rgb_cb, cloud, flags);
+		bulk.colors[2] = &pp;
 
 		numberOfColors = std::max(numberOfColors, (unsigned)pointElements[pp.elemIndex].elementInstances);
 	}
@@ -1615,6 +2459,7 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 		{
 			plyProperty pp = stdProperties[iIndex - 1];
 			ply_set_read_cb(ply, pointElements[pp.elemIndex].elementName, pp.propName, grey_cb, cloud, 0);
+			bulk.grey = &stdProperties[iIndex - 1];
 
 			numberOfColors = pointElements[pp.elemIndex].elementInstances;
 		}
@@ -1671,6 +2516,7 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 					if (sf->resizeSafe(numberOfScalars))
 					{
 						ply_set_read_cb(ply, pointElements[pp.elemIndex].elementName, pp.propName, scalar_cb, sf, 1);
+						bulk.scalarFields.emplace_back(&pp, sf);
 					}
 					else
 					{
@@ -1713,6 +2559,7 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 		else
 		{
 			ply_set_read_cb(ply, meshElements[pp.elemIndex].elementName, pp.propName, face_cb, mesh, 0);
+			bulk.faces = &pp;
 		}
 	}
 
@@ -1768,23 +2615,60 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 	QScopedPointer<ccProgressDialog> pDlg(nullptr);
 	if (parameters.parentWidget)
 	{
-		pDlg.reset(new ccProgressDialog(false, parameters.parentWidget));
+		pDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
 		pDlg->setInfo(QObject::tr("Loading in progress..."));
 		pDlg->setMethodTitle(QObject::tr("PLY file"));
-		pDlg->setRange(0, 0);
 		pDlg->start();
 		QApplication::processEvents();
 	}
 
-	// let 'Rply' do the job;)
 	int success = 0;
-	try
+
+	// binary files: we try to decode the data by blocks first (much faster than the per-value callbacks)
+	PlyBulkResult bulkResult = PlyBulkResult::NotApplicable;
+	if (!texCoords && !texIndexes) // texture coordinates and indexes are only handled by the callbacks
 	{
-		success = ply_read(ply);
+		try
+		{
+			bulkResult = LoadBinaryBlocks(filename, ply, storage_mode, bulk, cloud, mesh, pDlg.data());
+		}
+		catch (const std::bad_alloc&)
+		{
+			bulkResult = PlyBulkResult::NotEnoughMemory;
+		}
 	}
-	catch (...)
+
+	switch (bulkResult)
 	{
-		success = -1;
+	case PlyBulkResult::Success:
+		success = 1;
+		break;
+	case PlyBulkResult::NotEnoughMemory:
+		s_NotEnoughMemory = true;
+		break;
+	case PlyBulkResult::Malformed:
+		ccLog::Warning("[PLY] Malformed or truncated binary data");
+		break;
+	case PlyBulkResult::Canceled:
+		break;
+	case PlyBulkResult::NotApplicable:
+	default:
+		// the 'Rply' callbacks can't be interrupted (and don't report their progress)
+		if (pDlg)
+		{
+			pDlg->setCancelButton(nullptr);
+			pDlg->setRange(0, 0);
+		}
+		// let 'Rply' do the job;)
+		try
+		{
+			success = ply_read(ply);
+		}
+		catch (...)
+		{
+			success = -1;
+		}
+		break;
 	}
 
 	ply_close(ply);
@@ -1799,6 +2683,10 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 		if (mesh)
 			delete mesh;
 		delete cloud;
+		if (bulkResult == PlyBulkResult::Canceled)
+		{
+			return CC_FERR_CANCELED_BY_USER;
+		}
 		return s_NotEnoughMemory ? CC_FERR_NOT_ENOUGH_MEMORY : CC_FERR_THIRD_PARTY_LIB_FAILURE;
 	}
 
@@ -0,0 +1,448 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+// #                                                                        #
+// ##########################################################################
+
+#include "ccFileLoadingTask.h"
+
+// qCC_db
+#include <ccGenericPointCloud.h>
+#include <ccLog.h>
+#include <ccNormalVectors.h>
+
+// Qt
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+// System
+#include <algorithm>
+#include <cassert>
+
+//! Returns the thread pool dedicated to the loading tasks
+/** Some I/O filters use the global thread pool themselves (e.g. E57): it can't be
+    saturated by loading tasks waiting for it.
+**/
+static QThreadPool* LoadingThreadPool()
+{
+	static QThreadPool s_loadingThreadPool;
+	return &s_loadingThreadPool;
+}
+
+ccFileLoadingTask::ccFileLoadingTask(const QString& filename)
+    : m_filename(filename)
+    , m_coordinatesShift(0, 0, 0)
+    , m_coordinatesShiftEnabled(false)
+    , m_coordinatesShiftForced(false)
+    , m_globalShiftResolver(nullptr)
+    , m_cancelRequested(false)
+    , m_finished(false)
+    , m_progress(0)
+    , m_result(CC_FERR_NO_ERROR)
+    , m_container(nullptr)
+{
+}
+
+ccFileLoadingTask::~ccFileLoadingTask()
+{
+	cancel();
+	waitForFinished();
+
+	// release the entities that have not been taken
+	for (ccHObject* entity : m_entities)
+	{
+		delete entity;
+	}
+	m_entities.clear();
+
+	delete m_container;
+	m_container = nullptr;
+}
+
+void ccFileLoadingTask::launch(FileIOFilter::Shared filter, const FileIOFilter::LoadParameters& parameters, ccGlobalShiftResolver* globalShiftResolver /*=nullptr*/)
+{
+	assert(filter && !m_future.isRunning());
+
+	m_parameters          = parameters;
+	m_globalShiftResolver = globalShiftResolver;
+
+	// no dialog can be displayed by the loading thread
+	m_parameters.parentWidget            = nullptr;
+	m_parameters.alwaysDisplayLoadDialog = false;
+	if (!m_globalShiftResolver // otherwise the Global Shift dialog is displayed by the resolver owner thread
+	    && (m_parameters.shiftHandlingMode == ccGlobalShiftManager::DIALOG_IF_NECESSARY
+	        || m_parameters.shiftHandlingMode == ccGlobalShiftManager::ALWAYS_DISPLAY_DIALOG))
+	{
+		m_parameters.shiftHandlingMode = ccGlobalShiftManager::NO_DIALOG_AUTO_SHIFT;
+	}
+
+	// the global shift parameters are copied (so that several tasks can share the same input parameters)
+	if (parameters._coordinatesShift)
+	{
+		m_coordinatesShift = *parameters._coordinatesShift;
+	}
+	if (parameters._coordinatesShiftEnabled)
+	{
+		m_coordinatesShiftEnabled = *parameters._coordinatesShiftEnabled;
+	}
+	if (parameters._coordinatesShiftForced)
+	{
+		m_coordinatesShiftForced = *parameters._coordinatesShiftForced;
+	}
+	m_parameters._coordinatesShift        = &m_coordinatesShift;
+	m_parameters._coordinatesShiftEnabled = &m_coordinatesShiftEnabled;
+	m_parameters._coordinatesShiftForced  = &m_coordinatesShiftForced;
+
+	m_parameters.loadingTask = this;
+
+	// make sure the normals lookup table is initialized before being (potentially) used concurrently
+	ccNormalVectors::GetUniqueInstance();
+
+	m_future = QtConcurrent::run(LoadingThreadPool(), [this, filter]()
+	                             { run(filter); });
+}
+
+void ccFileLoadingTask::run(FileIOFilter::Shared filter)
+{
+	CC_FILE_ERROR result = CC_FERR_NO_ERROR;
+	m_container          = FileIOFilter::LoadFromFile(m_filename, m_parameters, filter, result);
+	if (result == CC_FERR_NO_LOAD && m_cancelRequested)
+	{
+		result = CC_FERR_CANCELED_BY_USER;
+	}
+
+	m_result = result;
+	m_progress.storeRelease(100);
+	m_finished = true;
+
+	Q_EMIT progressChanged(100);
+	Q_EMIT finished();
+}
+
+void ccFileLoadingTask::cancel()
+{
+	m_cancelRequested = true;
+}
+
+void ccFileLoadingTask::waitForFinished()
+{
+	m_future.waitForFinished();
+}
+
+bool ccFileLoadingTask::getCoordinatesShift(CCVector3d& shift) const
+{
+	if (!m_finished)
+	{
+		return false;
+	}
+
+	shift = m_coordinatesShift;
+	return m_coordinatesShiftEnabled;
+}
+
+std::vector<ccHObject*> ccFileLoadingTask::takeEntities()
+{
+	QMutexLocker locker(&m_entitiesMutex);
+
+	std::vector<ccHObject*> entities;
+	entities.swap(m_entities);
+	return entities;
+}
+
+ccHObject* ccFileLoadingTask::takeContainer()
+{
+	if (!m_finished)
+	{
+		assert(false);
+		return nullptr;
+	}
+
+	ccHObject* container = m_container;
+	m_container          = nullptr;
+	return container;
+}
+
+void ccFileLoadingTask::deliver(ccHObject* entity)
+{
+	if (!entity)
+	{
+		assert(false);
+		return;
+	}
+
+	{
+		QMutexLocker locker(&m_entitiesMutex);
+		try
+		{
+			m_entities.push_back(entity);
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Warning(QString("[I/O] Not enough memory to deliver entity '%1'").arg(entity->getName()));
+			delete entity;
+			return;
+		}
+	}
+
+	Q_EMIT entitiesReady();
+}
+
+void ccFileLoadingTask::update(float percent)
+{
+	// the progress is reported as a whole number (to limit the number of signals)
+	int value = std::max(0, std::min(static_cast<int>(percent), 99));
+	if (m_progress.fetchAndStoreOrdered(value) != value)
+	{
+		Q_EMIT progressChanged(value);
+	}
+}
+
+void ccFileLoadingTask::setMethodTitle(const char* methodTitle)
+{
+	Q_UNUSED(methodTitle);
+}
+
+void ccFileLoadingTask::setInfo(const char* infoStr)
+{
+	Q_UNUSED(infoStr);
+}
+
+void ccFileLoadingTask::start()
+{
+	// nothing to do
+}
+
+void ccFileLoadingTask::stop()
+{
+	// nothing to do
+}
+
+bool ccFileLoadingTask::isCancelRequested()
+{
+	return m_cancelRequested;
+}
+
+ccGlobalShiftResolver::ccGlobalShiftResolver(FileIOFilter::LoadParameters& parameters)
+    : m_parameters(parameters)
+    , m_shiftEnabled(false)
+    , m_shift(0, 0, 0)
+    , m_shiftForced(false)
+    , m_preserveShift(true)
+    , m_shiftRefused(false)
+{
+	synchronize();
+}
+
+void ccGlobalShiftResolver::synchronize()
+{
+	m_shiftEnabled  = (m_parameters._coordinatesShiftEnabled && *m_parameters._coordinatesShiftEnabled && m_parameters._coordinatesShift);
+	m_shift         = (m_shiftEnabled ? *m_parameters._coordinatesShift : CCVector3d(0, 0, 0));
+	m_shiftForced   = (m_shiftEnabled && m_parameters._coordinatesShiftForced && *m_parameters._coordinatesShiftForced);
+	m_preserveShift = m_parameters.preserveShiftOnSave;
+}
+
+bool ccGlobalShiftResolver::answer(Request& request) const
+{
+	if (m_shiftRefused)
+	{
+		// the user doesn't want any Global Shift
+		request.shift  = CCVector3d(0, 0, 0);
+		request.result = false;
+		return true;
+	}
+
+	if (m_shiftEnabled)
+	{
+		if (m_shiftForced
+		    || request.mode == ccGlobalShiftManager::NO_DIALOG
+		    || !ccGlobalShiftManager::NeedShift(request.P + m_shift))
+		{
+			// the accepted Global Shift is used
+			request.shift         = m_shift;
+			request.preserveShift = m_preserveShift;
+			request.result        = true;
+			return true;
+		}
+
+		// this entity is too far from the previous ones
+		return false;
+	}
+
+	if (request.mode == ccGlobalShiftManager::NO_DIALOG)
+	{
+		// without a dialog, only the input shift (if any) can be used
+		request.result = request.useInputShift;
+		if (!request.result)
+		{
+			request.shift = CCVector3d(0, 0, 0);
+		}
+		return true;
+	}
+
+	if (!request.useInputShift
+	    && request.mode != ccGlobalShiftManager::ALWAYS_DISPLAY_DIALOG
+	    && !ccGlobalShiftManager::NeedShift(request.P))
+	{
+		// no need to apply any Global Shift
+		request.shift  = CCVector3d(0, 0, 0);
+		request.result = false;
+		return true;
+	}
+
+	return false;
+}
+
+bool ccGlobalShiftResolver::handle(const CCVector3d&             P,
+                                   CCVector3d&                   Pshift,
+                                   bool&                         preserveCoordinateShift,
+                                   FileIOFilter::LoadParameters& loadParameters,
+                                   bool                          useInputCoordinatesShiftIfPossible)
+{
+	Request request;
+	request.P             = P;
+	request.shift         = Pshift;
+	request.useInputShift = useInputCoordinatesShiftIfPossible;
+	request.mode          = loadParameters.shiftHandlingMode;
+	request.preserveShift = preserveCoordinateShift;
+
+	QMutexLocker locker(&m_mutex);
+
+	if (!answer(request))
+	{
+		// the owner thread has to handle it (see processRequests)
+		try
+		{
+			m_requests.push_back(&request);
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Warning("[ccGlobalShiftResolver] Not enough memory");
+			Pshift = CCVector3d(0, 0, 0);
+			return false;
+		}
+
+		while (!request.processed)
+		{
+			if (loadParameters.loadingTask && loadParameters.loadingTask->isCanceled())
+			{
+				// the request is withdrawn (the owner thread can't be processing it, as we have the lock)
+				m_requests.erase(std::find(m_requests.begin(), m_requests.end(), &request));
+				Pshift = CCVector3d(0, 0, 0);
+				return false;
+			}
+			m_requestsProcessed.wait(&m_mutex, 100);
+		}
+	}
+
+	Pshift = request.shift;
+	if (request.result)
+	{
+		preserveCoordinateShift = request.preserveShift;
+	}
+	return request.result;
+}
+
+void ccGlobalShiftResolver::processRequests()
+{
+	// the lock is kept while the dialog is displayed (the requests belong to the waiting threads)
+	QMutexLocker locker(&m_mutex);
+
+	if (m_requests.empty())
+	{
+		return;
+	}
+
+	while (!m_requests.empty())
+	{
+		Request* request = m_requests.front();
+		m_requests.pop_front();
+
+		// the previous requests may have answered this one
+		if (!answer(*request))
+		{
+			ccGlobalShiftManager::Mode mode = m_parameters.shiftHandlingMode;
+			m_parameters.shiftHandlingMode  = request->mode;
+			request->result                 = FileIOFilter::HandleGlobalShift(request->P, request->shift, request->preserveShift, m_parameters, request->useInputShift);
+			m_parameters.shiftHandlingMode  = mode;
+
+			if (request->result)
+			{
+				if (m_parameters._coordinatesShiftEnabled && !*m_parameters._coordinatesShiftEnabled && m_parameters._coordinatesShift)
+				{
+					// the user may have accepted the Global Shift for this file only, but we want the same shift for the whole batch
+					*m_parameters._coordinatesShift        = request->shift;
+					*m_parameters._coordinatesShiftEnabled = true;
+					m_parameters.preserveShiftOnSave       = request->preserveShift;
+				}
+			}
+			else if (!m_shiftEnabled
+			         && (request->mode == ccGlobalShiftManager::DIALOG_IF_NECESSARY || request->mode == ccGlobalShiftManager::ALWAYS_DISPLAY_DIALOG))
+			{
+				// the user has refused to apply a Global Shift: we won't ask again
+				m_shiftRefused                 = true;
+				m_parameters.shiftHandlingMode = ccGlobalShiftManager::NO_DIALOG;
+			}
+
+			synchronize();
+		}
+
+		request->processed = true;
+	}
+
+	m_requestsProcessed.wakeAll();
+}
+
+void ccGlobalShiftResolver::update(ccHObject* entities)
+{
+	QMutexLocker locker(&m_mutex);
+
+	if (entities && !m_shiftEnabled && !m_shiftRefused)
+	{
+		bool shiftRefused = false;
+
+		ccHObject::Container clouds;
+		entities->filterChildren(clouds, true, CC_TYPES::POINT_CLOUD);
+		for (ccHObject* cloud : clouds)
+		{
+			ccGenericPointCloud* genericCloud = static_cast<ccGenericPointCloud*>(cloud);
+			if (genericCloud->isShifted())
+			{
+				if (m_parameters._coordinatesShiftEnabled && m_parameters._coordinatesShift)
+				{
+					// the user may have accepted the Global Shift for this file only, but we want the same shift for the whole batch
+					*m_parameters._coordinatesShift        = genericCloud->getGlobalShift();
+					*m_parameters._coordinatesShiftEnabled = true;
+				}
+				shiftRefused = false;
+				break;
+			}
+			else if (genericCloud->size() != 0)
+			{
+				CCVector3d C = genericCloud->getOwnBB().getCenter();
+				shiftRefused |= ccGlobalShiftManager::NeedShift(C);
+			}
+		}
+
+		if (shiftRefused
+		    && (m_parameters.shiftHandlingMode == ccGlobalShiftManager::DIALOG_IF_NECESSARY || m_parameters.shiftHandlingMode == ccGlobalShiftManager::ALWAYS_DISPLAY_DIALOG))
+		{
+			// the user has refused to apply a Global Shift to this file: we won't ask again
+			m_shiftRefused                 = true;
+			m_parameters.shiftHandlingMode = ccGlobalShiftManager::NO_DIALOG;
+		}
+	}
+
+	synchronize();
+}
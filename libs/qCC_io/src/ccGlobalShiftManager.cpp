@@ -23,6 +23,8 @@
 // Qt
 #include <QCoreApplication>
 #include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
 
 // qCC_db
 #include <ccHObject.h>
@@ -39,10 +41,15 @@ static QString s_defaultGlobalShiftListFilename("global_shift_list.txt");
 
 // default and last input shift/scale entries (don't use it directly, use GetLast() instead)
 static std::vector<ccGlobalShiftManager::ShiftInfo> s_lastInfoBuffer;
-const std::vector<ccGlobalShiftManager::ShiftInfo>& ccGlobalShiftManager::GetLast()
+// the first time the entries are accessed, the default values are loaded from the 'bookmark' files
+static bool s_firstTime = true;
+// protects the entries (the Global Shift can be handled by several loading threads at the same time)
+static QMutex s_lastInfoMutex;
+
+std::vector<ccGlobalShiftManager::ShiftInfo> ccGlobalShiftManager::GetLast()
 {
-	// the first time this method is called, load the default values from the 'bookmark' files
-	static bool s_firstTime = true;
+	QMutexLocker locker(&s_lastInfoMutex);
+
 	if (s_firstTime)
 	{
 		LoadInfoFromFile(QCoreApplication::applicationDirPath() + QString("/") + s_defaultGlobalShiftListFilename, s_lastInfoBuffer);
@@ -71,6 +78,8 @@ void ccGlobalShiftManager::StoreShift(const CCVector3d& shift, double scale, boo
 		return;
 	}
 
+	QMutexLocker locker(&s_lastInfoMutex);
+
 	// check if it's already stored
 	for (const ShiftInfo& shiftInfo : s_lastInfoBuffer)
 	{
@@ -81,7 +90,7 @@ void ccGlobalShiftManager::StoreShift(const CCVector3d& shift, double scale, boo
 		}
 	}
 
-	static unsigned lastInputIndex = 0;
+	static unsigned lastInputIndex = 0; // protected by s_lastInfoMutex as well
 	ShiftInfo       info("Previous input");
 	if (lastInputIndex != 0)
 	{
@@ -218,7 +227,8 @@ bool ccGlobalShiftManager::Handle(const CCVector3d& P,
 		}
 	}
 
-	const std::vector<ShiftInfo>& lastInfoBuffer = ccGlobalShiftManager::GetLast();
+	// local copy (the dialog may be displayed, and the entries may be updated by another thread in the meantime)
+	const std::vector<ShiftInfo> lastInfoBuffer = ccGlobalShiftManager::GetLast();
 
 	if (needShift || needRescale || mode == ALWAYS_DISPLAY_DIALOG)
 	{
@@ -0,0 +1,348 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+// #                                                                        #
+// ##########################################################################
+
+#include "ccLoadingFilter.h"
+
+// qCC_db
+#include <ccLog.h>
+#include <ccPointCloud.h>
+#include <ccScalarField.h>
+
+// Qt
+#include <QMutexLocker>
+
+// System
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+	//! Voxel (cell) coordinates
+	struct CellKey
+	{
+		int64_t x, y, z;
+
+		inline bool operator==(const CellKey& other) const
+		{
+			return x == other.x && y == other.y && z == other.z;
+		}
+	};
+
+	//! Voxel (cell) coordinates hash
+	struct CellKeyHash
+	{
+		inline size_t operator()(const CellKey& key) const
+		{
+			// large primes mixing
+			uint64_t h = static_cast<uint64_t>(key.x) * 73856093ULL;
+			h ^= static_cast<uint64_t>(key.y) * 19349663ULL;
+			h ^= static_cast<uint64_t>(key.z) * 83492791ULL;
+			return static_cast<size_t>(h);
+		}
+	};
+
+	//! SplitMix64 hash (so that the random subsampling only depends on the point index and the seed)
+	inline uint64_t SplitMix64(uint64_t x)
+	{
+		x += 0x9E3779B97F4A7C15ULL;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+		return x ^ (x >> 31);
+	}
+} // namespace
+
+struct ccLoadingFilter::CloudState
+{
+	//! Number of points filtered so far
+	uint64_t processedCount = 0;
+	//! Whether the state has been initialized
+	bool initialized = false;
+	//! Index of the filtering scalar field (or -1 if none)
+	int sfIndex = -1;
+	//! Cell size (spatial subsampling, in the cloud local coordinate system)
+	double cellSize = 0.0;
+	//! Minimum squared distance between two points (spatial subsampling, in the cloud local coordinate system)
+	double squareMinSpacing = 0.0;
+	//! Kept point per occupied cell (spatial subsampling)
+	std::unordered_map<CellKey, CCVector3, CellKeyHash> cells;
+};
+
+ccLoadingFilter::ccLoadingFilter(const Parameters& parameters)
+    : m_parameters(parameters)
+{
+}
+
+ccLoadingFilter::~ccLoadingFilter() = default;
+
+bool ccLoadingFilter::isActive() const
+{
+	return m_parameters.randomRatio < 1.0
+	       || m_parameters.minSpacing > 0.0
+	       || m_parameters.useBox
+	       || !m_parameters.sfName.isEmpty();
+}
+
+ccLoadingFilter::CloudState& ccLoadingFilter::getState(ccPointCloud* cloud)
+{
+	QMutexLocker locker(&m_statesMutex);
+
+	std::unique_ptr<CloudState>& state = m_states[cloud->getUniqueID()];
+	if (!state)
+	{
+		state.reset(new CloudState);
+	}
+	return *state;
+}
+
+unsigned ccLoadingFilter::filter(ccPointCloud* cloud, unsigned firstIndex)
+{
+	if (!cloud)
+	{
+		assert(false);
+		return 0;
+	}
+
+	CloudState&    state      = getState(cloud);
+	const unsigned pointCount = cloud->size();
+	if (firstIndex >= pointCount)
+	{
+		return 0;
+	}
+
+	if (!state.initialized)
+	{
+		state.initialized = true;
+
+		if (!m_parameters.sfName.isEmpty())
+		{
+			state.sfIndex = cloud->getScalarFieldIndexByName(qPrintable(m_parameters.sfName));
+			if (state.sfIndex < 0)
+			{
+				ccLog::Warning(QString("[Loading filter] Cloud '%1' has no scalar field named '%2' (no filtering by value)").arg(cloud->getName(), m_parameters.sfName));
+			}
+		}
+
+		if (m_parameters.minSpacing > 0.0)
+		{
+			// the global scale also applies to distances
+			double minSpacing      = m_parameters.minSpacing * cloud->getGlobalScale();
+			state.squareMinSpacing = minSpacing * minSpacing;
+			// the cell diagonal is equal to the min spacing (so that a cell holds at most one point)
+			state.cellSize = minSpacing / std::sqrt(3.0);
+		}
+	}
+
+	const bool     useRandom     = (m_parameters.randomRatio < 1.0);
+	const uint64_t randomLimit   = static_cast<uint64_t>(std::max(0.0, m_parameters.randomRatio) * static_cast<double>(uint64_t(1) << 53));
+	const uint64_t seed          = SplitMix64(m_parameters.seed);
+	const bool     useMinSpacing = (state.cellSize > 0.0);
+
+	CCCoreLib::ScalarField* filteringSF = (state.sfIndex >= 0 ? cloud->getScalarField(state.sfIndex) : nullptr);
+
+	// the attributes to move along with the points
+	RGBAColorsTableType*                 colors  = cloud->rgbaColors();
+	NormsIndexesTableType*               normals = cloud->normals();
+	std::vector<ccWaveform>*             fwf     = (cloud->hasFWF() ? &cloud->waveforms() : nullptr);
+	std::vector<CCCoreLib::ScalarField*> sfs;
+	sfs.reserve(cloud->getNumberOfScalarFields());
+	for (unsigned j = 0; j < cloud->getNumberOfScalarFields(); ++j)
+	{
+		sfs.push_back(cloud->getScalarField(static_cast<int>(j)));
+	}
+
+	unsigned keptIndex = firstIndex;
+	for (unsigned i = firstIndex; i < pointCount; ++i)
+	{
+		const uint64_t  pointIndex = state.processedCount++;
+		const CCVector3 P          = *cloud->getPoint(i);
+
+		if (m_parameters.useBox)
+		{
+			CCVector3d Pg = cloud->toGlobal3d(P);
+			if (Pg.x < m_parameters.boxMin.x || Pg.x > m_parameters.boxMax.x
+			    || Pg.y < m_parameters.boxMin.y || Pg.y > m_parameters.boxMax.y
+			    || Pg.z < m_parameters.boxMin.z || Pg.z > m_parameters.boxMax.z)
+			{
+				continue;
+			}
+		}
+
+		if (filteringSF)
+		{
+			double value = filteringSF->getValue(i);
+			if (!(value >= m_parameters.sfMin && value <= m_parameters.sfMax)) // NaN values are rejected as well
+			{
+				continue;
+			}
+		}
+
+		if (useRandom && (SplitMix64(seed ^ pointIndex) >> 11) >= randomLimit)
+		{
+			continue;
+		}
+
+		if (useMinSpacing)
+		{
+			CellKey key{static_cast<int64_t>(std::floor(P.x / state.cellSize)),
+			            static_cast<int64_t>(std::floor(P.y / state.cellSize)),
+			            static_cast<int64_t>(std::floor(P.z / state.cellSize))};
+
+			if (state.cells.find(key) != state.cells.end())
+			{
+				// the cell already holds a (too close) point
+				continue;
+			}
+
+			// the min spacing is smaller than 2 cells
+			bool tooClose = false;
+			for (int64_t dx = -2; dx <= 2 && !tooClose; ++dx)
+			{
+				for (int64_t dy = -2; dy <= 2 && !tooClose; ++dy)
+				{
+					for (int64_t dz = -2; dz <= 2; ++dz)
+					{
+						auto it = state.cells.find({key.x + dx, key.y + dy, key.z + dz});
+						if (it != state.cells.end() && (it->second - P).norm2d() < state.squareMinSpacing)
+						{
+							tooClose = true;
+							break;
+						}
+					}
+				}
+			}
+			if (tooClose)
+			{
+				continue;
+			}
+
+			try
+			{
+				state.cells.emplace(key, P);
+			}
+			catch (const std::bad_alloc&)
+			{
+				// not enough memory: we keep the point anyway
+			}
+		}
+
+		// the point is kept
+		if (keptIndex != i)
+		{
+			*const_cast<CCVector3*>(cloud->getPoint(keptIndex)) = P;
+			if (colors)
+			{
+				(*colors)[keptIndex] = (*colors)[i];
+			}
+			if (normals)
+			{
+				(*normals)[keptIndex] = (*normals)[i];
+			}
+			if (fwf)
+			{
+				(*fwf)[keptIndex] = (*fwf)[i];
+			}
+			for (CCCoreLib::ScalarField* sf : sfs)
+			{
+				sf->setLocalValue(keptIndex, sf->getLocalValue(i));
+			}
+		}
+		++keptIndex;
+	}
+
+	if (keptIndex != pointCount)
+	{
+		if (cloud->gridCount() != 0)
+		{
+			// the scan grids are not valid anymore
+			cloud->removeGrids();
+		}
+		cloud->resize(keptIndex); // shrinking the cloud can't fail
+		cloud->invalidateBoundingBox();
+	}
+
+	return keptIndex - firstIndex;
+}
+
+void ccLoadingFilter::finalize(ccHObject* root, bool releaseAllStates /*=true*/)
+{
+	if (!root)
+	{
+		assert(false);
+		return;
+	}
+
+	ccHObject::Container clouds;
+	if (root->isA(CC_TYPES::POINT_CLOUD))
+	{
+		clouds.push_back(root);
+	}
+	root->filterChildren(clouds, true, CC_TYPES::POINT_CLOUD, true);
+
+	for (ccHObject* object : clouds)
+	{
+		ccPointCloud* cloud  = static_cast<ccPointCloud*>(object);
+		ccHObject*    parent = cloud->getParent();
+		if (parent && (parent->isKindOf(CC_TYPES::MESH) || parent->isA(CC_TYPES::POLY_LINE)))
+		{
+			// we can't remove vertices
+			continue;
+		}
+
+		ccHObject::Container labels;
+		if (cloud->filterChildren(labels, false, CC_TYPES::LABEL_2D, true) != 0)
+		{
+			// the labels refer to the points indexes
+			ccLog::Warning(QString("[Loading filter] Cloud '%1' has labels: it won't be filtered").arg(cloud->getName()));
+			continue;
+		}
+
+		bool alreadyFiltered = false;
+		{
+			QMutexLocker locker(&m_statesMutex);
+			alreadyFiltered = (m_states.find(cloud->getUniqueID()) != m_states.end());
+		}
+
+		if (!alreadyFiltered)
+		{
+			filter(cloud, 0);
+
+			for (unsigned j = 0; j < cloud->getNumberOfScalarFields(); ++j)
+			{
+				cloud->getScalarField(static_cast<int>(j))->computeMinAndMax();
+			}
+		}
+
+		const CloudState& state = getState(cloud);
+		ccLog::Print(QString("[Loading filter] Cloud '%1': %2 points kept out of %3").arg(cloud->getName()).arg(cloud->size()).arg(state.processedCount));
+
+		if (!releaseAllStates)
+		{
+			QMutexLocker locker(&m_statesMutex);
+			m_states.erase(cloud->getUniqueID());
+		}
+	}
+
+	// release the states (and the spatial subsampling grids)
+	if (releaseAllStates)
+	{
+		QMutexLocker locker(&m_statesMutex);
+		m_states.clear();
+	}
+}
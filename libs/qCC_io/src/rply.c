@@ -739,6 +739,19 @@ int get_plystorage_mode(p_ply ply, e_ply_storage_mode *storage_mode)
 	return 1;
 }
 
+int get_plydata_offset(p_ply ply, long *offset)
+{
+	long position = 0;
+	if (!ply || !ply->fp || ply->io_mode != PLY_READ) return 0;
+
+	/* the data section starts at the first untouched byte of the buffer */
+	position = ftell(ply->fp);
+	if (position < 0) return 0;
+
+	*offset = position - (long)(ply->buffer_last - ply->buffer_first);
+	return 1;
+}
+
 /* ----------------------------------------------------------------------
  * Query support functions
  * ---------------------------------------------------------------------- */
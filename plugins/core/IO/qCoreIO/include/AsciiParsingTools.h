@@ -0,0 +1,439 @@
+#pragma once
+
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+// #                                                                        #
+// ##########################################################################
+
+// Qt
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+// System
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+//! Tools to parse (big) ASCII files at the byte level
+/** The file is memory-mapped and parsed in place (no QString/QStringList conversion),
+    with the same conventions as QTextStream::readLine, QString::simplified/split and
+    QString::toDouble/toInt (so that the results are identical).
+**/
+namespace AsciiParsingTools
+{
+	//! Read-only view on a text file (memory-mapped if possible)
+	class TextFile
+	{
+	  public:
+		//! Opens the file
+		bool open(const QString& filename)
+		{
+			m_file.setFileName(filename);
+			if (!m_file.open(QFile::ReadOnly))
+			{
+				return false;
+			}
+
+			m_size = m_file.size();
+			if (m_size == 0)
+			{
+				m_data = nullptr;
+				return true;
+			}
+
+			m_data = reinterpret_cast<const char*>(m_file.map(0, m_size));
+			if (!m_data)
+			{
+				// we load the whole file in memory instead
+				try
+				{
+					m_buffer = m_file.readAll();
+				}
+				catch (const std::bad_alloc&)
+				{
+					return false;
+				}
+				if (m_buffer.size() != m_size)
+				{
+					return false;
+				}
+				m_data = m_buffer.constData();
+			}
+
+			return true;
+		}
+
+		//! Returns the beginning of the file content
+		inline const char* begin() const { return m_data; }
+		//! Returns the end of the file content
+		inline const char* end() const { return m_data + m_size; }
+		//! Returns the file size
+		inline qint64 size() const { return m_size; }
+
+	  protected:
+		QFile       m_file;
+		QByteArray  m_buffer;
+		const char* m_data = nullptr;
+		qint64      m_size = 0;
+	};
+
+	//! Token (or line): view on a sequence of characters
+	struct Token
+	{
+		const char* begin = nullptr;
+		const char* end   = nullptr;
+
+		Token() = default;
+		Token(const char* b, const char* e)
+		    : begin(b)
+		    , end(e)
+		{
+		}
+
+		inline bool   empty() const { return begin == end; }
+		inline size_t length() const { return static_cast<size_t>(end - begin); }
+		inline char   front() const { return *begin; }
+
+		//! Returns whether the token is equal to a given string
+		inline bool operator==(const char* str) const
+		{
+			size_t len = std::strlen(str);
+			return length() == len && std::memcmp(begin, str, len) == 0;
+		}
+
+		//! Returns whether the token starts with a given string (case insensitive)
+		inline bool startsWithNoCase(const char* str) const
+		{
+			size_t len = std::strlen(str);
+			if (length() < len)
+			{
+				return false;
+			}
+			for (size_t i = 0; i < len; ++i)
+			{
+				char c = begin[i];
+				if (c >= 'a' && c <= 'z')
+				{
+					c -= ('a' - 'A');
+				}
+				if (c != str[i])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//! Returns whether the token is equal to a given (upper case) string (case insensitive)
+		inline bool equalsNoCase(const char* str) const
+		{
+			return length() == std::strlen(str) && startsWithNoCase(str);
+		}
+
+		//! Converts the token to a QString (UTF-8)
+		inline QString toString() const
+		{
+			return QString::fromUtf8(begin, static_cast<int>(length()));
+		}
+	};
+
+	//! Returns whether a character is a white space (same as QChar::isSpace for ASCII characters)
+	inline bool IsSpace(char c)
+	{
+		return c == ' ' || (c >= '\t' && c <= '\r');
+	}
+
+	//! Reads the next line (same convention as QTextStream::readLine: the "\n" or "\r\n" line endings are excluded)
+	/** \param pos current position (updated to the beginning of the next line)
+	    \param end end of the file
+	    \return the line
+	**/
+	inline Token ReadLine(const char*& pos, const char* end)
+	{
+		const char* lineStart = pos;
+		const char* eol       = static_cast<const char*>(std::memchr(pos, '\n', static_cast<size_t>(end - pos)));
+		if (eol)
+		{
+			pos = eol + 1;
+		}
+		else
+		{
+			eol = pos = end;
+		}
+
+		if (eol != lineStart && *(eol - 1) == '\r')
+		{
+			--eol;
+		}
+
+		return {lineStart, eol};
+	}
+
+	//! Returns the next token of a line (tokens are separated by white spaces, and never empty)
+	/** \param pos current position in the line (updated)
+	    \param end end of the line
+	    \return the token (empty if there's none left)
+	**/
+	inline Token NextToken(const char*& pos, const char* end)
+	{
+		while (pos != end && IsSpace(*pos))
+		{
+			++pos;
+		}
+		const char* tokenStart = pos;
+		while (pos != end && !IsSpace(*pos))
+		{
+			++pos;
+		}
+		return {tokenStart, pos};
+	}
+
+	//! Trims a token/line (same as QString::trimmed)
+	inline Token Trimmed(Token token)
+	{
+		while (!token.empty() && IsSpace(*token.begin))
+		{
+			++token.begin;
+		}
+		while (!token.empty() && IsSpace(*(token.end - 1)))
+		{
+			--token.end;
+		}
+		return token;
+	}
+
+	//! Converts a token to a double value (same result as QString::toDouble)
+	/** The usual decimal notations are converted directly (exactly, in the cases where a single
+	    IEEE operation is enough). The other ones are converted by Qt.
+	**/
+	inline double ToDouble(const Token& token, bool* ok = nullptr)
+	{
+		static const double s_powersOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		                                      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+		const char* p        = token.begin;
+		const char* end      = token.end;
+		bool        negative = false;
+		if (p != end && (*p == '-' || *p == '+'))
+		{
+			negative = (*p == '-');
+			++p;
+		}
+
+		uint64_t mantissa      = 0;
+		int      digitCount    = 0; // significant digits
+		int      exponent      = 0;
+		bool     hasDigits     = false;
+		bool     tooManyDigits = false;
+
+		// integer part
+		for (; p != end && *p >= '0' && *p <= '9'; ++p)
+		{
+			hasDigits = true;
+			if (mantissa == 0 && *p == '0')
+			{
+				continue; // leading zero
+			}
+			if (digitCount < 19)
+			{
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+				++digitCount;
+			}
+			else
+			{
+				tooManyDigits = true;
+			}
+		}
+
+		// fractional part
+		if (p != end && *p == '.')
+		{
+			++p;
+			for (; p != end && *p >= '0' && *p <= '9'; ++p)
+			{
+				hasDigits = true;
+				if (mantissa == 0 && *p == '0')
+				{
+					--exponent; // leading zero
+					continue;
+				}
+				if (digitCount < 19)
+				{
+					mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+					++digitCount;
+					--exponent;
+				}
+				else
+				{
+					tooManyDigits = true;
+				}
+			}
+		}
+
+		// exponent
+		if (hasDigits && p != end && (*p == 'e' || *p == 'E'))
+		{
+			++p;
+			bool negativeExp = false;
+			if (p != end && (*p == '-' || *p == '+'))
+			{
+				negativeExp = (*p == '-');
+				++p;
+			}
+			if (p == end || *p < '0' || *p > '9')
+			{
+				hasDigits = false; // malformed exponent
+			}
+			int exp = 0;
+			for (; p != end && *p >= '0' && *p <= '9'; ++p)
+			{
+				if (exp < 10000)
+				{
+					exp = exp * 10 + (*p - '0');
+				}
+			}
+			exponent += (negativeExp ? -exp : exp);
+		}
+
+		if (p == end && hasDigits && !tooManyDigits && mantissa <= (uint64_t(1) << 53))
+		{
+			double value = static_cast<double>(mantissa);
+			if (mantissa == 0 || exponent == 0)
+			{
+				if (ok)
+					*ok = true;
+				return negative ? -value : value;
+			}
+			else if (exponent > 0 && exponent <= 22)
+			{
+				if (ok)
+					*ok = true;
+				value *= s_powersOf10[exponent];
+				return negative ? -value : value;
+			}
+			else if (exponent < 0 && exponent >= -22)
+			{
+				if (ok)
+					*ok = true;
+				value /= s_powersOf10[-exponent];
+				return negative ? -value : value;
+			}
+		}
+
+		// unusual notation: we let Qt do the job
+		return QByteArray::fromRawData(token.begin, static_cast<int>(token.length())).toDouble(ok);
+	}
+
+	//! Converts a token to a float value (same result as QString::toFloat)
+	inline float ToFloat(const Token& token, bool* ok = nullptr)
+	{
+		double value = ToDouble(token, ok);
+		if (std::isfinite(value) && std::abs(value) > static_cast<double>(std::numeric_limits<float>::max()))
+		{
+			if (ok)
+				*ok = false;
+			return value < 0 ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity();
+		}
+		return static_cast<float>(value);
+	}
+
+	//! Converts a token to an integer value (same result as QString::toInt)
+	inline int ToInt(const Token& token, bool* ok = nullptr)
+	{
+		const char* p        = token.begin;
+		bool        negative = false;
+		if (p != token.end && (*p == '-' || *p == '+'))
+		{
+			negative = (*p == '-');
+			++p;
+		}
+
+		if (p != token.end && token.end - p <= 9) // no overflow possible
+		{
+			int value = 0;
+			for (; p != token.end && *p >= '0' && *p <= '9'; ++p)
+			{
+				value = value * 10 + (*p - '0');
+			}
+			if (p == token.end)
+			{
+				if (ok)
+					*ok = true;
+				return negative ? -value : value;
+			}
+		}
+
+		// unusual notation: we let Qt do the job
+		return QByteArray::fromRawData(token.begin, static_cast<int>(token.length())).toInt(ok);
+	}
+
+	//! Splits a text in chunks of (roughly) a given size, starting at the beginning of a line
+	/** \param begin beginning of the text
+	    \param end end of the text
+	    \param chunkSize approximate size of the chunks (in bytes)
+	    \param continuedLines whether lines ending with a backslash continue on the next line (and can't be split)
+	    \return the chunk boundaries (the first one is 'begin' and the last one is 'end')
+	**/
+	inline std::vector<const char*> SplitInChunks(const char* begin, const char* end, size_t chunkSize, bool continuedLines)
+	{
+		std::vector<const char*> boundaries;
+		boundaries.push_back(begin);
+
+		const char* pos = begin;
+		while (static_cast<size_t>(end - pos) > chunkSize)
+		{
+			const char* next = pos + chunkSize;
+			while (true)
+			{
+				const char* eol = static_cast<const char*>(std::memchr(next, '\n', static_cast<size_t>(end - next)));
+				if (!eol)
+				{
+					next = end;
+					break;
+				}
+
+				next = eol + 1;
+				if (continuedLines)
+				{
+					// the line continues on the next one if it ends with a backslash
+					const char* last = eol;
+					if (last != begin && *(last - 1) == '\r')
+					{
+						--last;
+					}
+					if (last != begin && *(last - 1) == '\\')
+					{
+						continue;
+					}
+				}
+				break;
+			}
+
+			if (next == end)
+			{
+				break;
+			}
+			boundaries.push_back(next);
+			pos = next;
+		}
+
+		boundaries.push_back(end);
+		return boundaries;
+	}
+} // namespace AsciiParsingTools
@@ -0,0 +1,34 @@
+#ifndef SBFCOMMAND_H
+#define SBFCOMMAND_H
+
+// ##########################################################################
+// #                                                                        #
+// #                      CLOUDCOMPARE PLUGIN                               #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 of the License.               #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: CloudCompare project                               #
+// #                                                                        #
+// ##########################################################################
+
+#include "ccCommandLineInterface.h"
+
+//! Sets the partial loading options of the SBF files loaded afterwards
+class SBFCommand : public ccCommandLineInterface::Command
+{
+  public:
+	SBFCommand();
+
+	~SBFCommand() override = default;
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
+#endif
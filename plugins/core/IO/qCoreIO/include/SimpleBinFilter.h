@@ -20,6 +20,12 @@
 
 #include "FileIOFilter.h"
 
+// CCCoreLib
+#include <CCGeom.h>
+
+// Qt
+#include <QStringList>
+
 //! Simple binary file (with attached text meta-file)
 class SimpleBinFilter : public FileIOFilter
 {
@@ -31,6 +37,32 @@ class SimpleBinFilter : public FileIOFilter
 
 	bool          canSave(CC_CLASS_ENUM type, bool& multiple, bool& exclusive) const override;
 	CC_FILE_ERROR saveToFile(ccHObject* entity, const QString& filename, const SaveParameters& parameters) override;
+
+  public: // Default / persistent settings
+	//! Partial loading options
+	struct LoadingOptions
+	{
+		//! Index of the first point to load
+		quint64 firstPoint = 0;
+		//! Max number of points to load (0 = all)
+		quint64 maxPointCount = 0;
+		//! Names of the scalar fields to load (all if empty)
+		QStringList scalarFields;
+		//! Whether to only load the points inside a box
+		bool useBox = false;
+		//! Box min corner (in the file coordinate system, i.e. before any Global Shift is applied)
+		CCVector3d boxMin;
+		//! Box max corner (in the file coordinate system, i.e. before any Global Shift is applied)
+		CCVector3d boxMax;
+	};
+
+	//! Sets the partial loading options (applied to all the files loaded afterwards)
+	/** When loading points inside a box, the chunk index of the header file (if any)
+	    is used to skip the chunks of points that are entirely outside of the box.
+	**/
+	static void SetLoadingOptions(const LoadingOptions& options);
+	//! Returns the current partial loading options
+	static const LoadingOptions& GetLoadingOptions();
 };
 
 #endif // CC_SIMPLE_BIN_FILTER_HEADER
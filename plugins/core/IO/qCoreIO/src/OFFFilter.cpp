@@ -35,7 +35,7 @@ OFFFilter::OFFFilter()
                     "off",
                     QStringList{"OFF mesh (*.off)"},
                     QStringList{"OFF mesh (*.off)"},
-                    Import | Export})
+                    Import | Export | ConcurrentLoad})
 {
 }
 
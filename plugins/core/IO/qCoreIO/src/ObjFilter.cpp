@@ -17,6 +17,7 @@
 
 #include "ObjFilter.h"
 
+#include "AsciiParsingTools.h"
 #include "FileIO.h"
 
 // Qt
@@ -28,7 +29,6 @@
 #include <QTextStream>
 
 // qCC_db
-#include <ccChunk.h>
 #include <ccHObjectCaster.h>
 #include <ccLog.h>
 #include <ccMaterial.h>
@@ -44,7 +44,15 @@
 #include <Delaunay2dMesh.h>
 
 // System
+#include <algorithm>
 #include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
 
 ObjFilter::ObjFilter()
     : FileIOFilter({"_OBJ Filter",
@@ -538,17 +546,411 @@ struct facetElement
 	}
 };
 
+namespace
+{
+	using AsciiParsingTools::Token;
+
+	//! Size of the chunks of an OBJ file (processed in parallel)
+	constexpr size_t OBJ_CHUNK_SIZE = (1 << 23); // 8 MB
+
+	//! OBJ record (line) types
+	enum class ObjRecordType : unsigned char
+	{
+		Ignored,
+		Vertex,
+		TexCoord,
+		Normal,
+		Group,
+		Face,
+		MalformedFace,
+		Polyline,
+		UseMaterial,
+		MaterialLib
+	};
+
+	//! Returns the type of an OBJ record (from its first token)
+	ObjRecordType GetObjRecordType(const Token& keyword)
+	{
+		// comments & empty lines
+		if (keyword.empty() || keyword.front() == '/' || keyword.front() == '#')
+			return ObjRecordType::Ignored;
+
+		if (keyword == "v")
+			return ObjRecordType::Vertex;
+		if (keyword == "vt")
+			return ObjRecordType::TexCoord;
+		if (keyword == "vn")
+			return ObjRecordType::Normal;
+		if (keyword == "g" || keyword == "o")
+			return ObjRecordType::Group;
+		if (keyword.front() == 'f')
+			return ObjRecordType::Face;
+		if (keyword.front() == 'l')
+			return ObjRecordType::Polyline;
+		if (keyword == "usemtl")
+			return ObjRecordType::UseMaterial;
+		if (keyword == "mtllib")
+			return ObjRecordType::MaterialLib;
+
+		// shading groups ('s'), etc. are ignored
+		return ObjRecordType::Ignored;
+	}
+
+	//! Reads the next (logical) line of an OBJ file
+	/** Specific case for weird files: lines ending with a backslash continue on the next one.
+	    The resulting line is then stored in 'buffer'.
+	**/
+	Token ReadObjLine(const char*& pos, const char* end, std::string& buffer)
+	{
+		Token line = AsciiParsingTools::ReadLine(pos, end);
+		if (line.empty() || *(line.end - 1) != '\\')
+		{
+			return line;
+		}
+
+		buffer.assign(line.begin, line.end);
+		while (!buffer.empty() && buffer.back() == '\\')
+		{
+			buffer.pop_back();
+			Token nextLine = AsciiParsingTools::ReadLine(pos, end);
+			buffer.append(nextLine.begin, nextLine.end);
+		}
+
+		return {buffer.data(), buffer.data() + buffer.size()};
+	}
+
+	//! Splits an OBJ record in tokens (same as QString::simplified().split(' ', Qt::SkipEmptyParts))
+	void SplitObjRecord(const std::string& record, std::vector<Token>& tokens)
+	{
+		tokens.clear();
+		const char* pos = record.data();
+		const char* end = pos + record.size();
+		for (Token token = AsciiParsingTools::NextToken(pos, end); !token.empty(); token = AsciiParsingTools::NextToken(pos, end))
+		{
+			tokens.push_back(token);
+		}
+	}
+
+	//! Returns the part of a token before the first '/' character (vertex index of a face or polyline element)
+	inline Token ObjElementVertexIndex(const Token& element)
+	{
+		return {element.begin, std::find(element.begin, element.end, '/')};
+	}
+
+	//! Reads the 3 coordinates of a 'v' or 'vn' record
+	bool ReadObjVector(const char* pos, const char* end, CCVector3d& P)
+	{
+		Token x = AsciiParsingTools::NextToken(pos, end);
+		Token y = AsciiParsingTools::NextToken(pos, end);
+		Token z = AsciiParsingTools::NextToken(pos, end);
+		if (z.empty())
+		{
+			// malformed line
+			return false;
+		}
+
+		P = CCVector3d(AsciiParsingTools::ToDouble(x), AsciiParsingTools::ToDouble(y), AsciiParsingTools::ToDouble(z));
+		return true;
+	}
+
+	//! OBJ record that must be processed sequentially (faces, groups, polylines and materials)
+	struct ObjRecord
+	{
+		//! Record type
+		ObjRecordType type;
+		//! Index of the first face element (faces) or of the record text (other records)
+		unsigned first;
+		//! Number of face elements (faces)
+		unsigned count;
+		//! Number of vertices declared before this record
+		int pointsRead;
+		//! Number of texture coordinates declared before this record
+		int texCoordsRead;
+		//! Number of normals declared before this record
+		int normsRead;
+	};
+
+	//! Chunk of an OBJ file (starting at the beginning of a line)
+	struct ObjChunk
+	{
+		const char* begin = nullptr;
+		const char* end   = nullptr;
+
+		//! Number of 'v', 'vt', 'vn' and 'f' records
+		unsigned vertexCount   = 0;
+		unsigned texCoordCount = 0;
+		unsigned normalCount   = 0;
+		unsigned faceCount     = 0;
+
+		//! Global index of the first 'v', 'vt' and 'vn' records
+		unsigned firstVertex   = 0;
+		unsigned firstTexCoord = 0;
+		unsigned firstNormal   = 0;
+
+		//! Face elements (of all the faces of the chunk)
+		std::vector<facetElement> faceElements;
+		//! Records to be processed sequentially
+		std::vector<ObjRecord> records;
+		//! Text of the non-face records
+		std::vector<std::string> texts;
+
+		//! Decoding errors/warnings
+		bool malformed       = false;
+		bool invalidNormals  = false;
+		bool notEnoughMemory = false;
+
+		//! Counts the records of the chunk
+		void countRecords()
+		{
+			std::string buffer;
+			const char* pos = begin;
+			while (pos != end)
+			{
+				Token       line = ReadObjLine(pos, end, buffer);
+				const char* p    = line.begin;
+				switch (GetObjRecordType(AsciiParsingTools::NextToken(p, line.end)))
+				{
+				case ObjRecordType::Vertex:
+					++vertexCount;
+					break;
+				case ObjRecordType::TexCoord:
+					++texCoordCount;
+					break;
+				case ObjRecordType::Normal:
+					++normalCount;
+					break;
+				case ObjRecordType::Face:
+					++faceCount;
+					break;
+				default:
+					break;
+				}
+			}
+		}
+
+		//! Decodes the chunk
+		/** The vertices, texture coordinates and normals are directly stored in the (pre-allocated)
+		    containers. The other records are stored in the chunk (to be processed sequentially).
+		**/
+		void decode(ccPointCloud* vertices, const CCVector3d& Pshift, TextureCoordsContainer* texCoords, NormsIndexesTableType* normals)
+		{
+			try
+			{
+				records.reserve(faceCount);
+				faceElements.reserve(3 * static_cast<size_t>(faceCount));
+
+				unsigned    vIndex  = firstVertex;
+				unsigned    tcIndex = firstTexCoord;
+				unsigned    nIndex  = firstNormal;
+				std::string buffer;
+
+				const char* pos = begin;
+				while (pos != end)
+				{
+					Token         line = ReadObjLine(pos, end, buffer);
+					const char*   p    = line.begin;
+					ObjRecordType type = GetObjRecordType(AsciiParsingTools::NextToken(p, line.end));
+
+					switch (type)
+					{
+					case ObjRecordType::Ignored:
+						break;
+
+					/*** new vertex ***/
+					case ObjRecordType::Vertex:
+					{
+						CCVector3d Pd;
+						if (!ReadObjVector(p, line.end, Pd))
+						{
+							malformed = true;
+							return;
+						}
+						// shifted point
+						*const_cast<CCVector3*>(vertices->getPoint(vIndex++)) = (Pd + Pshift).toPC();
+					}
+					break;
+
+					/*** new vertex texture coordinates ***/
+					case ObjRecordType::TexCoord:
+					{
+						Token tx = AsciiParsingTools::NextToken(p, line.end);
+						if (tx.empty())
+						{
+							malformed = true;
+							return;
+						}
+
+						TexCoords2D T(AsciiParsingTools::ToFloat(tx), 0);
+
+						Token ty = AsciiParsingTools::NextToken(p, line.end);
+						if (!ty.empty()) // OBJ specification allows for only one value!!!
+						{
+							T.ty = AsciiParsingTools::ToFloat(ty);
+						}
+
+						(*texCoords)[tcIndex++] = T;
+					}
+					break;
+
+					/*** new vertex normal ***/
+					case ObjRecordType::Normal: //--> in fact it can also be a facet normal!!!
+					{
+						CCVector3d Nd;
+						if (!ReadObjVector(p, line.end, Nd))
+						{
+							malformed = true;
+							return;
+						}
+
+						CCVector3 N(static_cast<PointCoordinateType>(Nd.x),
+						            static_cast<PointCoordinateType>(Nd.y),
+						            static_cast<PointCoordinateType>(Nd.z));
+
+						if (std::abs(N.norm2d() - 1.0) > 0.005)
+						{
+							invalidNormals = true;
+							N.normalize();
+						}
+
+						(*normals)[nIndex++] = ccNormalVectors::GetNormIndex(N.u); // we don't know yet if it's per-vertex or per-triangle normal...
+					}
+					break;
+
+					/*** new face ***/
+					case ObjRecordType::Face:
+					{
+						ObjRecord record{type, static_cast<unsigned>(faceElements.size()), 0, static_cast<int>(vIndex), static_cast<int>(tcIndex), static_cast<int>(nIndex)};
+
+						// read the face elements (singleton, pair or triplet)
+						bool invalidElement = false;
+						for (Token element = AsciiParsingTools::NextToken(p, line.end); !element.empty(); element = AsciiParsingTools::NextToken(p, line.end))
+						{
+							facetElement fe; //(0,0,0) by default
+
+							Token vToken = ObjElementVertexIndex(element);
+							if (vToken.empty())
+							{
+								invalidElement = true;
+							}
+							else
+							{
+								fe.vIndex = AsciiParsingTools::ToInt(vToken);
+							}
+
+							if (vToken.end != element.end)
+							{
+								Token tcToken = ObjElementVertexIndex({vToken.end + 1, element.end});
+								if (!tcToken.empty())
+									fe.tcIndex = AsciiParsingTools::ToInt(tcToken);
+
+								if (tcToken.end != element.end)
+								{
+									Token nToken = ObjElementVertexIndex({tcToken.end + 1, element.end});
+									if (!nToken.empty())
+										fe.nIndex = AsciiParsingTools::ToInt(nToken);
+								}
+							}
+
+							faceElements.push_back(fe);
+							++record.count;
+						}
+
+						if (record.count < 3)
+						{
+							// malformed line (will be skipped)
+							faceElements.resize(record.first);
+							record.type  = ObjRecordType::MalformedFace;
+							record.count = 0;
+						}
+						else if (invalidElement)
+						{
+							malformed = true;
+							return;
+						}
+
+						records.push_back(record);
+					}
+					break;
+
+					/*** groups, polylines and materials ***/
+					default:
+					{
+						records.push_back({type, static_cast<unsigned>(texts.size()), 0, static_cast<int>(vIndex), static_cast<int>(tcIndex), static_cast<int>(nIndex)});
+						texts.emplace_back(line.begin, line.end);
+					}
+					break;
+					}
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				notEnoughMemory = true;
+			}
+		}
+
+		//! Releases the decoded records
+		void release()
+		{
+			faceElements = std::vector<facetElement>();
+			records      = std::vector<ObjRecord>();
+			texts        = std::vector<std::string>();
+		}
+	};
+
+	//! Reads the first vertex of an OBJ file
+	bool ReadFirstObjVertex(const std::vector<ObjChunk>& chunks, CCVector3d& P)
+	{
+		std::string buffer;
+		for (const ObjChunk& chunk : chunks)
+		{
+			if (chunk.vertexCount == 0)
+			{
+				continue;
+			}
+
+			const char* pos = chunk.begin;
+			while (pos != chunk.end)
+			{
+				Token       line = ReadObjLine(pos, chunk.end, buffer);
+				const char* p    = line.begin;
+				if (GetObjRecordType(AsciiParsingTools::NextToken(p, line.end)) == ObjRecordType::Vertex)
+				{
+					return ReadObjVector(p, line.end, P);
+				}
+			}
+		}
+
+		return false;
+	}
+} // namespace
+
 CC_FILE_ERROR ObjFilter::loadFile(const QString& filename, ccHObject& container, LoadParameters& parameters)
 {
 	ccLog::Print(QString("[OBJ] Loading ") + filename);
 
-	// open file
-	QFile file(filename);
-	if (!file.open(QFile::ReadOnly))
+	// open (map) file
+	AsciiParsingTools::TextFile file;
+	if (!file.open(filename))
 	{
 		return CC_FERR_READING;
 	}
-	QTextStream stream(&file);
+
+	// we split the file in chunks (decoded in parallel)
+	std::vector<ObjChunk> chunks;
+	try
+	{
+		std::vector<const char*> boundaries = AsciiParsingTools::SplitInChunks(file.begin(), file.end(), OBJ_CHUNK_SIZE, true);
+		chunks.resize(boundaries.size() - 1);
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			chunks[i].begin = boundaries[i];
+			chunks[i].end   = boundaries[i + 1];
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
 
 	// current vertex shift
 	CCVector3d Pshift(0, 0, 0);
@@ -601,7 +1003,7 @@ CC_FILE_ERROR ObjFilter::loadFile(const QString& filename, ccHObject& container,
 		pDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
 		pDlg->setMethodTitle(QObject::tr("OBJ file"));
 		pDlg->setInfo(QObject::tr("Loading in progress..."));
-		pDlg->setRange(0, static_cast<int>(file.size()));
+		pDlg->setRange(0, static_cast<int>(chunks.size()));
 		pDlg->show();
 		QApplication::processEvents();
 	}
@@ -620,626 +1022,562 @@ CC_FILE_ERROR ObjFilter::loadFile(const QString& filename, ccHObject& container,
 
 	try
 	{
-		unsigned lineCount   = 0;
-		unsigned polyCount   = 0;
-		QString  currentLine = stream.readLine();
+		const int chunkCount = static_cast<int>(chunks.size());
 
-		while (!currentLine.isNull())
+		// 1st pass: count the records of each chunk
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads()) schedule(dynamic)
+#endif
+		for (int i = 0; i < chunkCount; ++i)
 		{
-			++lineCount;
-			if (pDlg && ((lineCount % 2048) == 0))
-			{
-				if (pDlg->wasCanceled())
-				{
-					error                          = true;
-					objWarnings[CANCELLED_BY_USER] = true;
-					break;
-				}
-				pDlg->setValue(static_cast<int>(file.pos()));
-				QApplication::processEvents();
-			}
-
-			// specific case for weird files
-			while (currentLine.endsWith('\\'))
-			{
-				currentLine.resize(currentLine.length() - 1);
-				currentLine += stream.readLine();
-				++lineCount;
-				if (pDlg && ((lineCount % 2048) == 0))
-				{
-					if (pDlg->wasCanceled())
-					{
-						error                          = true;
-						objWarnings[CANCELLED_BY_USER] = true;
-						break;
-					}
-					pDlg->setValue(static_cast<int>(file.pos()));
-					QApplication::processEvents();
-				}
-			}
+			chunks[i].countRecords();
+		}
 
-			const QStringList tokens = currentLine.simplified().split(QChar(' '), Qt::SkipEmptyParts);
+		unsigned faceCount = 0;
+		for (ObjChunk& chunk : chunks)
+		{
+			chunk.firstVertex   = static_cast<unsigned>(pointsRead);
+			chunk.firstTexCoord = static_cast<unsigned>(texCoordsRead);
+			chunk.firstNormal   = static_cast<unsigned>(normsRead);
+			pointsRead += static_cast<int>(chunk.vertexCount);
+			texCoordsRead += static_cast<int>(chunk.texCoordCount);
+			normsRead += static_cast<int>(chunk.normalCount);
+			faceCount += chunk.faceCount;
+		}
 
-			// skip comments & empty lines
-			if (tokens.empty() || tokens.front().startsWith('/', Qt::CaseInsensitive) || tokens.front().startsWith('#', Qt::CaseInsensitive))
+		// first point: check for 'big' coordinates
+		if (pointsRead != 0)
+		{
+			CCVector3d Pd;
+			if (!ReadFirstObjVertex(chunks, Pd))
 			{
-				currentLine = stream.readLine();
-				continue;
+				objWarnings[INVALID_LINE] = true;
+				error                     = true;
 			}
-
-			/*** new vertex ***/
-			if (tokens.front() == "v")
+			else
 			{
-				// reserve more memory if necessary
-				if (vertices->size() == vertices->capacity())
+				bool preserveCoordinateShift = true;
+				if (HandleGlobalShift(Pd, Pshift, preserveCoordinateShift, parameters))
 				{
-					if (!vertices->reserve(vertices->capacity() + ccChunk::SIZE))
+					if (preserveCoordinateShift)
 					{
-						objWarnings[NOT_ENOUGH_MEMORY] = true;
-						error                          = true;
-						break;
-					}
-				}
-
-				// malformed line?
-				if (tokens.size() < 4)
-				{
-					objWarnings[INVALID_LINE] = true;
-					error                     = true;
-					break;
-				}
-
-				CCVector3d Pd(tokens[1].toDouble(), tokens[2].toDouble(), tokens[3].toDouble());
-
-				// first point: check for 'big' coordinates
-				if (pointsRead == 0)
-				{
-					bool preserveCoordinateShift = true;
-					if (HandleGlobalShift(Pd, Pshift, preserveCoordinateShift, parameters))
-					{
-						if (preserveCoordinateShift)
-						{
-							vertices->setGlobalShift(Pshift);
-						}
-						ccLog::Warning("[OBJ] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", Pshift.x, Pshift.y, Pshift.z);
+						vertices->setGlobalShift(Pshift);
 					}
+					ccLog::Warning("[OBJ] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", Pshift.x, Pshift.y, Pshift.z);
 				}
+			}
+		}
 
-				// shifted point
-				CCVector3 P = (Pd + Pshift).toPC();
-				vertices->addPoint(P);
-				++pointsRead;
+		// we can now allocate all the containers
+		if (!error)
+		{
+			if (!vertices->resize(static_cast<unsigned>(pointsRead))
+			    || (faceCount > baseMesh->capacity() && !baseMesh->reserve(faceCount)))
+			{
+				objWarnings[NOT_ENOUGH_MEMORY] = true;
+				error                          = true;
 			}
-			/*** new vertex texture coordinates ***/
-			else if (tokens.front() == "vt")
+			else
 			{
-				// create and reserve memory for tex. coords container if necessary
-				if (!texCoords)
+				if (texCoordsRead != 0)
 				{
 					texCoords = new TextureCoordsContainer();
 					texCoords->link();
+					texCoords->resize(static_cast<size_t>(texCoordsRead));
 				}
-				if (texCoords->currentSize() == texCoords->capacity())
-				{
-					if (!texCoords->reserveSafe(texCoords->capacity() + ccChunk::SIZE))
-					{
-						objWarnings[NOT_ENOUGH_MEMORY] = true;
-						error                          = true;
-						break;
-					}
-				}
-
-				// malformed line?
-				if (tokens.size() < 2)
-				{
-					objWarnings[INVALID_LINE] = true;
-					error                     = true;
-					break;
-				}
-
-				TexCoords2D T(tokens[1].toFloat(), 0);
-
-				if (tokens.size() > 2) // OBJ specification allows for only one value!!!
-				{
-					T.ty = tokens[2].toFloat();
-				}
-
-				texCoords->addElement(T);
-				++texCoordsRead;
-			}
-			/*** new vertex normal ***/
-			else if (tokens.front() == "vn") //--> in fact it can also be a facet normal!!!
-			{
-				// create and reserve memory for normals container if necessary
-				if (!normals)
+				if (normsRead != 0)
 				{
 					normals = new NormsIndexesTableType;
 					normals->link();
+					normals->resize(static_cast<size_t>(normsRead));
 				}
-				if (normals->currentSize() == normals->capacity())
-				{
-					if (!normals->reserveSafe(normals->capacity() + ccChunk::SIZE))
-					{
-						objWarnings[NOT_ENOUGH_MEMORY] = true;
-						error                          = true;
-						break;
-					}
-				}
+			}
+		}
 
-				// malformed line?
-				if (tokens.size() < 4)
-				{
-					objWarnings[INVALID_LINE] = true;
-					error                     = true;
-					break;
-				}
+		// 2nd pass: the chunks are decoded in parallel (by groups of a few chunks), and the
+		// faces, groups, polylines and materials are then processed sequentially (in order)
+		int groupSize = 1;
+#if defined(_OPENMP)
+		groupSize = 2 * omp_get_max_threads();
+#endif
 
-				CCVector3 N(static_cast<PointCoordinateType>(tokens[1].toDouble()),
-				            static_cast<PointCoordinateType>(tokens[2].toDouble()),
-				            static_cast<PointCoordinateType>(tokens[3].toDouble()));
+		unsigned                  polyCount = 0;
+		std::vector<facetElement> currentFace;
+		std::vector<Token>        tokens;
 
-				if (std::abs(N.norm2d() - 1.0) > 0.005)
-				{
-					objWarnings[INVALID_NORMALS] = true;
-					N.normalize();
-				}
-				CompressedNormType nIndex = ccNormalVectors::GetNormIndex(N.u);
+		for (int groupStart = 0; !error && groupStart < chunkCount; groupStart += groupSize)
+		{
+			const int groupEnd = std::min(groupStart + groupSize, chunkCount);
 
-				normals->addElement(nIndex); // we don't know yet if it's per-vertex or per-triangle normal...
-				++normsRead;
-			}
-			/*** new group ***/
-			else if (tokens.front() == "g" || tokens.front() == "o")
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads()) schedule(dynamic)
+#endif
+			for (int i = groupStart; i < groupEnd; ++i)
 			{
-				// update new group index
-				facesRead = 0;
-				// get the group name
-				QString groupName = (tokens.size() > 1 && !tokens[1].isEmpty() ? tokens[1] : "default");
-				for (int i = 2; i < tokens.size(); ++i) // multiple parts?
-					groupName.append(QString(" ") + tokens[i]);
-				// push previous group descriptor (if none was pushed)
-				if (groups.empty() && totalFacesRead > 0)
-					groups.emplace_back(0, "default");
-				// push new group descriptor
-				if (!groups.empty() && groups.back().first == totalFacesRead)
-					groups.back().second = groupName; // simply replace the group name if the previous group was empty!
-				else
-					groups.emplace_back(totalFacesRead, groupName);
-				polyCount = 0; // restart polyline count at 0!
+				chunks[i].decode(vertices, Pshift, texCoords, normals);
 			}
-			/*** new face ***/
-			else if (tokens.front().startsWith('f'))
+
+			for (int i = groupStart; !error && i < groupEnd; ++i)
 			{
-				// malformed line?
-				if (tokens.size() < 4)
+				ObjChunk& chunk = chunks[i];
+				if (chunk.invalidNormals)
 				{
-					objWarnings[INVALID_LINE] = true;
-					currentLine               = stream.readLine();
-					continue;
-					// error = true;
-					// break;
+					objWarnings[INVALID_NORMALS] = true;
 				}
 
-				// read the face elements (singleton, pair or triplet)
-				std::vector<facetElement> currentFace;
+				for (const ObjRecord& record : chunk.records)
 				{
-					currentFace.reserve(tokens.size() - 1);
-					for (int i = 1; i < tokens.size(); ++i)
+					switch (record.type)
 					{
-						QStringList vertexTokens = tokens[i].split('/');
-						if (vertexTokens.empty() || vertexTokens[0].isEmpty())
-						{
-							objWarnings[INVALID_LINE] = true;
-							error                     = true;
-							break;
-						}
+					/*** new group ***/
+					case ObjRecordType::Group:
+					{
+						SplitObjRecord(chunk.texts[record.first], tokens);
+
+						// update new group index
+						facesRead = 0;
+						// get the group name
+						QString groupName = (tokens.size() > 1 ? tokens[1].toString() : "default");
+						for (size_t j = 2; j < tokens.size(); ++j) // multiple parts?
+							groupName.append(QString(" ") + tokens[j].toString());
+						// push previous group descriptor (if none was pushed)
+						if (groups.empty() && totalFacesRead > 0)
+							groups.emplace_back(0, "default");
+						// push new group descriptor
+						if (!groups.empty() && groups.back().first == totalFacesRead)
+							groups.back().second = groupName; // simply replace the group name if the previous group was empty!
 						else
-						{
-							// new vertex
-							facetElement fe; //(0,0,0) by default
-
-							fe.vIndex = vertexTokens[0].toInt();
-							if (vertexTokens.size() > 1 && !vertexTokens[1].isEmpty())
-								fe.tcIndex = vertexTokens[1].toInt();
-							if (vertexTokens.size() > 2 && !vertexTokens[2].isEmpty())
-								fe.nIndex = vertexTokens[2].toInt();
-
-							currentFace.push_back(fe);
-						}
+							groups.emplace_back(totalFacesRead, groupName);
+						polyCount = 0; // restart polyline count at 0!
 					}
-				}
-
-				if (error)
 					break;
 
-				if (currentFace.size() < 3)
-				{
-					ccLog::Warning("[OBJ] Malformed file: polygon on line %1 has less than 3 vertices!", lineCount);
-					error = true;
+					/*** malformed face (skipped) ***/
+					case ObjRecordType::MalformedFace:
+					{
+						objWarnings[INVALID_LINE] = true;
+					}
 					break;
-				}
 
-				// first vertex
-				std::vector<facetElement>::iterator A = currentFace.begin();
-
-				// the very first vertex of the group tells us about the whole sequence
-				if (facesRead == 0)
-				{
-					// we have a tex. coord index as second vertex element!
-					if (!hasTexCoords && A->tcIndex != 0 && !materialsLoadFailed)
+					/*** new face ***/
+					case ObjRecordType::Face:
 					{
-						if (!baseMesh->reservePerTriangleTexCoordIndexes())
-						{
-							objWarnings[NOT_ENOUGH_MEMORY] = true;
-							error                          = true;
-							break;
-						}
-						for (unsigned int i = 0; i < totalFacesRead; ++i)
-							baseMesh->addTriangleTexCoordIndexes(-1, -1, -1);
+						currentFace.assign(chunk.faceElements.begin() + record.first, chunk.faceElements.begin() + record.first + record.count);
 
-						hasTexCoords = true;
-					}
+						// first vertex
+						std::vector<facetElement>::iterator A = currentFace.begin();
 
-					// we have a normal index as third vertex element!
-					if (!normalsPerFacet && A->nIndex != 0)
-					{
-						// so the normals are 'per-facet'
-						if (!baseMesh->reservePerTriangleNormalIndexes())
+						// the very first vertex of the group tells us about the whole sequence
+						if (facesRead == 0)
 						{
-							objWarnings[NOT_ENOUGH_MEMORY] = true;
-							error                          = true;
-							break;
-						}
-						for (unsigned int i = 0; i < totalFacesRead; ++i)
-							baseMesh->addTriangleNormalIndexes(-1, -1, -1);
-						normalsPerFacet = true;
-					}
-				}
+							// we have a tex. coord index as second vertex element!
+							if (!hasTexCoords && A->tcIndex != 0 && !materialsLoadFailed)
+							{
+								if (!baseMesh->reservePerTriangleTexCoordIndexes())
+								{
+									objWarnings[NOT_ENOUGH_MEMORY] = true;
+									error                          = true;
+									break;
+								}
+								for (unsigned int j = 0; j < totalFacesRead; ++j)
+									baseMesh->addTriangleTexCoordIndexes(-1, -1, -1);
 
-				// we process all vertices accordingly
-				for (facetElement& vertex : currentFace)
-				{
-					// vertex index
-					{
-						if (!vertex.updatePointIndex(pointsRead))
-						{
-							objWarnings[INVALID_INDEX] = true;
-							error                      = true;
-							break;
-						}
-						if (vertex.vIndex > maxVertexIndex)
-							maxVertexIndex = vertex.vIndex;
-					}
-					// should we have a tex. coord index as second vertex element?
-					if (hasTexCoords && currentMaterialDefined)
-					{
-						if (!vertex.updateTexCoordIndex(texCoordsRead))
-						{
-							objWarnings[INVALID_INDEX] = true;
-							error                      = true;
-							break;
-						}
-						if (vertex.tcIndex > maxTexCoordIndex)
-							maxTexCoordIndex = vertex.tcIndex;
-					}
+								hasTexCoords = true;
+							}
 
-					// should we have a normal index as third vertex element?
-					if (normalsPerFacet)
-					{
-						if (!vertex.updateNormalIndex(normsRead))
-						{
-							objWarnings[INVALID_INDEX] = true;
-							error                      = true;
-							break;
+							// we have a normal index as third vertex element!
+							if (!normalsPerFacet && A->nIndex != 0)
+							{
+								// so the normals are 'per-facet'
+								if (!baseMesh->reservePerTriangleNormalIndexes())
+								{
+									objWarnings[NOT_ENOUGH_MEMORY] = true;
+									error                          = true;
+									break;
+								}
+								for (unsigned int j = 0; j < totalFacesRead; ++j)
+									baseMesh->addTriangleNormalIndexes(-1, -1, -1);
+								normalsPerFacet = true;
+							}
 						}
-						if (vertex.nIndex > maxTriNormIndex)
-							maxTriNormIndex = vertex.nIndex;
-					}
-				}
 
-				// don't forget material (common for all vertices)
-				if (currentMaterialDefined && !materialsLoadFailed)
-				{
-					if (!hasMaterial)
-					{
-						if (!baseMesh->reservePerTriangleMtlIndexes())
+						// we process all vertices accordingly
+						for (facetElement& vertex : currentFace)
 						{
-							objWarnings[NOT_ENOUGH_MEMORY] = true;
-							error                          = true;
-							break;
-						}
-						for (unsigned int i = 0; i < totalFacesRead; ++i)
-							baseMesh->addTriangleMtlIndex(-1);
-
-						hasMaterial = true;
-					}
-				}
-
-				if (error)
-					break;
+							// vertex index
+							{
+								if (!vertex.updatePointIndex(record.pointsRead))
+								{
+									objWarnings[INVALID_INDEX] = true;
+									error                      = true;
+									break;
+								}
+								if (vertex.vIndex > maxVertexIndex)
+									maxVertexIndex = vertex.vIndex;
+							}
+							// should we have a tex. coord index as second vertex element?
+							if (hasTexCoords && currentMaterialDefined)
+							{
+								if (!vertex.updateTexCoordIndex(record.texCoordsRead))
+								{
+									objWarnings[INVALID_INDEX] = true;
+									error                      = true;
+									break;
+								}
+								if (vertex.tcIndex > maxTexCoordIndex)
+									maxTexCoordIndex = vertex.tcIndex;
+							}
 
-				// Now, let's tesselate the whole polygon
-				bool shouldTesselate = (currentFace.size() > 4 && vertices);
-				if (shouldTesselate)
-				{
-					for (const facetElement& fe : currentFace)
-					{
-						if (fe.vIndex < 0 || vertices->size() <= static_cast<unsigned>(fe.vIndex))
-						{
-							// we haven't loaded all the vertices?! Too bad, we can't tesselate properly :(
-							ccLog::Warning("[OBJ] Failed to tesselate face");
-							shouldTesselate = false;
-							break;
+							// should we have a normal index as third vertex element?
+							if (normalsPerFacet)
+							{
+								if (!vertex.updateNormalIndex(record.normsRead))
+								{
+									objWarnings[INVALID_INDEX] = true;
+									error                      = true;
+									break;
+								}
+								if (vertex.nIndex > maxTriNormIndex)
+									maxTriNormIndex = vertex.nIndex;
+							}
 						}
-					}
-				}
-				if (shouldTesselate)
-				{
-					try
-					{
-						CCCoreLib::PointCloud contour;
-						contour.reserve(static_cast<unsigned>(currentFace.size()));
 
-						for (const facetElement& fe : currentFace)
-						{
-							contour.addPoint(*vertices->getPoint(fe.vIndex));
-						}
-						CCCoreLib::Delaunay2dMesh* dMesh = CCCoreLib::Delaunay2dMesh::TesselateContour(&contour);
-						if (dMesh)
+						// don't forget material (common for all vertices)
+						if (currentMaterialDefined && !materialsLoadFailed)
 						{
-							// need more space?
-							unsigned triCount = dMesh->size();
-							if (baseMesh->size() + triCount >= baseMesh->capacity())
+							if (!hasMaterial)
 							{
-								if (!baseMesh->reserve(baseMesh->size() + std::max(triCount, 4096u)))
+								if (!baseMesh->reservePerTriangleMtlIndexes())
 								{
 									objWarnings[NOT_ENOUGH_MEMORY] = true;
 									error                          = true;
 									break;
 								}
+								for (unsigned int j = 0; j < totalFacesRead; ++j)
+									baseMesh->addTriangleMtlIndex(-1);
+
+								hasMaterial = true;
 							}
+						}
+
+						if (error)
+							break;
 
-							// push new triangle
-							const int* _triIndexes = dMesh->getTriangleVertIndexesArray();
-							// determine if the triangles must be flipped or not
-							bool flip = false;
+						// Now, let's tesselate the whole polygon
+						bool shouldTesselate = (currentFace.size() > 4);
+						if (shouldTesselate)
+						{
+							for (const facetElement& fe : currentFace)
+							{
+								if (fe.vIndex < 0 || record.pointsRead <= fe.vIndex)
+								{
+									// we haven't loaded all the vertices?! Too bad, we can't tesselate properly :(
+									ccLog::Warning("[OBJ] Failed to tesselate face");
+									shouldTesselate = false;
+									break;
+								}
+							}
+						}
+						if (shouldTesselate)
+						{
+							try
 							{
-								for (unsigned i = 0; i < triCount; ++i, _triIndexes += 3)
+								CCCoreLib::PointCloud contour;
+								contour.reserve(static_cast<unsigned>(currentFace.size()));
+
+								for (const facetElement& fe : currentFace)
+								{
+									contour.addPoint(*vertices->getPoint(fe.vIndex));
+								}
+								CCCoreLib::Delaunay2dMesh* dMesh = CCCoreLib::Delaunay2dMesh::TesselateContour(&contour);
+								if (dMesh)
 								{
-									int i1 = _triIndexes[0];
-									int i2 = _triIndexes[1];
-									int i3 = _triIndexes[2];
-									// by definition the first edge of the original polygon
-									// should be in the same 'direction' of the triangle that uses it
-									if ((i1 == 0 || i2 == 0 || i3 == 0)
-									    && (i1 == 1 || i2 == 1 || i3 == 1))
+									// need more space?
+									unsigned triCount = dMesh->size();
+									if (baseMesh->size() + triCount >= baseMesh->capacity())
 									{
-										if ((i1 == 1 && i2 == 0)
-										    || (i2 == 1 && i3 == 0)
-										    || (i3 == 1 && i1 == 0))
+										if (!baseMesh->reserve(baseMesh->size() + std::max({triCount, baseMesh->size() / 2, 4096u})))
 										{
-											flip = true;
+											objWarnings[NOT_ENOUGH_MEMORY] = true;
+											error                          = true;
+											break;
 										}
-										break;
 									}
+
+									// push new triangle
+									const int* _triIndexes = dMesh->getTriangleVertIndexesArray();
+									// determine if the triangles must be flipped or not
+									bool flip = false;
+									{
+										for (unsigned j = 0; j < triCount; ++j, _triIndexes += 3)
+										{
+											int i1 = _triIndexes[0];
+											int i2 = _triIndexes[1];
+											int i3 = _triIndexes[2];
+											// by definition the first edge of the original polygon
+											// should be in the same 'direction' of the triangle that uses it
+											if ((i1 == 0 || i2 == 0 || i3 == 0)
+											    && (i1 == 1 || i2 == 1 || i3 == 1))
+											{
+												if ((i1 == 1 && i2 == 0)
+												    || (i2 == 1 && i3 == 0)
+												    || (i3 == 1 && i1 == 0))
+												{
+													flip = true;
+												}
+												break;
+											}
+										}
+									}
+
+									_triIndexes = dMesh->getTriangleVertIndexesArray();
+									for (unsigned j = 0; j < triCount; ++j, _triIndexes += 3)
+									{
+										const facetElement& f1 = currentFace[_triIndexes[0]];
+										facetElement        f2 = currentFace[_triIndexes[1]];
+										facetElement        f3 = currentFace[_triIndexes[2]];
+
+										if (flip)
+											std::swap(f2, f3);
+
+										baseMesh->addTriangle(f1.vIndex, f2.vIndex, f3.vIndex);
+
+										if (hasMaterial)
+											baseMesh->addTriangleMtlIndex(currentMaterial);
+
+										if (hasTexCoords)
+											baseMesh->addTriangleTexCoordIndexes(f1.tcIndex, f2.tcIndex, f3.tcIndex);
+
+										if (normalsPerFacet)
+											baseMesh->addTriangleNormalIndexes(f1.nIndex, f2.nIndex, f3.nIndex);
+
+										++facesRead;
+										++totalFacesRead;
+									}
+
+									delete dMesh;
+									dMesh = nullptr;
+								}
+								else
+								{
+									ccLog::Warning("[OBJ] Failed to tesselate face");
+									shouldTesselate = false;
 								}
 							}
-
-							_triIndexes = dMesh->getTriangleVertIndexesArray();
-							for (unsigned i = 0; i < triCount; ++i, _triIndexes += 3)
+							catch (const std::bad_alloc&)
 							{
-								const facetElement& f1 = currentFace[_triIndexes[0]];
-								facetElement        f2 = currentFace[_triIndexes[1]];
-								facetElement        f3 = currentFace[_triIndexes[2]];
+								// not enough memory to tesselate!
+								shouldTesselate = false;
+							}
+						}
 
-								if (flip)
-									std::swap(f2, f3);
+						if (!shouldTesselate)
+						{
+							std::vector<facetElement>::const_iterator B = A + 1;
+							std::vector<facetElement>::const_iterator C = B + 1;
+							for (; C != currentFace.end(); ++B, ++C)
+							{
+								// need more space?
+								if (baseMesh->size() == baseMesh->capacity())
+								{
+									if (!baseMesh->reserve(baseMesh->size() + std::max(baseMesh->size() / 2, 4096u)))
+									{
+										objWarnings[NOT_ENOUGH_MEMORY] = true;
+										error                          = true;
+										break;
+									}
+								}
 
-								baseMesh->addTriangle(f1.vIndex, f2.vIndex, f3.vIndex);
+								// push new triangle
+								baseMesh->addTriangle(A->vIndex, B->vIndex, C->vIndex);
+								++facesRead;
+								++totalFacesRead;
 
 								if (hasMaterial)
 									baseMesh->addTriangleMtlIndex(currentMaterial);
 
 								if (hasTexCoords)
-									baseMesh->addTriangleTexCoordIndexes(f1.tcIndex, f2.tcIndex, f3.tcIndex);
+									baseMesh->addTriangleTexCoordIndexes(A->tcIndex, B->tcIndex, C->tcIndex);
 
 								if (normalsPerFacet)
-									baseMesh->addTriangleNormalIndexes(f1.nIndex, f2.nIndex, f3.nIndex);
-
-								++facesRead;
-								++totalFacesRead;
+									baseMesh->addTriangleNormalIndexes(A->nIndex, B->nIndex, C->nIndex);
 							}
+						}
+					}
+					break;
 
-							delete dMesh;
-							dMesh = nullptr;
+					/*** polyline ***/
+					case ObjRecordType::Polyline:
+					{
+						SplitObjRecord(chunk.texts[record.first], tokens);
+
+						// malformed line?
+						if (tokens.size() < 3)
+						{
+							objWarnings[INVALID_LINE] = true;
+							break;
 						}
-						else
+
+						// read the face elements (singleton, pair or triplet)
+						ccPolyline* polyline = new ccPolyline(vertices);
+						if (!polyline->reserve(static_cast<unsigned>(tokens.size() - 1)))
 						{
-							ccLog::Warning("[OBJ] Failed to tesselate face");
-							shouldTesselate = false;
+							// not enough memory
+							objWarnings[NOT_ENOUGH_MEMORY] = true;
+							delete polyline;
+							polyline = nullptr;
+							break;
 						}
-					}
-					catch (const std::bad_alloc&)
-					{
-						// not enough memory to tesselate!
-						shouldTesselate = false;
-					}
-				}
 
-				if (!shouldTesselate)
-				{
-					std::vector<facetElement>::const_iterator B = A + 1;
-					std::vector<facetElement>::const_iterator C = B + 1;
-					for (; C != currentFace.end(); ++B, ++C)
-					{
-						// need more space?
-						if (baseMesh->size() == baseMesh->capacity())
+						for (size_t j = 1; j < tokens.size(); ++j)
 						{
-							if (!baseMesh->reserve(baseMesh->size() + 4096))
+							// get next polyline's vertex index
+							Token vToken = ObjElementVertexIndex(tokens[j]);
+							if (vToken.empty())
 							{
-								objWarnings[NOT_ENOUGH_MEMORY] = true;
-								error                          = true;
+								objWarnings[INVALID_LINE] = true;
+								error                     = true;
 								break;
 							}
-						}
-
-						// push new triangle
-						baseMesh->addTriangle(A->vIndex, B->vIndex, C->vIndex);
-						++facesRead;
-						++totalFacesRead;
+							else
+							{
+								int index = AsciiParsingTools::ToInt(vToken); // we ignore normal index (if any!)
+								if (!UpdatePointIndex(index, record.pointsRead))
+								{
+									objWarnings[INVALID_INDEX] = true;
+									error                      = true;
+									break;
+								}
 
-						if (hasMaterial)
-							baseMesh->addTriangleMtlIndex(currentMaterial);
+								polyline->addPointIndex(index);
+							}
+						}
 
-						if (hasTexCoords)
-							baseMesh->addTriangleTexCoordIndexes(A->tcIndex, B->tcIndex, C->tcIndex);
+						if (error)
+						{
+							delete polyline;
+							polyline = nullptr;
+							break;
+						}
 
-						if (normalsPerFacet)
-							baseMesh->addTriangleNormalIndexes(A->nIndex, B->nIndex, C->nIndex);
+						polyline->setVisible(true);
+						QString name = groups.empty() ? QString("Line") : groups.back().second + QString(".line");
+						polyline->setName(QString("%1 %2").arg(name).arg(++polyCount));
+						vertices->addChild(polyline);
 					}
-				}
-			}
-			/*** polyline ***/
-			else if (tokens.front().startsWith('l'))
-			{
-				// malformed line?
-				if (tokens.size() < 3)
-				{
-					objWarnings[INVALID_LINE] = true;
-					currentLine               = stream.readLine();
-					continue;
-				}
-
-				// read the face elements (singleton, pair or triplet)
-				ccPolyline* polyline = new ccPolyline(vertices);
-				if (!polyline->reserve(static_cast<unsigned>(tokens.size() - 1)))
-				{
-					// not enough memory
-					objWarnings[NOT_ENOUGH_MEMORY] = true;
-					delete polyline;
-					polyline    = nullptr;
-					currentLine = stream.readLine();
-					continue;
-				}
+					break;
 
-				for (int i = 1; i < tokens.size(); ++i)
-				{
-					// get next polyline's vertex index
-					QStringList vertexTokens = tokens[i].split('/');
-					if (vertexTokens.empty() || vertexTokens[0].isEmpty())
+					/*** material ***/
+					case ObjRecordType::UseMaterial: // see 'MTL file' below
 					{
-						objWarnings[INVALID_LINE] = true;
-						error                     = true;
-						break;
+						if (materials) // otherwise we have failed to load MTL file!!!
+						{
+							// DGM: in case there's space characters in the material name, we must read it again from the original line buffer
+							QString mtlName        = QString::fromStdString(chunk.texts[record.first]).mid(7).trimmed();
+							currentMaterial        = (!mtlName.isEmpty() ? materials->findMaterialByName(mtlName) : -1);
+							currentMaterialDefined = true;
+						}
 					}
-					else
+					break;
+
+					/*** material file (MTL) ***/
+					case ObjRecordType::MaterialLib:
 					{
-						int index = vertexTokens[0].toInt(); // we ignore normal index (if any!)
-						if (!UpdatePointIndex(index, pointsRead))
+						SplitObjRecord(chunk.texts[record.first], tokens);
+
+						// malformed line?
+						if (tokens.size() < 2)
 						{
-							objWarnings[INVALID_INDEX] = true;
-							error                      = true;
+							objWarnings[INVALID_LINE] = true;
 							break;
 						}
 
-						polyline->addPointIndex(index);
-					}
-				}
+						// we build the whole MTL filename + path
+						// DGM: in case there's space characters in the filename, we must read it again from the original line buffer
+						QString mtlFilename = QString::fromStdString(chunk.texts[record.first]).mid(7).trimmed();
+						// remove any quotes around the filename (Photoscan 1.4 bug)
+						if (mtlFilename.startsWith("\""))
+						{
+							mtlFilename = mtlFilename.right(mtlFilename.size() - 1);
+						}
+						if (mtlFilename.endsWith("\""))
+						{
+							mtlFilename = mtlFilename.left(mtlFilename.size() - 1);
+						}
+						ccLog::Print(QString("[OBJ] Material file: ") + mtlFilename);
 
-				if (error)
-				{
-					delete polyline;
-					polyline = nullptr;
+						// we try to load it
+						if (!materials)
+						{
+							materials = new ccMaterialSet("materials");
+							materials->link();
+						}
+						size_t oldSize = materials->size();
+
+						QStringList errors;
+						QString     mtlPath = QFileInfo(filename).absolutePath();
+						if (ccMaterialSet::ParseMTL(mtlPath, mtlFilename, *materials, errors))
+						{
+							ccLog::Print("[OBJ] %zu materials loaded", materials->size() - oldSize);
+							materialsLoadFailed = false;
+						}
+						else
+						{
+							ccLog::Error(QString("[OBJ] Failed to load material file! (should be in '%1')").arg(mtlPath + '/' + QString(mtlFilename)));
+							materialsLoadFailed = true;
+						}
+
+						if (!errors.empty())
+						{
+							for (int j = 0; j < errors.size(); ++j)
+								ccLog::Warning(QString("[OBJ::Load::MTL parser] ") + errors[j]);
+						}
+						if (materials->empty())
+						{
+							materials->release();
+							materials           = nullptr;
+							materialsLoadFailed = true;
+						}
+					}
 					break;
+
+					default:
+						break;
+					}
+
+					if (error)
+						break;
 				}
 
-				polyline->setVisible(true);
-				QString name = groups.empty() ? QString("Line") : groups.back().second + QString(".line");
-				polyline->setName(QString("%1 %2").arg(name).arg(++polyCount));
-				vertices->addChild(polyline);
-			}
-			/*** material ***/
-			else if (tokens.front() == "usemtl") // see 'MTL file' below
-			{
-				if (materials) // otherwise we have failed to load MTL file!!!
+				// the chunk decoding stops at the first (fatal) error
+				if (!error && chunk.notEnoughMemory)
 				{
-					QString mtlName = currentLine.mid(7).trimmed();
-					// DGM: in case there's space characters in the material name, we must read it again from the original line buffer
-					// QString mtlName = (tokens.size() > 1 && !tokens[1].isEmpty() ? tokens[1] : "");
-					currentMaterial        = (!mtlName.isEmpty() ? materials->findMaterialByName(mtlName) : -1);
-					currentMaterialDefined = true;
+					objWarnings[NOT_ENOUGH_MEMORY] = true;
+					error                          = true;
 				}
-			}
-			/*** material file (MTL) ***/
-			else if (tokens.front() == "mtllib")
-			{
-				// malformed line?
-				if (tokens.size() < 2 || tokens[1].isEmpty())
+				else if (!error && chunk.malformed)
 				{
 					objWarnings[INVALID_LINE] = true;
+					error                     = true;
 				}
-				else
-				{
-					// we build the whole MTL filename + path
-					// DGM: in case there's space characters in the filename, we must read it again from the original line buffer
-					// QString mtlFilename = tokens[1];
-					QString mtlFilename = currentLine.mid(7).trimmed();
-					// remove any quotes around the filename (Photoscan 1.4 bug)
-					if (mtlFilename.startsWith("\""))
-					{
-						mtlFilename = mtlFilename.right(mtlFilename.size() - 1);
-					}
-					if (mtlFilename.endsWith("\""))
-					{
-						mtlFilename = mtlFilename.left(mtlFilename.size() - 1);
-					}
-					ccLog::Print(QString("[OBJ] Material file: ") + mtlFilename);
-
-					// we try to load it
-					if (!materials)
-					{
-						materials = new ccMaterialSet("materials");
-						materials->link();
-					}
-					size_t oldSize = materials->size();
 
-					QStringList errors;
-					QString     mtlPath = QFileInfo(filename).absolutePath();
-					if (ccMaterialSet::ParseMTL(mtlPath, mtlFilename, *materials, errors))
-					{
-						ccLog::Print("[OBJ] %zu materials loaded", materials->size() - oldSize);
-						materialsLoadFailed = false;
-					}
-					else
-					{
-						ccLog::Error(QString("[OBJ] Failed to load material file! (should be in '%1')").arg(mtlPath + '/' + QString(mtlFilename)));
-						materialsLoadFailed = true;
-					}
+				chunk.release();
+			}
 
-					if (!errors.empty())
-					{
-						for (int i = 0; i < errors.size(); ++i)
-							ccLog::Warning(QString("[OBJ::Load::MTL parser] ") + errors[i]);
-					}
-					if (materials->empty())
-					{
-						materials->release();
-						materials           = nullptr;
-						materialsLoadFailed = true;
-					}
+			if (pDlg)
+			{
+				if (pDlg->wasCanceled())
+				{
+					error                          = true;
+					objWarnings[CANCELLED_BY_USER] = true;
+					break;
 				}
+				pDlg->setValue(groupEnd);
+				QApplication::processEvents();
 			}
-			///*** shading group ***/
-			// else if (tokens.front() == "s")
-			//{
-			//	//ignored!
-			// }
-
-			if (error)
-				break;
-
-			currentLine = stream.readLine();
 		}
+
+		vertices->invalidateBoundingBox();
 	}
 	catch (const std::bad_alloc&)
 	{
@@ -1248,8 +1586,6 @@ CC_FILE_ERROR ObjFilter::loadFile(const QString& filename, ccHObject& container,
 		error                          = true;
 	}
 
-	file.close();
-
 	// 1st check
 	if (!error && pointsRead == 0)
 	{
@@ -17,6 +17,8 @@
 
 #include "PTXFilter.h"
 
+#include "AsciiParsingTools.h"
+
 // qCC_db
 #include <ccColorScalesManager.h>
 #include <ccGBLSensor.h>
@@ -27,12 +29,23 @@
 #include <ccScalarField.h>
 
 // Qt
+#include <QApplication>
+#include <QByteArray>
 #include <QMessageBox>
-#include <QTextStream>
 
 // System
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <string>
+#include <vector>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
 
 const char CC_PTX_INTENSITY_FIELD_NAME[] = "Intensity";
 
@@ -43,7 +56,7 @@ PTXFilter::PTXFilter()
                     "ptx",
                     QStringList{"PTX cloud (*.ptx)"},
                     QStringList(),
-                    Import})
+                    Import | ConcurrentLoad})
 {
 }
 
@@ -87,432 +100,845 @@ static void CleanMatrix(ccGLMatrixd& mat)
 	}
 }
 
-CC_FILE_ERROR PTXFilter::loadFile(const QString&  filename,
-                                  ccHObject&      container,
-                                  LoadParameters& parameters)
+namespace
 {
-	// open ASCII file for reading
-	QFile file(filename);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-	{
-		return CC_FERR_READING;
-	}
+	using AsciiParsingTools::Token;
 
-	QTextStream inFile(&file);
+	//! Number of grid cells (lines) per chunk (chunks are decoded in parallel)
+	constexpr unsigned PTX_CHUNK_CELL_COUNT = (1 << 18);
 
-	CCVector3d PshiftTrans(0, 0, 0);
-	CCVector3d PshiftCloud(0, 0, 0);
-	bool       preserveCoordinateShift = true;
+	//! Max number of grid cells decoded at once (small scans are decoded concurrently)
+	/** Each scan is first loaded with all its grid cells (including the invalid ones), so this also
+	    bounds the memory overhead.
+	**/
+	constexpr size_t PTX_BATCH_CELL_COUNT = (1 << 25);
 
-	CC_FILE_ERROR result       = CC_FERR_NO_LOAD;
-	ScalarType    minIntensity = 0;
-	ScalarType    maxIntensity = 0;
+	//! Chunk of the grid cells of a PTX scan
+	struct PTXChunk
+	{
+		//! Beginning of the first line
+		const char* begin = nullptr;
+		//! End of the last line
+		const char* end = nullptr;
+		//! Index of the first grid cell
+		unsigned firstCell = 0;
+		//! Number of grid cells (lines)
+		unsigned cellCount = 0;
+		//! Number of valid points
+		unsigned validCount = 0;
+		//! Whether the chunk has been decoded
+		bool decoded = false;
+		//! Whether a malformed line has been met (the chunk is only decoded up to this line)
+		bool malformed = false;
+	};
+
+	//! PTX scan
+	struct PTXScan
+	{
+		//! Grid width
+		unsigned width = 0;
+		//! Grid height
+		unsigned height = 0;
+		//! Sensor transformation
+		ccGLMatrixd sensorTransD;
+		//! Cloud transformation
+		ccGLMatrixd cloudTransD;
+		//! Whether the points have colors
+		bool hasColors = false;
+		//! Whether the file ends before the last grid cell
+		bool truncated = false;
+		//! Grid cell chunks
+		std::vector<PTXChunk> chunks;
+
+		//! Loaded cloud
+		ccPointCloud* cloud = nullptr;
+		//! Intensities
+		ccScalarField* intensitySF = nullptr;
+		//! Grid structure
+		ccPointCloud::Grid::Shared grid;
+		//! Whether the grid indexes are loaded
+		bool hasIndexGrid = false;
+		//! Whether the colors are loaded
+		bool loadColors = false;
+		//! Whether the grid colors are loaded
+		bool loadGridColors = false;
+		//! Number of valid points (once compacted)
+		unsigned validCount = 0;
+		//! Whether all the chunks have been decoded (without error)
+		bool complete = false;
+
+		//! Returns the number of grid cells
+		inline unsigned gridSize() const { return width * height; }
+
+		//! Releases the loaded entities
+		void release()
+		{
+			delete cloud;
+			cloud = nullptr;
+			if (intensitySF)
+			{
+				intensitySF->release();
+				intensitySF = nullptr;
+			}
+			grid.clear();
+		}
+	};
 
-	// progress dialog
-	QScopedPointer<ccProgressDialog> pDlg(nullptr);
-	if (parameters.parentWidget)
+	//! Splits a line in (at most 'maxCount') tokens
+	/** \return the number of tokens (or maxCount + 1 if there are more)
+	**/
+	inline unsigned SplitPTXLine(const Token& line, Token* tokens, unsigned maxCount)
 	{
-		pDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
-		pDlg->setMethodTitle(QObject::tr("Loading PTX file"));
-		pDlg->setAutoClose(false);
+		const char* p     = line.begin;
+		unsigned    count = 0;
+		for (Token token = AsciiParsingTools::NextToken(p, line.end); !token.empty(); token = AsciiParsingTools::NextToken(p, line.end))
+		{
+			if (count == maxCount)
+			{
+				return maxCount + 1;
+			}
+			tokens[count++] = token;
+		}
+		return count;
 	}
 
-	// progress dialog (for normals computation)
-	QScopedPointer<ccProgressDialog> normalsProgressDlg(nullptr);
-	if (parameters.parentWidget && parameters.autoComputeNormals)
+	//! Reads an unsigned integer (header line)
+	inline bool ReadPTXUInt(const char*& pos, const char* end, unsigned& value)
 	{
-		normalsProgressDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
-		normalsProgressDlg->setAutoClose(false);
-		normalsProgressDlg->hide();
+		Token line = AsciiParsingTools::Trimmed(AsciiParsingTools::ReadLine(pos, end));
+		bool  ok   = false;
+		value      = QByteArray::fromRawData(line.begin, static_cast<int>(line.length())).toUInt(&ok);
+		return ok;
 	}
 
-	for (unsigned cloudIndex = 0; result == CC_FERR_NO_ERROR || result == CC_FERR_NO_LOAD; cloudIndex++)
+	//! Reads the header of a PTX scan (grid size and transformation matrices)
+	bool ReadPTXHeader(const char*& pos, const char* end, PTXScan& scan)
 	{
-		unsigned    width  = 0;
-		unsigned    height = 0;
-		ccGLMatrixd sensorTransD;
-		ccGLMatrixd cloudTransD;
-
-		// read header
+		// read the width (number of columns) and the height (number of rows) on the two first lines
+		//(DGM: we transpose the matrix right away)
+		if (!ReadPTXUInt(pos, end, scan.height) || !ReadPTXUInt(pos, end, scan.width))
 		{
-			QString line = inFile.readLine();
-			if (line.isNull() && container.getChildrenNumber() != 0) // end of file?
-				break;
-
-			// read the width (number of columns) and the height (number of rows) on the two first lines
-			//(DGM: we transpose the matrix right away)
-			bool ok;
-			height = line.toUInt(&ok);
-			if (!ok)
-				return CC_FERR_MALFORMED_FILE;
-			line  = inFile.readLine();
-			width = line.toUInt(&ok);
-			if (!ok)
-				return CC_FERR_MALFORMED_FILE;
+			return false;
+		}
+		if (static_cast<uint64_t>(scan.width) * scan.height > std::numeric_limits<unsigned>::max())
+		{
+			ccLog::Warning(QString("[PTX] Grid is too big (%1 x %2)").arg(scan.height).arg(scan.width));
+			return false;
+		}
 
-			ccLog::Print(QString("[PTX] Scan #%1 - grid size: %2 x %3").arg(cloudIndex + 1).arg(height).arg(width));
+		Token tokens[4];
 
-			// read sensor transformation matrix
-			for (int i = 0; i < 4; ++i)
+		// read sensor transformation matrix
+		for (int i = 0; i < 4; ++i)
+		{
+			Token line = AsciiParsingTools::ReadLine(pos, end);
+			if (SplitPTXLine(line, tokens, 3) != 3)
 			{
-				line               = inFile.readLine();
-				QStringList tokens = line.split(" ", Qt::SkipEmptyParts);
-				if (tokens.size() != 3)
-					return CC_FERR_MALFORMED_FILE;
+				return false;
+			}
 
-				double* colDest = nullptr;
-				if (i == 0)
-				{
-					// Translation
-					colDest = sensorTransD.getTranslation();
-				}
-				else
-				{
-					// X, Y and Z axis
-					colDest = sensorTransD.getColumn(i - 1);
-				}
+			double* colDest = nullptr;
+			if (i == 0)
+			{
+				// Translation
+				colDest = scan.sensorTransD.getTranslation();
+			}
+			else
+			{
+				// X, Y and Z axis
+				colDest = scan.sensorTransD.getColumn(i - 1);
+			}
 
-				for (int j = 0; j < 3; ++j)
+			for (int j = 0; j < 3; ++j)
+			{
+				bool ok    = false;
+				colDest[j] = AsciiParsingTools::ToDouble(tokens[j], &ok);
+				if (!ok)
 				{
-					assert(colDest);
-					colDest[j] = tokens[j].toDouble(&ok);
-					if (!ok)
-						return CC_FERR_MALFORMED_FILE;
+					return false;
 				}
 			}
-			// make the transform a little bit cleaner (necessary as it's read from ASCII!)
-			CleanMatrix(sensorTransD);
+		}
+		// make the transform a little bit cleaner (necessary as it's read from ASCII!)
+		CleanMatrix(scan.sensorTransD);
 
-			// read cloud transformation matrix
-			for (int i = 0; i < 4; ++i)
+		// read cloud transformation matrix
+		for (int i = 0; i < 4; ++i)
+		{
+			Token line = AsciiParsingTools::ReadLine(pos, end);
+			if (SplitPTXLine(line, tokens, 4) != 4)
 			{
-				line               = inFile.readLine();
-				QStringList tokens = line.split(" ", Qt::SkipEmptyParts);
-				if (tokens.size() != 4)
-					return CC_FERR_MALFORMED_FILE;
-
-				double* col = cloudTransD.getColumn(i);
-				for (int j = 0; j < 4; ++j)
-				{
-					col[j] = tokens[j].toDouble(&ok);
-					if (!ok)
-						return CC_FERR_MALFORMED_FILE;
-				}
+				return false;
 			}
-			// make the transform a little bit cleaner (necessary as it's read from ASCII!)
-			CleanMatrix(cloudTransD);
 
-			// handle Global Shift directly on the first cloud's translation!
-			if (cloudIndex == 0)
+			double* col = scan.cloudTransD.getColumn(i);
+			for (int j = 0; j < 4; ++j)
 			{
-				if (HandleGlobalShift(cloudTransD.getTranslationAsVec3D(), PshiftTrans, preserveCoordinateShift, parameters))
+				bool ok = false;
+				col[j]  = AsciiParsingTools::ToDouble(tokens[j], &ok);
+				if (!ok)
 				{
-					ccLog::Warning("[PTXFilter::loadFile] Cloud has be recentered! Translation: (%.2f ; %.2f ; %.2f)", PshiftTrans.x, PshiftTrans.y, PshiftTrans.z);
+					return false;
 				}
 			}
-
-			//'remove' global shift from the sensor and cloud transformation matrices
-			cloudTransD.setTranslation(cloudTransD.getTranslationAsVec3D() + PshiftTrans);
-			sensorTransD.setTranslation(sensorTransD.getTranslationAsVec3D() + PshiftTrans);
 		}
+		// make the transform a little bit cleaner (necessary as it's read from ASCII!)
+		CleanMatrix(scan.cloudTransD);
 
-		// now we can read the grid cells
-		ccPointCloud* cloud = new ccPointCloud();
-		if (container.getChildrenNumber() == 0)
+		return true;
+	}
+
+	//! Indexes the grid cells of a PTX scan (i.e. splits them in chunks)
+	bool IndexPTXCells(const char*& pos, const char* end, PTXScan& scan)
+	{
+		const unsigned gridSize = scan.gridSize();
+		try
 		{
-			cloud->setName("unnamed - Cloud");
+			scan.chunks.reserve((gridSize + PTX_CHUNK_CELL_COUNT - 1) / PTX_CHUNK_CELL_COUNT);
 		}
-		else
+		catch (const std::bad_alloc&)
 		{
-			if (container.getChildrenNumber() == 1)
-			{
-				container.getChild(0)->setName("unnamed - Cloud 1"); // update previous cloud name!
-			}
-			cloud->setName(QString("unnamed - Cloud %1").arg(container.getChildrenNumber() + 1));
+			return false;
 		}
 
-		unsigned gridSize = width * height;
-		if (!cloud->reserve(gridSize))
+		unsigned cellIndex = 0;
+		while (cellIndex < gridSize && pos != end)
 		{
-			result = CC_FERR_NOT_ENOUGH_MEMORY;
-			delete cloud;
-			cloud = nullptr;
-			break;
+			PTXChunk chunk;
+			chunk.begin     = pos;
+			chunk.firstCell = cellIndex;
+			for (; chunk.cellCount < PTX_CHUNK_CELL_COUNT && cellIndex < gridSize && pos != end; ++chunk.cellCount, ++cellIndex)
+			{
+				const char* eol = static_cast<const char*>(std::memchr(pos, '\n', static_cast<size_t>(end - pos)));
+				pos             = (eol ? eol + 1 : end);
+			}
+			chunk.end = pos;
+			scan.chunks.push_back(chunk);
 		}
 
-		// set global shift
-		if (preserveCoordinateShift)
-		{
-			cloud->setGlobalShift(PshiftTrans);
-		}
+		scan.truncated = (cellIndex < gridSize);
 
-		// intensities
-		ccScalarField* intensitySF = new ccScalarField(CC_PTX_INTENSITY_FIELD_NAME);
-		if (!intensitySF->reserveSafe(static_cast<unsigned>(gridSize)))
+		// the first line tells whether the points have colors or not
+		if (!scan.chunks.empty())
 		{
-			ccLog::Warning("[PTX] Not enough memory to load intensities!");
-			intensitySF->release();
-			intensitySF = nullptr;
+			const char* p = scan.chunks.front().begin;
+			Token       tokens[7];
+			scan.hasColors = (SplitPTXLine(AsciiParsingTools::ReadLine(p, end), tokens, 7) == 7);
 		}
 
-		// grid structure
-		ccPointCloud::Grid::Shared grid(new ccPointCloud::Grid);
-		grid->w           = width;
-		grid->h           = height;
-		bool hasIndexGrid = true;
-		try
-		{
-			grid->indexes.resize(gridSize, -1); //-1 means no cell/point
-		}
-		catch (const std::bad_alloc&)
+		return true;
+	}
+
+	//! Returns the first valid point of a PTX scan (if any)
+	bool ReadFirstPTXPoint(const PTXScan& scan, CCVector3d& P)
+	{
+		for (const PTXChunk& chunk : scan.chunks)
 		{
-			ccLog::Warning("[PTX] Not enough memory to load the grid structure");
-			hasIndexGrid = false;
+			const char* pos = chunk.begin;
+			for (unsigned k = 0; k < chunk.cellCount; ++k)
+			{
+				Token tokens[7];
+				if (SplitPTXLine(AsciiParsingTools::ReadLine(pos, chunk.end), tokens, 7) < 3)
+				{
+					return false;
+				}
+				bool okX = false;
+				bool okY = false;
+				bool okZ = false;
+				P        = CCVector3d(AsciiParsingTools::ToDouble(tokens[0], &okX),
+				                      AsciiParsingTools::ToDouble(tokens[1], &okY),
+				                      AsciiParsingTools::ToDouble(tokens[2], &okZ));
+				if (!okX || !okY || !okZ)
+				{
+					return false;
+				}
+				if (P.norm2() != 0)
+				{
+					return true;
+				}
+			}
 		}
+		return false;
+	}
 
-		// read points
+	//! Decodes a chunk of grid cells
+	/** The valid points are written (temporarily) at the beginning of the chunk range in the cloud,
+	    and the grid indexes are relative to the chunk (see CompactPTXScan).
+	**/
+	void DecodePTXChunk(PTXScan& scan, PTXChunk& chunk, const CCVector3d& PshiftCloud)
+	{
+		ccPointCloud*        cloud        = scan.cloud;
+		RGBAColorsTableType* colors       = (scan.loadColors ? cloud->rgbaColors() : nullptr);
+		const unsigned       expectedSize = (scan.hasColors ? 7 : 4);
+
+		const char* pos = chunk.begin;
+		for (unsigned k = 0; k < chunk.cellCount; ++k)
 		{
-			CCCoreLib::NormalizedProgress nprogress(pDlg.data(), gridSize);
-			if (pDlg)
+			const unsigned gridIndex = chunk.firstCell + k;
+
+			Token tokens[7];
+			if (SplitPTXLine(AsciiParsingTools::ReadLine(pos, chunk.end), tokens, 7) != expectedSize)
 			{
-				pDlg->setInfo(qPrintable(QString("Number of cells: %1").arg(gridSize)));
-				pDlg->start();
+				chunk.malformed = true;
+				break;
 			}
 
-			bool   firstPoint     = true;
-			bool   hasColors      = false;
-			bool   loadColors     = false;
-			bool   loadGridColors = false;
-			size_t gridIndex      = 0;
+			double values[4];
+			for (int v = 0; v < 4; ++v)
+			{
+				bool ok   = false;
+				values[v] = AsciiParsingTools::ToDouble(tokens[v], &ok);
+				if (!ok)
+				{
+					chunk.malformed = true;
+					break;
+				}
+			}
+			if (chunk.malformed)
+			{
+				break;
+			}
 
-			for (unsigned j = 0; j < height; ++j)
+			// we skip "empty" cells
+			const bool     pointIsValid = (CCVector3d::fromArray(values).norm2() != 0);
+			const unsigned pointIndex   = chunk.firstCell + chunk.validCount;
+			if (pointIsValid)
 			{
-				for (unsigned i = 0; i < width; ++i, ++gridIndex)
+				*const_cast<CCVector3*>(cloud->getPoint(pointIndex)) = CCVector3(static_cast<PointCoordinateType>(values[0] + PshiftCloud.x),
+				                                                                 static_cast<PointCoordinateType>(values[1] + PshiftCloud.y),
+				                                                                 static_cast<PointCoordinateType>(values[2] + PshiftCloud.z));
+
+				if (scan.intensitySF)
 				{
-					QString     line   = inFile.readLine();
-					QStringList tokens = line.split(" ", Qt::SkipEmptyParts);
+					scan.intensitySF->setValue(pointIndex, static_cast<ScalarType>(values[3]));
+				}
 
-					if (firstPoint)
+				// update index grid (relatively to the chunk for now)
+				if (scan.hasIndexGrid)
+				{
+					scan.grid->indexes[gridIndex] = static_cast<int>(chunk.validCount);
+				}
+			}
+
+			// color
+			if (colors && (pointIsValid || scan.loadGridColors))
+			{
+				ccColor::Rgb color;
+				for (int c = 0; c < 3; ++c)
+				{
+					bool ok   = false;
+					int  temp = AsciiParsingTools::ToInt(tokens[4 + c], &ok);
+					if (ok && temp >= 0 && temp <= 255)
 					{
-						hasColors = (tokens.size() == 7);
-						if (hasColors)
-						{
-							loadColors = cloud->reserveTheRGBTable();
-							if (!loadColors)
-							{
-								ccLog::Warning("[PTX] Not enough memory to load RGB colors!");
-							}
-							else if (hasIndexGrid)
-							{
-								// we also load the colors into the grid (as invalid/missing points can have colors!)
-								try
-								{
-									grid->colors.resize(gridSize, ccColor::Rgb(0, 0, 0));
-									loadGridColors = true;
-								}
-								catch (const std::bad_alloc&)
-								{
-									ccLog::Warning("[PTX] Not enough memory to load the grid colors");
-								}
-							}
-						}
+						color.rgb[c] = static_cast<unsigned char>(temp);
 					}
-					if ((hasColors && tokens.size() != 7) || (!hasColors && tokens.size() != 4))
+					else
 					{
-						result = CC_FERR_MALFORMED_FILE;
-						// early stop
-						j = height;
+						chunk.malformed = true;
 						break;
 					}
+				}
+				if (chunk.malformed)
+				{
+					break;
+				}
 
-					double values[4];
-					for (int v = 0; v < 4; ++v)
-					{
-						bool ok;
-						values[v] = tokens[v].toDouble(&ok);
-						if (!ok)
-						{
-							result = CC_FERR_MALFORMED_FILE;
-							// early stop
-							j = height;
-							break;
-						}
-					}
+				if (pointIsValid)
+				{
+					(*colors)[pointIndex] = ccColor::FromRgbToRgba(color);
+				}
+				if (scan.loadGridColors)
+				{
+					scan.grid->colors[gridIndex] = color;
+				}
+			}
+
+			if (pointIsValid)
+			{
+				++chunk.validCount;
+			}
+		}
+
+		chunk.decoded = true;
+	}
+
+	//! Moves the valid points of each chunk right after the ones of the previous chunk, and updates the grid indexes
+	/** The chunks after the first chunk that was not (entirely) decoded are discarded.
+	**/
+	void CompactPTXScan(PTXScan& scan)
+	{
+		ccPointCloud*        cloud  = scan.cloud;
+		RGBAColorsTableType* colors = (scan.loadColors ? cloud->rgbaColors() : nullptr);
 
-					// we skip "empty" cells
-					bool pointIsValid = (CCVector3d::fromArray(values).norm2() != 0);
-					if (pointIsValid)
+		unsigned validCount = 0;
+		bool     complete   = true;
+		for (const PTXChunk& chunk : scan.chunks)
+		{
+			if (!complete || !chunk.decoded)
+			{
+				if (complete)
+				{
+					// not decoded: the grid indexes are still invalid
+					complete = false;
+				}
+				else if (scan.hasIndexGrid && chunk.decoded)
+				{
+					std::fill(scan.grid->indexes.begin() + chunk.firstCell, scan.grid->indexes.begin() + chunk.firstCell + chunk.cellCount, -1);
+				}
+				continue;
+			}
+
+			if (validCount != chunk.firstCell)
+			{
+				for (unsigned i = 0; i < chunk.validCount; ++i)
+				{
+					const unsigned from = chunk.firstCell + i;
+					const unsigned to   = validCount + i;
+					*const_cast<CCVector3*>(cloud->getPoint(to)) = *cloud->getPoint(from);
+					if (colors)
 					{
-						const double* Pd = values;
-						// first point: check for 'big' coordinates
-						if (firstPoint)
-						{
-							if (cloudIndex == 0 && !cloud->isShifted()) // in case the trans. matrix was ok!
-							{
-								CCVector3d P(Pd);
-								if (HandleGlobalShift(P, PshiftCloud, preserveCoordinateShift, parameters))
-								{
-									if (preserveCoordinateShift)
-									{
-										cloud->setGlobalShift(PshiftCloud);
-									}
-									ccLog::Warning("[PTXFilter::loadFile] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", PshiftCloud.x, PshiftCloud.y, PshiftCloud.z);
-								}
-							}
-							firstPoint = false;
-						}
-
-						// update index grid
-						if (hasIndexGrid)
-						{
-							grid->indexes[gridIndex] = static_cast<int>(cloud->size()); // = index (default value = -1, means no point)
-						}
-
-						// add point
-						cloud->addPoint(CCVector3(static_cast<PointCoordinateType>(Pd[0] + PshiftCloud.x),
-						                          static_cast<PointCoordinateType>(Pd[1] + PshiftCloud.y),
-						                          static_cast<PointCoordinateType>(Pd[2] + PshiftCloud.z)));
-
-						// add intensity
-						if (intensitySF)
-						{
-							intensitySF->addElement(static_cast<ScalarType>(values[3]));
-						}
+						(*colors)[to] = (*colors)[from];
 					}
-
-					// color
-					if (loadColors && (pointIsValid || loadGridColors))
+					if (scan.intensitySF)
 					{
-						ccColor::Rgb color;
-						for (int c = 0; c < 3; ++c)
-						{
-							bool     ok;
-							unsigned temp = tokens[4 + c].toUInt(&ok);
-							ok &= (temp <= 255);
-							if (ok)
-							{
-								color.rgb[c] = static_cast<unsigned char>(temp);
-							}
-							else
-							{
-								result = CC_FERR_MALFORMED_FILE;
-								// early stop
-								j = height;
-								break;
-							}
-						}
-
-						if (pointIsValid)
-						{
-							cloud->addColor(color);
-						}
-						if (loadGridColors)
-						{
-							assert(!grid->colors.empty());
-							grid->colors[gridIndex] = color;
-						}
+						scan.intensitySF->setValue(to, scan.intensitySF->getValue(from));
 					}
+				}
+			}
 
-					if (parameters.parentWidget && !nprogress.oneStep())
+			if (scan.hasIndexGrid)
+			{
+				for (unsigned k = 0; k < chunk.cellCount; ++k)
+				{
+					int& index = scan.grid->indexes[chunk.firstCell + k];
+					if (index >= 0)
 					{
-						result = CC_FERR_CANCELED_BY_USER;
-						break;
+						index += static_cast<int>(validCount);
 					}
 				}
 			}
+
+			validCount += chunk.validCount;
+			if (chunk.malformed)
+			{
+				complete = false;
+			}
 		}
 
-		// is there at least one valid point in this grid?
-		if (cloud->size() == 0)
+		scan.validCount = validCount;
+		scan.complete   = complete && !scan.truncated;
+	}
+} // namespace
+
+CC_FILE_ERROR PTXFilter::loadFile(const QString&  filename,
+                                  ccHObject&      container,
+                                  LoadParameters& parameters)
+{
+	// open (map) ASCII file for reading
+	AsciiParsingTools::TextFile file;
+	if (!file.open(filename))
+	{
+		return CC_FERR_READING;
+	}
+
+	CCVector3d PshiftTrans(0, 0, 0);
+	CCVector3d PshiftCloud(0, 0, 0);
+	bool       preserveCoordinateShift = true;
+
+	CC_FILE_ERROR result       = CC_FERR_NO_LOAD;
+	ScalarType    minIntensity = 0;
+	ScalarType    maxIntensity = 0;
+
+	// 1st pass: read the scan headers and index the grid cells (the lines are not decoded)
+	std::vector<PTXScan> scans;
+	CC_FILE_ERROR        indexingError = CC_FERR_NO_ERROR;
+	size_t               chunkCount    = 0;
+	{
+		const char* pos = file.begin();
+		const char* end = file.end();
+		for (unsigned cloudIndex = 0;; ++cloudIndex)
 		{
-			delete cloud;
-			cloud = nullptr;
-			if (intensitySF)
+			// end of file?
+			if (!scans.empty())
 			{
-				intensitySF->release();
-				intensitySF = nullptr;
+				const char* p = pos;
+				while (p != end && AsciiParsingTools::IsSpace(*p))
+				{
+					++p;
+				}
+				if (p == end)
+				{
+					break;
+				}
+			}
+
+			PTXScan scan;
+			if (!ReadPTXHeader(pos, end, scan))
+			{
+				indexingError = CC_FERR_MALFORMED_FILE;
+				break;
+			}
+
+			ccLog::Print(QString("[PTX] Scan #%1 - grid size: %2 x %3").arg(cloudIndex + 1).arg(scan.height).arg(scan.width));
+
+			// handle Global Shift directly on the first cloud's translation!
+			if (cloudIndex == 0)
+			{
+				if (HandleGlobalShift(scan.cloudTransD.getTranslationAsVec3D(), PshiftTrans, preserveCoordinateShift, parameters))
+				{
+					ccLog::Warning("[PTXFilter::loadFile] Cloud has be recentered! Translation: (%.2f ; %.2f ; %.2f)", PshiftTrans.x, PshiftTrans.y, PshiftTrans.z);
+				}
+			}
+
+			//'remove' global shift from the sensor and cloud transformation matrices
+			scan.cloudTransD.setTranslation(scan.cloudTransD.getTranslationAsVec3D() + PshiftTrans);
+			scan.sensorTransD.setTranslation(scan.sensorTransD.getTranslationAsVec3D() + PshiftTrans);
+
+			if (!IndexPTXCells(pos, end, scan))
+			{
+				indexingError = CC_FERR_NOT_ENOUGH_MEMORY;
+				break;
+			}
+
+			// first point: check for 'big' coordinates
+			if (cloudIndex == 0 && !(preserveCoordinateShift && PshiftTrans.norm2() != 0)) // in case the trans. matrix was ok!
+			{
+				CCVector3d P;
+				if (ReadFirstPTXPoint(scan, P))
+				{
+					if (HandleGlobalShift(P, PshiftCloud, preserveCoordinateShift, parameters))
+					{
+						ccLog::Warning("[PTXFilter::loadFile] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", PshiftCloud.x, PshiftCloud.y, PshiftCloud.z);
+					}
+				}
+			}
+
+			chunkCount += scan.chunks.size();
+			const bool truncated = scan.truncated;
+			try
+			{
+				scans.push_back(std::move(scan));
+			}
+			catch (const std::bad_alloc&)
+			{
+				indexingError = CC_FERR_NOT_ENOUGH_MEMORY;
+				break;
 			}
 
-			ccLog::Warning(QString("[PTX] Scan #%1 is empty?!").arg(cloudIndex + 1));
+			if (truncated)
+			{
+				// the next scans (if any) can't be read
+				break;
+			}
 		}
-		else
+	}
+
+	if (scans.empty())
+	{
+		return (indexingError != CC_FERR_NO_ERROR ? indexingError : CC_FERR_NO_LOAD);
+	}
+
+	// progress dialog
+	QScopedPointer<ccProgressDialog> pDlg(nullptr);
+	if (parameters.parentWidget)
+	{
+		pDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
+		pDlg->setMethodTitle(QObject::tr("Loading PTX file"));
+		pDlg->setInfo(QObject::tr("Number of scans: %1").arg(scans.size()));
+		pDlg->setAutoClose(false);
+		pDlg->setRange(0, static_cast<int>(chunkCount));
+		pDlg->show();
+		QApplication::processEvents();
+	}
+
+	// progress dialog (for normals computation)
+	QScopedPointer<ccProgressDialog> normalsProgressDlg(nullptr);
+	if (parameters.parentWidget && parameters.autoComputeNormals)
+	{
+		normalsProgressDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
+		normalsProgressDlg->setAutoClose(false);
+		normalsProgressDlg->hide();
+	}
+
+	int groupSize = 1;
+#if defined(_OPENMP)
+	groupSize = 2 * omp_get_max_threads();
+#endif
+
+	// 2nd pass: the scans are decoded by batches (the chunks of all the scans of a batch are decoded in parallel)
+	size_t decodedChunkCount = 0;
+	bool   canceled          = false;
+	bool   stop              = false;
+	for (size_t batchStart = 0; batchStart < scans.size() && !stop;)
+	{
+		size_t batchEnd       = batchStart;
+		size_t batchCellCount = 0;
+		while (batchEnd < scans.size() && (batchEnd == batchStart || batchCellCount + scans[batchEnd].gridSize() <= PTX_BATCH_CELL_COUNT))
 		{
-			if (result == CC_FERR_NO_LOAD)
+			batchCellCount += scans[batchEnd].gridSize();
+			++batchEnd;
+		}
+
+		// allocate the clouds
+		for (size_t s = batchStart; s < batchEnd; ++s)
+		{
+			PTXScan&       scan     = scans[s];
+			const unsigned gridSize = scan.gridSize();
+
+			// each point is first written at the position of its grid cell (see DecodePTXChunk)
+			scan.cloud = new ccPointCloud();
+			if (!scan.cloud->resize(gridSize))
 			{
-				result = CC_FERR_NO_ERROR; // to make clear that we have loaded at least something!
+				result = CC_FERR_NOT_ENOUGH_MEMORY;
+				scan.release();
+				batchEnd = s;
+				stop     = true;
+				break;
 			}
 
-			cloud->resize(cloud->size());
-			if (intensitySF)
+			// set global shift
+			if (preserveCoordinateShift)
 			{
-				assert(intensitySF->currentSize() == cloud->size());
-				intensitySF->resizeSafe(cloud->size());
-				intensitySF->computeMinAndMax();
-				int intensitySFIndex = cloud->addScalarField(intensitySF);
+				scan.cloud->setGlobalShift(s == 0 && PshiftCloud.norm2() != 0 ? PshiftCloud : PshiftTrans);
+			}
 
-				// keep track of the min and max intensity
-				if (container.getChildrenNumber() == 0)
+			// intensities
+			scan.intensitySF = new ccScalarField(CC_PTX_INTENSITY_FIELD_NAME);
+			if (!scan.intensitySF->resizeSafe(gridSize))
+			{
+				ccLog::Warning("[PTX] Not enough memory to load intensities!");
+				scan.intensitySF->release();
+				scan.intensitySF = nullptr;
+			}
+
+			// grid structure
+			scan.grid.reset(new ccPointCloud::Grid);
+			scan.grid->w = scan.width;
+			scan.grid->h = scan.height;
+			try
+			{
+				scan.grid->indexes.resize(gridSize, -1); //-1 means no cell/point
+				scan.hasIndexGrid = true;
+			}
+			catch (const std::bad_alloc&)
+			{
+				ccLog::Warning("[PTX] Not enough memory to load the grid structure");
+			}
+
+			if (scan.hasColors)
+			{
+				scan.loadColors = scan.cloud->resizeTheRGBTable();
+				if (!scan.loadColors)
 				{
-					minIntensity = intensitySF->getMin();
-					maxIntensity = intensitySF->getMax();
+					ccLog::Warning("[PTX] Not enough memory to load RGB colors!");
 				}
-				else
+				else if (scan.hasIndexGrid)
 				{
-					minIntensity = std::min(minIntensity, intensitySF->getMin());
-					maxIntensity = std::max(maxIntensity, intensitySF->getMax());
+					// we also load the colors into the grid (as invalid/missing points can have colors!)
+					try
+					{
+						scan.grid->colors.resize(gridSize, ccColor::Rgb(0, 0, 0));
+						scan.loadGridColors = true;
+					}
+					catch (const std::bad_alloc&)
+					{
+						ccLog::Warning("[PTX] Not enough memory to load the grid colors");
+					}
 				}
-
-				cloud->showSF(true);
-				cloud->setCurrentDisplayedScalarField(intensitySFIndex);
 			}
+		}
 
-			ccGBLSensor* sensor = nullptr;
-			if (hasIndexGrid && result != CC_FERR_CANCELED_BY_USER)
+		// decode the chunks (by groups, to update the progress bar)
+		std::vector<std::pair<PTXScan*, PTXChunk*>> tasks;
+		try
+		{
+			for (size_t s = batchStart; s < batchEnd; ++s)
 			{
-				// determine best sensor parameters (mainly yaw and pitch steps)
-				ccGLMatrix cloudToSensorTrans((sensorTransD.inverse() * cloudTransD).data());
-				sensor = ccGriddedTools::ComputeBestSensor(cloud, grid, &cloudToSensorTrans);
+				for (PTXChunk& chunk : scans[s].chunks)
+				{
+					tasks.emplace_back(&scans[s], &chunk);
+				}
 			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			result = CC_FERR_NOT_ENOUGH_MEMORY;
+			tasks.clear();
+			stop = true;
+		}
 
-			// we apply the transformation
-			ccGLMatrix cloudTrans(cloudTransD.data());
-			cloud->applyGLTransformation_recursive(&cloudTrans);
-			// this transformation is of no interest for the user
-			cloud->resetGLTransformationHistory_recursive();
+		const int taskCount = static_cast<int>(tasks.size());
+		for (int groupStart = 0; groupStart < taskCount && !canceled; groupStart += groupSize)
+		{
+			const int groupEnd = std::min(groupStart + groupSize, taskCount);
 
-			if (sensor)
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads()) schedule(dynamic)
+#endif
+			for (int t = groupStart; t < groupEnd; ++t)
 			{
-				ccGLMatrix sensorTrans(sensorTransD.data());
-				sensor->setRigidTransformation(sensorTrans); // after cloud->applyGLTransformation_recursive!
-				cloud->addChild(sensor);
+				DecodePTXChunk(*tasks[t].first, *tasks[t].second, PshiftCloud);
 			}
 
-			// scan grid
-			if (hasIndexGrid)
+			decodedChunkCount += static_cast<size_t>(groupEnd - groupStart);
+			if (pDlg)
 			{
-				grid->validCount     = static_cast<unsigned>(cloud->size());
-				grid->minValidIndex  = 0;
-				grid->maxValidIndex  = grid->validCount - 1;
-				grid->sensorPosition = sensorTransD;
-				cloud->addGrid(grid);
+				if (pDlg->wasCanceled())
+				{
+					result   = CC_FERR_CANCELED_BY_USER;
+					canceled = true;
+					stop     = true;
+				}
+				pDlg->setValue(static_cast<int>(decodedChunkCount));
+				QApplication::processEvents();
+			}
+		}
 
-				// by default we don't compute normals without asking the user
-				if (parameters.autoComputeNormals)
+		// compact the clouds (in parallel)
+		const int batchScanCount = static_cast<int>(batchEnd - batchStart);
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads()) schedule(dynamic)
+#endif
+		for (int s = 0; s < batchScanCount; ++s)
+		{
+			CompactPTXScan(scans[batchStart + s]);
+		}
+
+		// finalize the clouds (in order)
+		for (size_t s = batchStart; s < batchEnd; ++s)
+		{
+			PTXScan&      scan  = scans[s];
+			ccPointCloud* cloud = scan.cloud;
+
+			const bool malformed = (!scan.complete && !canceled);
+			if (malformed)
+			{
+				// malformed or truncated file: the next scans can't be trusted
+				result = CC_FERR_MALFORMED_FILE;
+				stop   = true;
+			}
+
+			// is there at least one valid point in this grid?
+			if (scan.validCount == 0)
+			{
+				scan.release();
+				if (!canceled)
 				{
-					cloud->computeNormalsWithGrids(1.0, normalsProgressDlg.data());
+					ccLog::Warning(QString("[PTX] Scan #%1 is empty?!").arg(s + 1));
 				}
 			}
+			else
+			{
+				if (result == CC_FERR_NO_LOAD)
+				{
+					result = CC_FERR_NO_ERROR; // to make clear that we have loaded at least something!
+				}
 
-			cloud->setVisible(true);
-			cloud->showColors(cloud->hasColors());
-			cloud->showNormals(cloud->hasNormals());
+				if (container.getChildrenNumber() == 0)
+				{
+					cloud->setName("unnamed - Cloud");
+				}
+				else
+				{
+					if (container.getChildrenNumber() == 1)
+					{
+						container.getChild(0)->setName("unnamed - Cloud 1"); // update previous cloud name!
+					}
+					cloud->setName(QString("unnamed - Cloud %1").arg(container.getChildrenNumber() + 1));
+				}
 
-			container.addChild(cloud);
+				cloud->resize(scan.validCount); // shrinking the cloud can't fail
+				cloud->shrinkToFit();
+				cloud->invalidateBoundingBox();
 
-#ifdef QT_DEBUG
-			// break;
-#endif
+				if (scan.intensitySF)
+				{
+					scan.intensitySF->resizeSafe(scan.validCount);
+					scan.intensitySF->shrink_to_fit();
+					scan.intensitySF->computeMinAndMax();
+					int intensitySFIndex = cloud->addScalarField(scan.intensitySF);
+
+					// keep track of the min and max intensity
+					if (container.getChildrenNumber() == 0)
+					{
+						minIntensity = scan.intensitySF->getMin();
+						maxIntensity = scan.intensitySF->getMax();
+					}
+					else
+					{
+						minIntensity = std::min(minIntensity, scan.intensitySF->getMin());
+						maxIntensity = std::max(maxIntensity, scan.intensitySF->getMax());
+					}
+					scan.intensitySF = nullptr;
+
+					cloud->showSF(true);
+					cloud->setCurrentDisplayedScalarField(intensitySFIndex);
+				}
+
+				ccGBLSensor* sensor = nullptr;
+				if (scan.hasIndexGrid && scan.complete)
+				{
+					// determine best sensor parameters (mainly yaw and pitch steps)
+					ccGLMatrix cloudToSensorTrans((scan.sensorTransD.inverse() * scan.cloudTransD).data());
+					sensor = ccGriddedTools::ComputeBestSensor(cloud, scan.grid, &cloudToSensorTrans);
+				}
+
+				// we apply the transformation
+				ccGLMatrix cloudTrans(scan.cloudTransD.data());
+				cloud->applyGLTransformation_recursive(&cloudTrans);
+				// this transformation is of no interest for the user
+				cloud->resetGLTransformationHistory_recursive();
+
+				if (sensor)
+				{
+					ccGLMatrix sensorTrans(scan.sensorTransD.data());
+					sensor->setRigidTransformation(sensorTrans); // after cloud->applyGLTransformation_recursive!
+					cloud->addChild(sensor);
+				}
+
+				// scan grid
+				if (scan.hasIndexGrid)
+				{
+					scan.grid->validCount     = scan.validCount;
+					scan.grid->minValidIndex  = 0;
+					scan.grid->maxValidIndex  = scan.grid->validCount - 1;
+					scan.grid->sensorPosition = scan.sensorTransD;
+					cloud->addGrid(scan.grid);
+
+					// by default we don't compute normals without asking the user
+					if (parameters.autoComputeNormals && !canceled)
+					{
+						cloud->computeNormalsWithGrids(1.0, normalsProgressDlg.data());
+					}
+				}
+
+				cloud->setVisible(true);
+				cloud->showColors(cloud->hasColors());
+				cloud->showNormals(cloud->hasNormals());
+
+				container.addChild(cloud);
+				scan.cloud = nullptr;
+				scan.grid.clear();
+			}
+
+			if (malformed)
+			{
+				// release the remaining scans of the batch
+				for (size_t k = s + 1; k < batchEnd; ++k)
+				{
+					scans[k].release();
+				}
+				break;
+			}
 		}
+
+		batchStart = batchEnd;
+	}
+
+	if (result != CC_FERR_CANCELED_BY_USER && indexingError != CC_FERR_NO_ERROR && !stop)
+	{
+		// the header of a scan was malformed (the previous ones are loaded anyway)
+		result = indexingError;
 	}
 
 	// update scalar fields saturation (globally!)
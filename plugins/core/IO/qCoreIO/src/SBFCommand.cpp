@@ -0,0 +1,107 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: CloudCompare project                               #
+// #                                                                        #
+// ##########################################################################
+
+#include "SBFCommand.h"
+
+#include "SimpleBinFilter.h"
+
+constexpr char COMMAND_SBF[]             = "SBF";
+constexpr char COMMAND_SBF_FIRST_POINT[] = "FIRST_POINT";
+constexpr char COMMAND_SBF_MAX_POINTS[]  = "MAX_POINTS";
+constexpr char COMMAND_SBF_SF[]          = "SF";
+constexpr char COMMAND_SBF_BOX[]         = "BOX";
+
+SBFCommand::SBFCommand()
+    : Command("SBF", COMMAND_SBF)
+{
+}
+
+bool SBFCommand::process(ccCommandLineInterface& cmd)
+{
+	cmd.print("[SBF]");
+
+	// each call starts from the default options (i.e. load everything)
+	SimpleBinFilter::LoadingOptions options;
+
+	while (!cmd.arguments().empty())
+	{
+		const QString& arg = cmd.arguments().front();
+
+		if (ccCommandLineInterface::IsCommand(arg, COMMAND_SBF_FIRST_POINT))
+		{
+			cmd.arguments().pop_front();
+
+			bool ok            = false;
+			options.firstPoint = (cmd.arguments().empty() ? 0 : cmd.arguments().takeFirst().toULongLong(&ok));
+			if (!ok)
+			{
+				return cmd.error(QObject::tr("Missing or invalid parameter: point index after '%1'").arg(COMMAND_SBF_FIRST_POINT));
+			}
+			cmd.print(QObject::tr("First point: %1").arg(options.firstPoint));
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_SBF_MAX_POINTS))
+		{
+			cmd.arguments().pop_front();
+
+			bool ok               = false;
+			options.maxPointCount = (cmd.arguments().empty() ? 0 : cmd.arguments().takeFirst().toULongLong(&ok));
+			if (!ok)
+			{
+				return cmd.error(QObject::tr("Missing or invalid parameter: number of points after '%1'").arg(COMMAND_SBF_MAX_POINTS));
+			}
+			cmd.print(QObject::tr("Max number of points: %1").arg(options.maxPointCount));
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_SBF_SF))
+		{
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: scalar field names (separated by commas) after '%1'").arg(COMMAND_SBF_SF));
+			}
+			options.scalarFields = cmd.arguments().takeFirst().split(',', Qt::SkipEmptyParts);
+			cmd.print(QObject::tr("Scalar fields: %1").arg(options.scalarFields.join(", ")));
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_SBF_BOX))
+		{
+			cmd.arguments().pop_front();
+
+			double bounds[6]{0, 0, 0, 0, 0, 0};
+			for (double& value : bounds)
+			{
+				bool ok = false;
+				value   = (cmd.arguments().empty() ? 0 : cmd.arguments().takeFirst().toDouble(&ok));
+				if (!ok)
+				{
+					return cmd.error(QObject::tr("Missing or invalid parameter: 6 values expected after '%1' (Xmin Ymin Zmin Xmax Ymax Zmax)").arg(COMMAND_SBF_BOX));
+				}
+			}
+			options.useBox = true;
+			options.boxMin = CCVector3d(bounds[0], bounds[1], bounds[2]);
+			options.boxMax = CCVector3d(bounds[3], bounds[4], bounds[5]);
+			cmd.print(QObject::tr("Box: (%1 ; %2 ; %3) - (%4 ; %5 ; %6)").arg(bounds[0]).arg(bounds[1]).arg(bounds[2]).arg(bounds[3]).arg(bounds[4]).arg(bounds[5]));
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	SimpleBinFilter::SetLoadingOptions(options);
+
+	return true;
+}
@@ -17,6 +17,8 @@
 
 #include "STLFilter.h"
 
+#include "AsciiParsingTools.h"
+
 // Qt
 #include <QApplication>
 #include <QFile>
@@ -37,7 +39,14 @@
 #include <ccProgressDialog.h>
 
 // System
+#include <algorithm>
 #include <cstring>
+#include <vector>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
 
 STLFilter::STLFilter()
     : FileIOFilter({"_STL Filter",
@@ -46,7 +55,7 @@ STLFilter::STLFilter()
                     "stl",
                     QStringList{"STL mesh (*.stl)"},
                     QStringList{"STL mesh (*.stl)"},
-                    Import | Export})
+                    Import | Export | ConcurrentLoad})
 {
 }
 
@@ -396,6 +405,309 @@ CC_FILE_ERROR STLFilter::loadFile(const QString& filename, ccHObject& container,
 	return CC_FERR_NO_ERROR;
 }
 
+namespace
+{
+	using AsciiParsingTools::Token;
+
+	//! Size of the chunks of an ASCII STL file (processed in parallel)
+	constexpr size_t STL_CHUNK_SIZE = (1 << 23); // 8 MB
+
+	//! Chunk of an ASCII STL file (i.e. a sequence of facets)
+	struct STLAsciiChunk
+	{
+		const char* begin = nullptr;
+		const char* end   = nullptr;
+
+		//! Decoded (and shifted) vertices (3 per facet)
+		std::vector<CCVector3> points;
+		//! Compressed normal of each facet
+		std::vector<CompressedNormType> normals;
+		//! Whether the normal of each facet is valid
+		std::vector<bool> validNormals;
+
+		//! Number of lines read
+		unsigned lineCount = 0;
+		//! Whether the end of the solid has been reached ('endsolid' or empty line)
+		bool endOfSolid = false;
+		//! Not enough memory to decode the chunk
+		bool notEnoughMemory = false;
+
+		//! Error (if any)
+		CC_FILE_ERROR error = CC_FERR_NO_ERROR;
+		//! Error message (the line number is the only argument)
+		const char* errorMessage = nullptr;
+		//! Error line (in the chunk)
+		unsigned errorLine = 0;
+
+		//! First normal warning message (the line number is the only argument)
+		const char* normalWarning = nullptr;
+		//! Normal warning line (in the chunk)
+		unsigned normalWarningLine = 0;
+
+		//! Sets the chunk error
+		void setError(CC_FILE_ERROR err, const char* message, unsigned line)
+		{
+			error        = err;
+			errorMessage = message;
+			errorLine    = line;
+		}
+
+		//! Sets the normal warning (only the first one is kept)
+		void setNormalWarning(const char* message, unsigned line)
+		{
+			if (!normalWarning)
+			{
+				normalWarning     = message;
+				normalWarningLine = line;
+			}
+		}
+
+		//! Returns the next line of the chunk (or an empty one at the end of the chunk)
+		inline Token readLine(const char*& pos) const
+		{
+			return pos != end ? AsciiParsingTools::ReadLine(pos, end) : Token();
+		}
+
+		//! Returns whether a line starts by a given keyword (same as QString::trimmed().toUpper().startsWith())
+		static inline bool StartsWith(const Token& line, const char* keyword)
+		{
+			return AsciiParsingTools::Trimmed(line).startsWithNoCase(keyword);
+		}
+
+		//! Decodes the chunk (same grammar as the sequential parser)
+		void decode(const CCVector3d& Pshift)
+		{
+			try
+			{
+				const char* pos = begin;
+				while (pos != end)
+				{
+					CCVector3 N(0, 0, 0);
+					bool      normalIsOk = false;
+
+					// 1st line of a 'facet': "facet normal ni nj nk" / or 'endsolid' (i.e. end of file)
+					{
+						Token line = readLine(pos);
+						if (line.empty())
+						{
+							endOfSolid = true;
+							return;
+						}
+						++lineCount;
+
+						const char* p       = line.begin;
+						Token       keyword = AsciiParsingTools::NextToken(p, line.end);
+						if (!keyword.equalsNoCase("FACET"))
+						{
+							if (!keyword.equalsNoCase("ENDSOLID"))
+							{
+								setError(CC_FERR_MALFORMED_FILE, "[STL] Error on line #%i: line should start by 'facet'!", lineCount);
+								return;
+							}
+							endOfSolid = true;
+							return;
+						}
+
+						Token tokens[4];
+						int   tokenCount = 1;
+						for (Token& token : tokens)
+						{
+							token = AsciiParsingTools::NextToken(p, line.end);
+							if (!token.empty())
+								++tokenCount;
+						}
+
+						if (tokenCount >= 5)
+						{
+							// let's try to read normal
+							if (tokens[0].equalsNoCase("NORMAL"))
+							{
+								N.x = static_cast<PointCoordinateType>(AsciiParsingTools::ToDouble(tokens[1], &normalIsOk));
+								if (normalIsOk)
+								{
+									N.y = static_cast<PointCoordinateType>(AsciiParsingTools::ToDouble(tokens[2], &normalIsOk));
+									if (normalIsOk)
+									{
+										N.z = static_cast<PointCoordinateType>(AsciiParsingTools::ToDouble(tokens[3], &normalIsOk));
+									}
+								}
+								if (!normalIsOk)
+								{
+									setNormalWarning("[STL] Error on line #%i: failed to read 'normal' values!", lineCount);
+								}
+							}
+							else
+							{
+								setNormalWarning("[STL] Error on line #%i: expecting 'normal' after 'facet'!", lineCount);
+							}
+						}
+						else if (tokenCount > 1)
+						{
+							setNormalWarning("[STL] Error on line #%i: incomplete 'normal' description!", lineCount);
+						}
+					}
+
+					// 2nd line: 'outer loop'
+					{
+						Token line = readLine(pos);
+						if (line.empty() || !StartsWith(line, "OUTER LOOP"))
+						{
+							setError(CC_FERR_READING, "[STL] Error: expecting 'outer loop' on line #%i", lineCount + 1);
+							return;
+						}
+						++lineCount;
+					}
+
+					// 3rd to 5th lines: 'vertex vix viy viz'
+					for (unsigned i = 0; i < 3; ++i)
+					{
+						Token line = readLine(pos);
+						if (line.empty() || !StartsWith(line, "VERTEX"))
+						{
+							setError(CC_FERR_MALFORMED_FILE, "[STL] Error: expecting a line starting by 'vertex' on line #%i", lineCount + 1);
+							return;
+						}
+						++lineCount;
+
+						const char* p = line.begin;
+						AsciiParsingTools::NextToken(p, line.end); // 'vertex'
+						Token x = AsciiParsingTools::NextToken(p, line.end);
+						Token y = AsciiParsingTools::NextToken(p, line.end);
+						Token z = AsciiParsingTools::NextToken(p, line.end);
+						if (z.empty())
+						{
+							setError(CC_FERR_MALFORMED_FILE, "[STL] Error on line #%i: incomplete 'vertex' description!", lineCount);
+							return;
+						}
+
+						// read vertex
+						CCVector3d Pd(0, 0, 0);
+						{
+							bool vertexIsOk = false;
+							Pd.x            = AsciiParsingTools::ToDouble(x, &vertexIsOk);
+							if (vertexIsOk)
+							{
+								Pd.y = AsciiParsingTools::ToDouble(y, &vertexIsOk);
+								if (vertexIsOk)
+									Pd.z = AsciiParsingTools::ToDouble(z, &vertexIsOk);
+							}
+							if (!vertexIsOk)
+							{
+								setError(CC_FERR_MALFORMED_FILE, "[STL] Error on line #%i: failed to read 'vertex' coordinates!", lineCount);
+								return;
+							}
+						}
+
+						points.push_back((Pd + Pshift).toPC());
+					}
+
+					// we have successfully read the 3 vertices
+					normals.push_back(normalIsOk ? ccNormalVectors::GetNormIndex(N.u) : 0);
+					validNormals.push_back(normalIsOk);
+
+					// 6th line: 'endloop'
+					{
+						Token line = readLine(pos);
+						if (line.empty() || !StartsWith(line, "ENDLOOP"))
+						{
+							setError(CC_FERR_MALFORMED_FILE, "[STL] Error: expecting 'endnloop' on line #%i", lineCount + 1);
+							return;
+						}
+						++lineCount;
+					}
+
+					// 7th and last line: 'endfacet'
+					{
+						Token line = readLine(pos);
+						if (line.empty() || !StartsWith(line, "ENDFACET"))
+						{
+							setError(CC_FERR_MALFORMED_FILE, "[STL] Error: expecting 'endfacet' on line #%i", lineCount + 1);
+							return;
+						}
+						++lineCount;
+					}
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				notEnoughMemory = true;
+			}
+		}
+
+		//! Releases the decoded data
+		void release()
+		{
+			points       = std::vector<CCVector3>();
+			normals      = std::vector<CompressedNormType>();
+			validNormals = std::vector<bool>();
+		}
+	};
+
+	//! Splits the facets of an ASCII STL file in chunks (each chunk starts by a 'facet' line)
+	std::vector<const char*> SplitSTLFacets(const char* begin, const char* end)
+	{
+		std::vector<const char*> boundaries = AsciiParsingTools::SplitInChunks(begin, end, STL_CHUNK_SIZE, false);
+
+		// we move each intermediate boundary to the next 'facet' line
+		std::vector<const char*> facetBoundaries;
+		facetBoundaries.push_back(begin);
+		for (size_t i = 1; i + 1 < boundaries.size(); ++i)
+		{
+			const char* pos = std::max(boundaries[i], facetBoundaries.back());
+			while (pos != end)
+			{
+				const char* lineStart = pos;
+				Token       line      = AsciiParsingTools::ReadLine(pos, end);
+				const char* p         = line.begin;
+				if (AsciiParsingTools::NextToken(p, line.end).equalsNoCase("FACET"))
+				{
+					pos = lineStart;
+					break;
+				}
+			}
+
+			if (pos == end)
+			{
+				break;
+			}
+			if (pos != facetBoundaries.back())
+			{
+				facetBoundaries.push_back(pos);
+			}
+		}
+		facetBoundaries.push_back(end);
+
+		return facetBoundaries;
+	}
+
+	//! Reads the first vertex of an ASCII STL file (to handle the global shift)
+	bool ReadFirstSTLVertex(const char* pos, const char* end, CCVector3d& Pd)
+	{
+		while (pos != end)
+		{
+			Token       line = AsciiParsingTools::ReadLine(pos, end);
+			const char* p    = line.begin;
+			if (AsciiParsingTools::NextToken(p, line.end).equalsNoCase("VERTEX"))
+			{
+				Token x = AsciiParsingTools::NextToken(p, line.end);
+				Token y = AsciiParsingTools::NextToken(p, line.end);
+				Token z = AsciiParsingTools::NextToken(p, line.end);
+
+				bool ok = !z.empty();
+				if (ok)
+					Pd.x = AsciiParsingTools::ToDouble(x, &ok);
+				if (ok)
+					Pd.y = AsciiParsingTools::ToDouble(y, &ok);
+				if (ok)
+					Pd.z = AsciiParsingTools::ToDouble(z, &ok);
+				return ok;
+			}
+		}
+
+		return false;
+	}
+} // namespace
+
 CC_FILE_ERROR STLFilter::loadASCIIFile(QFile&          fp,
                                        ccMesh*         mesh,
                                        ccPointCloud*   vertices,
@@ -403,32 +715,60 @@ CC_FILE_ERROR STLFilter::loadASCIIFile(QFile&          fp,
 {
 	assert(fp.isOpen() && mesh && vertices);
 
-	// text stream
-	QTextStream stream(&fp);
+	// we map the whole file
+	AsciiParsingTools::TextFile file;
+	if (!file.open(fp.fileName()))
+	{
+		return CC_FERR_READING;
+	}
+	const char* pos = file.begin();
 
 	// 1st line: 'solid name'
 	QString name("mesh");
 	{
-		QString currentLine = stream.readLine();
-		if (currentLine.isEmpty() || fp.error() != QFile::NoError)
+		Token currentLine = (pos != file.end() ? AsciiParsingTools::ReadLine(pos, file.end()) : Token());
+		if (currentLine.empty())
 		{
 			return CC_FERR_READING;
 		}
-		QStringList tokens = currentLine.simplified().split(QChar(' '), Qt::SkipEmptyParts);
-		if (tokens.empty() || tokens[0].toUpper() != "SOLID")
+		const char* p       = currentLine.begin;
+		Token       keyword = AsciiParsingTools::NextToken(p, currentLine.end);
+		if (!keyword.equalsNoCase("SOLID"))
 		{
 			ccLog::Warning("[STL] File should begin by 'solid [name]'!");
 			return CC_FERR_MALFORMED_FILE;
 		}
 		// Extract name
-		if (tokens.size() > 1)
+		QStringList tokens;
+		for (Token token = AsciiParsingTools::NextToken(p, currentLine.end); !token.empty(); token = AsciiParsingTools::NextToken(p, currentLine.end))
+		{
+			tokens.append(token.toString());
+		}
+		if (!tokens.empty())
 		{
-			tokens.removeAt(0);
 			name = tokens.join(" ");
 		}
 	}
 	mesh->setName(name);
 
+	// we split the facets in chunks (decoded in parallel)
+	std::vector<STLAsciiChunk> chunks;
+	try
+	{
+		std::vector<const char*> boundaries = SplitSTLFacets(pos, file.end());
+		chunks.resize(boundaries.size() - 1);
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			chunks[i].begin = boundaries[i];
+			chunks[i].end   = boundaries[i + 1];
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+	const int chunkCount = static_cast<int>(chunks.size());
+
 	// progress dialog
 	QScopedPointer<ccProgressDialog> pDlg(nullptr);
 	if (parameters.parentWidget)
@@ -436,7 +776,7 @@ CC_FILE_ERROR STLFilter::loadASCIIFile(QFile&          fp,
 		pDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
 		pDlg->setMethodTitle(QObject::tr("(ASCII) STL file"));
 		pDlg->setInfo(QObject::tr("Loading in progress..."));
-		pDlg->setRange(0, 0);
+		pDlg->setRange(0, chunkCount);
 		pDlg->start();
 		QApplication::processEvents();
 	}
@@ -444,6 +784,23 @@ CC_FILE_ERROR STLFilter::loadASCIIFile(QFile&          fp,
 	// current vertex shift
 	CCVector3d Pshift(0, 0, 0);
 
+	// first point: check for 'big' coordinates
+	{
+		CCVector3d Pd(0, 0, 0);
+		if (ReadFirstSTLVertex(pos, file.end(), Pd))
+		{
+			bool preserveCoordinateShift = true;
+			if (HandleGlobalShift(Pd, Pshift, preserveCoordinateShift, parameters))
+			{
+				if (preserveCoordinateShift)
+				{
+					vertices->setGlobalShift(Pshift);
+				}
+				ccLog::Warning("[STLFilter::loadFile] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", Pshift.x, Pshift.y, Pshift.z);
+			}
+		}
+	}
+
 	unsigned               pointCount                    = 0;
 	unsigned               faceCount                     = 0;
 	static const unsigned  s_defaultMemAllocCount        = 65536;
@@ -452,242 +809,132 @@ CC_FILE_ERROR STLFilter::loadASCIIFile(QFile&          fp,
 
 	CC_FILE_ERROR result = CC_FERR_NO_ERROR;
 
-	unsigned lineCount = 1;
-	while (true)
-	{
-		CCVector3 N;
-		bool      normalIsOk = false;
+	// the chunks are decoded in parallel (by groups of a few chunks), then
+	// the facets are sequentially added to the mesh (in the right order)
+	int groupSize = 1;
+#if defined(_OPENMP)
+	groupSize = 2 * omp_get_max_threads();
+#endif
 
-		// 1st line of a 'facet': "facet normal ni nj nk" / or 'endsolid' (i.e. end of file)
-		{
-			QString currentLine = stream.readLine();
-			if (currentLine.isEmpty())
-			{
-				break;
-			}
-			else if (fp.error() != QFile::NoError)
-			{
-				result = CC_FERR_READING;
-				break;
-			}
-			++lineCount;
-
-			QStringList tokens = currentLine.simplified().split(QChar(' '), Qt::SkipEmptyParts);
-			if (tokens.empty() || tokens[0].toUpper() != "FACET")
-			{
-				if (tokens[0].toUpper() != "ENDSOLID")
-				{
-					ccLog::Warning("[STL] Error on line #%i: line should start by 'facet'!", lineCount);
-					return CC_FERR_MALFORMED_FILE;
-				}
-				break;
-			}
-
-			if (normals && tokens.size() >= 5)
-			{
-				// let's try to read normal
-				if (tokens[1].toUpper() == "NORMAL")
-				{
-					N.x = static_cast<PointCoordinateType>(tokens[2].toDouble(&normalIsOk));
-					if (normalIsOk)
-					{
-						N.y = static_cast<PointCoordinateType>(tokens[3].toDouble(&normalIsOk));
-						if (normalIsOk)
-						{
-							N.z = static_cast<PointCoordinateType>(tokens[4].toDouble(&normalIsOk));
-						}
-					}
-					if (!normalIsOk && !normalWarningAlreadyDisplayed)
-					{
-						ccLog::Warning("[STL] Error on line #%i: failed to read 'normal' values!", lineCount);
-						normalWarningAlreadyDisplayed = true;
-					}
-				}
-				else if (!normalWarningAlreadyDisplayed)
-				{
-					ccLog::Warning("[STL] Error on line #%i: expecting 'normal' after 'facet'!", lineCount);
-					normalWarningAlreadyDisplayed = true;
-				}
-			}
-			else if (tokens.size() > 1 && !normalWarningAlreadyDisplayed)
-			{
-				ccLog::Warning("[STL] Error on line #%i: incomplete 'normal' description!", lineCount);
-				normalWarningAlreadyDisplayed = true;
-			}
-		}
+	unsigned lineCount  = 1;
+	bool     endOfSolid = false;
+	for (int groupStart = 0; !endOfSolid && groupStart < chunkCount; groupStart += groupSize)
+	{
+		const int groupEnd = std::min(groupStart + groupSize, chunkCount);
 
-		// 2nd line: 'outer loop'
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads()) schedule(dynamic)
+#endif
+		for (int i = groupStart; i < groupEnd; ++i)
 		{
-			QString currentLine = stream.readLine();
-			if (currentLine.isEmpty()
-			    || fp.error() != QFile::NoError
-			    || !QString(currentLine).trimmed().toUpper().startsWith("OUTER LOOP"))
-			{
-				ccLog::Warning("[STL] Error: expecting 'outer loop' on line #%i", lineCount + 1);
-				result = CC_FERR_READING;
-				break;
-			}
-			++lineCount;
+			chunks[i].decode(Pshift);
 		}
 
-		// 3rd to 5th lines: 'vertex vix viy viz'
-		unsigned vertIndexes[3]{0, 0, 0};
-		// unsigned pointCountBefore = pointCount;
-		for (unsigned i = 0; i < 3; ++i)
+		for (int i = groupStart; !endOfSolid && i < groupEnd; ++i)
 		{
-			QString currentLine = stream.readLine();
-			if (currentLine.isEmpty()
-			    || fp.error() != QFile::NoError
-			    || !QString(currentLine).trimmed().toUpper().startsWith("VERTEX"))
+			STLAsciiChunk& chunk = chunks[i];
+			if (chunk.notEnoughMemory)
 			{
-				ccLog::Warning("[STL] Error: expecting a line starting by 'vertex' on line #%i", lineCount + 1);
-				result = CC_FERR_MALFORMED_FILE;
-				break;
+				return CC_FERR_NOT_ENOUGH_MEMORY;
 			}
-			++lineCount;
 
-			QStringList tokens = QString(currentLine).simplified().split(QChar(' '), Qt::SkipEmptyParts);
-			if (tokens.size() < 4)
+			if (chunk.normalWarning && normals && !normalWarningAlreadyDisplayed)
 			{
-				ccLog::Warning("[STL] Error on line #%i: incomplete 'vertex' description!", lineCount);
-				result = CC_FERR_MALFORMED_FILE;
-				break;
+				ccLog::Warning(chunk.normalWarning, lineCount + chunk.normalWarningLine);
+				normalWarningAlreadyDisplayed = true;
 			}
 
-			// read vertex
-			CCVector3d Pd(0, 0, 0);
+			// add the new points
+			unsigned chunkFaceCount = static_cast<unsigned>(chunk.validNormals.size());
+			if (chunkFaceCount != 0)
 			{
-				bool vertexIsOk = false;
-				Pd.x            = tokens[1].toDouble(&vertexIsOk);
-				if (vertexIsOk)
+				// cloud is already full?
+				unsigned newPointCount = pointCount + 3 * chunkFaceCount;
+				if (vertices->capacity() < newPointCount
+				    && !vertices->reserve(std::max({newPointCount, pointCount + s_defaultMemAllocCount, vertices->capacity() + vertices->capacity() / 2})))
 				{
-					Pd.y = tokens[2].toDouble(&vertexIsOk);
-					if (vertexIsOk)
-						Pd.z = tokens[3].toDouble(&vertexIsOk);
+					return CC_FERR_NOT_ENOUGH_MEMORY;
 				}
-				if (!vertexIsOk)
+				for (unsigned j = 0; j < 3 * chunkFaceCount; ++j)
 				{
-					ccLog::Warning("[STL] Error on line #%i: failed to read 'vertex' coordinates!", lineCount);
-					result = CC_FERR_MALFORMED_FILE;
-					break;
+					vertices->addPoint(chunk.points[j]);
 				}
-			}
 
-			// first point: check for 'big' coordinates
-			if (pointCount == 0)
-			{
-				bool preserveCoordinateShift = true;
-				if (HandleGlobalShift(Pd, Pshift, preserveCoordinateShift, parameters))
+				// mesh is full?
+				unsigned newFaceCount = faceCount + chunkFaceCount;
+				if (mesh->capacity() < newFaceCount)
 				{
-					if (preserveCoordinateShift)
+					if (!mesh->reserve(std::max({newFaceCount, faceCount + s_defaultMemAllocCount, mesh->capacity() + mesh->capacity() / 2})))
 					{
-						vertices->setGlobalShift(Pshift);
+						result = CC_FERR_NOT_ENOUGH_MEMORY;
+						break;
 					}
-					ccLog::Warning("[STLFilter::loadFile] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", Pshift.x, Pshift.y, Pshift.z);
-				}
-			}
-
-			CCVector3 P = (Pd + Pshift).toPC();
 
-			// cloud is already full?
-			if (vertices->capacity() == pointCount && !vertices->reserve(pointCount + s_defaultMemAllocCount))
-			{
-				return CC_FERR_NOT_ENOUGH_MEMORY;
-			}
-
-			// insert new point
-			vertIndexes[i] = pointCount++;
-			vertices->addPoint(P);
-		}
-
-		if (CC_FERR_NO_ERROR != result)
-		{
-			break;
-		}
+					if (normals)
+					{
+						bool success = normals->reserveSafe(mesh->capacity());
+						if (success && faceCount == 0) // specific case: allocate per triangle normal indexes the first time!
+						{
+							success = mesh->reservePerTriangleNormalIndexes();
+						}
 
-		// we have successfully read the 3 vertices
-		// let's add a new triangle
-		{
-			// mesh is full?
-			if (mesh->capacity() == faceCount)
-			{
-				if (!mesh->reserve(faceCount + s_defaultMemAllocCount))
-				{
-					result = CC_FERR_NOT_ENOUGH_MEMORY;
-					break;
+						if (!success)
+						{
+							ccLog::Warning("[STL] Not enough memory: can't store normals!");
+							mesh->removePerTriangleNormalIndexes();
+							mesh->setTriNormsTable(nullptr);
+							normals->release();
+							normals = nullptr;
+						}
+					}
 				}
 
-				if (normals)
+				// let's add the new triangles
+				for (unsigned j = 0; j < chunkFaceCount; ++j)
 				{
-					bool success = normals->reserveSafe(mesh->capacity());
-					if (success && faceCount == 0) // specific case: allocate per triangle normal indexes the first time!
-					{
-						success = mesh->reservePerTriangleNormalIndexes();
-					}
+					mesh->addTriangle(pointCount, pointCount + 1, pointCount + 2);
+					pointCount += 3;
+					++faceCount;
 
-					if (!success)
+					// and a new normal?
+					if (normals)
 					{
-						ccLog::Warning("[STL] Not enough memory: can't store normals!");
-						mesh->removePerTriangleNormalIndexes();
-						mesh->setTriNormsTable(nullptr);
-						normals->release();
-						normals = nullptr;
+						int index = -1;
+						if (chunk.validNormals[j])
+						{
+							// compressed normal
+							index = static_cast<int>(normals->currentSize());
+							normals->addElement(chunk.normals[j]);
+						}
+						mesh->addTriangleNormalIndexes(index, index, index);
 					}
 				}
 			}
 
-			mesh->addTriangle(vertIndexes[0], vertIndexes[1], vertIndexes[2]);
-			++faceCount;
-		}
-
-		// and a new normal?
-		if (normals)
-		{
-			int index = -1;
-			if (normalIsOk)
-			{
-				// compress normal
-				index                     = static_cast<int>(normals->currentSize());
-				CompressedNormType nIndex = ccNormalVectors::GetNormIndex(N.u);
-				normals->addElement(nIndex);
-			}
-			mesh->addTriangleNormalIndexes(index, index, index);
-		}
-
-		// 6th line: 'endloop'
-		{
-			QString currentLine = stream.readLine();
-			if (currentLine.isEmpty()
-			    || fp.error() != QFile::NoError
-			    || !QString(currentLine).trimmed().toUpper().startsWith("ENDLOOP"))
+			if (chunk.error != CC_FERR_NO_ERROR)
 			{
-				ccLog::Warning("[STL] Error: expecting 'endnloop' on line #%i", lineCount + 1);
-				result = CC_FERR_MALFORMED_FILE;
+				ccLog::Warning(chunk.errorMessage, lineCount + chunk.errorLine);
+				result = chunk.error;
 				break;
 			}
-			++lineCount;
+
+			lineCount += chunk.lineCount;
+			endOfSolid = chunk.endOfSolid;
+			chunk.release();
 		}
 
-		// 7th and last line: 'endfacet'
+		if (CC_FERR_NO_ERROR != result)
 		{
-			QString currentLine = stream.readLine();
-			if (currentLine.isEmpty()
-			    || fp.error() != QFile::NoError
-			    || !QString(currentLine).trimmed().toUpper().startsWith("ENDFACET"))
-			{
-				ccLog::Warning("[STL] Error: expecting 'endfacet' on line #%i", lineCount + 1);
-				result = CC_FERR_MALFORMED_FILE;
-				break;
-			}
-			++lineCount;
+			break;
 		}
 
 		// progress
-		if (pDlg && (faceCount % 1024) == 0)
+		if (pDlg)
 		{
 			if (pDlg->wasCanceled())
 				break;
-			pDlg->setValue(static_cast<int>(faceCount >> 10));
+			pDlg->setValue(groupEnd);
+			QApplication::processEvents();
 		}
 	}
 
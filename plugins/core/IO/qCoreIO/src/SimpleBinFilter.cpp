@@ -20,6 +20,7 @@
 // Qt
 #include <QFileInfo>
 #include <QSettings>
+#include <QtEndian>
 
 // qCC_db
 #include <ccHObjectCaster.h>
@@ -28,12 +29,39 @@
 #include <ccScalarField.h>
 
 // system
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
 
 // header: 32 first bytes
 constexpr size_t c_headerSize = 64;
 // header flag
 constexpr quint16 s_headerFlagSBF = (static_cast<quint16>(42) | static_cast<quint16>(42 << 8));
+// number of points per chunk (spatial index)
+constexpr unsigned c_chunkSize = (1 << 16);
+// number of chunks processed between two progress updates (loading)
+constexpr size_t c_chunksPerBatch = 64;
+
+// partial loading options
+static SimpleBinFilter::LoadingOptions s_loadingOptions;
+
+void SimpleBinFilter::SetLoadingOptions(const LoadingOptions& options)
+{
+	s_loadingOptions = options;
+}
+
+const SimpleBinFilter::LoadingOptions& SimpleBinFilter::GetLoadingOptions()
+{
+	return s_loadingOptions;
+}
 
 SimpleBinFilter::SimpleBinFilter()
     : FileIOFilter({"_Simple binary Filter",
@@ -72,6 +100,50 @@ CC_FILE_ERROR SimpleBinFilter::saveToFile(ccHObject* root, const QString& filena
 
 	ccLog::Print(QString("[SBF] Saving file '%1'...").arg(headerFilename));
 
+	unsigned sfCount    = cloud->getNumberOfScalarFields();
+	unsigned pointCount = cloud->size();
+
+	// internal coordinate shift (to avoid losing precision)
+	// warning: may be different from the cloud 'Global Shift'
+	CCVector3d coordinatesShift = cloud->toGlobal3d(*cloud->getPoint(0));
+
+	// chunk index: bounding-box of each chunk of points (in the internal coordinate system of the data file)
+	std::vector<CCVector3f> chunkBoxes;
+	try
+	{
+		chunkBoxes.resize(2 * static_cast<size_t>((pointCount + c_chunkSize - 1) / c_chunkSize));
+	}
+	catch (const std::bad_alloc&)
+	{
+		// not enough memory (the index is optional)
+		ccLog::Warning("[SBF] Not enough memory to write the chunk index");
+	}
+	{
+		const int chunkCount = static_cast<int>(chunkBoxes.size() / 2);
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+		for (int c = 0; c < chunkCount; ++c)
+		{
+			unsigned   firstIndex = static_cast<unsigned>(c) * c_chunkSize;
+			unsigned   lastIndex  = std::min(firstIndex + c_chunkSize, pointCount);
+			CCVector3f bbMin      = (cloud->toGlobal3d(*cloud->getPoint(firstIndex)) - coordinatesShift).toFloat();
+			CCVector3f bbMax      = bbMin;
+			for (unsigned i = firstIndex + 1; i < lastIndex; ++i)
+			{
+				CCVector3f coords = (cloud->toGlobal3d(*cloud->getPoint(i)) - coordinatesShift).toFloat();
+				bbMin.x           = std::min(bbMin.x, coords.x);
+				bbMin.y           = std::min(bbMin.y, coords.y);
+				bbMin.z           = std::min(bbMin.z, coords.z);
+				bbMax.x           = std::max(bbMax.x, coords.x);
+				bbMax.y           = std::max(bbMax.y, coords.y);
+				bbMax.z           = std::max(bbMax.z, coords.z);
+			}
+			chunkBoxes[2 * c]     = bbMin;
+			chunkBoxes[2 * c + 1] = bbMax;
+		}
+	}
+
 	// write the text file as an INI file
 	{
 		QSettings headerFile(headerFilename, QSettings::IniFormat);
@@ -99,7 +171,6 @@ CC_FILE_ERROR SimpleBinFilter::saveToFile(ccHObject* root, const QString& filena
 		// save the scalar field names (if any)
 		if (cloud->hasScalarFields())
 		{
-			unsigned sfCount = cloud->getNumberOfScalarFields();
 			headerFile.setValue("SFCount", sfCount);
 
 			// try to load the description of each SF
@@ -135,6 +206,20 @@ CC_FILE_ERROR SimpleBinFilter::saveToFile(ccHObject* root, const QString& filena
 			}
 		}
 
+		// save the chunk index (if any)
+		if (!chunkBoxes.empty())
+		{
+			QStringList strChunkBoxes;
+			for (const CCVector3f& corner : chunkBoxes)
+			{
+				strChunkBoxes << QString::number(corner.x, 'g', 9);
+				strChunkBoxes << QString::number(corner.y, 'g', 9);
+				strChunkBoxes << QString::number(corner.z, 'g', 9);
+			}
+			headerFile.setValue("ChunkSize", c_chunkSize);
+			headerFile.setValue("ChunkBoxes", strChunkBoxes);
+		}
+
 		headerFile.endGroup();
 		headerFile.sync();
 	}
@@ -149,10 +234,6 @@ CC_FILE_ERROR SimpleBinFilter::saveToFile(ccHObject* root, const QString& filena
 
 	QDataStream dataStream(&dataFile);
 
-	// internal coordinate shift (to avoid losing precision)
-	// warning: may be different from the cloud 'Global Shift'
-	CCVector3d coordinatesShift = cloud->toGlobal3d(*cloud->getPoint(0));
-
 	// header
 	{
 		size_t writtenBytes = 0;
@@ -173,8 +254,8 @@ CC_FILE_ERROR SimpleBinFilter::saveToFile(ccHObject* root, const QString& filena
 
 		// 2 bytes = sf count
 		{
-			quint16 sfCount = static_cast<uint16_t>(cloud->getNumberOfScalarFields());
-			dataStream << sfCount;
+			quint16 storedSFCount = static_cast<uint16_t>(sfCount);
+			dataStream << storedSFCount;
 		}
 		writtenBytes += 2;
 
@@ -194,9 +275,6 @@ CC_FILE_ERROR SimpleBinFilter::saveToFile(ccHObject* root, const QString& filena
 		}
 	}
 
-	unsigned sfCount    = cloud->getNumberOfScalarFields();
-	unsigned pointCount = cloud->size();
-
 	QScopedPointer<ccProgressDialog> pDlg(nullptr);
 	if (parameters.parentWidget)
 	{
@@ -251,8 +329,28 @@ struct GlobalDescriptor
 	CCVector3d                globalShift;
 	double                    globalScale = 1.0;
 	std::vector<SFDescriptor> SFs;
+	unsigned                  chunkSize = 0;
+	std::vector<CCVector3f>   chunkBoxes; // min and max corners of each chunk (in the internal coordinate system of the data file)
+};
+
+//! Range of points to load
+struct SBFChunk
+{
+	size_t firstPoint  = 0;
+	size_t pointCount  = 0;
+	size_t outputIndex = 0; // index of the first loaded point in the output cloud
+	size_t loadedCount = 0; // number of points loaded
 };
 
+//! Reads a float value (stored as big endian by QDataStream)
+static inline float ReadSBFFloat(const uchar* data)
+{
+	quint32 value = qFromBigEndian<quint32>(data);
+	float   fVal  = 0.0f;
+	std::memcpy(&fVal, &value, sizeof(float));
+	return fVal;
+}
+
 CC_FILE_ERROR SimpleBinFilter::loadFile(const QString& filename, ccHObject& container, LoadParameters& parameters)
 {
 	if (filename.isEmpty())
@@ -342,6 +440,42 @@ CC_FILE_ERROR SimpleBinFilter::loadFile(const QString& filename, ccHObject& cont
 			}
 		}
 
+		// read the chunk index (if any)
+		if (headerFile.contains("ChunkSize") && headerFile.contains("ChunkBoxes"))
+		{
+			bool        ok            = false;
+			int         chunkSize     = headerFile.value("ChunkSize").toInt(&ok);
+			QStringList strChunkBoxes = headerFile.value("ChunkBoxes").toStringList();
+			bool        validIndex    = (ok && chunkSize > 0 && strChunkBoxes.size() % 6 == 0);
+			if (validIndex)
+			{
+				try
+				{
+					descriptor.chunkBoxes.resize(strChunkBoxes.size() / 3);
+				}
+				catch (const std::bad_alloc&)
+				{
+					// not enough memory
+					return CC_FERR_NOT_ENOUGH_MEMORY;
+				}
+
+				for (int i = 0; validIndex && i < strChunkBoxes.size(); ++i)
+				{
+					descriptor.chunkBoxes[i / 3].u[i % 3] = strChunkBoxes[i].toFloat(&validIndex);
+				}
+			}
+
+			if (validIndex)
+			{
+				descriptor.chunkSize = static_cast<unsigned>(chunkSize);
+			}
+			else
+			{
+				ccLog::Warning("[SBF] Invalid chunk index (ignored)");
+				descriptor.chunkBoxes.clear();
+			}
+		}
+
 		// read the scalar field names (if any)
 		if (headerFile.contains("SFCount"))
 		{
@@ -500,34 +634,255 @@ CC_FILE_ERROR SimpleBinFilter::loadFile(const QString& filename, ccHObject& cont
 		return CC_FERR_MALFORMED_FILE;
 	}
 
+	// default SF names
+	for (size_t i = 0; i < descriptor.SFs.size(); ++i)
+	{
+		SFDescriptor& sfDesc = descriptor.SFs[i];
+		if (sfDesc.name.isEmpty())
+		{
+			sfDesc.name = QString("Scalar field #%1").arg(i + 1);
+		}
+	}
+
+	// partial loading
+	LoadingOptions options    = s_loadingOptions;
+	size_t         firstPoint = std::min(static_cast<size_t>(options.firstPoint), descriptor.pointCount);
+	size_t         lastPoint  = descriptor.pointCount;
+	if (options.maxPointCount != 0 && options.maxPointCount < lastPoint - firstPoint)
+	{
+		lastPoint = firstPoint + static_cast<size_t>(options.maxPointCount);
+	}
+
+	// scalar fields to load
+	std::vector<size_t> loadedSFs; // SF descriptor indexes
+	for (size_t i = 0; i < descriptor.SFs.size(); ++i)
+	{
+		if (options.scalarFields.empty() || options.scalarFields.contains(descriptor.SFs[i].name))
+		{
+			loadedSFs.push_back(i);
+		}
+	}
+
+	// the chunk index is only valid if it's consistent with the data file
+	size_t chunkSize = c_chunkSize;
+	bool   useIndex  = false;
+	if (descriptor.chunkSize != 0)
+	{
+		if (descriptor.chunkBoxes.size() == 2 * ((descriptor.pointCount + descriptor.chunkSize - 1) / descriptor.chunkSize))
+		{
+			chunkSize = descriptor.chunkSize;
+			useIndex  = true;
+		}
+		else
+		{
+			ccLog::Warning("[SBF] Chunk index is inconsistent with the data file (ignored)");
+		}
+	}
+
+	// chunks of points to load
+	std::vector<SBFChunk> chunks;
+	try
+	{
+		for (size_t c = firstPoint / chunkSize; c * chunkSize < lastPoint; ++c)
+		{
+			if (options.useBox && useIndex)
+			{
+				// skip the chunks that are entirely outside of the box
+				CCVector3d bbMin = coordinatesShift + descriptor.chunkBoxes[2 * c];
+				CCVector3d bbMax = coordinatesShift + descriptor.chunkBoxes[2 * c + 1];
+				if (bbMax.x < options.boxMin.x || bbMax.y < options.boxMin.y || bbMax.z < options.boxMin.z
+				    || bbMin.x > options.boxMax.x || bbMin.y > options.boxMax.y || bbMin.z > options.boxMax.z)
+				{
+					continue;
+				}
+			}
+
+			SBFChunk chunk;
+			chunk.firstPoint = std::max(c * chunkSize, firstPoint);
+			chunk.pointCount = std::min((c + 1) * chunkSize, lastPoint) - chunk.firstPoint;
+			chunks.push_back(chunk);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		// not enough memory
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+	const int chunkCount = static_cast<int>(chunks.size());
+
+	// we map the data file (if possible)
+	uchar* mappedData = dataFile.map(0, dataFile.size());
+	if (!mappedData)
+	{
+		ccLog::Warning("[SBF] Failed to map the data file (the file will be read sequentially)");
+	}
+
+	// returns the data of a given chunk
+	auto getChunkData = [&](const SBFChunk& chunk, QByteArray& buffer) -> const uchar*
+	{
+		qint64 offset = static_cast<qint64>(c_headerSize + chunk.firstPoint * sizePerPoint);
+		if (mappedData)
+		{
+			return mappedData + offset;
+		}
+
+		// not thread-safe (but the chunks are then processed sequentially)
+		buffer.resize(static_cast<int>(chunk.pointCount * sizePerPoint));
+		if (!dataFile.seek(offset) || dataFile.read(buffer.data(), buffer.size()) != buffer.size())
+		{
+			return nullptr;
+		}
+		return reinterpret_cast<const uchar*>(buffer.constData());
+	};
+
+	// returns whether a point is inside the box (if any)
+	auto isInside = [&](const CCVector3d& Pd)
+	{
+		return !options.useBox
+		       || (Pd.x >= options.boxMin.x && Pd.y >= options.boxMin.y && Pd.z >= options.boxMin.z
+		           && Pd.x <= options.boxMax.x && Pd.y <= options.boxMax.y && Pd.z <= options.boxMax.z);
+	};
+
+	// count the points to load
+	std::atomic<bool> readError(false);
+	if (options.useBox)
+	{
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads()) schedule(dynamic) if (mappedData)
+#endif
+		for (int c = 0; c < chunkCount; ++c)
+		{
+			SBFChunk&    chunk = chunks[c];
+			QByteArray   buffer;
+			const uchar* data = getChunkData(chunk, buffer);
+			if (!data)
+			{
+				readError = true;
+				continue;
+			}
+
+			for (size_t i = 0; i < chunk.pointCount; ++i, data += sizePerPoint)
+			{
+				CCVector3f Pf(ReadSBFFloat(data), ReadSBFFloat(data + 4), ReadSBFFloat(data + 8));
+				if (isInside(coordinatesShift + Pf))
+				{
+					++chunk.loadedCount;
+				}
+			}
+		}
+	}
+	else
+	{
+		for (SBFChunk& chunk : chunks)
+		{
+			chunk.loadedCount = chunk.pointCount;
+		}
+	}
+
+	if (readError)
+	{
+		ccLog::Warning("[SBF] Failed to read the data file");
+		return CC_FERR_READING;
+	}
+
+	size_t totalCount = 0;
+	for (SBFChunk& chunk : chunks)
+	{
+		chunk.outputIndex = totalCount;
+		totalCount += chunk.loadedCount;
+	}
+
+	if (totalCount == 0)
+	{
+		ccLog::Warning("[SBF] No point to load (check the partial loading options)");
+		return CC_FERR_NO_LOAD;
+	}
+	if (totalCount > std::numeric_limits<unsigned>::max())
+	{
+		ccLog::Error("[SBF] Too many points to load at once (use partial loading)");
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+
+	// load-time filter (applied on each batch of decoded points)
+	ccLoadingFilter* loadingFilter = (parameters.loadingFilter && parameters.loadingFilter->isActive() ? parameters.loadingFilter.data() : nullptr);
+	// the whole cloud is allocated at once, unless the points are filtered on the fly
+	const unsigned initialCount = (loadingFilter ? 0 : static_cast<unsigned>(totalCount));
+
 	// init structures
 	QScopedPointer<ccPointCloud> cloud(new ccPointCloud("unnamed"));
-	if (!cloud->reserve(static_cast<unsigned>(descriptor.pointCount)))
+	if (!cloud->resize(initialCount))
 	{
 		return CC_FERR_NOT_ENOUGH_MEMORY;
 	}
 
-	QScopedPointer<ccProgressDialog> pDlg(nullptr);
-	if (parameters.parentWidget)
+	// first loaded point: check for 'big' coordinates
 	{
-		pDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
-		pDlg->setMethodTitle(QObject::tr("Simple BIN file"));
-		pDlg->setInfo(QObject::tr("Loading %1 points / %2 scalar field(s)").arg(descriptor.pointCount).arg(descriptor.SFs.size()));
-		pDlg->setModal(true);
-		pDlg->start();
+		CCVector3d Pd(0, 0, 0);
+		for (const SBFChunk& chunk : chunks)
+		{
+			if (chunk.loadedCount == 0)
+			{
+				continue;
+			}
+
+			QByteArray   buffer;
+			const uchar* data = getChunkData(chunk, buffer);
+			if (!data)
+			{
+				ccLog::Warning("[SBF] Failed to read the data file");
+				return CC_FERR_READING;
+			}
+			for (size_t i = 0; i < chunk.pointCount; ++i, data += sizePerPoint)
+			{
+				CCVector3f Pf(ReadSBFFloat(data), ReadSBFFloat(data + 4), ReadSBFFloat(data + 8));
+				Pd = coordinatesShift + Pf;
+				if (isInside(Pd))
+				{
+					break;
+				}
+			}
+			break;
+		}
+
+		// backup input global parameters
+		ccGlobalShiftManager::Mode csModeBackup   = parameters.shiftHandlingMode;
+		bool                       useGlobalShift = false;
+		CCVector3d                 Pshift(0, 0, 0);
+		if ((descriptor.globalShift.norm2() != 0 || descriptor.globalScale != 1.0) && ((nullptr == parameters._coordinatesShiftEnabled) || (false == *parameters._coordinatesShiftEnabled)))
+		{
+			if (csModeBackup != ccGlobalShiftManager::NO_DIALOG) // No dialog, practically means that we don't want any shift!
+			{
+				useGlobalShift = true;
+				Pshift         = descriptor.globalShift;
+				if (csModeBackup != ccGlobalShiftManager::NO_DIALOG_AUTO_SHIFT)
+				{
+					parameters.shiftHandlingMode = ccGlobalShiftManager::ALWAYS_DISPLAY_DIALOG;
+				}
+			}
+		}
+
+		bool preserveCoordinateShift = true;
+		if (HandleGlobalShift(Pd, Pshift, preserveCoordinateShift, parameters, true))
+		{
+			// set global shift
+			descriptor.globalShift = Pshift;
+			if (preserveCoordinateShift)
+			{
+				cloud->setGlobalShift(descriptor.globalShift);
+			}
+			ccLog::Warning("[SBF] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", descriptor.globalShift.x, descriptor.globalShift.y, descriptor.globalShift.z);
+		}
+
+		// restore previous parameters
+		parameters.shiftHandlingMode = csModeBackup;
 	}
-	CCCoreLib::NormalizedProgress nProgress(pDlg.data(), static_cast<unsigned>(descriptor.pointCount));
 
 	// reserve memory
-	for (size_t i = 0; i < descriptor.SFs.size(); ++i)
+	for (size_t sfIndex : loadedSFs)
 	{
-		SFDescriptor& sfDesc = descriptor.SFs[i];
-		if (sfDesc.name.isEmpty())
-		{
-			sfDesc.name = QString("Scalar field #%1").arg(i + 1);
-		}
-		sfDesc.sf = new ccScalarField(sfDesc.name.toStdString());
-		if (!sfDesc.sf->reserveSafe(static_cast<unsigned>(descriptor.pointCount)))
+		SFDescriptor& sfDesc = descriptor.SFs[sfIndex];
+		sfDesc.sf            = new ccScalarField(sfDesc.name.toStdString());
+		if (!sfDesc.sf->resizeSafe(initialCount))
 		{
 			sfDesc.sf->release();
 			sfDesc.sf = nullptr;
@@ -548,88 +903,131 @@ CC_FILE_ERROR SimpleBinFilter::loadFile(const QString& filename, ccHObject& cont
 		}
 	}
 
-	// we can eventually load the data
-	dataStream.setFloatingPointPrecision(QDataStream::SinglePrecision); // we expect only 'float' values in the data
-	for (size_t i = 0; i < descriptor.pointCount; ++i)
+	const size_t batchCount = (chunks.size() + c_chunksPerBatch - 1) / c_chunksPerBatch;
+
+	QScopedPointer<ccProgressDialog> pDlg(nullptr);
+	if (parameters.parentWidget)
+	{
+		pDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
+		pDlg->setMethodTitle(QObject::tr("Simple BIN file"));
+		pDlg->setInfo(QObject::tr("Loading %1 points / %2 scalar field(s)").arg(totalCount).arg(loadedSFs.size()));
+		pDlg->setModal(true);
+		pDlg->start();
+	}
+	CCCoreLib::NormalizedProgress nProgress(pDlg.data(), static_cast<unsigned>(batchCount));
+
+	// we can eventually load the data (the chunks are decoded in parallel)
+	const CCVector3d globalShift = descriptor.globalShift;
+	size_t           loadedCount = 0;
+	for (size_t batchStart = 0; batchStart < chunks.size(); batchStart += c_chunksPerBatch)
 	{
-		// read the point coordinates
-		CCVector3f Pf;
-		dataStream >> Pf.x;
-		dataStream >> Pf.y;
-		dataStream >> Pf.z;
+		const int    batchEnd        = static_cast<int>(std::min(batchStart + c_chunksPerBatch, chunks.size()));
+		const size_t batchFirstIndex = chunks[batchStart].outputIndex;
+		const size_t batchLastIndex  = (batchEnd == chunkCount ? totalCount : chunks[batchEnd].outputIndex);
 
-		CCVector3d Pd = coordinatesShift + Pf;
+		// index of the first point of the batch in the cloud
+		size_t batchOffset = batchFirstIndex;
+		if (loadingFilter)
+		{
+			// the batch points are decoded after the points kept so far
+			batchOffset = cloud->size();
+			if (!cloud->resize(static_cast<unsigned>(batchOffset + batchLastIndex - batchFirstIndex)))
+			{
+				return CC_FERR_NOT_ENOUGH_MEMORY;
+			}
+		}
 
-		if (i == 0)
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads()) schedule(dynamic) if (mappedData)
+#endif
+		for (int c = static_cast<int>(batchStart); c < batchEnd; ++c)
 		{
-			// backup input global parameters
-			ccGlobalShiftManager::Mode csModeBackup   = parameters.shiftHandlingMode;
-			bool                       useGlobalShift = false;
-			CCVector3d                 Pshift(0, 0, 0);
-			if ((descriptor.globalShift.norm2() != 0 || descriptor.globalScale != 1.0) && ((nullptr == parameters._coordinatesShiftEnabled) || (false == *parameters._coordinatesShiftEnabled)))
+			const SBFChunk& chunk = chunks[c];
+			QByteArray      buffer;
+			const uchar*    data = getChunkData(chunk, buffer);
+			if (!data)
 			{
-				if (csModeBackup != ccGlobalShiftManager::NO_DIALOG) // No dialog, practically means that we don't want any shift!
-				{
-					useGlobalShift = true;
-					Pshift         = descriptor.globalShift;
-					if (csModeBackup != ccGlobalShiftManager::NO_DIALOG_AUTO_SHIFT)
-					{
-						parameters.shiftHandlingMode = ccGlobalShiftManager::ALWAYS_DISPLAY_DIALOG;
-					}
-				}
+				readError = true;
+				continue;
 			}
 
-			bool preserveCoordinateShift = true;
-			if (HandleGlobalShift(Pd, Pshift, preserveCoordinateShift, parameters, true))
+			unsigned pointIndex = static_cast<unsigned>(chunk.outputIndex - batchFirstIndex + batchOffset);
+			for (size_t i = 0; i < chunk.pointCount; ++i, data += sizePerPoint)
 			{
-				// set global shift
-				descriptor.globalShift = Pshift;
-				if (preserveCoordinateShift)
+				// read the point coordinates
+				CCVector3f Pf(ReadSBFFloat(data), ReadSBFFloat(data + 4), ReadSBFFloat(data + 8));
+				CCVector3d Pd = coordinatesShift + Pf;
+				if (!isInside(Pd))
 				{
-					cloud->setGlobalShift(descriptor.globalShift);
+					continue;
 				}
-				ccLog::Warning("[SBF] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", descriptor.globalShift.x, descriptor.globalShift.y, descriptor.globalShift.z);
-			}
 
-			// restore previous parameters
-			parameters.shiftHandlingMode = csModeBackup;
+				*const_cast<CCVector3*>(cloud->getPoint(pointIndex)) = (Pd + globalShift).toPC();
+
+				// and now for the scalar values
+				for (size_t sfIndex : loadedSFs)
+				{
+					const SFDescriptor& sfDesc = descriptor.SFs[sfIndex];
+					float               fVal   = ReadSBFFloat(data + 12 + 4 * sfIndex);
+					ScalarType          val    = sfDesc.offset + fVal;
+					sfDesc.sf->setValue(pointIndex, val);
+				}
+
+				++pointIndex;
+			}
 		}
 
-		CCVector3 P = (Pd + descriptor.globalShift).toPC();
-		cloud->addPoint(P);
+		if (readError)
+		{
+			ccLog::Warning("[SBF] Failed to read the data file");
+			return CC_FERR_READING;
+		}
 
-		// and now for the scalar values
-		for (SFDescriptor& sfDesc : descriptor.SFs)
+		if (loadingFilter)
 		{
-			float fVal;
-			dataStream >> fVal;
-			ScalarType val = sfDesc.offset + fVal;
-			sfDesc.sf->addElement(val);
+			loadingFilter->filter(cloud.data(), static_cast<unsigned>(batchOffset));
 		}
 
+		loadedCount = batchLastIndex;
+
 		if (!nProgress.oneStep())
 		{
 			break;
 		}
 	}
 
+	if (mappedData)
+	{
+		dataFile.unmap(mappedData);
+	}
 	dataFile.close();
 
-	if (cloud->size() == 0)
+	if (loadedCount == 0)
 	{
 		return CC_FERR_CANCELED_BY_USER;
 	}
-	else if (cloud->size() < descriptor.pointCount)
+	else if (loadingFilter)
+	{
+		if (cloud->size() == 0)
+		{
+			ccLog::Warning("[SBF] No point passed the loading filter");
+			return CC_FERR_NO_LOAD;
+		}
+		cloud->shrinkToFit();
+	}
+	else if (loadedCount < totalCount)
 	{
+		cloud->resize(static_cast<unsigned>(loadedCount));
 		cloud->shrinkToFit();
 	}
+	cloud->invalidateBoundingBox();
 
 	// update scalar fields
-	if (!descriptor.SFs.empty())
+	if (!loadedSFs.empty())
 	{
-		for (auto& SF : descriptor.SFs)
+		for (size_t sfIndex : loadedSFs)
 		{
-			SF.sf->computeMinAndMax();
+			descriptor.SFs[sfIndex].sf->computeMinAndMax();
 		}
 		cloud->setCurrentDisplayedScalarField(0);
 		cloud->showSF(true);
@@ -38,7 +38,7 @@ VTKFilter::VTKFilter()
                     "vtk",
                     QStringList{"VTK cloud or mesh (*.vtk)"},
                     QStringList{"VTK cloud or mesh (*.vtk)"},
-                    Import | Export})
+                    Import | Export | ConcurrentLoad})
 {
 }
 
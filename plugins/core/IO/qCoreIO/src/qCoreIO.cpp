@@ -24,6 +24,7 @@
 #include "ObjFilter.h"
 #include "PDMSFilter.h"
 #include "PTXFilter.h"
+#include "SBFCommand.h"
 #include "STLFilter.h"
 #include "SimpleBinFilter.h"
 #include "VTKFilter.h"
@@ -36,7 +37,7 @@ qCoreIO::qCoreIO(QObject* parent)
 
 void qCoreIO::registerCommands(ccCommandLineInterface* inCmdLine)
 {
-	Q_UNUSED(inCmdLine);
+	inCmdLine->registerCommand(ccCommandLineInterface::Command::Shared(new SBFCommand));
 }
 
 ccIOPluginInterface::FilterList qCoreIO::getFilters()
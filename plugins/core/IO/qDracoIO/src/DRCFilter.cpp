@@ -22,18 +22,73 @@
 // qCC_db
 #include <ccLog.h>
 #include <ccMesh.h>
+#include <ccNormalVectors.h>
 #include <ccPointCloud.h>
 #include <ccScalarField.h>
 
 // CCCoreLib
 #include <CCPlatform.h>
 
+// Qt
+#include <QDataStream>
+#include <QFile>
+#include <QScopedPointer>
+
 // draco
 #include <draco/compression/decode.h>
 #include <draco/compression/encode.h>
 #include <draco/mesh/mesh.h>
 #include <draco/point_cloud/point_cloud.h>
 
+// System
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
+//! Chunked DRACO cloud (CloudCompare container)
+/** Big clouds can be split in spatially coherent chunks, encoded independently (in parallel)
+    so that they can be decoded in parallel as well, or only partially (e.g. the chunks inside a box).
+
+    Layout (little endian):
+    - magic number "CCDRCCHK" (8 bytes), version (uint32), number of chunks (uint32)
+    - for each chunk: offset and size of its DRACO buffer in the file (uint64 each), number of points (uint32),
+      bounding-box min and max corners (3 + 3 doubles, in the original coordinate system)
+    - the DRACO buffers (each one is a standard DRACO point cloud)
+**/
+static const char s_chunkedMagic[]     = "CCDRCCHK";
+constexpr qint64  c_chunkedMagicSize   = 8;
+constexpr quint32 c_chunkedVersion     = 1;
+constexpr qint64  c_chunkedHeaderSize  = c_chunkedMagicSize + 4 + 4;
+constexpr qint64  c_chunkedEntrySize   = 8 + 8 + 4 + 6 * 8;
+
+//! Chunk of a chunked DRACO cloud
+struct DracoChunkEntry
+{
+	quint64    offset     = 0;
+	quint64    size       = 0;
+	quint32    pointCount = 0;
+	CCVector3d bbMin;
+	CCVector3d bbMax;
+};
+
+//! DRACO encoding options
+struct DracoEncodingOptions
+{
+	int coordQuantization    = 11;
+	int texCoordQuantization = 10;
+	int normalQuantization   = 8;
+	int sfQuantization       = 8;
+};
+
 DRCFilter::DRCFilter()
     : FileIOFilter({"_Draco DRC Filter",
                     12.0f, // priority
@@ -41,7 +96,7 @@ DRCFilter::DRCFilter()
                     "drc",
                     QStringList{"DRC cloud or mesh (*.drc)"},
                     QStringList{"DRC cloud or mesh (*.drc)"},
-                    Import | Export})
+                    Import | Export | ConcurrentLoad})
 {
 }
 
@@ -57,11 +112,34 @@ bool DRCFilter::canSave(CC_CLASS_ENUM type, bool& multiple, bool& exclusive) con
 	return false;
 }
 
-static CC_FILE_ERROR CCCloudToDraco(const ccGenericPointCloud& ccCloud, draco::PointCloud& dracoCloud)
+static void InitEncoder(draco::Encoder& encoder, const DracoEncodingOptions& options)
+{
+	encoder.SetSpeedOptions(0, 0);
+	encoder.SetAttributeQuantization(draco::GeometryAttribute::POSITION, options.coordQuantization);
+	encoder.SetAttributeQuantization(draco::GeometryAttribute::TEX_COORD, options.texCoordQuantization);
+	encoder.SetAttributeQuantization(draco::GeometryAttribute::NORMAL, options.normalQuantization);
+	encoder.SetAttributeQuantization(draco::GeometryAttribute::GENERIC, options.sfQuantization);
+}
+
+//! Converts a cloud (or a subset of it) to a DRACO cloud
+/** \param ccCloud input cloud
+    \param dracoCloud output DRACO cloud
+    \param pointIndexes indexes of the points to convert (or nullptr to convert the whole cloud)
+    \param indexCount number of indexes (if 'pointIndexes' is not nullptr)
+**/
+static CC_FILE_ERROR CCCloudToDraco(const ccGenericPointCloud& ccCloud,
+                                    draco::PointCloud&         dracoCloud,
+                                    const unsigned*            pointIndexes = nullptr,
+                                    unsigned                   indexCount   = 0)
 {
-	unsigned pointCount = ccCloud.size();
+	const unsigned pointCount = (pointIndexes ? indexCount : ccCloud.size());
 	dracoCloud.set_num_points(pointCount);
 
+	// the points are converted in parallel (unless we are already in a parallel section)
+	const int count = static_cast<int>(pointCount);
+	auto      index = [pointIndexes](int i)
+	{ return pointIndexes ? pointIndexes[i] : static_cast<unsigned>(i); };
+
 	draco::DataType dt      = draco::DT_FLOAT32;
 	bool            shifted = ccCloud.isShifted();
 	if (shifted)
@@ -83,16 +161,22 @@ static CC_FILE_ERROR CCCloudToDraco(const ccGenericPointCloud& ccCloud, draco::P
 
 		if (dt == draco::DT_FLOAT32)
 		{
-			for (draco::PointIndex::ValueType i = 0; i < pointCount; ++i)
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+			for (int i = 0; i < count; ++i)
 			{
-				pointAttribute->SetAttributeValue(draco::AttributeValueIndex(i), ccCloud.getPoint(i)->u);
+				pointAttribute->SetAttributeValue(draco::AttributeValueIndex(i), ccCloud.getPoint(index(i))->u);
 			}
 		}
 		else // draco::DT_FLOAT64
 		{
-			for (draco::PointIndex::ValueType i = 0; i < pointCount; ++i)
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+			for (int i = 0; i < count; ++i)
 			{
-				CCVector3 Plocal = *(ccCloud.getPoint(i));
+				CCVector3 Plocal = *(ccCloud.getPoint(index(i)));
 				pointAttribute->SetAttributeValue(draco::AttributeValueIndex(i), ccCloud.toGlobal3d(Plocal).u);
 			}
 		}
@@ -108,9 +192,12 @@ static CC_FILE_ERROR CCCloudToDraco(const ccGenericPointCloud& ccCloud, draco::P
 		draco::PointAttribute* normalAttribute = dracoCloud.attribute(normalAttributeID);
 		if (nullptr != normalAttribute)
 		{
-			for (draco::PointIndex::ValueType i = 0; i < pointCount; ++i)
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+			for (int i = 0; i < count; ++i)
 			{
-				normalAttribute->SetAttributeValue(draco::AttributeValueIndex(i), ccCloud.getPointNormal(i).u);
+				normalAttribute->SetAttributeValue(draco::AttributeValueIndex(i), ccCloud.getPointNormal(index(i)).u);
 			}
 		}
 		else
@@ -129,9 +216,12 @@ static CC_FILE_ERROR CCCloudToDraco(const ccGenericPointCloud& ccCloud, draco::P
 		draco::PointAttribute* colorAttribute = dracoCloud.attribute(colorAttributeID);
 		if (nullptr != colorAttribute)
 		{
-			for (draco::PointIndex::ValueType i = 0; i < pointCount; ++i)
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+			for (int i = 0; i < count; ++i)
 			{
-				colorAttribute->SetAttributeValue(draco::AttributeValueIndex(i), ccCloud.getPointColor(i).rgba);
+				colorAttribute->SetAttributeValue(draco::AttributeValueIndex(i), ccCloud.getPointColor(index(i)).rgba);
 			}
 		}
 		else
@@ -143,7 +233,7 @@ static CC_FILE_ERROR CCCloudToDraco(const ccGenericPointCloud& ccCloud, draco::P
 	// create generic attribute (if any)
 	if (ccCloud.hasScalarFields())
 	{
-		if (ccCloud.isA(CC_TYPES::POINT_CLOUD))
+		if (ccCloud.isA(CC_TYPES::POINT_CLOUD) && !pointIndexes) // the chunked export issues this warning only once
 		{
 			const ccPointCloud& cc = static_cast<const ccPointCloud&>(ccCloud);
 			// DGM: it seems DRACO supports only one "Generic" field
@@ -160,9 +250,12 @@ static CC_FILE_ERROR CCCloudToDraco(const ccGenericPointCloud& ccCloud, draco::P
 		draco::PointAttribute* sfAttribute = dracoCloud.attribute(sfAttributeID);
 		if (nullptr != sfAttribute)
 		{
-			for (draco::PointIndex::ValueType i = 0; i < pointCount; ++i)
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+			for (int i = 0; i < count; ++i)
 			{
-				float sfValue = ccCloud.getPointScalarValue(i);
+				float sfValue = ccCloud.getPointScalarValue(index(i));
 				sfAttribute->SetAttributeValue(draco::AttributeValueIndex(i), &sfValue);
 			}
 		}
@@ -268,6 +361,192 @@ static CC_FILE_ERROR CCMeshToDraco(ccGenericMesh& ccMesh, draco::Mesh& dracoMesh
 	return CC_FERR_NO_ERROR;
 }
 
+//! Splits a cloud in spatially coherent chunks (kd-tree leaves) of at most 'maxChunkSize' points
+/** \param cloud input cloud
+    \param maxChunkSize max number of points per chunk
+    \param indexes output point indexes (sorted by chunk)
+    \param chunks output chunks (as ranges of the 'indexes' vector)
+    \return success
+**/
+static bool SplitInChunks(const ccGenericPointCloud&                   cloud,
+                          unsigned                                     maxChunkSize,
+                          std::vector<unsigned>&                       indexes,
+                          std::vector<std::pair<unsigned, unsigned>>& chunks)
+{
+	try
+	{
+		indexes.resize(cloud.size());
+		std::iota(indexes.begin(), indexes.end(), 0);
+
+		std::vector<std::pair<unsigned, unsigned>> ranges{{0, cloud.size()}};
+		while (!ranges.empty())
+		{
+			const std::pair<unsigned, unsigned> range = ranges.back();
+			ranges.pop_back();
+
+			const unsigned count = range.second - range.first;
+			if (count <= maxChunkSize)
+			{
+				chunks.push_back(range);
+				continue;
+			}
+
+			// we split the range along the largest dimension of its bounding-box
+			CCVector3 bbMin = *cloud.getPoint(indexes[range.first]);
+			CCVector3 bbMax = bbMin;
+			for (unsigned i = range.first + 1; i < range.second; ++i)
+			{
+				const CCVector3* P = cloud.getPoint(indexes[i]);
+				for (unsigned char d = 0; d < 3; ++d)
+				{
+					bbMin.u[d] = std::min(bbMin.u[d], P->u[d]);
+					bbMax.u[d] = std::max(bbMax.u[d], P->u[d]);
+				}
+			}
+			const CCVector3     diag = bbMax - bbMin;
+			const unsigned char dim  = (diag.x >= diag.y ? (diag.x >= diag.z ? 0 : 2) : (diag.y >= diag.z ? 1 : 2));
+
+			const unsigned middle = range.first + count / 2;
+			std::nth_element(indexes.begin() + range.first,
+			                 indexes.begin() + middle,
+			                 indexes.begin() + range.second,
+			                 [&cloud, dim](unsigned a, unsigned b)
+			                 { return cloud.getPoint(a)->u[dim] < cloud.getPoint(b)->u[dim]; });
+
+			// the second half is pushed first, so that the chunks are output in a spatially coherent order
+			ranges.emplace_back(middle, range.second);
+			ranges.emplace_back(range.first, middle);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+//! Saves a cloud as a chunked DRACO cloud (the chunks are encoded in parallel)
+static CC_FILE_ERROR SaveChunkedCloud(const ccGenericPointCloud& ccCloud, unsigned maxChunkSize, const DracoEncodingOptions& options, QFile& file)
+{
+	std::vector<unsigned>                      indexes;
+	std::vector<std::pair<unsigned, unsigned>> ranges;
+	if (!SplitInChunks(ccCloud, maxChunkSize, indexes, ranges))
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+
+	if (ccCloud.isA(CC_TYPES::POINT_CLOUD) && static_cast<const ccPointCloud&>(ccCloud).getNumberOfScalarFields() > 1)
+	{
+		// DGM: it seems DRACO supports only one "Generic" field
+		ccLog::Warning(QString("[DRACO] Cloud %1 has multiple scalar fields, however, only one can be saved (the active one by default)").arg(ccCloud.getName()));
+	}
+
+	struct EncodedChunk
+	{
+		DracoChunkEntry      entry;
+		draco::EncoderBuffer buffer;
+		CC_FILE_ERROR        error = CC_FERR_NO_ERROR;
+	};
+
+	const int                 chunkCount = static_cast<int>(ranges.size());
+	std::vector<EncodedChunk> chunks;
+	try
+	{
+		chunks.resize(ranges.size());
+	}
+	catch (const std::bad_alloc&)
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads()) schedule(dynamic)
+#endif
+	for (int c = 0; c < chunkCount; ++c)
+	{
+		EncodedChunk&   chunk        = chunks[c];
+		const unsigned* chunkIndexes = indexes.data() + ranges[c].first;
+		chunk.entry.pointCount       = ranges[c].second - ranges[c].first;
+
+		// bounding-box (in the original coordinate system)
+		chunk.entry.bbMin = chunk.entry.bbMax = ccCloud.toGlobal3d(*ccCloud.getPoint(chunkIndexes[0]));
+		for (quint32 i = 1; i < chunk.entry.pointCount; ++i)
+		{
+			const CCVector3d P = ccCloud.toGlobal3d(*ccCloud.getPoint(chunkIndexes[i]));
+			for (unsigned char d = 0; d < 3; ++d)
+			{
+				chunk.entry.bbMin.u[d] = std::min(chunk.entry.bbMin.u[d], P.u[d]);
+				chunk.entry.bbMax.u[d] = std::max(chunk.entry.bbMax.u[d], P.u[d]);
+			}
+		}
+
+		try
+		{
+			draco::PointCloud dracoCloud;
+			chunk.error = CCCloudToDraco(ccCloud, dracoCloud, chunkIndexes, chunk.entry.pointCount);
+			if (chunk.error == CC_FERR_NO_ERROR)
+			{
+				draco::Encoder encoder;
+				InitEncoder(encoder, options);
+				if (!encoder.EncodePointCloudToBuffer(dracoCloud, &chunk.buffer).ok())
+				{
+					chunk.error = CC_FERR_THIRD_PARTY_LIB_FAILURE;
+				}
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			chunk.error = CC_FERR_NOT_ENOUGH_MEMORY;
+		}
+	}
+
+	for (const EncodedChunk& chunk : chunks)
+	{
+		if (chunk.error != CC_FERR_NO_ERROR)
+		{
+			return chunk.error;
+		}
+	}
+
+	// write the header
+	QDataStream stream(&file);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+	stream.writeRawData(s_chunkedMagic, static_cast<int>(c_chunkedMagicSize));
+	stream << c_chunkedVersion << static_cast<quint32>(chunkCount);
+
+	quint64 offset = static_cast<quint64>(c_chunkedHeaderSize + chunkCount * c_chunkedEntrySize);
+	for (EncodedChunk& chunk : chunks)
+	{
+		chunk.entry.offset = offset;
+		chunk.entry.size   = static_cast<quint64>(chunk.buffer.size());
+		offset += chunk.entry.size;
+
+		stream << chunk.entry.offset << chunk.entry.size << chunk.entry.pointCount;
+		stream << chunk.entry.bbMin.x << chunk.entry.bbMin.y << chunk.entry.bbMin.z;
+		stream << chunk.entry.bbMax.x << chunk.entry.bbMax.y << chunk.entry.bbMax.z;
+	}
+	if (stream.status() != QDataStream::Ok)
+	{
+		return CC_FERR_WRITING;
+	}
+
+	// and the DRACO buffers
+	for (const EncodedChunk& chunk : chunks)
+	{
+		if (file.write(chunk.buffer.data(), static_cast<qint64>(chunk.buffer.size())) != static_cast<qint64>(chunk.buffer.size()))
+		{
+			return CC_FERR_WRITING;
+		}
+	}
+
+	ccLog::Print(QString("[DRACO] Cloud saved as %1 chunks").arg(chunkCount));
+
+	return CC_FERR_NO_ERROR;
+}
+
 CC_FILE_ERROR DRCFilter::saveToFile(ccHObject* entity, const QString& filename, const SaveParameters& parameters)
 {
 	if (nullptr == entity)
@@ -276,13 +555,7 @@ CC_FILE_ERROR DRCFilter::saveToFile(ccHObject* entity, const QString& filename,
 		return CC_FERR_BAD_ARGUMENT;
 	}
 
-	draco::Encoder encoder;
-	encoder.SetSpeedOptions(0, 0);
-
-	int coordQuantization    = 11;
-	int texCoordQuantization = 10;
-	int normalQuantization   = 8;
-	int sfQuantization       = 8;
+	DracoEncodingOptions options;
 
 	// we always create the dialog, even if we don't display it, to retrieve the default values
 	SaveDracoFileDlg drcDialog(parameters.parentWidget);
@@ -294,15 +567,27 @@ CC_FILE_ERROR DRCFilter::saveToFile(ccHObject* entity, const QString& filename,
 		}
 	}
 
-	coordQuantization = drcDialog.coordsQuantSpinBox->value();
-	// texCoordQuantization = XXX; //not available yet since we don't know how to save the texture!
-	normalQuantization = drcDialog.normQuantSpinBox->value();
-	sfQuantization     = drcDialog.sfQuantSpinBox->value();
+	options.coordQuantization = drcDialog.coordsQuantSpinBox->value();
+	// options.texCoordQuantization = XXX; //not available yet since we don't know how to save the texture!
+	options.normalQuantization = drcDialog.normQuantSpinBox->value();
+	options.sfQuantization     = drcDialog.sfQuantSpinBox->value();
+
+	// big clouds can be split in chunks
+	const unsigned maxChunkSize = (drcDialog.chunksCheckBox->isChecked() ? static_cast<unsigned>(drcDialog.chunkSizeSpinBox->value()) : 0);
+	if (maxChunkSize != 0
+	    && entity->isKindOf(CC_TYPES::POINT_CLOUD)
+	    && static_cast<ccGenericPointCloud*>(entity)->size() > maxChunkSize)
+	{
+		QFile file(filename);
+		if (!file.open(QFile::WriteOnly))
+		{
+			return CC_FERR_WRITING;
+		}
+		return SaveChunkedCloud(*static_cast<ccGenericPointCloud*>(entity), maxChunkSize, options, file);
+	}
 
-	encoder.SetAttributeQuantization(draco::GeometryAttribute::POSITION, coordQuantization);
-	encoder.SetAttributeQuantization(draco::GeometryAttribute::TEX_COORD, texCoordQuantization);
-	encoder.SetAttributeQuantization(draco::GeometryAttribute::NORMAL, normalQuantization);
-	encoder.SetAttributeQuantization(draco::GeometryAttribute::GENERIC, sfQuantization);
+	draco::Encoder encoder;
+	InitEncoder(encoder, options);
 
 	draco::EncoderBuffer buffer;
 	if (entity->isKindOf(CC_TYPES::MESH))
@@ -354,167 +639,451 @@ CC_FILE_ERROR DRCFilter::saveToFile(ccHObject* entity, const QString& filename,
 	return CC_FERR_NO_ERROR;
 }
 
-static CC_FILE_ERROR LoadCloud(ccPointCloud& ccCloud, const draco::PointCloud& dracoCloud, FileIOFilter::LoadParameters& parameters)
+//! Returns a given attribute of a DRACO cloud if it has the expected type and one value per point (or nullptr otherwise)
+static const draco::PointAttribute* GetAttribute(const draco::PointCloud& dracoCloud, draco::GeometryAttribute::Type type, draco::DataType dataType)
 {
-	if (dracoCloud.num_points() == 0)
+	const draco::PointAttribute* attribute = dracoCloud.GetNamedAttribute(type);
+	if ((nullptr != attribute)
+	    && (attribute->data_type() == dataType)
+	    && (attribute->size() == dracoCloud.num_points()))
 	{
-		return CC_FERR_NO_LOAD;
+		return attribute;
 	}
+	return nullptr;
+}
 
-	unsigned pointCount = dracoCloud.num_points();
-	if (!ccCloud.reserve(pointCount))
+//! Returns the (RGB or RGBA) color attribute of a DRACO cloud (or nullptr if none)
+static const draco::PointAttribute* GetColorAttribute(const draco::PointCloud& dracoCloud)
+{
+	const draco::PointAttribute* colorAttribute = GetAttribute(dracoCloud, draco::GeometryAttribute::COLOR, draco::DataType::DT_UINT8);
+	if (colorAttribute && (colorAttribute->num_components() == 3 || colorAttribute->num_components() == 4))
 	{
-		return CC_FERR_NOT_ENOUGH_MEMORY;
+		return colorAttribute;
 	}
+	return nullptr;
+}
 
-	// load vertices
+//! Checks the position attribute of a DRACO cloud
+static CC_FILE_ERROR CheckPositions(const draco::PointCloud& dracoCloud)
+{
 	const draco::PointAttribute* pointAttribute = dracoCloud.GetNamedAttribute(draco::GeometryAttribute::POSITION);
 	if (nullptr == pointAttribute)
 	{
 		return CC_FERR_THIRD_PARTY_LIB_FAILURE;
 	}
-	if (pointCount != pointAttribute->size())
+	if (dracoCloud.num_points() != pointAttribute->size()
+	    || (pointAttribute->data_type() != draco::DT_FLOAT32 && pointAttribute->data_type() != draco::DT_FLOAT64))
 	{
 		return CC_FERR_MALFORMED_FILE;
 	}
-	draco::DataType dt = pointAttribute->data_type();
-	if (dt == draco::DT_FLOAT32)
+	return CC_FERR_NO_ERROR;
+}
+
+//! Handles the global shift (based on the first point of a DRACO cloud)
+static void HandleDracoGlobalShift(const draco::PointCloud& dracoCloud, ccPointCloud& ccCloud, FileIOFilter::LoadParameters& parameters, CCVector3d& Pshift)
+{
+	// only double precision coordinates may be shifted
+	const draco::PointAttribute* pointAttribute = dracoCloud.GetNamedAttribute(draco::GeometryAttribute::POSITION);
+	if (pointAttribute->data_type() != draco::DT_FLOAT64 || dracoCloud.num_points() == 0)
+	{
+		return;
+	}
+
+	CCVector3d P;
+	pointAttribute->GetValue(draco::AttributeValueIndex(0), P.u);
+
+	// first point: check for large coordinates
+	bool preserveCoordinateShift = true;
+	if (FileIOFilter::HandleGlobalShift(P, Pshift, preserveCoordinateShift, parameters))
 	{
-		for (draco::AttributeValueIndex i(0); i < static_cast<uint32_t>(pointAttribute->size()); ++i)
+		if (preserveCoordinateShift)
 		{
-			CCVector3f p;
-			pointAttribute->GetValue(i, p.u);
-			ccCloud.addPoint(p);
+			ccCloud.setGlobalShift(Pshift);
 		}
+		ccLog::Warning("[DRACO] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", Pshift.x, Pshift.y, Pshift.z);
+	}
+}
+
+//! Allocates a cloud and its attributes (normals, colors, scalar field) based on a reference DRACO cloud
+static CC_FILE_ERROR InitCloud(ccPointCloud& ccCloud, unsigned pointCount, const draco::PointCloud& dracoCloud)
+{
+	if (!ccCloud.resize(pointCount))
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
 	}
-	else if (dt == draco::DT_FLOAT64)
+
+	// load normals?
+	if (GetAttribute(dracoCloud, draco::GeometryAttribute::NORMAL, draco::DataType::DT_FLOAT32))
 	{
-		CCVector3d Pshift(0, 0, 0);
-		bool       preserveCoordinateShift = true;
-		for (draco::AttributeValueIndex i(0); i < static_cast<uint32_t>(pointAttribute->size()); ++i)
+		if (ccCloud.resizeTheNormsTable())
 		{
-			CCVector3d P;
-			pointAttribute->GetValue(i, P.u);
+			ccCloud.showNormals(true);
+		}
+		else
+		{
+			ccLog::Warning("Failed to load normals (not enough memory)");
+		}
+	}
 
-			// first point: check for large coordinates
-			if (i == 0)
-			{
-				if (FileIOFilter::HandleGlobalShift(P, Pshift, preserveCoordinateShift, parameters))
-				{
-					if (preserveCoordinateShift)
-					{
-						ccCloud.setGlobalShift(Pshift);
-					}
-					ccLog::Warning("[DRACO] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", Pshift.x, Pshift.y, Pshift.z);
-				}
-			}
+	// load colors?
+	if (GetColorAttribute(dracoCloud))
+	{
+		if (ccCloud.resizeTheRGBTable())
+		{
+			ccCloud.showColors(true);
+		}
+		else
+		{
+			ccLog::Warning("Failed to load colors (not enough memory)");
+		}
+	}
 
-			ccCloud.addPoint((P + Pshift).toPC());
+	// load SF?
+	if (GetAttribute(dracoCloud, draco::GeometryAttribute::GENERIC, draco::DataType::DT_FLOAT32))
+	{
+		ccScalarField* sf = new ccScalarField();
+		if (sf->resizeSafe(pointCount))
+		{
+			ccCloud.addScalarField(sf);
+		}
+		else
+		{
+			sf->release();
+			ccLog::Warning("Failed to load generic field (not enough memory)");
 		}
 	}
 
-	// load normals?
-	const draco::PointAttribute* normalAttribute = dracoCloud.GetNamedAttribute(draco::GeometryAttribute::NORMAL);
-	if ((nullptr != normalAttribute)
-	    && (normalAttribute->data_type() == draco::DataType::DT_FLOAT32)
-	    && (pointCount == normalAttribute->size()))
+	return CC_FERR_NO_ERROR;
+}
+
+//! Copies the points of a DRACO cloud in a (allocated) cloud
+/** Thread-safe as long as the threads fill different parts of the cloud.
+    \param ccCloud output cloud (see InitCloud)
+    \param firstIndex index of the first point to fill
+    \param dracoCloud DRACO cloud
+    \param Pshift global shift (double precision coordinates only)
+**/
+static void FillCloud(ccPointCloud& ccCloud, unsigned firstIndex, const draco::PointCloud& dracoCloud, const CCVector3d& Pshift)
+{
+	const int                    pointCount      = static_cast<int>(dracoCloud.num_points());
+	const draco::PointAttribute* pointAttribute  = dracoCloud.GetNamedAttribute(draco::GeometryAttribute::POSITION);
+	const bool                   doublePrecision = (pointAttribute->data_type() == draco::DT_FLOAT64);
+
+	NormsIndexesTableType*       normals         = ccCloud.normals();
+	const draco::PointAttribute* normalAttribute = (normals ? GetAttribute(dracoCloud, draco::GeometryAttribute::NORMAL, draco::DataType::DT_FLOAT32) : nullptr);
+	RGBAColorsTableType*         colors          = ccCloud.rgbaColors();
+	const draco::PointAttribute* colorAttribute  = (colors ? GetColorAttribute(dracoCloud) : nullptr);
+	const bool                   rgba            = (colorAttribute && colorAttribute->num_components() == 4);
+	CCCoreLib::ScalarField*      sf              = (ccCloud.hasScalarFields() ? ccCloud.getScalarField(0) : nullptr);
+	const draco::PointAttribute* sfAttribute     = (sf ? GetAttribute(dracoCloud, draco::GeometryAttribute::GENERIC, draco::DataType::DT_FLOAT32) : nullptr);
+
+	// the points are copied in parallel (unless we are already in a parallel section)
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+	for (int i = 0; i < pointCount; ++i)
 	{
-		if (ccCloud.reserveTheNormsTable())
+		const draco::AttributeValueIndex valueIndex(static_cast<uint32_t>(i));
+		const unsigned                   pointIndex = firstIndex + static_cast<unsigned>(i);
+
+		if (doublePrecision)
+		{
+			CCVector3d P;
+			pointAttribute->GetValue(valueIndex, P.u);
+			*const_cast<CCVector3*>(ccCloud.getPoint(pointIndex)) = (P + Pshift).toPC();
+		}
+		else
+		{
+			CCVector3f P;
+			pointAttribute->GetValue(valueIndex, P.u);
+			*const_cast<CCVector3*>(ccCloud.getPoint(pointIndex)) = CCVector3::fromArray(P.u);
+		}
+
+		if (normalAttribute)
 		{
-			for (draco::AttributeValueIndex i(0); i < static_cast<uint32_t>(normalAttribute->size()); ++i)
+			draco::Vector3f n;
+			normalAttribute->GetValue(valueIndex, &n[0]);
+			(*normals)[pointIndex] = ccNormalVectors::GetNormIndex(CCVector3::fromArray(n.data()));
+		}
+
+		if (colorAttribute)
+		{
+			if (rgba)
 			{
-				draco::Vector3f n;
-				normalAttribute->GetValue(i, &n[0]);
-				ccCloud.addNorm(CCVector3f::fromArray(n.data()));
+				std::array<uint8_t, 4> col;
+				colorAttribute->GetValue(valueIndex, &col[0]);
+				(*colors)[pointIndex] = ccColor::Rgba(col.data());
+			}
+			else
+			{
+				std::array<uint8_t, 3> col;
+				colorAttribute->GetValue(valueIndex, &col[0]);
+				(*colors)[pointIndex] = ccColor::FromRgbToRgba(ccColor::Rgb(col.data()));
 			}
-			ccCloud.showNormals(true);
 		}
-		else
+
+		if (sfAttribute)
 		{
-			ccLog::Warning("Failed to load normals (not enough memory)");
+			float sfValue = 0;
+			sfAttribute->GetValue(valueIndex, &sfValue);
+			sf->setValue(pointIndex, sfValue);
 		}
 	}
+}
 
-	// load colors?
-	const draco::PointAttribute* colorAttribute = dracoCloud.GetNamedAttribute(draco::GeometryAttribute::COLOR);
-	if ((nullptr != colorAttribute)
-	    && (colorAttribute->data_type() == draco::DataType::DT_UINT8)
-	    && (pointCount == colorAttribute->size()))
+//! Updates the cloud display state once all its points have been loaded
+static void FinalizeCloud(ccPointCloud& ccCloud)
+{
+	ccCloud.invalidateBoundingBox();
+
+	if (ccCloud.hasScalarFields())
+	{
+		ccCloud.getScalarField(0)->computeMinAndMax();
+		ccCloud.setCurrentDisplayedScalarField(0);
+		ccCloud.showSF(true);
+	}
+}
+
+static CC_FILE_ERROR LoadCloud(ccPointCloud& ccCloud, const draco::PointCloud& dracoCloud, FileIOFilter::LoadParameters& parameters)
+{
+	if (dracoCloud.num_points() == 0)
+	{
+		return CC_FERR_NO_LOAD;
+	}
+
+	CC_FILE_ERROR error = CheckPositions(dracoCloud);
+	if (error != CC_FERR_NO_ERROR)
+	{
+		return error;
+	}
+
+	CCVector3d Pshift(0, 0, 0);
+	HandleDracoGlobalShift(dracoCloud, ccCloud, parameters, Pshift);
+
+	error = InitCloud(ccCloud, dracoCloud.num_points(), dracoCloud);
+	if (error != CC_FERR_NO_ERROR)
+	{
+		return error;
+	}
+
+	FillCloud(ccCloud, 0, dracoCloud, Pshift);
+	FinalizeCloud(ccCloud);
+
+	return CC_FERR_NO_ERROR;
+}
+
+//! Decodes a chunk of a chunked DRACO cloud
+static CC_FILE_ERROR DecodeChunk(const char* data, const DracoChunkEntry& entry, std::unique_ptr<draco::PointCloud>& dracoCloud)
+{
+	draco::DecoderBuffer buffer;
+	buffer.Init(data + entry.offset, static_cast<size_t>(entry.size));
+
+	draco::Decoder decoder;
+	auto           result = decoder.DecodePointCloudFromBuffer(&buffer);
+	if (!result.ok())
+	{
+		return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+	}
+	dracoCloud = std::move(result).value();
+
+	if (dracoCloud->num_points() != entry.pointCount)
+	{
+		return CC_FERR_MALFORMED_FILE;
+	}
+	return CheckPositions(*dracoCloud);
+}
+
+//! Loads a chunked DRACO cloud (the chunks are decoded in parallel)
+static CC_FILE_ERROR LoadChunkedCloud(const char* data, qint64 size, ccHObject& container, FileIOFilter::LoadParameters& parameters)
+{
+	// read the header
+	QByteArray  header = QByteArray::fromRawData(data, static_cast<int>(std::min(size, c_chunkedHeaderSize)));
+	QDataStream headerStream(header);
+	headerStream.setByteOrder(QDataStream::LittleEndian);
+	headerStream.skipRawData(static_cast<int>(c_chunkedMagicSize));
+	quint32 version    = 0;
+	quint32 chunkCount = 0;
+	headerStream >> version >> chunkCount;
+	if (headerStream.status() != QDataStream::Ok)
+	{
+		return CC_FERR_MALFORMED_FILE;
+	}
+	if (version > c_chunkedVersion)
+	{
+		ccLog::Warning(QString("[DRACO] Unhandled chunked cloud version (%1)").arg(version));
+		return CC_FERR_WRONG_FILE_TYPE;
+	}
+	if (size < c_chunkedHeaderSize + static_cast<qint64>(chunkCount) * c_chunkedEntrySize)
+	{
+		return CC_FERR_MALFORMED_FILE;
+	}
+
+	std::vector<DracoChunkEntry> entries;
+	try
+	{
+		entries.resize(chunkCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+
+	QByteArray  table = QByteArray::fromRawData(data + c_chunkedHeaderSize, static_cast<int>(chunkCount * c_chunkedEntrySize));
+	QDataStream tableStream(table);
+	tableStream.setByteOrder(QDataStream::LittleEndian);
+	tableStream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+	for (DracoChunkEntry& entry : entries)
+	{
+		tableStream >> entry.offset >> entry.size >> entry.pointCount;
+		tableStream >> entry.bbMin.x >> entry.bbMin.y >> entry.bbMin.z;
+		tableStream >> entry.bbMax.x >> entry.bbMax.y >> entry.bbMax.z;
+		if (entry.offset > static_cast<quint64>(size) || entry.size > static_cast<quint64>(size) - entry.offset)
+		{
+			return CC_FERR_MALFORMED_FILE;
+		}
+	}
+
+	// the chunks outside of the loading filter box (if any) are not even decoded
+	if (parameters.loadingFilter && parameters.loadingFilter->parameters().useBox)
 	{
-		bool rgb  = (colorAttribute->num_components() == 3);
-		bool rgba = (colorAttribute->num_components() == 4);
-		if (rgb || rgba)
+		const ccLoadingFilter::Parameters& filterParams = parameters.loadingFilter->parameters();
+		size_t                             skipped      = 0;
+		for (size_t i = 0; i < entries.size(); ++i)
 		{
-			if (ccCloud.reserveTheRGBTable())
+			const DracoChunkEntry& entry = entries[i];
+			if (entry.bbMax.x < filterParams.boxMin.x || entry.bbMin.x > filterParams.boxMax.x
+			    || entry.bbMax.y < filterParams.boxMin.y || entry.bbMin.y > filterParams.boxMax.y
+			    || entry.bbMax.z < filterParams.boxMin.z || entry.bbMin.z > filterParams.boxMax.z)
 			{
-				if (rgb)
-				{
-					std::array<uint8_t, 3> col;
-					for (draco::AttributeValueIndex i(0); i < static_cast<uint32_t>(colorAttribute->size()); ++i)
-					{
-						colorAttribute->GetValue(i, &col[0]);
-						ccCloud.addColor(ccColor::Rgb(col.data()));
-					}
-				}
-				else if (rgba)
-				{
-					std::array<uint8_t, 4> col;
-					for (draco::AttributeValueIndex i(0); i < static_cast<uint32_t>(colorAttribute->size()); ++i)
-					{
-						colorAttribute->GetValue(i, &col[0]);
-						ccCloud.addColor(ccColor::Rgba(col.data()));
-					}
-				}
-				ccCloud.showColors(true);
+				++skipped;
 			}
 			else
 			{
-				ccLog::Warning("Failed to load colors (not enough memory)");
+				entries[i - skipped] = entry;
 			}
 		}
+		entries.resize(entries.size() - skipped);
+		ccLog::Print(QString("[DRACO] %1 chunk(s) outside of the loading box skipped").arg(skipped));
 	}
 
-	// load SF?
-	const draco::PointAttribute* sfAttribute = dracoCloud.GetNamedAttribute(draco::GeometryAttribute::GENERIC);
-	if ((nullptr != sfAttribute)
-	    && (sfAttribute->data_type() == draco::DataType::DT_FLOAT32)
-	    && (sfAttribute->size() == pointCount))
+	// output point indexes
+	std::vector<unsigned> firstIndexes;
+	size_t                totalCount = 0;
+	try
 	{
-		ccScalarField* sf = new ccScalarField();
-		if (sf->reserveSafe(pointCount))
+		firstIndexes.reserve(entries.size());
+		for (const DracoChunkEntry& entry : entries)
 		{
-			for (draco::AttributeValueIndex i(0); i < static_cast<uint32_t>(sfAttribute->size()); ++i)
+			firstIndexes.push_back(static_cast<unsigned>(totalCount));
+			totalCount += entry.pointCount;
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+	if (totalCount == 0)
+	{
+		return CC_FERR_NO_LOAD;
+	}
+	if (totalCount > std::numeric_limits<unsigned>::max())
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+	ccLog::Print(QString("[DRACO] Cloud size: %1 (%2 chunks)").arg(totalCount).arg(entries.size()));
+
+	// the first chunk is decoded first (global shift and attributes)
+	std::unique_ptr<draco::PointCloud> firstChunk;
+	CC_FILE_ERROR                      error = DecodeChunk(data, entries.front(), firstChunk);
+	if (error != CC_FERR_NO_ERROR)
+	{
+		return error;
+	}
+
+	QScopedPointer<ccPointCloud> ccCloud(new ccPointCloud("unnamed - Cloud"));
+
+	CCVector3d Pshift(0, 0, 0);
+	HandleDracoGlobalShift(*firstChunk, *ccCloud, parameters, Pshift);
+
+	error = InitCloud(*ccCloud, static_cast<unsigned>(totalCount), *firstChunk);
+	if (error != CC_FERR_NO_ERROR)
+	{
+		return error;
+	}
+	FillCloud(*ccCloud, 0, *firstChunk, Pshift);
+	firstChunk.reset();
+
+	// then the other ones (in parallel)
+	const int                  chunkCount = static_cast<int>(entries.size());
+	std::vector<CC_FILE_ERROR> chunkErrors;
+	try
+	{
+		chunkErrors.resize(entries.size(), CC_FERR_NO_ERROR);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads()) schedule(dynamic)
+#endif
+	for (int c = 1; c < chunkCount; ++c)
+	{
+		try
+		{
+			std::unique_ptr<draco::PointCloud> dracoCloud;
+			chunkErrors[c] = DecodeChunk(data, entries[c], dracoCloud);
+			if (chunkErrors[c] == CC_FERR_NO_ERROR)
 			{
-				float sfValue = 0;
-				sfAttribute->GetValue(i, &sfValue);
-				sf->addElement(sfValue);
+				FillCloud(*ccCloud, firstIndexes[c], *dracoCloud, Pshift);
 			}
-			sf->computeMinAndMax();
-			ccCloud.addScalarField(sf);
-			ccCloud.setCurrentDisplayedScalarField(0);
-			ccCloud.showSF(true);
 		}
-		else
+		catch (const std::bad_alloc&)
 		{
-			ccLog::Warning("Failed to load generic field (not enough memory)");
+			chunkErrors[c] = CC_FERR_NOT_ENOUGH_MEMORY;
+		}
+	}
+
+	for (CC_FILE_ERROR chunkError : chunkErrors)
+	{
+		if (chunkError != CC_FERR_NO_ERROR)
+		{
+			return chunkError;
 		}
 	}
 
+	FinalizeCloud(*ccCloud);
+	container.addChild(ccCloud.take());
+
 	return CC_FERR_NO_ERROR;
 }
 
 CC_FILE_ERROR DRCFilter::loadFile(const QString& filename, ccHObject& container, LoadParameters& parameters)
 {
-	draco::DecoderBuffer buffer;
-
 	QFile file(filename);
 	if (!file.open(QFile::ReadOnly))
 	{
 		return CC_FERR_READING;
 	}
 
-	QByteArray byteArray = file.readAll();
-	buffer.Init(byteArray.data(), byteArray.size());
+	// we map the file if possible (the DRACO buffers are decoded in place)
+	const qint64 fileSize = file.size();
+	QByteArray   byteArray;
+	const char*  data = (fileSize > 0 ? reinterpret_cast<const char*>(file.map(0, fileSize)) : nullptr);
+	if (!data)
+	{
+		byteArray = file.readAll();
+		data      = byteArray.constData();
+	}
+
+	if (fileSize >= c_chunkedHeaderSize && memcmp(data, s_chunkedMagic, c_chunkedMagicSize) == 0)
+	{
+		return LoadChunkedCloud(data, fileSize, container, parameters);
+	}
+
+	draco::DecoderBuffer buffer;
+	buffer.Init(data, static_cast<size_t>(fileSize));
 
 	const auto result = draco::Decoder::GetEncodedGeometryType(&buffer);
 	if (!result.ok())
@@ -25,6 +25,7 @@
 static const int DefaultCoordsQuant = 11;
 static const int DefaultNormQuant   = 8;
 static const int DefaultSFQuant     = 8;
+static const int DefaultChunkSize   = 1000000;
 
 SaveDracoFileDlg::SaveDracoFileDlg(QWidget* parent /*=nullptr*/)
     : QDialog(parent)
@@ -46,11 +47,15 @@ void SaveDracoFileDlg::initFromPersistentSettings()
 	int coordQuantization = settings.value("coordQuantization", DefaultCoordsQuant).toInt();
 	int normQuantization  = settings.value("normalQuantization", DefaultNormQuant).toInt();
 	int sfQuantization    = settings.value("sfQuantization", DefaultSFQuant).toInt();
+	int chunkSize         = settings.value("chunkSize", DefaultChunkSize).toInt();
 
 	// apply parameters
 	coordsQuantSpinBox->setValue(coordQuantization);
 	normQuantSpinBox->setValue(normQuantization);
 	sfQuantSpinBox->setValue(sfQuantization);
+	// the chunked files can't be read by the other Draco readers: this option is never persistent
+	chunksCheckBox->setChecked(false);
+	chunkSizeSpinBox->setValue(chunkSize);
 
 	settings.endGroup();
 }
@@ -64,6 +69,7 @@ void SaveDracoFileDlg::saveToPersistentSettings()
 	settings.setValue("coordQuantization", coordsQuantSpinBox->value());
 	settings.setValue("normalQuantization", normQuantSpinBox->value());
 	settings.setValue("sfQuantization", sfQuantSpinBox->value());
+	settings.setValue("chunkSize", chunkSizeSpinBox->value());
 
 	settings.endGroup();
 
@@ -75,4 +81,6 @@ void SaveDracoFileDlg::reset()
 	coordsQuantSpinBox->setValue(DefaultCoordsQuant);
 	normQuantSpinBox->setValue(DefaultNormQuant);
 	sfQuantSpinBox->setValue(DefaultSFQuant);
+	chunksCheckBox->setChecked(false);
+	chunkSizeSpinBox->setValue(DefaultChunkSize);
 }
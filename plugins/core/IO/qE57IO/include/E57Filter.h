@@ -32,6 +32,14 @@ class E57Filter : public FileIOFilter
 
 	bool          canSave(CC_CLASS_ENUM type, bool& multiple, bool& exclusive) const override;
 	CC_FILE_ERROR saveToFile(ccHObject* entity, const QString& filename, const SaveParameters& parameters) override;
+
+  public: // Default / persistent settings
+	//! Sets whether the next block of points is packed (in parallel) while the current one is written (default is true)
+	static void SetPipelinedWriting(bool state);
+	//! Sets the number of points per block when writing a scan (default is 2^20)
+	/** The memory used by the block buffers is roughly 100 bytes per point (twice as much if the writing is pipelined).
+	**/
+	static void SetWritingBlockSize(unsigned pointCount);
 };
 
 #endif // CC_E57_FILTER_HEADER
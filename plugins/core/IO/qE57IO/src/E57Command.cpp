@@ -0,0 +1,74 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: CloudCompare project                               #
+// #                                                                        #
+// ##########################################################################
+
+#include "E57Command.h"
+
+#include "E57Filter.h"
+
+constexpr char COMMAND_E57[]                  = "E57";
+constexpr char COMMAND_E57_WRITE_BLOCK_SIZE[] = "WRITE_BLOCK_SIZE";
+constexpr char COMMAND_E57_NO_PIPELINE[]      = "NO_PIPELINED_WRITING";
+
+E57Command::E57Command()
+    : Command("E57", COMMAND_E57)
+{
+}
+
+bool E57Command::process(ccCommandLineInterface& cmd)
+{
+	cmd.print("[E57]");
+
+	while (!cmd.arguments().empty())
+	{
+		const QString& arg = cmd.arguments().front();
+
+		if (ccCommandLineInterface::IsCommand(arg, COMMAND_E57_WRITE_BLOCK_SIZE))
+		{
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: number of points after '%1'").arg(COMMAND_E57_WRITE_BLOCK_SIZE));
+			}
+
+			bool     ok         = false;
+			unsigned pointCount = cmd.arguments().takeFirst().toUInt(&ok);
+			if (!ok || pointCount == 0)
+			{
+				return cmd.error(QObject::tr("Invalid number of points after '%1'").arg(COMMAND_E57_WRITE_BLOCK_SIZE));
+			}
+
+			cmd.print(QObject::tr("E57 writing block size: %1 points").arg(pointCount));
+
+			E57Filter::SetWritingBlockSize(pointCount);
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_E57_NO_PIPELINE))
+		{
+			cmd.arguments().pop_front();
+
+			cmd.print(QObject::tr("E57 pipelined writing disabled"));
+
+			E57Filter::SetPipelinedWriting(false);
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	return true;
+}
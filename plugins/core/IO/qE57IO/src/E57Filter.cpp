@@ -19,6 +19,9 @@
 
 #include "FileIO.h"
 
+// qCC_io
+#include <ccFileLoadingTask.h>
+
 // Local
 #include "E57Header.h"
 #include "E57Version.h"
@@ -31,6 +34,7 @@
 #include <ccColorScalesManager.h>
 #include <ccGBLSensor.h>
 #include <ccImage.h>
+#include <ccNormalVectors.h>
 #include <ccPointCloud.h>
 #include <ccProgressDialog.h>
 #include <ccScalarField.h>
@@ -38,11 +42,22 @@
 // Qt
 #include <QApplication>
 #include <QBuffer>
+#include <QFuture>
+#include <QThread>
 #include <QUuid>
+#include <QtConcurrentRun>
 
 // system
+#include <atomic>
 #include <cassert>
+#include <memory>
 #include <string>
+#include <vector>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
 
 using colorFieldType = double;
 
@@ -57,14 +72,16 @@ namespace
 	constexpr uint8_t VALID_DATA   = 0;
 	constexpr uint8_t INVALID_DATA = 1;
 
-	unsigned s_absoluteScanIndex     = 0;
-	bool     s_cancelRequestedByUser = false;
+	// max memory used by the buffers to decode the scans concurrently
+	constexpr size_t MAX_DECODING_BUFFERS_SIZE = (size_t(1) << 30); // 1 GB
 
-	ScalarType s_maxIntensity = 0;
-	ScalarType s_minIntensity = 0;
+	// writing options
+	bool     s_pipelinedWriting = true;
+	unsigned s_writingBlockSize = (1 << 20);
 
-	// for coordinate shift handling
-	FileIOFilter::LoadParameters s_loadParameters;
+	// writing state (the loading state is local, as several files can be loaded concurrently)
+	unsigned s_absoluteScanIndex     = 0;
+	bool     s_cancelRequestedByUser = false;
 
 	// Array chunks for reading/writing information out of E57 files
 	struct TempArrays
@@ -151,8 +168,18 @@ E57Filter::E57Filter()
                     "e57",
                     QStringList{"E57 cloud (*.e57)"},
                     QStringList{"E57 cloud (*.e57)"},
-                    Import | Export})
+                    Import | Export | ConcurrentLoad})
+{
+}
+
+void E57Filter::SetPipelinedWriting(bool state)
+{
+	s_pipelinedWriting = state;
+}
+
+void E57Filter::SetWritingBlockSize(unsigned pointCount)
 {
+	s_writingBlockSize = std::max(pointCount, 1024u);
 }
 
 bool E57Filter::canSave(CC_CLASS_ENUM type, bool& multiple, bool& exclusive) const
@@ -255,13 +282,26 @@ static void SaveNodeInfo(const E57NodeMap&   nodeMap,
 	}
 }
 
-static bool SaveScan(ccPointCloud*       cloud,
-                     e57::StructureNode& scanNode,
-                     e57::ImageFile&     imf,
-                     e57::VectorNode&    data3D,
-                     QString&            guidStr,
-                     ccProgressDialog*   progressDlg = nullptr)
+//! Saves a cloud as a scan
+/** \param cloud cloud to save
+    \param scanNode scan node (to be filled)
+    \param imf image file
+    \param data3D 'data3D' vector node
+    \param guidStr scan GUID
+    \param blockBuffers buffers to pack the points before they are written (reused from one scan to the other).
+    If there are two of them, the next block of points is packed while the current one is written (pipeline).
+    \param progressDlg progress dialog (optional)
+**/
+static bool SaveScan(ccPointCloud*            cloud,
+                     e57::StructureNode&      scanNode,
+                     e57::ImageFile&          imf,
+                     e57::VectorNode&         data3D,
+                     QString&                 guidStr,
+                     std::vector<TempArrays>& blockBuffers,
+                     ccProgressDialog*        progressDlg = nullptr)
 {
+	assert(!blockBuffers.empty());
+
 	assert(cloud);
 
 	unsigned pointCount = cloud->size();
@@ -348,29 +388,44 @@ static bool SaveScan(ccPointCloud*       cloud,
 	if (hasSensorPoseMat)
 	{
 		// we have to compute the rotated cloud bounding-box!
-		for (unsigned i = 0; i < pointCount; ++i)
-		{
-			// we apply the Global Scale but not the Global Shift (already incorporated in the 'pose' matrix above)
-			CCVector3d Psensor = cloud->getPointPersistentPtr(i)->toDouble() / globalScale;
+		// DGM: according to E57 specifications, the bounding-box is local
+		//(i.e. in the sensor 'input' coordinate system)
+		bbMin = bbMax = fromSensorToLocalCS * (cloud->getPointPersistentPtr(0)->toDouble() / globalScale);
 
-			// DGM: according to E57 specifications, the bounding-box is local
-			//(i.e. in the sensor 'input' coordinate system)
-			CCVector3d Plocal = fromSensorToLocalCS * Psensor;
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(omp_get_max_threads())
+#endif
+		{
+			CCVector3d localMin = bbMin;
+			CCVector3d localMax = bbMax;
 
-			if (i != 0)
+#if defined(_OPENMP)
+#pragma omp for
+#endif
+			for (int i = 1; i < static_cast<int>(pointCount); ++i)
 			{
-				bbMin.x = std::min(bbMin.x, Plocal.x);
-				bbMin.y = std::min(bbMin.y, Plocal.y);
-				bbMin.z = std::min(bbMin.z, Plocal.z);
-				bbMax.x = std::max(bbMax.x, Plocal.x);
-				bbMax.y = std::max(bbMax.y, Plocal.y);
-				bbMax.z = std::max(bbMax.z, Plocal.z);
+				// we apply the Global Scale but not the Global Shift (already incorporated in the 'pose' matrix above)
+				CCVector3d Psensor = cloud->getPointPersistentPtr(static_cast<unsigned>(i))->toDouble() / globalScale;
+				CCVector3d Plocal  = fromSensorToLocalCS * Psensor;
+
+				localMin.x = std::min(localMin.x, Plocal.x);
+				localMin.y = std::min(localMin.y, Plocal.y);
+				localMin.z = std::min(localMin.z, Plocal.z);
+				localMax.x = std::max(localMax.x, Plocal.x);
+				localMax.y = std::max(localMax.y, Plocal.y);
+				localMax.z = std::max(localMax.z, Plocal.z);
 			}
-			else
+
+#if defined(_OPENMP)
+#pragma omp critical(E57SaveScanBBox)
+#endif
 			{
-				bbMax.x = bbMin.x = Plocal.x;
-				bbMax.y = bbMin.y = Plocal.y;
-				bbMax.z = bbMin.z = Plocal.z;
+				bbMin.x = std::min(bbMin.x, localMin.x);
+				bbMin.y = std::min(bbMin.y, localMin.y);
+				bbMin.z = std::min(bbMin.z, localMin.z);
+				bbMax.x = std::max(bbMax.x, localMax.x);
+				bbMax.y = std::max(bbMax.y, localMax.y);
+				bbMax.z = std::max(bbMax.z, localMax.z);
 			}
 		}
 	}
@@ -543,11 +598,6 @@ static bool SaveScan(ccPointCloud*       cloud,
 	/// This prototype will be used in creating the points CompressedVector.
 	e57::StructureNode proto = e57::StructureNode(imf);
 
-	// prepare temporary structures
-	const unsigned                     chunkSize = std::min<unsigned>(pointCount, (1 << 20)); // we save the file in several steps to limit the memory consumption
-	TempArrays                         arrays;
-	std::vector<e57::SourceDestBuffer> dbufs;
-
 	// Cartesian field
 	{
 		e57::FloatPrecision precision = sizeof(PointCoordinateType) == 8 || isScaled ? e57::E57_DOUBLE : e57::E57_SINGLE;
@@ -555,16 +605,8 @@ static bool SaveScan(ccPointCloud*       cloud,
 		CCVector3d bbCenter = (bbMin + bbMax) / 2;
 
 		proto.set("cartesianX", e57::FloatNode(imf, bbCenter.x, precision, bbMin.x, bbMax.x));
-		arrays.xData.resize(chunkSize);
-		dbufs.emplace_back(imf, "cartesianX", arrays.xData.data(), chunkSize, true, true);
-
 		proto.set("cartesianY", e57::FloatNode(imf, bbCenter.y, precision, bbMin.y, bbMax.y));
-		arrays.yData.resize(chunkSize);
-		dbufs.emplace_back(imf, "cartesianY", arrays.yData.data(), chunkSize, true, true);
-
 		proto.set("cartesianZ", e57::FloatNode(imf, bbCenter.z, precision, bbMin.z, bbMax.z));
-		arrays.zData.resize(chunkSize);
-		dbufs.emplace_back(imf, "cartesianZ", arrays.zData.data(), chunkSize, true, true);
 	}
 
 	// Normals
@@ -574,16 +616,11 @@ static bool SaveScan(ccPointCloud*       cloud,
 		e57::FloatPrecision precision = sizeof(PointCoordinateType) == 8 ? e57::E57_DOUBLE : e57::E57_SINGLE;
 
 		proto.set("nor:normalX", e57::FloatNode(imf, 0.0, precision, -1.0, 1.0));
-		arrays.xNormData.resize(chunkSize);
-		dbufs.emplace_back(imf, "nor:normalX", arrays.xNormData.data(), chunkSize, true, true);
-
 		proto.set("nor:normalY", e57::FloatNode(imf, 0.0, precision, -1.0, 1.0));
-		arrays.yNormData.resize(chunkSize);
-		dbufs.emplace_back(imf, "nor:normalY", arrays.yNormData.data(), chunkSize, true, true);
-
 		proto.set("nor:normalZ", e57::FloatNode(imf, 0.0, precision, -1.0, 1.0));
-		arrays.zNormData.resize(chunkSize);
-		dbufs.emplace_back(imf, "nor:normalZ", arrays.zNormData.data(), chunkSize, true, true);
+
+		// make sure the normals lookup table is initialized before being used concurrently
+		ccNormalVectors::GetUniqueInstance();
 	}
 
 	// Return index
@@ -591,22 +628,16 @@ static bool SaveScan(ccPointCloud*       cloud,
 	{
 		assert(maxReturnIndex > minReturnIndex);
 		proto.set("returnIndex", e57::IntegerNode(imf, minReturnIndex, minReturnIndex, maxReturnIndex));
-		arrays.scanIndexData.resize(chunkSize);
-		dbufs.emplace_back(imf, "returnIndex", arrays.scanIndexData.data(), chunkSize, true, true);
 	}
 
 	// Intensity field
 	if (intensitySF)
 	{
 		proto.set("intensity", e57::FloatNode(imf, intensitySF->getMin(), sizeof(ScalarType) == 8 ? e57::E57_DOUBLE : e57::E57_SINGLE, intensitySF->getMin(), intensitySF->getMax()));
-		arrays.intData.resize(chunkSize);
-		dbufs.emplace_back(imf, "intensity", arrays.intData.data(), chunkSize, true, true);
 
 		if (hasInvalidIntensities)
 		{
 			proto.set("isIntensityInvalid", e57::IntegerNode(imf, 0, 0, 1));
-			arrays.isInvalidIntData.resize(chunkSize);
-			dbufs.emplace_back(imf, "isIntensityInvalid", arrays.isInvalidIntData.data(), chunkSize, true, true);
 		}
 	}
 
@@ -614,14 +645,8 @@ static bool SaveScan(ccPointCloud*       cloud,
 	if (hasColors)
 	{
 		proto.set("colorRed", e57::IntegerNode(imf, 0, 0, 255));
-		arrays.redData.resize(chunkSize);
-		dbufs.emplace_back(imf, "colorRed", arrays.redData.data(), chunkSize, true, true);
 		proto.set("colorGreen", e57::IntegerNode(imf, 0, 0, 255));
-		arrays.greenData.resize(chunkSize);
-		dbufs.emplace_back(imf, "colorGreen", arrays.greenData.data(), chunkSize, true, true);
 		proto.set("colorBlue", e57::IntegerNode(imf, 0, 0, 255));
-		arrays.blueData.resize(chunkSize);
-		dbufs.emplace_back(imf, "colorBlue", arrays.blueData.data(), chunkSize, true, true);
 	}
 
 	// ignored fields
@@ -636,37 +661,84 @@ static bool SaveScan(ccPointCloud*       cloud,
 	//"isColorInvalid"
 	//"isTimeStampInvalid"
 
-	// Make empty codecs vector for use in creating points CompressedVector.
-	/// If this vector is empty, it is assumed that all fields will use the BitPack codec.
-	e57::VectorNode codecs = e57::VectorNode(imf, true);
+	// prepare the (reusable) block buffers
+	const unsigned                                  chunkSize = std::min<unsigned>(pointCount, s_writingBlockSize); // we save the file in several steps to limit the memory consumption
+	std::vector<std::vector<e57::SourceDestBuffer>> blockDBufs;
+	for (TempArrays& arrays : blockBuffers)
+	{
+		std::vector<e57::SourceDestBuffer> dbufs;
+		try
+		{
+			arrays.xData.resize(chunkSize);
+			dbufs.emplace_back(imf, "cartesianX", arrays.xData.data(), chunkSize, true, true);
+			arrays.yData.resize(chunkSize);
+			dbufs.emplace_back(imf, "cartesianY", arrays.yData.data(), chunkSize, true, true);
+			arrays.zData.resize(chunkSize);
+			dbufs.emplace_back(imf, "cartesianZ", arrays.zData.data(), chunkSize, true, true);
 
-	// Create CompressedVector for storing points.
-	/// We use the prototype and empty codecs tree from above.
-	e57::CompressedVectorNode points = e57::CompressedVectorNode(imf, proto, codecs);
-	scanNode.set("points", points);
-	data3D.append(scanNode);
+			if (hasNormals)
+			{
+				arrays.xNormData.resize(chunkSize);
+				dbufs.emplace_back(imf, "nor:normalX", arrays.xNormData.data(), chunkSize, true, true);
+				arrays.yNormData.resize(chunkSize);
+				dbufs.emplace_back(imf, "nor:normalY", arrays.yNormData.data(), chunkSize, true, true);
+				arrays.zNormData.resize(chunkSize);
+				dbufs.emplace_back(imf, "nor:normalZ", arrays.zNormData.data(), chunkSize, true, true);
+			}
+
+			if (returnIndexSF)
+			{
+				arrays.scanIndexData.resize(chunkSize);
+				dbufs.emplace_back(imf, "returnIndex", arrays.scanIndexData.data(), chunkSize, true, true);
+			}
 
-	e57::CompressedVectorWriter writer = points.writer(dbufs);
+			if (intensitySF)
+			{
+				arrays.intData.resize(chunkSize);
+				dbufs.emplace_back(imf, "intensity", arrays.intData.data(), chunkSize, true, true);
 
-	// progress bar
-	CCCoreLib::NormalizedProgress nprogress(progressDlg, pointCount);
-	if (progressDlg)
-	{
-		progressDlg->setMethodTitle(QObject::tr("Write E57 file"));
-		progressDlg->setInfo(QObject::tr("Scan #%1 - %2 points").arg(s_absoluteScanIndex).arg(pointCount));
-		progressDlg->start();
-		QApplication::processEvents();
+				if (hasInvalidIntensities)
+				{
+					arrays.isInvalidIntData.resize(chunkSize);
+					dbufs.emplace_back(imf, "isIntensityInvalid", arrays.isInvalidIntData.data(), chunkSize, true, true);
+				}
+			}
+
+			if (hasColors)
+			{
+				arrays.redData.resize(chunkSize);
+				dbufs.emplace_back(imf, "colorRed", arrays.redData.data(), chunkSize, true, true);
+				arrays.greenData.resize(chunkSize);
+				dbufs.emplace_back(imf, "colorGreen", arrays.greenData.data(), chunkSize, true, true);
+				arrays.blueData.resize(chunkSize);
+				dbufs.emplace_back(imf, "colorBlue", arrays.blueData.data(), chunkSize, true, true);
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			if (blockDBufs.empty())
+			{
+				ccLog::Error("[E57] Not enough memory!");
+				return false;
+			}
+			// we'll work without the pipeline
+			ccLog::Warning("[E57] Not enough memory to pipeline the writing process");
+			break;
+		}
+
+		blockDBufs.emplace_back(std::move(dbufs));
 	}
 
-	unsigned index               = 0;
-	unsigned remainingPointCount = pointCount;
-	while (remainingPointCount != 0)
+	// packs a block of points in the given buffers
+	auto packBlock = [&](TempArrays& arrays, unsigned firstIndex, unsigned count)
 	{
-		unsigned thisChunkSize = std::min(remainingPointCount, chunkSize);
-
-		// load arrays
-		for (unsigned i = 0; i < thisChunkSize; ++i, ++index)
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+		for (int i = 0; i < static_cast<int>(count); ++i)
 		{
+			unsigned index = firstIndex + static_cast<unsigned>(i);
+
 			// we apply the Global Scale but not the Global Shift (already incorporated in the 'pose' matrix above)
 			CCVector3d Psensor = cloud->getPointPersistentPtr(index)->toDouble() / globalScale;
 
@@ -715,19 +787,79 @@ static bool SaveScan(ccPointCloud*       cloud,
 				assert(!arrays.scanIndexData.empty());
 				arrays.scanIndexData[i] = static_cast<int8_t>(returnIndexSF->getValue(index));
 			}
+		}
+	};
+
+	// Make empty codecs vector for use in creating points CompressedVector.
+	/// If this vector is empty, it is assumed that all fields will use the BitPack codec.
+	e57::VectorNode codecs = e57::VectorNode(imf, true);
+
+	// Create CompressedVector for storing points.
+	/// We use the prototype and empty codecs tree from above.
+	e57::CompressedVectorNode points = e57::CompressedVectorNode(imf, proto, codecs);
+	scanNode.set("points", points);
+	data3D.append(scanNode);
+
+	e57::CompressedVectorWriter writer = points.writer(blockDBufs.front());
+
+	// progress bar
+	if (progressDlg)
+	{
+		progressDlg->setMethodTitle(QObject::tr("Write E57 file"));
+		progressDlg->setInfo(QObject::tr("Scan #%1 - %2 points").arg(s_absoluteScanIndex).arg(pointCount));
+		progressDlg->start();
+		QApplication::processEvents();
+	}
+
+	const size_t   bufferCount = blockDBufs.size();
+	const unsigned blockCount  = (pointCount + chunkSize - 1) / chunkSize;
+
+	packBlock(blockBuffers[0], 0, chunkSize);
+
+	for (unsigned blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+	{
+		const unsigned firstIndex    = blockIndex * chunkSize;
+		const unsigned thisChunkSize = std::min(pointCount - firstIndex, chunkSize);
+		const size_t   bufferIndex   = blockIndex % bufferCount;
+
+		// pack the next block while the current one is being written (if possible)
+		const unsigned nextFirstIndex = firstIndex + thisChunkSize;
+		const unsigned nextChunkSize  = std::min(pointCount - nextFirstIndex, chunkSize);
+		QFuture<void>  nextBlockPacking;
+		if (bufferCount > 1 && nextChunkSize != 0)
+		{
+			TempArrays& nextArrays = blockBuffers[(blockIndex + 1) % bufferCount];
+			auto        packNext   = [&packBlock, &nextArrays, nextFirstIndex, nextChunkSize]()
+			{ packBlock(nextArrays, nextFirstIndex, nextChunkSize); };
+			nextBlockPacking = QtConcurrent::run(packNext);
+		}
+
+		try
+		{
+			writer.write(blockDBufs[bufferIndex], thisChunkSize);
+		}
+		catch (...)
+		{
+			nextBlockPacking.waitForFinished();
+			throw;
+		}
 
-			if (!nprogress.oneStep())
+		if (bufferCount == 1 && nextChunkSize != 0)
+		{
+			packBlock(blockBuffers[0], nextFirstIndex, nextChunkSize);
+		}
+		nextBlockPacking.waitForFinished();
+
+		if (progressDlg)
+		{
+			progressDlg->update((100.0f * nextFirstIndex) / pointCount);
+			QApplication::processEvents();
+			if (progressDlg->isCancelRequested())
 			{
-				QApplication::processEvents();
 				s_cancelRequestedByUser = true;
 				break;
 			}
 		}
-
-		writer.write(thisChunkSize);
-
-		assert(thisChunkSize <= remainingPointCount);
-		remainingPointCount -= thisChunkSize;
 	}
 
 	writer.close();
@@ -1053,6 +1185,9 @@ CC_FILE_ERROR E57Filter::saveToFile(ccHObject* entity, const QString& filename,
 		// Extension for normals
 		bool hasNormals = false;
 
+		// block buffers (reused from one scan to the other)
+		std::vector<TempArrays> blockBuffers(s_pipelinedWriting ? 2 : 1);
+
 		for (auto cloud : scans)
 		{
 			QString scanGUID = GetNewGuid();
@@ -1066,7 +1201,7 @@ CC_FILE_ERROR E57Filter::saveToFile(ccHObject* entity, const QString& filename,
 
 			// create corresponding node
 			e57::StructureNode scanNode = e57::StructureNode(imf);
-			if (SaveScan(cloud, scanNode, imf, data3D, scanGUID, progressDlg.data()))
+			if (SaveScan(cloud, scanNode, imf, data3D, scanGUID, blockBuffers, progressDlg.data()))
 			{
 				++s_absoluteScanIndex;
 				scansGUID.insert(cloud, scanGUID);
@@ -1708,24 +1843,273 @@ struct LoadedScan
 	bool          preserveCoordinateShift = false;
 };
 
-static LoadedScan LoadScan(const e57::Node& node, QString& guidStr, ccProgressDialog* progressDlg = nullptr)
+//! Scan to be read
+/** Prepared (sequentially) by PrepareScan, filled (concurrently) by ReadScanPoints
+    and eventually finalized (sequentially) by FinalizeScan.
+**/
+struct ScanToRead
+{
+	//! Reading status
+	enum class Status
+	{
+		Pending,
+		Success,
+		NoValidPoint,
+		NoPointKept,
+		NotEnoughMemory,
+		E57Error,
+		Canceled
+	};
+
+	//! Index of the scan in the 'data3D' vector
+	unsigned index = 0;
+	//! Scan GUID
+	QString guid;
+	//! Scan element name
+	QString elementName;
+
+	//! Output cloud
+	ccPointCloud* cloud = nullptr;
+	//! Output sensor (if any)
+	ccGBLSensor* sensor = nullptr;
+
+	//! Scan header (standard fields)
+	E57ScanHeader header;
+	//! Whether the points are expressed with spherical coordinates
+	bool sphericalMode = false;
+	//! Number of points (as declared in the file)
+	int64_t pointCount = 0;
+
+	//! Scan grid (if any)
+	ccPointCloud::Grid::Shared scanGrid;
+	//! Intensity scalar field (if any)
+	ccScalarField* intensitySF = nullptr;
+	//! Return index scalar field (if any)
+	ccScalarField* returnIndexSF = nullptr;
+	//! Whether the scan has normals
+	bool hasNormals = false;
+	//! Whether the scan has colors
+	bool hasColors = false;
+	//! Load-time filter (if the points are filtered while they are read)
+	ccLoadingFilter* loadingFilter = nullptr;
+
+	// color ranges
+	double colorRedRange    = 1.0;
+	double colorRedOffset   = 0.0;
+	double colorGreenRange  = 1.0;
+	double colorGreenOffset = 0.0;
+	double colorBlueRange   = 1.0;
+	double colorBlueOffset  = 0.0;
+
+	// pose and global shift
+	ccGLMatrixd poseMat;
+	bool        validPoseMat            = false;
+	bool        poseMatWasShifted       = false;
+	CCVector3d  poseMatShift{0, 0, 0};
+	CCVector3d  pointShift{0, 0, 0};
+	bool        globalShiftApplied      = false;
+	bool        preserveCoordinateShift = true;
+
+	// reading output
+	Status     status = Status::Pending;
+	QString    errorMessage;
+	int64_t    realCount         = 0;
+	int64_t    invalidCount      = 0;
+	int64_t    zeroCount         = 0;
+	bool       hasValidIntensity = false;
+	ScalarType minIntensity      = 0;
+	ScalarType maxIntensity      = 0;
+};
+
+//! Releases the entities of a scan that couldn't be loaded
+static void ReleaseScan(ScanToRead& scan)
+{
+	delete scan.sensor;
+	scan.sensor = nullptr;
+	delete scan.cloud; // will also release the scalar fields
+	scan.cloud         = nullptr;
+	scan.intensitySF   = nullptr;
+	scan.returnIndexSF = nullptr;
+}
+
+//! Returns the (max) size of the decoding buffers of a scan, per point
+static size_t GetDecodingBufferSizePerPoint(const ScanToRead& scan)
+{
+	const E57ScanHeader& header = scan.header;
+
+	size_t size = 3 * sizeof(double) + sizeof(int8_t); // coordinates + validity
+	if (scan.scanGrid)
+		size += 2 * sizeof(int32_t);
+	if (scan.hasNormals)
+		size += 3 * sizeof(double);
+	if (scan.intensitySF)
+		size += sizeof(double) + (header.pointFields.isIntensityInvalidField ? sizeof(int8_t) : 0);
+	if (scan.hasColors)
+		size += 3 * sizeof(colorFieldType);
+	if (scan.returnIndexSF)
+		size += sizeof(int8_t);
+
+	return size;
+}
+
+//! Returns the coordinates of a point read from a scan
+static inline CCVector3d GetScanPoint(const TempArrays& arrays, size_t i, bool sphericalMode)
+{
+	CCVector3d Pd(0, 0, 0);
+	if (sphericalMode)
+	{
+		double r     = (arrays.xData.empty() ? 0 : arrays.xData[i]);
+		double theta = (arrays.yData.empty() ? 0 : arrays.yData[i]); // Azimuth
+		double phi   = (arrays.zData.empty() ? 0 : arrays.zData[i]); // Elevation
+
+		double cos_phi = cos(phi);
+		Pd.x           = r * cos_phi * cos(theta);
+		Pd.y           = r * cos_phi * sin(theta);
+		Pd.z           = r * sin(phi);
+	}
+	// DGM TODO: not handled yet (-->what are the standard cylindrical field names?)
+	/*else if (cylindricalMode)
+	{
+	    //from cylindrical coordinates
+	    assert(arrays.xData);
+	    double theta = (arrays.yData ? arrays.yData[i] : 0);
+	    Pd.x = arrays.xData[i] * cos(theta);
+	    Pd.y = arrays.xData[i] * sin(theta);
+	    if (arrays.zData)
+	        Pd.z = arrays.zData[i];
+	}
+	//*/
+	else // cartesian
+	{
+		if (!arrays.xData.empty())
+			Pd.x = arrays.xData[i];
+		if (!arrays.yData.empty())
+			Pd.y = arrays.yData[i];
+		if (!arrays.zData.empty())
+			Pd.z = arrays.zData[i];
+	}
+
+	return Pd;
+}
+
+//! Creates the buffers to read the coordinates (and their validity) of a scan
+static void AddCoordinateBuffers(e57::ImageFile&                     imf,
+                                 const e57::StructureNode&           prototype,
+                                 const ScanToRead&                   scan,
+                                 unsigned                            chunkSize,
+                                 TempArrays&                         arrays,
+                                 std::vector<e57::SourceDestBuffer>& dbufs)
+{
+	const E57ScanHeader& header = scan.header;
+
+	if (scan.sphericalMode)
+	{
+		// spherical coordinates
+		if (header.pointFields.sphericalRangeField)
+		{
+			arrays.xData.resize(chunkSize);
+			dbufs.emplace_back(imf, "sphericalRange", arrays.xData.data(), chunkSize, true, (prototype.get("sphericalRange").type() == e57::E57_SCALED_INTEGER));
+		}
+		if (header.pointFields.sphericalAzimuthField)
+		{
+			arrays.yData.resize(chunkSize);
+			dbufs.emplace_back(imf, "sphericalAzimuth", arrays.yData.data(), chunkSize, true, (prototype.get("sphericalAzimuth").type() == e57::E57_SCALED_INTEGER));
+		}
+		if (header.pointFields.sphericalElevationField)
+		{
+			arrays.zData.resize(chunkSize);
+			dbufs.emplace_back(imf, "sphericalElevation", arrays.zData.data(), chunkSize, true, (prototype.get("sphericalElevation").type() == e57::E57_SCALED_INTEGER));
+		}
+
+		// data validity
+		if (header.pointFields.sphericalInvalidStateField)
+		{
+			arrays.isInvalidData.resize(chunkSize);
+			dbufs.emplace_back(imf, "sphericalInvalidState", arrays.isInvalidData.data(), chunkSize, true, (prototype.get("sphericalInvalidState").type() == e57::E57_SCALED_INTEGER));
+		}
+	}
+	else
+	{
+		// cartesian coordinates
+		if (header.pointFields.cartesianXField)
+		{
+			arrays.xData.resize(chunkSize);
+			dbufs.emplace_back(imf, "cartesianX", arrays.xData.data(), chunkSize, true, (prototype.get("cartesianX").type() == e57::E57_SCALED_INTEGER));
+		}
+		if (header.pointFields.cartesianYField)
+		{
+			arrays.yData.resize(chunkSize);
+			dbufs.emplace_back(imf, "cartesianY", arrays.yData.data(), chunkSize, true, (prototype.get("cartesianY").type() == e57::E57_SCALED_INTEGER));
+		}
+		if (header.pointFields.cartesianZField)
+		{
+			arrays.zData.resize(chunkSize);
+			dbufs.emplace_back(imf, "cartesianZ", arrays.zData.data(), chunkSize, true, (prototype.get("cartesianZ").type() == e57::E57_SCALED_INTEGER));
+		}
+
+		// data validity
+		if (header.pointFields.cartesianInvalidStateField)
+		{
+			arrays.isInvalidData.resize(chunkSize);
+			dbufs.emplace_back(imf, "cartesianInvalidState", arrays.isInvalidData.data(), chunkSize, true, (prototype.get("cartesianInvalidState").type() == e57::E57_SCALED_INTEGER));
+		}
+	}
+}
+
+//! Reads the first valid point of a scan (to handle the global shift before reading the whole scan)
+static bool ReadFirstValidPoint(e57::ImageFile& imf, const e57::CompressedVectorNode& points, const ScanToRead& scan, CCVector3d& P)
+{
+	static const unsigned chunkSize = 1024;
+
+	e57::StructureNode                 prototype(points.prototype());
+	TempArrays                         arrays;
+	std::vector<e57::SourceDestBuffer> dbufs;
+	AddCoordinateBuffers(imf, prototype, scan, chunkSize, arrays, dbufs);
+
+	e57::CompressedVectorReader dataReader = points.reader(dbufs);
+
+	bool     found = false;
+	unsigned size  = 0;
+	while (!found && (size = dataReader.read()))
+	{
+		for (unsigned i = 0; i < size; ++i)
+		{
+			if (arrays.isInvalidData.empty() || arrays.isInvalidData[i] == 0)
+			{
+				P     = GetScanPoint(arrays, i, scan.sphericalMode);
+				found = true;
+				break;
+			}
+		}
+	}
+
+	dataReader.close();
+
+	return found;
+}
+
+//! Prepares a scan for reading (meta-data, pose, global shift and memory allocation)
+/** Must be called sequentially (and by the thread calling loadFile, as the Global Shift dialog may be displayed).
+**/
+static bool PrepareScan(e57::ImageFile& imf, const e57::Node& node, ScanToRead& scan, FileIOFilter::LoadParameters& parameters)
 {
 	if (node.type() != e57::E57_STRUCTURE)
 	{
 		ccLog::Warning("[E57Filter] Scan nodes should be STRUCTURES!");
-		return {};
+		return false;
 	}
 	e57::StructureNode scanNode(node);
 
 	QString scanName = GetStringFromNode(scanNode, "name", "unnamed");
+	scan.elementName = QString::fromStdString(scanNode.elementName());
 
 	// log
-	ccLog::Print(QString("[E57] Reading new scan node (%1) - %2").arg(scanNode.elementName().c_str()).arg(scanName));
+	ccLog::Print(QString("[E57] Reading new scan node (%1) - %2").arg(scan.elementName).arg(scanName));
 
 	if (!scanNode.isDefined("points"))
 	{
-		ccLog::Warning(QString("[E57Filter] No point in scan '%1'!").arg(scanNode.elementName().c_str()));
-		return {};
+		ccLog::Warning(QString("[E57Filter] No point in scan '%1'!").arg(scan.elementName));
+		return false;
 	}
 
 	// unique GUID
@@ -1733,37 +2117,37 @@ static LoadedScan LoadScan(const e57::Node& node, QString& guidStr, ccProgressDi
 	{
 		e57::Node guidNode = scanNode.get("guid");
 		assert(guidNode.type() == e57::E57_STRING);
-		guidStr = QString(static_cast<e57::StringNode>(guidNode).value().c_str());
+		scan.guid = QString(static_cast<e57::StringNode>(guidNode).value().c_str());
 	}
 	else
 	{
 		// No GUID!
-		guidStr.clear();
+		scan.guid.clear();
 	}
 
 	// points
 	e57::CompressedVectorNode points(scanNode.get("points"));
-	const int64_t             pointCount = points.childCount();
+	scan.pointCount = points.childCount();
 
 	// prototype for points
 	e57::StructureNode prototype(points.prototype());
-	E57ScanHeader      header;
+	E57ScanHeader&     header = scan.header;
 	DecodePrototype(scanNode, prototype, header);
 
-	bool sphericalMode = false;
 	// no cartesian fields?
 	if (!header.pointFields.cartesianXField && !header.pointFields.cartesianYField && !header.pointFields.cartesianZField)
 	{
 		// let's look for spherical ones
 		if (!header.pointFields.sphericalRangeField && !header.pointFields.sphericalAzimuthField && !header.pointFields.sphericalElevationField)
 		{
-			ccLog::Warning(QString("[E57Filter] No readable point in scan '%1'! (only cartesian and spherical coordinates are supported right now)").arg(scanNode.elementName().c_str()));
-			return {};
+			ccLog::Warning(QString("[E57Filter] No readable point in scan '%1'! (only cartesian and spherical coordinates are supported right now)").arg(scan.elementName));
+			return false;
 		}
-		sphericalMode = true;
+		scan.sphericalMode = true;
 	}
 
 	ccPointCloud* cloud = new ccPointCloud();
+	scan.cloud          = cloud;
 
 	if (scanNode.isDefined("name"))
 	{
@@ -1897,503 +2281,629 @@ static LoadedScan LoadScan(const e57::Node& node, QString& guidStr, ccProgressDi
 	// if (scanNode.isDefined("sphericalBounds"))
 
 	// scan "pose" relatively to the others
-	ccGLMatrixd  poseMat;
-	const bool   validPoseMat            = GetPoseInformation(scanNode, poseMat);
-	bool         preserveCoordinateShift = true;
-	bool         globalShiftApplied      = false;
-	bool         poseMatWasShifted       = false;
-	CCVector3d   poseMatShift;
-	ccGBLSensor* sensor = nullptr;
+	scan.validPoseMat = GetPoseInformation(scanNode, scan.poseMat);
 
-	if (validPoseMat)
+	if (scan.validPoseMat)
 	{
-		const CCVector3d T = poseMat.getTranslationAsVec3D();
-		if (FileIOFilter::HandleGlobalShift(T, poseMatShift, preserveCoordinateShift, s_loadParameters))
+		const CCVector3d T = scan.poseMat.getTranslationAsVec3D();
+		if (FileIOFilter::HandleGlobalShift(T, scan.poseMatShift, scan.preserveCoordinateShift, parameters))
 		{
-			poseMat.setTranslation((T + poseMatShift).u);
-			if (preserveCoordinateShift)
+			scan.poseMat.setTranslation((T + scan.poseMatShift).u);
+			if (scan.preserveCoordinateShift)
 			{
-				cloud->setGlobalShift(poseMatShift);
+				cloud->setGlobalShift(scan.poseMatShift);
 			}
-			poseMatWasShifted  = true;
-			globalShiftApplied = true;
-			ccLog::Warning("[E57Filter::loadFile] Cloud %s has been recentered! Translation: (%.2f ; %.2f ; %.2f)", qPrintable(guidStr), poseMatShift.x, poseMatShift.y, poseMatShift.z);
+			scan.poseMatWasShifted  = true;
+			scan.globalShiftApplied = true;
+			ccLog::Warning("[E57Filter::loadFile] Cloud %s has been recentered! Translation: (%.2f ; %.2f ; %.2f)", qPrintable(scan.guid), scan.poseMatShift.x, scan.poseMatShift.y, scan.poseMatShift.z);
 		}
 
 		// cloud->setGLTransformation(poseMat); //TODO-> apply it at the end instead! Otherwise we will loose original coordinates!
 
-		sensor = new ccGBLSensor();
-		sensor->setRigidTransformation(ccGLMatrix(poseMat.data()));
+		scan.sensor = new ccGBLSensor();
+		scan.sensor->setRigidTransformation(ccGLMatrix(scan.poseMat.data()));
 	}
 
-	// prepare temporary structures
-	const unsigned                     chunkSize = std::min<unsigned>(pointCount, (1 << 20)); // we load the file in several steps to limit the memory consumption
-	TempArrays                         arrays;
-	std::vector<e57::SourceDestBuffer> dbufs;
-
-	if (0 == pointCount)
+	if (0 == scan.pointCount)
 	{
 		ccLog::Warning(QString("[E57] Scan '%1' is empty").arg(scanName));
-		return {cloud, globalShiftApplied, poseMatShift, preserveCoordinateShift};
+		scan.status = ScanToRead::Status::Success;
+		return true;
+	}
+
+	// first point: check for 'big' coordinates
+	// (we must do it now, as the points are read concurrently afterwards)
+	if (!scan.poseMatWasShifted)
+	{
+		CCVector3d Pd;
+		if (ReadFirstValidPoint(imf, points, scan, Pd))
+		{
+			if (FileIOFilter::HandleGlobalShift(Pd, scan.pointShift, scan.preserveCoordinateShift, parameters))
+			{
+				scan.globalShiftApplied = true;
+				if (scan.preserveCoordinateShift)
+				{
+					cloud->setGlobalShift(scan.pointShift);
+				}
+				ccLog::Warning("[E57Filter::loadFile] Cloud %s has been recentered! Translation: (%.2f ; %.2f ; %.2f)", qPrintable(scan.guid), scan.pointShift.x, scan.pointShift.y, scan.pointShift.z);
+			}
+		}
+	}
+
+	// load-time filter (the points can't be filtered while they are read if they have to be transformed afterwards)
+	if (!scan.validPoseMat && parameters.loadingFilter && parameters.loadingFilter->isActive())
+	{
+		scan.loadingFilter = parameters.loadingFilter.data();
 	}
+	// the points are filtered by batches (no need to reserve memory for all of them)
+	const unsigned reservedCount = static_cast<unsigned>(scan.loadingFilter ? std::min<int64_t>(scan.pointCount, ccLoadingFilter::BatchSize) : scan.pointCount);
 
-	if (!cloud->reserve(static_cast<unsigned>(pointCount)))
+	if (!cloud->reserve(reservedCount))
 	{
 		ccLog::Error("[E57] Not enough memory!");
-		delete cloud;
-		return {};
+		return false;
 	}
 
-	// scan grid
-	ccPointCloud::Grid::Shared scanGrid;
-	if (header.pointFields.rowIndexField && header.pointFields.columnIndexField && gridRowCount != 0 && gridColumnCount != 0)
+	// scan grid (not compatible with the load-time filter)
+	if (header.pointFields.rowIndexField && header.pointFields.columnIndexField && gridRowCount != 0 && gridColumnCount != 0 && !scan.loadingFilter)
 	{
-		scanGrid.reset(new ccPointCloud::Grid);
-		if (scanGrid->init(static_cast<unsigned>(gridRowCount), static_cast<unsigned>(gridColumnCount)))
-		{
-			arrays.rowIndex.resize(chunkSize);
-			dbufs.emplace_back(node.destImageFile(), "rowIndex", arrays.rowIndex.data(), chunkSize, true);
-			arrays.columnIndex.resize(chunkSize);
-			dbufs.emplace_back(node.destImageFile(), "columnIndex", arrays.columnIndex.data(), chunkSize, true);
-		}
-		else
+		scan.scanGrid.reset(new ccPointCloud::Grid);
+		if (!scan.scanGrid->init(static_cast<unsigned>(gridRowCount), static_cast<unsigned>(gridColumnCount)))
 		{
 			ccLog::Warning("[E57] Not enough memory to load the scan grid");
-			scanGrid.clear();
+			scan.scanGrid.clear();
 		}
 	}
 
-	if (sphericalMode)
-	{
-		// spherical coordinates
-		if (header.pointFields.sphericalRangeField)
-		{
-			arrays.xData.resize(chunkSize);
-			dbufs.emplace_back(node.destImageFile(), "sphericalRange", arrays.xData.data(), chunkSize, true, (prototype.get("sphericalRange").type() == e57::E57_SCALED_INTEGER));
-		}
-		if (header.pointFields.sphericalAzimuthField)
-		{
-			arrays.yData.resize(chunkSize);
-			dbufs.emplace_back(node.destImageFile(), "sphericalAzimuth", arrays.yData.data(), chunkSize, true, (prototype.get("sphericalAzimuth").type() == e57::E57_SCALED_INTEGER));
-		}
-		if (header.pointFields.sphericalElevationField)
-		{
-			arrays.zData.resize(chunkSize);
-			dbufs.emplace_back(node.destImageFile(), "sphericalElevation", arrays.zData.data(), chunkSize, true, (prototype.get("sphericalElevation").type() == e57::E57_SCALED_INTEGER));
-		}
-
-		// data validity
-		if (header.pointFields.sphericalInvalidStateField)
-		{
-			arrays.isInvalidData.resize(chunkSize);
-			dbufs.emplace_back(node.destImageFile(), "sphericalInvalidState", arrays.isInvalidData.data(), chunkSize, true, (prototype.get("sphericalInvalidState").type() == e57::E57_SCALED_INTEGER));
-		}
-	}
-	else
-	{
-		// cartesian coordinates
-		if (header.pointFields.cartesianXField)
-		{
-			arrays.xData.resize(chunkSize);
-			dbufs.emplace_back(node.destImageFile(), "cartesianX", arrays.xData.data(), chunkSize, true, (prototype.get("cartesianX").type() == e57::E57_SCALED_INTEGER));
-		}
-		if (header.pointFields.cartesianYField)
-		{
-			arrays.yData.resize(chunkSize);
-			dbufs.emplace_back(node.destImageFile(), "cartesianY", arrays.yData.data(), chunkSize, true, (prototype.get("cartesianY").type() == e57::E57_SCALED_INTEGER));
-		}
-		if (header.pointFields.cartesianZField)
-		{
-			arrays.zData.resize(chunkSize);
-			dbufs.emplace_back(node.destImageFile(), "cartesianZ", arrays.zData.data(), chunkSize, true, (prototype.get("cartesianZ").type() == e57::E57_SCALED_INTEGER));
-		}
-
-		// data validity
-		if (header.pointFields.cartesianInvalidStateField)
-		{
-			arrays.isInvalidData.resize(chunkSize);
-			dbufs.emplace_back(node.destImageFile(), "cartesianInvalidState", arrays.isInvalidData.data(), chunkSize, true, (prototype.get("cartesianInvalidState").type() == e57::E57_SCALED_INTEGER));
-		}
-	}
-
-	// normals
-	bool hasNormals = (header.pointFields.normXField
-	                   || header.pointFields.normYField
-	                   || header.pointFields.normZField);
-	if (hasNormals)
+	// normals
+	scan.hasNormals = (header.pointFields.normXField
+	                   || header.pointFields.normYField
+	                   || header.pointFields.normZField);
+	if (scan.hasNormals)
 	{
 		if (!cloud->reserveTheNormsTable())
 		{
 			ccLog::Error("[E57] Not enough memory!");
-			delete cloud;
-			return {};
+			return false;
 		}
 		cloud->showNormals(true);
-		if (header.pointFields.normXField)
-		{
-			arrays.xNormData.resize(chunkSize);
-			dbufs.emplace_back(node.destImageFile(), "nor:normalX", arrays.xNormData.data(), chunkSize, true, (prototype.get("nor:normalX").type() == e57::E57_SCALED_INTEGER));
-		}
-		if (header.pointFields.normYField)
-		{
-			arrays.yNormData.resize(chunkSize);
-			dbufs.emplace_back(node.destImageFile(), "nor:normalY", arrays.yNormData.data(), chunkSize, true, (prototype.get("nor:normalY").type() == e57::E57_SCALED_INTEGER));
-		}
-		if (header.pointFields.normZField)
-		{
-			arrays.zNormData.resize(chunkSize);
-			dbufs.emplace_back(node.destImageFile(), "nor:normalZ", arrays.zNormData.data(), chunkSize, true, (prototype.get("nor:normalZ").type() == e57::E57_SCALED_INTEGER));
-		}
 	}
 
 	// intensity
-	// double intRange = 0;
-	// double intOffset = 0;
-	// ScalarType invalidSFValue = 0;
-
-	ccScalarField* intensitySF = nullptr;
 	if (header.pointFields.intensityField)
 	{
-		intensitySF = new ccScalarField(CC_E57_INTENSITY_FIELD_NAME);
-		if (!intensitySF->resizeSafe(static_cast<unsigned>(pointCount)))
+		scan.intensitySF = new ccScalarField(CC_E57_INTENSITY_FIELD_NAME);
+		if (!scan.intensitySF->reserveSafe(reservedCount))
 		{
 			ccLog::Error("[E57] Not enough memory!");
-			intensitySF->release();
-			delete cloud;
-			return {};
-		}
-		cloud->addScalarField(intensitySF);
-
-		arrays.intData.resize(chunkSize);
-		dbufs.emplace_back(node.destImageFile(), "intensity", arrays.intData.data(), chunkSize, true, (prototype.get("intensity").type() == e57::E57_SCALED_INTEGER));
-		// intRange = header.intensityLimits.intensityMaximum - header.intensityLimits.intensityMinimum;
-		// intOffset = header.intensityLimits.intensityMinimum;
-
-		if (header.pointFields.isIntensityInvalidField)
-		{
-			arrays.isInvalidIntData.resize(chunkSize);
-			dbufs.emplace_back(node.destImageFile(), "isIntensityInvalid", arrays.isInvalidIntData.data(), chunkSize, true, (prototype.get("isIntensityInvalid").type() == e57::E57_SCALED_INTEGER));
+			scan.intensitySF->release();
+			scan.intensitySF = nullptr;
+			return false;
 		}
+		cloud->addScalarField(scan.intensitySF);
 	}
 
-	// color buffers
-	double colorRedRange    = 1;
-	double colorRedOffset   = 0;
-	double colorGreenRange  = 1;
-	double colorGreenOffset = 0;
-	double colorBlueRange   = 1;
-	double colorBlueOffset  = 0;
-	bool   hasColors        = (header.pointFields.colorRedField
-                      || header.pointFields.colorGreenField
-                      || header.pointFields.colorBlueField);
-	if (hasColors)
+	// colors
+	scan.hasColors = (header.pointFields.colorRedField
+	                  || header.pointFields.colorGreenField
+	                  || header.pointFields.colorBlueField);
+	if (scan.hasColors)
 	{
 		if (!cloud->reserveTheRGBTable())
 		{
 			ccLog::Error("[E57] Not enough memory!");
-			delete cloud;
-			return {};
+			return false;
 		}
 		if (header.pointFields.colorRedField)
 		{
-			arrays.redData.resize(chunkSize);
-			colorRedOffset = header.colorLimits.colorRedMinimum;
-			colorRedRange  = header.colorLimits.colorRedMaximum - header.colorLimits.colorRedMinimum;
-			if (colorRedRange <= 0.0)
-				colorRedRange = 1.0;
-			dbufs.emplace_back(node.destImageFile(), "colorRed", arrays.redData.data(), chunkSize, true, (prototype.get("colorRed").type() == e57::E57_SCALED_INTEGER));
+			scan.colorRedOffset = header.colorLimits.colorRedMinimum;
+			scan.colorRedRange  = header.colorLimits.colorRedMaximum - header.colorLimits.colorRedMinimum;
+			if (scan.colorRedRange <= 0.0)
+				scan.colorRedRange = 1.0;
 		}
 		if (header.pointFields.colorGreenField)
 		{
-			arrays.greenData.resize(chunkSize);
-			colorGreenOffset = header.colorLimits.colorGreenMinimum;
-			colorGreenRange  = header.colorLimits.colorGreenMaximum - header.colorLimits.colorGreenMinimum;
-			if (colorGreenRange <= 0.0)
-				colorGreenRange = 1.0;
-			dbufs.emplace_back(node.destImageFile(), "colorGreen", arrays.greenData.data(), chunkSize, true, (prototype.get("colorGreen").type() == e57::E57_SCALED_INTEGER));
+			scan.colorGreenOffset = header.colorLimits.colorGreenMinimum;
+			scan.colorGreenRange  = header.colorLimits.colorGreenMaximum - header.colorLimits.colorGreenMinimum;
+			if (scan.colorGreenRange <= 0.0)
+				scan.colorGreenRange = 1.0;
 		}
 		if (header.pointFields.colorBlueField)
 		{
-			arrays.blueData.resize(chunkSize);
-			colorBlueOffset = header.colorLimits.colorBlueMinimum;
-			colorBlueRange  = header.colorLimits.colorBlueMaximum - header.colorLimits.colorBlueMinimum;
-			if (colorBlueRange <= 0.0)
-				colorBlueRange = 1.0;
-			dbufs.emplace_back(node.destImageFile(), "colorBlue", arrays.blueData.data(), chunkSize, true, (prototype.get("colorBlue").type() == e57::E57_SCALED_INTEGER));
+			scan.colorBlueOffset = header.colorLimits.colorBlueMinimum;
+			scan.colorBlueRange  = header.colorLimits.colorBlueMaximum - header.colorLimits.colorBlueMinimum;
+			if (scan.colorBlueRange <= 0.0)
+				scan.colorBlueRange = 1.0;
 		}
 	}
 
 	// return index (multiple shoots scanners)
-	ccScalarField* returnIndexSF = nullptr;
 	if (header.pointFields.returnIndexField && header.pointFields.returnMaximum > 0)
 	{
 		// we store the point return index as a scalar field
-		returnIndexSF = new ccScalarField(CC_E57_RETURN_INDEX_FIELD_NAME);
-		if (!returnIndexSF->resizeSafe(static_cast<unsigned>(pointCount)))
+		scan.returnIndexSF = new ccScalarField(CC_E57_RETURN_INDEX_FIELD_NAME);
+		if (!scan.returnIndexSF->reserveSafe(reservedCount))
 		{
 			ccLog::Error("[E57] Not enough memory!");
-			delete cloud;
-			returnIndexSF->release();
-			return {};
+			scan.returnIndexSF->release();
+			scan.returnIndexSF = nullptr;
+			return false;
 		}
-		cloud->addScalarField(returnIndexSF);
-		arrays.scanIndexData.resize(chunkSize);
-		dbufs.emplace_back(node.destImageFile(), "returnIndex", arrays.scanIndexData.data(), chunkSize, true, (prototype.get("returnIndex").type() == e57::E57_SCALED_INTEGER));
+		cloud->addScalarField(scan.returnIndexSF);
 	}
 
-	// Read the point data
-	e57::CompressedVectorReader dataReader = points.reader(dbufs);
+	return true;
+}
 
-	// local progress bar
-	CCCoreLib::NormalizedProgress nprogress(progressDlg, static_cast<unsigned>(pointCount / chunkSize));
-	if (progressDlg)
-	{
-		progressDlg->setMethodTitle(QObject::tr("Read E57 file"));
-		progressDlg->setInfo(QObject::tr("Scan #%1 - %2 points").arg(s_absoluteScanIndex).arg(pointCount));
-		progressDlg->start();
-		QApplication::processEvents();
-	}
+//! Reads the points of a (prepared) scan
+/** Thread-safe as long as each thread uses its own ImageFile instance.
+    \param imf image file (opened by the calling thread)
+    \param data3D 'data3D' vector node (of the same image file)
+    \param scan prepared scan
+    \param readPointCount number of points read so far (shared by all threads, for progress report)
+    \param cancelRequested whether the process has been cancelled
+**/
+static void ReadScanPoints(e57::ImageFile&          imf,
+                           const e57::VectorNode&   data3D,
+                           ScanToRead&              scan,
+                           std::atomic<int64_t>&    readPointCount,
+                           const std::atomic<bool>& cancelRequested)
+{
+	assert(scan.status == ScanToRead::Status::Pending);
 
-	CCVector3d Pshift(0, 0, 0);
-	unsigned   size         = 0;
-	int64_t    realCount    = 0;
-	int64_t    invalidCount = 0;
-	int64_t    zeroCount    = 0;
-	int        col = 0, row = 0;
-	while ((size = dataReader.read()))
+	ccPointCloud*        cloud  = scan.cloud;
+	const E57ScanHeader& header = scan.header;
+
+	try
 	{
-		for (unsigned i = 0; i < size; ++i)
+		e57::StructureNode        scanNode(data3D.get(scan.index));
+		e57::CompressedVectorNode points(scanNode.get("points"));
+		e57::StructureNode        prototype(points.prototype());
+
+		// prepare temporary structures
+		const unsigned                     chunkSize = std::min<unsigned>(scan.pointCount, (1 << 20)); // we load the file in several steps to limit the memory consumption
+		TempArrays                         arrays;
+		std::vector<e57::SourceDestBuffer> dbufs;
+
+		// scan grid
+		if (scan.scanGrid)
 		{
-			if (scanGrid)
+			arrays.rowIndex.resize(chunkSize);
+			dbufs.emplace_back(imf, "rowIndex", arrays.rowIndex.data(), chunkSize, true);
+			arrays.columnIndex.resize(chunkSize);
+			dbufs.emplace_back(imf, "columnIndex", arrays.columnIndex.data(), chunkSize, true);
+		}
+
+		// coordinates
+		AddCoordinateBuffers(imf, prototype, scan, chunkSize, arrays, dbufs);
+
+		// normals
+		if (scan.hasNormals)
+		{
+			if (header.pointFields.normXField)
 			{
-				col = arrays.columnIndex[i];
-				row = arrays.rowIndex[i];
+				arrays.xNormData.resize(chunkSize);
+				dbufs.emplace_back(imf, "nor:normalX", arrays.xNormData.data(), chunkSize, true, (prototype.get("nor:normalX").type() == e57::E57_SCALED_INTEGER));
 			}
-
-			// we skip invalid points!
-			if (!arrays.isInvalidData.empty() && arrays.isInvalidData[i] != 0)
+			if (header.pointFields.normYField)
 			{
-				++invalidCount;
-				if (scanGrid)
-				{
-					scanGrid->setIndex(row, col, -1);
-				}
-				continue;
+				arrays.yNormData.resize(chunkSize);
+				dbufs.emplace_back(imf, "nor:normalY", arrays.yNormData.data(), chunkSize, true, (prototype.get("nor:normalY").type() == e57::E57_SCALED_INTEGER));
 			}
-
-			CCVector3d Pd(0, 0, 0);
-			if (sphericalMode)
+			if (header.pointFields.normZField)
 			{
-				double r     = (arrays.xData.empty() ? 0 : arrays.xData[i]);
-				double theta = (arrays.yData.empty() ? 0 : arrays.yData[i]); // Azimuth
-				double phi   = (arrays.zData.empty() ? 0 : arrays.zData[i]); // Elevation
+				arrays.zNormData.resize(chunkSize);
+				dbufs.emplace_back(imf, "nor:normalZ", arrays.zNormData.data(), chunkSize, true, (prototype.get("nor:normalZ").type() == e57::E57_SCALED_INTEGER));
+			}
+		}
+
+		// intensity
+		if (scan.intensitySF)
+		{
+			arrays.intData.resize(chunkSize);
+			dbufs.emplace_back(imf, "intensity", arrays.intData.data(), chunkSize, true, (prototype.get("intensity").type() == e57::E57_SCALED_INTEGER));
 
-				double cos_phi = cos(phi);
-				Pd.x           = r * cos_phi * cos(theta);
-				Pd.y           = r * cos_phi * sin(theta);
-				Pd.z           = r * sin(phi);
+			if (header.pointFields.isIntensityInvalidField)
+			{
+				arrays.isInvalidIntData.resize(chunkSize);
+				dbufs.emplace_back(imf, "isIntensityInvalid", arrays.isInvalidIntData.data(), chunkSize, true, (prototype.get("isIntensityInvalid").type() == e57::E57_SCALED_INTEGER));
 			}
-			// DGM TODO: not handled yet (-->what are the standard cylindrical field names?)
-			/*else if (cylindricalMode)
+		}
+
+		// colors
+		if (scan.hasColors)
+		{
+			if (header.pointFields.colorRedField)
 			{
-			    //from cylindrical coordinates
-			    assert(arrays.xData);
-			    double theta = (arrays.yData ? arrays.yData[i] : 0);
-			    Pd.x = arrays.xData[i] * cos(theta);
-			    Pd.y = arrays.xData[i] * sin(theta);
-			    if (arrays.zData)
-			        Pd.z = arrays.zData[i];
+				arrays.redData.resize(chunkSize);
+				dbufs.emplace_back(imf, "colorRed", arrays.redData.data(), chunkSize, true, (prototype.get("colorRed").type() == e57::E57_SCALED_INTEGER));
 			}
-			//*/
-			else // cartesian
+			if (header.pointFields.colorGreenField)
 			{
-				if (!arrays.xData.empty())
-					Pd.x = arrays.xData[i];
-				if (!arrays.yData.empty())
-					Pd.y = arrays.yData[i];
-				if (!arrays.zData.empty())
-					Pd.z = arrays.zData[i];
+				arrays.greenData.resize(chunkSize);
+				dbufs.emplace_back(imf, "colorGreen", arrays.greenData.data(), chunkSize, true, (prototype.get("colorGreen").type() == e57::E57_SCALED_INTEGER));
 			}
-
-			if (Pd.x == 0 && Pd.y == 0 && Pd.z == 0)
+			if (header.pointFields.colorBlueField)
 			{
-				++zeroCount;
+				arrays.blueData.resize(chunkSize);
+				dbufs.emplace_back(imf, "colorBlue", arrays.blueData.data(), chunkSize, true, (prototype.get("colorBlue").type() == e57::E57_SCALED_INTEGER));
 			}
+		}
+
+		// return index
+		if (scan.returnIndexSF)
+		{
+			arrays.scanIndexData.resize(chunkSize);
+			dbufs.emplace_back(imf, "returnIndex", arrays.scanIndexData.data(), chunkSize, true, (prototype.get("returnIndex").type() == e57::E57_SCALED_INTEGER));
+		}
+
+		// Read the point data
+		e57::CompressedVectorReader dataReader = points.reader(dbufs);
 
-			// first point: check for 'big' coordinates
-			if (realCount == 0 && !poseMatWasShifted)
+		unsigned size      = 0;
+		int      col       = 0, row = 0;
+		unsigned filterPos = 0; // index of the first point not filtered yet
+		while ((size = dataReader.read()))
+		{
+			for (unsigned i = 0; i < size; ++i)
 			{
-				if (FileIOFilter::HandleGlobalShift(Pd, Pshift, preserveCoordinateShift, s_loadParameters))
+				if (scan.scanGrid)
+				{
+					col = arrays.columnIndex[i];
+					row = arrays.rowIndex[i];
+				}
+
+				// we skip invalid points!
+				if (!arrays.isInvalidData.empty() && arrays.isInvalidData[i] != 0)
 				{
-					globalShiftApplied = true;
-					if (preserveCoordinateShift)
+					++scan.invalidCount;
+					if (scan.scanGrid)
 					{
-						cloud->setGlobalShift(Pshift);
+						scan.scanGrid->setIndex(row, col, -1);
 					}
-					ccLog::Warning("[E57Filter::loadFile] Cloud %s has been recentered! Translation: (%.2f ; %.2f ; %.2f)", qPrintable(guidStr), Pshift.x, Pshift.y, Pshift.z);
+					continue;
 				}
-			}
 
-			if (scanGrid)
-			{
-				scanGrid->setIndex(row, col, static_cast<int>(cloud->size()));
-			}
+				CCVector3d Pd = GetScanPoint(arrays, i, scan.sphericalMode);
 
-			const CCVector3 P = (Pd + Pshift).toPC();
-			cloud->addPoint(P);
+				if (Pd.x == 0 && Pd.y == 0 && Pd.z == 0)
+				{
+					++scan.zeroCount;
+				}
 
-			if (hasNormals)
-			{
-				CCVector3 N(0, 0, 0);
-				if (!arrays.xNormData.empty())
-					N.x = static_cast<PointCoordinateType>(arrays.xNormData[i]);
-				if (!arrays.yNormData.empty())
-					N.y = static_cast<PointCoordinateType>(arrays.yNormData[i]);
-				if (!arrays.zNormData.empty())
-					N.z = static_cast<PointCoordinateType>(arrays.zNormData[i]);
-				N.normalize();
-				cloud->addNorm(N);
-			}
+				if (scan.scanGrid)
+				{
+					scan.scanGrid->setIndex(row, col, static_cast<int>(cloud->size()));
+				}
 
-			if (!arrays.intData.empty())
-			{
-				assert(intensitySF);
-				if (!header.pointFields.isIntensityInvalidField || arrays.isInvalidIntData[i] != INVALID_DATA)
+				const CCVector3 P = (Pd + scan.pointShift).toPC();
+				cloud->addPoint(P);
+
+				if (scan.hasNormals)
 				{
-					// ScalarType intensity = (ScalarType)((arrays.intData[i] - intOffset)/intRange); //Normalize intensity to 0 - 1.
-					const ScalarType intensity = static_cast<ScalarType>(arrays.intData[i]);
-					intensitySF->setValue(static_cast<unsigned>(realCount), intensity);
+					CCVector3 N(0, 0, 0);
+					if (!arrays.xNormData.empty())
+						N.x = static_cast<PointCoordinateType>(arrays.xNormData[i]);
+					if (!arrays.yNormData.empty())
+						N.y = static_cast<PointCoordinateType>(arrays.yNormData[i]);
+					if (!arrays.zNormData.empty())
+						N.z = static_cast<PointCoordinateType>(arrays.zNormData[i]);
+					N.normalize();
+					cloud->addNorm(N);
+				}
 
-					// track max intensity (for proper visualization)
-					if (s_absoluteScanIndex != 0 || realCount != 0)
+				if (!arrays.intData.empty())
+				{
+					assert(scan.intensitySF);
+					if (!header.pointFields.isIntensityInvalidField || arrays.isInvalidIntData[i] != INVALID_DATA)
 					{
-						if (s_maxIntensity < intensity)
-							s_maxIntensity = intensity;
-						else if (s_minIntensity > intensity)
-							s_minIntensity = intensity;
+						const ScalarType intensity = static_cast<ScalarType>(arrays.intData[i]);
+						scan.intensitySF->addElement(intensity);
+
+						// track max intensity (for proper visualization)
+						if (scan.hasValidIntensity)
+						{
+							if (scan.maxIntensity < intensity)
+								scan.maxIntensity = intensity;
+							else if (scan.minIntensity > intensity)
+								scan.minIntensity = intensity;
+						}
+						else
+						{
+							scan.maxIntensity = scan.minIntensity = intensity;
+							scan.hasValidIntensity                = true;
+						}
 					}
 					else
 					{
-						s_maxIntensity = s_minIntensity = intensity;
+						scan.intensitySF->addElement(CCCoreLib::NAN_VALUE);
 					}
 				}
-				else
+
+				if (scan.hasColors)
 				{
-					intensitySF->flagValueAsInvalid(static_cast<unsigned>(realCount));
+					// Normalize color to 0 - 255
+					ccColor::Rgb C(0, 0, 0);
+					if (!arrays.redData.empty())
+						C.r = static_cast<ColorCompType>(((arrays.redData[i] - scan.colorRedOffset) * 255) / scan.colorRedRange);
+					if (!arrays.greenData.empty())
+						C.g = static_cast<ColorCompType>(((arrays.greenData[i] - scan.colorGreenOffset) * 255) / scan.colorGreenRange);
+					if (!arrays.blueData.empty())
+						C.b = static_cast<ColorCompType>(((arrays.blueData[i] - scan.colorBlueOffset) * 255) / scan.colorBlueRange);
+
+					cloud->addColor(C);
 				}
+
+				if (!arrays.scanIndexData.empty())
+				{
+					assert(scan.returnIndexSF);
+					const ScalarType s = static_cast<ScalarType>(arrays.scanIndexData[i]);
+					scan.returnIndexSF->addElement(s);
+				}
+
+				++scan.realCount;
 			}
 
-			if (hasColors)
-			{
-				// Normalize color to 0 - 255
-				ccColor::Rgb C(0, 0, 0);
-				if (!arrays.redData.empty())
-					C.r = static_cast<ColorCompType>(((arrays.redData[i] - colorRedOffset) * 255) / colorRedRange);
-				if (!arrays.greenData.empty())
-					C.g = static_cast<ColorCompType>(((arrays.greenData[i] - colorGreenOffset) * 255) / colorGreenRange);
-				if (!arrays.blueData.empty())
-					C.b = static_cast<ColorCompType>(((arrays.blueData[i] - colorBlueOffset) * 255) / colorBlueRange);
+			readPointCount += size;
 
-				cloud->addColor(C);
+			if (scan.loadingFilter && cloud->size() - filterPos >= ccLoadingFilter::BatchSize)
+			{
+				scan.loadingFilter->filter(cloud, filterPos);
+				filterPos = cloud->size();
 			}
 
-			if (!arrays.scanIndexData.empty())
+			if (cancelRequested)
 			{
-				assert(returnIndexSF);
-				const ScalarType s = static_cast<ScalarType>(arrays.scanIndexData[i]);
-				returnIndexSF->setValue(static_cast<unsigned>(realCount), s);
+				scan.status = ScanToRead::Status::Canceled;
+				break;
 			}
+		}
+
+		dataReader.close();
 
-			realCount++;
+		if (scan.loadingFilter)
+		{
+			scan.loadingFilter->filter(cloud, filterPos);
+		}
+	}
+	catch (const e57::E57Exception& e)
+	{
+		scan.status       = ScanToRead::Status::E57Error;
+		scan.errorMessage = QString::fromStdString(e57::Utilities::errorCodeToString(e.errorCode()));
+		if (!e.context().empty())
+		{
+			scan.errorMessage += QStringLiteral(" (context: %1)").arg(QString::fromStdString(e.context()));
 		}
+		return;
+	}
+	catch (const std::bad_alloc&)
+	{
+		scan.status = ScanToRead::Status::NotEnoughMemory;
+		return;
+	}
 
-		if (progressDlg && !nprogress.oneStep())
+	if (scan.realCount == 0)
+	{
+		if (scan.status != ScanToRead::Status::Canceled)
 		{
-			QApplication::processEvents();
-			s_cancelRequestedByUser = true;
-			break;
+			scan.status = ScanToRead::Status::NoValidPoint;
+		}
+		return;
+	}
+	else if (cloud->size() == 0)
+	{
+		// all the points have been rejected by the load-time filter
+		if (scan.status != ScanToRead::Status::Canceled)
+		{
+			scan.status = ScanToRead::Status::NoPointKept;
 		}
+		return;
+	}
+	else if (cloud->size() < scan.pointCount)
+	{
+		cloud->shrinkToFit();
 	}
 
-	dataReader.close();
+	// Scan grid
+	if (scan.scanGrid)
+	{
+		scan.scanGrid->validCount    = scan.realCount;
+		scan.scanGrid->minValidIndex = 0;
+		scan.scanGrid->maxValidIndex = scan.realCount - 1;
+		cloud->addGrid(scan.scanGrid);
+	}
 
-	if (zeroCount > 1)
+	// Scalar fields
+	if (scan.intensitySF)
+	{
+		scan.intensitySF->computeMinAndMax();
+	}
+	if (scan.returnIndexSF)
 	{
-		ccLog::Warning(QString("[E57] Number of points clustured at the origin: %1 (consider removing duplicate points)").arg(zeroCount));
+		scan.returnIndexSF->computeMinAndMax();
 	}
 
-	if (realCount == 0)
+	// we don't deal with virtual transformation (yet)
+	if (scan.validPoseMat)
 	{
-		ccLog::Warning(QString("[E57] No valid point in scan '%1'!").arg(scanNode.elementName().c_str()));
-		delete cloud;
-		return {};
+		const ccGLMatrix poseMatf(scan.poseMat.data());
+
+		cloud->applyGLTransformation_recursive(&poseMatf);
+		// this transformation is of no interest for the user
+		cloud->resetGLTransformationHistory_recursive();
 	}
-	else if (realCount < pointCount)
+
+	if (scan.status == ScanToRead::Status::Pending)
 	{
-		if ((realCount + invalidCount) != pointCount)
+		scan.status = ScanToRead::Status::Success;
+	}
+}
+
+//! Finalizes a scan once its points have been read
+/** Must be called sequentially (from the main thread). The cloud is deleted if the scan couldn't be read.
+**/
+static LoadedScan FinalizeScan(ScanToRead& scan)
+{
+	ccPointCloud* cloud = scan.cloud;
+
+	switch (scan.status)
+	{
+	case ScanToRead::Status::Success:
+		break;
+	case ScanToRead::Status::Canceled:
+		if (cloud->size() == 0)
 		{
-			ccLog::Warning(QString("[E57] We read fewer points than expected for scan '%1' (%2/%3)").arg(scanNode.elementName().c_str()).arg(realCount).arg(pointCount));
+			cloud = nullptr;
 		}
+		break;
+	case ScanToRead::Status::Pending:
+		// the scan hasn't been read at all (process cancelled, or no reader could be opened)
+		cloud = nullptr;
+		break;
+	case ScanToRead::Status::NoValidPoint:
+		ccLog::Warning(QString("[E57] No valid point in scan '%1'!").arg(scan.elementName));
+		cloud = nullptr;
+		break;
+	case ScanToRead::Status::NoPointKept:
+		ccLog::Warning(QString("[E57] No point of scan '%1' passed the loading filter").arg(scan.elementName));
+		cloud = nullptr;
+		break;
+	case ScanToRead::Status::NotEnoughMemory:
+		ccLog::Error("[E57] Not enough memory!");
+		cloud = nullptr;
+		break;
+	case ScanToRead::Status::E57Error:
+		ccLog::Warning(QString("[E57] Failed to read scan '%1': %2").arg(scan.elementName, scan.errorMessage));
+		cloud = nullptr;
+		break;
+	}
 
-		cloud->resize(static_cast<unsigned>(realCount));
+	if (!cloud)
+	{
+		ReleaseScan(scan);
+		return {};
 	}
 
-	// Scan grid
-	if (scanGrid)
+	if (scan.pointCount == 0)
+	{
+		// empty scan
+		delete scan.sensor;
+		scan.sensor = nullptr;
+		scan.cloud  = nullptr;
+		return {cloud, scan.globalShiftApplied, scan.poseMatShift, scan.preserveCoordinateShift};
+	}
+
+	if (scan.zeroCount > 1)
+	{
+		ccLog::Warning(QString("[E57] Number of points clustured at the origin: %1 (consider removing duplicate points)").arg(scan.zeroCount));
+	}
+
+	if (scan.status == ScanToRead::Status::Success && scan.realCount < scan.pointCount && (scan.realCount + scan.invalidCount) != scan.pointCount)
 	{
-		scanGrid->validCount    = realCount;
-		scanGrid->minValidIndex = 0;
-		scanGrid->maxValidIndex = realCount - 1;
-		cloud->addGrid(scanGrid);
+		ccLog::Warning(QString("[E57] We read fewer points than expected for scan '%1' (%2/%3)").arg(scan.elementName).arg(scan.realCount).arg(scan.pointCount));
+	}
 
-		ccLog::Print(QString("[E57] Scan grid loaded for scan '%1' (%2 x %3)").arg(scanNode.elementName().c_str()).arg(scanGrid->w).arg(scanGrid->h));
+	// Scan grid
+	if (scan.scanGrid)
+	{
+		ccLog::Print(QString("[E57] Scan grid loaded for scan '%1' (%2 x %3)").arg(scan.elementName).arg(scan.scanGrid->w).arg(scan.scanGrid->h));
 	}
 
 	// Scalar fields
-	if (intensitySF)
+	if (scan.intensitySF)
 	{
-		intensitySF->computeMinAndMax();
-		if (intensitySF->getMin() >= 0 && intensitySF->getMax() <= 1.0)
-			intensitySF->setColorScale(ccColorScalesManager::GetDefaultScale(ccColorScalesManager::ABS_NORM_GREY));
+		if (scan.intensitySF->getMin() >= 0 && scan.intensitySF->getMax() <= 1.0)
+			scan.intensitySF->setColorScale(ccColorScalesManager::GetDefaultScale(ccColorScalesManager::ABS_NORM_GREY));
 		else
-			intensitySF->setColorScale(ccColorScalesManager::GetDefaultScale(ccColorScalesManager::GREY));
-		cloud->setCurrentDisplayedScalarField(cloud->getScalarFieldIndexByName(intensitySF->getName()));
+			scan.intensitySF->setColorScale(ccColorScalesManager::GetDefaultScale(ccColorScalesManager::GREY));
+		cloud->setCurrentDisplayedScalarField(cloud->getScalarFieldIndexByName(scan.intensitySF->getName()));
 		cloud->showSF(true);
 	}
 
-	if (returnIndexSF)
+	if (scan.returnIndexSF)
 	{
-		returnIndexSF->computeMinAndMax();
-		cloud->setCurrentDisplayedScalarField(cloud->getScalarFieldIndexByName(returnIndexSF->getName()));
+		cloud->setCurrentDisplayedScalarField(cloud->getScalarFieldIndexByName(scan.returnIndexSF->getName()));
 		ccLog::Warning("[E57] Cloud has multiple echoes: use 'Edit > Scalar Fields > Filter by value' to extract one component");
 		cloud->showSF(true);
 	}
 
-	cloud->showColors(hasColors);
+	cloud->showColors(scan.hasColors);
 	cloud->setVisible(true);
 
-	// we don't deal with virtual transformation (yet)
-	if (validPoseMat)
+	if (scan.validPoseMat)
 	{
-		const ccGLMatrix poseMatf(poseMat.data());
-
-		cloud->applyGLTransformation_recursive(&poseMatf);
-		// this transformation is of no interest for the user
-		cloud->resetGLTransformationHistory_recursive();
-
 		// save the original pose matrix as meta-data
-		cloud->setMetaData(s_e57PoseKey, poseMat.toString(12, ' '));
+		cloud->setMetaData(s_e57PoseKey, scan.poseMat.toString(12, ' '));
 	}
 
-	if (sensor) // add the sensor at the end, after calling applyGLTransformation_recursive!
+	if (scan.sensor) // add the sensor at the end, after calling applyGLTransformation_recursive!
 	{
-		sensor->setEnabled(false);
-		sensor->setVisible(true);
-		sensor->setGraphicScale(cloud->getOwnBB().getDiagNorm() / 20);
-		cloud->addChild(sensor);
+		scan.sensor->setEnabled(false);
+		scan.sensor->setVisible(true);
+		scan.sensor->setGraphicScale(cloud->getOwnBB().getDiagNorm() / 20);
+		cloud->addChild(scan.sensor);
+		scan.sensor = nullptr;
 	}
 
-	return {cloud, globalShiftApplied, poseMatWasShifted ? poseMatShift : Pshift, preserveCoordinateShift};
+	scan.cloud = nullptr; // the cloud is now owned by the caller
+	return {cloud, scan.globalShiftApplied, scan.poseMatWasShifted ? scan.poseMatShift : scan.pointShift, scan.preserveCoordinateShift};
+}
+
+//! Reads the points of several scans (concurrently with other calls)
+/** Each call opens its own ImageFile, as libE57Format objects can't be shared between threads.
+    \param filename E57 filename
+    \param scans prepared scans
+    \param nextScan index of the next scan to read (shared by all threads)
+    \param readPointCount number of points read so far (shared by all threads, for progress report)
+    \param scanRead per-scan flags, set once a scan has been read (so that it can be finalized)
+    \param cancelRequested whether the process has been cancelled
+**/
+static void ReadScans(const QString&           filename,
+                      std::vector<ScanToRead>& scans,
+                      std::atomic<size_t>&     nextScan,
+                      std::atomic<int64_t>&    readPointCount,
+                      std::atomic<bool>*       scanRead,
+                      const std::atomic<bool>& cancelRequested)
+{
+	try
+	{
+		e57::ImageFile imf(filename.toStdString(), "r", e57::CHECKSUM_POLICY_SPARSE);
+		if (!imf.isOpen())
+		{
+			return;
+		}
+
+		// for normals handling
+		static const e57::ustring normalsExtension("http://www.libe57.org/E57_NOR_surface_normals.txt");
+		e57::ustring              _normalsExtension;
+		if (!imf.extensionsLookupPrefix("nor", _normalsExtension)) // the extension may already be registered
+		{
+			imf.extensionsAdd("nor", normalsExtension);
+		}
+
+		e57::VectorNode data3D(imf.root().get("/data3D"));
+
+		for (size_t i = nextScan++; i < scans.size() && !cancelRequested; i = nextScan++)
+		{
+			ScanToRead& scan = scans[i];
+			if (scan.status == ScanToRead::Status::Pending) // the empty scans are already 'read'
+			{
+				ReadScanPoints(imf, data3D, scan, readPointCount, cancelRequested);
+			}
+			scanRead[i] = true;
+		}
+
+		imf.close();
+	}
+	catch (const e57::E57Exception& e)
+	{
+		// the remaining scans will be read by the other threads (if they can)
+		ccLog::Warning(QString("[E57] Failed to open a reader: %1").arg(e57::Utilities::errorCodeToString(e.errorCode()).c_str()));
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[E57] Not enough memory to open a reader");
+	}
 }
 
 //! Loaded image
@@ -2405,7 +2915,121 @@ struct LoadedImage
 	ccCameraSensor* sensor       = nullptr;
 };
 
-static LoadedImage LoadImage(const e57::Node& node, QString& associatedData3DGuid)
+//! Reads and decodes the image data (JPG or PNG blob) of a camera representation node
+/** Doesn't create any entity: can be called from any thread (with its own ImageFile).
+**/
+static bool ReadImageData(const e57::StructureNode& cameraRepresentationNode, QImage& qImage)
+{
+	Image2DType imageType = E57_NO_IMAGE;
+	const char* blobName  = nullptr;
+	if (cameraRepresentationNode.isDefined("jpegImage"))
+	{
+		imageType = E57_JPEG_IMAGE;
+		blobName  = "jpegImage";
+	}
+	else if (cameraRepresentationNode.isDefined("pngImage"))
+	{
+		imageType = E57_PNG_IMAGE;
+		blobName  = "pngImage";
+	}
+	else
+	{
+		return false;
+	}
+
+	e57::BlobNode blob(cameraRepresentationNode.get(blobName));
+	int64_t       imageSize = blob.byteCount();
+	if (imageSize <= 0)
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> imageBits;
+	try
+	{
+		imageBits.resize(static_cast<size_t>(imageSize));
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[E57] Not enough memory to load image!");
+		return false;
+	}
+
+	blob.read(imageBits.data(), 0, imageBits.size());
+
+	bool loadResult = qImage.loadFromData(imageBits.data(), static_cast<int>(imageSize), imageType == E57_PNG_IMAGE ? "png" : "jpg");
+
+	// a bug in some 2.13.alpha versions was causing CC to save JPEG images declared as PNG images :(
+	if (!loadResult && imageType == E57_PNG_IMAGE)
+	{
+		loadResult = qImage.loadFromData(imageBits.data(), static_cast<int>(imageSize), "jpegImage");
+		ccLog::Warning("[E57] JPG image was wrongly tagged as PNG. You should save this E57 again to fix this...");
+	}
+
+	return loadResult;
+}
+
+//! Returns the camera representation node of an image node (if any)
+static bool GetCameraRepresentationNode(const e57::StructureNode& imageNode, e57::StructureNode& cameraRepresentationNode)
+{
+	for (const char* name : {VisualReferenceRepresentation::GetName(), PinholeRepresentation::GetName(), SphericalRepresentation::GetName(), CylindricalRepresentation::GetName()})
+	{
+		if (imageNode.isDefined(name))
+		{
+			cameraRepresentationNode = e57::StructureNode(imageNode.get(name));
+			return true;
+		}
+	}
+	return false;
+}
+
+//! Reads and decodes the data of all the images of an E57 file (for LoadImage)
+/** Meant to be run in the background (opens its own ImageFile).
+    \param filename E57 filename
+    \param images output images (same order as the 'images2D' vector - the images that couldn't be read are left null)
+    \param cancelRequested whether the process has been cancelled
+**/
+static void ReadImagesData(const QString& filename, std::vector<QImage>& images, const std::atomic<bool>& cancelRequested)
+{
+	try
+	{
+		e57::ImageFile imf(filename.toStdString(), "r", e57::CHECKSUM_POLICY_SPARSE);
+		if (!imf.isOpen())
+		{
+			return;
+		}
+
+		e57::VectorNode images2D(imf.root().get("/images2D"));
+		size_t          imageCount = std::min(images.size(), static_cast<size_t>(images2D.childCount()));
+		for (size_t i = 0; i < imageCount && !cancelRequested; ++i)
+		{
+			e57::Node imageNode = images2D.get(i);
+			if (imageNode.type() != e57::E57_STRUCTURE)
+			{
+				continue;
+			}
+
+			e57::StructureNode cameraRepresentationNode(imf);
+			if (GetCameraRepresentationNode(e57::StructureNode(imageNode), cameraRepresentationNode))
+			{
+				ReadImageData(cameraRepresentationNode, images[i]);
+			}
+		}
+
+		imf.close();
+	}
+	catch (const e57::E57Exception& e)
+	{
+		// the images will be read again by LoadImage
+		ccLog::Warning(QString("[E57] Failed to read the images in the background: %1").arg(e57::Utilities::errorCodeToString(e.errorCode()).c_str()));
+	}
+	catch (const std::bad_alloc&)
+	{
+		// the images will be read again by LoadImage
+	}
+}
+
+static LoadedImage LoadImage(const e57::Node& node, QString& associatedData3DGuid, const QImage* decodedImage = nullptr)
 {
 	if (node.type() != e57::E57_STRUCTURE)
 	{
@@ -2511,13 +3135,6 @@ static LoadedImage LoadImage(const e57::Node& node, QString& associatedData3DGui
 		return {};
 	}
 
-	uint8_t* imageBits = new uint8_t[cameraRepresentation->imageSize];
-	if (!imageBits)
-	{
-		ccLog::Warning("[E57] Not enough memory to load image!");
-		return {};
-	}
-
 	if (cameraRepresentationNode.isDefined("imageMask"))
 	{
 		cameraRepresentation->imageMaskSize = e57::BlobNode(cameraRepresentationNode.get("imageMask")).byteCount();
@@ -2560,30 +3177,6 @@ static LoadedImage LoadImage(const e57::Node& node, QString& associatedData3DGui
 		cylindrical->radius          = e57::FloatNode(cameraRepresentationNode.get("radius")).value();
 	}
 
-	// reading image data
-	char imageFormat[4] = "jpg";
-	switch (cameraRepresentation->imageType)
-	{
-	case E57_JPEG_IMAGE:
-	{
-		assert(cameraRepresentationNode.isDefined("jpegImage"));
-		e57::BlobNode jpegImage(cameraRepresentationNode.get("jpegImage"));
-		jpegImage.read(imageBits, 0, static_cast<size_t>(cameraRepresentation->imageSize));
-		break;
-	}
-	case E57_PNG_IMAGE:
-	{
-		strcpy(imageFormat, "png");
-		assert(cameraRepresentationNode.isDefined("pngImage"));
-		e57::BlobNode pngImage(cameraRepresentationNode.get("pngImage"));
-		pngImage.read((uint8_t*)imageBits, 0, static_cast<size_t>(cameraRepresentation->imageSize));
-		break;
-	}
-	default:
-		assert(false);
-		break;
-	}
-
 	// handle mask?
 	if (cameraRepresentation->imageMaskSize > 0)
 	{
@@ -2594,21 +3187,13 @@ static LoadedImage LoadImage(const e57::Node& node, QString& associatedData3DGui
 		cameraRepresentation->imageMaskSize = 0;
 	}
 
+	// reading image data (if not already done)
 	QImage qImage;
-	assert(imageBits);
-	bool loadResult = qImage.loadFromData(imageBits, static_cast<int>(cameraRepresentation->imageSize), imageFormat);
-
-	// a bug in some 2.13.alpha versions was causing CC to save JPEG images declared as PNG images :(
-	if (!loadResult && cameraRepresentation->imageType == E57_PNG_IMAGE)
+	if (decodedImage && !decodedImage->isNull())
 	{
-		loadResult = qImage.loadFromData(imageBits, static_cast<int>(cameraRepresentation->imageSize), "jpegImage");
-		ccLog::Warning("[E57] JPG image was wrongly tagged as PNG. You should save this E57 again to fix this...");
+		qImage = *decodedImage;
 	}
-
-	delete[] imageBits;
-	imageBits = nullptr;
-
-	if (!loadResult)
+	else if (!ReadImageData(cameraRepresentationNode, qImage))
 	{
 		ccLog::Warning("[E57] Failed to load image from blob data!");
 		return {};
@@ -2688,7 +3273,11 @@ static LoadedImage LoadImage(const e57::Node& node, QString& associatedData3DGui
 
 CC_FILE_ERROR E57Filter::loadFile(const QString& filename, ccHObject& container, LoadParameters& parameters)
 {
-	s_loadParameters = parameters;
+	// images decoded in the background (if any)
+	std::vector<QImage> decodedImages;
+	QFuture<void>       imagesFuture;
+	std::atomic<bool>   cancelRequested(false);
+	bool                cancelRequestedByUser = false;
 
 	CC_FILE_ERROR result = CC_FERR_NO_ERROR;
 	try
@@ -2746,64 +3335,230 @@ CC_FILE_ERROR E57Filter::loadFile(const QString& filename, ccHObject& container,
 
 			unsigned scanCount = static_cast<unsigned>(data3D.childCount());
 
+			// the images (if any) are read and decoded in the background, while the scans are loaded
+			if (root.isDefined("/images2D"))
+			{
+				e57::Node images2D = root.get("/images2D");
+				if (images2D.type() == e57::E57_VECTOR && e57::VectorNode(images2D).childCount() != 0)
+				{
+					decodedImages.resize(static_cast<size_t>(e57::VectorNode(images2D).childCount()));
+					imagesFuture = QtConcurrent::run([&filename, &decodedImages, &cancelRequested]()
+					                                 { ReadImagesData(filename, decodedImages, cancelRequested); });
+				}
+			}
+
+			// prepare the scans (sequentially, as the Global Shift may have to be handled)
+			std::vector<ScanToRead> scansToRead(scanCount);
+			int64_t                 totalPointCount  = 0;
+			size_t                  maxChunkMemory   = 0;
+			bool                    scansHaveNormals = false;
+			for (unsigned i = 0; i < scanCount; ++i)
+			{
+				ScanToRead& scan = scansToRead[i];
+				scan.index       = i;
+
+				bool prepared = false;
+				try
+				{
+					prepared = PrepareScan(imf, data3D.get(i), scan, parameters);
+				}
+				catch (...)
+				{
+					for (ScanToRead& preparedScan : scansToRead)
+					{
+						ReleaseScan(preparedScan);
+					}
+					throw;
+				}
+
+				if (!prepared)
+				{
+					ReleaseScan(scan);
+					continue;
+				}
+
+				if (scan.status == ScanToRead::Status::Pending)
+				{
+					totalPointCount += scan.pointCount;
+					maxChunkMemory   = std::max(maxChunkMemory, std::min<size_t>(scan.pointCount, (1 << 20)) * GetDecodingBufferSizePerPoint(scan));
+					scansHaveNormals |= scan.hasNormals;
+				}
+			}
+
+			if (scansHaveNormals)
+			{
+				// make sure the normals lookup table is initialized before being (potentially) used concurrently
+				ccNormalVectors::GetUniqueInstance();
+			}
+
 			// global progress bar
 			QScopedPointer<ccProgressDialog> progressDlg(nullptr);
 			if (parameters.parentWidget)
 			{
 				progressDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
 				progressDlg->setAutoClose(false);
-			}
-
-			bool showGlobalProgress = (scanCount > 10);
-			if (progressDlg && showGlobalProgress)
-			{
-				// Too many scans, will display a global progress bar
 				progressDlg->setMethodTitle(QObject::tr("Read E57 file"));
-				progressDlg->setInfo(QObject::tr("Scans: %1").arg(scanCount));
+				progressDlg->setInfo(QObject::tr("Scans: %1\nPoints: %L2").arg(scanCount).arg(totalPointCount));
 				progressDlg->start();
 				QApplication::processEvents();
 			}
-			CCCoreLib::NormalizedProgress nprogress(progressDlg.data(), showGlobalProgress ? scanCount : 100);
-
-			// static states
-			s_absoluteScanIndex     = 0;
-			s_cancelRequestedByUser = false;
-			s_minIntensity = s_maxIntensity = 0;
-			for (unsigned i = 0; i < scanCount; ++i)
+			// or asynchronous loading task (no dialog in this case)
+			CCCoreLib::GenericProgressCallback* progressCb = progressDlg ? static_cast<CCCoreLib::GenericProgressCallback*>(progressDlg.data()) : parameters.loadingTask;
+
+			// when loaded asynchronously, the scans are delivered as soon as they are read (unless
+			// they have to be associated with images, once all the scans are loaded)
+			const bool deliverScans = (parameters.loadingTask && decodedImages.empty());
+
+			// finalizes a scan (in the file order)
+			bool       firstIntensity = true;
+			ScalarType minIntensity   = 0;
+			ScalarType maxIntensity   = 0;
+			auto finalizeScan   = [&](ScanToRead& scan, bool deliver)
 			{
-				const e57::Node scanNode = data3D.get(i);
-				QString         scanGUID;
+				if (!scan.cloud)
+				{
+					// the scan couldn't be prepared
+					return;
+				}
+
+				if (scan.status == ScanToRead::Status::E57Error)
+				{
+					result = CC_FERR_THIRD_PARTY_LIB_EXCEPTION;
+				}
+
+				// track max intensity (for proper visualization)
+				if (scan.hasValidIntensity)
+				{
+					if (firstIntensity)
+					{
+						minIntensity = scan.minIntensity;
+						maxIntensity = scan.maxIntensity;
+						firstIntensity = false;
+					}
+					else
+					{
+						minIntensity = std::min(minIntensity, scan.minIntensity);
+						maxIntensity = std::max(maxIntensity, scan.maxIntensity);
+					}
+				}
 
-				LoadedScan scan = LoadScan(scanNode, scanGUID, showGlobalProgress ? nullptr : progressDlg.data());
+				LoadedScan loadedScan = FinalizeScan(scan);
 
-				if (scan.entity)
+				if (loadedScan.entity)
 				{
-					if (scan.entity->getName().isEmpty())
+					if (loadedScan.entity->getName().isEmpty())
 					{
-						QString      name("Scan ");
-						e57::ustring nodeName = scanNode.elementName();
+						QString name("Scan ");
 
-						if (!nodeName.empty())
-							name += QString::fromStdString(nodeName);
+						if (!scan.elementName.isEmpty())
+							name += scan.elementName;
 						else
-							name += QString::number(i);
+							name += QString::number(scan.index);
 
-						scan.entity->setName(name);
+						loadedScan.entity->setName(name);
 					}
-					container.addChild(scan.entity);
 
-					// we also add the scan to the GUID/object map
-					if (!scanGUID.isEmpty())
+					if (deliver)
+					{
+						// the delivered scans keep their own saturation values (and can't be associated with images)
+						FileIOFilter::DeliverEntity(loadedScan.entity, container, parameters);
+					}
+					else
 					{
-						scans.insert(scanGUID, scan);
+						container.addChild(loadedScan.entity);
+
+						// we also add the scan to the GUID/object map
+						if (!scan.guid.isEmpty())
+						{
+							scans.insert(scan.guid, loadedScan);
+						}
 					}
 				}
+			};
 
-				if ((showGlobalProgress && progressDlg && !nprogress.oneStep()) || s_cancelRequestedByUser)
+			// read the scans concurrently (each thread with its own reader)
+			size_t nextScanToFinalize = 0;
+			{
+				int threadCount = std::max(1, QThread::idealThreadCount());
+				threadCount     = std::min(threadCount, static_cast<int>(std::max(1u, scanCount)));
+				if (maxChunkMemory != 0)
 				{
-					break;
+					// limit the memory used by the decoding buffers
+					threadCount = std::min(threadCount, static_cast<int>(std::max<size_t>(1, MAX_DECODING_BUFFERS_SIZE / maxChunkMemory)));
+				}
+
+				std::atomic<size_t>  nextScan(0);
+				std::atomic<int64_t> readPointCount(0);
+
+				std::unique_ptr<std::atomic<bool>[]> scanRead(new std::atomic<bool>[scanCount]);
+				for (unsigned i = 0; i < scanCount; ++i)
+				{
+					scanRead[i] = false;
+				}
+
+				std::vector<QFuture<void>> readers;
+				readers.reserve(threadCount);
+				for (int t = 0; t < threadCount; ++t)
+				{
+					readers.push_back(QtConcurrent::run([&]()
+					                                    { ReadScans(filename, scansToRead, nextScan, readPointCount, scanRead.get(), cancelRequested); }));
+				}
+
+				for (QFuture<void>& reader : readers)
+				{
+					while (!reader.isFinished())
+					{
+						QThread::msleep(50);
+						if (progressCb)
+						{
+							if (progressCb->isCancelRequested())
+							{
+								cancelRequested = true;
+							}
+							if (totalPointCount != 0)
+							{
+								progressCb->update(static_cast<float>((100.0 * readPointCount) / totalPointCount));
+							}
+						}
+						if (progressDlg)
+						{
+							QApplication::processEvents();
+						}
+
+						if (deliverScans)
+						{
+							// deliver the scans that have been entirely read so far
+							while (nextScanToFinalize < scansToRead.size() && scanRead[nextScanToFinalize])
+							{
+								finalizeScan(scansToRead[nextScanToFinalize++], true);
+							}
+						}
+					}
+				}
+
+				// if no reader could be opened (or if some of them failed), the remaining scans are read with the main one
+				for (unsigned i = 0; i < scanCount && !cancelRequested; ++i)
+				{
+					if (!scanRead[i])
+					{
+						if (scansToRead[i].status == ScanToRead::Status::Pending)
+						{
+							ReadScanPoints(imf, data3D, scansToRead[i], readPointCount, cancelRequested);
+						}
+						scanRead[i] = true;
+					}
 				}
-				++s_absoluteScanIndex;
+			}
+
+			if (cancelRequested)
+			{
+				cancelRequestedByUser = true;
+			}
+
+			// finalize the remaining scans
+			for (; nextScanToFinalize < scansToRead.size(); ++nextScanToFinalize)
+			{
+				finalizeScan(scansToRead[nextScanToFinalize], deliverScans);
 			}
 
 			if (progressDlg)
@@ -2821,18 +3576,18 @@ CC_FILE_ERROR E57Filter::loadFile(const QString& filename, ccHObject& container,
 					ccScalarField* sf = pc->getCurrentDisplayedScalarField();
 					if (sf)
 					{
-						sf->setSaturationStart(s_minIntensity);
-						sf->setSaturationStop(s_maxIntensity);
+						sf->setSaturationStart(minIntensity);
+						sf->setSaturationStop(maxIntensity);
 					}
 				}
 			}
 		}
 
-		// we save parameters
-		parameters = s_loadParameters;
+		// wait for the images to be decoded (if any)
+		imagesFuture.waitForFinished();
 
 		// Image data?
-		if (!s_cancelRequestedByUser && root.isDefined("/images2D"))
+		if (!cancelRequestedByUser && root.isDefined("/images2D"))
 		{
 			e57::Node n = root.get("/images2D"); // E57 standard: "images2D is a vector for storing two dimensional images"
 			if (n.type() != e57::E57_VECTOR)
@@ -2862,7 +3617,7 @@ CC_FILE_ERROR E57Filter::loadFile(const QString& filename, ccHObject& container,
 				{
 					e57::Node   imageNode = images2D.get(i);
 					QString     associatedData3DGuid;
-					LoadedImage image = LoadImage(imageNode, associatedData3DGuid);
+					LoadedImage image = LoadImage(imageNode, associatedData3DGuid, i < decodedImages.size() ? &decodedImages[i] : nullptr);
 					if (image.entity)
 					{
 						// no name?
@@ -2914,7 +3669,7 @@ CC_FILE_ERROR E57Filter::loadFile(const QString& filename, ccHObject& container,
 							{
 								// we may have to apply a Gloal Shift to the sensor (if any)
 								const CCVector3d T     = image.poseMat.getTranslationAsVec3D();
-								applySensorGlobalShift = FileIOFilter::HandleGlobalShift(T, poseMatShift, preserveCoordinateShift, s_loadParameters);
+								applySensorGlobalShift = FileIOFilter::HandleGlobalShift(T, poseMatShift, preserveCoordinateShift, parameters);
 
 								if (image.sensor && preserveCoordinateShift)
 								{
@@ -2944,7 +3699,7 @@ CC_FILE_ERROR E57Filter::loadFile(const QString& filename, ccHObject& container,
 
 					if (progressDlg && !nprogress.oneStep())
 					{
-						s_cancelRequestedByUser = true;
+						cancelRequestedByUser = true;
 						break;
 					}
 				}
@@ -2970,8 +3725,12 @@ CC_FILE_ERROR E57Filter::loadFile(const QString& filename, ccHObject& container,
 		result = CC_FERR_THIRD_PARTY_LIB_EXCEPTION;
 	}
 
+	// make sure the background decoding of the images is over (in case of error)
+	cancelRequested = true;
+	imagesFuture.waitForFinished();
+
 	// special case: process has been cancelled by user
-	if (result == CC_FERR_NO_ERROR && s_cancelRequestedByUser)
+	if (result == CC_FERR_NO_ERROR && cancelRequestedByUser)
 	{
 		result = CC_FERR_CANCELED_BY_USER;
 	}
@@ -17,6 +17,7 @@
 
 #include "qE57IO.h"
 
+#include "E57Command.h"
 #include "E57Filter.h"
 
 qE57IO::qE57IO(QObject* parent)
@@ -27,7 +28,7 @@ qE57IO::qE57IO(QObject* parent)
 
 void qE57IO::registerCommands(ccCommandLineInterface* cmd)
 {
-	Q_UNUSED(cmd);
+	cmd->registerCommand(ccCommandLineInterface::Command::Shared(new E57Command));
 }
 
 ccIOPluginInterface::FilterList qE57IO::getFilters()
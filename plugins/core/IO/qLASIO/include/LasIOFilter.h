@@ -22,9 +22,18 @@
 #include "LasExtraScalarField.h"
 #include "LasOpenDialog.h"
 
+// Qt
+#include <QMap>
+#include <QMutex>
+
 // System
 #include <memory>
 
+namespace copc
+{
+	class CopcLoader;
+}
+
 class LasIOFilter : public FileIOFilter
 {
   public:
@@ -32,9 +41,20 @@ class LasIOFilter : public FileIOFilter
 
 	// Inherited from FileIOFilter
 	CC_FILE_ERROR loadFile(const QString& fileName, ccHObject& container, LoadParameters& parameters) override;
+	bool          prepareConcurrentLoad(const QString& fileName, LoadParameters& parameters, CC_FILE_ERROR& result) override;
 	bool          canSave(CC_CLASS_ENUM type, bool& multiple, bool& exclusive) const override;
 	CC_FILE_ERROR saveToFile(ccHObject* entity, const QString& filename, const SaveParameters& parameters) override;
 
+  private:
+	/// Fills the open dialog with the content of the file, and shows it if needed.
+	///
+	/// The dialog can only be used by the main thread.
+	CC_FILE_ERROR showOpenDialog(const laszip_header* laszipHeader, const copc::CopcLoader* copcLoader, const LoadParameters& parameters);
+
+	/// Returns the options chosen for a file to be loaded in a background thread
+	/// (see prepareConcurrentLoad), or the last ones chosen with the dialog.
+	LasLoadingOptions takeLoadingOptions(const QString& fileName);
+
   private:
 	struct FileInfo
 	{
@@ -79,4 +99,11 @@ class LasIOFilter : public FileIOFilter
 
 	std::unique_ptr<FileInfo> m_infoOfLastOpened;
 	LasOpenDialog             m_openDialog{};
+
+	/// Options chosen for the files to be loaded in background threads
+	QMap<QString, LasLoadingOptions> m_preparedLoadingOptions;
+	/// Last options chosen with the dialog
+	LasLoadingOptions m_lastLoadingOptions;
+	/// Protects the loading options (the files may be loaded concurrently)
+	QMutex m_loadingOptionsMutex;
 };
@@ -25,7 +25,12 @@
 // GUI generated by Qt Designer
 #include <ui_lasopendialog.h>
 
+// Qt
+#include <QSet>
+
 // system
+#include <array>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -33,6 +38,38 @@
 #include <CCGeom.h>
 #include <ccLog.h>
 
+/// Options chosen by the user to load a LAS file.
+///
+/// They are plain values (see LasOpenDialog::loadingOptions), so that
+/// a file can be loaded without accessing the dialog (e.g. in a background thread).
+struct LasLoadingOptions final
+{
+	/// Names of the standard scalar fields that shouldn't be loaded
+	QSet<QString> uncheckedScalarFields;
+	/// Names of the extra scalar fields that shouldn't be loaded
+	QSet<QString> uncheckedExtraScalarFields;
+	/// Names of the extra scalar fields to be used as normals (empty if none)
+	std::array<QString, 3> normalFields;
+
+	bool ignoreFieldsWithDefaultValues = true;
+	bool force8bitColors               = false;
+	bool decomposeClassification       = true;
+
+	/// COPC max level
+	uint32_t copcMaxLevel = std::numeric_limits<uint32_t>::max();
+	/// Whether the COPC extent should be used
+	bool                       hasUsableCopcExtent = false;
+	LasDetails::UnscaledExtent copcExtent;
+
+	/// Removes from the lists scalar fields and extra scalar fields
+	/// which the user unchecked from the list of fields to load.
+	void filterOutNotChecked(std::vector<LasScalarField>&      scalarFields,
+	                         std::vector<LasExtraScalarField>& extraScalarFields) const;
+
+	/// Returns the array of extra scalar fields to be used as normals
+	std::array<LasExtraScalarField, 3> getExtraFieldsToBeLoadedAsNormals(const std::vector<LasExtraScalarField>& extraScalarFields) const;
+};
+
 /// Dialog shown to the user when opening a LAS file
 class LasOpenDialog : public QDialog
     , public Ui::LASOpenDialog
@@ -61,20 +98,12 @@ class LasOpenDialog : public QDialog
 	void setAvailableScalarFields(const std::vector<LasScalarField>&      scalarFields,
 	                              const std::vector<LasExtraScalarField>& extraScalarFields);
 
-	/// Removes from the lists scalar fields and extra scalar fields
-	/// which the user unchecked from the list of fields to load.
-	void filterOutNotChecked(std::vector<LasScalarField>&      scalarFields,
-	                         std::vector<LasExtraScalarField>& extraScalarFields);
-
 	/// handle COPC tab visibility
 	void displayCopcTab(bool visibilityState);
 
 	/// set informations to fill the copc tab
 	void setCopcInformations(const std::vector<uint64_t>& level_point_count, const LasDetails::UnscaledExtent& copcBB);
 
-	/// Returns the array of extra scalar fields to be used as normals
-	std::array<LasExtraScalarField, 3> getExtraFieldsToBeLoadedAsNormals(const std::vector<LasExtraScalarField>& extraScalarFields) const;
-
 	/// Returns whether the user wants to ignore (not load)
 	/// fields for which values are all default values.
 	bool shouldIgnoreFieldsWithDefaultValues() const;
@@ -107,15 +136,16 @@ class LasOpenDialog : public QDialog
 	/// Returns the current extent defined in the COPC tab
 	LasDetails::UnscaledExtent copcExtent() const;
 
+	/// Returns the loading options.
+	///
+	/// Only valid when the action is Load
+	LasLoadingOptions loadingOptions() const;
+
 	void resetShouldSkipDialog();
 
 	bool shouldSkipDialog() const;
 
   private:
-	bool isChecked(const LasScalarField& lasScalarField) const;
-
-	bool isChecked(const LasExtraScalarField& lasExtraScalarField) const;
-
 	void doSelectAll(bool doSelect);
 	void doSelectAllESF(bool doSelect);
 
@@ -32,6 +32,7 @@
 #include <CCGeom.h>
 #include <GenericProgressCallback.h>
 #include <ccColorScalesManager.h>
+#include <ccFileLoadingTask.h>
 #include <ccPointCloud.h>
 #include <ccProgressDialog.h>
 #include <ccScalarField.h>
@@ -45,6 +46,7 @@
 #include <laszip/laszip_api.h>
 
 // System
+#include <limits>
 #include <memory>
 #include <utility>
 
@@ -87,26 +89,17 @@ static CCVector3d GetGlobalShift(FileIOFilter::LoadParameters& parameters,
 	return shift;
 }
 
-LasIOFilter::LasIOFilter()
-    : FileIOFilter({"LAS IO Filter",
-                    3.0f, // priority (same as the old PDAL-based plugin)
-                    QStringList{"las", "laz"},
-                    "las",
-                    QStringList{"LAS file (*.las *.laz *.copc.laz)"},
-                    QStringList{"LAS file (*.las *.laz)"},
-                    Import | Export})
+static void CloseLasReader(laszip_POINTER laszipReader)
 {
-	m_openDialog.resetShouldSkipDialog();
+	laszip_close_reader(laszipReader);
+	laszip_clean(laszipReader);
+	laszip_destroy(laszipReader);
 }
 
-CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
-                                    ccHObject&      container,
-                                    LoadParameters& parameters)
+static CC_FILE_ERROR OpenLasReader(const QString& fileName, laszip_POINTER& laszipReader, laszip_header*& laszipHeader)
 {
-	laszip_POINTER laszipReader;
-	laszip_header* laszipHeader{nullptr};
-	laszip_BOOL    isCompressed{false};
-	laszip_CHAR*   errorMsg{nullptr};
+	laszip_BOOL  isCompressed{false};
+	laszip_CHAR* errorMsg{nullptr};
 
 	if (laszip_create(&laszipReader))
 	{
@@ -127,49 +120,55 @@ CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
 	{
 		laszip_get_error(laszipHeader, &errorMsg);
 		ccLog::Warning("[LAS] laszip error: '%s'", errorMsg);
-		laszip_close_reader(laszipReader);
-		laszip_clean(laszipReader);
-		laszip_destroy(laszipReader);
+		CloseLasReader(laszipReader);
 		return CC_FERR_THIRD_PARTY_LIB_FAILURE;
 	}
 
-	laszip_U64 pointCount = TrueNumberOfPoints(laszipHeader);
+	return CC_FERR_NO_ERROR;
+}
 
-	if (pointCount >= std::numeric_limits<unsigned>::max())
+static std::unique_ptr<copc::CopcLoader> CreateCopcLoader(laszip_header* laszipHeader, const QString& fileName)
+{
+	// Check that all COPC (pre)conditions are met before creating a loader
+	if (!copc::CopcLoader::IsPutativeCOPCFile(laszipHeader))
 	{
-		ccLog::Error("[LAS] Files with more that %u points are not supported", std::numeric_limits<unsigned>::max());
-		return CC_FERR_NOT_IMPLEMENTED;
+		return nullptr;
 	}
 
-	// intervalsToRead is initialized to only one interval
-	// from 0 to the last point of the LAS file
-	LasDetails::ChunkInterval                                      fullInterval(0, pointCount);
-	std::vector<std::reference_wrapper<LasDetails::ChunkInterval>> chunksToRead;
-	chunksToRead.emplace_back(fullInterval);
+	auto copcLoader = std::make_unique<copc::CopcLoader>(laszipHeader, fileName);
+	// The Loader constructor could fail, check its valididy
+	// If it fails to create a valid COPC reader we give the file another chance to be read as a "regular" LAZ file
+	if (!copcLoader->isValid())
+	{
+		ccLog::Warning("[LAS] Something went wrong with the initial parsing of the COPC structure, fall back to regular LAZ reading");
+		return nullptr;
+	}
+
+	return copcLoader;
+}
 
+LasIOFilter::LasIOFilter()
+    : FileIOFilter({"LAS IO Filter",
+                    3.0f, // priority (same as the old PDAL-based plugin)
+                    QStringList{"las", "laz"},
+                    "las",
+                    QStringList{"LAS file (*.las *.laz *.copc.laz)"},
+                    QStringList{"LAS file (*.las *.laz)"},
+                    Import | Export | ConcurrentLoad})
+{
+	m_openDialog.resetShouldSkipDialog();
+}
+
+CC_FILE_ERROR LasIOFilter::showOpenDialog(const laszip_header* laszipHeader, const copc::CopcLoader* copcLoader, const LoadParameters& parameters)
+{
 	// COPC handling
-	m_openDialog.displayCopcTab(false);
-	std::unique_ptr<copc::CopcLoader> copcLoader{nullptr};
-	// Check that all COPC (pre)conditions are met before creating a loader
-	if (copc::CopcLoader::IsPutativeCOPCFile(laszipHeader))
+	m_openDialog.displayCopcTab(copcLoader != nullptr);
+	if (copcLoader)
 	{
-		copcLoader = std::make_unique<copc::CopcLoader>(laszipHeader, fileName);
-		// The Loader constructor could fail, check its valididy
-		// If it fails to create a valid COPC reader we give the file another chance to be read as a "regular" LAZ file
-		if (copcLoader->isValid())
-		{
-			m_openDialog.displayCopcTab(true);
-			m_openDialog.setCopcInformations(copcLoader->levelPointCounts(), copcLoader->extent());
-		}
-		else
-		{
-			ccLog::Warning("[LAS] Something went wrong with the initial parsing of the COPC structure, fall back to regular LAZ reading");
-			copcLoader.reset(nullptr);
-		}
+		m_openDialog.setCopcInformations(copcLoader->levelPointCounts(), copcLoader->extent());
 	}
 
-	std::vector<LasScalarField>
-	    availableScalarFields = LasScalarField::ForPointFormat(laszipHeader->point_data_format);
+	std::vector<LasScalarField> availableScalarFields = LasScalarField::ForPointFormat(laszipHeader->point_data_format);
 
 	std::vector<LasExtraScalarField> availableExtraScalarFields = LasExtraScalarField::ParseExtraScalarFields(*laszipHeader);
 
@@ -180,7 +179,7 @@ CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
 
 	bool fileContentIsDifferentFromPrevious = (m_infoOfLastOpened && (*m_infoOfLastOpened != *infoOfCurrentFile));
 
-	m_openDialog.setInfo(laszipHeader->version_minor, laszipHeader->point_data_format, pointCount);
+	m_openDialog.setInfo(laszipHeader->version_minor, laszipHeader->point_data_format, TrueNumberOfPoints(laszipHeader));
 	m_openDialog.setAvailableScalarFields(availableScalarFields, availableExtraScalarFields);
 	m_infoOfLastOpened = std::move(infoOfCurrentFile);
 
@@ -210,31 +209,142 @@ CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
 		m_openDialog.exec();
 		if (m_openDialog.result() == QDialog::Rejected)
 		{
-			laszip_close_reader(laszipReader);
-			laszip_clean(laszipReader);
-			laszip_destroy(laszipReader);
 			return CC_FERR_CANCELED_BY_USER;
 		}
 	}
 
-	// Tiling takes precedence over COPC
+	if (m_openDialog.action() == LasOpenDialog::Action::Load)
+	{
+		QMutexLocker locker(&m_loadingOptionsMutex);
+		m_lastLoadingOptions = m_openDialog.loadingOptions();
+	}
+
+	return CC_FERR_NO_ERROR;
+}
+
+LasLoadingOptions LasIOFilter::takeLoadingOptions(const QString& fileName)
+{
+	QMutexLocker locker(&m_loadingOptionsMutex);
+
+	if (m_preparedLoadingOptions.contains(fileName))
+	{
+		return m_preparedLoadingOptions.take(fileName);
+	}
+
+	// the file hasn't been prepared: the COPC constraints of the last file can't be used
+	LasLoadingOptions options   = m_lastLoadingOptions;
+	options.copcMaxLevel        = std::numeric_limits<uint32_t>::max();
+	options.hasUsableCopcExtent = false;
+	return options;
+}
+
+bool LasIOFilter::prepareConcurrentLoad(const QString& fileName, LoadParameters& parameters, CC_FILE_ERROR& result)
+{
+	laszip_POINTER laszipReader{nullptr};
+	laszip_header* laszipHeader{nullptr};
+
+	if (OpenLasReader(fileName, laszipReader, laszipHeader) != CC_FERR_NO_ERROR)
+	{
+		// the error will be reported by the loading thread
+		result = CC_FERR_NO_ERROR;
+		return true;
+	}
+
+	std::unique_ptr<copc::CopcLoader> copcLoader = CreateCopcLoader(laszipHeader, fileName);
+
+	result = showOpenDialog(laszipHeader, copcLoader.get(), parameters);
+	if (result != CC_FERR_NO_ERROR)
+	{
+		CloseLasReader(laszipReader);
+		return false;
+	}
+
+	// the file is tiled right away (there's nothing to load)
 	if (m_openDialog.action() == LasOpenDialog::Action::Tile)
 	{
-		return TileLasReader(laszipReader, fileName, m_openDialog.tilingOptions());
+		result = TileLasReader(laszipReader, fileName, m_openDialog.tilingOptions());
+		return false;
+	}
+
+	CloseLasReader(laszipReader);
+
+	QMutexLocker locker(&m_loadingOptionsMutex);
+	m_preparedLoadingOptions[fileName] = m_lastLoadingOptions;
+
+	return true;
+}
+
+CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
+                                    ccHObject&      container,
+                                    LoadParameters& parameters)
+{
+	laszip_POINTER laszipReader{nullptr};
+	laszip_header* laszipHeader{nullptr};
+	laszip_CHAR*   errorMsg{nullptr};
+
+	CC_FILE_ERROR openResult = OpenLasReader(fileName, laszipReader, laszipHeader);
+	if (openResult != CC_FERR_NO_ERROR)
+	{
+		return openResult;
 	}
 
+	laszip_U64 pointCount = TrueNumberOfPoints(laszipHeader);
+
+	if (pointCount >= std::numeric_limits<unsigned>::max())
+	{
+		ccLog::Error("[LAS] Files with more that %u points are not supported", std::numeric_limits<unsigned>::max());
+		CloseLasReader(laszipReader);
+		return CC_FERR_NOT_IMPLEMENTED;
+	}
+
+	// intervalsToRead is initialized to only one interval
+	// from 0 to the last point of the LAS file
+	LasDetails::ChunkInterval                                      fullInterval(0, pointCount);
+	std::vector<std::reference_wrapper<LasDetails::ChunkInterval>> chunksToRead;
+	chunksToRead.emplace_back(fullInterval);
+
+	std::unique_ptr<copc::CopcLoader> copcLoader = CreateCopcLoader(laszipHeader, fileName);
+
+	LasLoadingOptions loadingOptions;
+	if (parameters.loadingTask)
+	{
+		// the dialog can't be used by a background thread (it has been shown by prepareConcurrentLoad, if necessary)
+		loadingOptions = takeLoadingOptions(fileName);
+	}
+	else
+	{
+		CC_FILE_ERROR dialogResult = showOpenDialog(laszipHeader, copcLoader.get(), parameters);
+		if (dialogResult != CC_FERR_NO_ERROR)
+		{
+			CloseLasReader(laszipReader);
+			return dialogResult;
+		}
+
+		// Tiling takes precedence over COPC
+		if (m_openDialog.action() == LasOpenDialog::Action::Tile)
+		{
+			return TileLasReader(laszipReader, fileName, m_openDialog.tilingOptions());
+		}
+
+		loadingOptions = m_openDialog.loadingOptions();
+	}
+
+	std::vector<LasScalarField> availableScalarFields = LasScalarField::ForPointFormat(laszipHeader->point_data_format);
+
+	std::vector<LasExtraScalarField> availableExtraScalarFields = LasExtraScalarField::ParseExtraScalarFields(*laszipHeader);
+
 	// Update chunksToReads according to the COPCLoader if needed
 	if (copcLoader)
 	{
-		const uint32_t copcUserDefinedMaxLevel = m_openDialog.copcMaxLevel();
+		const uint32_t copcUserDefinedMaxLevel = loadingOptions.copcMaxLevel;
 		if (copcUserDefinedMaxLevel < static_cast<uint32_t>(copcLoader->maxLevel()))
 		{
 			copcLoader->setMaxLevelConstraint(copcUserDefinedMaxLevel);
 		}
 
-		if (m_openDialog.hasUsableExtent())
+		if (loadingOptions.hasUsableCopcExtent)
 		{
-			const auto clippingExtent = m_openDialog.copcExtent();
+			const auto clippingExtent = loadingOptions.copcExtent;
 			if (clippingExtent.isValid())
 			{
 				copcLoader->setClippingBoxConstraint(clippingExtent);
@@ -244,21 +354,19 @@ CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
 		copcLoader->getChunkIntervalsSet(chunksToRead, pointCount);
 	}
 
-	std::array<LasExtraScalarField, 3> extraScalarFieldsToLoadAsNormals = m_openDialog.getExtraFieldsToBeLoadedAsNormals(availableExtraScalarFields);
+	std::array<LasExtraScalarField, 3> extraScalarFieldsToLoadAsNormals = loadingOptions.getExtraFieldsToBeLoadedAsNormals(availableExtraScalarFields);
 	bool                               haveToLoadNormals                = std::any_of(extraScalarFieldsToLoadAsNormals.begin(),
                                          extraScalarFieldsToLoadAsNormals.end(),
                                          [](const LasExtraScalarField& e)
                                          {
                                              return e.type != LasExtraScalarField::DataType::Undocumented;
                                          });
-	m_openDialog.filterOutNotChecked(availableScalarFields, availableExtraScalarFields);
+	loadingOptions.filterOutNotChecked(availableScalarFields, availableExtraScalarFields);
 
 	auto pointCloud = std::make_unique<ccPointCloud>(QFileInfo(fileName).fileName());
 	if (!pointCloud->reserve(pointCount))
 	{
-		laszip_close_reader(laszipReader);
-		laszip_clean(laszipReader);
-		laszip_destroy(laszipReader);
+		CloseLasReader(laszipReader);
 		return CC_FERR_NOT_ENOUGH_MEMORY;
 	}
 
@@ -266,9 +374,7 @@ CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
 	{
 		if (!pointCloud->reserveTheNormsTable())
 		{
-			laszip_close_reader(laszipReader);
-			laszip_clean(laszipReader);
-			laszip_destroy(laszipReader);
+			CloseLasReader(laszipReader);
 			return CC_FERR_NOT_ENOUGH_MEMORY;
 		}
 	}
@@ -282,9 +388,7 @@ CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
 	{
 		laszip_get_error(laszipHeader, &errorMsg);
 		ccLog::Warning("[LAS] laszip error: '%s'", errorMsg);
-		laszip_close_reader(laszipReader);
-		laszip_clean(laszipReader);
-		laszip_destroy(laszipReader);
+		CloseLasReader(laszipReader);
 		return CC_FERR_THIRD_PARTY_LIB_FAILURE;
 	}
 
@@ -292,9 +396,9 @@ CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
 	                            availableExtraScalarFields,
 	                            *pointCloud);
 
-	loader.setIgnoreFieldsWithDefaultValues(m_openDialog.shouldIgnoreFieldsWithDefaultValues());
-	loader.setForce8bitRgbMode(m_openDialog.shouldForce8bitColors());
-	loader.setDecomposeClassification(m_openDialog.shouldDecomposeClassification());
+	loader.setIgnoreFieldsWithDefaultValues(loadingOptions.ignoreFieldsWithDefaultValues);
+	loader.setForce8bitRgbMode(loadingOptions.force8bitColors);
+	loader.setDecomposeClassification(loadingOptions.decomposeClassification);
 	std::unique_ptr<LasWaveformLoader> waveformLoader{nullptr};
 	if (LasDetails::HasWaveform(laszipHeader->point_data_format))
 	{
@@ -306,14 +410,23 @@ CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
 	QElapsedTimer timer;
 	timer.start();
 
-	ccProgressDialog progressDialog(true, parameters.parentWidget);
-	progressDialog.setMethodTitle("Loading LAS points");
-	progressDialog.setInfo("Loading points");
-	QScopedPointer<CCCoreLib::NormalizedProgress> normProgress;
+	QScopedPointer<ccProgressDialog> progressDialog(nullptr);
 	if (parameters.parentWidget)
 	{
-		normProgress.reset(new CCCoreLib::NormalizedProgress(&progressDialog, pointCount));
-		progressDialog.start();
+		progressDialog.reset(new ccProgressDialog(true, parameters.parentWidget));
+		progressDialog->setMethodTitle("Loading LAS points");
+		progressDialog->setInfo("Loading points");
+	}
+	// or asynchronous loading task (no dialog in this case)
+	CCCoreLib::GenericProgressCallback* progressCb = progressDialog ? static_cast<CCCoreLib::GenericProgressCallback*>(progressDialog.data()) : parameters.loadingTask;
+	QScopedPointer<CCCoreLib::NormalizedProgress> normProgress;
+	if (progressCb)
+	{
+		normProgress.reset(new CCCoreLib::NormalizedProgress(progressCb, pointCount));
+	}
+	if (progressDialog)
+	{
+		progressDialog->start();
 	}
 
 	CC_FILE_ERROR error{CC_FERR_NO_ERROR};
@@ -599,9 +712,7 @@ CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
 		ccLog::Warning("[LAS] laszip error: '%s'", errorMsg);
 	}
 
-	laszip_close_reader(laszipReader);
-	laszip_clean(laszipReader);
-	laszip_destroy(laszipReader);
+	CloseLasReader(laszipReader);
 
 	timer.elapsed();
 	qint64  elapsed = timer.elapsed();
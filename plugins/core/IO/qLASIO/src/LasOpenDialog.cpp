@@ -37,24 +37,6 @@ static QListWidgetItem* CreateItem(const char* name, bool checked = true)
 	return item;
 }
 
-static bool IsCheckedIn(const QString& name, const QListWidget* list)
-{
-	if (!list)
-	{
-		assert(false);
-		return false;
-	}
-
-	for (int i = 0; i < list->count(); ++i)
-	{
-		if (list->item(i)->text() == name)
-		{
-			return list->item(i)->checkState() == Qt::Checked;
-		}
-	}
-	return false;
-}
-
 // TODO use std::remove_if
 template <typename T, typename Pred>
 static void RemoveFalse(std::vector<T>& vec, Pred predicate)
@@ -293,46 +275,37 @@ void LasOpenDialog::checkExtentConsistency(double value)
 	copcLabelWarningExtent->setVisible(!m_validExtent);
 }
 
-void LasOpenDialog::filterOutNotChecked(std::vector<LasScalarField>&      scalarFields,
-                                        std::vector<LasExtraScalarField>& extraScalarFields)
+void LasLoadingOptions::filterOutNotChecked(std::vector<LasScalarField>&      scalarFields,
+                                            std::vector<LasExtraScalarField>& extraScalarFields) const
 {
-	const auto isFieldSelected = [this](const auto& field)
-	{ return isChecked(field); };
-
-	RemoveFalse(scalarFields, isFieldSelected);
-	RemoveFalse(extraScalarFields, isFieldSelected);
+	RemoveFalse(scalarFields, [this](const LasScalarField& field)
+	            { return !uncheckedScalarFields.contains(field.name()); });
+	RemoveFalse(extraScalarFields, [this](const LasExtraScalarField& field)
+	            { return !uncheckedExtraScalarFields.contains(field.name); });
 }
 
-std::array<LasExtraScalarField, 3> LasOpenDialog::getExtraFieldsToBeLoadedAsNormals(const std::vector<LasExtraScalarField>& extraScalarFields) const
+std::array<LasExtraScalarField, 3> LasLoadingOptions::getExtraFieldsToBeLoadedAsNormals(const std::vector<LasExtraScalarField>& extraScalarFields) const
 {
 	std::array<LasExtraScalarField, 3> array;
 
-	if (!extraScalarFields.empty())
+	for (size_t i = 0; i < 3; ++i)
 	{
-		const std::array<const QComboBox*, 3> boxes{xNormalComboBox, yNormalComboBox, zNormalComboBox};
+		if (normalFields[i].isEmpty())
+		{
+			continue;
+		}
 
-		for (size_t i = 0; i < 3; ++i)
+		const std::string name = normalFields[i].toStdString();
+		const auto        it   = std::find_if(
+            extraScalarFields.begin(),
+            extraScalarFields.end(),
+            [&name](const LasExtraScalarField& e)
+            { return e.name == name; });
+
+		// the options may have been chosen for another file
+		if (it != extraScalarFields.end())
 		{
-			const QComboBox* comboBox = boxes[i];
-			if (comboBox && comboBox->currentIndex() > 0)
-			{
-				const std::string name = comboBox->currentText().toStdString();
-				const auto        it   = std::find_if(
-                    extraScalarFields.begin(),
-                    extraScalarFields.end(),
-                    [&name](const LasExtraScalarField& e)
-                    { return e.name == name; });
-
-				// safeguard
-				if (it != extraScalarFields.end())
-				{
-					array[i] = *it;
-				}
-				else
-				{
-					assert(false);
-				}
-			}
+			array[i] = *it;
 		}
 	}
 
@@ -354,14 +327,48 @@ bool LasOpenDialog::shouldDecomposeClassification() const
 	return decomposeClassificationCheckBox->isChecked();
 }
 
-bool LasOpenDialog::isChecked(const LasExtraScalarField& lasExtraScalarField) const
+LasLoadingOptions LasOpenDialog::loadingOptions() const
 {
-	return IsCheckedIn(lasExtraScalarField.name, availableExtraScalarFields);
-}
+	LasLoadingOptions options;
 
-bool LasOpenDialog::isChecked(const LasScalarField& lasScalarField) const
-{
-	return IsCheckedIn(lasScalarField.name(), availableScalarFields);
+	for (int i = 0; i < availableScalarFields->count(); ++i)
+	{
+		const QListWidgetItem* item = availableScalarFields->item(i);
+		if (item->checkState() != Qt::Checked)
+		{
+			options.uncheckedScalarFields.insert(item->text());
+		}
+	}
+	for (int i = 0; i < availableExtraScalarFields->count(); ++i)
+	{
+		const QListWidgetItem* item = availableExtraScalarFields->item(i);
+		if (item->checkState() != Qt::Checked)
+		{
+			options.uncheckedExtraScalarFields.insert(item->text());
+		}
+	}
+
+	if (availableExtraScalarFields->count() != 0)
+	{
+		const std::array<const QComboBox*, 3> boxes{xNormalComboBox, yNormalComboBox, zNormalComboBox};
+		for (size_t i = 0; i < 3; ++i)
+		{
+			if (boxes[i]->currentIndex() > 0)
+			{
+				options.normalFields[i] = boxes[i]->currentText();
+			}
+		}
+	}
+
+	options.ignoreFieldsWithDefaultValues = shouldIgnoreFieldsWithDefaultValues();
+	options.force8bitColors               = shouldForce8bitColors();
+	options.decomposeClassification       = shouldDecomposeClassification();
+
+	options.copcMaxLevel        = copcMaxLevel();
+	options.hasUsableCopcExtent = hasUsableExtent();
+	options.copcExtent          = copcExtent();
+
+	return options;
 }
 
 bool LasOpenDialog::shouldSkipDialog() const
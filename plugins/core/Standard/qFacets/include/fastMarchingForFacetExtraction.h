@@ -44,6 +44,24 @@ public:
 									CCCoreLib::GenericProgressCallback* progressCb = nullptr,
 									CCCoreLib::DgmOctree* _theOctree = nullptr);
 
+	//! Static entry point (parallel version)
+	/** The octree cells are partitioned in cubic blocks that are processed
+		concurrently (the facets can't grow across the block borders). The
+		facets touching each other across a block border are then merged if
+		the resulting facet still satisfies the max error criterion.
+		\param blockSize block edge (in octree cells at the given level) or 0 for automatic sizing
+		\param maxThreadCount max number of threads (0 = ideal thread count)
+	**/
+	static int ExtractPlanarFacetsParallel(	ccPointCloud* theCloud,
+											unsigned char octreeLevel,
+											ScalarType maxError,
+											CCCoreLib::DistanceComputationTools::ERROR_MEASURES errorMeasure,
+											bool useRetroProjectionError = true,
+											unsigned blockSize = 0,
+											int maxThreadCount = 0,
+											CCCoreLib::GenericProgressCallback* progressCb = nullptr,
+											CCCoreLib::DgmOctree* _theOctree = nullptr);
+
 	//! Default constructor
 	FastMarchingForFacetExtraction();
 
@@ -69,6 +87,40 @@ public:
 				bool useRetroProjectionError,
 				CCCoreLib::GenericProgressCallback* progressCb = nullptr);
 
+	//! Initializes the grid with a block of octree cells
+	/** Same as init, but the grid only covers a cubic block of cells (starting at 'blockMin').
+		The seed cell positions are then relative to the block origin.
+		\param theOctree an octree, associated to a point cloud
+		\param gridLevel the level of subdivision
+		\param blockMin position of the block's first cell (in the octree)
+		\param blockSize block edge (in cells)
+		\param cellCodes codes of the (non empty) cells of the block (truncated)
+		\param cellPos positions of the same cells (in the octree)
+		\param maxError maximum error allowed by 'propagated' facet
+		\param errorMeasure error measure
+		\param useRetroProjectionError whether to use retro-projection error in propagation
+		\return a negative value if something went wrong
+	**/
+	int initBlock(	CCCoreLib::DgmOctree* theOctree,
+					unsigned char gridLevel,
+					const Tuple3i& blockMin,
+					unsigned blockSize,
+					const CCCoreLib::DgmOctree::cellCodesContainer& cellCodes,
+					const std::vector<Tuple3i>& cellPos,
+					ScalarType maxError,
+					CCCoreLib::DistanceComputationTools::ERROR_MEASURES errorMeasure,
+					bool useRetroProjectionError);
+
+	//! Returns whether a cell is still available (i.e. not already part of a facet)
+	bool hasCell(const Tuple3i& pos) const;
+
+	//! Assigns a label to the points of the current facet
+	/** Same as updateFlagsTable, but without touching the cloud (so that
+		several blocks can be processed concurrently).
+		\return the number of newly labelled points
+	**/
+	unsigned labelCurrentFacet(std::vector<unsigned>& labels, unsigned label);
+
 	//! Updates a list of point flags, indicating the points alreay processed
 	/** \return the number of newly flagged points
 	**/
@@ -33,6 +33,7 @@ public:
 		\param overlapCoef maximum relative distance between two sets to accept fusion (1 = no distance, < 1 = overlap, > 1 = gap)
 		\param closestFirst
 		\param progressCb for progress notifications (optional)
+		\param maxThreadCount max number of threads (0 = ideal thread count)
 	**/
 	static bool FuseCells(	ccKdTree* kdTree,
 							double maxError,
@@ -40,6 +41,7 @@ public:
 							double maxAngle_deg,
 							PointCoordinateType overlapCoef = 1,
 							bool closestFirst = true,
-							CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+							CCCoreLib::GenericProgressCallback* progressCb = nullptr,
+							int maxThreadCount = 0);
 
 };
@@ -75,6 +75,8 @@ class qFacets : public QObject, public ccStdPluginInterface
 		// ALGO_FAST_MARCHING only
 		unsigned octreeLevel;
 		bool     useRetroProjectionError;
+		bool     useParallelBlocks; // process the octree by blocks (concurrently)
+		unsigned blockSize;         // block edge (in octree cells) - 0 = automatic
 		// both ALGO_KD_TREE and ALGO_FAST_MARCHING
 		double                                              errorMaxPerFacet;
 		double                                              maxEdgeLength;
@@ -105,6 +107,8 @@ class qFacets : public QObject, public ccStdPluginInterface
 		    , kdTreeFusionMaxRelativeDistance(1.0f)
 		    , octreeLevel(8)
 		    , useRetroProjectionError(false)
+		    , useParallelBlocks(false)
+		    , blockSize(0)
 		    , errorMaxPerFacet(0.2f)
 		    , minPointsPerFacet(10)
 		    , maxEdgeLength(1.0f)
@@ -39,6 +39,8 @@ constexpr char KD_TREE_FUSION_MAX_RELATIVE_DISTANCE[] = "-KD_TREE_FUSION_MAX_REL
 // ALGO_FAST_MARCHING only
 constexpr char OCTREE_LEVEL[]               = "-OCTREE_LEVEL";
 constexpr char USE_RETRO_PROJECTION_ERROR[] = "-USE_RETRO_PROJECTION_ERROR";
+constexpr char USE_PARALLEL_BLOCKS[]        = "-USE_PARALLEL_BLOCKS";
+constexpr char BLOCK_SIZE[]                 = "-BLOCK_SIZE";
 // both ALGO_KD_TREE and ALGO_FAST_MARCHING
 constexpr char ERROR_MAX_PER_FACET[]  = "-ERROR_MAX_PER_FACET";
 constexpr char MAX_EDGE_LENGTH[]      = "-MAX_EDGE_LENGTH";
@@ -119,7 +121,7 @@ struct CommandFacets : public ccCommandLineInterface::Command
 		}
 
 		qFacets::FacetsParams params;
-		QStringList           paramNames        = QStringList() << EXTRACT_FACETS << ALGO << KD_TREE_FUSION_MAX_ANGLE_DEG << KD_TREE_FUSION_MAX_RELATIVE_DISTANCE << OCTREE_LEVEL << USE_RETRO_PROJECTION_ERROR << ERROR_MAX_PER_FACET << MIN_POINTS_PER_FACET << MAX_EDGE_LENGTH << ERROR_MEASURE << CLASSIFY_FACETS_BY_ANGLE << CLASSIF_ANGLE_STEP << CLASSIF_MAX_DIST << EXPORT_FACETS << SHAPE_FILENAME << USE_NATIVE_ORIENTATION << USE_GLOBAL_ORIENTATION << USE_CUSTOM_ORIENTATION << EXPORT_FACETS_INFO << CSV_FILENAME << COORDS_IN_CSV;
+		QStringList           paramNames        = QStringList() << EXTRACT_FACETS << ALGO << KD_TREE_FUSION_MAX_ANGLE_DEG << KD_TREE_FUSION_MAX_RELATIVE_DISTANCE << OCTREE_LEVEL << USE_RETRO_PROJECTION_ERROR << USE_PARALLEL_BLOCKS << BLOCK_SIZE << ERROR_MAX_PER_FACET << MIN_POINTS_PER_FACET << MAX_EDGE_LENGTH << ERROR_MEASURE << CLASSIFY_FACETS_BY_ANGLE << CLASSIF_ANGLE_STEP << CLASSIF_MAX_DIST << EXPORT_FACETS << SHAPE_FILENAME << USE_NATIVE_ORIENTATION << USE_GLOBAL_ORIENTATION << USE_CUSTOM_ORIENTATION << EXPORT_FACETS_INFO << CSV_FILENAME << COORDS_IN_CSV;
 		QStringList           algoNames         = QStringList() << ALGO_FAST_MARCHING << ALGO_KD_TREE;
 		QStringList           errorMeasureNames = QStringList() << RMS << MAX_DIST_68_PERCENT << MAX_DIST_95_PERCENT << MAX_DIST_99_PERCENT << MAX_DIST;
 
@@ -214,6 +216,27 @@ struct CommandFacets : public ccCommandLineInterface::Command
 				{
 					params.useRetroProjectionError = true;
 				}
+				// USE_PARALLEL_BLOCKS
+				else if (param == USE_PARALLEL_BLOCKS)
+				{
+					params.useParallelBlocks = true;
+				}
+				// BLOCK_SIZE
+				else if (param == BLOCK_SIZE)
+				{
+					if (cmd.arguments().empty())
+					{
+						return cmd.error(QObject::tr("Missing parameter: number after \"-%1 %2\"").arg(COMMAND_FACETS, BLOCK_SIZE));
+					}
+					bool ok;
+					int  val = cmd.arguments().takeFirst().toInt(&ok);
+					if (!ok || val < 0)
+					{
+						return cmd.error("Invalid number for -BLOCK_SIZE!");
+					}
+					cmd.print(QObject::tr("\t-BLOCK_SIZE : %1").arg(val));
+					params.blockSize = static_cast<unsigned>(val);
+				}
 				// ERROR_MAX_PER_FACET
 				else if (param == ERROR_MAX_PER_FACET)
 				{
@@ -470,6 +493,11 @@ struct CommandFacets : public ccCommandLineInterface::Command
 				cmd.print(QObject::tr("\t\t-ALGO ALGO_FAST_MARCHING"));
 				cmd.print(QObject::tr("\t\t\t-OCTREE_LEVEL : %1").arg(params.octreeLevel));
 				cmd.print(QObject::tr("\t\t\t-USE_RETRO_PROJECTION_ERROR : %1").arg(params.useRetroProjectionError));
+				cmd.print(QObject::tr("\t\t\t-USE_PARALLEL_BLOCKS : %1").arg(params.useParallelBlocks));
+				if (params.useParallelBlocks)
+				{
+					cmd.print(QObject::tr("\t\t\t-BLOCK_SIZE : %1").arg(params.blockSize));
+				}
 			}
 
 			if (params.errorMeasure == CCCoreLib::DistanceComputationTools::RMS)
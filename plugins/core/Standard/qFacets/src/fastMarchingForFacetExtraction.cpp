@@ -27,6 +27,16 @@
 
 //Qt
 #include <QApplication>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+//System
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <set>
+#include <unordered_map>
 
 FastMarchingForFacetExtraction::FastMarchingForFacetExtraction()
 	: CCCoreLib::FastMarching()
@@ -366,6 +376,92 @@ unsigned FastMarchingForFacetExtraction::updateFlagsTable(	ccGenericPointCloud*
 	return pointCount;
 }
 
+int FastMarchingForFacetExtraction::initBlock(	CCCoreLib::DgmOctree* theOctree,
+												unsigned char level,
+												const Tuple3i& blockMin,
+												unsigned blockSize,
+												const CCCoreLib::DgmOctree::cellCodesContainer& cellCodes,
+												const std::vector<Tuple3i>& cellPos,
+												ScalarType maxError,
+												CCCoreLib::DistanceComputationTools::ERROR_MEASURES errorMeasure,
+												bool useRetroProjectionError)
+{
+	assert(theOctree && cellCodes.size() == cellPos.size());
+
+	m_maxError = maxError;
+	m_errorMeasure = errorMeasure;
+	m_useRetroProjectionError = useRetroProjectionError;
+
+	unsigned gridSize[3] = { blockSize, blockSize, blockSize };
+	int result = initGrid(static_cast<float>(theOctree->getCellSize(level)), gridSize);
+	if (result < 0)
+		return result;
+
+	//the grid is not aligned with the whole octree, but we still need it to access the cells points
+	m_octree = theOctree;
+	m_gridLevel = level;
+
+	CCCoreLib::ReferenceCloud Yk(theOctree->associatedCloud());
+	for (size_t i = 0; i < cellCodes.size(); ++i)
+	{
+		if (!theOctree->getPointsInCell(cellCodes[i], level, &Yk, true))
+			continue;
+
+		CCVector3 N;
+		CCVector3 C;
+		ScalarType error;
+		if (!ComputeCellStats(&Yk, N, C, error, m_errorMeasure))
+		{
+			//an error occurred?!
+			return -10;
+		}
+
+		//convert octree cell pos to (local) FM cell pos index
+		Tuple3i localPos(cellPos[i].x - blockMin.x, cellPos[i].y - blockMin.y, cellPos[i].z - blockMin.z);
+		unsigned gridPos = pos2index(localPos);
+
+		//create corresponding cell
+		PlanarCell* aCell = new PlanarCell;
+		aCell->cellCode = cellCodes[i];
+		aCell->N = N;
+		aCell->C = C;
+		aCell->planarError = error;
+		m_theGrid[gridPos] = aCell;
+	}
+
+	m_initialized = true;
+
+	return 0;
+}
+
+bool FastMarchingForFacetExtraction::hasCell(const Tuple3i& pos) const
+{
+	return m_initialized && m_theGrid[pos2index(pos)] != nullptr;
+}
+
+unsigned FastMarchingForFacetExtraction::labelCurrentFacet(std::vector<unsigned>& labels, unsigned label)
+{
+	if (!m_initialized || !m_currentFacetPoints)
+		return 0;
+
+	unsigned pointCount = m_currentFacetPoints->size();
+	for (unsigned k = 0; k < pointCount; ++k)
+	{
+		labels[m_currentFacetPoints->getPointGlobalIndex(k)] = label;
+	}
+	m_currentFacetPoints->clear(false);
+
+	//we remove the processed cells so as to be sure not to consider them again!
+	for (unsigned index : m_activeCells)
+	{
+		CCCoreLib::FastMarching::Cell* aCell = m_theGrid[index];
+		m_theGrid[index] = nullptr;
+		delete aCell;
+	}
+
+	return pointCount;
+}
+
 bool FastMarchingForFacetExtraction::setSeedCell(const Tuple3i& pos)
 {
 	if (!CCCoreLib::FastMarching::setSeedCell(pos))
@@ -637,3 +733,502 @@ int FastMarchingForFacetExtraction::ExtractPlanarFacets(	ccPointCloud* theCloud,
 
 	return result;
 }
+
+//! Block of octree cells (see ExtractPlanarFacetsParallel)
+struct FacetBlock
+{
+	//! Position of the block's first cell (in the octree)
+	Tuple3i minPos;
+	//! Codes of the block (non empty) cells
+	CCCoreLib::DgmOctree::cellCodesContainer cellCodes;
+	//! Positions of the same cells (in the octree)
+	std::vector<Tuple3i> cellPos;
+	//! Number of facets extracted in this block
+	unsigned facetCount = 0;
+};
+
+//! Facet plane (see ExtractPlanarFacetsParallel)
+struct FacetPlane
+{
+	CCVector3 N;
+	CCVector3 C;
+	ScalarType error = 0;
+};
+
+//! Packs a cell position (up to 21 bits per dimension) in a single key
+static inline uint64_t PackCellPos(const Tuple3i& pos)
+{
+	return static_cast<uint64_t>(pos.x) | (static_cast<uint64_t>(pos.y) << 21) | (static_cast<uint64_t>(pos.z) << 42);
+}
+
+//! Returns the root of a facet (union-find)
+static unsigned FindRootFacet(std::vector<unsigned>& parent, unsigned facet)
+{
+	while (parent[facet] != facet)
+	{
+		parent[facet] = parent[parent[facet]]; //path halving
+		facet = parent[facet];
+	}
+	return facet;
+}
+
+int FastMarchingForFacetExtraction::ExtractPlanarFacetsParallel(	ccPointCloud* theCloud,
+																	unsigned char octreeLevel,
+																	ScalarType maxError,
+																	CCCoreLib::DistanceComputationTools::ERROR_MEASURES errorMeasure,
+																	bool useRetroProjectionError/*=true*/,
+																	unsigned blockSize/*=0*/,
+																	int maxThreadCount/*=0*/,
+																	CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/,
+																	CCCoreLib::DgmOctree* _theOctree/*=nullptr*/)
+{
+	assert(theCloud);
+
+	unsigned numberOfPoints = theCloud->size();
+	if (numberOfPoints == 0)
+		return -1;
+
+	if (!theCloud->getCurrentOutScalarField())
+		return -2;
+
+	if (progressCb)
+	{
+		//just spawn the dialog so that we can see the
+		//octree computation (in case the CPU charge prevents
+		//the dialog from being shown)
+		progressCb->start();
+		QApplication::processEvents();
+	}
+
+	//we compute the octree if none is provided
+	CCCoreLib::DgmOctree* theOctree = _theOctree;
+	QScopedPointer<CCCoreLib::DgmOctree> tempOctree;
+	if (!theOctree)
+	{
+		theOctree = new CCCoreLib::DgmOctree(theCloud);
+		tempOctree.reset(theOctree);
+		if (theOctree->build(progressCb) < 1)
+		{
+			return -3;
+		}
+	}
+
+	if (!theCloud->enableScalarField())
+	{
+		ccLog::Warning("[FastMarchingForFacetExtraction] Couldn't enable scalar field! Not enough memory?");
+		return -4;
+	}
+
+	int threadCount = (maxThreadCount > 0 ? maxThreadCount : QThread::idealThreadCount());
+	if (blockSize == 0)
+	{
+		//we aim at a few blocks per thread (to balance the load) while keeping them
+		//big enough so that only a small portion of the facets cross their borders
+		const int* minFillIndexes = theOctree->getMinFillIndexes(octreeLevel);
+		const int* maxFillIndexes = theOctree->getMaxFillIndexes(octreeLevel);
+		double filledVolume = 1.0;
+		for (unsigned d = 0; d < 3; ++d)
+		{
+			filledVolume *= (maxFillIndexes[d] - minFillIndexes[d] + 1);
+		}
+		blockSize = static_cast<unsigned>(std::ceil(std::cbrt(filledVolume / (8.0 * std::max(1, threadCount)))));
+		blockSize = std::max(8u, std::min(64u, blockSize));
+	}
+	const int bs = static_cast<int>(blockSize);
+
+	//facet index of each point (0 = none)
+	std::vector<unsigned> labels;
+	//octree cells grouped by block
+	std::vector<FacetBlock> blocks;
+	try
+	{
+		labels.resize(numberOfPoints, 0);
+
+		CCCoreLib::DgmOctree::cellCodesContainer cellCodes;
+		if (!theOctree->getCellCodes(octreeLevel, cellCodes, true))
+		{
+			return -5;
+		}
+
+		std::unordered_map<uint64_t, size_t> blockIndexes;
+		for (CCCoreLib::DgmOctree::CellCode cellCode : cellCodes)
+		{
+			Tuple3i cellPos;
+			theOctree->getCellPos(cellCode, octreeLevel, cellPos, true);
+
+			Tuple3i blockPos(cellPos.x / bs, cellPos.y / bs, cellPos.z / bs);
+			//the blocks are created in the order of the cell codes (so that the result is reproducible)
+			auto it = blockIndexes.find(PackCellPos(blockPos));
+			size_t blockIndex = 0;
+			if (it == blockIndexes.end())
+			{
+				blockIndex = blocks.size();
+				blockIndexes[PackCellPos(blockPos)] = blockIndex;
+				blocks.emplace_back();
+				blocks.back().minPos = Tuple3i(blockPos.x * bs, blockPos.y * bs, blockPos.z * bs);
+			}
+			else
+			{
+				blockIndex = it->second;
+			}
+
+			blocks[blockIndex].cellCodes.push_back(cellCode);
+			blocks[blockIndex].cellPos.push_back(cellPos);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[FastMarchingForFacetExtraction] Not enough memory!");
+		return -5;
+	}
+
+	//progress notification
+	CCCoreLib::NormalizedProgress nProgress(progressCb, static_cast<unsigned>(blocks.size()));
+	if (progressCb)
+	{
+		progressCb->update(0);
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Facets extraction");
+			progressCb->setInfo(qPrintable(QString("Octree level: %1\nPoints: %2\nBlocks: %3 (%4 cells wide)").arg(octreeLevel).arg(numberOfPoints).arg(blocks.size()).arg(blockSize)));
+		}
+		progressCb->start();
+		QApplication::processEvents();
+	}
+
+	std::atomic<bool> error(false);
+	std::atomic<bool> canceled(false);
+
+	//each block is processed independently (with its own Fast Marching grid)
+	if (maxThreadCount > 0)
+	{
+		QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
+	}
+	QtConcurrent::blockingMap(blocks, [&](FacetBlock& block)
+	{
+		if (error || canceled)
+			return;
+
+		try
+		{
+			FastMarchingForFacetExtraction fm;
+			if (fm.initBlock(	theOctree,
+								octreeLevel,
+								block.minPos,
+								blockSize,
+								block.cellCodes,
+								block.cellPos,
+								maxError,
+								errorMeasure,
+								useRetroProjectionError) < 0)
+			{
+				error = true;
+				return;
+			}
+
+			for (const Tuple3i& cellPos : block.cellPos)
+			{
+				Tuple3i localPos(cellPos.x - block.minPos.x, cellPos.y - block.minPos.y, cellPos.z - block.minPos.z);
+
+				//already part of a facet?
+				if (!fm.hasCell(localPos))
+					continue;
+
+				if (!fm.setSeedCell(localPos) || fm.propagate() < 0)
+				{
+					error = true;
+					return;
+				}
+
+				fm.labelCurrentFacet(labels, ++block.facetCount);
+				fm.cleanLastPropagation();
+
+				if (canceled)
+					return;
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			error = true;
+			return;
+		}
+
+		if (progressCb && !nProgress.oneStep())
+		{
+			canceled = true;
+		}
+	});
+
+	if (error || canceled)
+	{
+		if (progressCb)
+		{
+			progressCb->stop();
+		}
+		if (error)
+		{
+			ccLog::Warning("[FastMarchingForFacetExtraction] An error occurred during the facets extraction (not enough memory?)");
+		}
+		return -7;
+	}
+
+	//convert the local facet indexes to global ones (in the blocks order, so
+	//that the result doesn't depend on the threads scheduling) and get the
+	//facet index of the cells lying on the blocks borders
+	std::unordered_map<uint64_t, unsigned> borderCellFacets;
+	unsigned facetCount = 0;
+	try
+	{
+		CCCoreLib::ReferenceCloud Yk(theOctree->associatedCloud());
+		for (const FacetBlock& block : blocks)
+		{
+			for (size_t i = 0; i < block.cellCodes.size(); ++i)
+			{
+				if (!theOctree->getPointsInCell(block.cellCodes[i], octreeLevel, &Yk, true) || Yk.size() == 0)
+					continue;
+
+				for (unsigned k = 0; k < Yk.size(); ++k)
+				{
+					unsigned& label = labels[Yk.getPointGlobalIndex(k)];
+					if (label != 0)
+					{
+						label += facetCount;
+					}
+				}
+
+				const Tuple3i& cellPos = block.cellPos[i];
+				for (unsigned d = 0; d < 3; ++d)
+				{
+					int localPos = cellPos.u[d] - block.minPos.u[d];
+					if (localPos == 0 || localPos + 1 == bs)
+					{
+						//a cell is never split between facets
+						borderCellFacets[PackCellPos(cellPos)] = labels[Yk.getPointGlobalIndex(0)];
+						break;
+					}
+				}
+			}
+
+			facetCount += block.facetCount;
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[FastMarchingForFacetExtraction] Not enough memory!");
+		if (progressCb)
+		{
+			progressCb->stop();
+		}
+		return -5;
+	}
+
+	//look for the facets touching each other across a block border
+	std::set< std::pair<unsigned, unsigned> > adjacentFacets; //sorted, for a reproducible merging order
+	std::map<unsigned, CCCoreLib::DgmOctree::cellCodesContainer> facetCells; //only for the facets to be tested
+	std::vector<unsigned> parent;
+	try
+	{
+		for (const auto& borderCell : borderCellFacets)
+		{
+			if (borderCell.second == 0)
+				continue;
+
+			Tuple3i cellPos(static_cast<int>(borderCell.first & 0x1FFFFF),
+							static_cast<int>((borderCell.first >> 21) & 0x1FFFFF),
+							static_cast<int>((borderCell.first >> 42) & 0x1FFFFF));
+
+			for (unsigned d = 0; d < 3; ++d)
+			{
+				Tuple3i neighbourPos = cellPos;
+				++neighbourPos.u[d];
+				if (neighbourPos.u[d] % bs != 0)
+				{
+					//same block (already handled by the Fast Marching)
+					continue;
+				}
+
+				auto it = borderCellFacets.find(PackCellPos(neighbourPos));
+				if (it != borderCellFacets.end() && it->second != 0 && it->second != borderCell.second)
+				{
+					adjacentFacets.insert({ std::min(borderCell.second, it->second), std::max(borderCell.second, it->second) });
+				}
+			}
+		}
+
+		for (const auto& facets : adjacentFacets)
+		{
+			facetCells[facets.first];
+			facetCells[facets.second];
+		}
+
+		//we need the cells of these facets to test the merging
+		if (!facetCells.empty())
+		{
+			CCCoreLib::ReferenceCloud Yk(theOctree->associatedCloud());
+			for (const FacetBlock& block : blocks)
+			{
+				for (CCCoreLib::DgmOctree::CellCode cellCode : block.cellCodes)
+				{
+					if (!theOctree->getPointsInCell(cellCode, octreeLevel, &Yk, true) || Yk.size() == 0)
+						continue;
+
+					auto it = facetCells.find(labels[Yk.getPointGlobalIndex(0)]);
+					if (it != facetCells.end())
+					{
+						it->second.push_back(cellCode);
+					}
+				}
+			}
+		}
+
+		parent.resize(static_cast<size_t>(facetCount) + 1);
+		for (unsigned i = 0; i <= facetCount; ++i)
+		{
+			parent[i] = i;
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[FastMarchingForFacetExtraction] Not enough memory!");
+		if (progressCb)
+		{
+			progressCb->stop();
+		}
+		return -5;
+	}
+
+	//merge the compatible facets
+	unsigned mergeCount = 0;
+	if (!adjacentFacets.empty())
+	{
+		CCCoreLib::NormalizedProgress nMergeProgress(progressCb, static_cast<unsigned>(adjacentFacets.size()));
+		if (progressCb)
+		{
+			if (progressCb->textCanBeEdited())
+			{
+				progressCb->setInfo(qPrintable(QString("Merging facets across blocks borders\nCandidates: %1").arg(adjacentFacets.size())));
+			}
+			progressCb->update(0);
+		}
+
+		CCCoreLib::ReferenceCloud facetPoints(theOctree->associatedCloud());
+		CCCoreLib::ReferenceCloud Yk(theOctree->associatedCloud());
+		auto addFacetPoints = [&](unsigned facet) -> bool
+		{
+			for (CCCoreLib::DgmOctree::CellCode cellCode : facetCells[facet])
+			{
+				if (!theOctree->getPointsInCell(cellCode, octreeLevel, &Yk, true) || !facetPoints.add(Yk))
+					return false;
+			}
+			return true;
+		};
+
+		std::map<unsigned, FacetPlane> facetPlanes;
+		auto getFacetPlane = [&](unsigned facet) -> const FacetPlane&
+		{
+			auto it = facetPlanes.find(facet);
+			if (it == facetPlanes.end())
+			{
+				FacetPlane plane;
+				facetPoints.clear(false);
+				if (!addFacetPoints(facet) || !ComputeCellStats(&facetPoints, plane.N, plane.C, plane.error, errorMeasure))
+				{
+					plane.error = -1;
+				}
+				it = facetPlanes.insert({ facet, plane }).first;
+			}
+			return it->second;
+		};
+
+		for (const auto& facets : adjacentFacets)
+		{
+			unsigned rootA = FindRootFacet(parent, facets.first);
+			unsigned rootB = FindRootFacet(parent, facets.second);
+			if (rootA != rootB)
+			{
+				FacetPlane planeA = getFacetPlane(rootA);
+				const FacetPlane& planeB = getFacetPlane(rootB);
+
+				//quick test: both facets should be (roughly) coplanar
+				bool compatible = (planeA.error >= 0 && planeB.error >= 0);
+				if (compatible && planeA.N.norm2() != 0 && planeB.N.norm2() != 0)
+				{
+					compatible =	std::abs((planeB.C - planeA.C).dot(planeA.N)) <= maxError
+								&&	std::abs((planeA.C - planeB.C).dot(planeB.N)) <= maxError;
+				}
+
+				//real test: the merged facet should still satisfy the max error criterion
+				if (compatible)
+				{
+					FacetPlane mergedPlane;
+					facetPoints.clear(false);
+					if (	addFacetPoints(rootA)
+						&&	addFacetPoints(rootB)
+						&&	ComputeCellStats(&facetPoints, mergedPlane.N, mergedPlane.C, mergedPlane.error, errorMeasure)
+						&&	mergedPlane.error >= 0
+						&&	mergedPlane.error <= maxError)
+					{
+						//the smallest index is kept as root
+						unsigned newRoot = std::min(rootA, rootB);
+						unsigned oldRoot = std::max(rootA, rootB);
+						parent[oldRoot] = newRoot;
+
+						CCCoreLib::DgmOctree::cellCodesContainer& newRootCells = facetCells[newRoot];
+						CCCoreLib::DgmOctree::cellCodesContainer& oldRootCells = facetCells[oldRoot];
+						newRootCells.insert(newRootCells.end(), oldRootCells.begin(), oldRootCells.end());
+						oldRootCells.clear();
+						oldRootCells.shrink_to_fit();
+
+						facetPlanes[newRoot] = mergedPlane;
+						facetPlanes.erase(oldRoot);
+						++mergeCount;
+					}
+				}
+			}
+
+			if (progressCb && !nMergeProgress.oneStep())
+			{
+				//process cancelled by user
+				progressCb->stop();
+				return -7;
+			}
+		}
+	}
+
+	//final (contiguous) facet indexes
+	std::vector<unsigned> finalIndexes;
+	try
+	{
+		finalIndexes.resize(static_cast<size_t>(facetCount) + 1, 0);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[FastMarchingForFacetExtraction] Not enough memory!");
+		if (progressCb)
+		{
+			progressCb->stop();
+		}
+		return -5;
+	}
+
+	unsigned finalFacetCount = 0;
+	for (unsigned i = 1; i <= facetCount; ++i)
+	{
+		unsigned root = FindRootFacet(parent, i);
+		finalIndexes[i] = (root == i ? ++finalFacetCount : finalIndexes[root]);
+	}
+
+	for (unsigned i = 0; i < numberOfPoints; ++i)
+	{
+		theCloud->setPointScalarValue(i, static_cast<ScalarType>(finalIndexes[labels[i]]));
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	ccLog::Print(QString("[FastMarchingForFacetExtraction] %1 blocks processed, %2 facets (%3 merged across the blocks borders)").arg(blocks.size()).arg(finalFacetCount).arg(mergeCount));
+
+	return 0;
+}
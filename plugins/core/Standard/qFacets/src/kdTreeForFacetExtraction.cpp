@@ -26,30 +26,52 @@
 #include <ccPointCloud.h>
 
 //Qt
-#include <QApplication>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+//System
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 
 static bool DescendingLeafSizeComparison(const ccKdTree::Leaf* a, const ccKdTree::Leaf* b)
 {
-	return a->points->size() > b->points->size();
+	if (a->points->size() != b->points->size())
+		return a->points->size() > b->points->size();
+
+	//same size: we use the first point index so that the order is always the same
+	return (a->points->size() != 0 && a->points->getPointGlobalIndex(0) < b->points->getPointGlobalIndex(0));
 }
 
+//! Leaf properties (computed once)
+struct LeafInfo
+{
+	CCVector3 centroid;
+	PointCoordinateType radius = 0;
+	//! Neighbor leaves (indexes, sorted)
+	std::vector<unsigned> neighbors;
+	//! Fusion group
+	unsigned group = 0;
+};
+
 struct Candidate
 {
+	unsigned leafIndex;
 	ccKdTree::Leaf* leaf;
 	PointCoordinateType dist;
 	PointCoordinateType radius;
 	CCVector3 centroid;
 
-	Candidate() : leaf(nullptr), dist(CCCoreLib::PC_NAN), radius(0) {}
-	Candidate(ccKdTree::Leaf* l) : leaf(l), dist(CCCoreLib::PC_NAN), radius(0)
-	{
-		if (leaf && leaf->points)
-		{
-			CCCoreLib::Neighbourhood N(leaf->points);
-			centroid = *N.getGravityCenter();
-			radius = N.computeLargestRadius();
-		}
-	}
+	Candidate(unsigned index, ccKdTree::Leaf* l, const LeafInfo& info)
+		: leafIndex(index)
+		, leaf(l)
+		, dist(CCCoreLib::PC_NAN)
+		, radius(info.radius)
+		, centroid(info.centroid)
+	{}
 };
 
 static bool CandidateDistAscendingComparison(const Candidate& a, const Candidate& b)
@@ -57,328 +79,532 @@ static bool CandidateDistAscendingComparison(const Candidate& a, const Candidate
 	return a.dist < b.dist;
 }
 
-bool ccKdTreeForFacetExtraction::FuseCells(	ccKdTree* kdTree,
-											double maxError,
-											CCCoreLib::DistanceComputationTools::ERROR_MEASURES errorMeasure,
-											double maxAngle_deg,
-											PointCoordinateType overlapCoef/*=1*/,
-											bool closestFirst/*=true*/,
-											CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+//! Returns the root of a group (union-find)
+static unsigned FindRootGroup(std::vector<unsigned>& parent, unsigned index)
 {
-	if (!kdTree)
-		return false;
-
-	ccGenericPointCloud* associatedGenericCloud = kdTree->associatedGenericCloud();
-	if (!associatedGenericCloud || !associatedGenericCloud->isA(CC_TYPES::POINT_CLOUD) || maxError < 0.0)
-		return false;
-
-	//get leaves
-	std::vector<ccKdTree::Leaf*> leaves;
-	if (!kdTree->getLeaves(leaves) || leaves.empty())
-		return false;
-
-	//progress notification
-	CCCoreLib::NormalizedProgress nProgress(progressCb, static_cast<unsigned>(leaves.size()));
-	if (progressCb)
+	while (parent[index] != index)
 	{
-		progressCb->update(0);
-		if (progressCb->textCanBeEdited())
-		{
-			progressCb->setMethodTitle("Fuse Kd-tree cells");
-			progressCb->setInfo(qPrintable(QString("Cells: %1\nMax error: %2").arg(leaves.size()).arg(maxError)));
-		}
-		progressCb->start();
+		parent[index] = parent[parent[index]]; //path halving
+		index = parent[index];
 	}
+	return index;
+}
 
-	ccPointCloud* pc = static_cast<ccPointCloud*>(associatedGenericCloud);
-
-	//sort cells based on their population size (we start by the biggest ones)
-	ParallelSort(leaves.begin(), leaves.end(), DescendingLeafSizeComparison);
-
-	//set all 'userData' to -1 (i.e. unfused cells)
+//! Fuses the cells of a given group (see ccKdTreeForFacetExtraction::FuseCells)
+/** The leaves 'userData' is set to -1 (unfused), 0 (above the max error)
+	or to the index of the seed leaf + 1.
+**/
+static bool FuseGroup(	const std::vector<unsigned>& group,
+						const std::vector<ccKdTree::Leaf*>& leaves,
+						const std::vector<LeafInfo>& leafInfos,
+						double maxError,
+						CCCoreLib::DistanceComputationTools::ERROR_MEASURES errorMeasure,
+						double minCosNormAngle,
+						PointCoordinateType overlapCoef,
+						bool closestFirst,
+						CCCoreLib::NormalizedProgress* nProgress,
+						std::atomic<bool>& cancelled)
+{
+	//fuse all cells, starting from the biggest ones
+	for (unsigned currentIndex : group)
 	{
-		for (auto& leaf : leaves)
+		ccKdTree::Leaf* currentCell = leaves[currentIndex];
+		if (currentCell->error >= maxError)
+			currentCell->userData = 0; //0 = special group for cells already above the user defined threshold!
+
+		if (nProgress && !nProgress->oneStep()) //process canceled by user
 		{
-			leaf->userData = -1;
-			//check by the way that the plane normal is unit!
-			assert(static_cast<double>(std::abs(CCVector3(leaf->planeEq).norm2()) - 1.0) < 1.0e-6);
+			cancelled = true;
 		}
-	}
-
-	// cosine of the max angle between fused 'planes'
-	const double c_minCosNormAngle = cos( CCCoreLib::DegreesToRadians( maxAngle_deg ) );
-
-	//fuse all cells, starting from the ones with the best error
-	const int unvisitedNeighborValue = -1;
-	bool cancelled = false;
-	int macroIndex = 1; //starts at 1 (0 is reserved for cells already above the max error)
-	{
-		for (auto& currentCell : leaves)
+		if (cancelled)
 		{
-			if (currentCell->error >= maxError)
-				currentCell->userData = 0; //0 = special group for cells already above the user defined threshold!
-
-			//already fused?
-			if (currentCell->userData != -1)
-			{
-				if (progressCb && !nProgress.oneStep()) //process canceled by user
-				{
-					cancelled = true;
-					break;
-				}
-				continue;
-			}
+			break;
+		}
 
-			//we create a new "macro cell" index
-			currentCell->userData = macroIndex++;
+		//already fused?
+		if (currentCell->userData != -1)
+		{
+			continue;
+		}
 
-			//we init the current set of 'fused' points with the cell's points
-			CCCoreLib::ReferenceCloud* currentPointSet = currentCell->points;
-			//get current fused set centroid and normal
-			CCVector3 currentCentroid = *CCCoreLib::Neighbourhood(currentPointSet).getGravityCenter();
-			CCVector3 currentNormal(currentCell->planeEq);
+		//we create a new "macro cell" (the final index is only assigned at the end)
+		currentCell->userData = static_cast<int>(currentIndex) + 1;
 
-			//visited neighbors
-			ccKdTree::LeafSet visitedNeighbors;
-			//set of candidates
-			std::list<Candidate> candidates;
+		//we init the current set of 'fused' points with the cell's points
+		CCCoreLib::ReferenceCloud* currentPointSet = currentCell->points;
+		//get current fused set centroid and normal
+		CCVector3 currentCentroid = leafInfos[currentIndex].centroid;
+		CCVector3 currentNormal(currentCell->planeEq);
 
-			//we are going to iteratively look for neighbor cells that could be fused to this one
-			ccKdTree::LeafVector cellsToTest;
-			cellsToTest.push_back(currentCell);
+		//visited neighbors
+		std::unordered_set<unsigned> visitedNeighbors;
+		//set of candidates
+		std::list<Candidate> candidates;
 
-			if (progressCb && !nProgress.oneStep()) //process canceled by user
-			{
-				cancelled = true;
-				break;
-			}
+		//we are going to iteratively look for neighbor cells that could be fused to this one
+		std::vector<unsigned> cellsToTest;
+		cellsToTest.push_back(currentIndex);
 
-			while (!cellsToTest.empty() || !candidates.empty())
+		while (!cellsToTest.empty() || !candidates.empty())
+		{
+			//get all neighbors around the 'waiting' cell(s)
+			if (!cellsToTest.empty())
 			{
-				//get all neighbors around the 'waiting' cell(s)
-				if (!cellsToTest.empty())
+				//we only consider unvisited cells (of the same group)
+				std::set<unsigned> neighbors;
+				try
 				{
-					ccKdTree::LeafSet neighbors;
 					while (!cellsToTest.empty())
 					{
-						if (!kdTree->getNeighborLeaves(cellsToTest.back(), neighbors, &unvisitedNeighborValue)) //we only consider unvisited cells!
+						for (unsigned neighborIndex : leafInfos[cellsToTest.back()].neighbors)
 						{
-							//an error occurred
-							return false;
+							if (leafInfos[neighborIndex].group == leafInfos[currentIndex].group && leaves[neighborIndex]->userData == -1)
+							{
+								neighbors.insert(neighborIndex);
+							}
 						}
 						cellsToTest.pop_back();
 					}
 
 					//add those (new) neighbors to the 'visitedNeighbors' set
 					//and to the candidates set by the way if they are not yet there
-					for (ccKdTree::LeafSet::iterator it = neighbors.begin(); it != neighbors.end(); ++it)
+					for (unsigned neighborIndex : neighbors)
 					{
-						ccKdTree::Leaf* neighbor = *it;
-						std::pair<ccKdTree::LeafSet::iterator,bool> ret = visitedNeighbors.insert(neighbor);
 						//neighbour not already in the set?
-						if (ret.second)
+						if (visitedNeighbors.insert(neighborIndex).second)
 						{
 							//we create the corresponding candidate
-							try
-							{
-								candidates.push_back(Candidate(neighbor));
-							}
-							catch (const std::bad_alloc&)
-							{
-								//not enough memory!
-								ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
-								return false;
-							}
+							candidates.push_back(Candidate(neighborIndex, leaves[neighborIndex], leafInfos[neighborIndex]));
 						}
 					}
 				}
+				catch (const std::bad_alloc&)
+				{
+					//not enough memory!
+					if (currentPointSet != currentCell->points)
+						delete currentPointSet;
+					return false;
+				}
+			}
 
-				//is there remaining candidates?
-				if (!candidates.empty())
+			//is there remaining candidates?
+			if (!candidates.empty())
+			{
+				//update the set of candidates
+				if (closestFirst && candidates.size() > 1)
 				{
-					//update the set of candidates
-					if (closestFirst && candidates.size() > 1)
-					{
-						for (std::list<Candidate>::iterator it = candidates.begin(); it !=candidates.end(); ++it)
-							it->dist = (it->centroid-currentCentroid).norm2();
+					for (std::list<Candidate>::iterator it = candidates.begin(); it != candidates.end(); ++it)
+						it->dist = (it->centroid - currentCentroid).norm2();
 
-						//sort candidates by their distance
-						candidates.sort(CandidateDistAscendingComparison);
-					}
-					
-					//we will keep track of the best fused 'couple' at each pass
-					std::list<Candidate>::iterator bestIt = candidates.end();
-					CCCoreLib::ReferenceCloud* bestFused = nullptr;
-					CCVector3 bestNormal(0, 0, 0);
-					double bestError = -1.0;
-
-					unsigned skipCount = 0;
-					for (std::list<Candidate>::iterator it = candidates.begin(); it != candidates.end(); /*++it*/)
-					{
-						assert(it->leaf && it->leaf->points);
-						assert(currentPointSet->getAssociatedCloud() == it->leaf->points->getAssociatedCloud());
+					//sort candidates by their distance
+					candidates.sort(CandidateDistAscendingComparison);
+				}
 
-						//if the leaf orientation is too different
-						if (std::abs(CCVector3(it->leaf->planeEq).dot(currentNormal)) < c_minCosNormAngle)
-						{
-							it = candidates.erase(it);
-							//++it;
-							//++skipCount;
-							continue;
-						}
+				//we will keep track of the best fused 'couple' at each pass
+				std::list<Candidate>::iterator bestIt = candidates.end();
+				CCCoreLib::ReferenceCloud* bestFused = nullptr;
+				double bestError = -1.0;
 
-						//compute the minimum distance between the candidate centroid and the 'currentPointSet'
-						PointCoordinateType minDistToMainSet = 0.0;
-						{
-							for (unsigned j = 0; j < currentPointSet->size(); ++j)
-							{
-								const CCVector3* P = currentPointSet->getPoint(j);
-								PointCoordinateType d2 = (*P - it->centroid).norm2();
-								if (d2 < minDistToMainSet || j == 0)
-									minDistToMainSet = d2;
-							}
-							minDistToMainSet = sqrt(minDistToMainSet);
-						}
+				unsigned skipCount = 0;
+				for (std::list<Candidate>::iterator it = candidates.begin(); it != candidates.end(); /*++it*/)
+				{
+					assert(it->leaf && it->leaf->points);
+					assert(currentPointSet->getAssociatedCloud() == it->leaf->points->getAssociatedCloud());
 
-						//if the leaf is too far
-						if (it->radius < minDistToMainSet / overlapCoef)
-						{
-							++it;
-							++skipCount;
-							continue;
-						}
+					//if the leaf orientation is too different
+					if (std::abs(CCVector3(it->leaf->planeEq).dot(currentNormal)) < minCosNormAngle)
+					{
+						it = candidates.erase(it);
+						continue;
+					}
 
-						//fuse the main set with the current candidate
-						CCCoreLib::ReferenceCloud* fused = new CCCoreLib::ReferenceCloud(*currentPointSet);
-						if (!fused->add(*(it->leaf->points)))
+					//compute the minimum distance between the candidate centroid and the 'currentPointSet'
+					PointCoordinateType minDistToMainSet = 0.0;
+					{
+						for (unsigned j = 0; j < currentPointSet->size(); ++j)
 						{
-							//not enough memory!
-							ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
-							delete fused;
-							if (currentPointSet != currentCell->points)
-								delete currentPointSet;
-							return false;
+							const CCVector3* P = currentPointSet->getPoint(j);
+							PointCoordinateType d2 = (*P - it->centroid).norm2();
+							if (d2 < minDistToMainSet || j == 0)
+								minDistToMainSet = d2;
 						}
+						minDistToMainSet = sqrt(minDistToMainSet);
+					}
 
-						//fit a plane and estimate the resulting error
-						double error = -1.0;
-						const PointCoordinateType* planeEquation = CCCoreLib::Neighbourhood(fused).getLSPlane();
-						if (planeEquation)
-							error = CCCoreLib::DistanceComputationTools::ComputeCloud2PlaneDistance(fused, planeEquation, errorMeasure);
+					//if the leaf is too far
+					if (it->radius < minDistToMainSet / overlapCoef)
+					{
+						++it;
+						++skipCount;
+						continue;
+					}
 
-						if (error < 0.0 || error > maxError)
-						{
-							//candidate is rejected
-							it = candidates.erase(it);
-						}
-						else
-						{
-							//otherwise we keep track of the best one!
-							if (bestError < 0.0 || error < bestError)
-							{
-								bestIt = it;
-								bestError = error;
-								if (bestFused)
-									delete bestFused;
-								bestFused = fused;
-								bestNormal = CCVector3(planeEquation);
-								fused = nullptr;
-
-								if (closestFirst)
-									break; //if we have found a good candidate, we stop here (closest first ;)
-							}
-							++it;
-						}
+					//fuse the main set with the current candidate
+					CCCoreLib::ReferenceCloud* fused = new CCCoreLib::ReferenceCloud(*currentPointSet);
+					if (!fused->add(*(it->leaf->points)))
+					{
+						//not enough memory!
+						delete fused;
+						if (bestFused)
+							delete bestFused;
+						if (currentPointSet != currentCell->points)
+							delete currentPointSet;
+						return false;
+					}
 
-						if (fused)
+					//fit a plane and estimate the resulting error
+					double error = -1.0;
+					const PointCoordinateType* planeEquation = CCCoreLib::Neighbourhood(fused).getLSPlane();
+					if (planeEquation)
+						error = CCCoreLib::DistanceComputationTools::ComputeCloud2PlaneDistance(fused, planeEquation, errorMeasure);
+
+					if (error < 0.0 || error > maxError)
+					{
+						//candidate is rejected
+						it = candidates.erase(it);
+					}
+					else
+					{
+						//otherwise we keep track of the best one!
+						if (bestError < 0.0 || error < bestError)
 						{
-							delete fused;
+							bestIt = it;
+							bestError = error;
+							if (bestFused)
+								delete bestFused;
+							bestFused = fused;
 							fused = nullptr;
+
+							if (closestFirst)
+								break; //if we have found a good candidate, we stop here (closest first ;)
 						}
+						++it;
 					}
 
-					//we have a (best) candidate for this pass?
-					if (bestIt != candidates.end())
+					if (fused)
 					{
-						assert(bestFused && bestError >= 0.0);
-						if (currentPointSet != currentCell->points)
-							delete currentPointSet;
-						currentPointSet = bestFused;
-						{
-							//update infos
-							CCCoreLib::Neighbourhood N(currentPointSet);
-							//currentCentroid = *N.getGravityCenter(); //if we update it, the search will naturally shift along one dimension!
-							//currentNormal = bestNormal; //same thing here for normals
-						}
+						delete fused;
+						fused = nullptr;
+					}
+				}
 
-						bestIt->leaf->userData = currentCell->userData;
+				//we have a (best) candidate for this pass?
+				if (bestIt != candidates.end())
+				{
+					assert(bestFused && bestError >= 0.0);
+					if (currentPointSet != currentCell->points)
+						delete currentPointSet;
+					currentPointSet = bestFused;
+					//we don't update the centroid and the normal, otherwise the search would naturally shift along one dimension!
 
-						//we will test this cell's neighbors as well
-						cellsToTest.push_back(bestIt->leaf);
+					bestIt->leaf->userData = currentCell->userData;
 
-						if (progressCb && !nProgress.oneStep()) //process canceled by user
-						{
-							//premature end!
-							candidates.clear();
-							cellsToTest.clear();
-							cancelled = true;
-							break;
-						}
-						QApplication::processEvents();
+					//we will test this cell's neighbors as well
+					cellsToTest.push_back(bestIt->leafIndex);
 
-						//we also remove it from the candidates list
-						candidates.erase(bestIt);
-					}
+					//we also remove it from the candidates list
+					candidates.erase(bestIt);
 
-					if (skipCount == candidates.size() && cellsToTest.empty())
+					if (cancelled)
 					{
-						//only far leaves remain...
+						//premature end!
 						candidates.clear();
+						cellsToTest.clear();
+						break;
 					}
+				}
 
+				if (skipCount == candidates.size() && cellsToTest.empty())
+				{
+					//only far leaves remain...
+					candidates.clear();
 				}
+			}
 
-			} //no more candidates or cells to test
+		} //no more candidates or cells to test
 
-			//end of the fusion process for the current leaf
-			if (currentPointSet != currentCell->points)
-				delete currentPointSet;
-			currentPointSet = nullptr;
+		//end of the fusion process for the current leaf
+		if (currentPointSet != currentCell->points)
+			delete currentPointSet;
+		currentPointSet = nullptr;
+	}
+
+	return true;
+}
 
-			if (cancelled)
-				break;
+bool ccKdTreeForFacetExtraction::FuseCells(	ccKdTree* kdTree,
+											double maxError,
+											CCCoreLib::DistanceComputationTools::ERROR_MEASURES errorMeasure,
+											double maxAngle_deg,
+											PointCoordinateType overlapCoef/*=1*/,
+											bool closestFirst/*=true*/,
+											CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/,
+											int maxThreadCount/*=0*/)
+{
+	if (!kdTree)
+		return false;
+
+	ccGenericPointCloud* associatedGenericCloud = kdTree->associatedGenericCloud();
+	if (!associatedGenericCloud || !associatedGenericCloud->isA(CC_TYPES::POINT_CLOUD) || maxError < 0.0)
+		return false;
+
+	//get leaves
+	std::vector<ccKdTree::Leaf*> leaves;
+	if (!kdTree->getLeaves(leaves) || leaves.empty())
+		return false;
+
+	unsigned leafCount = static_cast<unsigned>(leaves.size());
+
+	//progress notification (neighborhood + fusion)
+	CCCoreLib::NormalizedProgress nProgress(progressCb, 2 * leafCount);
+	if (progressCb)
+	{
+		progressCb->update(0);
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Fuse Kd-tree cells");
+			progressCb->setInfo(qPrintable(QString("Cells: %1\nMax error: %2").arg(leafCount).arg(maxError)));
 		}
+		progressCb->start();
 	}
 
-	//convert fused indexes to SF
-	if (!cancelled)
+	ccPointCloud* pc = static_cast<ccPointCloud*>(associatedGenericCloud);
+
+	//sort cells based on their population size (we start by the biggest ones)
+	ParallelSort(leaves.begin(), leaves.end(), DescendingLeafSizeComparison);
+
+	//set all 'userData' to -1 (i.e. unfused cells)
+	{
+		for (auto& leaf : leaves)
+		{
+			leaf->userData = -1;
+			//check by the way that the plane normal is unit!
+			assert(static_cast<double>(std::abs(CCVector3(leaf->planeEq).norm2()) - 1.0) < 1.0e-6);
+		}
+	}
+
+	std::vector<LeafInfo> leafInfos;
+	std::vector<unsigned> leafIndexes;
+	std::unordered_map<ccKdTree::Leaf*, unsigned> leafIndexMap;
+	try
 	{
-		if (!pc->enableScalarField())
+		leafInfos.resize(leafCount);
+		leafIndexes.resize(leafCount);
+		leafIndexMap.reserve(leafCount);
+		for (unsigned i = 0; i < leafCount; ++i)
 		{
-			ccLog::Error("Not enough memory");
-			return false;
+			leafIndexes[i] = i;
+			leafIndexMap[leaves[i]] = i;
 		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
+		return false;
+	}
 
-		for (size_t i = 0; i < leaves.size(); ++i)
+	if (maxThreadCount > 0)
+	{
+		QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
+	}
+
+	std::atomic<bool> error(false);
+	std::atomic<bool> cancelled(false);
+
+	//compute the leaves properties and their neighbors (concurrently)
+	kdTree->getOwnBB(); //make sure the cloud bounding-box is up to date before the concurrent queries
+	QtConcurrent::blockingMap(leafIndexes, [&](unsigned leafIndex)
+	{
+		if (error || cancelled)
+			return;
+
+		ccKdTree::Leaf* leaf = leaves[leafIndex];
+		LeafInfo& info = leafInfos[leafIndex];
+		if (leaf->points)
 		{
-			CCCoreLib::ReferenceCloud* subset = leaves[i]->points;
-			if (subset)
+			CCCoreLib::Neighbourhood N(leaf->points);
+			info.centroid = *N.getGravityCenter();
+			info.radius = N.computeLargestRadius();
+		}
+
+		try
+		{
+			ccKdTree::LeafSet neighbors;
+			if (!kdTree->getNeighborLeaves(leaf, neighbors))
 			{
-				ScalarType scalar = static_cast<ScalarType>(leaves[i]->userData);
-				if (leaves[i]->userData <= 0) //for unfused cells, we create new individual groups
-				{
-					scalar = static_cast<ScalarType>(macroIndex++);
-					//scalar = NAN_VALUE; //FIXME TEST
-				}
-				for (unsigned j = 0; j < subset->size(); ++j)
+				error = true;
+				return;
+			}
+			info.neighbors.reserve(neighbors.size());
+			for (ccKdTree::Leaf* neighbor : neighbors)
+			{
+				info.neighbors.push_back(leafIndexMap.at(neighbor));
+			}
+			std::sort(info.neighbors.begin(), info.neighbors.end());
+		}
+		catch (const std::exception&)
+		{
+			error = true;
+			return;
+		}
+
+		if (progressCb && !nProgress.oneStep()) //process canceled by user
+		{
+			cancelled = true;
+		}
+	});
+
+	if (error)
+	{
+		ccLog::Warning("[ccKdTreeForFacetExtraction] Failed to compute the cells neighborhood (not enough memory?)");
+		return false;
+	}
+	if (cancelled)
+	{
+		return false;
+	}
+
+	// cosine of the max angle between fused 'planes'
+	const double c_minCosNormAngle = cos( CCCoreLib::DegreesToRadians( maxAngle_deg ) );
+
+	//A leaf can only be fused with a seed leaf if they are linked by a chain of (fused)
+	//neighbor leaves, all deviating from the seed normal by less than the max angle.
+	//Therefore two neighbor leaves deviating from each other by more than twice this
+	//angle can't be part of the same facet, and the leaves can be split in groups
+	//that can be fused independently.
+	const double maxLinkAngle_deg = 2 * maxAngle_deg + 1.0; //+1 degree as safety margin
+	const double c_minCosLinkAngle = (maxLinkAngle_deg < 90.0 ? cos(CCCoreLib::DegreesToRadians(maxLinkAngle_deg)) : -1.0);
+
+	std::vector< std::vector<unsigned> > groups;
+	try
+	{
+		std::vector<unsigned> parent(leafIndexes);
+		for (unsigned i = 0; i < leafCount; ++i)
+		{
+			CCVector3 N(leaves[i]->planeEq);
+			for (unsigned j : leafInfos[i].neighbors)
+			{
+				if (j > i && std::abs(N.dot(CCVector3(leaves[j]->planeEq))) >= c_minCosLinkAngle)
 				{
-					subset->setPointScalarValue(j, scalar);
+					unsigned rootI = FindRootGroup(parent, i);
+					unsigned rootJ = FindRootGroup(parent, j);
+					if (rootI != rootJ)
+					{
+						parent[std::max(rootI, rootJ)] = std::min(rootI, rootJ);
+					}
 				}
 			}
 		}
 
-		//pc->setCurrentDisplayedScalarField(sfIdx);
+		//the leaves of each group are kept in the (global) processing order
+		std::vector<unsigned> groupIndexes(leafCount, 0);
+		for (unsigned i = 0; i < leafCount; ++i)
+		{
+			unsigned root = FindRootGroup(parent, i);
+			if (root == i)
+			{
+				groupIndexes[i] = static_cast<unsigned>(groups.size());
+				groups.emplace_back();
+			}
+			leafInfos[i].group = groupIndexes[root];
+			groups[groupIndexes[root]].push_back(i);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
+		return false;
+	}
+
+	//we process the biggest groups first (better load balancing)
+	std::sort(groups.begin(), groups.end(), [](const std::vector<unsigned>& a, const std::vector<unsigned>& b) { return a.size() > b.size(); });
+
+	if (progressCb && progressCb->textCanBeEdited())
+	{
+		progressCb->setInfo(qPrintable(QString("Cells: %1\nMax error: %2\nIndependent groups: %3").arg(leafCount).arg(maxError).arg(groups.size())));
+	}
+
+	//fuse the cells of each group (concurrently)
+	QtConcurrent::blockingMap(groups, [&](const std::vector<unsigned>& group)
+	{
+		if (error || cancelled)
+			return;
+
+		if (!FuseGroup(	group,
+						leaves,
+						leafInfos,
+						maxError,
+						errorMeasure,
+						c_minCosNormAngle,
+						overlapCoef,
+						closestFirst,
+						progressCb ? &nProgress : nullptr,
+						cancelled))
+		{
+			error = true;
+		}
+	});
+
+	if (error)
+	{
+		ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
+		return false;
+	}
+	if (cancelled)
+	{
+		return false;
+	}
+
+	//assign the final "macro cell" indexes in the leaves order (so that they don't depend on the threads scheduling)
+	int macroIndex = 1; //starts at 1 (0 is reserved for cells already above the max error)
+	std::vector<int> macroIndexes;
+	try
+	{
+		macroIndexes.resize(leafCount, 0);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
+		return false;
+	}
+	for (unsigned i = 0; i < leafCount; ++i)
+	{
+		if (leaves[i]->userData == static_cast<int>(i) + 1) //seed cell
+		{
+			macroIndexes[i] = macroIndex++;
+		}
+	}
+	for (ccKdTree::Leaf* leaf : leaves)
+	{
+		if (leaf->userData > 0)
+		{
+			leaf->userData = macroIndexes[leaf->userData - 1];
+		}
+	}
+
+	//convert fused indexes to SF
+	if (!pc->enableScalarField())
+	{
+		ccLog::Error("Not enough memory");
+		return false;
+	}
+
+	for (size_t i = 0; i < leaves.size(); ++i)
+	{
+		CCCoreLib::ReferenceCloud* subset = leaves[i]->points;
+		if (subset)
+		{
+			ScalarType scalar = static_cast<ScalarType>(leaves[i]->userData);
+			if (leaves[i]->userData <= 0) //for unfused cells, we create new individual groups
+			{
+				scalar = static_cast<ScalarType>(macroIndex++);
+			}
+			for (unsigned j = 0; j < subset->size(); ++j)
+			{
+				subset->setPointScalarValue(j, scalar);
+			}
+		}
 	}
 
-	return !cancelled;
+	return true;
 }
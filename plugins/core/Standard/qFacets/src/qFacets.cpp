@@ -55,6 +55,7 @@
 // semi-persistent dialog values
 static unsigned s_octreeLevel               = 8;
 static bool     s_fmUseRetroProjectionError = false;
+static bool     s_fmUseParallelBlocks       = false;
 
 static unsigned s_minPointsPerFacet = 10;
 static double   s_errorMaxPerFacet  = 0.2;
@@ -227,6 +228,7 @@ void qFacets::extractFacets(CellsFusionDlg::Algorithm algo)
 	params.kdTreeFusionMaxRelativeDistance = s_kdTreeFusionMaxRelativeDistance;
 	params.octreeLevel                     = s_octreeLevel;
 	params.useRetroProjectionError         = s_fmUseRetroProjectionError;
+	params.useParallelBlocks               = s_fmUseParallelBlocks;
 
 	// Convert static int to enum for the param struct
 	switch (s_errorMeasureType)
@@ -257,6 +259,7 @@ void qFacets::extractFacets(CellsFusionDlg::Algorithm algo)
 	// Populate dialog from params (which hold the defaults)
 	fusionDlg.octreeLevelSpinBox->setValue(params.octreeLevel);
 	fusionDlg.useRetroProjectionCheckBox->setChecked(params.useRetroProjectionError);
+	fusionDlg.parallelBlocksCheckBox->setChecked(params.useParallelBlocks);
 	fusionDlg.minPointsPerFacetSpinBox->setValue(params.minPointsPerFacet);
 	fusionDlg.errorMeasureComboBox->setCurrentIndex(s_errorMeasureType); // Use static index for dialog
 	fusionDlg.maxRMSDoubleSpinBox->setValue(params.errorMaxPerFacet);
@@ -271,6 +274,7 @@ void qFacets::extractFacets(CellsFusionDlg::Algorithm algo)
 	// Read values back from dialog into params struct
 	params.octreeLevel                     = fusionDlg.octreeLevelSpinBox->value();
 	params.useRetroProjectionError         = fusionDlg.useRetroProjectionCheckBox->isChecked();
+	params.useParallelBlocks               = fusionDlg.parallelBlocksCheckBox->isChecked();
 	params.minPointsPerFacet               = fusionDlg.minPointsPerFacetSpinBox->value();
 	params.errorMaxPerFacet                = fusionDlg.maxRMSDoubleSpinBox->value();
 	params.kdTreeFusionMaxAngleDeg         = fusionDlg.maxAngleDoubleSpinBox->value();
@@ -280,6 +284,7 @@ void qFacets::extractFacets(CellsFusionDlg::Algorithm algo)
 	// Save static defaults
 	s_octreeLevel                     = params.octreeLevel;
 	s_fmUseRetroProjectionError       = params.useRetroProjectionError;
+	s_fmUseParallelBlocks             = params.useParallelBlocks;
 	s_minPointsPerFacet               = params.minPointsPerFacet;
 	s_errorMaxPerFacet                = params.errorMaxPerFacet;
 	s_kdTreeFusionMaxAngle_deg        = params.kdTreeFusionMaxAngleDeg;
@@ -415,14 +420,31 @@ ccHObject* qFacets::ExecuteFacetExtraction(ccPointCloud*                       p
 	}
 	else if (params.algo == CellsFusionDlg::ALGO_FAST_MARCHING)
 	{
-		int result = FastMarchingForFacetExtraction::ExtractPlanarFacets(
-		    pc,
-		    static_cast<unsigned char>(params.octreeLevel),
-		    static_cast<ScalarType>(params.errorMaxPerFacet),
-		    params.errorMeasure,
-		    params.useRetroProjectionError,
-		    progress,
-		    pc->getOctree().data());
+		int result = 0;
+		if (params.useParallelBlocks)
+		{
+			result = FastMarchingForFacetExtraction::ExtractPlanarFacetsParallel(
+			    pc,
+			    static_cast<unsigned char>(params.octreeLevel),
+			    static_cast<ScalarType>(params.errorMaxPerFacet),
+			    params.errorMeasure,
+			    params.useRetroProjectionError,
+			    params.blockSize,
+			    0,
+			    progress,
+			    pc->getOctree().data());
+		}
+		else
+		{
+			result = FastMarchingForFacetExtraction::ExtractPlanarFacets(
+			    pc,
+			    static_cast<unsigned char>(params.octreeLevel),
+			    static_cast<ScalarType>(params.errorMaxPerFacet),
+			    params.errorMeasure,
+			    params.useRetroProjectionError,
+			    progress,
+			    pc->getOctree().data());
+		}
 
 		success = (result >= 0);
 	}
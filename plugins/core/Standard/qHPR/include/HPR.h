@@ -0,0 +1,95 @@
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qHPR                        #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                  COPYRIGHT: Daniel Girardeau-Montaut                   #
+//#                                                                        #
+//##########################################################################
+
+#ifndef HPR_HEADER
+#define HPR_HEADER
+
+//CCCoreLib
+#include <DgmOctree.h>
+#include <GenericProgressCallback.h>
+#include <ReferenceCloud.h>
+
+//System
+#include <vector>
+
+//! Hidden Point Removal (Katz et al.)
+/** "Direct Visibility of Point Sets", Sagi Katz, Ayellet Tal, and Ronen Basri.
+	SIGGRAPH 2007
+**/
+class HPR
+{
+public:
+
+	//! Working buffers
+	/** Can be reused from one view point to the next (one instance per thread).
+	**/
+	struct Buffers
+	{
+		//! Flipped coordinates (+ the view point) as expected by qhull
+		std::vector<double> coordinates;
+		//! Whether each point belongs to the convex hull (i.e. is visible) or not
+		std::vector<bool> visible;
+	};
+
+	//! Flags the points visible from a given view point
+	/** \param cloud input cloud
+		\param viewPoint view point
+		\param fParam spherical flipping radius parameter (exponent)
+		\param buffers working buffers (the result is stored in buffers.visible)
+		\return success
+	**/
+	static bool FlagVisiblePoints(	CCCoreLib::GenericIndexedCloudPersist* cloud,
+									const CCVector3d& viewPoint,
+									double fParam,
+									Buffers& buffers);
+
+	//! Returns the points visible from a given view point
+	/** \param cloud input cloud
+		\param viewPoint view point
+		\param fParam spherical flipping radius parameter (exponent)
+		\param buffers optional working buffers (to avoid reallocating them at each call)
+		\return visible points (or nullptr if an error occurred)
+	**/
+	static CCCoreLib::ReferenceCloud* RemoveHiddenPoints(	CCCoreLib::GenericIndexedCloudPersist* cloud,
+															const CCVector3d& viewPoint,
+															double fParam,
+															Buffers* buffers = nullptr);
+
+	//! Computes the number of view points from which each point is visible
+	/** The spherical flipping and the visibility accumulation are processed in parallel,
+		but the convex hulls are computed one at a time (the bundled qhull library is not reentrant).
+		\param cloud input cloud
+		\param viewPoints set of view points (e.g. a scanner trajectory)
+		\param fParam spherical flipping radius parameter (exponent)
+		\param[out] visibilityCount per-point visibility count
+		\param octree optional octree (required if octreeLevel > 0)
+		\param octreeLevel if > 0, the cloud is decimated with the octree before computing the hulls (one point per cell)
+		\param progressCb optional progress callback
+		\param maxThreadCount max number of threads (0 = ideal thread count)
+		\return success
+	**/
+	static bool ComputeVisibilityCount(	CCCoreLib::GenericIndexedCloudPersist* cloud,
+										const std::vector<CCVector3d>& viewPoints,
+										double fParam,
+										std::vector<unsigned>& visibilityCount,
+										CCCoreLib::DgmOctree* octree = nullptr,
+										unsigned char octreeLevel = 0,
+										CCCoreLib::GenericProgressCallback* progressCb = nullptr,
+										int maxThreadCount = 0);
+};
+
+#endif
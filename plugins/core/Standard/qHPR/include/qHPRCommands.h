@@ -0,0 +1,309 @@
+#pragma once
+
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qHPR                        #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                  COPYRIGHT: Daniel Girardeau-Montaut                   #
+//#                                                                        #
+//##########################################################################
+
+//CloudCompare
+#include "ccCommandLineInterface.h"
+
+//Local
+#include "HPR.h"
+
+//qCC_db
+#include <ccOctree.h>
+#include <ccScalarField.h>
+
+//Qt
+#include <QFile>
+#include <QRegularExpression>
+#include <QTextStream>
+
+static const char COMMAND_HPR[] = "HPR";
+static const char COMMAND_HPR_VIEWPOINT[] = "VIEWPOINT";
+static const char COMMAND_HPR_VIEWPOINTS_FILE[] = "VIEWPOINTS_FILE";
+static const char COMMAND_HPR_OCTREE_LEVEL[] = "OCTREE_LEVEL";
+static const char COMMAND_HPR_VISIBLE_ONLY[] = "VISIBLE_ONLY";
+static const char COMMAND_HPR_MAX_THREAD_COUNT[] = "MAX_THREAD_COUNT";
+
+static const char HPR_VISIBILITY_SF_NAME[] = "HPR visibility count";
+
+//! Hidden Point Removal for one or several view points (e.g. a scanner trajectory)
+/** Syntax: -HPR {-VIEWPOINT x y z} {-VIEWPOINTS_FILE filename} [-OCTREE_LEVEL level] [-VISIBLE_ONLY] [-MAX_THREAD_COUNT count]
+	- the view points are expressed in the global coordinate system
+	- the viewpoints file is an ASCII file with 'X Y Z' per line (lines starting with '//' or '#' are ignored)
+	- the octree level is used to decimate the cloud before computing the hulls (0 = no decimation, default: 7)
+	- the number of view points from which each point is visible is stored as a scalar field
+	- with -VISIBLE_ONLY, each cloud is replaced by the points visible from at least one view point
+**/
+struct CommandHPR : public ccCommandLineInterface::Command
+{
+	CommandHPR() : ccCommandLineInterface::Command("HPR", COMMAND_HPR) {}
+
+	static bool ReadViewPoints(const QString& filename, std::vector<CCVector3d>& viewPoints, QString& errorStr)
+	{
+		QFile file(filename);
+		if (!file.open(QFile::ReadOnly | QFile::Text))
+		{
+			errorStr = QObject::tr("Failed to open file '%1'").arg(filename);
+			return false;
+		}
+
+		QTextStream stream(&file);
+		unsigned lineIndex = 0;
+		while (!stream.atEnd())
+		{
+			QString line = stream.readLine().trimmed();
+			++lineIndex;
+			if (line.isEmpty() || line.startsWith("//") || line.startsWith('#'))
+			{
+				continue;
+			}
+
+			QStringList tokens = line.simplified().split(QRegularExpression("[ ,;\\t]"), Qt::SkipEmptyParts);
+			if (tokens.size() < 3)
+			{
+				errorStr = QObject::tr("Line %1: expecting at least 3 values (X Y Z)").arg(lineIndex);
+				return false;
+			}
+
+			CCVector3d P;
+			bool okX = false;
+			bool okY = false;
+			bool okZ = false;
+			P.x = tokens[0].toDouble(&okX);
+			P.y = tokens[1].toDouble(&okY);
+			P.z = tokens[2].toDouble(&okZ);
+			if (!okX || !okY || !okZ)
+			{
+				errorStr = QObject::tr("Line %1: invalid coordinates").arg(lineIndex);
+				return false;
+			}
+
+			try
+			{
+				viewPoints.push_back(P);
+			}
+			catch (const std::bad_alloc&)
+			{
+				errorStr = QObject::tr("Not enough memory");
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool process(ccCommandLineInterface& cmd) override
+	{
+		cmd.print("[HPR]");
+
+		if (cmd.clouds().empty())
+		{
+			return cmd.error(QObject::tr("No cloud loaded"));
+		}
+
+		//initial parameters
+		std::vector<CCVector3d> viewPoints;
+		int octreeLevel = 7;
+		bool visibleOnly = false;
+		int maxThreadCount = 0;
+
+		while (!cmd.arguments().empty())
+		{
+			const QString& ARGUMENT = cmd.arguments().front();
+			if (ccCommandLineInterface::IsCommand(ARGUMENT, COMMAND_HPR_VIEWPOINT))
+			{
+				cmd.arguments().pop_front();
+				if (cmd.arguments().size() < 3)
+				{
+					return cmd.error(QObject::tr("Missing parameter(s): X Y Z after \"-%1\"").arg(COMMAND_HPR_VIEWPOINT));
+				}
+				CCVector3d P;
+				bool okX = false;
+				bool okY = false;
+				bool okZ = false;
+				P.x = cmd.arguments().takeFirst().toDouble(&okX);
+				P.y = cmd.arguments().takeFirst().toDouble(&okY);
+				P.z = cmd.arguments().takeFirst().toDouble(&okZ);
+				if (!okX || !okY || !okZ)
+				{
+					return cmd.error(QObject::tr("Invalid parameter: X Y Z after \"-%1\"").arg(COMMAND_HPR_VIEWPOINT));
+				}
+				viewPoints.push_back(P);
+			}
+			else if (ccCommandLineInterface::IsCommand(ARGUMENT, COMMAND_HPR_VIEWPOINTS_FILE))
+			{
+				cmd.arguments().pop_front();
+				if (cmd.arguments().empty())
+				{
+					return cmd.error(QObject::tr("Missing parameter: filename after \"-%1\"").arg(COMMAND_HPR_VIEWPOINTS_FILE));
+				}
+				QString filename = cmd.arguments().takeFirst();
+				QString errorStr;
+				if (!ReadViewPoints(filename, viewPoints, errorStr))
+				{
+					return cmd.error(errorStr);
+				}
+				cmd.print(QObject::tr("View points loaded from '%1'").arg(filename));
+			}
+			else if (ccCommandLineInterface::IsCommand(ARGUMENT, COMMAND_HPR_OCTREE_LEVEL))
+			{
+				cmd.arguments().pop_front();
+				bool conv = false;
+				octreeLevel = cmd.arguments().isEmpty() ? -1 : cmd.arguments().takeFirst().toInt(&conv);
+				if (!conv || octreeLevel < 0 || octreeLevel > CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL)
+				{
+					return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_HPR_OCTREE_LEVEL));
+				}
+			}
+			else if (ccCommandLineInterface::IsCommand(ARGUMENT, COMMAND_HPR_VISIBLE_ONLY))
+			{
+				cmd.arguments().pop_front();
+				visibleOnly = true;
+			}
+			else if (ccCommandLineInterface::IsCommand(ARGUMENT, COMMAND_HPR_MAX_THREAD_COUNT))
+			{
+				cmd.arguments().pop_front();
+				bool conv = false;
+				maxThreadCount = cmd.arguments().isEmpty() ? -1 : cmd.arguments().takeFirst().toInt(&conv);
+				if (!conv || maxThreadCount < 0)
+				{
+					return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_HPR_MAX_THREAD_COUNT));
+				}
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		if (viewPoints.empty())
+		{
+			return cmd.error(QObject::tr("No view point defined (use -%1 or -%2)").arg(COMMAND_HPR_VIEWPOINT, COMMAND_HPR_VIEWPOINTS_FILE));
+		}
+		cmd.print(QObject::tr("View points: %1").arg(viewPoints.size()));
+
+		for (CLCloudDesc& desc : cmd.clouds())
+		{
+			ccPointCloud* pc = desc.pc;
+			if (!pc || pc->size() == 0)
+			{
+				cmd.warning(QObject::tr("Cloud %1 is empty").arg(desc.basename));
+				continue;
+			}
+
+			//the view points are expressed in the global coordinate system
+			std::vector<CCVector3d> localViewPoints(viewPoints.size());
+			for (size_t i = 0; i < viewPoints.size(); ++i)
+			{
+				localViewPoints[i] = pc->toLocal3d(viewPoints[i]);
+			}
+
+			ccOctree::Shared octree;
+			if (octreeLevel != 0)
+			{
+				octree = pc->getOctree();
+				if (!octree)
+				{
+					octree = pc->computeOctree(cmd.progressDialog());
+				}
+				if (!octree)
+				{
+					return cmd.error(QObject::tr("Failed to compute the octree of cloud %1").arg(desc.basename));
+				}
+			}
+
+			std::vector<unsigned> visibilityCount;
+			if (!HPR::ComputeVisibilityCount(	pc,
+												localViewPoints,
+												3.5,
+												visibilityCount,
+												octree.data(),
+												static_cast<unsigned char>(octreeLevel),
+												cmd.progressDialog(),
+												maxThreadCount))
+			{
+				return cmd.error(QObject::tr("Hidden Point Removal failed on cloud %1 (not enough memory?)").arg(desc.basename));
+			}
+
+			//store the visibility count as a scalar field
+			int sfIdx = pc->getScalarFieldIndexByName(HPR_VISIBILITY_SF_NAME);
+			if (sfIdx < 0)
+			{
+				sfIdx = pc->addScalarField(HPR_VISIBILITY_SF_NAME);
+			}
+			if (sfIdx < 0)
+			{
+				return cmd.error(QObject::tr("Not enough memory"));
+			}
+			CCCoreLib::ScalarField* sf = pc->getScalarField(sfIdx);
+			unsigned visiblePointCount = 0;
+			for (unsigned i = 0; i < pc->size(); ++i)
+			{
+				sf->setValue(i, static_cast<ScalarType>(visibilityCount[i]));
+				if (visibilityCount[i] != 0)
+				{
+					++visiblePointCount;
+				}
+			}
+			sf->computeMinAndMax();
+			pc->setCurrentDisplayedScalarField(sfIdx);
+			cmd.print(QObject::tr("Cloud %1: %2 visible points (out of %3)").arg(desc.basename).arg(visiblePointCount).arg(pc->size()));
+
+			if (visibleOnly)
+			{
+				CCCoreLib::ReferenceCloud visiblePoints(pc);
+				if (!visiblePoints.reserve(visiblePointCount))
+				{
+					return cmd.error(QObject::tr("Not enough memory"));
+				}
+				for (unsigned i = 0; i < pc->size(); ++i)
+				{
+					if (visibilityCount[i] != 0)
+					{
+						visiblePoints.addPointIndex(i); //can't fail, see above
+					}
+				}
+
+				ccPointCloud* result = pc->partialClone(&visiblePoints);
+				if (!result)
+				{
+					return cmd.error(QObject::tr("Not enough memory"));
+				}
+				result->setName(pc->getName() + QString(".visible_points"));
+
+				//replace current cloud by this one
+				delete desc.pc;
+				desc.pc = result;
+			}
+
+			desc.basename += QString("_HPR");
+
+			//save output
+			if (cmd.autoSaveMode())
+			{
+				QString errorStr = cmd.exportEntity(desc);
+				if (!errorStr.isEmpty())
+				{
+					return cmd.error(errorStr);
+				}
+			}
+		}
+
+		return true;
+	}
+};
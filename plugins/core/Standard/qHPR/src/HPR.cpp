@@ -0,0 +1,369 @@
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qHPR                        #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                  COPYRIGHT: Daniel Girardeau-Montaut                   #
+//#                                                                        #
+//##########################################################################
+
+#include "HPR.h"
+
+//CCCoreLib
+#include <CloudSamplingTools.h>
+
+//Qt
+#include <QMutex>
+#include <QScopedPointer>
+#include <QString>
+#include <QThread>
+#include <QtConcurrentMap>
+
+//Qhull
+extern "C"
+{
+#include <qhull_a.h>
+}
+
+//System
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+
+static_assert(std::is_same<coordT, double>::value, "HPR::Buffers::coordinates must match qhull's coordinate type");
+
+//! The (non reentrant) qhull library relies on a global state
+static QMutex s_qhullMutex;
+
+bool HPR::FlagVisiblePoints(CCCoreLib::GenericIndexedCloudPersist* cloud,
+							const CCVector3d& viewPoint,
+							double fParam,
+							Buffers& buffers)
+{
+	assert(cloud);
+
+	unsigned nbPoints = cloud->size();
+	if (nbPoints == 0)
+		return false;
+
+	try
+	{
+		buffers.visible.resize(nbPoints + 1);
+		//less than 4 points? no need for calculation, the whole cloud is visible
+		std::fill(buffers.visible.begin(), buffers.visible.end(), nbPoints < 4);
+		if (nbPoints < 4)
+		{
+			return true;
+		}
+
+		buffers.coordinates.resize((static_cast<size_t>(nbPoints) + 1) * 3);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory!
+		return false;
+	}
+
+	double maxRadius = 0;
+
+	//convert point cloud to an array of double triplets (for qHull)
+	coordT* pt_array = buffers.coordinates.data();
+	{
+		coordT* _pt_array = pt_array;
+
+		for (unsigned i = 0; i < nbPoints; ++i)
+		{
+			CCVector3d P = cloud->getPoint(i)->toDouble() - viewPoint;
+			*_pt_array++ = static_cast<coordT>(P.x);
+			*_pt_array++ = static_cast<coordT>(P.y);
+			*_pt_array++ = static_cast<coordT>(P.z);
+
+			//we keep track of the highest 'radius'
+			double r2 = P.norm2();
+			if (maxRadius < r2)
+				maxRadius = r2;
+		}
+
+		//we add the view point (Cf. HPR)
+		*_pt_array++ = 0;
+		*_pt_array++ = 0;
+		*_pt_array++ = 0;
+
+		maxRadius = sqrt(maxRadius);
+	}
+
+	//apply spherical flipping
+	{
+		maxRadius *= pow(10.0, fParam) * 2;
+
+		coordT* _pt_array = pt_array;
+		for (unsigned i = 0; i < nbPoints; ++i, _pt_array += 3)
+		{
+			double norm = sqrt(_pt_array[0] * _pt_array[0] + _pt_array[1] * _pt_array[1] + _pt_array[2] * _pt_array[2]);
+
+			double r = (maxRadius / norm) - 1.0;
+			_pt_array[0] *= r;
+			_pt_array[1] *= r;
+			_pt_array[2] *= r;
+		}
+	}
+
+	bool success = false;
+	{
+		QMutexLocker locker(&s_qhullMutex);
+
+		static char qHullCommand[] = "qhull QJ Qci";
+		if (!qh_new_qhull(3, nbPoints + 1, pt_array, False, qHullCommand, nullptr, stderr))
+		{
+			vertexT *vertex = nullptr;
+			vertexT **vertexp = nullptr;
+			facetT *facet = nullptr;
+
+			FORALLfacets
+			{
+				//if (!facet->simplicial)
+				//	error("convhulln: non-simplicial facet"); // should never happen with QJ
+
+				setT* vertices = qh_facet3vertex(facet);
+				FOREACHvertex_(vertices)
+				{
+					buffers.visible[qh_pointid(vertex->point)] = true;
+				}
+				qh_settempfree(&vertices);
+			}
+
+			success = true;
+		}
+
+		qh_freeqhull(!qh_ALL);
+		//free long memory
+		int curlong = 0;
+		int totlong = 0;
+		qh_memfreeshort(&curlong, &totlong);
+		//free short memory and memory allocator
+	}
+
+	return success;
+}
+
+CCCoreLib::ReferenceCloud* HPR::RemoveHiddenPoints(	CCCoreLib::GenericIndexedCloudPersist* cloud,
+													const CCVector3d& viewPoint,
+													double fParam,
+													Buffers* buffers/*=nullptr*/)
+{
+	assert(cloud);
+
+	Buffers localBuffers;
+	if (!buffers)
+	{
+		buffers = &localBuffers;
+	}
+
+	if (!FlagVisiblePoints(cloud, viewPoint, fParam, *buffers))
+	{
+		return nullptr;
+	}
+
+	unsigned nbPoints = cloud->size();
+
+	//compute the number of points belonging to the convex hull
+	unsigned cvxHullSize = 0;
+	{
+		for (unsigned i = 0; i < nbPoints; ++i)
+			if (buffers->visible[i])
+				++cvxHullSize;
+	}
+
+	CCCoreLib::ReferenceCloud* visiblePoints = new CCCoreLib::ReferenceCloud(cloud);
+	if (cvxHullSize != 0 && visiblePoints->reserve(cvxHullSize))
+	{
+		for (unsigned i = 0; i < nbPoints; ++i)
+			if (buffers->visible[i])
+				visiblePoints->addPointIndex(i); //can't fail, see above
+
+		return visiblePoints;
+	}
+	else //not enough memory
+	{
+		delete visiblePoints;
+		visiblePoints = nullptr;
+	}
+
+	return nullptr;
+}
+
+bool HPR::ComputeVisibilityCount(	CCCoreLib::GenericIndexedCloudPersist* cloud,
+									const std::vector<CCVector3d>& viewPoints,
+									double fParam,
+									std::vector<unsigned>& visibilityCount,
+									CCCoreLib::DgmOctree* octree/*=nullptr*/,
+									unsigned char octreeLevel/*=0*/,
+									CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/,
+									int maxThreadCount/*=0*/)
+{
+	if (!cloud || cloud->size() == 0 || viewPoints.empty())
+	{
+		assert(false);
+		return false;
+	}
+	if (octreeLevel != 0 && !octree)
+	{
+		assert(false);
+		return false;
+	}
+
+	unsigned pointCount = cloud->size();
+
+	//the hulls are computed on the decimated cloud (if any)
+	QScopedPointer<CCCoreLib::ReferenceCloud> cellCenters;
+	CCCoreLib::GenericIndexedCloudPersist* hullCloud = cloud;
+	//cell index for each point (only if the cloud is decimated)
+	std::vector<unsigned> pointCell;
+
+	if (octreeLevel != 0)
+	{
+		cellCenters.reset(CCCoreLib::CloudSamplingTools::subsampleCloudWithOctreeAtLevel(	cloud,
+																							octreeLevel,
+																							CCCoreLib::CloudSamplingTools::NEAREST_POINT_TO_CELL_CENTER,
+																							progressCb,
+																							octree));
+		if (!cellCenters)
+		{
+			return false;
+		}
+		hullCloud = cellCenters.data();
+
+		CCCoreLib::DgmOctree::cellIndexesContainer cellIndexes;
+		if (!octree->getCellIndexes(octreeLevel, cellIndexes) || cellIndexes.size() != cellCenters->size())
+		{
+			return false;
+		}
+
+		try
+		{
+			pointCell.resize(pointCount, 0);
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory
+			return false;
+		}
+
+		//the cell centers are ordered as the octree cells
+		CCCoreLib::ReferenceCloud Yk(octree->associatedCloud());
+		for (unsigned c = 0; c < static_cast<unsigned>(cellIndexes.size()); ++c)
+		{
+			Yk.clear(false);
+			if (!octree->getPointsInCellByCellIndex(&Yk, cellIndexes[c], octreeLevel))
+			{
+				return false;
+			}
+			for (unsigned j = 0; j < Yk.size(); ++j)
+			{
+				pointCell[Yk.getPointGlobalIndex(j)] = c;
+			}
+		}
+	}
+
+	unsigned hullPointCount = hullCloud->size();
+	unsigned viewPointCount = static_cast<unsigned>(viewPoints.size());
+
+	std::vector< std::atomic<unsigned> > hullCount;
+	std::vector<Buffers> buffers;
+	try
+	{
+		hullCount = std::vector< std::atomic<unsigned> >(hullPointCount);
+		for (std::atomic<unsigned>& count : hullCount)
+		{
+			count.store(0, std::memory_order_relaxed);
+		}
+
+		//one set of (reusable) buffers per thread
+		int threadCount = (maxThreadCount > 0 ? maxThreadCount : QThread::idealThreadCount());
+		threadCount = std::max(1, std::min(threadCount, static_cast<int>(viewPointCount)));
+		buffers.resize(threadCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+
+	CCCoreLib::NormalizedProgress nProgress(progressCb, viewPointCount);
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Hidden Point Removal");
+			progressCb->setInfo(qPrintable(QString("View points: %1\nPoints: %2").arg(viewPointCount).arg(hullPointCount)));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+
+	std::atomic<unsigned> nextViewPoint(0);
+	std::atomic<bool> error(false);
+	std::atomic<bool> canceled(false);
+
+	//the spherical flipping is done concurrently, while the qhull calls are serialized (see FlagVisiblePoints)
+	QtConcurrent::blockingMap(buffers, [&](Buffers& threadBuffers)
+	{
+		for (unsigned i = nextViewPoint++; i < viewPointCount && !error && !canceled; i = nextViewPoint++)
+		{
+			if (!FlagVisiblePoints(hullCloud, viewPoints[i], fParam, threadBuffers))
+			{
+				error = true;
+				break;
+			}
+
+			for (unsigned j = 0; j < hullPointCount; ++j)
+			{
+				if (threadBuffers.visible[j])
+				{
+					hullCount[j].fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+
+			if (progressCb && !nProgress.oneStep())
+			{
+				canceled = true;
+			}
+		}
+	});
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (error || canceled)
+	{
+		return false;
+	}
+
+	try
+	{
+		visibilityCount.resize(pointCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+
+	for (unsigned i = 0; i < pointCount; ++i)
+	{
+		visibilityCount[i] = hullCount[pointCell.empty() ? i : pointCell[i]].load(std::memory_order_relaxed);
+	}
+
+	return true;
+}
@@ -17,6 +17,8 @@
 
 #include "qHPR.h"
 #include "ccHprDlg.h"
+#include "HPR.h"
+#include "qHPRCommands.h"
 
 //Qt
 #include <QtGui>
@@ -35,12 +37,6 @@
 //CCCoreLib
 #include <CloudSamplingTools.h>
 
-//Qhull
-extern "C"
-{
-#include <qhull_a.h>
-}
-
 qHPR::qHPR(QObject* parent)
 	: QObject(parent)
 	, ccStdPluginInterface(":/CC/plugin/qHPR/info.json")
@@ -72,144 +68,14 @@ void qHPR::onNewSelection(const ccHObject::Container& selectedEntities)
 	}
 }
 
-CCCoreLib::ReferenceCloud* qHPR::removeHiddenPoints(CCCoreLib::GenericIndexedCloudPersist* theCloud, const CCVector3d& viewPoint, double fParam)
+void qHPR::registerCommands(ccCommandLineInterface* cmd)
 {
-	assert(theCloud);
-
-	unsigned nbPoints = theCloud->size();
-	if (nbPoints == 0)
-		return nullptr;
-
-	//less than 4 points? no need for calculation, we return the whole cloud
-	if (nbPoints < 4)
-	{
-		CCCoreLib::ReferenceCloud* visiblePoints = new CCCoreLib::ReferenceCloud(theCloud);
-		if (!visiblePoints->addPointIndex(0, nbPoints)) //well even for less than 4 points we never know ;)
-		{
-			//not enough memory!
-			delete visiblePoints;
-			visiblePoints = nullptr;
-		}
-		return visiblePoints;
-	}
-
-	double maxRadius = 0;
-
-	//convert point cloud to an array of double triplets (for qHull)
-	coordT* pt_array = new coordT[(nbPoints + 1) * 3];
-	{
-		coordT* _pt_array = pt_array;
-
-		for (unsigned i = 0; i < nbPoints; ++i)
-		{
-			CCVector3d P = theCloud->getPoint(i)->toDouble() - viewPoint;
-			*_pt_array++ = static_cast<coordT>(P.x);
-			*_pt_array++ = static_cast<coordT>(P.y);
-			*_pt_array++ = static_cast<coordT>(P.z);
-
-			//we keep track of the highest 'radius'
-			double r2 = P.norm2();
-			if (maxRadius < r2)
-				maxRadius = r2;
-		}
-
-		//we add the view point (Cf. HPR)
-		*_pt_array++ = 0;
-		*_pt_array++ = 0;
-		*_pt_array++ = 0;
-
-		maxRadius = sqrt(maxRadius);
-	}
-
-	//apply spherical flipping
-	{
-		maxRadius *= pow(10.0, fParam) * 2;
-
-		coordT* _pt_array = pt_array;
-		for (unsigned i = 0; i < nbPoints; ++i)
-		{
-			CCVector3d P = theCloud->getPoint(i)->toDouble() - viewPoint;
-
-			double r = (maxRadius / P.norm()) - 1.0;
-			*_pt_array++ *= r;
-			*_pt_array++ *= r;
-			*_pt_array++ *= r;
-		}
-	}
-
-	//array to flag points on the convex hull
-	std::vector<bool> pointBelongsToCvxHull;
-
-	static char qHullCommand[] = "qhull QJ Qci";
-	if (!qh_new_qhull(3, nbPoints + 1, pt_array, False, qHullCommand, nullptr, stderr))
+	if (!cmd)
 	{
-		try
-		{
-			pointBelongsToCvxHull.resize(nbPoints + 1, false);
-		}
-		catch (const std::bad_alloc&)
-		{
-			//not enough memory!
-			delete[] pt_array;
-			return nullptr;
-		}
-
-		vertexT *vertex = nullptr;
-		vertexT **vertexp = nullptr;
-		facetT *facet = nullptr;
-
-		FORALLfacets
-		{
-			//if (!facet->simplicial)
-			//	error("convhulln: non-simplicial facet"); // should never happen with QJ
-
-			setT* vertices = qh_facet3vertex(facet);
-			FOREACHvertex_(vertices)
-			{
-				pointBelongsToCvxHull[qh_pointid(vertex->point)] = true;
-			}
-			qh_settempfree(&vertices);
-		}
-	}
-
-	delete[] pt_array;
-	pt_array = nullptr;
-
-	qh_freeqhull(!qh_ALL);
-	//free long memory
-	int curlong = 0;
-	int totlong = 0;
-	qh_memfreeshort(&curlong, &totlong);
-	//free short memory and memory allocator
-
-	if (!pointBelongsToCvxHull.empty())
-	{
-		//compute the number of points belonging to the convex hull
-		unsigned cvxHullSize = 0;
-		{
-			for (unsigned i = 0; i < nbPoints; ++i)
-				if (pointBelongsToCvxHull[i])
-					++cvxHullSize;
-		}
-
-		CCCoreLib::ReferenceCloud* visiblePoints = new CCCoreLib::ReferenceCloud(theCloud);
-		if (cvxHullSize != 0 && visiblePoints->reserve(cvxHullSize))
-		{
-			for (unsigned i = 0; i < nbPoints; ++i)
-				if (pointBelongsToCvxHull[i])
-					visiblePoints->addPointIndex(i); //can't fail, see above
-
-			return visiblePoints;
-
-		}
-		else //not enough memory
-		{
-			delete visiblePoints;
-			visiblePoints = nullptr;
-		}
+		assert(false);
+		return;
 	}
-
-	return nullptr;
+	cmd->registerCommand(ccCommandLineInterface::Command::Shared(new CommandHPR));
 }
 
 void qHPR::doAction()
@@ -295,7 +161,7 @@ void qHPR::doAction()
 			return;
 		}
 
-		visibleCells.reset(removeHiddenPoints(theCellCenters.data(), viewPoint, 3.5));
+		visibleCells.reset(HPR::RemoveHiddenPoints(theCellCenters.data(), viewPoint, 3.5));
 
 		m_app->dispToConsole(QString("[HPR] Cells: %1 - Time: %2 s").arg(theCellCenters->size()).arg(eTimer.elapsed() / 1.0e3));
 
@@ -0,0 +1,128 @@
+//##########################################################################
+//#                                                                        #
+//#                                PCV                                     #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU Library General Public License as       #
+//#  published by the Free Software Foundation; version 2 or later of the License.  #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef PCV_SOFTWARE_CONTEXT_HEADER
+#define PCV_SOFTWARE_CONTEXT_HEADER
+
+//CCCoreLib
+#include <GenericCloud.h>
+#include <GenericMesh.h>
+
+//system
+#include <atomic>
+#include <vector>
+
+//! PCV (Portion de Ciel Visible / Ambiant Illumination) CPU rendering context
+/** Software (OpenGL-free) equivalent of PCVContext: renders orthographic
+	depth maps of the entity in a regular (row-major) float z-buffer and
+	flags the vertices that are visible from each direction.
+
+	The scene (centered and scaled vertices + triangle indexes) is shared
+	by all the rendering buffers so that several light directions can be
+	processed concurrently (one RenderBuffer per thread).
+**/
+class PCVSoftwareContext
+{
+	public:
+		//! Default constructor
+		PCVSoftwareContext();
+
+		//! Per-thread rendering buffers
+		struct RenderBuffer
+		{
+			//! Depth buffer (normalized depth, 1 = far plane)
+			std::vector<float> depth;
+			//! Coverage buffer (only for non closed meshes)
+			std::vector<unsigned char> coverage;
+		};
+
+		//! Initialization
+		/** \param W render context width (pixels)
+			\param H render context height (pixels)
+			\param cloud associated cloud (or mesh vertices)
+			\param mesh associated mesh (if any)
+			\param closedMesh whether mesh is closed (faster) or not (need more memory)
+			\return initialization success
+		**/
+		bool init(	unsigned W,
+					unsigned H,
+					CCCoreLib::GenericCloud* cloud,
+					CCCoreLib::GenericMesh* mesh = nullptr,
+					bool closedMesh = true);
+
+		//! Allocates a rendering buffer (one per concurrent thread)
+		bool initBuffer(RenderBuffer& buffer) const;
+
+		//! Renders the entity along a given direction and increments the visibility counter of the viewed vertices
+		/** Thread-safe as long as each thread uses its own buffer.
+			\param V viewing ('light') direction
+			\param buffer rendering buffer (see initBuffer)
+			\param visibilityCount per-vertex visibility count (same size as the number of vertices)
+			\return number of vertices seen during this pass (or -1 if an error occurred)
+		**/
+		int accumPixel(	const CCVector3& V,
+						RenderBuffer& buffer,
+						std::vector< std::atomic<int> >& visibilityCount) const;
+
+		//! Returns the number of vertices
+		inline unsigned vertexCount() const { return m_vertexCount; }
+
+	protected:
+
+		//! Orthographic viewing frame (already scaled)
+		struct ViewFrame
+		{
+			CCVector3 s; //!< horizontal axis
+			CCVector3 u; //!< vertical axis
+			CCVector3 f; //!< viewing direction (depth)
+		};
+
+		//! Computes the viewing frame (equivalent to gluLookAt)
+		static ViewFrame GetViewFrame(const CCVector3& V);
+
+		//! Rasterizes a triangle in the depth buffer (both faces if 'cullBackFaces' is false)
+		void rasterTriangle(const CCVector3& A,
+							const CCVector3& B,
+							const CCVector3& C,
+							bool cullBackFaces,
+							RenderBuffer& buffer) const;
+
+		//! Vertices (centered and scaled so as to fit in the render context)
+		/** The first 'm_vertexCount' ones are the entity vertices. The
+			others (if any) are the corners of non-indexed triangles.
+		**/
+		std::vector<CCVector3> m_vertices;
+
+		//! Number of entity vertices
+		unsigned m_vertexCount;
+
+		//! Triangles (vertex indexes)
+		std::vector<unsigned> m_triangles;
+
+		//! Render context width (pixels)
+		unsigned m_width;
+		//! Render context height (pixels)
+		unsigned m_height;
+
+		//! Depth range half-extent (same as PCVContext's orthographic projection)
+		float m_maxD;
+
+		//! Whether displayed mesh is closed or not
+		bool m_meshIsClosed;
+};
+
+#endif
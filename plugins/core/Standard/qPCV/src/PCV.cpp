@@ -18,12 +18,16 @@
 
 #include "PCV.h"
 #include "PCVContext.h"
+#include "PCVSoftwareContext.h"
 
 //Qt
 #include <QString>
+#include <QThread>
+#include <QtConcurrentMap>
 
 //System
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstring>
 
@@ -170,6 +174,94 @@ static bool SampleSphere(unsigned N, std::vector<CCVector3>& dirs)
 	return true;
 }
 
+//! CPU (multi-threaded) version of the main illumination loop
+/** Each thread renders its own light directions in its own rendering buffer,
+	while the visibility counters are shared (atomic).
+**/
+static bool SoftwareAccumPixels(const std::vector<CCVector3>& rays,
+								GenericCloud* vertices,
+								GenericMesh* mesh,
+								bool meshIsClosed,
+								unsigned width,
+								unsigned height,
+								NormalizedProgress* nProgress,
+								std::vector<int>& visibilityCount)
+{
+	PCVSoftwareContext context;
+	if (!context.init(width, height, vertices, mesh, meshIsClosed))
+	{
+		return false;
+	}
+
+	unsigned numberOfPoints = context.vertexCount();
+	unsigned numberOfRays = static_cast<unsigned>(rays.size());
+	assert(visibilityCount.size() == numberOfPoints);
+
+	std::vector< std::atomic<int> > sharedCount;
+	std::vector<PCVSoftwareContext::RenderBuffer> buffers;
+	try
+	{
+		sharedCount = std::vector< std::atomic<int> >(numberOfPoints);
+		for (std::atomic<int>& count : sharedCount)
+		{
+			count.store(0, std::memory_order_relaxed);
+		}
+
+		//one rendering buffer per thread (as long as there's enough memory)
+		int threadCount = std::max(1, std::min(QThread::idealThreadCount(), static_cast<int>(numberOfRays)));
+		buffers.reserve(threadCount);
+		for (int i = 0; i < threadCount; ++i)
+		{
+			PCVSoftwareContext::RenderBuffer buffer;
+			if (!context.initBuffer(buffer))
+			{
+				break;
+			}
+			buffers.push_back(std::move(buffer));
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+
+	if (buffers.empty())
+	{
+		//not enough memory
+		return false;
+	}
+
+	std::atomic<unsigned> nextRay(0);
+	std::atomic<bool> canceled(false);
+
+	QtConcurrent::blockingMap(buffers, [&](PCVSoftwareContext::RenderBuffer& buffer)
+	{
+		for (unsigned i = nextRay++; i < numberOfRays && !canceled; i = nextRay++)
+		{
+			//set current 'light' direction and flag viewed vertices
+			context.accumPixel(rays[i], buffer, sharedCount);
+
+			if (nProgress && !nProgress->oneStep())
+			{
+				canceled = true;
+			}
+		}
+	});
+
+	if (canceled)
+	{
+		return false;
+	}
+
+	for (unsigned j = 0; j < numberOfPoints; ++j)
+	{
+		visibilityCount[j] = sharedCount[j].load(std::memory_order_relaxed);
+	}
+
+	return true;
+}
+
 bool PCV::GenerateRays(unsigned numberOfRays, std::vector<CCVector3>& rays, bool mode360/*=true*/)
 {
 	//generates light directions
@@ -209,7 +301,8 @@ int PCV::Launch(unsigned numberOfRays,
 				unsigned width/*=1024*/,
 				unsigned height/*=1024*/,
 				CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/,
-				const QString& entityName/*=QString()*/)
+				const QString& entityName/*=QString()*/,
+				bool softwareRendering/*=false*/)
 {
 	//generates light directions
 	std::vector<CCVector3> rays;
@@ -218,7 +311,7 @@ int PCV::Launch(unsigned numberOfRays,
 		return -2;
 	}
 
-	if (!Launch(rays, vertices, mesh, meshIsClosed, width, height, progressCb, entityName))
+	if (!Launch(rays, vertices, mesh, meshIsClosed, width, height, progressCb, entityName, softwareRendering))
 	{
 		return -1;
 	}
@@ -233,7 +326,8 @@ bool PCV::Launch(const std::vector<CCVector3>& rays,
 				 unsigned width/*=1024*/,
 				 unsigned height/*=1024*/,
 				 CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/,
-				 const QString& entityName/*=QString()*/)
+				 const QString& entityName/*=QString()*/,
+				 bool softwareRendering/*=false*/)
 {
 	if (rays.empty())
 		return false;
@@ -282,38 +376,45 @@ bool PCV::Launch(const std::vector<CCVector3>& rays,
 
 	bool success = true;
 
-	//must be done after progress dialog display!
-	PCVContext win;
-	if (win.init(width, height, vertices, mesh, meshIsClosed))
+	if (softwareRendering)
 	{
-		for (unsigned i = 0; i < numberOfRays; ++i)
+		success = SoftwareAccumPixels(rays, vertices, mesh, meshIsClosed, width, height, progressCb ? &nProgress : nullptr, visibilityCount);
+	}
+	else
+	{
+		//must be done after progress dialog display!
+		PCVContext win;
+		if (win.init(width, height, vertices, mesh, meshIsClosed))
 		{
-			//set current 'light' direction
-			win.setViewDirection(rays[i]);
+			for (unsigned i = 0; i < numberOfRays; ++i)
+			{
+				//set current 'light' direction
+				win.setViewDirection(rays[i]);
 
-			//flag viewed vertices
-			win.GLAccumPixel(visibilityCount);
+				//flag viewed vertices
+				win.GLAccumPixel(visibilityCount);
 
-			if (progressCb && !nProgress.oneStep())
-			{
-				success = false;
-				break;
+				if (progressCb && !nProgress.oneStep())
+				{
+					success = false;
+					break;
+				}
 			}
 		}
-
-		if (success)
+		else
 		{
-			//we convert per-vertex accumulators to an 'intensity' scalar field
-			for (unsigned j = 0; j < numberOfPoints; ++j)
-			{
-				ScalarType visValue = static_cast<ScalarType>(visibilityCount[j]) / numberOfRays;
-				vertices->setPointScalarValue(j, visValue);
-			}
+			success = false;
 		}
 	}
-	else
+
+	if (success)
 	{
-		success = false;
+		//we convert per-vertex accumulators to an 'intensity' scalar field
+		for (unsigned j = 0; j < numberOfPoints; ++j)
+		{
+			ScalarType visValue = static_cast<ScalarType>(visibilityCount[j]) / numberOfRays;
+			vertices->setPointScalarValue(j, visValue);
+		}
 	}
 
 	return success;
@@ -17,6 +17,7 @@ constexpr char COMMAND_PCV_N_RAYS[] = "N_RAYS";
 constexpr char COMMAND_PCV_IS_CLOSED[] = "IS_CLOSED";
 constexpr char COMMAND_PCV_180[] = "180";
 constexpr char COMMAND_PCV_RESOLUTION[] = "RESOLUTION";
+constexpr char COMMAND_PCV_CPU[] = "CPU";
 
 PCVCommand::PCVCommand()
 	: Command("PCV", COMMAND_PCV)
@@ -28,7 +29,8 @@ bool PCVCommand::Process(	const ccHObject::Container& candidates,
 							bool meshIsClosed,
 							unsigned resolution,
 							ccProgressDialog* progressDlg/*=nullptr*/,
-							ccMainAppInterface* app/*=nullptr*/)
+							ccMainAppInterface* app/*=nullptr*/,
+							bool softwareRendering/*=false*/)
 {
 	size_t count = 0;
 	size_t errorCount = 0;
@@ -89,7 +91,7 @@ bool PCVCommand::Process(	const ccHObject::Container& candidates,
 		bool wasVisible = obj->isVisible();
 		obj->setEnabled(true);
 		obj->setVisible(true);
-		bool success = PCV::Launch(rays, cloud, mesh, meshIsClosed, resolution, resolution, progressDlg, objNameForPorgressDialog);
+		bool success = PCV::Launch(rays, cloud, mesh, meshIsClosed, resolution, resolution, progressDlg, objNameForPorgressDialog, softwareRendering);
 		obj->setEnabled(wasEnabled);
 		obj->setVisible(wasVisible);
 
@@ -153,6 +155,7 @@ bool PCVCommand::process(ccCommandLineInterface& cmd)
 	bool meshIsClosed = false;
 	bool mode360 = true;
 	unsigned resolution = 1024;
+	bool softwareRendering = false;
 
 	while (!cmd.arguments().empty())
 	{
@@ -170,6 +173,12 @@ bool PCVCommand::process(ccCommandLineInterface& cmd)
 			cmd.arguments().pop_front();
 			mode360 = false;
 		}
+		// CPU (multi-threaded) rendering, i.e. no OpenGL context required
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_PCV_CPU))
+		{
+			cmd.arguments().pop_front();
+			softwareRendering = true;
+		}
 		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_PCV_N_RAYS))
 		{
 			cmd.arguments().pop_front();
@@ -221,7 +230,7 @@ bool PCVCommand::process(ccCommandLineInterface& cmd)
 	for (CLMeshDesc& desc : cmd.meshes())
 		candidates.push_back(desc.mesh);
 
-	if (!Process(candidates, rays, meshIsClosed, resolution, &pcvProgressCb, nullptr))
+	if (!Process(candidates, rays, meshIsClosed, resolution, &pcvProgressCb, nullptr, softwareRendering))
 	{
 		return cmd.error(QObject::tr("Process failed"));
 	}
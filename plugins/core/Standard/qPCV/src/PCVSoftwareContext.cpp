@@ -0,0 +1,355 @@
+//##########################################################################
+//#                                                                        #
+//#                                PCV                                     #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU Library General Public License as       #
+//#  published by the Free Software Foundation; version 2 or later of the License.  #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#include "PCVSoftwareContext.h"
+
+//CCCoreLib
+#include <CCMath.h>
+#include <GenericIndexedMesh.h>
+#include <GenericTriangle.h>
+
+//system
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace CCCoreLib;
+
+//same depth offset as the OpenGL context (see PCVContext.cpp)
+#ifndef ZTWIST
+#define ZTWIST 1e-3f
+#endif
+
+PCVSoftwareContext::PCVSoftwareContext()
+	: m_vertexCount(0)
+	, m_width(0)
+	, m_height(0)
+	, m_maxD(1.0f)
+	, m_meshIsClosed(false)
+{
+}
+
+bool PCVSoftwareContext::init(	unsigned W,
+								unsigned H,
+								CCCoreLib::GenericCloud* cloud,
+								CCCoreLib::GenericMesh* mesh/*=nullptr*/,
+								bool closedMesh/*=true*/)
+{
+	if (!cloud || W == 0 || H == 0)
+	{
+		assert(false);
+		return false;
+	}
+
+	m_width = W;
+	m_height = H;
+	m_maxD = static_cast<float>(std::max(W, H));
+	m_meshIsClosed = (closedMesh || !mesh);
+
+	//same default zoom and center as the OpenGL context
+	CCVector3 bbMin;
+	CCVector3 bbMax;
+	cloud->getBoundingBox(bbMin, bbMax);
+	PointCoordinateType maxD = (bbMax - bbMin).norm();
+	PointCoordinateType zoom = (CCCoreLib::GreaterThanEpsilon(maxD) ? static_cast<PointCoordinateType>(std::min(W, H)) / maxD : CCCoreLib::PC_ONE);
+	CCVector3 viewCenter = (bbMax + bbMin) / 2;
+
+	CCCoreLib::GenericIndexedMesh* indexedMesh = dynamic_cast<CCCoreLib::GenericIndexedMesh*>(mesh);
+
+	try
+	{
+		m_vertexCount = cloud->size();
+		m_vertices.clear();
+		m_vertices.reserve(m_vertexCount + (mesh && !indexedMesh ? 3 * mesh->size() : 0));
+		m_triangles.clear();
+
+		cloud->placeIteratorAtBeginning();
+		for (unsigned i = 0; i < m_vertexCount; ++i)
+		{
+			m_vertices.push_back((*cloud->getNextPoint() - viewCenter) * zoom);
+		}
+
+		if (mesh)
+		{
+			unsigned triCount = mesh->size();
+			m_triangles.resize(3 * static_cast<size_t>(triCount));
+
+			if (indexedMesh)
+			{
+				for (unsigned i = 0; i < triCount; ++i)
+				{
+					const CCCoreLib::VerticesIndexes* tsi = indexedMesh->getTriangleVertIndexes(i);
+					m_triangles[3 * i    ] = tsi->i1;
+					m_triangles[3 * i + 1] = tsi->i2;
+					m_triangles[3 * i + 2] = tsi->i3;
+				}
+			}
+			else
+			{
+				//we can't retrieve the vertex indexes: we duplicate the triangle corners
+				mesh->placeIteratorAtBeginning();
+				for (unsigned i = 0; i < triCount; ++i)
+				{
+					const GenericTriangle* t = mesh->_getNextTriangle();
+					for (unsigned j = 0; j < 3; ++j)
+					{
+						const CCVector3* P = (j == 0 ? t->_getA() : j == 1 ? t->_getB() : t->_getC());
+						m_triangles[3 * i + j] = static_cast<unsigned>(m_vertices.size());
+						m_vertices.push_back((*P - viewCenter) * zoom);
+					}
+				}
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		m_vertices.clear();
+		m_triangles.clear();
+		m_vertexCount = 0;
+		return false;
+	}
+
+	return true;
+}
+
+bool PCVSoftwareContext::initBuffer(RenderBuffer& buffer) const
+{
+	size_t size = static_cast<size_t>(m_width) * m_height;
+	try
+	{
+		buffer.depth.resize(size);
+		if (!m_meshIsClosed)
+		{
+			buffer.coverage.resize(size);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		buffer.depth.clear();
+		buffer.coverage.clear();
+		return false;
+	}
+
+	return true;
+}
+
+PCVSoftwareContext::ViewFrame PCVSoftwareContext::GetViewFrame(const CCVector3& V)
+{
+	//same as PCVContext::setViewDirection (gluLookAt)
+	CCVector3 U(0, 0, 1);
+	if (1 - std::abs(V.dot(U)) < 1.0e-4)
+	{
+		U.y = 1;
+		U.z = 0;
+	}
+
+	ViewFrame frame;
+	frame.f = V;
+	frame.f.normalize();
+	frame.s = frame.f.cross(U);
+	frame.s.normalize();
+	frame.u = frame.s.cross(frame.f);
+
+	return frame;
+}
+
+void PCVSoftwareContext::rasterTriangle(const CCVector3& A,
+										const CCVector3& B,
+										const CCVector3& C,
+										bool cullBackFaces,
+										RenderBuffer& buffer) const
+{
+	//signed area (in window coordinates): > 0 for front (CCW) faces
+	float area = (B.x - A.x) * (C.y - A.y) - (B.y - A.y) * (C.x - A.x);
+	if (area == 0 || (cullBackFaces && area < 0))
+	{
+		return;
+	}
+
+	//bounding box (pixel centers are at +0.5)
+	int xMin = std::max(0, static_cast<int>(std::ceil(std::min(A.x, std::min(B.x, C.x)) - 0.5f)));
+	int xMax = std::min(static_cast<int>(m_width) - 1, static_cast<int>(std::floor(std::max(A.x, std::max(B.x, C.x)) - 0.5f)));
+	int yMin = std::max(0, static_cast<int>(std::ceil(std::min(A.y, std::min(B.y, C.y)) - 0.5f)));
+	int yMax = std::min(static_cast<int>(m_height) - 1, static_cast<int>(std::floor(std::max(A.y, std::max(B.y, C.y)) - 0.5f)));
+	if (xMin > xMax || yMin > yMax)
+	{
+		return;
+	}
+
+	//edge functions (normalized so that they sum to 1 inside the triangle)
+	float invArea = 1.0f / area;
+	float a0 = (B.y - C.y) * invArea, b0 = (C.x - B.x) * invArea, c0 = (B.x * C.y - B.y * C.x) * invArea;
+	float a1 = (C.y - A.y) * invArea, b1 = (A.x - C.x) * invArea, c1 = (C.x * A.y - C.y * A.x) * invArea;
+	float a2 = (A.y - B.y) * invArea, b2 = (B.x - A.x) * invArea, c2 = (A.x * B.y - A.y * B.x) * invArea;
+
+	//depth is linear in window coordinates (orthographic projection)
+	float za = a0 * A.z + a1 * B.z + a2 * C.z;
+	float zb = b0 * A.z + b1 * B.z + b2 * C.z;
+	float zc = c0 * A.z + c1 * B.z + c2 * C.z;
+
+	bool withCoverage = !buffer.coverage.empty();
+
+	for (int y = yMin; y <= yMax; ++y)
+	{
+		float py = y + 0.5f;
+		float* depthRow = buffer.depth.data() + static_cast<size_t>(y) * m_width;
+		unsigned char* coverageRow = (withCoverage ? buffer.coverage.data() + static_cast<size_t>(y) * m_width : nullptr);
+
+		for (int x = xMin; x <= xMax; ++x)
+		{
+			float px = x + 0.5f;
+			float w0 = a0 * px + b0 * py + c0;
+			float w1 = a1 * px + b1 * py + c1;
+			float w2 = a2 * px + b2 * py + c2;
+			if (w0 >= 0 && w1 >= 0 && w2 >= 0)
+			{
+				float z = za * px + zb * py + zc;
+				if (z < depthRow[x])
+				{
+					depthRow[x] = z;
+				}
+				if (coverageRow)
+				{
+					coverageRow[x] = 1;
+				}
+			}
+		}
+	}
+}
+
+//The method below mimics PCVContext::GLAccumPixel (itself inspired from ShadeVis' "GLAccumPixel" by Cignoni et al.)
+int PCVSoftwareContext::accumPixel(	const CCVector3& V,
+									RenderBuffer& buffer,
+									std::vector< std::atomic<int> >& visibilityCount) const
+{
+	if (visibilityCount.size() != m_vertexCount)
+		return -1;
+	if (buffer.depth.size() != static_cast<size_t>(m_width) * m_height)
+		return -1;
+
+	const ViewFrame frame = GetViewFrame(V);
+
+	//the eye is placed at -V (see PCVContext::setViewDirection)
+	const float eyeDist = static_cast<float>(V.norm());
+	const float w2 = 0.5f * m_width;
+	const float h2 = 0.5f * m_height;
+	const float invMaxD = 1.0f / m_maxD;
+
+	//projection in window coordinates (x, y in pixels, z = normalized depth in [0 ; 1])
+	auto project = [&](const CCVector3& P) -> CCVector3
+	{
+		return CCVector3(	static_cast<PointCoordinateType>(frame.s.dot(P) + w2),
+							static_cast<PointCoordinateType>(frame.u.dot(P) + h2),
+							static_cast<PointCoordinateType>(0.5f * ((frame.f.dot(P) + eyeDist) * invMaxD + 1.0f)));
+	};
+
+	//depth range used for rendering the entity (see GLAccumPixel)
+	static const float c_renderDepthMin = 2.0f * ZTWIST;
+	//depth range used for projecting the vertices (see GLAccumPixel)
+	static const float c_testDepthMax = 1.0f - 2.0f * ZTWIST;
+
+	std::fill(buffer.depth.begin(), buffer.depth.end(), 1.0f);
+	if (!buffer.coverage.empty())
+	{
+		std::fill(buffer.coverage.begin(), buffer.coverage.end(), static_cast<unsigned char>(0));
+	}
+
+	//render the entity
+	if (!m_triangles.empty())
+	{
+		size_t triCount = m_triangles.size() / 3;
+		for (size_t i = 0; i < triCount; ++i)
+		{
+			CCVector3 A = project(m_vertices[m_triangles[3 * i    ]]);
+			CCVector3 B = project(m_vertices[m_triangles[3 * i + 1]]);
+			CCVector3 C = project(m_vertices[m_triangles[3 * i + 2]]);
+
+			//triangles crossing the near/far planes are clipped (as OpenGL would roughly do)
+			if (A.z < 0 || A.z > 1 || B.z < 0 || B.z > 1 || C.z < 0 || C.z > 1)
+				continue;
+
+			A.z = c_renderDepthMin + (1.0f - c_renderDepthMin) * A.z;
+			B.z = c_renderDepthMin + (1.0f - c_renderDepthMin) * B.z;
+			C.z = c_renderDepthMin + (1.0f - c_renderDepthMin) * C.z;
+
+			//for non closed meshes, both faces are displayed
+			rasterTriangle(A, B, C, m_meshIsClosed, buffer);
+		}
+	}
+	else
+	{
+		for (unsigned i = 0; i < m_vertexCount; ++i)
+		{
+			CCVector3 Q = project(m_vertices[i]);
+			int xi = static_cast<int>(std::floor(Q.x));
+			int yi = static_cast<int>(std::floor(Q.y));
+			if (	xi >= 0 && xi < static_cast<int>(m_width)
+				&&	yi >= 0 && yi < static_cast<int>(m_height)
+				&&	Q.z >= 0 && Q.z <= 1)
+			{
+				float z = c_renderDepthMin + (1.0f - c_renderDepthMin) * static_cast<float>(Q.z);
+				float& depth = buffer.depth[xi + static_cast<size_t>(yi) * m_width];
+				if (z < depth)
+				{
+					depth = z;
+				}
+			}
+		}
+	}
+
+	//flag the visible vertices
+	int count = 0;
+	for (unsigned i = 0; i < m_vertexCount; ++i)
+	{
+		CCVector3 Q = project(m_vertices[i]);
+
+		int txi = static_cast<int>(std::floor(Q.x));
+		int tyi = static_cast<int>(std::floor(Q.y));
+		if (	txi < 0 || txi >= static_cast<int>(m_width)
+			||	tyi < 0 || tyi >= static_cast<int>(m_height))
+		{
+			continue;
+		}
+
+		size_t dec = txi + static_cast<size_t>(tyi) * m_width;
+
+		if (!m_meshIsClosed)
+		{
+			//we look at the 2x2 neighborhood (as ShadeVis does)
+			int txi1 = std::min(txi + 1, static_cast<int>(m_width) - 1);
+			int tyi1 = std::min(tyi + 1, static_cast<int>(m_height) - 1);
+			const unsigned char* cov = buffer.coverage.data();
+			if (	!cov[dec]
+				&&	!cov[txi1 + static_cast<size_t>(tyi) * m_width]
+				&&	!cov[txi + static_cast<size_t>(tyi1) * m_width]
+				&&	!cov[txi1 + static_cast<size_t>(tyi1) * m_width])
+			{
+				continue;
+			}
+		}
+
+		if (c_testDepthMax * static_cast<float>(Q.z) < buffer.depth[dec])
+		{
+			visibilityCount[i].fetch_add(1, std::memory_order_relaxed);
+			++count;
+		}
+	}
+
+	return count;
+}
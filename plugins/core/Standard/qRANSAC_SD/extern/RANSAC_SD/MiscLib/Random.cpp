@@ -6,6 +6,7 @@
  *
  */
 #include <stdio.h>
+#include <time.h>
 #include "Random.h"
 #define register 
 using namespace MiscLib;
@@ -19,11 +20,14 @@ using namespace MiscLib;
 #define is_odd(x)     ( (x) & 1 )
 #define evenize(x)    ( (x) & (MM-2) )
 
-size_t MiscLib::rn_buf[MiscLib_RN_BUFSIZE];
-size_t MiscLib::rn_point = MiscLib_RN_BUFSIZE;
+thread_local size_t MiscLib::rn_buf[MiscLib_RN_BUFSIZE];
+thread_local size_t MiscLib::rn_point = MiscLib_RN_BUFSIZE;
+//the sequence of each thread is seeded on its first use if rn_setseed hasn't been called by this thread
+static thread_local bool rn_seeded = false;
 
 void MiscLib::rn_setseed(size_t seed)
 {
+  rn_seeded = true;
   register int t, j;
   size_t x[KK+KK-1];
   register size_t ss = evenize(seed+2);
@@ -59,6 +63,11 @@ size_t MiscLib::rn_refresh()
 /* You remember Duff's device? If it would help then it should be used here */
   rn_point=1;
 
+  if (!rn_seeded) {
+    //the address of the buffer is specific to each thread
+    rn_setseed((size_t)time(NULL) ^ (size_t)rn_buf);
+  }
+
   register int i, j;
   for (j=KK;j<MiscLib_RN_BUFSIZE;j++) 
     rn_buf[j]=mod_diff(rn_buf[j-KK],rn_buf[j-LL]);
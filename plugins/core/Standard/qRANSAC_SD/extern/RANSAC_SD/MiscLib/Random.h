@@ -13,8 +13,10 @@
 
 namespace MiscLib
 {
-	extern size_t rn_buf[];
-	extern size_t rn_point;
+	//one sequence per thread (so that several detections can run concurrently),
+	//seeded on its first use if rn_setseed hasn't been called by the thread
+	extern thread_local size_t rn_buf[];
+	extern thread_local size_t rn_point;
 	void rn_setseed(size_t);
 	size_t rn_refresh(void);
 	inline size_t rn_rand()
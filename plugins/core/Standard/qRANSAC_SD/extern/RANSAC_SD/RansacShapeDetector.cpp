@@ -25,6 +25,8 @@ RansacShapeDetector::RansacShapeDetector()
 : m_maxCandTries(20)
 , m_reqSamples(0)
 , m_autoAcceptSize(0)
+, m_seed(0)
+, m_hasSeed(false)
 {}
 
 RansacShapeDetector::RansacShapeDetector(const Options &options)
@@ -32,6 +34,8 @@ RansacShapeDetector::RansacShapeDetector(const Options &options)
 , m_maxCandTries(20)
 , m_reqSamples(0)
 , m_autoAcceptSize(0)
+, m_seed(0)
+, m_hasSeed(false)
 {}
 
 RansacShapeDetector::~RansacShapeDetector()
@@ -460,7 +464,7 @@ RansacShapeDetector::Detect(PointCloud &pc, size_t beginIdx, size_t endIdx,
 	 * Initialization part
 	 */
 	srand((unsigned int)time(NULL));
-	rn_setseed((size_t)time(NULL));
+	rn_setseed(m_hasSeed ? m_seed : (size_t)time(NULL));
 
 	CandidatesType candidates;
 
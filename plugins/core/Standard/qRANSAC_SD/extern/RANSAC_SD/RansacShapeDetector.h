@@ -45,6 +45,8 @@ class DLL_LINKAGE RansacShapeDetector
 			MiscLib::Vector< std::pair< MiscLib::RefCountPtr< PrimitiveShape >, size_t > > *shapes);
 		void AutoAcceptSize(size_t s) { m_autoAcceptSize = s; }
 		size_t AutoAcceptSize() const { return m_autoAcceptSize; }
+		//sets the seed of the random sequence used by Detect (the current time by default)
+		void Seed(size_t s) { m_seed = s; m_hasSeed = true; }
 		const Options &GetOptions() const { return m_options; }
 
 	private:
@@ -103,6 +105,8 @@ class DLL_LINKAGE RansacShapeDetector
 		size_t m_maxCandTries;
 		size_t m_reqSamples;
 		size_t m_autoAcceptSize;
+		size_t m_seed;
+		bool m_hasSeed;
 };
 
 #endif
@@ -67,6 +67,9 @@ public:
 		float minTorusMajorRadius;
 		float maxTorusMinorRadius;
 		float maxTorusMajorRadius;
+		bool partitioned; // whether the cloud should be split into overlapping cells processed in parallel
+		float partitionCellSize; // size of the partition cells (0 = automatic)
+		int maxThreadCount; // max number of threads for the partitioned mode (0 = ideal thread count)
 
 		RansacParams() : epsilon(0.005f)
 			, bitmapEpsilon(0.001f)
@@ -89,6 +92,9 @@ public:
 			, minTorusMajorRadius(0)
 			, maxTorusMinorRadius(std::numeric_limits<float>::max())
 			, maxTorusMajorRadius(std::numeric_limits<float>::max())
+			, partitioned(false)
+			, partitionCellSize(0)
+			, maxThreadCount(0)
 		{
 			primEnabled[RPT_PLANE] = true;
 			primEnabled[RPT_SPHERE] = true;
@@ -118,6 +124,9 @@ public:
 			, minTorusMajorRadius(0)
 			, maxTorusMinorRadius(std::numeric_limits<float>::max())
 			, maxTorusMajorRadius(std::numeric_limits<float>::max())
+			, partitioned(false)
+			, partitionCellSize(0)
+			, maxThreadCount(0)
 		{
 			primEnabled[RPT_PLANE] = true;
 			primEnabled[RPT_SPHERE] = true;
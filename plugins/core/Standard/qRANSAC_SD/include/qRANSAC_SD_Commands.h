@@ -46,6 +46,9 @@ constexpr char OUTPUT_INDIVIDUAL_PRIMITIVES[] = "OUTPUT_INDIVIDUAL_PRIMITIVES";
 constexpr char OUTPUT_INDIVIDUAL_SUBCLOUDS[] = "OUTPUT_INDIVIDUAL_SUBCLOUDS";
 constexpr char OUTPUT_INDIVIDUAL_PAIRED_CLOUD_PRIMITIVE[] = "OUTPUT_INDIVIDUAL_PAIRED_CLOUD_PRIMITIVE";
 constexpr char OUTPUT_GROUPED[] = "OUTPUT_GROUPED";
+constexpr char PARTITIONED[] = "PARTITIONED";
+constexpr char PARTITION_CELL_SIZE[] = "PARTITION_CELL_SIZE";
+constexpr char MAX_THREAD_COUNT[] = "MAX_THREAD_COUNT";
 
 constexpr char PRIM_PLANE[] = "PLANE";
 constexpr char PRIM_SPHERE[] = "SPHERE";
@@ -69,7 +72,8 @@ struct CommandRANSAC : public ccCommandLineInterface::Command
 			BITMAP_EPSILON_PERCENTAGE_OF_SCALE << BITMAP_EPSILON_ABSOLUTE <<
 			SUPPORT_POINTS << MAX_NORMAL_DEV << PROBABILITY << ENABLE_PRIMITIVE <<
 			OUT_CLOUD_DIR << OUT_MESH_DIR << OUT_GROUP_DIR << OUT_PAIR_DIR << OUT_RANDOM_COLOR << OUTPUT_INDIVIDUAL_PRIMITIVES <<
-			OUTPUT_INDIVIDUAL_SUBCLOUDS << OUTPUT_GROUPED << OUTPUT_INDIVIDUAL_PAIRED_CLOUD_PRIMITIVE;
+			OUTPUT_INDIVIDUAL_SUBCLOUDS << OUTPUT_GROUPED << OUTPUT_INDIVIDUAL_PAIRED_CLOUD_PRIMITIVE <<
+			PARTITIONED << PARTITION_CELL_SIZE << MAX_THREAD_COUNT;
 		QStringList primitiveNames = QStringList() << PRIM_PLANE << PRIM_SPHERE << PRIM_CYLINDER << PRIM_CONE << PRIM_TORUS;
 		QString outputCloudsDir;
 		QString outputMeshesDir;
@@ -209,6 +213,41 @@ struct CommandRANSAC : public ccCommandLineInterface::Command
 				{
 					params.randomColor = true;
 				}
+				else if (param == PARTITIONED)
+				{
+					params.partitioned = true;
+				}
+				else if (param == PARTITION_CELL_SIZE)
+				{
+					if (cmd.arguments().empty())
+					{
+						return cmd.error(QObject::tr("Missing parameter: number after \"-%1 %2\"").arg(COMMAND_RANSAC, PARTITION_CELL_SIZE));
+					}
+					bool ok;
+					float val = cmd.arguments().takeFirst().toFloat(&ok);
+					if (!ok || val < 0.0f)
+					{
+						return cmd.error("Invalid number for partition cell size (0 = automatic)!");
+					}
+					cmd.print(QObject::tr("\tPartition cell size : %1").arg(val));
+					params.partitioned = true;
+					params.partitionCellSize = val;
+				}
+				else if (param == MAX_THREAD_COUNT)
+				{
+					if (cmd.arguments().empty())
+					{
+						return cmd.error(QObject::tr("Missing parameter: number after \"-%1 %2\"").arg(COMMAND_RANSAC, MAX_THREAD_COUNT));
+					}
+					bool ok;
+					int val = cmd.arguments().takeFirst().toInt(&ok);
+					if (!ok || val < 0)
+					{
+						return cmd.error("Invalid number for max thread count!");
+					}
+					cmd.print(QObject::tr("\tMax thread count : %1").arg(val));
+					params.maxThreadCount = val;
+				}
 				else if (param == OUT_CLOUD_DIR)
 				{
 					if (!makePathIfPossible(cmd, param, &outputCloudsDir, &outputIndividualClouds))
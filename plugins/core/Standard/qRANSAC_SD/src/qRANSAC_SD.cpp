@@ -37,9 +37,12 @@
 //Qt
 #include <QtGui>
 #include <QApplication>
+#include <QtConcurrentMap>
 #include <QtConcurrentRun>
 #include <QApplication>
 #include <QMainWindow>
+#include <QThread>
+#include <QThreadPool>
 
 //qCC_db
 #include <ccGenericPointCloud.h>
@@ -58,6 +61,9 @@
 
 //System
 #include <algorithm>
+#include <atomic>
+#include <set>
+#include <vector>
 #if defined(CC_WINDOWS)
 #include "windows.h"
 #else
@@ -105,7 +111,9 @@ void qRansacSD::registerCommands(ccCommandLineInterface* cmd)
 	cmd->registerCommand(ccCommandLineInterface::Command::Shared(new CommandRANSAC));
 }
 
-static MiscLib::Vector< std::pair< MiscLib::RefCountPtr< PrimitiveShape >, size_t > >* s_shapes; // stores the detected shapes
+typedef std::pair< MiscLib::RefCountPtr< PrimitiveShape >, size_t > DetectedShape;
+
+static MiscLib::Vector< DetectedShape >* s_shapes; // stores the detected shapes
 static size_t s_remainingPoints = 0;
 static RansacShapeDetector* s_detector = 0;
 static PointCloud* s_cloud = 0;
@@ -117,6 +125,249 @@ void doDetection()
 	s_remainingPoints = s_detector->Detect(*s_cloud, 0, s_cloud->size(), s_shapes);
 }
 
+//! Adds the constructors of the enabled primitive types to a detector
+static void AddShapeConstructors(RansacShapeDetector& detector, const qRansacSD::RansacParams& params)
+{
+	if (params.primEnabled[qRansacSD::RPT_PLANE])
+		detector.Add(new PlanePrimitiveShapeConstructor());
+	if (params.primEnabled[qRansacSD::RPT_SPHERE])
+		detector.Add(new SpherePrimitiveShapeConstructor(params.minSphereRadius, params.maxSphereRadius));
+	if (params.primEnabled[qRansacSD::RPT_CYLINDER])
+		detector.Add(new CylinderPrimitiveShapeConstructor(params.minCylinderRadius, params.maxCylinderRadius, params.maxCylinderLength));
+	if (params.primEnabled[qRansacSD::RPT_CONE])
+		detector.Add(new ConePrimitiveShapeConstructor(params.maxConeRadius, CCCoreLib::DegreesToRadians(params.maxConeAngle_deg), params.maxConeLength));
+	if (params.primEnabled[qRansacSD::RPT_TORUS])
+		detector.Add(new TorusPrimitiveShapeConstructor(false, params.minTorusMinorRadius, params.minTorusMajorRadius, params.maxTorusMinorRadius, params.maxTorusMajorRadius)); // Do not allow apple shaped torus
+}
+
+//! Shape clouds name prefix (per RANSAC_PRIMITIVE_TYPES)
+static const char* s_shapeCloudPrefixes[5] = { "Plane", "Sphere", "Cylinder", "Cone", "Torus" };
+
+//! Converts a detected shape into a CC primitive
+/** \param shape detected shape
+	\param shapePointsCount number of points associated to the shape
+	\param pointPos accessor to the position of the shape points (Vec3f pointPos(unsigned j))
+	\param cylinderExtentsFromPoints whether the cylinders height should be deduced from the points
+	\return the primitive (or nullptr if the shape can't be converted)
+**/
+template <class PointPosAccessor>
+static ccGenericPrimitive* CreatePrimitive(	const PrimitiveShape* shape,
+											unsigned shapePointsCount,
+											PointPosAccessor pointPos,
+											bool cylinderExtentsFromPoints = false)
+{
+	ccGenericPrimitive* prim = nullptr;
+	switch (shape->Identifier())
+	{
+	case qRansacSD::RPT_PLANE: //plane
+	{
+		const PlanePrimitiveShape* plane = static_cast<const PlanePrimitiveShape*>(shape);
+		Vec3f G = plane->Internal().getPosition();
+		Vec3f N = plane->Internal().getNormal();
+		Vec3f X = plane->getXDim();
+		Vec3f Y = plane->getYDim();
+
+		//we look for real plane extents
+		float minX, maxX, minY, maxY;
+		for (unsigned j = 0; j < shapePointsCount; ++j)
+		{
+			std::pair<float, float> param;
+			plane->Parameters(pointPos(j), &param);
+			if (j != 0)
+			{
+				if (minX < param.first)
+					minX = param.first;
+				else if (maxX > param.first)
+					maxX = param.first;
+				if (minY < param.second)
+					minY = param.second;
+				else if (maxY > param.second)
+					maxY = param.second;
+			}
+			else
+			{
+				minX = maxX = param.first;
+				minY = maxY = param.second;
+			}
+		}
+
+		//we recenter plane (as it is not always the case!)
+		float dX = maxX - minX;
+		float dY = maxY - minY;
+		G += X * (minX + dX / 2);
+		G += Y * (minY + dY / 2);
+
+		//we build matrix from these vectors
+		ccGLMatrix glMat(CCVector3::fromArray(X.getValue()),
+		    CCVector3::fromArray(Y.getValue()),
+		    CCVector3::fromArray(N.getValue()),
+		    CCVector3::fromArray(G.getValue()));
+
+		//plane primitive
+		//ccLog::Print(QString("dX: %1, dY: %2").arg(dX).arg(dY));
+		prim = new ccPlane(std::abs(dX), std::abs(dY), &glMat);
+		prim->setSelectionBehavior(ccHObject::SELECTION_FIT_BBOX);
+		prim->enableStippling(true);
+		PointCoordinateType dip = 0.0f;
+		PointCoordinateType dipDir = 0.0f;
+		ccNormalVectors::ConvertNormalToDipAndDipDir(CCVector3::fromArray(N.getValue()), dip, dipDir);
+		QString dipAndDipDirStr = ccNormalVectors::ConvertDipAndDipDirToString(dip, dipDir);
+		prim->setName(dipAndDipDirStr);
+	}
+	break;
+
+	case qRansacSD::RPT_SPHERE: //sphere
+	{
+		const SpherePrimitiveShape* sphere = static_cast<const SpherePrimitiveShape*>(shape);
+		float radius = sphere->Internal().Radius();
+		Vec3f CC = sphere->Internal().Center();
+
+		//we build matrix from these vecctors
+		ccGLMatrix glMat;
+		glMat.setTranslation(CC.getValue());
+		//sphere primitive
+		prim = new ccSphere(radius, &glMat);
+		prim->setEnabled(false);
+		prim->setName(QString("Sphere (r=%1)").arg(radius, 0, 'f'));
+	}
+	break;
+
+	case qRansacSD::RPT_CYLINDER: //cylinder
+	{
+		const CylinderPrimitiveShape* cyl = static_cast<const CylinderPrimitiveShape*>(shape);
+		Vec3f G = cyl->Internal().AxisPosition();
+		Vec3f N = cyl->Internal().AxisDirection();
+		Vec3f X = cyl->Internal().AngularDirection();
+		Vec3f Y = N.cross(X);
+		float r = cyl->Internal().Radius();
+		float hMin = cyl->MinHeight();
+		float hMax = cyl->MaxHeight();
+		if (cylinderExtentsFromPoints && shapePointsCount != 0)
+		{
+			//the shape parametrization may only cover a part of the points (see the partitioned mode)
+			hMin = hMax = (pointPos(0) - G).dot(N);
+			for (unsigned j = 1; j < shapePointsCount; ++j)
+			{
+				float hj = (pointPos(j) - G).dot(N);
+				if (hj < hMin)
+					hMin = hj;
+				else if (hj > hMax)
+					hMax = hj;
+			}
+		}
+		float h = hMax - hMin;
+		G += N * (hMin + h / 2);
+
+		//we build matrix from these vecctors
+		ccGLMatrix glMat(CCVector3::fromArray(X.getValue()),
+		    CCVector3::fromArray(Y.getValue()),
+		    CCVector3::fromArray(N.getValue()),
+		    CCVector3::fromArray(G.getValue()));
+
+		//cylinder primitive
+		prim = new ccCylinder(r, h, &glMat);
+		prim->setEnabled(false);
+		prim->setName(QString("Cylinder (r=%1/h=%2)").arg(r, 0, 'f').arg(h, 0, 'f'));
+	}
+	break;
+
+	case qRansacSD::RPT_CONE: //cone
+	{
+		const ConePrimitiveShape* cone = static_cast<const ConePrimitiveShape*>(shape);
+		Vec3f CC = cone->Internal().Center();
+		Vec3f CA = cone->Internal().AxisDirection();
+		float alpha_rad = cone->Internal().Angle();
+
+		//compute max height
+		Vec3f minP, maxP;
+		float minHeight, maxHeight;
+		minP = maxP = pointPos(0);
+		minHeight = maxHeight = cone->Internal().Height(pointPos(0));
+		for (unsigned j = 1; j < shapePointsCount; ++j)
+		{
+			float h = cone->Internal().Height(pointPos(j));
+			if (h < minHeight)
+			{
+				minHeight = h;
+				minP = pointPos(j);
+			}
+			else if (h > maxHeight)
+			{
+				maxHeight = h;
+				maxP = pointPos(j);
+			}
+
+		}
+
+
+		float minRadius = tan(alpha_rad) * minHeight;
+		float maxRadius = tan(alpha_rad) * maxHeight;
+
+		//let's build the cone primitive
+		{
+			//the bottom should be the largest part so we inverse the axis direction
+			CCVector3 Z = -CCVector3::fromArray(CA.getValue());
+			Z.normalize();
+
+			//the center is halfway between the min and max height
+			float midHeight = (minHeight + maxHeight) / 2;
+			CCVector3 C = CCVector3::fromArray((CC + CA * midHeight).getValue());
+
+			//radial axis
+			CCVector3 X = CCVector3::fromArray((maxP - (CC + maxHeight * CA)).getValue());
+			X.normalize();
+
+			//orthogonal radial axis
+			CCVector3 Y = Z * X;
+
+			//we build the transformation matrix from these vecctors
+			ccGLMatrix glMat(X, Y, Z, C);
+
+			//eventually create the cone primitive
+			prim = new ccCone(maxRadius, minRadius, maxHeight - minHeight, 0, 0, &glMat);
+			prim->setEnabled(false);
+			prim->setName(QString("Cone (alpha=%1 deg / h=%2)").arg(CCCoreLib::RadiansToDegrees(alpha_rad), 0, 'f').arg(static_cast<double>(maxHeight) - minHeight, 0, 'f'));
+		}
+
+	}
+	break;
+
+	case qRansacSD::RPT_TORUS: //torus
+	{
+		const TorusPrimitiveShape* torus = static_cast<const TorusPrimitiveShape*>(shape);
+		if (torus->Internal().IsAppleShaped())
+		{
+			ccLog::Warning("[qRansacSD] Apple-shaped torus are not handled by CloudCompare!");
+		}
+		else
+		{
+			Vec3f CC = torus->Internal().Center();
+			Vec3f CA = torus->Internal().AxisDirection();
+			float minRadius = torus->Internal().MinorRadius();
+			float maxRadius = torus->Internal().MajorRadius();
+
+			CCVector3 Z = CCVector3::fromArray(CA.getValue());
+			CCVector3 C = CCVector3::fromArray(CC.getValue());
+			//construct remaining of base
+			CCVector3 X = Z.orthogonal();
+			CCVector3 Y = Z * X;
+
+			//we build matrix from these vecctors
+			ccGLMatrix glMat(X, Y, Z, C);
+
+			//torus primitive
+			prim = new ccTorus(maxRadius - minRadius, maxRadius + minRadius, M_PI * 2.0, false, 0, &glMat);
+			prim->setEnabled(false);
+			prim->setName(QString("Torus (r=%1/R=%2)").arg(minRadius, 0, 'f').arg(maxRadius, 0, 'f'));
+		}
+
+	}
+	break;
+	}
+
+	return prim;
+}
+
 //for parameters persistence
 static unsigned s_supportPoints = 500;	// this is the minimal numer of points required for a primitive
 static double   s_maxNormalDev_deg = 25.0;	// maximal normal deviation from ideal shape (in degrees)
@@ -150,6 +401,8 @@ static double s_minTorusMinorRadius = 1;
 static double s_minTorusMajorRadius = 1;
 static double s_maxTorusMinorRadius = 1;
 static double s_maxTorusMajorRadius = 1;
+static bool s_partitioned = false;
+static double s_partitionCellSize = 0;
 
 void qRansacSD::doAction()
 {
@@ -219,6 +472,8 @@ void qRansacSD::doAction()
 	rsdDlg.maxTorusMinorRadiusdoubleSpinBox->setValue(s_maxTorusMinorRadius);
 	rsdDlg.maxTorusMajorRadiusdoubleSpinBox->setValue(s_maxTorusMajorRadius);
 	rsdDlg.randomColorcheckBox->setChecked(s_randomColor);
+	rsdDlg.partitionCheckBox->setChecked(s_partitioned);
+	rsdDlg.partitionCellSizeDoubleSpinBox->setValue(s_partitionCellSize);
 	if (!rsdDlg.exec())
 	{
 		return;
@@ -235,6 +490,8 @@ void qRansacSD::doAction()
 	s_maxTorusMinorRadiusEnabled = rsdDlg.maxTorusMinorRadiuscheckBox->isChecked();
 	s_maxTorusMajorRadiusEnabled = rsdDlg.maxTorusMajorRadiuscheckBox->isChecked();
 	s_randomColor = rsdDlg.randomColorcheckBox->isChecked();
+	s_partitioned = rsdDlg.partitionCheckBox->isChecked();
+	s_partitionCellSize = rsdDlg.partitionCellSizeDoubleSpinBox->value();
 	RansacParams params;
 	{
 		params.epsilon = static_cast<float>(rsdDlg.epsilonDoubleSpinBox->value());
@@ -251,6 +508,8 @@ void qRansacSD::doAction()
 		params.createCloudFromLeftOverPoints = rsdDlg.saveLeftOverscheckBox->isChecked();
 		params.allowFitting = rsdDlg.allowFittingcheckBox->isChecked();
 		params.allowSimplification = rsdDlg.simplifyShapescheckBox->isChecked();
+		params.partitioned = s_partitioned;
+		params.partitionCellSize = static_cast<float>(s_partitionCellSize);
 		if (s_minSphereRadiusEnabled)
 		{
 			params.minSphereRadius = static_cast<float>(rsdDlg.minSphereRadiusdoubleSpinBox->value());
@@ -320,6 +579,807 @@ void qRansacSD::doAction()
 }
 
 
+//! Minimal number of points per partition cell (automatic cell size)
+static const unsigned s_minPointsPerPartitionCell = 100000;
+//! Max number of points tested to decide whether two shapes detected in neighbor cells should be merged
+static const size_t s_mergeTestPointCount = 256;
+//! Min ratio of tested points that must fit the other shape to merge two shapes
+static const double s_mergeMinFittingRatio = 0.9;
+//! Max number of points used to refit merged shapes
+static const size_t s_maxRefitPointCount = 50000;
+
+//! Shape detected in a partition cell
+struct CellShape
+{
+	//! Detected shape
+	MiscLib::RefCountPtr< PrimitiveShape > shape;
+	//! Associated points (global indexes)
+	std::vector<unsigned> pointIndexes;
+};
+
+//! Partition cell
+struct PartitionCell
+{
+	//! Linear cell index
+	unsigned index = 0;
+	//! Shapes detected in this cell (core + overlap area)
+	std::vector<CellShape> shapes;
+};
+
+//! Output shape (the clouds and the primitives are built concurrently)
+struct OutputShape
+{
+	//! Detected shape
+	MiscLib::RefCountPtr< PrimitiveShape > shape;
+	//! Associated points (global indexes)
+	std::vector<unsigned> pointIndexes;
+	//! Shape cloud
+	ccPointCloud* cloud = nullptr;
+	//! Shape primitive
+	ccGenericPrimitive* primitive = nullptr;
+	//! Whether the normals could be copied or not
+	bool saveNormals = true;
+};
+
+//! Converts a CC vector to the RANSAC library format
+static inline Vec3f ToVec3f(const CCVector3& P)
+{
+	return Vec3f(static_cast<float>(P.x), static_cast<float>(P.y), static_cast<float>(P.z));
+}
+
+//! Returns the root of a set of merged shapes (union-find)
+static unsigned FindRootShape(std::vector<unsigned>& parents, unsigned index)
+{
+	while (parents[index] != index)
+	{
+		parents[index] = parents[parents[index]]; //path halving
+		index = parents[index];
+	}
+	return index;
+}
+
+//! Waits for concurrent jobs to finish while keeping the GUI responsive
+static void WaitForJobs(QFuture<void>& future,
+						ccProgressDialog* pDlg,
+						const std::atomic<unsigned>& processedCount,
+						unsigned totalCount,
+						std::atomic<bool>& canceled)
+{
+	while (!future.isFinished())
+	{
+#if defined(CC_WINDOWS)
+		::Sleep(100);
+#else
+		usleep(100 * 1000);
+#endif
+		if (pDlg)
+		{
+			pDlg->setValue(static_cast<int>((100.0 * processedCount) / std::max(1u, totalCount)));
+			if (pDlg->wasCanceled())
+			{
+				canceled = true;
+			}
+		}
+		QApplication::processEvents();
+	}
+}
+
+//! Partitioned (multi-threaded) shape detection
+/** The cloud is split into overlapping cubical cells. The shapes are detected
+	independently (and concurrently) in each cell, then the compatible shapes
+	sharing points in the overlap areas are merged. Eventually, the output clouds
+	and primitives are built concurrently.
+**/
+static ccHObject* ExecutePartitionedRANSAC(	ccPointCloud* ccPC,
+											const qRansacSD::RansacParams& params,
+											const RansacShapeDetector::Options& ransacOptions,
+											bool silent)
+{
+	unsigned count = ccPC->size();
+	bool hasNorms = ccPC->hasNormals();
+	CCVector3 bbMin, bbMax;
+	ccPC->getBoundingBox(bbMin, bbMax);
+	CCVector3 diag = bbMax - bbMin;
+	const float scale = static_cast<float>(std::max(std::max(diag.x, diag.y), diag.z));
+
+	int threadCount = (params.maxThreadCount > 0 ? params.maxThreadCount : QThread::idealThreadCount());
+	threadCount = std::max(1, threadCount);
+
+	//the cells should be large enough to contain the shapes
+	const float minCellSize = 20.0f * std::max(ransacOptions.m_epsilon, ransacOptions.m_bitmapEpsilon);
+
+	float cellSize = params.partitionCellSize;
+	if (cellSize <= 0)
+	{
+		//a few cells per thread, with enough points per cell
+		unsigned targetPointsPerCell = std::max(s_minPointsPerPartitionCell, count / (4 * static_cast<unsigned>(threadCount)));
+		double targetCellCount = std::ceil(static_cast<double>(count) / targetPointsPerCell);
+		cellSize = scale;
+		while (cellSize / 2 >= minCellSize)
+		{
+			double cellCount = 1.0;
+			for (unsigned char d = 0; d < 3; ++d)
+			{
+				cellCount *= std::max(1.0, std::ceil(static_cast<double>(diag.u[d]) / cellSize));
+			}
+			if (cellCount >= targetCellCount)
+			{
+				break;
+			}
+			cellSize /= 2;
+		}
+	}
+	if (cellSize < minCellSize)
+	{
+		ccLog::Warning(QString("[qRansacSD] Partition cell size is too small, it will be set to %1").arg(minCellSize));
+		cellSize = minCellSize;
+	}
+
+	//grid dimensions
+	unsigned gridDim[3];
+	double gridCellCount = 1.0;
+	for (unsigned char d = 0; d < 3; ++d)
+	{
+		gridDim[d] = static_cast<unsigned>(std::max(1.0, std::ceil(static_cast<double>(diag.u[d]) / cellSize)));
+		gridCellCount *= gridDim[d];
+	}
+	if (gridCellCount > (1 << 24))
+	{
+		ccLog::Error("[qRansacSD] Too many partition cells (increase the cell size)");
+		return nullptr;
+	}
+	const unsigned cellCount = static_cast<unsigned>(gridCellCount);
+	if (cellCount == 1)
+	{
+		ccLog::Print("[qRansacSD] The cloud fits in a single partition cell: regular detection");
+		qRansacSD::RansacParams singleCellParams = params;
+		singleCellParams.partitioned = false;
+		return qRansacSD::executeRANSAC(ccPC, singleCellParams, silent);
+	}
+
+	//the overlap must be large enough for the shapes to be merged (and the normals to be computed)
+	float overlap = std::max(2 * ransacOptions.m_epsilon, 2 * ransacOptions.m_bitmapEpsilon);
+	overlap = std::max(overlap, 0.05f * cellSize);
+	if (!hasNorms)
+	{
+		overlap = std::max(overlap, 0.01f * scale);
+	}
+	overlap = std::min(overlap, cellSize / 2);
+
+	//sort the points per cell (counting sort)
+	std::vector<unsigned> cellStart;
+	std::vector<unsigned> cellPoints;
+	std::vector<CCVector3> computedNormals;
+	std::vector<PartitionCell> cells;
+	try
+	{
+		std::vector<unsigned> pointCell(count);
+		cellStart.resize(static_cast<size_t>(cellCount) + 1, 0);
+		cellPoints.resize(count);
+		if (!hasNorms)
+		{
+			computedNormals.resize(count);
+		}
+
+		for (unsigned i = 0; i < count; ++i)
+		{
+			const CCVector3* P = ccPC->getPoint(i);
+			unsigned cellPos[3];
+			for (unsigned char d = 0; d < 3; ++d)
+			{
+				int c = static_cast<int>((P->u[d] - bbMin.u[d]) / cellSize);
+				cellPos[d] = static_cast<unsigned>(std::max(0, std::min(c, static_cast<int>(gridDim[d]) - 1)));
+			}
+			pointCell[i] = cellPos[0] + (cellPos[1] + cellPos[2] * gridDim[1]) * gridDim[0];
+			++cellStart[pointCell[i] + 1];
+		}
+
+		for (unsigned c = 0; c < cellCount; ++c)
+		{
+			if (cellStart[c + 1] != 0)
+			{
+				PartitionCell cell;
+				cell.index = c;
+				cells.push_back(cell);
+			}
+			cellStart[c + 1] += cellStart[c];
+		}
+
+		std::vector<unsigned> cellCursor(cellStart.begin(), cellStart.end() - 1);
+		for (unsigned i = 0; i < count; ++i)
+		{
+			cellPoints[cellCursor[pointCell[i]]++] = i;
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Error("[qRansacSD] Not enough memory!");
+		return nullptr;
+	}
+
+	ccLog::Print(QString("[qRansacSD] Partition: %1 non-empty cells (cell size = %2 / overlap = %3)").arg(cells.size()).arg(cellSize).arg(overlap));
+
+	std::atomic<unsigned> processedCount(0);
+	std::atomic<bool> error(false);
+	std::atomic<bool> canceled(false);
+
+	//each cell has its own random sequence (otherwise the cells processed at the same time would draw the same samples)
+	const size_t baseSeed = static_cast<size_t>(time(nullptr));
+
+	auto detectShapesInCell = [&](PartitionCell& cell)
+	{
+		if (error || canceled)
+		{
+			++processedCount;
+			return;
+		}
+
+		unsigned cellPos[3] = { cell.index % gridDim[0], (cell.index / gridDim[0]) % gridDim[1], cell.index / (gridDim[0] * gridDim[1]) };
+		CCVector3 cellMin;
+		CCVector3 cellMax;
+		for (unsigned char d = 0; d < 3; ++d)
+		{
+			cellMin.u[d] = bbMin.u[d] + cellPos[d] * cellSize - overlap;
+			cellMax.u[d] = bbMin.u[d] + (cellPos[d] + 1) * cellSize + overlap;
+		}
+
+		try
+		{
+			PointCloud cloud;
+			Vec3f cbbMin;
+			Vec3f cbbMax;
+
+			//default point & normal
+			Point Pt;
+			Pt.normal[0] = 0.0;
+			Pt.normal[1] = 0.0;
+			Pt.normal[2] = 0.0;
+			auto addPoint = [&](unsigned globalIndex)
+			{
+				const CCVector3* P = ccPC->getPoint(globalIndex);
+				Pt.pos[0] = static_cast<float>(P->x);
+				Pt.pos[1] = static_cast<float>(P->y);
+				Pt.pos[2] = static_cast<float>(P->z);
+				if (hasNorms)
+				{
+					const CCVector3& N = ccPC->getPointNormal(globalIndex);
+					Pt.normal[0] = static_cast<float>(N.x);
+					Pt.normal[1] = static_cast<float>(N.y);
+					Pt.normal[2] = static_cast<float>(N.z);
+				}
+#ifdef POINTSWITHINDEX
+				Pt.index = globalIndex;
+#endif
+				if (cloud.size() == 0)
+				{
+					cbbMin = cbbMax = Pt.pos;
+				}
+				else
+				{
+					for (unsigned char d = 0; d < 3; ++d)
+					{
+						cbbMin[d] = std::min(cbbMin[d], Pt.pos[d]);
+						cbbMax[d] = std::max(cbbMax[d], Pt.pos[d]);
+					}
+				}
+				cloud.push_back(Pt);
+			};
+
+			//the cell (core) points come first
+			unsigned coreCount = cellStart[cell.index + 1] - cellStart[cell.index];
+			cloud.reserve(coreCount);
+			for (unsigned k = cellStart[cell.index]; k < cellStart[cell.index + 1]; ++k)
+			{
+				addPoint(cellPoints[k]);
+			}
+
+			//then the points of the neighbor cells that lie in the overlap area
+			for (int dz = -1; dz <= 1; ++dz)
+			{
+				int z = static_cast<int>(cellPos[2]) + dz;
+				if (z < 0 || z >= static_cast<int>(gridDim[2]))
+					continue;
+				for (int dy = -1; dy <= 1; ++dy)
+				{
+					int y = static_cast<int>(cellPos[1]) + dy;
+					if (y < 0 || y >= static_cast<int>(gridDim[1]))
+						continue;
+					for (int dx = -1; dx <= 1; ++dx)
+					{
+						int x = static_cast<int>(cellPos[0]) + dx;
+						if (x < 0 || x >= static_cast<int>(gridDim[0]) || (dx == 0 && dy == 0 && dz == 0))
+							continue;
+
+						unsigned neighborIndex = static_cast<unsigned>(x) + (static_cast<unsigned>(y) + static_cast<unsigned>(z) * gridDim[1]) * gridDim[0];
+						for (unsigned k = cellStart[neighborIndex]; k < cellStart[neighborIndex + 1]; ++k)
+						{
+							const CCVector3* P = ccPC->getPoint(cellPoints[k]);
+							if (	P->x >= cellMin.x && P->x <= cellMax.x
+								&&	P->y >= cellMin.y && P->y <= cellMax.y
+								&&	P->z >= cellMin.z && P->z <= cellMax.z)
+							{
+								addPoint(cellPoints[k]);
+							}
+						}
+					}
+				}
+			}
+			cloud.setBBox(cbbMin, cbbMax);
+
+			if (!hasNorms)
+			{
+				//same radius as the regular detection
+				cloud.calcNormals(.01f * scale);
+				//each point is a core point of exactly one cell
+				for (unsigned k = 0; k < coreCount; ++k)
+				{
+					computedNormals[cloud[k].index] = CCVector3::fromArray(cloud[k].normal);
+				}
+			}
+
+			if (cloud.size() >= params.supportPoints)
+			{
+				RansacShapeDetector detector(ransacOptions);
+				AddShapeConstructors(detector, params);
+				detector.Seed(baseSeed ^ cell.index);
+
+				MiscLib::Vector< DetectedShape > shapes;
+				detector.Detect(cloud, 0, cloud.size(), &shapes);
+
+				//the points of the first shape are at the end of the cloud, etc.
+				size_t shapeEnd = cloud.size();
+				cell.shapes.reserve(shapes.size());
+				for (const DetectedShape& detectedShape : shapes)
+				{
+					size_t shapePointsCount = detectedShape.second;
+					if (shapePointsCount > shapeEnd)
+					{
+						assert(false);
+						break;
+					}
+
+					CellShape cellShape;
+					cellShape.shape = detectedShape.first;
+					cellShape.pointIndexes.resize(shapePointsCount);
+					for (size_t j = 0; j < shapePointsCount; ++j)
+					{
+						cellShape.pointIndexes[j] = cloud[shapeEnd - 1 - j].index;
+					}
+					shapeEnd -= shapePointsCount;
+
+					cell.shapes.push_back(std::move(cellShape));
+				}
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			error = true;
+		}
+
+		++processedCount;
+	};
+
+	ccProgressDialog* pDlg = nullptr;
+	if (!silent)
+	{
+		pDlg = new ccProgressDialog(true, s_app ? s_app->getMainWindow() : nullptr);
+		pDlg->setWindowTitle("Ransac Shape Detection");
+		pDlg->setLabelText(QObject::tr("Partitioned detection: %1 cells").arg(cells.size()));
+		pDlg->setRange(0, 100);
+		pDlg->show();
+	}
+
+	QElapsedTimer eTimer;
+	eTimer.start();
+
+	if (params.maxThreadCount > 0)
+	{
+		QThreadPool::globalInstance()->setMaxThreadCount(params.maxThreadCount);
+	}
+	{
+		QFuture<void> future = QtConcurrent::map(cells, detectShapesInCell);
+		WaitForJobs(future, pDlg, processedCount, static_cast<unsigned>(cells.size()), canceled);
+	}
+
+	ccLog::Print("[qRANSAC] Search Timing: %2.3f s", static_cast<double>(eTimer.elapsed()) / 1.0e3);
+
+	if (canceled || error)
+	{
+		if (pDlg)
+		{
+			pDlg->hide();
+			delete pDlg;
+		}
+		if (error)
+			ccLog::Error("[qRansacSD] Not enough memory!");
+		else
+			ccLog::Warning("[qRansacSD] Process canceled by the user");
+		return nullptr;
+	}
+
+	//store the computed normals
+	if (!hasNorms)
+	{
+		if (ccPC->reserveTheNormsTable())
+		{
+			for (unsigned i = 0; i < count; ++i)
+			{
+				CCVector3 Ni = computedNormals[i];
+				//normalize the vector in case of
+				Ni.normalize();
+				ccPC->addNorm(Ni);
+			}
+			ccPC->showNormals(true);
+
+			//currently selected entities appearance may have changed!
+			ccPC->prepareDisplayForRefresh_recursive();
+		}
+		else
+		{
+			ccLog::Error("[qRansacSD] Not enough memory to compute normals!");
+			if (pDlg)
+			{
+				pDlg->hide();
+				delete pDlg;
+			}
+			return nullptr;
+		}
+		computedNormals.clear();
+		computedNormals.shrink_to_fit();
+	}
+
+	//gather all the shapes (in the cells order)
+	std::vector<CellShape*> cellShapes;
+	for (PartitionCell& cell : cells)
+	{
+		for (CellShape& cellShape : cell.shapes)
+		{
+			cellShapes.push_back(&cellShape);
+		}
+	}
+	const unsigned cellShapeCount = static_cast<unsigned>(cellShapes.size());
+
+	//merge the compatible shapes detected in neighbor cells
+	std::vector<OutputShape> outputShapes;
+	std::vector<int> pointShape; //output shape index per point (-1 = leftover)
+	try
+	{
+		//each point is associated to the first shape that claims it
+		std::vector<int> pointOwner(count, -1);
+		std::set< std::pair<unsigned, unsigned> > sharedPoints; //pairs of shapes sharing points
+		for (unsigned s = 0; s < cellShapeCount; ++s)
+		{
+			for (unsigned index : cellShapes[s]->pointIndexes)
+			{
+				if (pointOwner[index] < 0)
+				{
+					pointOwner[index] = static_cast<int>(s);
+				}
+				else
+				{
+					sharedPoints.insert(std::make_pair(static_cast<unsigned>(pointOwner[index]), s));
+				}
+			}
+		}
+
+		auto pointPos = [&](unsigned index) { return ToVec3f(*ccPC->getPoint(index)); };
+
+		//whether (a subset of) the points fit a given shape
+		auto pointsFitShape = [&](const PrimitiveShape* shape, const std::vector<unsigned>& pointIndexes) -> bool
+		{
+			size_t step = std::max<size_t>(1, pointIndexes.size() / s_mergeTestPointCount);
+			size_t testedCount = 0;
+			size_t fittingCount = 0;
+			for (size_t k = 0; k < pointIndexes.size(); k += step)
+			{
+				std::pair<float, float> dn;
+				shape->DistanceAndNormalDeviation(pointPos(pointIndexes[k]), ToVec3f(ccPC->getPointNormal(pointIndexes[k])), &dn);
+				++testedCount;
+				if (dn.first < ransacOptions.m_epsilon && std::abs(dn.second) >= ransacOptions.m_normalThresh)
+				{
+					++fittingCount;
+				}
+			}
+			return fittingCount >= s_mergeMinFittingRatio * testedCount;
+		};
+
+		std::vector<unsigned> parents(cellShapeCount);
+		for (unsigned s = 0; s < cellShapeCount; ++s)
+		{
+			parents[s] = s;
+		}
+		for (const std::pair<unsigned, unsigned>& shapePair : sharedPoints)
+		{
+			const CellShape* shapeA = cellShapes[shapePair.first];
+			const CellShape* shapeB = cellShapes[shapePair.second];
+			if (shapeA->shape->Identifier() != shapeB->shape->Identifier())
+			{
+				continue;
+			}
+			unsigned rootA = FindRootShape(parents, shapePair.first);
+			unsigned rootB = FindRootShape(parents, shapePair.second);
+			if (rootA == rootB)
+			{
+				continue;
+			}
+			if (pointsFitShape(shapeA->shape, shapeB->pointIndexes) && pointsFitShape(shapeB->shape, shapeA->pointIndexes))
+			{
+				//the smallest index is the root (deterministic)
+				parents[std::max(rootA, rootB)] = std::min(rootA, rootB);
+			}
+		}
+
+		//output shape per set of merged shapes
+		std::vector<int> rootOutputShape(cellShapeCount, -1);
+		std::vector<unsigned> outputShapeSizes;
+		for (unsigned s = 0; s < cellShapeCount; ++s)
+		{
+			unsigned root = FindRootShape(parents, s);
+			if (rootOutputShape[root] < 0)
+			{
+				rootOutputShape[root] = static_cast<int>(outputShapes.size());
+				outputShapes.emplace_back();
+				outputShapeSizes.push_back(0);
+			}
+			//the largest shape of the set is used as model
+			OutputShape& outputShape = outputShapes[rootOutputShape[root]];
+			if (cellShapes[s]->pointIndexes.size() > outputShapeSizes[rootOutputShape[root]])
+			{
+				outputShape.shape = cellShapes[s]->shape;
+				outputShapeSizes[rootOutputShape[root]] = static_cast<unsigned>(cellShapes[s]->pointIndexes.size());
+			}
+		}
+
+		pointShape.resize(count, -1);
+		for (unsigned i = 0; i < count; ++i)
+		{
+			if (pointOwner[i] >= 0)
+			{
+				int s = rootOutputShape[FindRootShape(parents, static_cast<unsigned>(pointOwner[i]))];
+				outputShapes[s].pointIndexes.push_back(i);
+				pointShape[i] = s;
+			}
+		}
+
+		//refit the merged shapes (the model was only fitted on a part of the points)
+		if (params.allowFitting)
+		{
+			for (size_t s = 0; s < outputShapes.size(); ++s)
+			{
+				OutputShape& outputShape = outputShapes[s];
+				if (outputShape.pointIndexes.size() == outputShapeSizes[s])
+				{
+					//nothing has been merged
+					continue;
+				}
+
+				PointCloud refitCloud;
+				size_t step = std::max<size_t>(1, outputShape.pointIndexes.size() / s_maxRefitPointCount);
+				refitCloud.reserve(outputShape.pointIndexes.size() / step + 1);
+				for (size_t k = 0; k < outputShape.pointIndexes.size(); k += step)
+				{
+					unsigned index = outputShape.pointIndexes[k];
+					refitCloud.push_back(Point(pointPos(index), ToVec3f(ccPC->getPointNormal(index))));
+				}
+				MiscLib::Vector<size_t> refitIndexes(refitCloud.size());
+				for (size_t k = 0; k < refitCloud.size(); ++k)
+				{
+					refitIndexes[k] = k;
+				}
+
+				MiscLib::RefCountPtr< PrimitiveShape > refitShape(outputShape.shape->Clone());
+				refitShape->Release(); //the clone is now only referenced by refitShape
+				if (	refitShape->Fit(refitCloud, ransacOptions.m_epsilon, ransacOptions.m_normalThresh, refitIndexes.begin(), refitIndexes.end())
+					&&	pointsFitShape(refitShape, outputShape.pointIndexes))
+				{
+					outputShape.shape = refitShape;
+				}
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Error("[qRansacSD] Not enough memory!");
+		if (pDlg)
+		{
+			pDlg->hide();
+			delete pDlg;
+		}
+		return nullptr;
+	}
+
+	//the shapes that are too small are dropped (their points are considered as leftovers)
+	{
+		std::vector<int> newIndexes(outputShapes.size(), -1);
+		std::vector<OutputShape> validShapes;
+		for (size_t s = 0; s < outputShapes.size(); ++s)
+		{
+			if (outputShapes[s].pointIndexes.size() >= params.supportPoints)
+			{
+				newIndexes[s] = static_cast<int>(validShapes.size());
+				validShapes.push_back(std::move(outputShapes[s]));
+			}
+		}
+		outputShapes = std::move(validShapes);
+		for (int& s : pointShape)
+		{
+			if (s >= 0)
+			{
+				s = newIndexes[s];
+			}
+		}
+	}
+	if (outputShapes.empty())
+	{
+		if (pDlg)
+		{
+			pDlg->hide();
+			delete pDlg;
+		}
+		ccLog::Error("[qRansacSD] Segmentation failed...");
+		return nullptr;
+	}
+
+	//biggest shapes first (as the regular detection)
+	std::stable_sort(outputShapes.begin(), outputShapes.end(), [](const OutputShape& a, const OutputShape& b) { return a.pointIndexes.size() > b.pointIndexes.size(); });
+
+	ccLog::Print(QString("[qRansacSD] %1 shapes detected in the cells, %2 after merging").arg(cellShapeCount).arg(outputShapes.size()));
+
+	//build the output clouds and primitives concurrently
+	processedCount = 0;
+	auto buildOutputShape = [&](OutputShape& outputShape)
+	{
+		if (error)
+		{
+			++processedCount;
+			return;
+		}
+
+		unsigned shapePointsCount = static_cast<unsigned>(outputShape.pointIndexes.size());
+		CCCoreLib::ReferenceCloud refPcShape(ccPC);
+		if (!refPcShape.reserve(shapePointsCount))
+		{
+			error = true;
+			++processedCount;
+			return;
+		}
+		for (unsigned index : outputShape.pointIndexes)
+		{
+			refPcShape.addPointIndex(index);
+		}
+
+		int warnings = 0;
+		outputShape.cloud = ccPC->partialClone(&refPcShape, &warnings);
+		if (!outputShape.cloud)
+		{
+			error = true;
+			++processedCount;
+			return;
+		}
+		outputShape.saveNormals = ((warnings & ccPointCloud::WRN_OUT_OF_MEM_FOR_NORMALS) != ccPointCloud::WRN_OUT_OF_MEM_FOR_NORMALS);
+
+		outputShape.primitive = CreatePrimitive(outputShape.shape, shapePointsCount, [&](unsigned j) { return ToVec3f(*ccPC->getPoint(outputShape.pointIndexes[j])); }, true);
+		if (outputShape.primitive)
+		{
+			outputShape.primitive->copyGlobalShiftAndScale(*ccPC);
+			outputShape.primitive->applyGLTransformation_recursive();
+		}
+
+		++processedCount;
+	};
+
+	if (pDlg)
+	{
+		pDlg->setLabelText(QObject::tr("Creating %1 shapes").arg(outputShapes.size()));
+		pDlg->setValue(0);
+	}
+	{
+		std::atomic<bool> dummyCanceled(false); //the output can't be canceled
+		QFuture<void> future = QtConcurrent::map(outputShapes, buildOutputShape);
+		WaitForJobs(future, pDlg, processedCount, static_cast<unsigned>(outputShapes.size()), dummyCanceled);
+	}
+
+	if (pDlg)
+	{
+		pDlg->hide();
+		delete pDlg;
+		pDlg = nullptr;
+	}
+
+	if (error)
+	{
+		for (OutputShape& outputShape : outputShapes)
+		{
+			delete outputShape.cloud; //the primitive (if any) is not a child yet
+			delete outputShape.primitive;
+		}
+		ccLog::Error("[qRansacSD] Not enough memory!");
+		return nullptr;
+	}
+
+	//the colors, names and hierarchy are set sequentially (deterministic result)
+	ccHObject* group = nullptr;
+	unsigned shapeCounts[5] = { 1, 1, 1, 1, 1 }; //RANSAC_PRIMITIVE_TYPES
+	for (OutputShape& outputShape : outputShapes)
+	{
+		ccPointCloud* pcShape = outputShape.cloud;
+		ccGenericPrimitive* prim = outputShape.primitive;
+		if (!prim)
+		{
+			//unhandled shape
+			delete pcShape;
+			continue;
+		}
+
+		//random color
+		ccColor::Rgb col = ccColor::Generator::Random();
+		if (params.randomColor)
+		{
+			pcShape->setColor(col);
+			pcShape->showSF(false);
+			pcShape->showColors(true);
+		}
+		pcShape->showNormals(outputShape.saveNormals);
+		pcShape->setVisible(true);
+
+		size_t shapeType = outputShape.shape->Identifier();
+		pcShape->setName(QString("%1_%2").arg(s_shapeCloudPrefixes[shapeType]).arg(shapeCounts[shapeType]++, 4, 10, QChar('0')));
+
+		pcShape->addChild(prim);
+		prim->setDisplay(pcShape->getDisplay());
+		if (params.randomColor)
+		{
+			prim->setColor(col);
+		}
+		prim->showColors(true);
+		prim->setVisible(true);
+		if (!group)
+		{
+			group = new ccHObject(QString("Ransac Detected Shapes (%1)").arg(ccPC->getName()));
+		}
+		group->addChild(pcShape);
+	}
+
+	if (!group)
+	{
+		ccLog::Error("[qRansacSD] Segmentation failed...");
+		return nullptr;
+	}
+
+	//we hide input cloud
+	ccPC->setEnabled(false);
+	ccLog::Warning("[qRansacSD] Input cloud has been automtically hidden!");
+
+	group->setVisible(true);
+	group->setDisplay_recursive(ccPC->getDisplay());
+
+	if (params.createCloudFromLeftOverPoints)
+	{
+		//new cloud for left overs
+		CCCoreLib::ReferenceCloud refPcLO(ccPC);
+		bool success = true;
+		for (unsigned i = 0; i < count && success; ++i)
+		{
+			if (pointShape[i] < 0)
+			{
+				success = refPcLO.addPointIndex(i);
+			}
+		}
+		ccPointCloud* pcLeftOvers = (success && refPcLO.size() != 0 ? ccPC->partialClone(&refPcLO) : nullptr);
+		if (pcLeftOvers)
+		{
+			pcLeftOvers->setName("Leftovers");
+			group->addChild(pcLeftOvers);
+		}
+		else if (!success)
+		{
+			ccLog::Error("[qRansacSD] Not enough memory!");
+		}
+	}
+
+	return group;
+}
+
 ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& params, bool silent)
 {
 	//consistency check
@@ -344,6 +1404,24 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 	s_proba = params.probability;
 	s_createCloudFromLeftOverPoints = params.createCloudFromLeftOverPoints;
 	s_allowSimplification = params.allowSimplification;
+
+	RansacShapeDetector::Options ransacOptions;
+	{
+		ransacOptions.m_epsilon = params.epsilon;
+		ransacOptions.m_bitmapEpsilon = params.bitmapEpsilon;
+		ransacOptions.m_normalThresh = static_cast<float>(cos( CCCoreLib::DegreesToRadians( params.maxNormalDev_deg ) ));
+		assert(ransacOptions.m_normalThresh >= 0);
+		ransacOptions.m_probability = params.probability;
+		ransacOptions.m_minSupport = params.supportPoints;
+		ransacOptions.m_allowSimplification = params.allowSimplification;
+		ransacOptions.m_fitting = params.allowFitting ? RansacShapeDetector::Options::LS_FITTING : RansacShapeDetector::Options::NO_FITTING;
+	}
+
+	if (params.partitioned)
+	{
+		return ExecutePartitionedRANSAC(ccPC, params, ransacOptions, silent);
+	}
+
 	unsigned count = ccPC->size();
 	bool hasNorms = ccPC->hasNormals();
 	CCVector3 bbMin, bbMax;
@@ -397,17 +1475,6 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 		cloud.setBBox(cbbMin, cbbMax);
 	}
 
-	RansacShapeDetector::Options ransacOptions;
-	{
-		ransacOptions.m_epsilon = params.epsilon;
-		ransacOptions.m_bitmapEpsilon = params.bitmapEpsilon;
-		ransacOptions.m_normalThresh = static_cast<float>(cos( CCCoreLib::DegreesToRadians( params.maxNormalDev_deg ) ));
-		assert(ransacOptions.m_normalThresh >= 0);
-		ransacOptions.m_probability = params.probability;
-		ransacOptions.m_minSupport = params.supportPoints;
-		ransacOptions.m_allowSimplification = params.allowSimplification;
-		ransacOptions.m_fitting = params.allowFitting ? RansacShapeDetector::Options::LS_FITTING : RansacShapeDetector::Options::NO_FITTING;
-	}
 	const float scale = cloud.getScale();
 
 	if (!hasNorms)
@@ -458,21 +1525,9 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 	}
 
 	RansacShapeDetector detector(ransacOptions); // the detector object
-
-	if (params.primEnabled[RPT_PLANE])
-		detector.Add(new PlanePrimitiveShapeConstructor());
-	if (params.primEnabled[RPT_SPHERE])
-		detector.Add(new SpherePrimitiveShapeConstructor(params.minSphereRadius, params.maxSphereRadius));
-	if (params.primEnabled[RPT_CYLINDER])
-		detector.Add(new CylinderPrimitiveShapeConstructor(params.minCylinderRadius, params.maxCylinderRadius, params.maxCylinderLength));
-	if (params.primEnabled[RPT_CONE])
-		detector.Add(new ConePrimitiveShapeConstructor(params.maxConeRadius, CCCoreLib::DegreesToRadians(params.maxConeAngle_deg), params.maxConeLength));
-	if (params.primEnabled[RPT_TORUS])
-		detector.Add(new TorusPrimitiveShapeConstructor(false, params.minTorusMinorRadius, params.minTorusMajorRadius, params.maxTorusMinorRadius, params.maxTorusMajorRadius)); // Do not allow apple shaped torus
-
+	AddShapeConstructors(detector, params);
 
 	unsigned remaining = count;
-	typedef std::pair< MiscLib::RefCountPtr< PrimitiveShape >, size_t > DetectedShape;
 	MiscLib::Vector< DetectedShape > shapes; // stores the detected shapes
 
 	// run detection
@@ -570,11 +1625,7 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 
 	if (shapes.size() > 0)
 	{
-		unsigned planeCount = 1;
-		unsigned sphereCount = 1;
-		unsigned cylinderCount = 1;
-		unsigned coneCount = 1;
-		unsigned torusCount = 1;
+		unsigned shapeCounts[5] = { 1, 1, 1, 1, 1 }; //RANSAC_PRIMITIVE_TYPES
 		ccHObject* group = nullptr;
 		for (MiscLib::Vector<DetectedShape>::const_iterator it = shapes.begin(); it != shapes.end(); ++it)
 		{
@@ -664,215 +1715,13 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 
 
 			//convert detected primitive into a CC primitive type
-			ccGenericPrimitive* prim = nullptr;
-			switch (shape->Identifier())
-			{
-			case RPT_PLANE: //plane
-			{
-				const PlanePrimitiveShape* plane = static_cast<const PlanePrimitiveShape*>(shape);
-				Vec3f G = plane->Internal().getPosition();
-				Vec3f N = plane->Internal().getNormal();
-				Vec3f X = plane->getXDim();
-				Vec3f Y = plane->getYDim();
-
-				//we look for real plane extents
-				float minX, maxX, minY, maxY;
-				for (unsigned j = 0; j < shapePointsCount; ++j)
-				{
-					std::pair<float, float> param;
-					plane->Parameters(cloud[shapeCloudIndex - j].pos, &param);
-					if (j != 0)
-					{
-						if (minX < param.first)
-							minX = param.first;
-						else if (maxX > param.first)
-							maxX = param.first;
-						if (minY < param.second)
-							minY = param.second;
-						else if (maxY > param.second)
-							maxY = param.second;
-					}
-					else
-					{
-						minX = maxX = param.first;
-						minY = maxY = param.second;
-					}
-				}
-
-				//we recenter plane (as it is not always the case!)
-				float dX = maxX - minX;
-				float dY = maxY - minY;
-				G += X * (minX + dX / 2);
-				G += Y * (minY + dY / 2);
-
-				//we build matrix from these vectors
-				ccGLMatrix glMat(CCVector3::fromArray(X.getValue()),
-				    CCVector3::fromArray(Y.getValue()),
-				    CCVector3::fromArray(N.getValue()),
-				    CCVector3::fromArray(G.getValue()));
-
-				//plane primitive
-				//ccLog::Print(QString("dX: %1, dY: %2").arg(dX).arg(dY));
-				prim = new ccPlane(std::abs(dX), std::abs(dY), &glMat);
-				prim->setSelectionBehavior(ccHObject::SELECTION_FIT_BBOX);
-				prim->enableStippling(true);
-				PointCoordinateType dip = 0.0f;
-				PointCoordinateType dipDir = 0.0f;
-				ccNormalVectors::ConvertNormalToDipAndDipDir(CCVector3::fromArray(N.getValue()), dip, dipDir);
-				QString dipAndDipDirStr = ccNormalVectors::ConvertDipAndDipDirToString(dip, dipDir);
-				prim->setName(dipAndDipDirStr);
-				pcShape->setName(QString("Plane_%1").arg(planeCount, 4, 10, QChar('0')));
-				planeCount++;
-			}
-			break;
-
-			case RPT_SPHERE: //sphere
-			{
-				const SpherePrimitiveShape* sphere = static_cast<const SpherePrimitiveShape*>(shape);
-				float radius = sphere->Internal().Radius();
-				Vec3f CC = sphere->Internal().Center();
-
-				//we build matrix from these vecctors
-				ccGLMatrix glMat;
-				glMat.setTranslation(CC.getValue());
-				//sphere primitive
-				prim = new ccSphere(radius, &glMat);
-				prim->setEnabled(false);
-				prim->setName(QString("Sphere (r=%1)").arg(radius, 0, 'f'));
-				pcShape->setName(QString("Sphere_%1").arg(sphereCount, 4, 10, QChar('0')));
-				sphereCount++;
-			}
-			break;
-
-			case RPT_CYLINDER: //cylinder
-			{
-				const CylinderPrimitiveShape* cyl = static_cast<const CylinderPrimitiveShape*>(shape);
-				Vec3f G = cyl->Internal().AxisPosition();
-				Vec3f N = cyl->Internal().AxisDirection();
-				Vec3f X = cyl->Internal().AngularDirection();
-				Vec3f Y = N.cross(X);
-				float r = cyl->Internal().Radius();
-				float hMin = cyl->MinHeight();
-				float hMax = cyl->MaxHeight();
-				float h = hMax - hMin;
-				G += N * (hMin + h / 2);
-
-				//we build matrix from these vecctors
-				ccGLMatrix glMat(CCVector3::fromArray(X.getValue()),
-				    CCVector3::fromArray(Y.getValue()),
-				    CCVector3::fromArray(N.getValue()),
-				    CCVector3::fromArray(G.getValue()));
-
-				//cylinder primitive
-				prim = new ccCylinder(r, h, &glMat);
-				prim->setEnabled(false);
-				prim->setName(QString("Cylinder (r=%1/h=%2)").arg(r, 0, 'f').arg(h, 0, 'f'));
-				pcShape->setName(QString("Cylinder_%1").arg(cylinderCount, 4, 10, QChar('0')));
-				cylinderCount++;
-			}
-			break;
-
-			case RPT_CONE: //cone
-			{
-				const ConePrimitiveShape* cone = static_cast<const ConePrimitiveShape*>(shape);
-				Vec3f CC = cone->Internal().Center();
-				Vec3f CA = cone->Internal().AxisDirection();
-				float alpha_rad = cone->Internal().Angle();
-
-				//compute max height
-				Vec3f minP, maxP;
-				float minHeight, maxHeight;
-				minP = maxP = cloud[shapeCloudIndex].pos;
-				minHeight = maxHeight = cone->Internal().Height(cloud[shapeCloudIndex].pos);
-				for (size_t j = 1; j < shapePointsCount; ++j)
-				{
-					float h = cone->Internal().Height(cloud[shapeCloudIndex - j].pos);
-					if (h < minHeight)
-					{
-						minHeight = h;
-						minP = cloud[shapeCloudIndex - j].pos;
-					}
-					else if (h > maxHeight)
-					{
-						maxHeight = h;
-						maxP = cloud[shapeCloudIndex - j].pos;
-					}
-
-				}
-
-
-				float minRadius = tan(alpha_rad) * minHeight;
-				float maxRadius = tan(alpha_rad) * maxHeight;
-
-				//let's build the cone primitive
-				{
-					//the bottom should be the largest part so we inverse the axis direction
-					CCVector3 Z = -CCVector3::fromArray(CA.getValue());
-					Z.normalize();
-
-					//the center is halfway between the min and max height
-					float midHeight = (minHeight + maxHeight) / 2;
-					CCVector3 C = CCVector3::fromArray((CC + CA * midHeight).getValue());
-
-					//radial axis
-					CCVector3 X = CCVector3::fromArray((maxP - (CC + maxHeight * CA)).getValue());
-					X.normalize();
-
-					//orthogonal radial axis
-					CCVector3 Y = Z * X;
-
-					//we build the transformation matrix from these vecctors
-					ccGLMatrix glMat(X, Y, Z, C);
-
-					//eventually create the cone primitive
-					prim = new ccCone(maxRadius, minRadius, maxHeight - minHeight, 0, 0, &glMat);
-					prim->setEnabled(false);
-					prim->setName(QString("Cone (alpha=%1 deg / h=%2)").arg(CCCoreLib::RadiansToDegrees(alpha_rad), 0, 'f').arg(static_cast<double>(maxHeight) - minHeight, 0, 'f'));
-					pcShape->setName(QString("Cone_%1").arg(coneCount, 4, 10, QChar('0')));
-					coneCount++;
-				}
-
-			}
-			break;
-
-			case RPT_TORUS: //torus
-			{
-				const TorusPrimitiveShape* torus = static_cast<const TorusPrimitiveShape*>(shape);
-				if (torus->Internal().IsAppleShaped())
-				{
-					ccLog::Warning("[qRansacSD] Apple-shaped torus are not handled by CloudCompare!");
-				}
-				else
-				{
-					Vec3f CC = torus->Internal().Center();
-					Vec3f CA = torus->Internal().AxisDirection();
-					float minRadius = torus->Internal().MinorRadius();
-					float maxRadius = torus->Internal().MajorRadius();
-
-					CCVector3 Z = CCVector3::fromArray(CA.getValue());
-					CCVector3 C = CCVector3::fromArray(CC.getValue());
-					//construct remaining of base
-					CCVector3 X = Z.orthogonal();
-					CCVector3 Y = Z * X;
-
-					//we build matrix from these vecctors
-					ccGLMatrix glMat(X, Y, Z, C);
-
-					//torus primitive
-					prim = new ccTorus(maxRadius - minRadius, maxRadius + minRadius, M_PI * 2.0, false, 0, &glMat);
-					prim->setEnabled(false);
-					prim->setName(QString("Torus (r=%1/R=%2)").arg(minRadius, 0, 'f').arg(maxRadius, 0, 'f'));
-					pcShape->setName(QString("Torus_%1").arg(torusCount, 4, 10, QChar('0')));
-					torusCount++;
-				}
-
-			}
-			break;
-			}
+			ccGenericPrimitive* prim = CreatePrimitive(shape, shapePointsCount, [&](unsigned j) { return cloud[shapeCloudIndex - j].pos; });
 
 			//is there a primitive to add to part cloud?
 			if (prim)
 			{
+				size_t shapeType = shape->Identifier();
+				pcShape->setName(QString("%1_%2").arg(s_shapeCloudPrefixes[shapeType]).arg(shapeCounts[shapeType]++, 4, 10, QChar('0')));
 				prim->copyGlobalShiftAndScale(*ccPC);
 				prim->applyGLTransformation_recursive();
 				pcShape->addChild(prim);
@@ -29,6 +29,7 @@
 
 // qCC_db
 #include <ccClipBox.h>
+#include <ccHObjectCaster.h>
 #include <ccPointCloud.h>
 #include <ccProgressDialog.h>
 #include <ccRasterGrid.h>
@@ -36,6 +37,15 @@
 // Qt
 #include <QMessageBox>
 
+// System
+#include <atomic>
+#include <limits>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
 namespace
 {
 	// Last envelope or contour unique ID
@@ -664,11 +674,25 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 				ccBBox localBox;
 				for (ccGenericPointCloud* cloud : clouds)
 				{
-					for (unsigned i = 0; i < cloud->size(); ++i)
+					int pointCount = static_cast<int>(cloud->size());
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(omp_get_max_threads())
+#endif
 					{
-						CCVector3 P = *cloud->getPoint(i);
-						localTrans.apply(P);
-						localBox.add(P);
+						ccBBox threadBox;
+#if defined(_OPENMP)
+#pragma omp for
+#endif
+						for (int i = 0; i < pointCount; ++i)
+						{
+							CCVector3 P = *cloud->getPoint(i);
+							localTrans.apply(P);
+							threadBox.add(P);
+						}
+#if defined(_OPENMP)
+#pragma omp critical(ExtractSlicesAndContours_localBox)
+#endif
+						localBox += threadBox;
 					}
 				}
 
@@ -676,10 +700,21 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 				int      indexMaxs[3]{0, 0, 0};
 				int      gridDim[3]{0, 0, 0};
 				unsigned cellCount = ComputeGridDimensions(localBox, repeatDimensions, indexMins, indexMaxs, gridDim, gridOrigin, cellSizePlusGap);
+				if (cellCount == 0)
+				{
+					// error message already issued
+					return false;
+				}
 
-				// we'll potentially create up to one (ref.) cloud per input loud and per cell
-				std::vector<CCCoreLib::ReferenceCloud*> refClouds;
-				refClouds.resize(cellCount * clouds.size(), nullptr);
+				// each (non empty) slice is identified by a unique key (in the output order: X, then Y, then Z, then cloud index)
+				const size_t   cloudCount = clouds.size();
+				const size_t   keyCount   = static_cast<size_t>(cellCount) * cloudCount;
+				const unsigned InvalidKey = std::numeric_limits<unsigned>::max();
+				if (keyCount >= InvalidKey)
+				{
+					ccLog::Error(tr("Too many slices!"));
+					return false;
+				}
 
 				if (progressDialog)
 				{
@@ -689,13 +724,13 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 					progressDialog->setAutoClose(false);
 				}
 
-				unsigned subCloudsCount = 0;
-
-				// project points into grid
-				for (size_t ci = 0; ci != clouds.size(); ++ci)
+				// assign each point to a slice (in parallel)
+				std::vector<std::vector<unsigned>> pointKeys(cloudCount);
+				std::vector<size_t>                keyOffsets(keyCount + 1, 0); // number of points per slice, then first point position (see below)
+				for (size_t ci = 0; ci != cloudCount; ++ci)
 				{
 					ccGenericPointCloud* cloud      = clouds[ci];
-					unsigned             pointCount = cloud->size();
+					int                  pointCount = static_cast<int>(cloud->size());
 
 					QString infos = tr("Cloud '%1").arg(cloud->getName());
 					infos += tr("Points: %L1").arg(pointCount);
@@ -705,8 +740,13 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 					}
 					QApplication::processEvents();
 
-					CCCoreLib::NormalizedProgress nProgress(progressDialog, pointCount);
-					for (unsigned i = 0; i < pointCount; ++i)
+					std::vector<unsigned>& keys = pointKeys[ci];
+					keys.resize(pointCount);
+
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+					for (int i = 0; i < pointCount; ++i)
 					{
 						CCVector3 P = *cloud->getPoint(i);
 						localTrans.apply(P);
@@ -726,129 +766,217 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 
 						if (gap == 0 || ((P.x - static_cast<PointCoordinateType>(xi)) * cellSizePlusGap.x <= cellSize.x && (P.y - static_cast<PointCoordinateType>(yi)) * cellSizePlusGap.y <= cellSize.y && (P.z - static_cast<PointCoordinateType>(zi)) * cellSizePlusGap.z <= cellSize.z))
 						{
-							int cloudIndex = ((zi - indexMins[2]) * static_cast<int>(gridDim[1]) + (yi - indexMins[1])) * static_cast<int>(gridDim[0]) + (xi - indexMins[0]);
-							assert(cloudIndex >= 0 && static_cast<size_t>(cloudIndex) * clouds.size() + ci < refClouds.size());
+							size_t sliceIndex = (static_cast<size_t>(xi - indexMins[0]) * gridDim[1] + (yi - indexMins[1])) * gridDim[2] + (zi - indexMins[2]);
+							keys[i]           = static_cast<unsigned>(sliceIndex * cloudCount + ci);
+						}
+						else
+						{
+							keys[i] = InvalidKey;
+						}
+					}
+
+					for (unsigned key : keys)
+					{
+						if (key != InvalidKey)
+						{
+							++keyOffsets[key + 1];
+						}
+					}
+				} // assign points to slices
 
-							CCCoreLib::ReferenceCloud*& destCloud = refClouds[cloudIndex * clouds.size() + ci];
-							if (!destCloud)
-							{
-								destCloud = new CCCoreLib::ReferenceCloud(cloud);
-								++subCloudsCount;
-							}
+				// counting sort: the point indexes of each slice are stored contiguously
+				std::vector<unsigned> sliceKeys; // non empty slices
+				for (size_t key = 0; key < keyCount; ++key)
+				{
+					if (keyOffsets[key + 1] != 0)
+					{
+						sliceKeys.push_back(static_cast<unsigned>(key));
+					}
+					keyOffsets[key + 1] += keyOffsets[key];
+				}
 
-							if (!destCloud->addPointIndex(i))
+				std::vector<unsigned> sortedIndexes(keyOffsets.back());
+				{
+					std::vector<size_t> fillPos(keyOffsets.begin(), keyOffsets.end() - 1);
+					for (size_t ci = 0; ci != cloudCount; ++ci)
+					{
+						const std::vector<unsigned>& keys = pointKeys[ci];
+						for (unsigned i = 0; i < static_cast<unsigned>(keys.size()); ++i)
+						{
+							if (keys[i] != InvalidKey)
 							{
-								ccLog::Error("Not enough memory!");
-								error = true;
-								break;
+								sortedIndexes[fillPos[keys[i]]++] = i;
 							}
 						}
+						// release memory as soon as possible
+						pointKeys[ci] = std::vector<unsigned>();
 					}
+				}
+
+				int sliceCount = static_cast<int>(sliceKeys.size());
 
-					if (!nProgress.oneStep())
+				// the random colors are generated beforehand (the generator is not thread-safe)
+				std::vector<ccColor::Rgb> sliceColors;
+				if (generateRandomColors)
+				{
+					sliceColors.resize(sliceKeys.size());
+					for (ccColor::Rgb& col : sliceColors)
 					{
-						// sadly, we can't cancel in the middle of this process!
+						col = ccColor::Generator::Random();
 					}
-				} // project points into grid
+				}
 
 				if (progressDialog)
 				{
 					progressDialog->setWindowTitle(QObject::tr("Section extraction"));
-					progressDialog->setInfo(QObject::tr("Section(s): %L1").arg(subCloudsCount));
-					progressDialog->setMaximum(static_cast<int>(subCloudsCount));
+					progressDialog->setInfo(QObject::tr("Section(s): %L1").arg(sliceCount));
+					progressDialog->setMaximum(100); // see the NormalizedProgress instance below
 					progressDialog->setValue(0);
 					QApplication::processEvents();
 				}
 
-				// reset count
-				subCloudsCount = 0;
-
-				// now create the real clouds
-				for (int i = indexMins[0]; i <= indexMaxs[0]; ++i)
+				// now create the real clouds (in parallel)
+				std::vector<ccPointCloud*>    sliceClouds(sliceKeys.size(), nullptr);
+				CCCoreLib::NormalizedProgress nProgress(progressDialog, static_cast<unsigned>(sliceCount));
+				std::atomic<bool>             notEnoughMemory(false);
+				std::atomic<bool>             canceled(false);
+				std::atomic<bool>             sliceWarnings(false);
+
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(omp_get_max_threads())
+#endif
+				for (int si = 0; si < sliceCount; ++si)
 				{
-					for (int j = indexMins[1]; j <= indexMaxs[1]; ++j)
+					if (notEnoughMemory || canceled)
 					{
-						for (int k = indexMins[2]; k <= indexMaxs[2]; ++k)
-						{
-							int cloudIndex = ((k - indexMins[2]) * static_cast<int>(gridDim[1]) + (j - indexMins[1])) * static_cast<int>(gridDim[0]) + (i - indexMins[0]);
-							assert(cloudIndex >= 0 && static_cast<size_t>(cloudIndex) * clouds.size() < refClouds.size());
+						continue;
+					}
 
-							for (size_t ci = 0; ci != clouds.size(); ++ci)
-							{
-								ccGenericPointCloud*       cloud     = clouds[ci];
-								CCCoreLib::ReferenceCloud* destCloud = refClouds[cloudIndex * clouds.size() + ci];
-								if (destCloud) // some slices can be empty!
-								{
-									// generate slice from previous selection
-									int           warnings   = 0;
-									ccPointCloud* sliceCloud = cloud->isA(CC_TYPES::POINT_CLOUD) ? static_cast<ccPointCloud*>(cloud)->partialClone(destCloud, &warnings) : ccPointCloud::From(destCloud, cloud);
-									warningsIssued |= (warnings != 0);
+					const unsigned       key        = sliceKeys[si];
+					const size_t         ci         = key % cloudCount;
+					const unsigned       sliceIndex = static_cast<unsigned>(key / cloudCount);
+					ccGenericPointCloud* cloud      = clouds[ci];
 
-									if (sliceCloud)
-									{
-										if (generateRandomColors)
-										{
-											ccColor::Rgb col = ccColor::Generator::Random();
-											if (!sliceCloud->setColor(col))
-											{
-												ccLog::Error("Not enough memory!");
-												error = true;
-												i     = indexMaxs[0];
-												j     = indexMaxs[1];
-												k     = indexMaxs[2];
-											}
-											sliceCloud->showColors(true);
-										}
+					// generate slice from the sorted indexes
+					CCCoreLib::ReferenceCloud destCloud(cloud);
+					const size_t              firstPos = keyOffsets[key];
+					const size_t              lastPos  = keyOffsets[key + 1];
+					if (!destCloud.reserve(static_cast<unsigned>(lastPos - firstPos)))
+					{
+						notEnoughMemory = true;
+						continue;
+					}
+					for (size_t n = firstPos; n < lastPos; ++n)
+					{
+						destCloud.addPointIndex(sortedIndexes[n]); // can't fail, see above
+					}
 
-										sliceCloud->setEnabled(true);
-										sliceCloud->setVisible(true);
-										sliceCloud->setDisplay(cloud->getDisplay());
+					int           warnings   = 0;
+					ccPointCloud* sliceCloud = cloud->isA(CC_TYPES::POINT_CLOUD)
+					                               ? static_cast<ccPointCloud*>(cloud)->partialClone(&destCloud, &warnings, false) // the child entities are cloned afterwards (see below)
+					                               : ccPointCloud::From(&destCloud, cloud);
+					if (warnings != 0)
+					{
+						sliceWarnings = true;
+					}
 
-										CCVector3 cellOrigin(gridOrigin.x + i * cellSizePlusGap.x,
-										                     gridOrigin.y + j * cellSizePlusGap.y,
-										                     gridOrigin.z + k * cellSizePlusGap.z);
-										QString   slicePosStr = QString("(%1 ; %2 ; %3)").arg(cellOrigin.x).arg(cellOrigin.y).arg(cellOrigin.z);
-										sliceCloud->setName(cloud->getName() + QString(".slice @ ") + slicePosStr);
+					if (sliceCloud)
+					{
+						if (generateRandomColors)
+						{
+							if (!sliceCloud->setColor(sliceColors[si]))
+							{
+								notEnoughMemory = true;
+							}
+							sliceCloud->showColors(true);
+						}
 
-										// set meta-data
-										sliceCloud->setMetaData(s_originEntityUUID, cloud->getUniqueID());
-										sliceCloud->setMetaData(s_sliceID, slicePosStr);
-										sliceCloud->setMetaData("slice.origin.dim(0)", cellOrigin.x);
-										sliceCloud->setMetaData("slice.origin.dim(1)", cellOrigin.y);
-										sliceCloud->setMetaData("slice.origin.dim(2)", cellOrigin.z);
+						sliceCloud->setEnabled(true);
+						sliceCloud->setVisible(true);
+						sliceCloud->setDisplay(cloud->getDisplay());
+
+						// retrieve the cell indexes
+						int k = indexMins[2] + static_cast<int>(sliceIndex % gridDim[2]);
+						int j = indexMins[1] + static_cast<int>((sliceIndex / gridDim[2]) % gridDim[1]);
+						int i = indexMins[0] + static_cast<int>(sliceIndex / (static_cast<unsigned>(gridDim[2]) * gridDim[1]));
+
+						CCVector3 cellOrigin(gridOrigin.x + i * cellSizePlusGap.x,
+						                     gridOrigin.y + j * cellSizePlusGap.y,
+						                     gridOrigin.z + k * cellSizePlusGap.z);
+						QString   slicePosStr = QString("(%1 ; %2 ; %3)").arg(cellOrigin.x).arg(cellOrigin.y).arg(cellOrigin.z);
+						sliceCloud->setName(cloud->getName() + QString(".slice @ ") + slicePosStr);
+
+						// set meta-data
+						sliceCloud->setMetaData(s_originEntityUUID, cloud->getUniqueID());
+						sliceCloud->setMetaData(s_sliceID, slicePosStr);
+						sliceCloud->setMetaData("slice.origin.dim(0)", cellOrigin.x);
+						sliceCloud->setMetaData("slice.origin.dim(1)", cellOrigin.y);
+						sliceCloud->setMetaData("slice.origin.dim(2)", cellOrigin.z);
+
+						sliceClouds[si] = sliceCloud;
+					}
+					else
+					{
+						notEnoughMemory = true;
+					}
 
-										// add slice to group
-										outputSlices.push_back(sliceCloud);
-										++subCloudsCount;
+					if (progressDialog && !nProgress.oneStep())
+					{
+						canceled = true;
+					}
+				} // now create the real clouds
 
-										if (progressDialog)
-										{
-											progressDialog->setValue(static_cast<int>(subCloudsCount));
-										}
-									}
+				// the child entities (labels, etc.) are cloned sequentially, as they may share dependencies with other entities
+				if (!notEnoughMemory && !canceled)
+				{
+					std::vector<int> newIndexMap;
+					for (int si = 0; si < sliceCount; ++si)
+					{
+						ccPointCloud*        sliceCloud = sliceClouds[si];
+						const unsigned       key        = sliceKeys[si];
+						ccGenericPointCloud* cloud      = clouds[key % cloudCount];
+						if (!sliceCloud || !cloud->isA(CC_TYPES::POINT_CLOUD) || cloud->getChildrenNumber() == 0)
+						{
+							continue;
+						}
 
-									if (progressDialog && progressDialog->wasCanceled())
-									{
-										error = true;
-										ccLog::Warning(QString("[ExtractSlicesAndContours] Process canceled by user"));
-										// early stop
-										i = indexMaxs[0];
-										j = indexMaxs[1];
-										k = indexMaxs[2];
-										break;
-									}
-								}
-							}
+						try
+						{
+							newIndexMap.assign(cloud->size(), -1);
+						}
+						catch (const std::bad_alloc&)
+						{
+							notEnoughMemory = true;
+							break;
+						}
+						for (size_t n = keyOffsets[key]; n < keyOffsets[key + 1]; ++n)
+						{
+							newIndexMap[sortedIndexes[n]] = static_cast<int>(n - keyOffsets[key]);
 						}
+
+						ccHObjectCaster::CloneChildren(cloud, sliceCloud, &newIndexMap);
 					}
-				} // now create the real clouds
+				}
 
-				// release memory
+				// add the slices to the output (in the right order)
+				for (ccPointCloud* sliceCloud : sliceClouds)
 				{
-					for (size_t i = 0; i < refClouds.size(); ++i)
-						if (refClouds[i])
-							delete refClouds[i];
-					refClouds.clear();
+					if (sliceCloud)
+					{
+						outputSlices.push_back(sliceCloud);
+					}
+				}
+
+				warningsIssued |= sliceWarnings;
+				if (notEnoughMemory)
+				{
+					ccLog::Error("Not enough memory!");
+					error = true;
+				}
+				else if (canceled)
+				{
+					ccLog::Warning(QString("[ExtractSlicesAndContours] Process canceled by user"));
+					error = true;
 				}
 
 				cloudSliceCount = outputSlices.size();
@@ -1136,7 +1264,7 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 			{
 				progressDialog->setWindowTitle(tr("Envelope extraction"));
 				progressDialog->setInfo(tr("Envelope(s): %L1").arg(cloudSliceCount));
-				progressDialog->setMaximum(static_cast<int>(cloudSliceCount));
+				progressDialog->setMaximum(100); // see the NormalizedProgress instance below
 				if (!visualDebugMode)
 				{
 					progressDialog->show();
@@ -1147,13 +1275,13 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 			// preferred dimension?
 			PointCoordinateType* preferredNormDir = nullptr;
 			PointCoordinateType* preferredUpDir   = nullptr;
+			ccGLMatrix           invLocalTrans    = localTrans.inverse(); // (must outlive the above pointers)
 			if (repeatDimensionsSum == 1)
 			{
 				for (int i = 0; i < 3; ++i)
 				{
 					if (repeatDimensions[i])
 					{
-						ccGLMatrix invLocalTrans = localTrans.inverse();
 						if (!projectOnBestFitPlane) // otherwise the normal will be automatically computed
 							preferredNormDir = invLocalTrans.getColumn(i);
 						preferredUpDir = invLocalTrans.getColumn(i < 2 ? 2 : 0);
@@ -1165,21 +1293,58 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 			assert(cloudSliceCount <= outputSlices.size());
 
 			// process all the slices originating from point clouds
+			// (concurrently, unless the visual debug mode is enabled as it requires the GUI)
+			std::vector<std::vector<ccPolyline*>> slicePolys(cloudSliceCount);
+			std::vector<char>                     sliceSuccess(cloudSliceCount, 0);
+			{
+				CCCoreLib::NormalizedProgress nProgress(visualDebugMode ? nullptr : progressDialog, static_cast<unsigned>(cloudSliceCount));
+				std::atomic<bool>             canceled(false);
+				int                           sliceCount = static_cast<int>(cloudSliceCount);
+
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(visualDebugMode ? 1 : omp_get_max_threads())
+#endif
+				for (int i = 0; i < sliceCount; ++i)
+				{
+					if (canceled)
+					{
+						continue;
+					}
+
+					ccPointCloud* sliceCloud = ccHObjectCaster::ToPointCloud(outputSlices[i]);
+					assert(sliceCloud);
+
+					sliceSuccess[i] = ccEnvelopeExtractor::ExtractFlatEnvelope(sliceCloud,
+					                                                           multiPass,
+					                                                           maxEdgeLength,
+					                                                           slicePolys[i],
+					                                                           envelopeType,
+					                                                           splitEnvelopes,
+					                                                           preferredNormDir,
+					                                                           preferredUpDir,
+					                                                           visualDebugMode);
+
+					if (progressDialog && !visualDebugMode && !nProgress.oneStep())
+					{
+						canceled = true;
+					}
+				}
+
+				if (canceled)
+				{
+					error = true;
+					ccLog::Warning(tr("[ExtractSlicesAndContours] Process canceled by user"));
+				}
+			}
+
+			// now post-process the envelopes (in the slices order)
 			for (size_t i = 0; i < cloudSliceCount; ++i)
 			{
 				ccPointCloud* sliceCloud = ccHObjectCaster::ToPointCloud(outputSlices[i]);
 				assert(sliceCloud);
 
-				std::vector<ccPolyline*> polys;
-				if (ccEnvelopeExtractor::ExtractFlatEnvelope(sliceCloud,
-				                                             multiPass,
-				                                             maxEdgeLength,
-				                                             polys,
-				                                             envelopeType,
-				                                             splitEnvelopes,
-				                                             preferredNormDir,
-				                                             preferredUpDir,
-				                                             visualDebugMode))
+				std::vector<ccPolyline*>& polys = slicePolys[i];
+				if (sliceSuccess[i])
 				{
 					if (!polys.empty())
 					{
@@ -1208,29 +1373,17 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 							outputEnvelopes.push_back(poly);
 						}
 					}
-					else
+					else if (!error)
 					{
 						ccLog::Warning(tr("%1: points are too far from each other! Increase the max edge length").arg(sliceCloud->getName()));
 						warningsIssued = true;
 					}
 				}
-				else
+				else if (!error)
 				{
 					ccLog::Warning(tr("%1: envelope extraction failed!").arg(sliceCloud->getName()));
 					warningsIssued = true;
 				}
-
-				if (progressDialog && !visualDebugMode)
-				{
-					if (progressDialog->wasCanceled())
-					{
-						error = true;
-						ccLog::Warning(tr("[ExtractSlicesAndContours] Process canceled by user"));
-						// early stop
-						break;
-					}
-					progressDialog->setValue(static_cast<int>(i));
-				}
 			}
 
 		} // extract envelope polylines
@@ -1701,36 +1854,33 @@ void ccClippingBoxTool::extractSlicesAndContours(bool singleSliceMode)
 
 	removeLastContourToolButton->setEnabled(!s_lastContourUniqueIDs.empty());
 
-	// now take care of the 'output' groups
+	// now take care of the 'output' groups (added to the DB tree at once)
 	{
+		ccHObject::Container outputGroups;
+
 		if (sliceGroup)
 		{
-			sliceGroup->setDisplay_recursive(defaultDisplay);
-			MainWindow::TheInstance()->addToDB(sliceGroup);
+			outputGroups.push_back(sliceGroup);
 		}
 
 		if (envelopeGroup)
 		{
-			envelopeGroup->setDisplay_recursive(defaultDisplay);
-			MainWindow::TheInstance()->addToDB(envelopeGroup);
+			outputGroups.push_back(envelopeGroup);
 		}
 
 		if (levelSetGroup)
 		{
-			levelSetGroup->setDisplay_recursive(defaultDisplay);
-			MainWindow::TheInstance()->addToDB(levelSetGroup);
+			outputGroups.push_back(levelSetGroup);
 		}
 
 		for (ccHObject* group : perSliceGroups)
 		{
-			group->setDisplay_recursive(defaultDisplay);
-			MainWindow::TheInstance()->addToDB(group);
+			outputGroups.push_back(group);
 		}
 
 		for (ccHObject* group : perEntityGroups)
 		{
-			group->setDisplay_recursive(defaultDisplay);
-			MainWindow::TheInstance()->addToDB(group);
+			outputGroups.push_back(group);
 		}
 
 		// don't forget the 'garbage' group (just in case)
@@ -1738,8 +1888,7 @@ void ccClippingBoxTool::extractSlicesAndContours(bool singleSliceMode)
 		{
 			if (garbageGroup->getChildrenNumber() != 0)
 			{
-				garbageGroup->setDisplay_recursive(defaultDisplay);
-				MainWindow::TheInstance()->addToDB(garbageGroup);
+				outputGroups.push_back(garbageGroup);
 			}
 			else
 			{
@@ -1747,6 +1896,12 @@ void ccClippingBoxTool::extractSlicesAndContours(bool singleSliceMode)
 				garbageGroup = nullptr;
 			}
 		}
+
+		for (ccHObject* group : outputGroups)
+		{
+			group->setDisplay_recursive(defaultDisplay);
+		}
+		MainWindow::TheInstance()->addToDB(outputGroups);
 	}
 
 	if (m_associatedWin)
@@ -0,0 +1,566 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+// #                                                                        #
+// ##########################################################################
+
+#include "ccCloudDistanceGrid.h"
+
+// CCCoreLib
+#include <DgmOctree.h>
+#include <GenericIndexedCloudPersist.h>
+#include <GenericProgressCallback.h>
+#include <ParallelSort.h>
+#include <ScalarField.h>
+
+// qCC_db
+#include <ccGenericPointCloud.h>
+#include <ccLog.h>
+
+// System
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
+//! Max subdivision level (same as the octree)
+static const unsigned char s_maxLevel = CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL;
+//! Target mean number of points per cell at the finest level
+static const unsigned s_targetPopulation = 8;
+//! Number of points processed by each thread at once
+static const unsigned s_chunkSize = 1024;
+
+//! Watches the reference cloud of the cached grid (see ccCloudDistanceGrid::GetOrBuild)
+/** The watcher can't be deleted while its cloud notifies it (the cloud may be iterating over
+    its dependencies), so the grid is only released then, and the watcher is deleted later.
+**/
+class ccCloudDistanceGridWatcher : public ccHObject
+{
+  public:
+	ccCloudDistanceGridWatcher()
+	    : ccHObject("Distance grid watcher")
+	{
+	}
+
+	//! Inherited from ccHObject
+	void onDeletionOf(const ccHObject* obj) override;
+	//! Inherited from ccHObject
+	void onUpdateOf(ccHObject* obj) override;
+};
+
+//! Cached grid (see ccCloudDistanceGrid::GetOrBuild)
+static ccCloudDistanceGrid::Shared s_cachedGrid;
+//! Reference cloud of the cached grid
+static const ccGenericPointCloud* s_cachedGridCloud = nullptr;
+//! Bounding-box of the reference cloud when the cached grid has been built
+static ccBBox s_cachedGridBox;
+//! Watcher of the reference cloud of the cached grid
+static ccCloudDistanceGridWatcher* s_cachedGridWatcher = nullptr;
+
+//! Releases the cached grid, but not its watcher
+static void InvalidateCachedGrid()
+{
+	s_cachedGrid.clear();
+	s_cachedGridCloud = nullptr;
+}
+
+void ccCloudDistanceGridWatcher::onDeletionOf(const ccHObject* obj)
+{
+	ccHObject::onDeletionOf(obj);
+	InvalidateCachedGrid();
+}
+
+void ccCloudDistanceGridWatcher::onUpdateOf(ccHObject* obj)
+{
+	Q_UNUSED(obj);
+	InvalidateCachedGrid();
+}
+
+//! Spreads the (21) lowest bits of a value so that there are 2 zero bits between each of them
+static inline uint64_t SpreadBits(uint64_t x)
+{
+	x &= 0x1fffff;
+	x = (x | x << 32) & 0x1f00000000ffff;
+	x = (x | x << 16) & 0x1f0000ff0000ff;
+	x = (x | x << 8) & 0x100f00f00f00f00f;
+	x = (x | x << 4) & 0x10c30c30c30c30c3;
+	x = (x | x << 2) & 0x1249249249249249;
+	return x;
+}
+
+//! Inverse of SpreadBits
+static inline uint64_t CompactBits(uint64_t x)
+{
+	x &= 0x1249249249249249;
+	x = (x ^ (x >> 2)) & 0x10c30c30c30c30c3;
+	x = (x ^ (x >> 4)) & 0x100f00f00f00f00f;
+	x = (x ^ (x >> 8)) & 0x1f0000ff0000ff;
+	x = (x ^ (x >> 16)) & 0x1f00000000ffff;
+	x = (x ^ (x >> 32)) & 0x1fffff;
+	return x;
+}
+
+ccCloudDistanceGrid::ccCloudDistanceGrid()
+    : m_origin(0, 0, 0)
+    , m_dimension(1.0)
+{
+}
+
+ccCloudDistanceGrid::Shared ccCloudDistanceGrid::GetOrBuild(ccGenericPointCloud* cloud, CCCoreLib::GenericProgressCallback* progressCb /*=nullptr*/)
+{
+	if (!cloud)
+	{
+		assert(false);
+		return {};
+	}
+
+	if (s_cachedGrid && s_cachedGridCloud == cloud && s_cachedGrid->size() == cloud->size())
+	{
+		ccBBox box = cloud->getOwnBB();
+		if (box.isValid() == s_cachedGridBox.isValid()
+		    && box.minCorner() == s_cachedGridBox.minCorner()
+		    && box.maxCorner() == s_cachedGridBox.maxCorner())
+		{
+			ccLog::PrintDebug(QString("[ccCloudDistanceGrid] Re-using the cached grid of cloud '%1'").arg(cloud->getName()));
+			return s_cachedGrid;
+		}
+	}
+
+	// release the previous grid before building the new one
+	ReleaseCache();
+
+	Shared grid = Build(cloud, progressCb);
+	if (!grid)
+	{
+		return {};
+	}
+
+	s_cachedGrid        = grid;
+	s_cachedGridCloud   = cloud;
+	s_cachedGridBox     = cloud->getOwnBB();
+	s_cachedGridWatcher = new ccCloudDistanceGridWatcher;
+	cloud->addDependency(s_cachedGridWatcher, ccHObject::DP_NOTIFY_OTHER_ON_DELETE | ccHObject::DP_NOTIFY_OTHER_ON_UPDATE);
+
+	return grid;
+}
+
+void ccCloudDistanceGrid::ReleaseCache()
+{
+	InvalidateCachedGrid();
+
+	// the watcher removes its dependency with the cloud (if it still exists)
+	delete s_cachedGridWatcher;
+	s_cachedGridWatcher = nullptr;
+}
+
+ccCloudDistanceGrid::Shared ccCloudDistanceGrid::Build(ccGenericPointCloud* cloud, CCCoreLib::GenericProgressCallback* progressCb /*=nullptr*/)
+{
+	if (!cloud || cloud->size() == 0)
+	{
+		return {};
+	}
+
+	const unsigned pointCount = cloud->size();
+
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Distance grid");
+			progressCb->setInfo(qPrintable(QString("Reference points: %L1").arg(pointCount)));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+
+	Shared grid(new ccCloudDistanceGrid);
+
+	// cubical bounding-box (as the octree)
+	{
+		ccBBox    box     = cloud->getOwnBB();
+		CCVector3 diag    = box.getDiagVec();
+		double    maxDim  = std::max({diag.x, diag.y, diag.z});
+		grid->m_origin    = box.minCorner();
+		grid->m_dimension = (maxDim > 0 ? maxDim * (1.0 + 1.0e-6) : 1.0); // slightly enlarged so that the last points fall inside
+	}
+
+	struct PointCode
+	{
+		uint64_t code;
+		unsigned index;
+	};
+
+	try
+	{
+		std::vector<PointCode> pointCodes(pointCount);
+
+		// compute the code of each point (at the max level)
+		const double   scale    = static_cast<double>(uint64_t(1) << s_maxLevel) / grid->m_dimension;
+		const int64_t  maxCoord = (int64_t(1) << s_maxLevel) - 1;
+		const CCVector3 origin  = grid->m_origin;
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+		for (int i = 0; i < static_cast<int>(pointCount); ++i)
+		{
+			const CCVector3* P = cloud->getPoint(static_cast<unsigned>(i));
+
+			int64_t x = std::clamp(static_cast<int64_t>((P->x - origin.x) * scale), int64_t(0), maxCoord);
+			int64_t y = std::clamp(static_cast<int64_t>((P->y - origin.y) * scale), int64_t(0), maxCoord);
+			int64_t z = std::clamp(static_cast<int64_t>((P->z - origin.z) * scale), int64_t(0), maxCoord);
+
+			pointCodes[i].code  = SpreadBits(x) | (SpreadBits(y) << 1) | (SpreadBits(z) << 2);
+			pointCodes[i].index = static_cast<unsigned>(i);
+		}
+		if (progressCb)
+		{
+			progressCb->update(20.0f);
+		}
+
+		// sort the points by code
+		ParallelSort(pointCodes.begin(), pointCodes.end(), [](const PointCode& a, const PointCode& b) { return a.code < b.code; });
+		if (progressCb)
+		{
+			progressCb->update(60.0f);
+		}
+
+		grid->m_points.resize(pointCount);
+		grid->m_indexes.resize(pointCount);
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+		for (int i = 0; i < static_cast<int>(pointCount); ++i)
+		{
+			grid->m_points[i]  = *cloud->getPoint(pointCodes[i].index);
+			grid->m_indexes[i] = pointCodes[i].index;
+		}
+
+		// now build the levels (until the cells are small enough)
+		grid->m_levels.reserve(s_maxLevel + 1);
+		{
+			Level root;
+			root.codes.push_back(0);
+			root.firstPoint.push_back(0);
+			grid->m_levels.push_back(root);
+		}
+		for (unsigned char level = 1; level <= s_maxLevel; ++level)
+		{
+			const unsigned char bitShift = 3 * (s_maxLevel - level);
+
+			grid->m_levels.emplace_back();
+			Level& cells = grid->m_levels.back();
+
+			uint64_t previousCode = std::numeric_limits<uint64_t>::max();
+			for (unsigned i = 0; i < pointCount; ++i)
+			{
+				uint64_t code = (pointCodes[i].code >> bitShift);
+				if (code != previousCode)
+				{
+					cells.codes.push_back(code);
+					cells.firstPoint.push_back(i);
+					previousCode = code;
+				}
+			}
+			cells.codes.shrink_to_fit();
+			cells.firstPoint.shrink_to_fit();
+
+			// link the parent cells with their children (both are sorted, and each parent cell has at least one child)
+			Level& parentCells = grid->m_levels[level - 1];
+			parentCells.firstChild.resize(parentCells.codes.size());
+			size_t childIndex = 0;
+			for (size_t p = 0; p < parentCells.codes.size(); ++p)
+			{
+				while ((cells.codes[childIndex] >> 3) != parentCells.codes[p])
+				{
+					++childIndex;
+					assert(childIndex < cells.codes.size());
+				}
+				parentCells.firstChild[p] = static_cast<unsigned>(childIndex);
+			}
+
+			if (progressCb)
+			{
+				progressCb->update(60.0f + (40.0f * level) / s_maxLevel);
+			}
+
+			if (static_cast<uint64_t>(cells.codes.size()) * s_targetPopulation >= pointCount)
+			{
+				// the cells are small enough
+				break;
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccCloudDistanceGrid] Not enough memory");
+		grid.clear();
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (grid)
+	{
+		ccLog::PrintDebug(QString("[ccCloudDistanceGrid] Grid built for cloud '%1' (finest level: %2)").arg(cloud->getName()).arg(grid->finestLevel()));
+	}
+
+	return grid;
+}
+
+double ccCloudDistanceGrid::cellSize(unsigned char level) const
+{
+	return std::ldexp(m_dimension, -static_cast<int>(level));
+}
+
+double ccCloudDistanceGrid::meanPointsPerCell(unsigned char level) const
+{
+	if (m_levels.empty())
+	{
+		return 0.0;
+	}
+
+	unsigned char finest = finestLevel();
+	if (level <= finest)
+	{
+		return static_cast<double>(size()) / m_levels[level].codes.size();
+	}
+
+	// we assume that the number of cells is multiplied by 4 at each level (i.e. surface-like clouds)
+	double cellCount = std::ldexp(static_cast<double>(m_levels[finest].codes.size()), 2 * (level - finest));
+	return std::max(1.0, size() / cellCount);
+}
+
+double ccCloudDistanceGrid::nearestNeighborDistance(const CCVector3& P, double maxDistance, double tolerance, std::vector<SearchEntry>& heap, unsigned* nearestIndex /*=nullptr*/) const
+{
+	if (nearestIndex)
+	{
+		*nearestIndex = std::numeric_limits<unsigned>::max();
+	}
+
+	double bestSquareDist = (maxDistance > 0 ? maxDistance * maxDistance : std::numeric_limits<double>::infinity());
+	// a cell is only worth visiting if it's closer than this threshold (squared)
+	double threshold = bestSquareDist;
+	auto   updateBest = [&](double squareDist)
+	{
+		bestSquareDist = squareDist;
+		double t       = std::sqrt(squareDist) - tolerance;
+		threshold      = (t > 0 ? t * t : 0.0);
+	};
+	if (maxDistance > 0)
+	{
+		updateBest(bestSquareDist);
+	}
+
+	// squared distance between the query point and a cell
+	auto squareDistToCell = [&](unsigned char level, uint64_t code)
+	{
+		const double cs = cellSize(level);
+		double       d2 = 0.0;
+		for (unsigned char dim = 0; dim < 3; ++dim)
+		{
+			double cellMin = m_origin.u[dim] + CompactBits(code >> dim) * cs;
+			double p       = P.u[dim];
+			if (p < cellMin)
+			{
+				d2 += (cellMin - p) * (cellMin - p);
+			}
+			else if (p > cellMin + cs)
+			{
+				d2 += (p - cellMin - cs) * (p - cellMin - cs);
+			}
+		}
+		return d2;
+	};
+
+	const unsigned char finest = finestLevel();
+
+	heap.clear();
+	heap.push_back({squareDistToCell(0, 0), 0, 0});
+
+	while (!heap.empty())
+	{
+		std::pop_heap(heap.begin(), heap.end());
+		SearchEntry entry = heap.back();
+		heap.pop_back();
+
+		if (entry.squareDist >= threshold)
+		{
+			// all the remaining cells are farther
+			break;
+		}
+
+		const Level& cells = m_levels[entry.level];
+		if (entry.level == finest)
+		{
+			// test the points of this cell
+			unsigned firstIndex = cells.firstPoint[entry.cellIndex];
+			unsigned lastIndex  = (entry.cellIndex + 1 < cells.firstPoint.size() ? cells.firstPoint[entry.cellIndex + 1] : size());
+			for (unsigned i = firstIndex; i < lastIndex; ++i)
+			{
+				const CCVector3& Q          = m_points[i];
+				double           dx         = static_cast<double>(Q.x) - P.x;
+				double           dy         = static_cast<double>(Q.y) - P.y;
+				double           dz         = static_cast<double>(Q.z) - P.z;
+				double           squareDist = dx * dx + dy * dy + dz * dz;
+				if (squareDist < bestSquareDist)
+				{
+					updateBest(squareDist);
+					if (nearestIndex)
+					{
+						*nearestIndex = i;
+					}
+				}
+			}
+		}
+		else
+		{
+			// push the children cells
+			const unsigned char childLevel = entry.level + 1;
+			const Level&        children   = m_levels[childLevel];
+			unsigned            firstChild = cells.firstChild[entry.cellIndex];
+			unsigned            lastChild  = (entry.cellIndex + 1 < cells.firstChild.size() ? cells.firstChild[entry.cellIndex + 1] : static_cast<unsigned>(children.codes.size()));
+			for (unsigned c = firstChild; c < lastChild; ++c)
+			{
+				double squareDist = squareDistToCell(childLevel, children.codes[c]);
+				if (squareDist < threshold)
+				{
+					heap.push_back({squareDist, childLevel, c});
+					std::push_heap(heap.begin(), heap.end());
+				}
+			}
+		}
+	}
+
+	return std::sqrt(bestSquareDist);
+}
+
+bool ccCloudDistanceGrid::findNearestNeighbor(const CCVector3& P, unsigned& nearestIndex, double& distance, double maxDistance /*=0.0*/) const
+{
+	if (m_points.empty())
+	{
+		return false;
+	}
+
+	// search heap (one per thread)
+	thread_local std::vector<SearchEntry> s_heap;
+
+	unsigned sortedIndex = 0;
+	distance             = nearestNeighborDistance(P, maxDistance, 0.0, s_heap, &sortedIndex);
+	if (sortedIndex >= m_indexes.size())
+	{
+		return false;
+	}
+
+	nearestIndex = m_indexes[sortedIndex];
+	return true;
+}
+
+bool ccCloudDistanceGrid::computeDistances(CCCoreLib::GenericIndexedCloudPersist* comparedCloud,
+                                           CCCoreLib::ScalarField*                distances,
+                                           double                                 maxDistance /*=0.0*/,
+                                           double                                 tolerance /*=0.0*/,
+                                           CCCoreLib::GenericProgressCallback*    progressCb /*=nullptr*/,
+                                           int                                    maxThreadCount /*=0*/) const
+{
+	if (!comparedCloud || !distances || m_points.empty())
+	{
+		assert(false);
+		return false;
+	}
+
+	const unsigned pointCount = comparedCloud->size();
+	if (distances->currentSize() != pointCount && !distances->resizeSafe(pointCount))
+	{
+		ccLog::Warning("[ccCloudDistanceGrid] Not enough memory");
+		return false;
+	}
+
+	const int chunkCount = static_cast<int>((pointCount + s_chunkSize - 1) / s_chunkSize);
+
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Nearest neighbor distances");
+			progressCb->setInfo(qPrintable(QString("Compared points: %L1\nReference points: %L2").arg(pointCount).arg(size())));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+	CCCoreLib::NormalizedProgress nProgress(progressCb, static_cast<unsigned>(chunkCount));
+
+	std::atomic<bool> notEnoughMemory(false);
+	std::atomic<bool> canceled(false);
+
+#if defined(_OPENMP)
+	int threadCount = (maxThreadCount > 0 ? maxThreadCount : omp_get_max_threads());
+#pragma omp parallel num_threads(threadCount)
+#endif
+	{
+		// search heap (re-used for all the points processed by this thread)
+		std::vector<SearchEntry> heap;
+
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic)
+#endif
+		for (int c = 0; c < chunkCount; ++c)
+		{
+			if (notEnoughMemory || canceled)
+			{
+				continue;
+			}
+
+			const unsigned firstIndex = static_cast<unsigned>(c) * s_chunkSize;
+			const unsigned lastIndex  = std::min(firstIndex + s_chunkSize, pointCount);
+			try
+			{
+				for (unsigned i = firstIndex; i < lastIndex; ++i)
+				{
+					double distance = nearestNeighborDistance(*comparedCloud->getPoint(i), maxDistance, tolerance, heap);
+					distances->setValue(i, static_cast<ScalarType>(distance));
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				notEnoughMemory = true;
+			}
+
+			if (progressCb && !nProgress.oneStep())
+			{
+				canceled = true;
+			}
+		}
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (notEnoughMemory)
+	{
+		ccLog::Warning("[ccCloudDistanceGrid] Not enough memory");
+		return false;
+	}
+
+	return !canceled;
+}
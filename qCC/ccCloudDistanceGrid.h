@@ -0,0 +1,169 @@
+#pragma once
+
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+// #                                                                        #
+// ##########################################################################
+
+// qCC_db
+#include <ccBBox.h>
+
+// Qt
+#include <QSharedPointer>
+
+// System
+#include <cstdint>
+#include <vector>
+
+class ccGenericPointCloud;
+
+namespace CCCoreLib
+{
+	class GenericIndexedCloudPersist;
+	class GenericProgressCallback;
+	class ScalarField;
+} // namespace CCCoreLib
+
+//! Multi-resolution grid to compute (approximate) nearest neighbor distances to a reference cloud
+/** The reference points are copied and sorted along a Z-order curve, with the same cubical
+    subdivision as CCCoreLib's octree. Hence each (non empty) cell of each level corresponds
+    to a contiguous range of points. The nearest neighbors are searched with a best-first
+    traversal of the cells, which stops as soon as the remaining cells are farther than the
+    current nearest point (minus the tolerance) or than the max search distance.
+
+    The grid doesn't depend on the compared cloud: it can be re-used for successive comparisons
+    with the same reference cloud (e.g. several epochs against a single reference), as long as
+    the reference cloud is not modified (the grid holds a copy of its points). See GetOrBuild.
+**/
+class ccCloudDistanceGrid
+{
+  public:
+	//! Shared type
+	using Shared = QSharedPointer<ccCloudDistanceGrid>;
+
+	//! Returns the grid of a given cloud, from the cache if possible, or builds it
+	/** Only the grid of the last reference cloud is cached. It is released as soon as this cloud
+	    is deleted or its geometry is updated (see ccHObject::notifyGeometryUpdate), or if its number
+	    of points or its bounding-box have changed. To be called by the main thread only.
+	    \param cloud reference cloud
+	    \param progressCb progress callback (optional)
+	    \return the grid (or a null pointer if not enough memory)
+	**/
+	static Shared GetOrBuild(ccGenericPointCloud* cloud, CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
+	//! Releases the cached grid (if any)
+	static void ReleaseCache();
+
+	//! Builds the grid of a given cloud (without caching it)
+	/** \param cloud reference cloud
+	    \param progressCb progress callback (optional)
+	    \return the grid (or a null pointer if not enough memory)
+	**/
+	static Shared Build(ccGenericPointCloud* cloud, CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
+	//! Computes the distance between each point of a cloud and its nearest neighbor in the reference cloud
+	/** \param comparedCloud compared cloud
+	    \param distances output scalar field (will be resized if necessary)
+	    \param maxDistance max search distance (the distance of farther points is set to this value - ignored if <= 0)
+	    \param tolerance max error on the distances (the greater, the faster)
+	    \param progressCb progress callback (optional)
+	    \param maxThreadCount max number of threads (0 = all)
+	    \return success
+	**/
+	bool computeDistances(CCCoreLib::GenericIndexedCloudPersist* comparedCloud,
+	                      CCCoreLib::ScalarField*                distances,
+	                      double                                 maxDistance    = 0.0,
+	                      double                                 tolerance      = 0.0,
+	                      CCCoreLib::GenericProgressCallback*    progressCb     = nullptr,
+	                      int                                    maxThreadCount = 0) const;
+
+	//! Looks for the nearest neighbor of a given point in the reference cloud
+	/** Thread-safe (can be called concurrently).
+	    \param P query point
+	    \param[out] nearestIndex index of the nearest point (in the reference cloud)
+	    \param[out] distance distance to the nearest point
+	    \param maxDistance max search distance (ignored if <= 0)
+	    \return whether a point has been found (within the max search distance)
+	**/
+	bool findNearestNeighbor(const CCVector3& P, unsigned& nearestIndex, double& distance, double maxDistance = 0.0) const;
+
+	//! Returns the number of (reference) points
+	inline unsigned size() const
+	{
+		return static_cast<unsigned>(m_points.size());
+	}
+
+	//! Returns the finest level of the grid
+	inline unsigned char finestLevel() const
+	{
+		return static_cast<unsigned char>(m_levels.size() - 1);
+	}
+
+	//! Returns the cell size at a given level (same subdivision as the octree)
+	double cellSize(unsigned char level) const;
+
+	//! Returns the mean number of points per (non empty) cell at a given level
+	/** Extrapolated for the levels finer than the finest one.
+	**/
+	double meanPointsPerCell(unsigned char level) const;
+
+  protected:
+	//! Default constructor
+	ccCloudDistanceGrid();
+
+	//! Cell candidate (nearest neighbor search)
+	struct SearchEntry
+	{
+		//! Squared distance between the query point and the cell
+		double squareDist;
+		//! Cell level
+		unsigned char level;
+		//! Cell index (in its level)
+		unsigned cellIndex;
+
+		//! Comparison operator (to get a min-heap with the std heap methods)
+		inline bool operator<(const SearchEntry& other) const
+		{
+			return squareDist > other.squareDist;
+		}
+	};
+
+	//! Returns the distance between a point and its nearest neighbor (or the max distance if there's none closer)
+	/** \param nearestIndex if not null, the (sorted) index of the nearest point is output (or -1 if there's none closer than the max distance)
+	**/
+	double nearestNeighborDistance(const CCVector3& P, double maxDistance, double tolerance, std::vector<SearchEntry>& heap, unsigned* nearestIndex = nullptr) const;
+
+	//! Cells of one level (sorted by code)
+	struct Level
+	{
+		//! Truncated codes
+		std::vector<uint64_t> codes;
+		//! Index of the first point of each cell
+		std::vector<unsigned> firstPoint;
+		//! Index of the first child cell (in the next level)
+		std::vector<unsigned> firstChild;
+	};
+
+	//! Sorted points
+	std::vector<CCVector3> m_points;
+	//! Original index of the sorted points
+	std::vector<unsigned> m_indexes;
+	//! Levels (from 0 = a single cell, to the finest one)
+	std::vector<Level> m_levels;
+	//! Grid origin
+	CCVector3 m_origin;
+	//! Grid (cubical) dimension
+	double m_dimension;
+};
@@ -33,6 +33,7 @@
 #include "ccLibAlgorithms.h"
 #include "ccRegistrationTools.h"
 #include "ccScalarFieldArithmeticsDlg.h"
+#include "ccScalarFieldExpression.h"
 
 // Qt
 #include "ccCommandLineCommands.h"
@@ -55,6 +56,10 @@ constexpr char COMMAND_HIERARCHY_EXPORT_FORMAT[]          = "H_EXPORT_FMT";
 constexpr char COMMAND_OPEN[]                             = "O";    //+ file name
 constexpr char COMMAND_OPEN_SKIP_LINES[]                  = "SKIP"; //+ number of lines to skip
 constexpr char COMMAND_OPEN_NO_LABEL[]                    = "NO_LABEL";
+constexpr char COMMAND_OPEN_RANDOM_RATIO[]                = "RANDOM_RATIO"; //+ ratio of points to keep (load-time filter)
+constexpr char COMMAND_OPEN_MIN_SPACING[]                 = "MIN_SPACING";  //+ min distance between points (load-time filter)
+constexpr char COMMAND_OPEN_CROP_BOX[]                    = "CROP_BOX";     //+ Xmin Ymin Zmin Xmax Ymax Zmax (load-time filter)
+constexpr char COMMAND_OPEN_SF_RANGE[]                    = "SF_RANGE";     //+ SF name + min + max (load-time filter)
 constexpr char COMMAND_COMMAND_FILE[]                     = "COMMAND_FILE"; //+ file name
 constexpr char COMMAND_SUBSAMPLE[]                        = "SS";           //+ method (RANDOM/SPATIAL/OCTREE) + parameter (resp. point count / spatial step / octree level)
 constexpr char COMMAND_EXTRACT_CC[]                       = "EXTRACT_CC";
@@ -125,6 +130,7 @@ constexpr char COMMAND_SF_ARITHMETIC_IN_PLACE[]           = "IN_PLACE";
 constexpr char COMMAND_SF_OP[]                            = "SF_OP";
 constexpr char COMMAND_SF_OP_NOT_IN_PLACE[]               = "NOT_IN_PLACE";
 constexpr char COMMAND_SF_OP_SF[]                         = "SF_OP_SF";
+constexpr char COMMAND_SF_EXPR[]                          = "SF_EXPR";
 constexpr char COMMAND_SF_INTERP[]                        = "SF_INTERP";
 constexpr char COMMAND_COLOR_INTERP[]                     = "COLOR_INTERP";
 constexpr char COMMAND_SF_INTERP_DEST_IS_FIRST[]          = "DEST_IS_FIRST";
@@ -153,6 +159,8 @@ constexpr char COMMAND_ICP_SKIP_TX[]                      = "SKIP_TX";
 constexpr char COMMAND_ICP_SKIP_TY[]                      = "SKIP_TY";
 constexpr char COMMAND_ICP_SKIP_TZ[]                      = "SKIP_TZ";
 constexpr char COMMAND_ICP_C2M_DIST[]                     = "USE_C2M_DIST";
+constexpr char COMMAND_ICP_METRIC[]                       = "METRIC";
+constexpr char COMMAND_ICP_MULTI_RES[]                    = "MULTI_RES";
 constexpr char COMMAND_PLY_EXPORT_FORMAT[]                = "PLY_EXPORT_FMT";
 constexpr char COMMAND_COMPUTE_GRIDDED_NORMALS[]          = "COMPUTE_NORMALS";
 constexpr char COMMAND_INVERT_NORMALS[]                   = "INVERT_NORMALS";
@@ -640,6 +648,8 @@ bool CommandLoad::process(ccCommandLineInterface& cmd)
 	int                                        skipLines = 0;
 	ccCommandLineInterface::GlobalShiftOptions globalShiftOptions;
 	bool                                       doNotCreateLabels = false;
+	ccLoadingFilter::Parameters                filterParams;
+	bool                                       useLoadingFilter = false;
 
 	while (!cmd.arguments().empty())
 	{
@@ -672,6 +682,90 @@ bool CommandLoad::process(ccCommandLineInterface& cmd)
 
 			cmd.print(QObject::tr("Will skip %1 lines").arg(skipLines));
 		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_OPEN_RANDOM_RATIO))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			bool ok = false;
+			if (!cmd.arguments().empty())
+			{
+				filterParams.randomRatio = cmd.arguments().takeFirst().toDouble(&ok);
+			}
+			if (!ok || filterParams.randomRatio <= 0.0 || filterParams.randomRatio > 1.0)
+			{
+				return cmd.error(QObject::tr("Missing or invalid parameter: ratio (in ]0, 1]) after '%1'").arg(COMMAND_OPEN_RANDOM_RATIO));
+			}
+
+			cmd.print(QObject::tr("Will randomly keep %1% of the points").arg(filterParams.randomRatio * 100.0));
+			useLoadingFilter = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_OPEN_MIN_SPACING))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			bool ok = false;
+			if (!cmd.arguments().empty())
+			{
+				filterParams.minSpacing = cmd.arguments().takeFirst().toDouble(&ok);
+			}
+			if (!ok || filterParams.minSpacing < 0.0)
+			{
+				return cmd.error(QObject::tr("Missing or invalid parameter: distance after '%1'").arg(COMMAND_OPEN_MIN_SPACING));
+			}
+
+			cmd.print(QObject::tr("Will keep points at least %1 apart").arg(filterParams.minSpacing));
+			useLoadingFilter = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_OPEN_CROP_BOX))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			double bounds[6]{0, 0, 0, 0, 0, 0};
+			for (double& value : bounds)
+			{
+				bool ok = false;
+				if (!cmd.arguments().empty())
+				{
+					value = cmd.arguments().takeFirst().toDouble(&ok);
+				}
+				if (!ok)
+				{
+					return cmd.error(QObject::tr("Missing or invalid parameter: 6 values expected after '%1' (Xmin Ymin Zmin Xmax Ymax Zmax)").arg(COMMAND_OPEN_CROP_BOX));
+				}
+			}
+			filterParams.useBox = true;
+			filterParams.boxMin = CCVector3d(bounds[0], bounds[1], bounds[2]);
+			filterParams.boxMax = CCVector3d(bounds[3], bounds[4], bounds[5]);
+
+			cmd.print(QObject::tr("Will only keep the points inside the box (%1 ; %2 ; %3) - (%4 ; %5 ; %6)").arg(bounds[0]).arg(bounds[1]).arg(bounds[2]).arg(bounds[3]).arg(bounds[4]).arg(bounds[5]));
+			useLoadingFilter = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_OPEN_SF_RANGE))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().size() < 3)
+			{
+				return cmd.error(QObject::tr("Missing parameter(s): SF name, min and max values expected after '%1'").arg(COMMAND_OPEN_SF_RANGE));
+			}
+
+			bool okMin = false;
+			bool okMax = false;
+			filterParams.sfName = cmd.arguments().takeFirst();
+			filterParams.sfMin  = cmd.arguments().takeFirst().toDouble(&okMin);
+			filterParams.sfMax  = cmd.arguments().takeFirst().toDouble(&okMax);
+			if (!okMin || !okMax)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: min and max values expected after the SF name ('%1')").arg(COMMAND_OPEN_SF_RANGE));
+			}
+
+			cmd.print(QObject::tr("Will only keep the points with a '%1' value in [%2 ; %3]").arg(filterParams.sfName).arg(filterParams.sfMin).arg(filterParams.sfMax));
+			useLoadingFilter = true;
+		}
 		else if (cmd.nextCommandIsGlobalShift())
 		{
 			// local option confirmed, we can move on
@@ -695,14 +789,19 @@ bool CommandLoad::process(ccCommandLineInterface& cmd)
 	}
 	AsciiFilter::SetNoLabelCreated(doNotCreateLabels);
 
-	// open specified file
-	QString filename(cmd.arguments().takeFirst());
-	if (!cmd.importFile(filename, globalShiftOptions))
+	// load-time filter (only for this file)
+	if (useLoadingFilter)
 	{
-		return false;
+		cmd.fileLoadingParams().loadingFilter.reset(new ccLoadingFilter(filterParams));
 	}
 
-	return true;
+	// open specified file
+	QString filename(cmd.arguments().takeFirst());
+	bool    success = cmd.importFile(filename, globalShiftOptions);
+
+	cmd.fileLoadingParams().loadingFilter.reset();
+
+	return success;
 }
 
 CommandLoadCommandFile::CommandLoadCommandFile()
@@ -6505,6 +6604,74 @@ bool CommandSFOperationSF::process(ccCommandLineInterface& cmd)
 	return true;
 }
 
+CommandSFExpression::CommandSFExpression()
+    : ccCommandLineInterface::Command(QObject::tr("SF expression"), COMMAND_SF_EXPR)
+{
+}
+
+bool CommandSFExpression::process(ccCommandLineInterface& cmd)
+{
+	if (cmd.arguments().size() < 2)
+	{
+		return cmd.error(QObject::tr("Missing parameter(s): output SF name and expression after '%1' (2 values expected)").arg(COMMAND_SF_EXPR));
+	}
+
+	QString outputSFName = cmd.arguments().takeFirst();
+	QString expression   = cmd.arguments().takeFirst();
+	if (outputSFName.isEmpty())
+	{
+		return cmd.error(QObject::tr("Invalid output SF name (after %1)").arg(COMMAND_SF_EXPR));
+	}
+	cmd.print(QObject::tr("Expression: %1 = %2").arg(outputSFName, expression));
+
+	// apply the expression on clouds
+	for (CLCloudDesc& desc : cmd.clouds())
+	{
+		if (desc.pc)
+		{
+			QString errorMessage;
+			if (ccScalarFieldExpression::Apply(desc.pc, expression, outputSFName, errorMessage, cmd.progressDialog()) < 0)
+			{
+				return cmd.error(QObject::tr("Failed to apply the expression on cloud '%1': %2").arg(desc.pc->getName(), errorMessage));
+			}
+			else if (cmd.autoSaveMode())
+			{
+				QString errorStr = cmd.exportEntity(desc, "SF_EXPR");
+				if (!errorStr.isEmpty())
+				{
+					return cmd.error(errorStr);
+				}
+			}
+		}
+	}
+
+	// and meshes!
+	for (size_t j = 0; j < cmd.meshes().size(); ++j)
+	{
+		bool           isLocked = false;
+		ccGenericMesh* mesh     = cmd.meshes()[j].mesh;
+		ccPointCloud*  cloud    = ccHObjectCaster::ToPointCloud(mesh, &isLocked);
+		if (cloud && !isLocked)
+		{
+			QString errorMessage;
+			if (ccScalarFieldExpression::Apply(cloud, expression, outputSFName, errorMessage, cmd.progressDialog()) < 0)
+			{
+				return cmd.error(QObject::tr("Failed to apply the expression on mesh '%1': %2").arg(mesh->getName(), errorMessage));
+			}
+			else if (cmd.autoSaveMode())
+			{
+				QString errorStr = cmd.exportEntity(cmd.meshes()[j], "SF_EXPR");
+				if (!errorStr.isEmpty())
+				{
+					return cmd.error(errorStr);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
 CommandSFInterpolation::CommandSFInterpolation()
     : ccCommandLineInterface::Command(QObject::tr("SF interpolation"), COMMAND_SF_INTERP)
 {
@@ -7041,6 +7208,7 @@ bool CommandICP::process(ccCommandLineInterface& cmd)
 	bool                                              useC2MDistances       = false;
 	bool                                              robustC2MDistances    = true;
 	CCCoreLib::ICPRegistrationTools::NORMALS_MATCHING normalsMatching       = CCCoreLib::ICPRegistrationTools::NO_NORMAL;
+	ccRegistrationTools::MultiResolutionParams        multiResParams;
 
 	while (!cmd.arguments().empty())
 	{
@@ -7247,6 +7415,65 @@ bool CommandICP::process(ccCommandLineInterface& cmd)
 			// local option confirmed, we can move on
 			cmd.arguments().pop_front();
 		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_METRIC))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: metric after '%1'").arg(COMMAND_ICP_METRIC));
+			}
+
+			QString metric = cmd.arguments().takeFirst().toUpper();
+			if (metric == "POINT_TO_POINT")
+			{
+				multiResParams.metric = ccRegistrationTools::ICPMetric::POINT_TO_POINT;
+			}
+			else if (metric == "POINT_TO_PLANE")
+			{
+				multiResParams.metric = ccRegistrationTools::ICPMetric::POINT_TO_PLANE;
+			}
+			else if (metric == "SYMMETRIC")
+			{
+				multiResParams.metric = ccRegistrationTools::ICPMetric::SYMMETRIC;
+			}
+			else
+			{
+				return cmd.error(QObject::tr("Unknown ICP metric: ") + metric);
+			}
+			multiResParams.enabled = true;
+			cmd.print(QObject::tr("[ICP] Multi-resolution engine with metric: %1").arg(metric));
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_MULTI_RES))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().size() < 2)
+			{
+				return cmd.error(QObject::tr("Missing parameter(s): number of levels and finest voxel size after '%1'").arg(COMMAND_ICP_MULTI_RES));
+			}
+
+			bool     ok         = false;
+			QString  arg        = cmd.arguments().takeFirst();
+			unsigned levelCount = arg.toUInt(&ok);
+			if (!ok || levelCount == 0)
+			{
+				return cmd.error(QObject::tr("Invalid number of levels! (%1)").arg(arg));
+			}
+			arg              = cmd.arguments().takeFirst();
+			double voxelSize = arg.toDouble(&ok);
+			if (!ok || voxelSize < 0)
+			{
+				return cmd.error(QObject::tr("Invalid voxel size! (%1)").arg(arg));
+			}
+
+			multiResParams.enabled    = true;
+			multiResParams.levelCount = levelCount;
+			multiResParams.voxelSize  = voxelSize;
+			cmd.print(QObject::tr("[ICP] Multi-resolution engine: %1 level(s), finest voxel size = %2").arg(levelCount).arg(voxelSize > 0 ? QString::number(voxelSize) : QString("auto")));
+		}
 		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_C2M_DIST))
 		{
 			useC2MDistances = true;
@@ -7396,7 +7623,8 @@ bool CommandICP::process(ccCommandLineInterface& cmd)
 	                             parameters,
 	                             dataWeightsSFIndex >= 0,
 	                             modelWeightsSFIndex >= 0,
-	                             cmd.widgetParent()))
+	                             cmd.widgetParent(),
+	                             &multiResParams))
 	{
 		ccHObject* data = dataAndModel[0]->getEntity();
 		data->applyGLTransformation_recursive(&transMat);
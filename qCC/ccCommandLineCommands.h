@@ -446,6 +446,13 @@ struct CommandSFOperationSF : public ccCommandLineInterface::Command
 	bool process(ccCommandLineInterface& cmd) override;
 };
 
+struct CommandSFExpression : public ccCommandLineInterface::Command
+{
+	CommandSFExpression();
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
 struct CommandSFInterpolation : public ccCommandLineInterface::Command
 {
 	CommandSFInterpolation();
@@ -908,6 +908,7 @@ void ccCommandLineParser::registerBuiltInCommands()
 	registerCommand(Command::Shared(new CommandSFArithmetic));
 	registerCommand(Command::Shared(new CommandSFOperation));
 	registerCommand(Command::Shared(new CommandSFOperationSF));
+	registerCommand(Command::Shared(new CommandSFExpression));
 	registerCommand(Command::Shared(new CommandSFInterpolation));
 	registerCommand(Command::Shared(new CommandColorInterpolation));
 	registerCommand(Command::Shared(new CommandFilter));
@@ -42,6 +42,8 @@ constexpr char COMMAND_RASTER_PROJ_AVG[]               = "AVG";
 constexpr char COMMAND_RASTER_PROJ_MED[]               = "MED";
 constexpr char COMMAND_RASTER_PROJ_INVERSE_VAR[]       = "INV_VAR";
 constexpr char COMMAND_RASTER_RESAMPLE[]               = "RESAMPLE";
+constexpr char COMMAND_RASTER_TILE_SIZE[]              = "TILE_SIZE";
+constexpr char COMMAND_RASTER_TILE_OVERLAP[]           = "TILE_OVERLAP";
 
 // 2.5D Volume calculation specific commands
 constexpr char COMMAND_VOLUME[]                 = "VOLUME";
@@ -151,6 +153,12 @@ bool CommandRasterize::process(ccCommandLineInterface& cmd)
 		krigingParams.autoGuess = true;
 	}
 	QString projStdDevSFDesc, sfProjStdDevSFDesc;
+	// tiled mode (only for raster outputs)
+	ccRasterizeTool::TileParams tileParams;
+	{
+		tileParams.tileSize = 0; // disabled by default
+	}
+	bool tileOverlapSet = false;
 
 	while (!cmd.arguments().empty())
 	{
@@ -300,6 +308,31 @@ bool CommandRasterize::process(ccCommandLineInterface& cmd)
 
 			resample = true;
 		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RASTER_TILE_SIZE))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			bool ok             = false;
+			tileParams.tileSize = cmd.arguments().isEmpty() ? 0 : cmd.arguments().takeFirst().toUInt(&ok);
+			if (!ok || tileParams.tileSize == 0)
+			{
+				return cmd.error(QString("Invalid tile size! (after %1)").arg(COMMAND_RASTER_TILE_SIZE));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RASTER_TILE_OVERLAP))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			bool ok            = false;
+			tileParams.overlap = cmd.arguments().isEmpty() ? 0 : cmd.arguments().takeFirst().toUInt(&ok);
+			if (!ok)
+			{
+				return cmd.error(QString("Invalid tile overlap! (after %1)").arg(COMMAND_RASTER_TILE_OVERLAP));
+			}
+			tileOverlapSet = true;
+		}
 		else
 		{
 			break;
@@ -350,6 +383,20 @@ bool CommandRasterize::process(ccCommandLineInterface& cmd)
 		cmd.warning("[Rasterize] The 'resample' option is set while the raster won't be exported as a cloud nor as a mesh");
 	}
 
+	if (tileParams.tileSize != 0)
+	{
+		if (outputCloud || outputMesh)
+		{
+			cmd.warning("[Rasterize] The tiled mode is only available for raster outputs (the full grid will be computed)");
+			tileParams.tileSize = 0;
+		}
+		else if (!tileOverlapSet && emptyCellFillStrategy == ccRasterGrid::INTERPOLATE_DELAUNAY && dInterpParams.maxEdgeLength > 0.0)
+		{
+			// the overlap should be large enough to contain the largest triangles
+			tileParams.overlap = std::max(tileParams.overlap, static_cast<unsigned>(std::ceil(dInterpParams.maxEdgeLength / gridStep)) + 1);
+		}
+	}
+
 	// we'll get the first two clouds
 	for (CLCloudDesc& cloudDesc : cmd.clouds())
 	{
@@ -392,6 +439,76 @@ bool CommandRasterize::process(ccCommandLineInterface& cmd)
 
 		cmd.print(QString("Grid size: %1 x %2").arg(gridWidth).arg(gridHeight));
 
+		ccRasterGrid::InterpolationType interpolationType   = ccRasterGrid::InterpolationTypeFromEmptyCellFillOption(emptyCellFillStrategy);
+		void*                           interpolationParams = nullptr;
+		switch (interpolationType)
+		{
+		case ccRasterGrid::InterpolationType::DELAUNAY:
+			interpolationParams = (void*)&dInterpParams;
+			break;
+		case ccRasterGrid::InterpolationType::KRIGING:
+			interpolationParams = (void*)&krigingParams;
+			break;
+		default:
+			// do nothing
+			break;
+		}
+
+		if (tileParams.tileSize != 0)
+		{
+			// tiled mode: the full grid is never held in memory
+			cmd.print(QString("[Rasterize] Tiled mode: tile size = %1 cells / overlap = %2 cells").arg(tileParams.tileSize).arg(tileParams.overlap));
+
+			// progress dialog
+			QScopedPointer<ccProgressDialog> pDlg(nullptr);
+			if (!cmd.silentMode())
+			{
+				pDlg.reset(new ccProgressDialog(true, cmd.widgetParent()));
+			}
+
+			if (outputRasterZ)
+			{
+				ccRasterizeTool::ExportBands bands;
+				{
+					bands.height = true;
+					bands.rgb    = false; // not a good idea to mix RGB and height values!
+					bands.allSFs = outputRasterSFs;
+				}
+				QString exportFilename = cmd.getExportFilename(cloudDesc, "tif", outputRasterSFs ? "RASTER_Z_AND_SF" : "RASTER_Z", nullptr, !cmd.addTimestamp());
+				if (exportFilename.isEmpty())
+				{
+					exportFilename = "rasterZ.tif";
+				}
+
+				if (!ccRasterizeTool::RasterizeToTiledGeoTiff(exportFilename, bands, cloudDesc.pc, gridBBox, gridStep, vertDir, projectionType, sfProjectionType, emptyCellFillStrategy, interpolationParams, tileParams, customHeight, invVarProjSFIndex, -1, pDlg.data()))
+				{
+					return cmd.error("Rasterize process failed");
+				}
+			}
+
+			if (outputRasterRGB)
+			{
+				ccRasterizeTool::ExportBands bands;
+				{
+					bands.rgb    = true;
+					bands.height = false; // not a good idea to mix RGB and height values!
+					bands.allSFs = outputRasterSFs;
+				}
+				QString exportFilename = cmd.getExportFilename(cloudDesc, "tif", "RASTER_RGB", nullptr, !cmd.addTimestamp());
+				if (exportFilename.isEmpty())
+				{
+					exportFilename = "rasterRGB.tif";
+				}
+
+				if (!ccRasterizeTool::RasterizeToTiledGeoTiff(exportFilename, bands, cloudDesc.pc, gridBBox, gridStep, vertDir, projectionType, sfProjectionType, emptyCellFillStrategy, interpolationParams, tileParams, customHeight, invVarProjSFIndex, -1, pDlg.data()))
+				{
+					return cmd.error("Rasterize process failed");
+				}
+			}
+
+			continue;
+		}
+
 		if (gridWidth * gridHeight > (1 << 26)) // 64 million of cells
 		{
 			if (cmd.silentMode())
@@ -426,21 +543,6 @@ bool CommandRasterize::process(ccCommandLineInterface& cmd)
 				pDlg.reset(new ccProgressDialog(true, cmd.widgetParent()));
 			}
 
-			ccRasterGrid::InterpolationType interpolationType   = ccRasterGrid::InterpolationTypeFromEmptyCellFillOption(emptyCellFillStrategy);
-			void*                           interpolationParams = nullptr;
-			switch (interpolationType)
-			{
-			case ccRasterGrid::InterpolationType::DELAUNAY:
-				interpolationParams = (void*)&dInterpParams;
-				break;
-			case ccRasterGrid::InterpolationType::KRIGING:
-				interpolationParams = (void*)&krigingParams;
-				break;
-			default:
-				// do nothing
-				break;
-			}
-
 			if (grid.fillWith(cloudDesc.pc,
 			                  vertDir,
 			                  projectionType,
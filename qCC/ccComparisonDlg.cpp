@@ -73,6 +73,8 @@ ccComparisonDlg::ccComparisonDlg(ccHObject*         compEntity,
     , m_refMesh(nullptr)
     , m_refOctree(nullptr)
     , m_refOctreeIsPartial(false)
+    , m_refGrid(nullptr)
+    , m_approxTolerance(0.0)
     , m_refVisibility(false)
     , m_compType(cpType)
     , m_noDisplay(noDisplay)
@@ -274,6 +276,9 @@ void ccComparisonDlg::releaseOctrees()
 		m_refOctree.clear();
 		m_refOctreeIsPartial = false;
 	}
+
+	// the grid itself may remain cached (see ccCloudDistanceGrid::GetOrBuild)
+	m_refGrid.clear();
 }
 
 void ccComparisonDlg::updateDisplay(bool showSF, bool showRef)
@@ -352,13 +357,26 @@ bool ccComparisonDlg::computeApproxDistances()
 	{
 	case CLOUDCLOUD_DIST: // cloud-cloud
 	{
-		approxResult = CCCoreLib::DistanceComputationTools::computeApproxCloud2CloudDistance(m_compCloud,
-		                                                                                     m_refCloud,
-		                                                                                     DEFAULT_OCTREE_LEVEL,
-		                                                                                     0,
-		                                                                                     progressDlg.data(),
-		                                                                                     m_compOctree.data(),
-		                                                                                     m_refOctree.data());
+		// we use a (cached) multi-resolution grid instead of the octrees (much faster, and the grid
+		// is re-used for the successive comparisons with the same reference cloud, until it's modified)
+		m_refGrid = ccCloudDistanceGrid::GetOrBuild(m_refCloud, progressDlg.data());
+		if (!m_refGrid)
+		{
+			// not enough memory
+			break;
+		}
+
+		// same error as the former octree-based approximation
+		m_approxTolerance = m_refGrid->cellSize(DEFAULT_OCTREE_LEVEL) / 2.0;
+		if (m_refGrid->computeDistances(m_compCloud,
+		                                sf,
+		                                0,
+		                                m_approxTolerance,
+		                                progressDlg.data(),
+		                                maxThreadCountSpinBox->value()))
+		{
+			approxResult = 0;
+		}
 	}
 	break;
 
@@ -432,8 +450,12 @@ bool ccComparisonDlg::computeApproxDistances()
 		approxStats->setItem(curRow++, 1, new QTableWidgetItem(QString("%1").arg(variance >= 0.0 ? sqrt(variance) : variance)));
 
 		// Max relative error
-		PointCoordinateType cs = m_compOctree->getCellSize(DEFAULT_OCTREE_LEVEL);
-		double              e  = cs / 2.0;
+		double e = m_approxTolerance;
+		if (m_compType == CLOUDMESH_DIST)
+		{
+			PointCoordinateType cs = m_compOctree->getCellSize(DEFAULT_OCTREE_LEVEL);
+			e                      = cs / 2.0;
+		}
 		approxStats->setItem(curRow, 0, new QTableWidgetItem("Max error"));
 		approxStats->setItem(curRow++, 1, new QTableWidgetItem(QString("%1").arg(e)));
 
@@ -493,6 +515,21 @@ int ccComparisonDlg::determineBestOctreeLevel(double maxSearchDist)
 		return -1;
 	}
 
+	// the approximate cloud/cloud distances don't require the compared cloud's octree anymore
+	if (m_compOctree->getNumberOfProjectedPoints() == 0)
+	{
+		QScopedPointer<ccProgressDialog> progressDlg;
+		if (parentWidget())
+		{
+			progressDlg.reset(new ccProgressDialog(true, this));
+		}
+		if (m_compOctree->build(progressDlg.data()) <= 0)
+		{
+			ccLog::Warning("Can't determine best octree level: failed to compute the compared cloud octree!");
+			return -1;
+		}
+	}
+
 	// evalutate the theoretical time for each octree level
 	const int           MAX_OCTREE_LEVEL = m_refMesh ? 9 : CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL; // DGM: can't go higher than level 9 with a mesh as the grid is 'plain' and would take too much memory!
 	std::vector<double> timings;
@@ -567,10 +604,14 @@ int ccComparisonDlg::determineBestOctreeLevel(double maxSearchDist)
 
 		// we also use the reference cloud density (points/cell) if we have the info
 		double refListDensity = 1.0;
-		if (m_refOctree)
+		if (m_refOctree && m_refOctree->getNumberOfProjectedPoints() != 0)
 		{
 			refListDensity = m_refOctree->computeMeanOctreeDensity(static_cast<unsigned char>(level));
 		}
+		else if (m_refGrid)
+		{
+			refListDensity = m_refGrid->meanPointsPerCell(static_cast<unsigned char>(level));
+		}
 
 		CCCoreLib::DgmOctree::CellCode tempCode = 0xFFFFFFFF;
 
@@ -638,7 +679,7 @@ int ccComparisonDlg::determineBestOctreeLevel(double maxSearchDist)
 				tempCode             = truncatedCode;
 			}
 
-			ScalarType pointDist = approxDistances->getValue(index);
+			ScalarType pointDist = approxDistances->getValue(c->theIndex);
 			if (maxDistanceDefined && pointDist > maxDistance)
 			{
 				pointDist = maxDistance;
@@ -18,6 +18,9 @@
 #ifndef CC_COMPARISON_DIALOG_HEADER
 #define CC_COMPARISON_DIALOG_HEADER
 
+// Local
+#include "ccCloudDistanceGrid.h"
+
 // qCC_db
 #include <ccOctree.h>
 
@@ -113,6 +116,10 @@ class ccComparisonDlg : public QDialog
 	ccOctree::Shared m_refOctree;
 	//! Whether the reference entity octree is partial or not
 	bool m_refOctreeIsPartial;
+	//! Reference cloud's distance grid (approximate cloud/cloud distances)
+	ccCloudDistanceGrid::Shared m_refGrid;
+	//! Max error of the approximate distances
+	double m_approxTolerance;
 	//! Initial reference entity visibility
 	bool m_refVisibility;
 
@@ -30,6 +30,9 @@
 #include <Neighbourhood.h>
 #include <PointProjectionTools.h>
 
+// Qt
+#include <QScopedPointer>
+
 #ifdef CC_CORE_LIB_USES_TBB
 #ifndef Q_MOC_RUN
 #if defined(emit)
@@ -362,17 +365,18 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 		}
 	}
 
-	// DEBUG MECHANISM
-	ccEnvelopeExtractorDlg debugDialog;
+	// DEBUG MECHANISM (the dialog is only created when required, as this method can be called from worker threads)
+	QScopedPointer<ccEnvelopeExtractorDlg> debugDialog;
 	ccPointCloud*          debugCloud            = nullptr;
 	ccPolyline*            debugEnvelope         = nullptr;
 	ccPointCloud*          debugEnvelopeVertices = nullptr;
 
 	if (enableVisualDebugMode)
 	{
-		debugDialog.init();
-		debugDialog.setGeometry(50, 50, 800, 600);
-		debugDialog.show();
+		debugDialog.reset(new ccEnvelopeExtractorDlg);
+		debugDialog->init();
+		debugDialog->setGeometry(50, 50, 800, 600);
+		debugDialog->show();
 		QCoreApplication::processEvents(); // make sure the dialog is visible or the call to zoomOn below won't be effective!
 
 		// create point cloud with all (2D) input points
@@ -385,7 +389,7 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 				debugCloud->addPoint(CCVector3(P.x, P.y, 0));
 			}
 			debugCloud->setPointSize(3);
-			debugDialog.addToDisplay(debugCloud, false); // the window will take care of deleting this entity!
+			debugDialog->addToDisplay(debugCloud, false); // the window will take care of deleting this entity!
 		}
 
 		// create polyline
@@ -407,7 +411,7 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 				debugEnvelope->setColor(ccColor::red);
 				debugEnvelopeVertices->setEnabled(false);
 				debugEnvelope->setClosed(envelopeType == FULL);
-				debugDialog.addToDisplay(debugEnvelope, false); // the window will take care of deleting this entity!
+				debugDialog->addToDisplay(debugEnvelope, false); // the window will take care of deleting this entity!
 			}
 			else
 			{
@@ -421,9 +425,9 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 		// set zoom
 		{
 			ccBBox box = debugCloud->getOwnBB();
-			debugDialog.zoomOn(box);
+			debugDialog->zoomOn(box);
 		}
-		debugDialog.refresh();
+		debugDialog->refresh();
 	}
 
 	// Warning: high STL containers usage ahead ;)
@@ -511,7 +515,7 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 				cc2DLabel* edgeLabel = nullptr;
 				cc2DLabel* label     = nullptr;
 
-				if (enableVisualDebugMode && !debugDialog.isSkipped())
+				if (enableVisualDebugMode && !debugDialog->isSkipped())
 				{
 					edgeLabel       = new cc2DLabel("edge");
 					unsigned indexA = 0;
@@ -528,15 +532,15 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 					edgeLabel->addPickedPoint(debugCloud, indexB);
 					edgeLabel->setVisible(true);
 					edgeLabel->setDisplayedIn2D(false);
-					debugDialog.addToDisplay(edgeLabel);
-					debugDialog.refresh();
+					debugDialog->addToDisplay(edgeLabel);
+					debugDialog->refresh();
 
 					label = new cc2DLabel("nearest point");
 					label->addPickedPoint(debugCloud, e.nearestPointIndex);
 					label->setVisible(true);
 					label->setSelected(true);
-					debugDialog.addToDisplay(label);
-					debugDialog.displayMessage(QString("nearest point found index #%1 (dist = %2)").arg(e.nearestPointIndex).arg(sqrt(e.nearestPointSquareDist)), true);
+					debugDialog->addToDisplay(label);
+					debugDialog->displayMessage(QString("nearest point found index #%1 (dist = %2)").arg(e.nearestPointIndex).arg(sqrt(e.nearestPointSquareDist)), true);
 				}
 
 				// check that we don't create too small edges!
@@ -551,7 +555,7 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 				//	pointFlags[P.index] = POINT_IGNORED;
 				//	edges.push(e); //retest the edge!
 				//	if (enableVisualDebugMode)
-				//		debugDialog.displayMessage("nearest point is too close!",true);
+				//		debugDialog->displayMessage("nearest point is too close!",true);
 				// }
 
 				// last check: the new segments must not intersect with the actual hull!
@@ -586,7 +590,7 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 
 					somethingHasChanged = true;
 
-					if (enableVisualDebugMode && !debugDialog.isSkipped())
+					if (enableVisualDebugMode && !debugDialog->isSkipped())
 					{
 						if (debugEnvelope && debugEnvelopeVertices)
 						{
@@ -601,9 +605,9 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 							}
 							debugEnvelope->reserve(hullSize);
 							debugEnvelope->addPointIndex(hullSize - 1);
-							debugDialog.refresh();
+							debugDialog->refresh();
 						}
-						debugDialog.displayMessage("point has been added to envelope", true);
+						debugDialog->displayMessage("point has been added to envelope", true);
 					}
 
 					// update all edges that were having 'P' as their nearest candidate as well
@@ -703,26 +707,26 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 				else
 				{
 					if (enableVisualDebugMode)
-						debugDialog.displayMessage("[rejected] new edge would intersect the current envelope!", true);
+						debugDialog->displayMessage("[rejected] new edge would intersect the current envelope!", true);
 				}
 
 				// remove labels
 				if (label)
 				{
 					assert(enableVisualDebugMode);
-					debugDialog.removFromDisplay(label);
+					debugDialog->removFromDisplay(label);
 					delete label;
 					label = nullptr;
-					// debugDialog.refresh();
+					// debugDialog->refresh();
 				}
 
 				if (edgeLabel)
 				{
 					assert(enableVisualDebugMode);
-					debugDialog.removFromDisplay(edgeLabel);
+					debugDialog->removFromDisplay(edgeLabel);
 					delete edgeLabel;
 					edgeLabel = nullptr;
-					// debugDialog.refresh();
+					// debugDialog->refresh();
 				}
 			}
 		}
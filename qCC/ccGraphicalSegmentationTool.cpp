@@ -34,6 +34,7 @@
 #include <ccHObjectCaster.h>
 #include <ccLog.h>
 #include <ccMesh.h>
+#include <ccOctree.h>
 #include <ccPointCloud.h>
 #include <ccPolyline.h>
 
@@ -54,7 +55,10 @@
 #include <QSettings>
 
 // System
+#include <algorithm>
 #include <assert.h>
+#include <cmath>
+#include <vector>
 
 #if defined(_OPENMP)
 // OpenMP
@@ -856,6 +860,235 @@ void ccGraphicalSegmentationTool::exportSelection()
 	segment(true, CCCoreLib::NAN_VALUE, true);
 }
 
+//! Rasterized inside/outside mask of a 2D polygon
+/** Each cell of the mask is either fully inside the polygon, fully outside, or crossed by
+    (at least) one of its edges. The (costly) exact point-in-polygon test is only required
+    for the points falling in the latter cells.
+**/
+class PolygonMask
+{
+  public:
+	//! Cell status
+	enum Status : unsigned char
+	{
+		OUTSIDE  = 0,
+		INSIDE   = 1,
+		BOUNDARY = 2
+	};
+
+	//! Builds the mask
+	/** \return false if not enough memory
+	**/
+	bool build(const ccPolyline* poly, unsigned maxGridSize = 512)
+	{
+		m_poly = poly;
+		m_cells.clear();
+
+		unsigned vertexCount = (poly ? poly->size() : 0);
+		if (vertexCount < 3)
+		{
+			return false;
+		}
+
+		// polygon bounding-box
+		m_minX = m_maxX = poly->getPoint(0)->x;
+		m_minY = m_maxY = poly->getPoint(0)->y;
+		for (unsigned i = 1; i < vertexCount; ++i)
+		{
+			const CCVector3* P = poly->getPoint(i);
+			m_minX             = std::min(m_minX, static_cast<double>(P->x));
+			m_maxX             = std::max(m_maxX, static_cast<double>(P->x));
+			m_minY             = std::min(m_minY, static_cast<double>(P->y));
+			m_maxY             = std::max(m_maxY, static_cast<double>(P->y));
+		}
+
+		double maxDim = std::max(m_maxX - m_minX, m_maxY - m_minY);
+		if (maxDim <= 0)
+		{
+			return false;
+		}
+		m_cellSize = maxDim / maxGridSize;
+		m_width    = std::max(1, static_cast<int>(std::ceil((m_maxX - m_minX) / m_cellSize)));
+		m_height   = std::max(1, static_cast<int>(std::ceil((m_maxY - m_minY) / m_cellSize)));
+
+		try
+		{
+			m_cells.resize(static_cast<size_t>(m_width) * m_height, OUTSIDE);
+		}
+		catch (const std::bad_alloc&)
+		{
+			return false;
+		}
+
+		// flag the cells crossed by the polygon edges
+		for (unsigned i = 0; i < vertexCount; ++i)
+		{
+			const CCVector3* A = poly->getPoint(i);
+			const CCVector3* B = poly->getPoint((i + 1) % vertexCount);
+			flagSegment(A->x, A->y, B->x, B->y);
+		}
+
+		// the cells of a same row between two boundary cells share the same status
+		for (int j = 0; j < m_height; ++j)
+		{
+			unsigned char* row = m_cells.data() + static_cast<size_t>(j) * m_width;
+			for (int i = 0; i < m_width;)
+			{
+				if (row[i] == BOUNDARY)
+				{
+					++i;
+					continue;
+				}
+
+				CCVector2 C(static_cast<PointCoordinateType>(m_minX + (i + 0.5) * m_cellSize),
+				            static_cast<PointCoordinateType>(m_minY + (j + 0.5) * m_cellSize));
+				unsigned char status = (CCCoreLib::ManualSegmentationTools::isPointInsidePoly(C, poly) ? INSIDE : OUTSIDE);
+				for (; i < m_width && row[i] != BOUNDARY; ++i)
+				{
+					row[i] = status;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	//! Returns whether the mask is valid
+	inline bool isValid() const
+	{
+		return !m_cells.empty();
+	}
+
+	//! Tests whether a point is inside the polygon
+	inline bool isInside(const CCVector2& P) const
+	{
+		if (!isValid())
+		{
+			return CCCoreLib::ManualSegmentationTools::isPointInsidePoly(P, m_poly);
+		}
+
+		int i = static_cast<int>(std::floor((P.x - m_minX) / m_cellSize));
+		int j = static_cast<int>(std::floor((P.y - m_minY) / m_cellSize));
+		if (i < 0 || j < 0 || i >= m_width || j >= m_height)
+		{
+			return false;
+		}
+
+		unsigned char status = m_cells[static_cast<size_t>(j) * m_width + i];
+		if (status == BOUNDARY)
+		{
+			return CCCoreLib::ManualSegmentationTools::isPointInsidePoly(P, m_poly);
+		}
+		return (status == INSIDE);
+	}
+
+	//! Returns the status of a 2D rectangle (OUTSIDE, INSIDE or BOUNDARY if it's mixed or undetermined)
+	Status rectangleStatus(double minX, double minY, double maxX, double maxY) const
+	{
+		if (!isValid())
+		{
+			return BOUNDARY;
+		}
+		if (maxX < m_minX || minX > m_maxX || maxY < m_minY || minY > m_maxY)
+		{
+			// no overlap with the polygon bounding-box
+			return OUTSIDE;
+		}
+		if (minX < m_minX || minY < m_minY || maxX > m_maxX || maxY > m_maxY)
+		{
+			// partially outside of the bounding-box: the rectangle can't be fully inside
+			bool allOutside = true;
+			forEachCell(minX, minY, maxX, maxY, [&](unsigned char status) { allOutside &= (status == OUTSIDE); return allOutside; });
+			return (allOutside ? OUTSIDE : BOUNDARY);
+		}
+
+		unsigned char refStatus = m_cells[cellIndex(minX, minY)];
+		if (refStatus == BOUNDARY)
+		{
+			return BOUNDARY;
+		}
+		bool sameStatus = true;
+		forEachCell(minX, minY, maxX, maxY, [&](unsigned char status) { sameStatus &= (status == refStatus); return sameStatus; });
+		return (sameStatus ? static_cast<Status>(refStatus) : BOUNDARY);
+	}
+
+  protected:
+	//! Returns the index of the (clamped) cell containing a given point
+	inline size_t cellIndex(double x, double y) const
+	{
+		int i = std::clamp(static_cast<int>(std::floor((x - m_minX) / m_cellSize)), 0, m_width - 1);
+		int j = std::clamp(static_cast<int>(std::floor((y - m_minY) / m_cellSize)), 0, m_height - 1);
+		return static_cast<size_t>(j) * m_width + i;
+	}
+
+	//! Calls a visitor on all the cells overlapped by a rectangle (until it returns false)
+	template <class Visitor>
+	void forEachCell(double minX, double minY, double maxX, double maxY, Visitor visitor) const
+	{
+		int i0 = std::clamp(static_cast<int>(std::floor((minX - m_minX) / m_cellSize)), 0, m_width - 1);
+		int i1 = std::clamp(static_cast<int>(std::floor((maxX - m_minX) / m_cellSize)), 0, m_width - 1);
+		int j0 = std::clamp(static_cast<int>(std::floor((minY - m_minY) / m_cellSize)), 0, m_height - 1);
+		int j1 = std::clamp(static_cast<int>(std::floor((maxY - m_minY) / m_cellSize)), 0, m_height - 1);
+		for (int j = j0; j <= j1; ++j)
+		{
+			const unsigned char* row = m_cells.data() + static_cast<size_t>(j) * m_width;
+			for (int i = i0; i <= i1; ++i)
+			{
+				if (!visitor(row[i]))
+				{
+					return;
+				}
+			}
+		}
+	}
+
+	//! Flags all the cells crossed by a segment as BOUNDARY cells
+	void flagSegment(double xA, double yA, double xB, double yB)
+	{
+		if (xA > xB)
+		{
+			std::swap(xA, xB);
+			std::swap(yA, yB);
+		}
+
+		int i0 = std::clamp(static_cast<int>(std::floor((xA - m_minX) / m_cellSize)), 0, m_width - 1);
+		int i1 = std::clamp(static_cast<int>(std::floor((xB - m_minX) / m_cellSize)), 0, m_width - 1);
+		double slope = (xB > xA ? (yB - yA) / (xB - xA) : 0.0);
+
+		for (int i = i0; i <= i1; ++i)
+		{
+			// part of the segment inside this column
+			double x0 = std::max(xA, m_minX + i * m_cellSize);
+			double x1 = std::min(xB, m_minX + (i + 1) * m_cellSize);
+			double y0 = (xB > xA ? yA + (x0 - xA) * slope : yA);
+			double y1 = (xB > xA ? yA + (x1 - xA) * slope : yB);
+			if (y0 > y1)
+			{
+				std::swap(y0, y1);
+			}
+
+			// we add a small margin to be robust to rounding errors
+			int j0 = std::clamp(static_cast<int>(std::floor((y0 - m_minY) / m_cellSize - 1.0e-6)), 0, m_height - 1);
+			int j1 = std::clamp(static_cast<int>(std::floor((y1 - m_minY) / m_cellSize + 1.0e-6)), 0, m_height - 1);
+			for (int j = j0; j <= j1; ++j)
+			{
+				m_cells[static_cast<size_t>(j) * m_width + i] = BOUNDARY;
+			}
+		}
+	}
+
+	//! Associated polygon
+	const ccPolyline* m_poly = nullptr;
+	//! Cells
+	std::vector<unsigned char> m_cells;
+	//! Polygon bounding-box
+	double m_minX = 0.0, m_minY = 0.0, m_maxX = 0.0, m_maxY = 0.0;
+	//! Cell size
+	double m_cellSize = 1.0;
+	//! Grid dimensions
+	int m_width = 0, m_height = 0;
+};
+
 void ccGraphicalSegmentationTool::segment(bool keepPointsInside, ScalarType classificationValue /*=CCCoreLib::NAN_VALUE*/, bool exportSelection /*=false*/)
 {
 	if (!m_associatedWin)
@@ -908,6 +1141,13 @@ void ccGraphicalSegmentationTool::segment(bool keepPointsInside, ScalarType clas
 	}
 	ccLog::PrintDebug("Polyline is fully inside viewport: " + QString(polyInsideViewport ? "Yes" : "No"));
 
+	// rasterized version of the polygon (to speed up the point-in-polygon tests)
+	PolygonMask polyMask;
+	if (!polyMask.build(m_segmentationPoly))
+	{
+		ccLog::Warning("[Segmentation] Failed to build the polygon mask (not enough memory?), the process will be slower");
+	}
+
 	bool classificationMode = CCCoreLib::ScalarField::ValidValue(classificationValue);
 
 	// for each selected entity
@@ -964,52 +1204,152 @@ void ccGraphicalSegmentationTool::segment(bool keepPointsInside, ScalarType clas
 			pc->setCurrentDisplayedScalarField(sfIdx);
 		}
 
-		// we project each point and we check if it falls inside the segmentation polyline
-#if defined(_OPENMP)
-#pragma omp parallel for num_threads(omp_get_max_threads())
-#endif
-		for (int i = 0; i < cloudSize; ++i)
+		// tests if a point falls inside the segmentation polyline
+		auto isPointInside = [&](const CCVector3* P3D)
 		{
-			if (visibilityArray[i] == CCCoreLib::POINT_VISIBLE)
+			CCVector3d Q2D;
+			bool       pointInFrustum = false;
+			camera.project(*P3D, Q2D, &pointInFrustum);
+
+			if (pointInFrustum || !polyInsideViewport) // we can only skip the test if the point is outside the viewport/frustum AND the polyline is fully inside the viewport
 			{
-				const CCVector3* P3D = cloud->getPoint(i);
+				CCVector2 P2D(static_cast<PointCoordinateType>(Q2D.x - half_w),
+				              static_cast<PointCoordinateType>(Q2D.y - half_h));
+
+				return polyMask.isInside(P2D);
+			}
+
+			return false;
+		};
 
-				CCVector3d Q2D;
-				bool       pointInFrustum = false;
-				camera.project(*P3D, Q2D, &pointInFrustum);
+		// updates the point state depending on whether it's inside or not
+		auto processPoint = [&](int i, bool pointInside)
+		{
+			if (classifSF) // classification mode
+			{
+				if (pointInside)
+				{
+					classifSF->setValue(i, classificationValue);
+				}
+			}
+			else if (exportSelection)
+			{
+				// 'export inside selection' mode
+				assert(keepPointsInside == true);
+				visibilityArray[i] = (pointInside ? CCCoreLib::POINT_VISIBLE : CCCoreLib::POINT_HIDDEN);
 
-				bool pointInside = false;
-				if (pointInFrustum || !polyInsideViewport) // we can only skip the test if the point is outside the viewport/frustum AND the polyline is fully inside the viewport
+				if (pointInside)
 				{
-					CCVector2 P2D(static_cast<PointCoordinateType>(Q2D.x - half_w),
-					              static_cast<PointCoordinateType>(Q2D.y - half_h));
+					// (exported points or triangles will be hidden until the Segment tool is closed)
+					outVisibilityArray[i] = CCCoreLib::POINT_HIDDEN;
+				}
+			}
+			else
+			{
+				// standard segmentation mode
+				visibilityArray[i] = (keepPointsInside != pointInside ? CCCoreLib::POINT_HIDDEN : CCCoreLib::POINT_VISIBLE);
+			}
+		};
 
-					pointInside = CCCoreLib::ManualSegmentationTools::isPointInsidePoly(P2D, m_segmentationPoly);
+		// if the cloud already has an octree, we can process whole cells at once
+		ccOctree::Shared                           octree = cloud->getOctree();
+		CCCoreLib::DgmOctree::cellIndexesContainer cellIndexes;
+		unsigned char                              octreeLevel = 0;
+		if (octree && octree->getNumberOfProjectedPoints() == cloud->size() && polyMask.isValid())
+		{
+			octreeLevel = octree->findBestLevelForAGivenPopulationPerCell(256);
+			try
+			{
+				if (!octree->getCellIndexes(octreeLevel, cellIndexes))
+				{
+					cellIndexes.clear();
 				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				cellIndexes.clear();
+			}
+		}
 
-				if (classifSF) // classification mode
+		if (!cellIndexes.empty())
+		{
+			const CCCoreLib::DgmOctree::cellsContainer& cellCodes = octree->pointsAndTheirCellCodes();
+			const unsigned char                         bitDec    = CCCoreLib::DgmOctree::GET_BIT_SHIFT(octreeLevel);
+			const int                                   cellCount = static_cast<int>(cellIndexes.size());
+
+			// we project the cell corners and we check if the whole cell falls inside (or outside) the polyline
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(omp_get_max_threads())
+#endif
+			for (int c = 0; c < cellCount; ++c)
+			{
+				const unsigned firstIndex = cellIndexes[c];
+				const unsigned lastIndex  = (c + 1 < cellCount ? cellIndexes[c + 1] : static_cast<unsigned>(cellCodes.size()));
+
+				CCVector3 cellMin;
+				CCVector3 cellMax;
+				octree->computeCellLimits(cellCodes[firstIndex].theCode >> bitDec, octreeLevel, cellMin, cellMax, true);
+
+				// the projection of the cell is inside the bounding-box of its projected corners (if they are all inside the frustum)
+				PolygonMask::Status cellStatus = PolygonMask::BOUNDARY;
 				{
-					if (pointInside)
+					bool   allCornersInFrustum = true;
+					double minX                = 0.0;
+					double minY                = 0.0;
+					double maxX                = 0.0;
+					double maxY                = 0.0;
+					for (unsigned k = 0; k < 8 && allCornersInFrustum; ++k)
 					{
-						classifSF->setValue(i, classificationValue);
+						CCVector3 corner((k & 1) ? cellMax.x : cellMin.x,
+						                 (k & 2) ? cellMax.y : cellMin.y,
+						                 (k & 4) ? cellMax.z : cellMin.z);
+
+						CCVector3d Q2D;
+						camera.project(corner, Q2D, &allCornersInFrustum);
+						double x = Q2D.x - half_w;
+						double y = Q2D.y - half_h;
+						if (k == 0)
+						{
+							minX = maxX = x;
+							minY = maxY = y;
+						}
+						else
+						{
+							minX = std::min(minX, x);
+							maxX = std::max(maxX, x);
+							minY = std::min(minY, y);
+							maxY = std::max(maxY, y);
+						}
+					}
+
+					if (allCornersInFrustum)
+					{
+						cellStatus = polyMask.rectangleStatus(minX, minY, maxX, maxY);
 					}
 				}
-				else if (exportSelection)
-				{
-					// 'export inside selection' mode
-					assert(keepPointsInside == true);
-					visibilityArray[i] = (pointInside ? CCCoreLib::POINT_VISIBLE : CCCoreLib::POINT_HIDDEN);
 
-					if (pointInside)
+				for (unsigned n = firstIndex; n < lastIndex; ++n)
+				{
+					int i = static_cast<int>(cellCodes[n].theIndex);
+					if (visibilityArray[i] == CCCoreLib::POINT_VISIBLE)
 					{
-						// (exported points or triangles will be hidden until the Segment tool is closed)
-						outVisibilityArray[i] = CCCoreLib::POINT_HIDDEN;
+						bool pointInside = (cellStatus == PolygonMask::BOUNDARY ? isPointInside(cloud->getPoint(i)) : cellStatus == PolygonMask::INSIDE);
+						processPoint(i, pointInside);
 					}
 				}
-				else
+			}
+		}
+		else
+		{
+			// we project each point and we check if it falls inside the segmentation polyline
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+			for (int i = 0; i < cloudSize; ++i)
+			{
+				if (visibilityArray[i] == CCCoreLib::POINT_VISIBLE)
 				{
-					// standard segmentation mode
-					visibilityArray[i] = (keepPointsInside != pointInside ? CCCoreLib::POINT_HIDDEN : CCCoreLib::POINT_VISIBLE);
+					processPoint(i, isPointInside(cloud->getPoint(i)));
 				}
 			}
 		}
@@ -28,6 +28,7 @@
 
 // CCCoreLib
 #include <NormalDistribution.h>
+#include <ReferenceCloud.h>
 
 // qCC_db
 #include <ccColorScalesManager.h>
@@ -1680,6 +1681,645 @@ bool ccRasterizeTool::ExportGeoTiff(const QString&                    outputFile
 #endif
 }
 
+bool ccRasterizeTool::RasterizeToTiledGeoTiff(const QString&                    outputFilename,
+                                              const ExportBands&                exportBands,
+                                              ccPointCloud*                     cloud,
+                                              const ccBBox&                     gridBBox,
+                                              double                            gridStep,
+                                              unsigned char                     Z,
+                                              ccRasterGrid::ProjectionType      projectionType,
+                                              ccRasterGrid::ProjectionType      sfProjectionType,
+                                              ccRasterGrid::EmptyCellFillOption fillEmptyCellsStrategy,
+                                              void*                             interpolationParams,
+                                              const TileParams&                 tileParams,
+                                              double                            customHeightForEmptyCells /*=std::numeric_limits<double>::quiet_NaN()*/,
+                                              int                               zStdDevSfIndex /*=-1*/,
+                                              int                               visibleSfIndex /*=-1*/,
+                                              ccProgressDialog*                 progressDialog /*=nullptr*/)
+{
+#ifdef CC_GDAL_SUPPORT
+
+	if (!cloud || cloud->size() == 0 || !gridBBox.isValid() || gridStep <= 0.0 || Z > 2 || tileParams.tileSize == 0)
+	{
+		assert(false);
+		return false;
+	}
+	if (exportBands.visibleSF && visibleSfIndex < 0)
+	{
+		assert(false);
+		return false;
+	}
+
+	// vertical dimension
+	const unsigned char X = (Z == 2 ? 0 : Z + 1);
+	const unsigned char Y = (X == 2 ? 0 : X + 1);
+
+	// global grid size
+	unsigned width  = 0;
+	unsigned height = 0;
+	if (!ccRasterGrid::ComputeGridSize(Z, gridBBox, gridStep, width, height))
+	{
+		ccLog::Error("[Rasterize] Failed to compute the grid dimensions (check the bounding-box)");
+		return false;
+	}
+
+	// the tiles are aligned with the geotiff blocks
+	static const unsigned s_blockSize = 256;
+	const unsigned        tileSize    = ((tileParams.tileSize + s_blockSize - 1) / s_blockSize) * s_blockSize;
+	const unsigned        overlap     = tileParams.overlap;
+	const unsigned        tileCountX  = (width + tileSize - 1) / tileSize;
+	const unsigned        tileCountY  = (height + tileSize - 1) / tileSize;
+	const unsigned        tileCount   = tileCountX * tileCountY;
+
+	double stepX = gridStep;
+	double stepY = gridStep;
+
+	// global shift
+	double shiftX = gridBBox.minCorner().u[X] - stepX / 2; // we will declare the raster grid as 'Pixel-is-area'!
+	double shiftY = gridBBox.maxCorner().u[Y] + stepY / 2; // we will declare the raster grid as 'Pixel-is-area'!
+	double shiftZ = 0.0;
+	{
+		const CCVector3d& shift = cloud->getGlobalShift();
+		shiftX -= shift.u[X];
+		shiftY -= shift.u[Y];
+		shiftZ -= shift.u[Z];
+
+		double scale = cloud->getGlobalScale();
+		assert(scale != 0);
+		stepX /= scale;
+		stepY /= scale;
+	}
+
+	// scalar fields
+	bool     projectSFs = (sfProjectionType != ccRasterGrid::INVALID_PROJECTION_TYPE && cloud->hasScalarFields());
+	unsigned sfCount    = (projectSFs ? cloud->getNumberOfScalarFields() : 0);
+
+	std::vector<int> sfBandIndexes(sfCount, 0);
+	int              totalBands = 0;
+	bool             onlyRGBA   = true;
+
+	// the number of empty cells is unknown in advance
+	bool rgbaMode = (exportBands.rgb && fillEmptyCellsStrategy == ccRasterGrid::LEAVE_EMPTY);
+	int  rgbBand  = 0;
+	if (exportBands.rgb)
+	{
+		rgbBand = totalBands + 1;
+		totalBands += (rgbaMode ? 4 : 3);
+	}
+	int heightBand = 0;
+	if (exportBands.height)
+	{
+		heightBand = ++totalBands;
+		onlyRGBA   = false;
+	}
+	int densityBand = 0;
+	if (exportBands.density)
+	{
+		densityBand = ++totalBands;
+		onlyRGBA    = false;
+	}
+	for (unsigned k = 0; k < sfCount; ++k)
+	{
+		if (exportBands.allSFs || (exportBands.visibleSF && visibleSfIndex == static_cast<int>(k)))
+		{
+			sfBandIndexes[k] = ++totalBands;
+			onlyRGBA         = false;
+		}
+	}
+
+	if (totalBands == 0)
+	{
+		ccLog::Error("Can't output a raster with no band! (check export parameters)");
+		return false;
+	}
+
+	// sort the point indexes by tile (a point may belong to several tiles because of the overlap)
+	std::vector<size_t>   tileStart;
+	std::vector<unsigned> tilePointIndexes;
+	{
+		const CCVector3d gridMinCorner = gridBBox.minCorner();
+
+		// returns the range of tiles (with their overlap) that contain a given point (or false if the point is outside the grid)
+		auto getTileRange = [&](unsigned pointIndex, unsigned& txMin, unsigned& txMax, unsigned& tyMin, unsigned& tyMax) -> bool
+		{
+			const CCVector3* P = cloud->getPoint(pointIndex);
+			int              i = static_cast<int>((P->u[X] - gridMinCorner.u[X]) / gridStep + 0.5);
+			int              j = static_cast<int>((P->u[Y] - gridMinCorner.u[Y]) / gridStep + 0.5);
+			if (i < 0 || i >= static_cast<int>(width) || j < 0 || j >= static_cast<int>(height))
+			{
+				return false;
+			}
+			// the tiles are ordered from the top (northest) row of the raster
+			unsigned r = height - 1 - static_cast<unsigned>(j);
+			txMin      = (static_cast<unsigned>(i) > overlap ? static_cast<unsigned>(i) - overlap : 0) / tileSize;
+			txMax      = std::min(width - 1, static_cast<unsigned>(i) + overlap) / tileSize;
+			tyMin      = (r > overlap ? r - overlap : 0) / tileSize;
+			tyMax      = std::min(height - 1, r + overlap) / tileSize;
+			return true;
+		};
+
+		try
+		{
+			tileStart.resize(static_cast<size_t>(tileCount) + 2, 0);
+
+			unsigned pointCount = cloud->size();
+			unsigned txMin      = 0;
+			unsigned txMax      = 0;
+			unsigned tyMin      = 0;
+			unsigned tyMax      = 0;
+			for (unsigned n = 0; n < pointCount; ++n)
+			{
+				if (getTileRange(n, txMin, txMax, tyMin, tyMax))
+				{
+					for (unsigned ty = tyMin; ty <= tyMax; ++ty)
+					{
+						for (unsigned tx = txMin; tx <= txMax; ++tx)
+						{
+							++tileStart[ty * tileCountX + tx + 2];
+						}
+					}
+				}
+			}
+			for (size_t t = 2; t < tileStart.size(); ++t)
+			{
+				tileStart[t] += tileStart[t - 1];
+			}
+
+			tilePointIndexes.resize(tileStart.back());
+
+			for (unsigned n = 0; n < pointCount; ++n)
+			{
+				if (getTileRange(n, txMin, txMax, tyMin, tyMax))
+				{
+					for (unsigned ty = tyMin; ty <= tyMax; ++ty)
+					{
+						for (unsigned tx = txMin; tx <= txMax; ++tx)
+						{
+							tilePointIndexes[tileStart[ty * tileCountX + tx + 1]++] = n;
+						}
+					}
+				}
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Error("[Rasterize] Not enough memory");
+			return false;
+		}
+	}
+
+	GDALAllRegister();
+	ccLog::PrintDebug("(GDAL drivers: %i)", GetGDALDriverManager()->GetDriverCount());
+
+	const char  pszFormat[] = "GTiff";
+	GDALDriver* poDriver    = GetGDALDriverManager()->GetDriverByName(pszFormat);
+	if (!poDriver)
+	{
+		ccLog::Error("[GDAL] Driver %s is not supported", pszFormat);
+		return false;
+	}
+
+	char** papszMetadata = poDriver->GetMetadata();
+	if (!CSLFetchBoolean(papszMetadata, GDAL_DCAP_CREATE, FALSE))
+	{
+		ccLog::Error("[GDAL] Driver %s doesn't support Create() method", pszFormat);
+		return false;
+	}
+
+	QByteArray blockSizeStr = QByteArray::number(s_blockSize);
+	char**     papszOptions = nullptr;
+	papszOptions            = CSLSetNameValue(papszOptions, "TILED", "YES");
+	papszOptions            = CSLSetNameValue(papszOptions, "BLOCKXSIZE", blockSizeStr.constData());
+	papszOptions            = CSLSetNameValue(papszOptions, "BLOCKYSIZE", blockSizeStr.constData());
+	papszOptions            = CSLSetNameValue(papszOptions, "BIGTIFF", "IF_SAFER");
+
+	GDALDataset* poDstDS = poDriver->Create(qUtf8Printable(outputFilename),
+	                                        static_cast<int>(width),
+	                                        static_cast<int>(height),
+	                                        totalBands,
+	                                        onlyRGBA ? GDT_Byte : GDT_Float64,
+	                                        papszOptions);
+	CSLDestroy(papszOptions);
+	papszOptions = nullptr;
+
+	if (!poDstDS)
+	{
+		ccLog::Error("[GDAL] Failed to create output raster");
+		return false;
+	}
+
+	poDstDS->SetMetadataItem("AREA_OR_POINT", "AREA");
+
+	double adfGeoTransform[6]{
+	    shiftX, // top left x
+	    stepX,  // w-e pixel resolution (can be negative)
+	    0,      // 0
+	    shiftY, // top left y
+	    0,      // 0
+	    -stepY  // n-s pixel resolution (can be negative)
+	};
+
+	poDstDS->SetGeoTransform(adfGeoTransform);
+
+	// bands setup
+	if (rgbBand != 0)
+	{
+		poDstDS->GetRasterBand(rgbBand)->SetColorInterpretation(GCI_RedBand);
+		poDstDS->GetRasterBand(rgbBand + 1)->SetColorInterpretation(GCI_GreenBand);
+		poDstDS->GetRasterBand(rgbBand + 2)->SetColorInterpretation(GCI_BlueBand);
+		for (int k = 0; k < 3; ++k)
+		{
+			poDstDS->GetRasterBand(rgbBand + k)->SetStatistics(0, 255, 128, 0); // warning: arbitrary average and std. dev. values
+		}
+		if (rgbaMode)
+		{
+			poDstDS->GetRasterBand(rgbBand + 3)->SetColorInterpretation(GCI_AlphaBand);
+			poDstDS->GetRasterBand(rgbBand + 3)->SetStatistics(0, 255, 255, 0); // warning: arbitrary average and std. dev. values
+		}
+	}
+
+	double emptyCellHeight = std::numeric_limits<double>::quiet_NaN();
+	// whether the empty cells must be filled afterwards (with a global statistic)
+	bool fillEmptyCellsAfterwards = false;
+	if (heightBand != 0)
+	{
+		GDALRasterBand* poBand = poDstDS->GetRasterBand(heightBand);
+		poBand->SetColorInterpretation(GCI_Undefined);
+
+		switch (fillEmptyCellsStrategy)
+		{
+		case ccRasterGrid::LEAVE_EMPTY:
+			if (CE_None != poBand->SetNoDataValue(emptyCellHeight))
+			{
+				ccLog::Warning("[GDAL] Failed to set the No Data value");
+			}
+			break;
+		case ccRasterGrid::FILL_MINIMUM_HEIGHT:
+		case ccRasterGrid::FILL_MAXIMUM_HEIGHT:
+		case ccRasterGrid::FILL_AVERAGE_HEIGHT:
+			fillEmptyCellsAfterwards = true;
+			break;
+		case ccRasterGrid::FILL_CUSTOM_HEIGHT:
+		case ccRasterGrid::INTERPOLATE_DELAUNAY:
+			emptyCellHeight = customHeightForEmptyCells + shiftZ;
+			break;
+		case ccRasterGrid::KRIGING:
+			// nothing to do
+			break;
+		default:
+			assert(false);
+		}
+	}
+	if (densityBand != 0)
+	{
+		poDstDS->GetRasterBand(densityBand)->SetColorInterpretation(GCI_Undefined);
+	}
+	const double sfNanValue = std::numeric_limits<ccRasterGrid::SF::value_type>::quiet_NaN();
+	for (int sfBand : sfBandIndexes)
+	{
+		if (sfBand != 0)
+		{
+			GDALRasterBand* poBand = poDstDS->GetRasterBand(sfBand);
+			poBand->SetNoDataValue(sfNanValue); // should be transparent!
+			poBand->SetColorInterpretation(GCI_Undefined);
+		}
+	}
+
+	// tile buffers (only one tile is resident at a time)
+	std::vector<double>        valueBlock;
+	std::vector<unsigned char> byteBlock;
+	try
+	{
+		if (onlyRGBA)
+		{
+			byteBlock.resize(static_cast<size_t>(tileSize) * tileSize);
+		}
+		else
+		{
+			valueBlock.resize(static_cast<size_t>(tileSize) * tileSize);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Error("[Rasterize] Not enough memory");
+		GDALClose(poDstDS);
+		return false;
+	}
+
+	// global statistics (on the non-empty or interpolated cells)
+	double minHeight      = std::numeric_limits<double>::max();
+	double maxHeight      = -std::numeric_limits<double>::max();
+	double sumHeight      = 0.0;
+	size_t validCellCount = 0;
+
+	ccRasterGrid::InterpolationType interpolationType = ccRasterGrid::InterpolationTypeFromEmptyCellFillOption(fillEmptyCellsStrategy);
+
+	if (progressDialog)
+	{
+		progressDialog->setMethodTitle(QObject::tr("Tiled rasterization"));
+		progressDialog->setInfo(QObject::tr("Cells: %L1 x %L2\nTiles: %3 x %4").arg(width).arg(height).arg(tileCountX).arg(tileCountY));
+		progressDialog->start();
+		QCoreApplication::processEvents();
+	}
+	CCCoreLib::NormalizedProgress nProgress(progressDialog, tileCount);
+
+	bool error = false;
+	for (unsigned ty = 0; ty < tileCountY && !error; ++ty)
+	{
+		for (unsigned tx = 0; tx < tileCountX && !error; ++tx)
+		{
+			// tile core (in raster coordinates, i.e. the first row is the northest one)
+			unsigned x0 = tx * tileSize;
+			unsigned r0 = ty * tileSize;
+			unsigned w  = std::min(tileSize, width - x0);
+			unsigned h  = std::min(tileSize, height - r0);
+
+			// tile core (in grid coordinates, i.e. the first row is the southest one)
+			unsigned j0 = height - (r0 + h);
+			unsigned j1 = height - r0;
+
+			// tile extents (with the overlap)
+			unsigned ex0 = x0 - std::min(x0, overlap);
+			unsigned ex1 = std::min(width, x0 + w + overlap);
+			unsigned ej0 = j0 - std::min(j0, overlap);
+			unsigned ej1 = std::min(height, j1 + overlap);
+
+			ccRasterGrid tileGrid;
+			size_t       tileIndex = static_cast<size_t>(ty) * tileCountX + tx;
+			size_t       tileBegin = tileStart[tileIndex];
+			size_t       tileEnd   = tileStart[tileIndex + 1];
+			if (tileEnd > tileBegin)
+			{
+				CCCoreLib::ReferenceCloud tilePoints(cloud);
+				if (!tilePoints.reserve(static_cast<unsigned>(tileEnd - tileBegin)))
+				{
+					ccLog::Error("[Rasterize] Not enough memory");
+					error = true;
+					break;
+				}
+				for (size_t n = tileBegin; n < tileEnd; ++n)
+				{
+					tilePoints.addPointIndex(tilePointIndexes[n]); // can't fail (see above)
+				}
+
+				ccPointCloud* tileCloud = cloud->partialClone(&tilePoints, nullptr, false);
+				if (!tileCloud)
+				{
+					ccLog::Error("[Rasterize] Not enough memory");
+					error = true;
+					break;
+				}
+
+				CCVector3d tileMinCorner = gridBBox.minCorner();
+				tileMinCorner.u[X] += ex0 * gridStep;
+				tileMinCorner.u[Y] += ej0 * gridStep;
+
+				bool success = tileGrid.init(ex1 - ex0, ej1 - ej0, gridStep, tileMinCorner)
+				               && tileGrid.fillWith(tileCloud,
+				                                    Z,
+				                                    projectionType,
+				                                    interpolationType,
+				                                    interpolationParams,
+				                                    projectSFs ? sfProjectionType : ccRasterGrid::INVALID_PROJECTION_TYPE,
+				                                    nullptr,
+				                                    zStdDevSfIndex);
+
+				delete tileCloud;
+				tileCloud = nullptr;
+
+				if (!success)
+				{
+					ccLog::Error(QString("[Rasterize] Failed to rasterize tile (%1, %2)").arg(tx).arg(ty));
+					error = true;
+					break;
+				}
+			}
+
+			// returns the cell corresponding to a given position in the tile core (or nullptr if the tile is empty)
+			auto coreCell = [&](unsigned r, unsigned c) -> const ccRasterCell*
+			{
+				if (!tileGrid.isValid())
+				{
+					return nullptr;
+				}
+				return &tileGrid.rows[j1 - 1 - r - ej0][x0 + c - ex0];
+			};
+
+			// writes the current block in a given band
+			auto writeBlock = [&](int bandIndex, bool bytes) -> bool
+			{
+				return poDstDS->GetRasterBand(bandIndex)->RasterIO(GF_Write,
+				                                                   static_cast<int>(x0),
+				                                                   static_cast<int>(r0),
+				                                                   static_cast<int>(w),
+				                                                   static_cast<int>(h),
+				                                                   bytes ? static_cast<void*>(byteBlock.data()) : static_cast<void*>(valueBlock.data()),
+				                                                   static_cast<int>(w),
+				                                                   static_cast<int>(h),
+				                                                   bytes ? GDT_Byte : GDT_Float64,
+				                                                   0,
+				                                                   0)
+				       == CE_None;
+			};
+
+			// export RGB(A) bands
+			if (rgbBand != 0)
+			{
+				for (int k = 0; k < (rgbaMode ? 4 : 3) && !error; ++k)
+				{
+					for (unsigned r = 0; r < h; ++r)
+					{
+						for (unsigned c = 0; c < w; ++c)
+						{
+							const ccRasterCell* cell  = coreCell(r, c);
+							unsigned char       value = 0;
+							if (cell && std::isfinite(cell->h))
+							{
+								value = (k == 3 ? 255 : static_cast<unsigned char>(std::max(0.0, std::min(255.0, cell->color.u[k]))));
+							}
+							if (onlyRGBA)
+							{
+								byteBlock[r * w + c] = value;
+							}
+							else
+							{
+								valueBlock[r * w + c] = value;
+							}
+						}
+					}
+					if (!writeBlock(rgbBand + k, onlyRGBA))
+					{
+						ccLog::Error("[GDAL] An error occurred while writing the color bands!");
+						error = true;
+					}
+				}
+			}
+
+			// export height band
+			if (heightBand != 0 && !error)
+			{
+				for (unsigned r = 0; r < h; ++r)
+				{
+					for (unsigned c = 0; c < w; ++c)
+					{
+						const ccRasterCell* cell = coreCell(r, c);
+						if (cell && std::isfinite(cell->h))
+						{
+							minHeight = std::min(minHeight, cell->h);
+							maxHeight = std::max(maxHeight, cell->h);
+							sumHeight += cell->h;
+							++validCellCount;
+							valueBlock[r * w + c] = cell->h + shiftZ;
+						}
+						else
+						{
+							valueBlock[r * w + c] = emptyCellHeight;
+						}
+					}
+				}
+				if (!writeBlock(heightBand, false))
+				{
+					ccLog::Error("[GDAL] An error occurred while writing the height band!");
+					error = true;
+				}
+			}
+
+			// export density band
+			if (densityBand != 0 && !error)
+			{
+				for (unsigned r = 0; r < h; ++r)
+				{
+					for (unsigned c = 0; c < w; ++c)
+					{
+						const ccRasterCell* cell = coreCell(r, c);
+						valueBlock[r * w + c]    = (cell ? cell->nbPoints : 0);
+					}
+				}
+				if (!writeBlock(densityBand, false))
+				{
+					ccLog::Error("[GDAL] An error occurred while writing the density band!");
+					error = true;
+				}
+			}
+
+			// export SF bands
+			for (unsigned k = 0; k < sfCount && !error; ++k)
+			{
+				if (sfBandIndexes[k] == 0)
+				{
+					continue;
+				}
+
+				const double* sfGrid = (k < tileGrid.scalarFields.size() && !tileGrid.scalarFields[k].empty() ? tileGrid.scalarFields[k].data() : nullptr);
+				for (unsigned r = 0; r < h; ++r)
+				{
+					for (unsigned c = 0; c < w; ++c)
+					{
+						double value = sfNanValue;
+						if (sfGrid)
+						{
+							value = sfGrid[static_cast<size_t>(j1 - 1 - r - ej0) * tileGrid.width + (x0 + c - ex0)];
+						}
+						valueBlock[r * w + c] = std::isfinite(value) ? value : sfNanValue;
+					}
+				}
+				if (!writeBlock(sfBandIndexes[k], false))
+				{
+					ccLog::Error("[GDAL] An error occurred while writing a scalar field band!");
+					error = true;
+				}
+			}
+
+			if (!error && !nProgress.oneStep())
+			{
+				ccLog::Warning("[Rasterize] Process cancelled by the user");
+				error = true;
+			}
+		}
+
+		// the whole row of tiles has been written
+		poDstDS->FlushCache();
+	}
+
+	if (progressDialog)
+	{
+		progressDialog->stop();
+	}
+
+	// fill the empty cells with a global statistic
+	if (!error && fillEmptyCellsAfterwards && validCellCount != 0 && validCellCount < static_cast<size_t>(width) * height)
+	{
+		double defaultHeight = 0.0;
+		switch (fillEmptyCellsStrategy)
+		{
+		case ccRasterGrid::FILL_MINIMUM_HEIGHT:
+			defaultHeight = minHeight;
+			break;
+		case ccRasterGrid::FILL_MAXIMUM_HEIGHT:
+			defaultHeight = maxHeight;
+			break;
+		case ccRasterGrid::FILL_AVERAGE_HEIGHT:
+			defaultHeight = sumHeight / validCellCount;
+			break;
+		default:
+			assert(false);
+			break;
+		}
+		defaultHeight += shiftZ;
+
+		// we process the band by rows of blocks
+		GDALRasterBand* poBand = poDstDS->GetRasterBand(heightBand);
+		for (unsigned r0 = 0; r0 < height && !error; r0 += s_blockSize)
+		{
+			unsigned h = std::min(s_blockSize, height - r0);
+			for (unsigned x0 = 0; x0 < width && !error; x0 += tileSize)
+			{
+				unsigned w = std::min(tileSize, width - x0);
+				if (poBand->RasterIO(GF_Read, static_cast<int>(x0), static_cast<int>(r0), static_cast<int>(w), static_cast<int>(h), valueBlock.data(), static_cast<int>(w), static_cast<int>(h), GDT_Float64, 0, 0) != CE_None)
+				{
+					error = true;
+					break;
+				}
+				for (size_t n = 0; n < static_cast<size_t>(w) * h; ++n)
+				{
+					if (!std::isfinite(valueBlock[n]))
+					{
+						valueBlock[n] = defaultHeight;
+					}
+				}
+				if (poBand->RasterIO(GF_Write, static_cast<int>(x0), static_cast<int>(r0), static_cast<int>(w), static_cast<int>(h), valueBlock.data(), static_cast<int>(w), static_cast<int>(h), GDT_Float64, 0, 0) != CE_None)
+				{
+					error = true;
+					break;
+				}
+			}
+			poDstDS->FlushCache();
+		}
+
+		if (error)
+		{
+			ccLog::Error("[GDAL] An error occurred while filling the empty cells of the height band!");
+		}
+	}
+
+	/* Once we're done, close properly the dataset */
+	GDALClose(poDstDS);
+
+	if (error)
+	{
+		return false;
+	}
+
+	ccLog::Print(QString("[Rasterize] Raster '%1' successfully saved (%2 x %3 cells, %4 tile(s))").arg(outputFilename).arg(width).arg(height).arg(tileCount));
+	return true;
+
+#else
+	assert(false);
+	ccLog::Error("[Rasterize] GDAL not supported by this version! Can't generate a raster...");
+	return false;
+#endif
+}
+
 void ccRasterizeTool::generateXRaySF()
 {
 	if (!m_grid.isValid() || !m_rasterCloud)
@@ -1769,7 +2409,7 @@ void ccRasterizeTool::generateXRaySF()
 			if (std::isfinite(cell.h))
 			{
 				std::vector<unsigned> indexes;
-				cell.getPointIndexes(indexes, m_grid.pointRefList);
+				cell.getPointIndexes(indexes, m_grid.pointIndexes);
 
 				if (indexes.empty())
 				{
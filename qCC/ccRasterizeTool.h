@@ -68,6 +68,41 @@ class ccRasterizeTool : public QDialog
 	                          ccGenericPointCloud*              originCloud               = nullptr,
 	                          int                               visibleSfIndex            = -1);
 
+	//! Tiled rasterization parameters
+	struct TileParams
+	{
+		//! Tile size (in cells)
+		unsigned tileSize = 2048;
+		//! Tile overlap (in cells)
+		/** Each tile is computed with this margin of extra cells on each side, so that
+		    the empty cells interpolation is consistent across the tile borders.
+		**/
+		unsigned overlap = 32;
+	};
+
+	//! Rasterizes a cloud tile by tile and streams the result to a (tiled) geotiff file
+	/** Contrarily to ExportGeoTiff, the full raster grid is never held in memory: only
+	    one tile (plus its overlap) is computed at a time, and it is directly written to
+	    the output file. This allows generating rasters that wouldn't fit in memory.
+	    \warning The 'FILL_MINIMUM_HEIGHT', 'FILL_MAXIMUM_HEIGHT' and 'FILL_AVERAGE_HEIGHT'
+	    strategies require a second pass on the output file (the statistics are global).
+	**/
+	static bool RasterizeToTiledGeoTiff(const QString&                    outputFilename,
+	                                    const ExportBands&                exportBands,
+	                                    ccPointCloud*                     cloud,
+	                                    const ccBBox&                     gridBBox,
+	                                    double                            gridStep,
+	                                    unsigned char                     Z,
+	                                    ccRasterGrid::ProjectionType      projectionType,
+	                                    ccRasterGrid::ProjectionType      sfProjectionType,
+	                                    ccRasterGrid::EmptyCellFillOption fillEmptyCellsStrategy,
+	                                    void*                             interpolationParams,
+	                                    const TileParams&                 tileParams,
+	                                    double                            customHeightForEmptyCells = std::numeric_limits<double>::quiet_NaN(),
+	                                    int                               zStdDevSfIndex            = -1,
+	                                    int                               visibleSfIndex            = -1,
+	                                    ccProgressDialog*                 progressDialog            = nullptr);
+
   private:
 	//! Exports the grid as a cloud
 	ccPointCloud* generateCloud(bool autoExport = true);
@@ -56,6 +56,10 @@ static bool     s_useModelSFAsWeights         = false;
 static bool     s_useC2MSignedDistances       = false;
 static bool     s_robustC2MSignedDistances    = true;
 static int      s_normalsMatchingOption       = CCCoreLib::ICPRegistrationTools::NO_NORMAL;
+static bool     s_useMultiResolution          = false;
+static int      s_icpMetricIndex              = 1;
+static int      s_multiResLevelCount          = 3;
+static double   s_multiResVoxelSize           = 0.0;
 
 ccRegistrationDlg::ccRegistrationDlg(ccHObject* data, ccHObject* model, QWidget* parent /*=nullptr*/)
     : QDialog(parent, Qt::Tool)
@@ -104,6 +108,10 @@ ccRegistrationDlg::ccRegistrationDlg(ccHObject* data, ccHObject* model, QWidget*
 		useC2MSignedDistancesCheckBox->setChecked(s_useC2MSignedDistances);
 		robustC2MDistsCheckBox->setChecked(s_robustC2MSignedDistances);
 		normalsComboBox->setCurrentIndex(s_normalsMatchingOption);
+		multiResGroupBox->setChecked(s_useMultiResolution);
+		icpMetricComboBox->setCurrentIndex(s_icpMetricIndex);
+		multiResLevelsSpinBox->setValue(s_multiResLevelCount);
+		multiResVoxelSizeDoubleSpinBox->setValue(s_multiResVoxelSize);
 	}
 
 	connect(swapButton, &QAbstractButton::clicked, this, &ccRegistrationDlg::swapModelAndData);
@@ -144,6 +152,34 @@ void ccRegistrationDlg::saveParameters() const
 	s_useC2MSignedDistances       = useC2MSignedDistancesCheckBox->isChecked();
 	s_robustC2MSignedDistances    = robustC2MDistsCheckBox->isChecked();
 	s_normalsMatchingOption       = normalsComboBox->currentIndex();
+	s_useMultiResolution          = multiResGroupBox->isChecked();
+	s_icpMetricIndex              = icpMetricComboBox->currentIndex();
+	s_multiResLevelCount          = multiResLevelsSpinBox->value();
+	s_multiResVoxelSize           = multiResVoxelSizeDoubleSpinBox->value();
+}
+
+ccRegistrationTools::MultiResolutionParams ccRegistrationDlg::getMultiResolutionParams() const
+{
+	ccRegistrationTools::MultiResolutionParams params;
+	params.enabled    = multiResGroupBox->isChecked();
+	params.levelCount = static_cast<unsigned>(multiResLevelsSpinBox->value());
+	params.voxelSize  = multiResVoxelSizeDoubleSpinBox->value();
+	switch (icpMetricComboBox->currentIndex())
+	{
+	case 0:
+		params.metric = ccRegistrationTools::ICPMetric::POINT_TO_POINT;
+		break;
+	case 1:
+		params.metric = ccRegistrationTools::ICPMetric::POINT_TO_PLANE;
+		break;
+	case 2:
+		params.metric = ccRegistrationTools::ICPMetric::SYMMETRIC;
+		break;
+	default:
+		assert(false);
+		break;
+	}
+	return params;
 }
 
 ccHObject* ccRegistrationDlg::getDataEntity()
@@ -308,6 +344,7 @@ void ccRegistrationDlg::updateGUI()
 	useC2MSignedDistancesCheckBox->setEnabled(hasRefMesh); // only supported if a mesh is the reference cloud
 	robustC2MDistsCheckBox->setEnabled(hasRefMesh);
 	normalsComboBox->setEnabled(dataEntity->hasNormals() && modelEntity->hasNormals()); // only supported if both the to-be-aligned and the reference entities have normals
+	multiResGroupBox->setEnabled(modelEntity->isKindOf(CC_TYPES::POINT_CLOUD)); // only supported if the reference entity is a cloud
 
 	MainWindow::RefreshAllGLWindow(false);
 }
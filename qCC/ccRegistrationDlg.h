@@ -20,6 +20,9 @@
 
 #include <QDialog>
 
+// Local
+#include "ccRegistrationTools.h"
+
 // CCCoreLib
 #include <ReferenceCloud.h>
 #include <RegistrationTools.h>
@@ -107,6 +110,9 @@ class ccRegistrationDlg : public QDialog
 	//! Returns the maximum number of threads
 	int getMaxThreadCount() const;
 
+	//! Returns the multi-resolution ICP parameters
+	ccRegistrationTools::MultiResolutionParams getMultiResolutionParams() const;
+
 	//! Saves parameters for next call
 	void saveParameters() const;
 
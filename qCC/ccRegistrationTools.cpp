@@ -35,11 +35,23 @@
 #include <ccProgressDialog.h>
 #include <ccScalarField.h>
 
+// Local
+#include "ccCloudDistanceGrid.h"
+
 // Qt
 #include <QElapsedTimer>
 
 // system
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <set>
+#include <vector>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
 
 //! Default number of points sampled on the 'data' mesh (if any)
 static const unsigned s_defaultSampledPointsOnDataMesh = 50000;
@@ -55,7 +67,8 @@ bool ccRegistrationTools::ICP(ccHObject*
                               const CCCoreLib::ICPRegistrationTools::Parameters& inputParameters,
                               bool                                               useDataSFAsWeights /*=false*/,
                               bool                                               useModelSFAsWeights /*=false*/,
-                              QWidget*                                           parent /*=nullptr*/)
+                              QWidget*                                           parent /*=nullptr*/,
+                              const MultiResolutionParams*                       multiResParams /*=nullptr*/)
 {
 	QElapsedTimer timer;
 	timer.start();
@@ -71,6 +84,46 @@ bool ccRegistrationTools::ICP(ccHObject*
 		progressDlg.reset(new ccProgressDialog(false, parent));
 	}
 
+	// multi-resolution engine
+	if (multiResParams && multiResParams->enabled)
+	{
+		if (model->isKindOf(CC_TYPES::MESH))
+		{
+			ccLog::Warning("[ICP] The multi-resolution engine requires a cloud as model entity: the standard ICP will be used instead");
+		}
+		else if (params.adjustScale)
+		{
+			ccLog::Warning("[ICP] The multi-resolution engine can't adjust the scale: the standard ICP will be used instead");
+		}
+		else
+		{
+			if (useDataSFAsWeights || useModelSFAsWeights)
+			{
+				ccLog::Warning("[ICP] Weights are ignored by the multi-resolution engine");
+			}
+
+			ccGenericPointCloud* dataCloud  = ccHObjectCaster::ToGenericPointCloud(data);
+			ccGenericPointCloud* modelCloud = ccHObjectCaster::ToGenericPointCloud(model);
+			if (!dataCloud || !modelCloud)
+			{
+				ccLog::Error("[ICP] Invalid input entities");
+				return false;
+			}
+
+			if (!MultiResolutionICP(dataCloud, modelCloud, transMat, finalRMS, finalPointCount, params, *multiResParams, progressDlg.data()))
+			{
+				ccLog::Error("Registration failed");
+				return false;
+			}
+
+			finalScale = 1.0;
+
+			qint64 duration_ms = timer.elapsed();
+			ccLog::Print(QObject::tr("[ICP] Registration done in %1 sec").arg(duration_ms / 1000.0, 0, 'f', 3));
+			return true;
+		}
+	}
+
 	CCCoreLib::Garbage<CCCoreLib::GenericIndexedCloudPersist> cloudGarbage;
 
 	// if the 'model' entity is a mesh, we need to sample points on it
@@ -316,3 +369,605 @@ bool ccRegistrationTools::ICP(ccHObject*
 
 	return (result < CCCoreLib::ICPRegistrationTools::ICP_ERROR);
 }
+
+//! Subsamples a cloud on a voxel grid (the points - and optionally the normals - of each voxel are averaged)
+static ccPointCloud* VoxelSubsample(ccGenericPointCloud* cloud, double voxelSize, bool withNormals)
+{
+	assert(cloud && (!withNormals || cloud->hasNormals()));
+
+	const unsigned pointCount = cloud->size();
+	ccBBox         box        = cloud->getOwnBB();
+	CCVector3      diag       = box.getDiagVec();
+	double         maxDim     = std::max({diag.x, diag.y, diag.z});
+
+	// the 3 voxel coordinates must fit in a 64 bits key (21 bits each)
+	static const int64_t MaxVoxelCoord = (int64_t(1) << 21) - 1;
+	voxelSize                          = std::max(voxelSize, maxDim / MaxVoxelCoord);
+	if (voxelSize <= 0)
+	{
+		// all the points are at the same position
+		voxelSize = 1.0;
+	}
+
+	struct VoxelPoint
+	{
+		uint64_t key;
+		unsigned index;
+	};
+
+	ccPointCloud* output = nullptr;
+	try
+	{
+		std::vector<VoxelPoint> voxelPoints(pointCount);
+
+		const CCVector3 minCorner = box.minCorner();
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+		for (int i = 0; i < static_cast<int>(pointCount); ++i)
+		{
+			const CCVector3* P = cloud->getPoint(static_cast<unsigned>(i));
+
+			uint64_t x = static_cast<uint64_t>(std::clamp(static_cast<int64_t>((P->x - minCorner.x) / voxelSize), int64_t(0), MaxVoxelCoord));
+			uint64_t y = static_cast<uint64_t>(std::clamp(static_cast<int64_t>((P->y - minCorner.y) / voxelSize), int64_t(0), MaxVoxelCoord));
+			uint64_t z = static_cast<uint64_t>(std::clamp(static_cast<int64_t>((P->z - minCorner.z) / voxelSize), int64_t(0), MaxVoxelCoord));
+
+			voxelPoints[i].key   = (x << 42) | (y << 21) | z;
+			voxelPoints[i].index = static_cast<unsigned>(i);
+		}
+
+		ParallelSort(voxelPoints.begin(), voxelPoints.end(), [](const VoxelPoint& a, const VoxelPoint& b) { return a.key < b.key; });
+
+		unsigned voxelCount = 0;
+		for (unsigned i = 0; i < pointCount; ++i)
+		{
+			if (i == 0 || voxelPoints[i].key != voxelPoints[i - 1].key)
+			{
+				++voxelCount;
+			}
+		}
+
+		output = new ccPointCloud(cloud->getName() + QString(".voxels"));
+		if (!output->reserve(voxelCount) || (withNormals && !output->reserveTheNormsTable()))
+		{
+			delete output;
+			return nullptr;
+		}
+
+		for (unsigned i = 0; i < pointCount;)
+		{
+			CCVector3d sumP(0, 0, 0);
+			CCVector3d sumN(0, 0, 0);
+			unsigned   j = i;
+			for (; j < pointCount && voxelPoints[j].key == voxelPoints[i].key; ++j)
+			{
+				unsigned index = voxelPoints[j].index;
+				sumP += CCVector3d::fromArray(cloud->getPoint(index)->u);
+				if (withNormals)
+				{
+					sumN += CCVector3d::fromArray(cloud->getPointNormal(index).u);
+				}
+			}
+
+			sumP /= (j - i);
+			output->addPoint(sumP.toPC());
+			if (withNormals)
+			{
+				if (sumN.norm2() > std::numeric_limits<double>::epsilon())
+				{
+					sumN.normalize();
+					output->addNorm(sumN.toPC());
+				}
+				else
+				{
+					// the normals cancel each other out
+					output->addNorm(cloud->getPointNormal(voxelPoints[i].index));
+				}
+			}
+
+			i = j;
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		delete output;
+		return nullptr;
+	}
+
+	return output;
+}
+
+//! Randomly subsamples a cloud (the normals are kept)
+/** \return the subsampled cloud (or a null pointer if not enough memory)
+**/
+static ccPointCloud* RandomSubsample(ccPointCloud* cloud, unsigned count)
+{
+	assert(cloud && count < cloud->size());
+
+	QScopedPointer<CCCoreLib::ReferenceCloud> sampledCloud(CCCoreLib::CloudSamplingTools::subsampleCloudRandomly(cloud, count));
+	if (!sampledCloud)
+	{
+		return nullptr;
+	}
+
+	return cloud->partialClone(sampledCloud.data(), nullptr, false);
+}
+
+//! Solves a 6x6 linear system (Gaussian elimination with partial pivoting)
+static bool Solve6x6(double A[6][6], double b[6], double x[6])
+{
+	for (int k = 0; k < 6; ++k)
+	{
+		// pivot
+		int pivot = k;
+		for (int i = k + 1; i < 6; ++i)
+		{
+			if (std::abs(A[i][k]) > std::abs(A[pivot][k]))
+			{
+				pivot = i;
+			}
+		}
+		if (std::abs(A[pivot][k]) < 1.0e-12)
+		{
+			// singular system
+			return false;
+		}
+		if (pivot != k)
+		{
+			std::swap(A[k], A[pivot]);
+			std::swap(b[k], b[pivot]);
+		}
+
+		for (int i = k + 1; i < 6; ++i)
+		{
+			double f = A[i][k] / A[k][k];
+			for (int j = k; j < 6; ++j)
+			{
+				A[i][j] -= f * A[k][j];
+			}
+			b[i] -= f * b[k];
+		}
+	}
+
+	for (int k = 5; k >= 0; --k)
+	{
+		double sum = b[k];
+		for (int j = k + 1; j < 6; ++j)
+		{
+			sum -= A[k][j] * x[j];
+		}
+		x[k] = sum / A[k][k];
+	}
+
+	return true;
+}
+
+bool ccRegistrationTools::MultiResolutionICP(ccGenericPointCloud*                               dataCloud,
+                                             ccGenericPointCloud*                               modelCloud,
+                                             ccGLMatrix&                                        transMat,
+                                             double&                                            finalRMS,
+                                             unsigned&                                          finalPointCount,
+                                             const CCCoreLib::ICPRegistrationTools::Parameters& params,
+                                             const MultiResolutionParams&                       multiResParams,
+                                             CCCoreLib::GenericProgressCallback*                progressCb /*=nullptr*/)
+{
+	if (!dataCloud || !modelCloud || dataCloud->size() == 0 || modelCloud->size() == 0)
+	{
+		ccLog::Warning("[ICP] Empty input cloud(s)");
+		return false;
+	}
+
+	// check the metric requirements
+	ICPMetric metric = multiResParams.metric;
+	if (metric != ICPMetric::POINT_TO_POINT && !modelCloud->hasNormals())
+	{
+		ccLog::Warning("[ICP] The model cloud has no normals: the point-to-point metric will be used");
+		metric = ICPMetric::POINT_TO_POINT;
+	}
+	if (metric == ICPMetric::SYMMETRIC && !dataCloud->hasNormals())
+	{
+		ccLog::Warning("[ICP] The data cloud has no normals: the point-to-plane metric will be used");
+		metric = ICPMetric::POINT_TO_PLANE;
+	}
+
+	const unsigned levelCount = std::max(1u, multiResParams.levelCount);
+	double         voxelSize  = multiResParams.voxelSize;
+	if (voxelSize <= 0)
+	{
+		CCVector3 diag = modelCloud->getOwnBB().getDiagVec();
+		voxelSize      = std::max({diag.x, diag.y, diag.z}) / 1024.0;
+	}
+
+	// transformation filters (fixed unknowns: rotation around X, Y and Z, then translation along X, Y and Z)
+	bool fixedUnknowns[6]{false, false, false, false, false, false};
+	{
+		int filters = params.transformationFilters;
+		if ((filters & CCCoreLib::RegistrationTools::SKIP_ROTATION) == CCCoreLib::RegistrationTools::SKIP_ROTATION)
+		{
+			fixedUnknowns[0] = fixedUnknowns[1] = fixedUnknowns[2] = true;
+		}
+		if (filters & CCCoreLib::RegistrationTools::SKIP_RYZ)
+		{
+			fixedUnknowns[1] = fixedUnknowns[2] = true;
+		}
+		if (filters & CCCoreLib::RegistrationTools::SKIP_RXZ)
+		{
+			fixedUnknowns[0] = fixedUnknowns[2] = true;
+		}
+		if (filters & CCCoreLib::RegistrationTools::SKIP_RXY)
+		{
+			fixedUnknowns[0] = fixedUnknowns[1] = true;
+		}
+		fixedUnknowns[3] = (filters & CCCoreLib::RegistrationTools::SKIP_TX);
+		fixedUnknowns[4] = (filters & CCCoreLib::RegistrationTools::SKIP_TY);
+		fixedUnknowns[5] = (filters & CCCoreLib::RegistrationTools::SKIP_TZ);
+	}
+
+	// the rotations are linearized around the model center (for a better conditioning)
+	const CCVector3d center = CCVector3d::fromArray(modelCloud->getOwnBB().getCenter().u);
+
+	const bool     errorConvergence  = (params.convType == CCCoreLib::ICPRegistrationTools::MAX_ERROR_CONVERGENCE);
+	const unsigned maxIterationCount = (errorConvergence ? 100 : std::max(1u, params.nbMaxIterations)); // per level
+
+#if defined(_OPENMP)
+	const int threadCount = (params.maxThreadCount > 0 ? params.maxThreadCount : omp_get_max_threads());
+#endif
+
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Multi-resolution ICP");
+			progressCb->setInfo(qPrintable(QString("Levels: %1").arg(levelCount)));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+
+	static const unsigned InvalidIndex = std::numeric_limits<unsigned>::max();
+
+	ccGLMatrixd transformation; // identity by default
+	bool        success = true;
+	finalRMS            = 0.0;
+	finalPointCount     = 0;
+
+	for (unsigned level = 0; level < levelCount && success; ++level)
+	{
+		const bool   lastLevel      = (level + 1 == levelCount);
+		const double levelVoxelSize = std::ldexp(voxelSize, static_cast<int>(levelCount - 1 - level));
+
+		// subsampled data points
+		QScopedPointer<ccPointCloud> levelData(VoxelSubsample(dataCloud, levelVoxelSize, metric == ICPMetric::SYMMETRIC));
+		if (levelData && params.samplingLimit != 0 && levelData->size() > params.samplingLimit)
+		{
+			// random sampling limit (as with the standard ICP)
+			levelData.reset(RandomSubsample(levelData.data(), params.samplingLimit));
+		}
+
+		// model points (the full resolution model is used at the last level)
+		QScopedPointer<ccPointCloud> levelModel;
+		ccGenericPointCloud*         levelModelCloud = modelCloud;
+		if (!lastLevel)
+		{
+			levelModel.reset(VoxelSubsample(modelCloud, levelVoxelSize, metric != ICPMetric::POINT_TO_POINT));
+			levelModelCloud = levelModel.data();
+		}
+		if (levelModelCloud && params.samplingLimit != 0 && levelModelCloud->size() > params.samplingLimit)
+		{
+			ccPointCloud* levelModelPC = ccHObjectCaster::ToPointCloud(levelModelCloud);
+			if (levelModelPC)
+			{
+				levelModel.reset(RandomSubsample(levelModelPC, params.samplingLimit));
+				levelModelCloud = levelModel.data();
+			}
+			else if (lastLevel)
+			{
+				ccLog::Warning("[ICP] The random sampling limit can't be applied to the model entity (not a point cloud)");
+			}
+		}
+
+		// model search structure
+		ccCloudDistanceGrid::Shared modelGrid;
+		if (levelModelCloud)
+		{
+			modelGrid = ccCloudDistanceGrid::Build(levelModelCloud);
+		}
+
+		if (!levelData || !levelModelCloud || !modelGrid)
+		{
+			ccLog::Error("[ICP] Not enough memory");
+			success = false;
+			break;
+		}
+
+		const unsigned dataCount = levelData->size();
+		ccLog::Print(QString("[ICP] Level %1/%2: voxel size = %3 (%4 data points, %5 model points)")
+		                 .arg(level + 1)
+		                 .arg(levelCount)
+		                 .arg(levelVoxelSize)
+		                 .arg(dataCount)
+		                 .arg(levelModelCloud->size()));
+
+		std::vector<CCVector3d> transformedPoints;
+		std::vector<unsigned>   matchIndexes;
+		std::vector<double>     matchDistances;
+		std::vector<double>     sortedDistances;
+		try
+		{
+			transformedPoints.resize(dataCount);
+			matchIndexes.resize(dataCount);
+			matchDistances.resize(dataCount);
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Error("[ICP] Not enough memory");
+			success = false;
+			break;
+		}
+
+		double   previousRMS = std::numeric_limits<double>::infinity();
+		unsigned iteration   = 0;
+		for (; iteration < maxIterationCount; ++iteration)
+		{
+			if (progressCb)
+			{
+				progressCb->update((100.0f * (level + static_cast<float>(iteration) / maxIterationCount)) / levelCount);
+				if (progressCb->isCancelRequested())
+				{
+					ccLog::Warning("[ICP] Process canceled by the user");
+					success = false;
+					break;
+				}
+			}
+
+			// look for the correspondences (in parallel)
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(threadCount) schedule(dynamic, 1024)
+#endif
+			for (int i = 0; i < static_cast<int>(dataCount); ++i)
+			{
+				CCVector3d Q         = transformation * CCVector3d::fromArray(levelData->getPoint(static_cast<unsigned>(i))->u);
+				transformedPoints[i] = Q;
+
+				unsigned nearestIndex = InvalidIndex;
+				double   distance     = 0.0;
+				if (!modelGrid->findNearestNeighbor(Q.toPC(), nearestIndex, distance))
+				{
+					nearestIndex = InvalidIndex;
+				}
+				matchIndexes[i]   = nearestIndex;
+				matchDistances[i] = distance;
+			}
+
+			// determine the max distance of the kept correspondences
+			double maxDistance = std::numeric_limits<double>::infinity();
+			try
+			{
+				sortedDistances.clear();
+				for (unsigned i = 0; i < dataCount; ++i)
+				{
+					if (matchIndexes[i] != InvalidIndex)
+					{
+						sortedDistances.push_back(matchDistances[i]);
+					}
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				ccLog::Error("[ICP] Not enough memory");
+				success = false;
+				break;
+			}
+			if (sortedDistances.empty())
+			{
+				ccLog::Error("[ICP] No correspondence found");
+				success = false;
+				break;
+			}
+			if (params.finalOverlapRatio < 1.0)
+			{
+				// trimmed ICP: we only keep the closest correspondences
+				size_t keptCount = std::max<size_t>(1, static_cast<size_t>(sortedDistances.size() * std::max(params.finalOverlapRatio, 0.01)));
+				std::nth_element(sortedDistances.begin(), sortedDistances.begin() + (keptCount - 1), sortedDistances.end());
+				maxDistance = sortedDistances[keptCount - 1];
+			}
+			if (params.filterOutFarthestPoints)
+			{
+				// we ignore the correspondences farther than mean + 3 sigma
+				double   sum   = 0.0;
+				double   sum2  = 0.0;
+				unsigned count = 0;
+				for (double d : sortedDistances)
+				{
+					if (d <= maxDistance)
+					{
+						sum += d;
+						sum2 += d * d;
+						++count;
+					}
+				}
+				double mean  = sum / count;
+				double sigma = std::sqrt(std::max(0.0, sum2 / count - mean * mean));
+				maxDistance  = std::min(maxDistance, mean + 3.0 * sigma);
+			}
+
+			// accumulate the (linearized) normal equations (in parallel)
+			double   AtA[6][6]{};
+			double   Atb[6]{};
+			double   squareDistSum = 0.0;
+			unsigned matchCount    = 0;
+
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(threadCount)
+#endif
+			{
+				double   localAtA[6][6]{};
+				double   localAtb[6]{};
+				double   localSquareDistSum = 0.0;
+				unsigned localMatchCount    = 0;
+
+				auto addRow = [&](const double J[6], double r)
+				{
+					for (int a = 0; a < 6; ++a)
+					{
+						for (int b = a; b < 6; ++b)
+						{
+							localAtA[a][b] += J[a] * J[b];
+						}
+						localAtb[a] -= J[a] * r;
+					}
+				};
+
+#if defined(_OPENMP)
+#pragma omp for nowait
+#endif
+				for (int i = 0; i < static_cast<int>(dataCount); ++i)
+				{
+					if (matchIndexes[i] == InvalidIndex || matchDistances[i] > maxDistance)
+					{
+						continue;
+					}
+
+					const CCVector3d Q = transformedPoints[i] - center;
+					const CCVector3d M = CCVector3d::fromArray(levelModelCloud->getPoint(matchIndexes[i])->u) - center;
+					const CCVector3d d = Q - M;
+
+					localSquareDistSum += matchDistances[i] * matchDistances[i];
+					++localMatchCount;
+
+					if (metric == ICPMetric::POINT_TO_POINT)
+					{
+						// residual: Q + w x Q + t - M
+						const double Jx[6]{0.0, Q.z, -Q.y, 1.0, 0.0, 0.0};
+						const double Jy[6]{-Q.z, 0.0, Q.x, 0.0, 1.0, 0.0};
+						const double Jz[6]{Q.y, -Q.x, 0.0, 0.0, 0.0, 1.0};
+						addRow(Jx, d.x);
+						addRow(Jy, d.y);
+						addRow(Jz, d.z);
+					}
+					else
+					{
+						CCVector3d n = CCVector3d::fromArray(levelModelCloud->getPointNormal(matchIndexes[i]).u);
+						if (metric == ICPMetric::SYMMETRIC)
+						{
+							CCVector3d nData = CCVector3d::fromArray(levelData->getPointNormal(static_cast<unsigned>(i)).u);
+							transformation.applyRotation(nData);
+							if (nData.dot(n) < 0)
+							{
+								nData = -nData;
+							}
+							n += nData;
+							if (n.norm2() < std::numeric_limits<double>::epsilon())
+							{
+								continue;
+							}
+							n.normalize();
+						}
+
+						// residual: (Q + w x Q + t - M).n
+						const CCVector3d c = Q.cross(n);
+						const double     J[6]{c.x, c.y, c.z, n.x, n.y, n.z};
+						addRow(J, d.dot(n));
+					}
+				}
+
+#if defined(_OPENMP)
+#pragma omp critical(ICPNormalEquations)
+#endif
+				{
+					for (int a = 0; a < 6; ++a)
+					{
+						for (int b = a; b < 6; ++b)
+						{
+							AtA[a][b] += localAtA[a][b];
+						}
+						Atb[a] += localAtb[a];
+					}
+					squareDistSum += localSquareDistSum;
+					matchCount += localMatchCount;
+				}
+			}
+
+			if (matchCount < 6)
+			{
+				ccLog::Error("[ICP] Not enough correspondences");
+				success = false;
+				break;
+			}
+
+			const double rms = std::sqrt(squareDistSum / matchCount);
+			finalRMS         = rms;
+			finalPointCount  = matchCount;
+
+			if (errorConvergence && previousRMS - rms < params.minRMSDecrease)
+			{
+				// converged
+				break;
+			}
+			previousRMS = rms;
+
+			// symmetric matrix + fixed unknowns
+			for (int a = 0; a < 6; ++a)
+			{
+				for (int b = 0; b < a; ++b)
+				{
+					AtA[a][b] = AtA[b][a];
+				}
+			}
+			for (int a = 0; a < 6; ++a)
+			{
+				if (fixedUnknowns[a])
+				{
+					for (int b = 0; b < 6; ++b)
+					{
+						AtA[a][b] = AtA[b][a] = 0.0;
+					}
+					AtA[a][a] = 1.0;
+					Atb[a]    = 0.0;
+				}
+			}
+
+			double x[6]{};
+			if (!Solve6x6(AtA, Atb, x))
+			{
+				ccLog::Warning("[ICP] Degenerate configuration (level %i, iteration %i)", level + 1, iteration + 1);
+				break;
+			}
+
+			// update the transformation: P' = dR.(P - C) + C + t
+			CCVector3d   w(x[0], x[1], x[2]);
+			CCVector3d   t(x[3], x[4], x[5]);
+			const double angle = w.norm();
+			CCVector3d   axis  = (angle > 0 ? w / angle : CCVector3d(0, 0, 1));
+
+			ccGLMatrixd deltaRotation;
+			deltaRotation.initFromParameters(angle, axis, CCVector3d(0, 0, 0));
+			ccGLMatrixd delta;
+			delta.initFromParameters(angle, axis, center + t - deltaRotation * center);
+			transformation = delta * transformation;
+
+			// early stop (the transformation doesn't change anymore)
+			if (angle < 1.0e-9 && t.norm() < 1.0e-9 * levelVoxelSize)
+			{
+				break;
+			}
+		}
+
+		if (success)
+		{
+			ccLog::Print(QString("[ICP] Level %1/%2: %3 iteration(s), RMS = %4 (%5 points)").arg(level + 1).arg(levelCount).arg(std::min(iteration + 1, maxIterationCount)).arg(finalRMS).arg(finalPointCount));
+		}
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (success)
+	{
+		transMat = ccGLMatrix(transformation.data());
+	}
+
+	return success;
+}
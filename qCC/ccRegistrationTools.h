@@ -25,6 +25,7 @@
 #include <ccGLMatrix.h>
 
 class QWidget;
+class ccGenericPointCloud;
 class ccHObject;
 
 //! Registration tools wrapper
@@ -32,8 +33,34 @@ class ccRegistrationTools
 {
 
   public:
+	//! ICP error metrics
+	enum class ICPMetric
+	{
+		POINT_TO_POINT, //!< Classic ICP (distance between the matched points)
+		POINT_TO_PLANE, //!< Distance to the tangent plane of the model points (requires normals on the model)
+		SYMMETRIC       //!< Symmetric point-to-plane (distance along the sum of both normals - requires normals on both entities)
+	};
+
+	//! Multi-resolution ICP parameters
+	/** See MultiResolutionICP.
+	**/
+	struct MultiResolutionParams
+	{
+		//! Whether to use the multi-resolution engine (instead of CCCoreLib's ICP)
+		bool enabled = false;
+		//! Error metric
+		ICPMetric metric = ICPMetric::POINT_TO_PLANE;
+		//! Number of levels of the voxel pyramid
+		unsigned levelCount = 3;
+		//! Voxel size of the finest level (0 = automatic, i.e. 1/1024 of the model extent)
+		/** The voxel size is doubled for each coarser level.
+		**/
+		double voxelSize = 0.0;
+	};
+
 	//! Applies ICP registration on two entities
 	/** \warning Automatically samples points on meshes if necessary (see code for magic numbers ;)
+	    \param multiResParams optional multi-resolution parameters (if enabled, and if the model entity is a cloud, MultiResolutionICP is used instead of CCCoreLib's ICP)
 	 **/
 	static bool ICP(ccHObject*                                         data,
 	                ccHObject*                                         model,
@@ -44,7 +71,33 @@ class ccRegistrationTools
 	                const CCCoreLib::ICPRegistrationTools::Parameters& inputParameters,
 	                bool                                               useDataSFAsWeights  = false,
 	                bool                                               useModelSFAsWeights = false,
-	                QWidget*                                           parent              = nullptr);
+	                QWidget*                                           parent              = nullptr,
+	                const MultiResolutionParams*                       multiResParams      = nullptr);
+
+	//! Applies a multi-resolution ICP registration on two clouds
+	/** The registration goes from coarse to fine levels: at each level, both clouds are
+	    subsampled on a voxel grid (the voxel size being halved at each level) and the ICP
+	    iterations are stopped as soon as the error doesn't decrease enough (or when the
+	    maximum number of iterations is reached). The last level uses the full model cloud.
+	    The model points are searched with a ccCloudDistanceGrid (built at each level).
+
+	    The correspondences are searched in parallel, and the (linearized) least squares
+	    system is accumulated concurrently. The farthest correspondences are discarded
+	    according to the final overlap ratio (trimmed ICP).
+
+	    Supported parameters: convergence type, min RMS decrease, max iteration count (per
+	    level), random sampling limit (applied to both clouds, at each level), final overlap,
+	    farthest points removal, transformation filters and max thread count. The scale can't
+	    be adjusted and weights are not supported.
+	**/
+	static bool MultiResolutionICP(ccGenericPointCloud*                               dataCloud,
+	                               ccGenericPointCloud*                               modelCloud,
+	                               ccGLMatrix&                                        transMat,
+	                               double&                                            finalRMS,
+	                               unsigned&                                          finalPointCount,
+	                               const CCCoreLib::ICPRegistrationTools::Parameters& params,
+	                               const MultiResolutionParams&                       multiResParams,
+	                               CCCoreLib::GenericProgressCallback*                progressCb = nullptr);
 };
 
 #endif // CC_REGISTRATION_TOOLS_HEADER
@@ -0,0 +1,820 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+// #                                                                        #
+// ##########################################################################
+
+#include "ccScalarFieldExpression.h"
+
+// CCCoreLib
+#include <GenericProgressCallback.h>
+
+// Qt
+#include <QObject>
+
+// qCC_db
+#include <ccLog.h>
+#include <ccPointCloud.h>
+#include <ccScalarField.h>
+
+// system
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
+//! Number of points processed at once by each instruction
+static const unsigned s_chunkSize = 4096;
+
+//! Recursive descent parser
+/** Grammar:
+    expression := term (('+' | '-') term)*
+    term       := unary (('*' | '/') unary)*
+    unary      := ('-' | '+') unary | power
+    power      := primary ('^' unary)?
+    primary    := number | variable | function '(' expression (',' expression)* ')' | '(' expression ')'
+**/
+class ccScalarFieldExpression::Parser
+{
+  public:
+	Parser(const QString& expression, const ccPointCloud* cloud, std::vector<Instruction>& program)
+	    : m_expr(expression)
+	    , m_pos(0)
+	    , m_cloud(cloud)
+	    , m_program(program)
+	    , m_depth(0)
+	    , m_maxDepth(0)
+	{
+	}
+
+	bool parse(QString& errorMessage)
+	{
+		if (!parseExpression())
+		{
+			errorMessage = m_error;
+			return false;
+		}
+		skipSpaces();
+		if (m_pos < m_expr.length())
+		{
+			errorMessage = QObject::tr("Unexpected character '%1' at position %2").arg(m_expr[m_pos]).arg(m_pos + 1);
+			return false;
+		}
+		return true;
+	}
+
+	unsigned maxDepth() const
+	{
+		return m_maxDepth;
+	}
+
+  protected:
+	void skipSpaces()
+	{
+		while (m_pos < m_expr.length() && m_expr[m_pos].isSpace())
+		{
+			++m_pos;
+		}
+	}
+
+	bool accept(QChar c)
+	{
+		skipSpaces();
+		if (m_pos < m_expr.length() && m_expr[m_pos] == c)
+		{
+			++m_pos;
+			return true;
+		}
+		return false;
+	}
+
+	bool fail(const QString& error)
+	{
+		m_error = error;
+		return false;
+	}
+
+	//! Emits an instruction (and folds the constant operations)
+	void addInstruction(OpCode op, int index = 0, double value = 0.0)
+	{
+		unsigned operandCount = 0;
+		switch (op)
+		{
+		case OpCode::CONSTANT:
+		case OpCode::COORDINATE:
+		case OpCode::COLOR:
+		case OpCode::SCALAR_FIELD:
+			operandCount = 0;
+			break;
+		case OpCode::ADD:
+		case OpCode::SUB:
+		case OpCode::MUL:
+		case OpCode::DIV:
+		case OpCode::POW:
+		case OpCode::MIN:
+		case OpCode::MAX:
+			operandCount = 2;
+			break;
+		default:
+			operandCount = 1;
+			break;
+		}
+
+		// constant folding
+		if (operandCount != 0 && m_program.size() >= operandCount)
+		{
+			bool constantOperands = true;
+			for (size_t k = m_program.size() - operandCount; k < m_program.size(); ++k)
+			{
+				constantOperands &= (m_program[k].op == OpCode::CONSTANT);
+			}
+			if (constantOperands)
+			{
+				double a = m_program[m_program.size() - operandCount].value;
+				double b = m_program.back().value;
+				m_program.resize(m_program.size() - operandCount);
+				m_depth -= operandCount;
+				Instruction folded;
+				folded.op    = OpCode::CONSTANT;
+				folded.value = Compute(op, a, b);
+				push(folded, 1);
+				return;
+			}
+		}
+
+		Instruction instruction;
+		instruction.op    = op;
+		instruction.index = index;
+		instruction.value = value;
+		push(instruction, operandCount == 0 ? 1 : -static_cast<int>(operandCount) + 1);
+	}
+
+	void push(const Instruction& instruction, int depthIncrement)
+	{
+		m_program.push_back(instruction);
+		m_depth += depthIncrement;
+		m_maxDepth = std::max(m_maxDepth, m_depth);
+	}
+
+	bool parseExpression()
+	{
+		if (!parseTerm())
+		{
+			return false;
+		}
+		while (true)
+		{
+			if (accept('+'))
+			{
+				if (!parseTerm())
+					return false;
+				addInstruction(OpCode::ADD);
+			}
+			else if (accept('-'))
+			{
+				if (!parseTerm())
+					return false;
+				addInstruction(OpCode::SUB);
+			}
+			else
+			{
+				return true;
+			}
+		}
+	}
+
+	bool parseTerm()
+	{
+		if (!parseUnary())
+		{
+			return false;
+		}
+		while (true)
+		{
+			if (accept('*'))
+			{
+				if (!parseUnary())
+					return false;
+				addInstruction(OpCode::MUL);
+			}
+			else if (accept('/'))
+			{
+				if (!parseUnary())
+					return false;
+				addInstruction(OpCode::DIV);
+			}
+			else
+			{
+				return true;
+			}
+		}
+	}
+
+	bool parseUnary()
+	{
+		if (accept('-'))
+		{
+			if (!parseUnary())
+				return false;
+			addInstruction(OpCode::NEG);
+			return true;
+		}
+		if (accept('+'))
+		{
+			return parseUnary();
+		}
+		return parsePower();
+	}
+
+	bool parsePower()
+	{
+		if (!parsePrimary())
+		{
+			return false;
+		}
+		if (accept('^'))
+		{
+			// right associative (and we accept a unary minus in the exponent)
+			if (!parseUnary())
+				return false;
+			addInstruction(OpCode::POW);
+		}
+		return true;
+	}
+
+	bool parsePrimary()
+	{
+		skipSpaces();
+		if (m_pos >= m_expr.length())
+		{
+			return fail(QObject::tr("Unexpected end of expression"));
+		}
+
+		QChar c = m_expr[m_pos];
+
+		// sub-expression
+		if (accept('('))
+		{
+			if (!parseExpression())
+				return false;
+			if (!accept(')'))
+				return fail(QObject::tr("Missing closing parenthesis at position %1").arg(m_pos + 1));
+			return true;
+		}
+
+		// scalar field name
+		if (accept('['))
+		{
+			int end = m_expr.indexOf(']', m_pos);
+			if (end < 0)
+			{
+				return fail(QObject::tr("Missing closing bracket at position %1").arg(m_pos + 1));
+			}
+			QString sfName = m_expr.mid(m_pos, end - m_pos).trimmed();
+			m_pos          = end + 1;
+			int sfIndex    = m_cloud ? m_cloud->getScalarFieldIndexByName(sfName.toStdString()) : -1;
+			if (sfIndex < 0)
+			{
+				return fail(QObject::tr("Unknown scalar field '%1'").arg(sfName));
+			}
+			addInstruction(OpCode::SCALAR_FIELD, sfIndex);
+			return true;
+		}
+
+		// number
+		if (c.isDigit() || c == '.')
+		{
+			int start = m_pos;
+			while (m_pos < m_expr.length() && (m_expr[m_pos].isDigit() || m_expr[m_pos] == '.'))
+			{
+				++m_pos;
+			}
+			// exponent
+			if (m_pos < m_expr.length() && (m_expr[m_pos] == 'e' || m_expr[m_pos] == 'E'))
+			{
+				int expPos = m_pos + 1;
+				if (expPos < m_expr.length() && (m_expr[expPos] == '+' || m_expr[expPos] == '-'))
+				{
+					++expPos;
+				}
+				if (expPos < m_expr.length() && m_expr[expPos].isDigit())
+				{
+					m_pos = expPos;
+					while (m_pos < m_expr.length() && m_expr[m_pos].isDigit())
+					{
+						++m_pos;
+					}
+				}
+			}
+			bool   ok    = false;
+			double value = m_expr.mid(start, m_pos - start).toDouble(&ok);
+			if (!ok)
+			{
+				return fail(QObject::tr("Invalid number at position %1").arg(start + 1));
+			}
+			addInstruction(OpCode::CONSTANT, 0, value);
+			return true;
+		}
+
+		// identifier (variable or function)
+		if (c.isLetter() || c == '_')
+		{
+			int start = m_pos;
+			while (m_pos < m_expr.length() && (m_expr[m_pos].isLetterOrNumber() || m_expr[m_pos] == '_'))
+			{
+				++m_pos;
+			}
+			QString name  = m_expr.mid(start, m_pos - start);
+			QString upper = name.toUpper();
+
+			skipSpaces();
+			if (m_pos < m_expr.length() && m_expr[m_pos] == '(')
+			{
+				return parseFunction(upper, start);
+			}
+
+			if (upper == "PI")
+			{
+				addInstruction(OpCode::CONSTANT, 0, M_PI);
+				return true;
+			}
+			if (upper == "X" || upper == "Y" || upper == "Z")
+			{
+				addInstruction(OpCode::COORDINATE, upper[0].unicode() - 'X');
+				return true;
+			}
+			if (upper == "R" || upper == "G" || upper == "B")
+			{
+				if (!m_cloud || !m_cloud->hasColors())
+				{
+					return fail(QObject::tr("The cloud has no colors (can't use '%1')").arg(name));
+				}
+				addInstruction(OpCode::COLOR, upper == "R" ? 0 : upper == "G" ? 1 : 2);
+				return true;
+			}
+			if (upper.startsWith("SF") && upper.length() > 2)
+			{
+				bool ok      = false;
+				int  sfIndex = upper.mid(2).toInt(&ok);
+				if (ok)
+				{
+					if (!m_cloud || sfIndex < 0 || sfIndex >= static_cast<int>(m_cloud->getNumberOfScalarFields()))
+					{
+						return fail(QObject::tr("Invalid scalar field index: %1").arg(name));
+					}
+					addInstruction(OpCode::SCALAR_FIELD, sfIndex);
+					return true;
+				}
+			}
+
+			return fail(QObject::tr("Unknown variable '%1' (use brackets for scalar field names, e.g. [%1])").arg(name));
+		}
+
+		return fail(QObject::tr("Unexpected character '%1' at position %2").arg(c).arg(m_pos + 1));
+	}
+
+	bool parseFunction(const QString& name, int position)
+	{
+		struct Function
+		{
+			const char* name;
+			OpCode      op;
+			int         argCount;
+		};
+		static const Function s_functions[]{{"SQRT", OpCode::SQRT, 1},
+		                                    {"EXP", OpCode::EXP, 1},
+		                                    {"LOG", OpCode::LOG, 1},
+		                                    {"LOG10", OpCode::LOG10, 1},
+		                                    {"COS", OpCode::COS, 1},
+		                                    {"SIN", OpCode::SIN, 1},
+		                                    {"TAN", OpCode::TAN, 1},
+		                                    {"ACOS", OpCode::ACOS, 1},
+		                                    {"ASIN", OpCode::ASIN, 1},
+		                                    {"ATAN", OpCode::ATAN, 1},
+		                                    {"ABS", OpCode::ABS, 1},
+		                                    {"INT", OpCode::INT, 1},
+		                                    {"MIN", OpCode::MIN, 2},
+		                                    {"MAX", OpCode::MAX, 2},
+		                                    {"POW", OpCode::POW, 2}};
+
+		const Function* function = nullptr;
+		for (const Function& f : s_functions)
+		{
+			if (name == f.name)
+			{
+				function = &f;
+				break;
+			}
+		}
+		if (!function)
+		{
+			return fail(QObject::tr("Unknown function '%1' at position %2").arg(name.toLower()).arg(position + 1));
+		}
+
+		accept('(');
+		for (int k = 0; k < function->argCount; ++k)
+		{
+			if (k != 0 && !accept(','))
+			{
+				return fail(QObject::tr("Function '%1' expects %2 arguments").arg(name.toLower()).arg(function->argCount));
+			}
+			if (!parseExpression())
+			{
+				return false;
+			}
+		}
+		if (!accept(')'))
+		{
+			return fail(QObject::tr("Missing closing parenthesis for function '%1'").arg(name.toLower()));
+		}
+
+		addInstruction(function->op);
+		return true;
+	}
+
+  public:
+	//! Applies an operation on one or two values
+	static inline double Compute(OpCode op, double a, double b)
+	{
+		switch (op)
+		{
+		case OpCode::NEG:
+			return -a;
+		case OpCode::ADD:
+			return a + b;
+		case OpCode::SUB:
+			return a - b;
+		case OpCode::MUL:
+			return a * b;
+		case OpCode::DIV:
+			return a / b;
+		case OpCode::POW:
+			return std::pow(a, b);
+		case OpCode::MIN:
+			return (std::isnan(a) || std::isnan(b) ? std::numeric_limits<double>::quiet_NaN() : std::min(a, b));
+		case OpCode::MAX:
+			return (std::isnan(a) || std::isnan(b) ? std::numeric_limits<double>::quiet_NaN() : std::max(a, b));
+		case OpCode::SQRT:
+			return std::sqrt(a);
+		case OpCode::EXP:
+			return std::exp(a);
+		case OpCode::LOG:
+			return std::log(a);
+		case OpCode::LOG10:
+			return std::log10(a);
+		case OpCode::COS:
+			return std::cos(a);
+		case OpCode::SIN:
+			return std::sin(a);
+		case OpCode::TAN:
+			return std::tan(a);
+		case OpCode::ACOS:
+			return std::acos(a);
+		case OpCode::ASIN:
+			return std::asin(a);
+		case OpCode::ATAN:
+			return std::atan(a);
+		case OpCode::ABS:
+			return std::abs(a);
+		case OpCode::INT:
+			return std::trunc(a);
+		default:
+			assert(false);
+			return std::numeric_limits<double>::quiet_NaN();
+		}
+	}
+
+  private:
+	const QString&            m_expr;
+	int                       m_pos;
+	const ccPointCloud*       m_cloud;
+	std::vector<Instruction>& m_program;
+	unsigned                  m_depth;
+	unsigned                  m_maxDepth;
+	QString                   m_error;
+};
+
+ccScalarFieldExpression::ccScalarFieldExpression()
+    : m_maxStackDepth(0)
+{
+}
+
+bool ccScalarFieldExpression::compile(const QString& expression, const ccPointCloud* cloud, QString& errorMessage)
+{
+	m_program.clear();
+	m_maxStackDepth = 0;
+
+	if (expression.trimmed().isEmpty())
+	{
+		errorMessage = QObject::tr("Empty expression");
+		return false;
+	}
+
+	try
+	{
+		Parser parser(expression, cloud, m_program);
+		if (!parser.parse(errorMessage))
+		{
+			m_program.clear();
+			return false;
+		}
+		m_maxStackDepth = parser.maxDepth();
+	}
+	catch (const std::bad_alloc&)
+	{
+		m_program.clear();
+		errorMessage = QObject::tr("Not enough memory");
+		return false;
+	}
+
+	assert(!m_program.empty() && m_maxStackDepth != 0);
+	return true;
+}
+
+bool ccScalarFieldExpression::evaluate(const ccPointCloud* cloud, CCCoreLib::ScalarField* outputSF, CCCoreLib::GenericProgressCallback* progressCb /*=nullptr*/) const
+{
+	if (!cloud || !outputSF || !isValid())
+	{
+		assert(false);
+		return false;
+	}
+
+	unsigned pointCount = cloud->size();
+	if (outputSF->currentSize() != pointCount && !outputSF->resizeSafe(pointCount))
+	{
+		ccLog::Warning("[ccScalarFieldExpression] Not enough memory");
+		return false;
+	}
+	if (pointCount == 0)
+	{
+		return true;
+	}
+
+	// resolve the input scalar fields
+	std::vector<const CCCoreLib::ScalarField*> inputSFs(cloud->getNumberOfScalarFields(), nullptr);
+	for (const Instruction& instruction : m_program)
+	{
+		if (instruction.op == OpCode::SCALAR_FIELD)
+		{
+			if (instruction.index >= static_cast<int>(inputSFs.size()))
+			{
+				ccLog::Warning("[ccScalarFieldExpression] Invalid scalar field index (the expression was compiled on another cloud?)");
+				return false;
+			}
+			inputSFs[instruction.index] = cloud->getScalarField(instruction.index);
+			if (inputSFs[instruction.index]->currentSize() < pointCount)
+			{
+				ccLog::Warning("[ccScalarFieldExpression] Invalid scalar field size");
+				return false;
+			}
+		}
+		else if (instruction.op == OpCode::COLOR && !cloud->hasColors())
+		{
+			ccLog::Warning("[ccScalarFieldExpression] The cloud has no colors");
+			return false;
+		}
+	}
+
+	const int chunkCount = static_cast<int>((pointCount + s_chunkSize - 1) / s_chunkSize);
+
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("SF expression");
+			progressCb->setInfo(qPrintable(QObject::tr("Points: %L1").arg(pointCount)));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+	CCCoreLib::NormalizedProgress nProgress(progressCb, static_cast<unsigned>(chunkCount));
+
+	std::atomic<bool> notEnoughMemory(false);
+	std::atomic<bool> cancelled(false);
+
+	// each chunk is read entirely before being written, so the output SF can be one of the inputs
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(omp_get_max_threads())
+#endif
+	{
+		// evaluation stack (one chunk of values per level)
+		std::vector<double> stack;
+		try
+		{
+			stack.resize(static_cast<size_t>(m_maxStackDepth) * s_chunkSize);
+		}
+		catch (const std::bad_alloc&)
+		{
+			notEnoughMemory = true;
+		}
+
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic)
+#endif
+		for (int c = 0; c < chunkCount; ++c)
+		{
+			if (notEnoughMemory || cancelled)
+			{
+				continue;
+			}
+
+			const unsigned firstIndex = static_cast<unsigned>(c) * s_chunkSize;
+			const unsigned count      = std::min(s_chunkSize, pointCount - firstIndex);
+
+			double* top = stack.data() - s_chunkSize; // top of the stack (empty for now)
+			for (const Instruction& instruction : m_program)
+			{
+				switch (instruction.op)
+				{
+				case OpCode::CONSTANT:
+					top += s_chunkSize;
+					std::fill(top, top + count, instruction.value);
+					break;
+
+				case OpCode::COORDINATE:
+					top += s_chunkSize;
+					for (unsigned k = 0; k < count; ++k)
+					{
+						top[k] = cloud->getPoint(firstIndex + k)->u[instruction.index];
+					}
+					break;
+
+				case OpCode::COLOR:
+					top += s_chunkSize;
+					for (unsigned k = 0; k < count; ++k)
+					{
+						top[k] = cloud->getPointColor(firstIndex + k).rgba[instruction.index];
+					}
+					break;
+
+				case OpCode::SCALAR_FIELD:
+				{
+					top += s_chunkSize;
+					const CCCoreLib::ScalarField* sf = inputSFs[instruction.index];
+					for (unsigned k = 0; k < count; ++k)
+					{
+						top[k] = sf->getValue(firstIndex + k);
+					}
+				}
+				break;
+
+				// binary operations (the result replaces the first operand)
+				case OpCode::ADD:
+				{
+					double* a = top - s_chunkSize;
+					for (unsigned k = 0; k < count; ++k)
+						a[k] += top[k];
+					top = a;
+				}
+				break;
+				case OpCode::SUB:
+				{
+					double* a = top - s_chunkSize;
+					for (unsigned k = 0; k < count; ++k)
+						a[k] -= top[k];
+					top = a;
+				}
+				break;
+				case OpCode::MUL:
+				{
+					double* a = top - s_chunkSize;
+					for (unsigned k = 0; k < count; ++k)
+						a[k] *= top[k];
+					top = a;
+				}
+				break;
+				case OpCode::DIV:
+				{
+					double* a = top - s_chunkSize;
+					for (unsigned k = 0; k < count; ++k)
+						a[k] /= top[k];
+					top = a;
+				}
+				break;
+				case OpCode::POW:
+				case OpCode::MIN:
+				case OpCode::MAX:
+				{
+					double* a = top - s_chunkSize;
+					for (unsigned k = 0; k < count; ++k)
+						a[k] = Parser::Compute(instruction.op, a[k], top[k]);
+					top = a;
+				}
+				break;
+
+				// unary operations (in place)
+				case OpCode::NEG:
+					for (unsigned k = 0; k < count; ++k)
+						top[k] = -top[k];
+					break;
+				case OpCode::SQRT:
+					for (unsigned k = 0; k < count; ++k)
+						top[k] = std::sqrt(top[k]);
+					break;
+				case OpCode::ABS:
+					for (unsigned k = 0; k < count; ++k)
+						top[k] = std::abs(top[k]);
+					break;
+				default:
+					for (unsigned k = 0; k < count; ++k)
+						top[k] = Parser::Compute(instruction.op, top[k], 0.0);
+					break;
+				}
+			}
+			assert(top == stack.data());
+
+			// store the result (all non-finite values are considered as invalid)
+			for (unsigned k = 0; k < count; ++k)
+			{
+				double value = top[k];
+				outputSF->setValue(firstIndex + k, std::isfinite(value) ? static_cast<ScalarType>(value) : CCCoreLib::NAN_VALUE);
+			}
+
+			if (progressCb && !nProgress.oneStep())
+			{
+				cancelled = true;
+			}
+		}
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (notEnoughMemory)
+	{
+		ccLog::Warning("[ccScalarFieldExpression] Not enough memory");
+		return false;
+	}
+
+	return !cancelled;
+}
+
+int ccScalarFieldExpression::Apply(ccPointCloud*                       cloud,
+                                   const QString&                      expression,
+                                   const QString&                      outputSFName,
+                                   QString&                            errorMessage,
+                                   CCCoreLib::GenericProgressCallback* progressCb /*=nullptr*/)
+{
+	if (!cloud || outputSFName.isEmpty())
+	{
+		assert(false);
+		errorMessage = QObject::tr("Invalid input");
+		return -1;
+	}
+
+	ccScalarFieldExpression compiledExpression;
+	if (!compiledExpression.compile(expression, cloud, errorMessage))
+	{
+		return -1;
+	}
+
+	// output SF (if it already exists, it will be overwritten)
+	int  sfIdx     = cloud->getScalarFieldIndexByName(outputSFName.toStdString());
+	bool newSField = (sfIdx < 0);
+	if (newSField)
+	{
+		sfIdx = cloud->addScalarField(outputSFName.toStdString());
+		if (sfIdx < 0)
+		{
+			errorMessage = QObject::tr("Failed to create the output scalar field (not enough memory?)");
+			return -1;
+		}
+	}
+
+	CCCoreLib::ScalarField* outputSF = cloud->getScalarField(sfIdx);
+	assert(outputSF);
+
+	if (!compiledExpression.evaluate(cloud, outputSF, progressCb))
+	{
+		errorMessage = QObject::tr("Failed to evaluate the expression (not enough memory or process cancelled)");
+		if (newSField)
+		{
+			cloud->deleteScalarField(sfIdx);
+		}
+		return -1;
+	}
+
+	outputSF->computeMinAndMax();
+	cloud->setCurrentDisplayedScalarField(sfIdx);
+
+	return sfIdx;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+// #                                                                        #
+// ##########################################################################
+
+// Qt
+#include <QString>
+
+// System
+#include <vector>
+
+class ccPointCloud;
+
+namespace CCCoreLib
+{
+	class GenericProgressCallback;
+	class ScalarField;
+} // namespace CCCoreLib
+
+//! Arithmetic expression over the scalar fields, coordinates and colors of a cloud
+/** Syntax:
+    - numbers (e.g. '2', '0.5', '1e-3') and the 'pi' constant
+    - X, Y, Z: point coordinates
+    - R, G, B: point color components (between 0 and 255)
+    - SF0, SF1, etc.: scalar fields (by index)
+    - [name]: scalar field (by name)
+    - operators: +, -, *, / and ^ (power), as well as parentheses
+    - functions: sqrt, exp, log, log10, cos, sin, tan, acos, asin, atan, abs, int,
+      min(a, b), max(a, b) and pow(a, b)
+
+    Example: "(SF1 - SF2) / max(Z, 0.1)"
+
+    The expression is compiled once in a (postfix) list of instructions. It is then
+    evaluated by chunks of points (concurrently), each instruction being applied to
+    a whole chunk of values at once. Invalid scalar values (NaN) are propagated, and
+    all non-finite results are considered as invalid.
+**/
+class ccScalarFieldExpression
+{
+  public:
+	//! Default constructor
+	ccScalarFieldExpression();
+
+	//! Compiles an expression
+	/** \param expression expression
+	    \param cloud cloud on which the expression will be evaluated (to resolve the scalar fields)
+	    \param[out] errorMessage error message (if any)
+	    \return success
+	**/
+	bool compile(const QString& expression, const ccPointCloud* cloud, QString& errorMessage);
+
+	//! Returns whether the expression has been successfully compiled
+	inline bool isValid() const
+	{
+		return !m_program.empty();
+	}
+
+	//! Evaluates the (compiled) expression on all the points of a cloud
+	/** The output scalar field can be one of the input scalar fields.
+	    \param cloud cloud (should be the same as the one used to compile the expression)
+	    \param outputSF output scalar field (will be resized if necessary)
+	    \param progressCb progress callback (optional)
+	    \return success
+	**/
+	bool evaluate(const ccPointCloud* cloud, CCCoreLib::ScalarField* outputSF, CCCoreLib::GenericProgressCallback* progressCb = nullptr) const;
+
+	//! Compiles and evaluates an expression on a cloud
+	/** \param cloud cloud
+	    \param expression expression
+	    \param outputSFName output scalar field name (the scalar field is created if it doesn't exist yet)
+	    \param[out] errorMessage error message (if any)
+	    \param progressCb progress callback (optional)
+	    \return the output scalar field index (or -1 if an error occurred)
+	**/
+	static int Apply(ccPointCloud*                       cloud,
+	                 const QString&                      expression,
+	                 const QString&                      outputSFName,
+	                 QString&                            errorMessage,
+	                 CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
+  protected:
+	//! Instruction codes
+	enum class OpCode
+	{
+		CONSTANT,
+		COORDINATE,
+		COLOR,
+		SCALAR_FIELD,
+		NEG,
+		ADD,
+		SUB,
+		MUL,
+		DIV,
+		POW,
+		MIN,
+		MAX,
+		SQRT,
+		EXP,
+		LOG,
+		LOG10,
+		COS,
+		SIN,
+		TAN,
+		ACOS,
+		ASIN,
+		ATAN,
+		ABS,
+		INT
+	};
+
+	//! Instruction
+	struct Instruction
+	{
+		OpCode op;
+		//! Coordinate, color component or scalar field index
+		int index = 0;
+		//! Constant value
+		double value = 0.0;
+	};
+
+	//! Parser (recursive descent)
+	class Parser;
+
+	//! Compiled program (postfix order)
+	std::vector<Instruction> m_program;
+
+	//! Max stack depth required to evaluate the program
+	unsigned m_maxStackDepth;
+};
@@ -35,9 +35,17 @@
 #include <QClipboard>
 #include <QMessageBox>
 #include <QSettings>
+#include <QtConcurrentRun>
 
 // System
+#include <atomic>
 #include <cassert>
+#include <vector>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
 
 ccVolumeCalcTool::ccVolumeCalcTool(ccGenericPointCloud* cloud1, ccGenericPointCloud* cloud2, QWidget* parent /*=nullptr*/)
     : QDialog(parent, Qt::WindowMaximizeButtonHint | Qt::WindowCloseButtonHint)
@@ -602,22 +610,22 @@ bool ccVolumeCalcTool::ComputeVolume(ccRasterGrid&                     grid,
 		pDlg.reset(new ccProgressDialog(true, parentWidget));
 	}
 
-	ccRasterGrid groundRaster;
-	if (ground)
+	// fills a (initialized) raster grid with a cloud (and its empty cells)
+	auto fillRaster = [&](ccRasterGrid&                     raster,
+	                      ccGenericPointCloud*              cloud,
+	                      ccRasterGrid::EmptyCellFillOption emptyCellFillStrategy,
+	                      double                            maxEdgeLength,
+	                      double                            emptyCellsHeight,
+	                      const QString&                    rasterName,
+	                      ccProgressDialog*                 progressDialog) -> bool
 	{
-		if (!groundRaster.init(gridWidth, gridHeight, gridStep, minCorner))
-		{
-			// not enough memory
-			return SendError("Not enough memory", parentWidget);
-		}
-
-		ccRasterGrid::InterpolationType           interpolationType = ccRasterGrid::InterpolationTypeFromEmptyCellFillOption(groundEmptyCellFillStrategy);
+		ccRasterGrid::InterpolationType           interpolationType = ccRasterGrid::InterpolationTypeFromEmptyCellFillOption(emptyCellFillStrategy);
 		ccRasterGrid::DelaunayInterpolationParams dInterpParams;
 		void*                                     interpolationParams = nullptr;
 		switch (interpolationType)
 		{
 		case ccRasterGrid::InterpolationType::DELAUNAY:
-			dInterpParams.maxEdgeLength = groundMaxEdgeLength;
+			dInterpParams.maxEdgeLength = maxEdgeLength;
 			interpolationParams         = (void*)&dInterpParams;
 			break;
 		case ccRasterGrid::InterpolationType::KRIGING:
@@ -629,63 +637,51 @@ bool ccVolumeCalcTool::ComputeVolume(ccRasterGrid&                     grid,
 			break;
 		}
 
-		if (groundRaster.fillWith(ground,
-		                          vertDim,
-		                          projectionType,
-		                          interpolationType,
-		                          interpolationParams,
-		                          ccRasterGrid::INVALID_PROJECTION_TYPE,
-		                          pDlg.data()))
-		{
-			groundRaster.fillEmptyCells(groundEmptyCellFillStrategy, groundHeight);
-			ccLog::Print(QString("[Volume] Ground raster grid: size: %1 x %2 / heights: [%3 ; %4]").arg(groundRaster.width).arg(groundRaster.height).arg(groundRaster.minHeight).arg(groundRaster.maxHeight));
-		}
-		else
+		if (!raster.fillWith(cloud,
+		                     vertDim,
+		                     projectionType,
+		                     interpolationType,
+		                     interpolationParams,
+		                     ccRasterGrid::INVALID_PROJECTION_TYPE,
+		                     progressDialog))
 		{
 			return false;
 		}
-	}
 
-	// ceil
+		raster.fillEmptyCells(emptyCellFillStrategy, emptyCellsHeight);
+		ccLog::Print(QString("[Volume] %1 raster grid: size: %2 x %3 / heights: [%4 ; %5]").arg(rasterName).arg(raster.width).arg(raster.height).arg(raster.minHeight).arg(raster.maxHeight));
+		return true;
+	};
+
+	ccRasterGrid groundRaster;
 	ccRasterGrid ceilRaster;
-	if (ceil)
+	if ((ground && !groundRaster.init(gridWidth, gridHeight, gridStep, minCorner))
+	    || (ceil && !ceilRaster.init(gridWidth, gridHeight, gridStep, minCorner)))
 	{
-		if (!ceilRaster.init(gridWidth, gridHeight, gridStep, minCorner))
-		{
-			// not enough memory
-			return SendError("Not enough memory", parentWidget);
-		}
+		// not enough memory
+		return SendError("Not enough memory", parentWidget);
+	}
 
-		ccRasterGrid::InterpolationType           interpolationType = ccRasterGrid::InterpolationTypeFromEmptyCellFillOption(ceilEmptyCellFillStrategy);
-		ccRasterGrid::DelaunayInterpolationParams dInterpParams;
-		void*                                     interpolationParams = nullptr;
-		switch (interpolationType)
+	if (ground && ceil && ground != ceil)
+	{
+		// both grids are filled concurrently (the ground grid in a background thread, without progress dialog)
+		QFuture<bool> groundFuture = QtConcurrent::run([&]()
+		                                               { return fillRaster(groundRaster, ground, groundEmptyCellFillStrategy, groundMaxEdgeLength, groundHeight, "Ground", nullptr); });
+
+		bool ceilSuccess   = fillRaster(ceilRaster, ceil, ceilEmptyCellFillStrategy, ceilMaxEdgeLength, ceilHeight, "Ceil", pDlg.data());
+		bool groundSuccess = groundFuture.result();
+		if (!groundSuccess || !ceilSuccess)
 		{
-		case ccRasterGrid::InterpolationType::DELAUNAY:
-			dInterpParams.maxEdgeLength = ceilMaxEdgeLength;
-			interpolationParams         = (void*)&dInterpParams;
-			break;
-		case ccRasterGrid::InterpolationType::KRIGING:
-			// not supported yet
-			assert(false);
-			break;
-		default:
-			// do nothing
-			break;
+			return false;
 		}
-
-		if (ceilRaster.fillWith(ceil,
-		                        vertDim,
-		                        projectionType,
-		                        interpolationType,
-		                        interpolationParams,
-		                        ccRasterGrid::INVALID_PROJECTION_TYPE,
-		                        pDlg.data()))
+	}
+	else
+	{
+		if (ground && !fillRaster(groundRaster, ground, groundEmptyCellFillStrategy, groundMaxEdgeLength, groundHeight, "Ground", pDlg.data()))
 		{
-			ceilRaster.fillEmptyCells(ceilEmptyCellFillStrategy, ceilHeight);
-			ccLog::Print(QString("[Volume] Ceil raster grid: size: %1 x %2 / heights: [%3 ; %4]").arg(ceilRaster.width).arg(ceilRaster.height).arg(ceilRaster.minHeight).arg(ceilRaster.maxHeight));
+			return false;
 		}
-		else
+		if (ceil && !fillRaster(ceilRaster, ceil, ceilEmptyCellFillStrategy, ceilMaxEdgeLength, ceilHeight, "Ceil", pDlg.data()))
 		{
 			return false;
 		}
@@ -701,16 +697,43 @@ bool ccVolumeCalcTool::ComputeVolume(ccRasterGrid&                     grid,
 			pDlg->show();
 			QCoreApplication::processEvents();
 		}
-		CCCoreLib::NormalizedProgress nProgress(pDlg.data(), grid.width * grid.height);
+		CCCoreLib::NormalizedProgress nProgress(pDlg.data(), grid.height);
+
+		// per-row sums (summed afterwards in the row order, so that the result doesn't depend on the number of threads)
+		struct RowStats
+		{
+			double volume        = 0.0;
+			double addedVolume   = 0.0;
+			double removedVolume = 0.0;
+		};
+		std::vector<RowStats> rowStats;
+		try
+		{
+			rowStats.resize(grid.height);
+		}
+		catch (const std::bad_alloc&)
+		{
+			return SendError("Not enough memory", parentWidget);
+		}
 
-		size_t ceilNonMatchingCount   = 0;
-		size_t groundNonMatchingCount = 0;
-		size_t cellCount              = 0;
+		int64_t           matchingCount          = 0;
+		int64_t           ceilNonMatchingCount   = 0;
+		int64_t           groundNonMatchingCount = 0;
+		int64_t           cellCount              = 0;
+		std::atomic<bool> cancelled(false);
 
 		// at least one of the grid is based on a cloud
-		grid.nonEmptyCellCount = 0;
-		for (unsigned i = 0; i < grid.height; ++i)
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(omp_get_max_threads()) reduction(+ : matchingCount, ceilNonMatchingCount, groundNonMatchingCount, cellCount)
+#endif
+		for (int i = 0; i < static_cast<int>(grid.height); ++i)
 		{
+			if (cancelled)
+			{
+				continue;
+			}
+
+			RowStats& stats = rowStats[i];
 			for (unsigned j = 0; j < grid.width; ++j)
 			{
 				ccRasterCell& cell = grid.rows[i][j];
@@ -736,17 +759,16 @@ bool ccVolumeCalcTool::ComputeVolume(ccRasterGrid&                     grid,
 					cell.h        = cell.maxHeight - cell.minHeight;
 					cell.nbPoints = 1;
 
-					reportInfo.volume += cell.h;
+					stats.volume += cell.h;
 					if (cell.h < 0)
 					{
-						reportInfo.removedVolume -= cell.h;
+						stats.removedVolume -= cell.h;
 					}
 					else if (cell.h > 0)
 					{
-						reportInfo.addedVolume += cell.h;
+						stats.addedVolume += cell.h;
 					}
-					reportInfo.surface += 1.0;
-					++grid.nonEmptyCellCount; // matching count
+					++matchingCount;
 					++cellCount;
 				}
 				else
@@ -764,34 +786,52 @@ bool ccVolumeCalcTool::ComputeVolume(ccRasterGrid&                     grid,
 					cell.h        = std::numeric_limits<double>::quiet_NaN();
 					cell.nbPoints = 0;
 				}
+			}
 
-				if (pDlg && !nProgress.oneStep())
-				{
-					ccLog::Warning("[Volume] Process cancelled by the user");
-					return false;
-				}
+			if (pDlg && !nProgress.oneStep())
+			{
+				cancelled = true;
 			}
 		}
-		grid.validCellCount = grid.nonEmptyCellCount;
+
+		if (cancelled)
+		{
+			ccLog::Warning("[Volume] Process cancelled by the user");
+			return false;
+		}
+
+		for (const RowStats& stats : rowStats)
+		{
+			reportInfo.volume += stats.volume;
+			reportInfo.addedVolume += stats.addedVolume;
+			reportInfo.removedVolume += stats.removedVolume;
+		}
+		reportInfo.surface += static_cast<double>(matchingCount);
+
+		grid.nonEmptyCellCount = static_cast<unsigned>(matchingCount);
+		grid.validCellCount    = grid.nonEmptyCellCount;
 
 		// count the average number of valid neighbors
 		{
-			size_t validNeighborsCount = 0;
-			size_t count               = 0;
-			for (unsigned i = 1; i < grid.height - 1; ++i)
+			int64_t validNeighborsCount = 0;
+			int64_t count               = 0;
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads()) reduction(+ : validNeighborsCount, count)
+#endif
+			for (int i = 1; i < static_cast<int>(grid.height) - 1; ++i)
 			{
 				for (unsigned j = 1; j < grid.width - 1; ++j)
 				{
-					ccRasterCell& cell = grid.rows[i][j];
+					const ccRasterCell& cell = grid.rows[i][j];
 					if (std::isfinite(cell.h))
 					{
-						for (unsigned k = i - 1; k <= i + 1; ++k)
+						for (int k = i - 1; k <= i + 1; ++k)
 						{
 							for (unsigned l = j - 1; l <= j + 1; ++l)
 							{
 								if (k != i || l != j)
 								{
-									ccRasterCell& otherCell = grid.rows[k][l];
+									const ccRasterCell& otherCell = grid.rows[k][l];
 									if (std::isfinite(otherCell.h))
 									{
 										++validNeighborsCount;
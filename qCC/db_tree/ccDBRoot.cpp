@@ -67,6 +67,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <unordered_map>
 
 // Minimum width of the left column of the properties tree view
 static const int c_propViewLeftColumnWidth = 115;
@@ -345,16 +346,20 @@ void ccDBRoot::unloadAll()
 		return;
 	}
 
-	while (m_treeRoot->getChildrenNumber() > 0)
+	unsigned childCount = m_treeRoot->getChildrenNumber();
+	if (childCount != 0)
 	{
-		int        i      = static_cast<int>(m_treeRoot->getChildrenNumber()) - 1;
-		ccHObject* object = m_treeRoot->getChild(i);
-		assert(object);
-
-		object->prepareDisplayForRefresh_recursive();
+		for (unsigned i = 0; i < childCount; ++i)
+		{
+			m_treeRoot->getChild(i)->prepareDisplayForRefresh_recursive();
+		}
 
-		beginRemoveRows(index(object).parent(), i, i);
-		m_treeRoot->removeChild(i);
+		// remove all the top-level entities at once
+		beginRemoveRows(QModelIndex(), 0, static_cast<int>(childCount) - 1);
+		while (m_treeRoot->getChildrenNumber() > 0)
+		{
+			m_treeRoot->removeChild(static_cast<int>(m_treeRoot->getChildrenNumber()) - 1);
+		}
 		endRemoveRows();
 	}
 
@@ -433,6 +438,126 @@ void ccDBRoot::addElement(ccHObject* object, bool autoExpand /*=true*/)
 	}
 }
 
+void ccDBRoot::addElements(const ccHObject::Container& objects, bool autoExpand /*=true*/)
+{
+	if (!m_treeRoot)
+	{
+		assert(false);
+		return;
+	}
+	if (objects.empty())
+	{
+		return;
+	}
+
+	bool wasEmpty = (m_treeRoot->getChildrenNumber() == 0);
+
+	// insert the parent-less objects at tree root, and group the new rows by parent
+	std::vector<std::pair<ccHObject*, std::vector<int>>> rowsByParent;
+	std::unordered_map<ccHObject*, size_t>                parentSlots;
+	bool                                                  notEnoughMemory = false;
+	for (ccHObject* object : objects)
+	{
+		if (!object)
+		{
+			assert(false);
+			continue;
+		}
+
+		ccHObject* parentObject = object->getParent();
+		if (!parentObject)
+		{
+			parentObject = m_treeRoot;
+			if (!m_treeRoot->addChild(object))
+			{
+				ccLog::Warning(QString("[ccDBRoot::addElements] Failed to insert entity '%1' in the DB tree").arg(object->getName()));
+				continue;
+			}
+		}
+
+		int childPos = parentObject->getChildIndex(object);
+		if (childPos < 0)
+		{
+			assert(false);
+			continue;
+		}
+
+		if (notEnoughMemory)
+		{
+			continue;
+		}
+
+		try
+		{
+			auto it = parentSlots.find(parentObject);
+			if (it == parentSlots.end())
+			{
+				it = parentSlots.emplace(parentObject, rowsByParent.size()).first;
+				rowsByParent.emplace_back(parentObject, std::vector<int>());
+			}
+			rowsByParent[it->second].second.push_back(childPos);
+		}
+		catch (const std::bad_alloc&)
+		{
+			// we'll reset the whole model instead
+			notEnoughMemory = true;
+		}
+	}
+
+	if (notEnoughMemory)
+	{
+		beginResetModel();
+		endResetModel();
+	}
+	else
+	{
+		// row insertion operations (one per range of contiguous rows)
+		for (auto& parentRows : rowsByParent)
+		{
+			std::vector<int>& rows = parentRows.second;
+			std::sort(rows.begin(), rows.end());
+			rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+			QModelIndex insertNodeIndex = index(parentRows.first);
+			for (size_t i = 0; i < rows.size();)
+			{
+				size_t j = i + 1;
+				while (j < rows.size() && rows[j] == rows[j - 1] + 1)
+				{
+					++j;
+				}
+
+				beginInsertRows(insertNodeIndex, rows[i], rows[j - 1]);
+				endInsertRows();
+
+				i = j;
+			}
+		}
+	}
+
+	// expand the parents (just in case)
+	for (const auto& parentRows : rowsByParent)
+	{
+		m_dbTreeWidget->expand(index(parentRows.first));
+	}
+	if (autoExpand)
+	{
+		// and the children
+		for (ccHObject* object : objects)
+		{
+			if (object && object->getParent())
+			{
+				m_dbTreeWidget->expand(index(object));
+			}
+		}
+	}
+
+	if (wasEmpty && m_treeRoot->getChildrenNumber() != 0)
+	{
+		Q_EMIT dbIsNotEmptyAnymore();
+	}
+}
+
 void ccDBRoot::expandElement(ccHObject* object, bool state)
 {
 	if (!object || !m_dbTreeWidget)
@@ -454,32 +579,15 @@ void ccDBRoot::removeElements(ccHObject::Container& objects)
 	// we hide properties view in case this is the deleted object that is currently selected
 	hidePropertiesView();
 
-	// every object in tree must have a parent!
 	for (ccHObject* object : objects)
 	{
-		ccHObject* parent = object->getParent();
-		if (!parent)
-		{
-			ccLog::Warning(QString("[ccDBRoot::removeElements] Internal error: object '%1' has no parent").arg(object->getName()));
-			continue;
-		}
-
 		// just in case
 		object->prepareDisplayForRefresh();
-
-		int childPos = parent->getChildIndex(object);
-		assert(childPos >= 0);
-		{
-			// row removal operation (start)
-			beginRemoveRows(index(parent), childPos, childPos);
-
-			parent->removeChild(childPos);
-
-			// row removal operation (end)
-			endRemoveRows();
-		}
 	}
 
+	// every object in tree must have a parent! (checked by removeChildrenByRanges)
+	removeChildrenByRanges(objects);
+
 	// we restore properties view
 	updatePropertiesView();
 
@@ -532,6 +640,124 @@ void ccDBRoot::removeElement(ccHObject* object)
 	}
 }
 
+void ccDBRoot::removeChildrenByRanges(const ccHObject::Container& objects)
+{
+	// The deletion of an entity may delete other entities than its own descendants (see
+	// ccHObject::DP_DELETE_OTHER), including its siblings or its parent. Such entities are
+	// removed one at a time (after the others), and all the entities are tracked by their
+	// unique ID as any of them may have been deleted along with a previous one.
+	struct ChildToRemove
+	{
+		unsigned parentID;
+		int      row;
+		unsigned uniqueID;
+	};
+	std::vector<ChildToRemove> children;
+	std::vector<unsigned>      cascadingIDs;
+	try
+	{
+		children.reserve(objects.size());
+		cascadingIDs.reserve(objects.size());
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Error("[ccDBRoot] Not enough memory");
+		return;
+	}
+
+	for (ccHObject* object : objects)
+	{
+		ccHObject* parent = object->getParent();
+		if (!parent)
+		{
+			ccLog::Warning(QString("[ccDBRoot] Internal error: object '%1' has no parent").arg(object->getName()));
+			continue;
+		}
+
+		int childPos = parent->getChildIndex(object);
+		if (childPos < 0)
+		{
+			assert(false);
+			continue;
+		}
+
+		if (object->deletionCascadesOutside())
+		{
+			cascadingIDs.push_back(object->getUniqueID());
+		}
+		else
+		{
+			children.push_back({parent->getUniqueID(), childPos, object->getUniqueID()});
+		}
+	}
+
+	// group the rows by parent, highest rows first (so that removing a range doesn't shift the next ones)
+	std::sort(children.begin(), children.end(), [](const ChildToRemove& a, const ChildToRemove& b)
+	          { return (a.parentID != b.parentID ? a.parentID < b.parentID : a.row > b.row); });
+
+	// removes a single entity (if it still exists)
+	auto removeAlone = [this](unsigned uniqueID)
+	{
+		ccHObject* object = m_treeRoot->find(uniqueID);
+		ccHObject* parent = (object ? object->getParent() : nullptr);
+		int        childPos = (parent ? parent->getChildIndex(object) : -1);
+		if (childPos >= 0)
+		{
+			beginRemoveRows(index(parent), childPos, childPos);
+			parent->removeChild(childPos);
+			endRemoveRows();
+		}
+	};
+
+	for (size_t i = 0; i < children.size();)
+	{
+		// the parent may have been deleted along with a previous entity
+		ccHObject* parent = m_treeRoot->find(children[i].parentID);
+
+		// look for a range of contiguous rows that are still up to date
+		size_t j = i;
+		while (parent
+		       && j < children.size()
+		       && children[j].parentID == children[i].parentID
+		       && (j == i || children[j].row + 1 == children[j - 1].row))
+		{
+			ccHObject* child = parent->getChild(children[j].row);
+			if (!child || child->getUniqueID() != children[j].uniqueID)
+			{
+				break;
+			}
+			++j;
+		}
+
+		if (j == i)
+		{
+			// this entity has been deleted (or moved) in the meantime
+			removeAlone(children[i].uniqueID);
+			++i;
+			continue;
+		}
+
+		// row removal operation (start)
+		beginRemoveRows(index(parent), children[j - 1].row, children[i].row);
+
+		// none of these deletions can affect the other rows
+		for (size_t k = i; k < j; ++k)
+		{
+			parent->removeChild(children[k].row);
+		}
+
+		// row removal operation (end)
+		endRemoveRows();
+
+		i = j;
+	}
+
+	for (unsigned uniqueID : cascadingIDs)
+	{
+		removeAlone(uniqueID);
+	}
+}
+
 void ccDBRoot::deleteSelectedEntities()
 {
 	QItemSelectionModel* qism            = m_dbTreeWidget->selectionModel();
@@ -548,6 +774,12 @@ void ccDBRoot::deleteSelectedEntities()
 	// we remove all objects that are children of other deleted ones!
 	//(otherwise we may delete the parent before the child!)
 	// TODO DGM: not sure this is still necessary with the new dependency mechanism
+	std::unordered_set<const ccHObject*> selectedObjects;
+	for (unsigned i = 0; i < selCount; ++i)
+	{
+		selectedObjects.insert(static_cast<ccHObject*>(selectedIndexes[i].internalPointer()));
+	}
+
 	std::vector<ccHObject*> toBeDeleted;
 	for (unsigned i = 0; i < selCount; ++i)
 	{
@@ -561,16 +793,12 @@ void ccDBRoot::deleteSelectedEntities()
 
 		// we don't consider objects that are 'descendent' of others in the selection
 		bool isDescendent = false;
-		for (unsigned j = 0; j < selCount; ++j)
+		for (const ccHObject* ancestor = obj->getParent(); ancestor; ancestor = ancestor->getParent())
 		{
-			if (i != j)
+			if (selectedObjects.find(ancestor) != selectedObjects.end())
 			{
-				ccHObject* otherObj = static_cast<ccHObject*>(selectedIndexes[j].internalPointer());
-				if (otherObj->isAncestorOf(obj))
-				{
-					isDescendent = true;
-					break;
-				}
+				isDescendent = true;
+				break;
 			}
 		}
 
@@ -593,12 +821,9 @@ void ccDBRoot::deleteSelectedEntities()
 
 	qism->clear();
 
-	while (!toBeDeleted.empty())
+	for (ccHObject* object : toBeDeleted)
 	{
-		ccHObject* object = toBeDeleted.back();
 		assert(object);
-		toBeDeleted.pop_back();
-
 		object->prepareDisplayForRefresh_recursive();
 
 		if (object->isKindOf(CC_TYPES::MESH))
@@ -610,16 +835,10 @@ void ccDBRoot::deleteSelectedEntities()
 				object->getParent()->setVisible(true);
 			}
 		}
-
-		ccHObject* parent   = object->getParent();
-		int        childPos = parent->getChildIndex(object);
-		assert(childPos >= 0);
-
-		beginRemoveRows(index(object).parent(), childPos, childPos);
-		parent->removeChild(childPos);
-		endRemoveRows();
 	}
 
+	removeChildrenByRanges(toBeDeleted);
+
 	updatePropertiesView();
 
 	if (m_treeRoot->getChildrenNumber() == 0)
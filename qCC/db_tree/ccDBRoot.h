@@ -102,6 +102,13 @@ class ccDBRoot : public QAbstractItemModel
 	//! Adds an element to the DB tree
 	void addElement(ccHObject* object, bool autoExpand = true);
 
+	//! Adds several elements at once to the DB tree
+	/** Much faster than multiple calls to addElement when adding a lot of
+	    entities, as the tree view is only notified once per parent (and per
+	    range of contiguous rows).
+	**/
+	void addElements(const ccHObject::Container& objects, bool autoExpand = true);
+
 	//! Removes an element from the DB tree
 	/** Automatically calls prepareDisplayForRefresh on the object.
 	 **/
@@ -273,6 +280,15 @@ class ccDBRoot : public QAbstractItemModel
 	//! Sorts selected entities children
 	void sortSelectedEntitiesChildren(SortRules rule);
 
+	//! Removes (and potentially deletes) several entities from the DB tree
+	/** Entities are grouped by parent, and each range of contiguous rows
+	    is removed at once (i.e. the tree view is only notified once).
+	    Entities whose deletion may delete other entities than their own
+	    descendants (see ccHObject::deletionCascadesOutside) are removed
+	    one at a time. The entities must all have a parent.
+	**/
+	void removeChildrenByRanges(const ccHObject::Container& objects);
+
 	//! Expands or collapses hovered item
 	void expandOrCollapseHoveredBranch(bool expand);
 
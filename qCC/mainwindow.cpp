@@ -87,6 +87,7 @@
 #include "ccBoundingBoxEditorDlg.h"
 #include "ccCamSensorProjectionDlg.h"
 #include "ccClippingBoxTool.h"
+#include "ccCloudDistanceGrid.h"
 #include "ccColorFromScalarDlg.h"
 #include "ccColorScaleEditorDlg.h"
 #include "ccComparisonDlg.h"
@@ -374,6 +375,9 @@ MainWindow::~MainWindow()
 	m_pprDlg    = nullptr;
 	m_pfDlg     = nullptr;
 
+	// release the cached Cloud/Cloud distances grid (if any)
+	ccCloudDistanceGrid::ReleaseCache();
+
 	// release all 'overlay' dialogs
 	while (!m_mdiDialogs.empty())
 	{
@@ -3863,8 +3867,9 @@ void MainWindow::doActionRegister()
 		parameters.useC2MSignedDistances   = rDlg.useC2MSignedDistances(parameters.robustC2MSignedDistances);
 		parameters.normalsMatching         = rDlg.normalsMatchingOption();
 	}
-	bool useDataSFAsWeights  = rDlg.useDataSFAsWeights();
-	bool useModelSFAsWeights = rDlg.useModelSFAsWeights();
+	bool                                       useDataSFAsWeights  = rDlg.useDataSFAsWeights();
+	bool                                       useModelSFAsWeights = rDlg.useModelSFAsWeights();
+	ccRegistrationTools::MultiResolutionParams multiResParams      = rDlg.getMultiResolutionParams();
 
 	// semi-persistent storage (for next call)
 	rDlg.saveParameters();
@@ -3883,7 +3888,8 @@ void MainWindow::doActionRegister()
 	                             parameters,
 	                             useDataSFAsWeights,
 	                             useModelSFAsWeights,
-	                             this))
+	                             this,
+	                             &multiResParams))
 	{
 		QString rmsString           = tr("Final RMS*: %1 (computed on %2 points)").arg(finalError).arg(finalPointCount);
 		QString rmsDisclaimerString = tr("(* RMS is potentially weighted, depending on the selected options)");
@@ -10452,6 +10458,63 @@ void MainWindow::addToDB(ccHObject* obj,
 	}
 }
 
+void MainWindow::addToDB(const ccHObject::Container& entities,
+                         bool                        autoExpandDBTree /*=true*/,
+                         bool                        autoRedraw /*=true*/)
+{
+	if (entities.empty())
+	{
+		return;
+	}
+
+	if (!m_ccRoot)
+	{
+		ccLog::Warning(tr("[MainWindow::addToDB] Internal error: no associated DB?!"));
+		assert(false);
+		return;
+	}
+
+	// force a 'global zoom' if the DB was emtpy!
+	bool updateZoom = (!m_ccRoot->getRootEntity() || m_ccRoot->getRootEntity()->getChildrenNumber() == 0);
+
+	m_ccRoot->addElements(entities, autoExpandDBTree);
+
+	// we can now set destination display (if none already)
+	ccGLWindowInterface*              activeWin = getActiveGLWindow();
+	std::vector<ccGLWindowInterface*> displays;
+	for (ccHObject* entity : entities)
+	{
+		if (!entity->getDisplay())
+		{
+			if (!activeWin)
+			{
+				// no active GL window?!
+				continue;
+			}
+			entity->setDisplay_recursive(activeWin);
+		}
+
+		ccGLWindowInterface* display = static_cast<ccGLWindowInterface*>(entity->getDisplay());
+		if (std::find(displays.begin(), displays.end(), display) == displays.end())
+		{
+			displays.push_back(display);
+		}
+	}
+
+	// eventually we update the corresponding displays (once)
+	for (ccGLWindowInterface* display : displays)
+	{
+		if (updateZoom)
+		{
+			display->zoomGlobal(); // automatically calls ccGLWindowInterface::redraw
+		}
+		else if (autoRedraw)
+		{
+			display->redraw();
+		}
+	}
+}
+
 void MainWindow::onExclusiveFullScreenToggled(bool state)
 {
 	// we simply update the fullscreen action method icon (whatever the window)
@@ -10524,42 +10587,117 @@ void MainWindow::addToDB(const QStringList&   filenames,
 	bool normalsDisplayedByDefault = ccOptions::Instance().normalsDisplayedByDefault;
 	FileIOFilter::ResetSesionCounter();
 
-	for (const QString& filename : filenames)
+	auto prepareLoadedEntity = [&](ccHObject* entity)
 	{
-		CC_FILE_ERROR result   = CC_FERR_NO_ERROR;
-		ccHObject*    newGroup = FileIOFilter::LoadFromFile(filename, parameters, result, fileFilter);
-
-		if (newGroup)
+		if (!normalsDisplayedByDefault)
 		{
-			if (!normalsDisplayedByDefault)
+			// disable the normals on all loaded clouds!
+			ccHObject::Container clouds;
+			entity->filterChildren(clouds, true, CC_TYPES::POINT_CLOUD);
+			if (entity->isKindOf(CC_TYPES::POINT_CLOUD))
 			{
-				// disable the normals on all loaded clouds!
-				ccHObject::Container clouds;
-				newGroup->filterChildren(clouds, true, CC_TYPES::POINT_CLOUD);
-				for (ccHObject* cloud : clouds)
+				clouds.push_back(entity);
+			}
+			for (ccHObject* cloud : clouds)
+			{
+				if (cloud)
 				{
-					if (cloud)
-					{
-						static_cast<ccGenericPointCloud*>(cloud)->showNormals(false);
-					}
+					static_cast<ccGenericPointCloud*>(cloud)->showNormals(false);
 				}
 			}
+		}
+
+		if (destWin)
+		{
+			entity->setDisplay_recursive(destWin);
+		}
+	};
+
+	// group of the file being loaded in the background, if some of its entities have already been added to the DB
+	// (we keep its unique ID, as the user may delete it in the meantime)
+	unsigned loadingFileGroupID = 0;
+	auto     getLoadingFileGroup = [&]() -> ccHObject*
+	{
+		if (loadingFileGroupID == 0 || !m_ccRoot || !m_ccRoot->getRootEntity())
+		{
+			return nullptr;
+		}
+		return m_ccRoot->getRootEntity()->find(loadingFileGroupID);
+	};
 
+	// called with the entities delivered before the end of the loading of a file (so that they can be displayed right away)
+	auto addDeliveredEntities = [&](const QString& filename, const std::vector<ccHObject*>& entities)
+	{
+		ccHObject* group = getLoadingFileGroup();
+		if (!group)
+		{
+			QFileInfo fi(filename);
+			group = new ccHObject(QString("%1 (%2)").arg(fi.fileName(), fi.absolutePath()));
+			for (ccHObject* entity : entities)
+			{
+				prepareLoadedEntity(entity);
+				group->addChild(entity);
+			}
 			if (destWin)
 			{
-				newGroup->setDisplay_recursive(destWin);
+				group->setDisplay(destWin);
 			}
-			addToDB(newGroup, true, true, false);
-
-			m_recentFiles->addFilePath(filename);
+			addToDB(group, true, true, false);
+			loadingFileGroupID = group->getUniqueID();
+		}
+		else
+		{
+			for (ccHObject* entity : entities)
+			{
+				prepareLoadedEntity(entity);
+				group->addChild(entity);
+			}
+			addToDB(entities, false);
 		}
+	};
+
+	// called for each file, in the input order
+	auto addLoadedFile = [&](const QString& filename, ccHObject* newGroup, CC_FILE_ERROR result)
+	{
+		Q_UNUSED(result);
 
-		if (result == CC_FERR_CANCELED_BY_USER)
+		ccHObject* loadingFileGroup = getLoadingFileGroup();
+		loadingFileGroupID          = 0;
+
+		if (loadingFileGroup)
 		{
-			// stop importing the file if the user has cancelled the current process!
-			break;
+			// the first entities of this file are already in the DB: we add the remaining ones to the same group
+			if (newGroup)
+			{
+				ccHObject::Container remainingEntities;
+				while (newGroup->getChildrenNumber() != 0)
+				{
+					ccHObject* child = newGroup->getChild(0);
+					newGroup->transferChild(child, *loadingFileGroup);
+					prepareLoadedEntity(child);
+					remainingEntities.push_back(child);
+				}
+				delete newGroup;
+
+				addToDB(remainingEntities, false);
+			}
 		}
-	}
+		else
+		{
+			if (!newGroup)
+			{
+				return;
+			}
+
+			prepareLoadedEntity(newGroup);
+			addToDB(newGroup, true, true, false);
+		}
+
+		m_recentFiles->addFilePath(filename);
+	};
+
+	// the files are loaded concurrently when possible (the loading stops if the user cancels the current process)
+	FileIOFilter::LoadFromFiles(filenames, parameters, addLoadedFile, fileFilter, 0, addDeliveredEntities);
 
 	QMainWindow::statusBar()->showMessage(tr("%1 file(s) loaded").arg(filenames.size()), 2000);
 }
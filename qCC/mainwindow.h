@@ -132,6 +132,18 @@ class MainWindow : public QMainWindow
 	             bool       checkDimensions  = false,
 	             bool       autoRedraw       = true) override;
 
+	//! Adds several entities to the DB tree at once
+	/** The entities may already have a parent in the DB tree (otherwise they are
+	    added at the root). The DB tree view is only notified once per range of
+	    contiguous rows, and the displays are refreshed once.
+	    \param entities entities to add
+	    \param autoExpandDBTree whether the DB tree should be expanded to show the new entities
+	    \param autoRedraw whether the displays should be refreshed
+	**/
+	void addToDB(const ccHObject::Container& entities,
+	             bool                        autoExpandDBTree = true,
+	             bool                        autoRedraw       = true);
+
 	void                registerOverlayDialog(ccOverlayDialog* dlg, Qt::Corner pos) override;
 	void                unregisterOverlayDialog(ccOverlayDialog* dlg) override;
 	void                updateOverlayDialogsPlacement() override;